@@ -781,6 +781,17 @@ AS_IF([test x$enable_sss_default_nss_plugin = xyes],
       AC_DEFINE_UNQUOTED([NONSTANDARD_SSS_NSS_BEHAVIOUR], [1],
           [whether to build sssd nss plugin with nonstandard glibc behaviour]))
 
+AC_ARG_ENABLE([lockfree-support],
+              [AS_HELP_STRING([--disable-lockfree-support],
+                              [Build the client libraries with a single
+                               connection to the responder shared by all
+                               threads of an application. If this option is
+                               not disabled each thread opens its own
+                               connection and requests are not serialized.
+                               [default=yes]])],
+              [enable_lockfree_support=$enableval],
+              [enable_lockfree_support=yes])
+
 AC_DEFUN([WITH_NFS],
   [ AC_ARG_WITH([nfsv4-idmapd-plugin],
                 [AC_HELP_STRING([--with-nfsv4-idmapd-plugin],
@@ -97,6 +97,8 @@
 #define CONFDB_NSS_ENUM_CACHE_TIMEOUT "enum_cache_timeout"
 #define CONFDB_NSS_ENTRY_CACHE_NOWAIT_PERCENTAGE "entry_cache_nowait_percentage"
 #define CONFDB_NSS_ENTRY_NEG_TIMEOUT "entry_negative_timeout"
+#define CONFDB_NSS_NEG_CACHE_BACKEND "negative_cache_backend"
+#define CONFDB_NSS_NEG_CACHE_BACKEND_DEFAULT "tdb"
 #define CONFDB_NSS_FILTER_USERS_IN_GROUPS "filter_users_in_groups"
 #define CONFDB_NSS_FILTER_USERS "filter_users"
 #define CONFDB_NSS_FILTER_GROUPS "filter_groups"
@@ -109,6 +111,14 @@
 #define CONFDB_NSS_SHELL_FALLBACK "shell_fallback"
 #define CONFDB_NSS_DEFAULT_SHELL "default_shell"
 #define CONFDB_MEMCACHE_TIMEOUT "memcache_timeout"
+#define CONFDB_NSS_MEMCACHE_SIZE_PASSWD "memcache_size_passwd"
+#define CONFDB_NSS_MEMCACHE_SIZE_GROUP "memcache_size_group"
+#define CONFDB_NSS_MEMCACHE_SIZE_INITGROUPS "memcache_size_initgroups"
+#define CONFDB_NSS_MEMCACHE_SIZE_SID "memcache_size_sid"
+#define CONFDB_NSS_MEMCACHE_SIZE_SERVICES "memcache_size_services"
+#define CONFDB_NSS_MEMCACHE_SIZE_NETGROUP "memcache_size_netgroup"
+#define CONFDB_NSS_MEMCACHE_SIZE_NEGATIVE "memcache_size_negative"
+#define CONFDB_NSS_MEMCACHE_MAX_GROWTH "memcache_max_growth"
 #define CONFDB_NSS_HOMEDIR_SUBSTRING "homedir_substring"
 #define CONFDB_DEFAULT_HOMEDIR_SUBSTRING "/home"
 
@@ -234,6 +244,7 @@
 #define CONFDB_DOMAIN_TYPE_POSIX "posix"
 #define CONFDB_DOMAIN_TYPE_APP "application"
 #define CONFDB_DOMAIN_INHERIT_FROM "inherit_from"
+#define CONFDB_DOMAIN_FRAME_TRANSPORT "frame_transport"
 
 /* Local Provider */
 #define CONFDB_LOCAL_DEFAULT_SHELL   "default_shell"
@@ -254,6 +265,7 @@
 /* Files Provider */
 #define CONFDB_FILES_PASSWD "passwd_files"
 #define CONFDB_FILES_GROUP "group_files"
+#define CONFDB_FILES_INCREMENTAL_RELOAD "incremental_reload"
 
 /* Secrets Service */
 #define CONFDB_SEC_CONF_ENTRY "config/secrets"
@@ -266,6 +278,7 @@
 #define CONFDB_KCM_CONF_ENTRY "config/kcm"
 #define CONFDB_KCM_SOCKET "socket_path"
 #define CONFDB_KCM_DB "ccache_storage" /* Undocumented on purpose */
+#define CONFDB_KCM_WRITE_BACK_INTERVAL "ccache_write_back_interval"
 
 /* Certificate mapping rules */
 #define CONFDB_CERTMAP_BASEDN "cn=certmap,cn=config"
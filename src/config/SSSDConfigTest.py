@@ -608,6 +608,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'account_cache_expiration',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'failover_probe_timeout',
+            'dns_resolver_cache_max_ttl',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -642,7 +644,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
-            'auto_private_groups']
+            'auto_private_groups',
+            'frame_transport']
 
         self.assertTrue(type(options) == dict,
                         "Options should be a dictionary")
@@ -726,7 +729,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
              'krb5_canonicalize',
              'krb5_use_enterprise_principal',
              'krb5_use_kdcinfo',
-             'krb5_map_user'])
+             'krb5_map_user',
+             'krb5_child_pool_size',
+             'krb5_child_pool_max_requests'])
 
         options = domain.list_options()
 
@@ -888,7 +893,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'krb5_canonicalize',
             'krb5_use_enterprise_principal',
             'krb5_use_kdcinfo',
-            'krb5_map_user']
+            'krb5_map_user',
+            'krb5_child_pool_size',
+            'krb5_child_pool_max_requests']
 
         self.assertTrue(type(options) == dict,
                         "Options should be a dictionary")
@@ -978,6 +985,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'lookup_family_order',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'failover_probe_timeout',
+            'dns_resolver_cache_max_ttl',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -1012,7 +1021,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
-            'auto_private_groups']
+            'auto_private_groups',
+            'frame_transport']
 
         self.assertTrue(type(options) == dict,
                         "Options should be a dictionary")
@@ -1097,7 +1107,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
              'krb5_canonicalize',
              'krb5_use_enterprise_principal',
              'krb5_use_kdcinfo',
-             'krb5_map_user'])
+             'krb5_map_user',
+             'krb5_child_pool_size',
+             'krb5_child_pool_max_requests'])
 
         options = domain.list_options()
 
@@ -224,6 +224,7 @@
 #define SYSDB_USER_CERT_FILTER "(&("SYSDB_UC")%s)"
 
 #define SYSDB_HAS_ENUMERATED "has_enumerated"
+#define SYSDB_CHANGE_STREAM_COOKIE "changeStreamCookie"
 
 #define SYSDB_DEFAULT_ATTRS SYSDB_LAST_UPDATE, \
                             SYSDB_CACHE_EXPIRE, \
@@ -774,6 +775,29 @@ int sysdb_enumpwent_filter_with_views(TALLOC_CTX *mem_ctx,
                                       const char *addtl_filter,
                                       struct ldb_result **res);
 
+/* Largest page_size accepted by the paged enumeration calls. */
+#define SYSDB_ENUM_PAGE_MAX_SIZE 10000
+
+/* Returns at most page_size users matching name_filter whose names sort
+ * after the given name (byte-wise), in name order. Pass the last name of
+ * the previous page as after, or NULL to get the first page. EINVAL is
+ * returned if page_size is 0 or larger than SYSDB_ENUM_PAGE_MAX_SIZE. */
+int sysdb_enumpwent_page(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *domain,
+                         const char *name_filter,
+                         const char *after,
+                         size_t page_size,
+                         struct ldb_result **res);
+
+/* Same as sysdb_enumpwent_page() but with the overrides of the domain view
+ * added. Pages are still cut by the original names. */
+int sysdb_enumpwent_page_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    const char *after,
+                                    size_t page_size,
+                                    struct ldb_result **res);
+
 int sysdb_getgrnam(TALLOC_CTX *mem_ctx,
                    struct sss_domain_info *domain,
                    const char *name,
@@ -810,6 +834,23 @@ int sysdb_enumgrent_filter_with_views(TALLOC_CTX *mem_ctx,
                                       const char *addtl_filter,
                                       struct ldb_result **res);
 
+/* Same as sysdb_enumpwent_page() but for groups. */
+int sysdb_enumgrent_page(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *domain,
+                         const char *name_filter,
+                         const char *after,
+                         size_t page_size,
+                         struct ldb_result **res);
+
+/* Same as sysdb_enumpwent_page_with_views() but for groups, the overrides of
+ * the group members are added as well. */
+int sysdb_enumgrent_page_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    const char *after,
+                                    size_t page_size,
+                                    struct ldb_result **res);
+
 struct sysdb_netgroup_ctx {
     enum {SYSDB_NETGROUP_TRIPLE_VAL, SYSDB_NETGROUP_GROUP_VAL} type;
     union {
@@ -1084,6 +1125,47 @@ int sysdb_store_group(struct sss_domain_info *domain,
                       uint64_t cache_timeout,
                       time_t now);
 
+/* Entries of sysdb_store_users() and sysdb_store_groups(), the members
+ * have the same meaning as the arguments of sysdb_store_user() and
+ * sysdb_store_group() */
+struct sysdb_store_user_entry {
+    const char *name;
+    const char *pwd;
+    uid_t uid;
+    gid_t gid;
+    const char *gecos;
+    const char *homedir;
+    const char *shell;
+    const char *orig_dn;
+    struct sysdb_attrs *attrs;
+    char **remove_attrs;
+};
+
+struct sysdb_store_group_entry {
+    const char *name;
+    gid_t gid;
+    struct sysdb_attrs *attrs;
+};
+
+/* Store many users or groups in a single transaction. The cache is
+ * searched for the existing entries in a few batched searches instead of
+ * once per entry. Entries which cannot be stored are skipped and counted
+ * in _failed (optional), the transaction is only cancelled on errors
+ * which affect the whole batch. */
+errno_t sysdb_store_users(struct sss_domain_info *domain,
+                          struct sysdb_store_user_entry *users,
+                          size_t count,
+                          uint64_t cache_timeout,
+                          time_t now,
+                          size_t *_failed);
+
+errno_t sysdb_store_groups(struct sss_domain_info *domain,
+                           struct sysdb_store_group_entry *groups,
+                           size_t count,
+                           uint64_t cache_timeout,
+                           time_t now,
+                           size_t *_failed);
+
 int sysdb_add_group_member(struct sss_domain_info *domain,
                            const char *group,
                            const char *member,
@@ -1255,6 +1337,16 @@ errno_t sysdb_has_enumerated(struct sss_domain_info *domain,
 errno_t sysdb_set_enumerated(struct sss_domain_info *domain,
                              bool enumerated);
 
+/* The cookie of the LDAP change stream of the domain, base64 encoded.
+ * _cookie is set to NULL if there is no cookie. */
+errno_t sysdb_get_change_stream_cookie(TALLOC_CTX *mem_ctx,
+                                       struct sss_domain_info *domain,
+                                       const char **_cookie);
+
+/* Passing NULL removes the cookie */
+errno_t sysdb_set_change_stream_cookie(struct sss_domain_info *domain,
+                                       const char *cookie);
+
 errno_t sysdb_remove_attrs(struct sss_domain_info *domain,
                            const char *name,
                            enum sysdb_member_type type,
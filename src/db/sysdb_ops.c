@@ -3104,6 +3104,484 @@ static errno_t sysdb_store_group_attrs(struct sss_domain_info *domain,
     return EOK;
 }
 
+/* =Store-Users-and-Groups-in-bulk======================================== */
+
+/* number of names searched for with a single filter */
+#define SYSDB_STORE_BULK_CHUNK 100
+
+static errno_t sysdb_bulk_add_key(hash_table_t *existing,
+                                  const char *name)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(name);
+    value.type = HASH_VALUE_UNDEF;
+
+    hret = hash_enter(existing, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to hash %s [%d]: %s\n",
+              name, hret, hash_error_string(hret));
+        return EIO;
+    }
+
+    return EOK;
+}
+
+/* Names of case-insensitive domains are also added lower-cased */
+static errno_t sysdb_bulk_add_name(hash_table_t *existing,
+                                   struct sss_domain_info *domain,
+                                   const char *name)
+{
+    char *lc_name;
+    errno_t ret;
+
+    ret = sysdb_bulk_add_key(existing, name);
+    if (ret != EOK || domain->case_sensitive) {
+        return ret;
+    }
+
+    lc_name = sss_tc_utf8_str_tolower(NULL, name);
+    if (lc_name == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_bulk_add_key(existing, lc_name);
+    talloc_free(lc_name);
+    return ret;
+}
+
+static bool sysdb_bulk_exists(hash_table_t *existing,
+                              struct sss_domain_info *domain,
+                              const char *name)
+{
+    hash_key_t key;
+    char *lc_name;
+    bool found;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(name);
+    if (hash_has_key(existing, &key)) {
+        return true;
+    }
+
+    if (domain->case_sensitive) {
+        return false;
+    }
+
+    lc_name = sss_tc_utf8_str_tolower(NULL, name);
+    if (lc_name == NULL) {
+        return false;
+    }
+
+    key.str = lc_name;
+    found = hash_has_key(existing, &key);
+    talloc_free(lc_name);
+    return found;
+}
+
+/* Find which of the names are already cached, matching them the same way
+ * sysdb_search_user_by_name() and sysdb_search_group_by_name() do. The
+ * returned table is keyed by the cached names and aliases. */
+static errno_t sysdb_bulk_find_existing(TALLOC_CTX *mem_ctx,
+                                        struct sss_domain_info *domain,
+                                        enum sysdb_obj_type type,
+                                        const char **names,
+                                        size_t count,
+                                        hash_table_t **_existing)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_NAME_ALIAS, NULL };
+    const char *category;
+    struct ldb_dn *basedn;
+    struct ldb_message **msgs;
+    struct ldb_message_element *el;
+    hash_table_t *existing;
+    size_t msgs_count;
+    char *sanitized;
+    char *lc_sanitized;
+    char *filter;
+    size_t i;
+    size_t j;
+    size_t k;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_hash_create(tmp_ctx, count, &existing);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (type == SYSDB_USER) {
+        category = SYSDB_UC;
+        basedn = sysdb_user_base_dn(tmp_ctx, domain);
+    } else if (sss_domain_is_mpg(domain)
+                && (!local_provider_is_built()
+                    || strcasecmp(domain->provider, "local") != 0)) {
+        /* user private groups match as well, see sysdb_search_by_name() */
+        category = SYSDB_MPGC;
+        basedn = sysdb_domain_dn(tmp_ctx, domain);
+    } else {
+        category = SYSDB_GC;
+        basedn = sysdb_group_base_dn(tmp_ctx, domain);
+    }
+    if (basedn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i += SYSDB_STORE_BULK_CHUNK) {
+        filter = talloc_asprintf(tmp_ctx, "(&(%s)(|", category);
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (j = i; j < count && j < i + SYSDB_STORE_BULK_CHUNK; j++) {
+            ret = sss_filter_sanitize_for_dom(filter, names[j], domain,
+                                              &sanitized, &lc_sanitized);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            filter = talloc_asprintf_append(filter,
+                                            "(%s=%s)(%s=%s)(%s=%s)",
+                                            SYSDB_NAME_ALIAS, lc_sanitized,
+                                            SYSDB_NAME_ALIAS, sanitized,
+                                            SYSDB_NAME, sanitized);
+            if (filter == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        filter = talloc_asprintf_append(filter, "))");
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_search_entry(filter, domain->sysdb, basedn,
+                                 LDB_SCOPE_SUBTREE, filter, attrs,
+                                 &msgs_count, &msgs);
+        if (ret == ENOENT) {
+            talloc_free(filter);
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        for (j = 0; j < msgs_count; j++) {
+            el = ldb_msg_find_element(msgs[j], SYSDB_NAME);
+            if (el != NULL && el->num_values > 0) {
+                ret = sysdb_bulk_add_name(existing, domain,
+                                          (const char *)el->values[0].data);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+
+            el = ldb_msg_find_element(msgs[j], SYSDB_NAME_ALIAS);
+            for (k = 0; el != NULL && k < el->num_values; k++) {
+                ret = sysdb_bulk_add_key(existing,
+                                         (const char *)el->values[k].data);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+
+        talloc_free(filter);
+    }
+
+    *_existing = talloc_steal(mem_ctx, existing);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sysdb_store_users(struct sss_domain_info *domain,
+                          struct sysdb_store_user_entry *users,
+                          size_t count,
+                          uint64_t cache_timeout,
+                          time_t now,
+                          size_t *_failed)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_store_user_entry *u;
+    struct sysdb_attrs *attrs;
+    hash_table_t *existing;
+    const char **names;
+    size_t failed = 0;
+    size_t i;
+    bool in_transaction = false;
+    errno_t sret;
+    errno_t ret;
+
+    if (_failed != NULL) {
+        *_failed = 0;
+    }
+
+    if (count == 0) {
+        return EOK;
+    }
+
+    if (now == 0) {
+        now = time(NULL);
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    names = talloc_array(tmp_ctx, const char *, count);
+    if (names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        names[i] = users[i].name;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_bulk_find_existing(tmp_ctx, domain, SYSDB_USER,
+                                   names, count, &existing);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot search for cached users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        u = &users[i];
+
+        attrs = u->attrs;
+        if (attrs == NULL) {
+            attrs = sysdb_new_attrs(tmp_ctx);
+            if (attrs == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        if (u->pwd && !*u->pwd) {
+            ret = sysdb_attrs_add_string(attrs, SYSDB_PWD, u->pwd);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        if (sysdb_bulk_exists(existing, domain, u->name)) {
+            ret = sysdb_store_user_attrs(domain, u->name, u->uid, u->gid,
+                                         u->gecos, u->homedir, u->shell,
+                                         u->orig_dn, attrs, u->remove_attrs,
+                                         cache_timeout, now);
+        } else {
+            ret = sysdb_store_new_user(domain, u->name, u->uid, u->gid,
+                                       u->gecos, u->homedir, u->shell,
+                                       u->orig_dn, attrs,
+                                       cache_timeout, now);
+            if (ret == EOK) {
+                /* a duplicate later in the batch modifies the new user */
+                ret = sysdb_bulk_add_name(existing, domain, u->name);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot store user %s [%d]: %s\n",
+                  u->name, ret, sss_strerror(ret));
+            failed++;
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_LIBS, "User \"%s\" has been stored\n", u->name);
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Stored %zu users, %zu failed\n",
+          count - failed, failed);
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    if (ret == EOK && _failed != NULL) {
+        *_failed = failed;
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sysdb_store_groups(struct sss_domain_info *domain,
+                           struct sysdb_store_group_entry *groups,
+                           size_t count,
+                           uint64_t cache_timeout,
+                           time_t now,
+                           size_t *_failed)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_store_group_entry *g;
+    struct sysdb_store_group_entry **changed;
+    struct sysdb_attrs *attrs;
+    hash_table_t *existing;
+    const char **names;
+    size_t num_changed = 0;
+    size_t failed = 0;
+    size_t i;
+    bool in_transaction = false;
+    errno_t sret;
+    errno_t ret;
+
+    if (_failed != NULL) {
+        *_failed = 0;
+    }
+
+    if (count == 0) {
+        return EOK;
+    }
+
+    if (now == 0) {
+        now = time(NULL);
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    changed = talloc_array(tmp_ctx, struct sysdb_store_group_entry *, count);
+    names = talloc_array(tmp_ctx, const char *, count);
+    if (changed == NULL || names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Unchanged groups only need their timestamps updated, which happens
+     * outside of the cache transaction, see sysdb_store_group() */
+    for (i = 0; i < count; i++) {
+        ret = sysdb_check_and_update_ts_grp(domain, groups[i].name,
+                                            groups[i].attrs,
+                                            cache_timeout, now);
+        if (ret == EOK) {
+            DEBUG(SSSDBG_TRACE_LIBS,
+                  "The group record of %s did not change, only updated "
+                  "the timestamp cache\n", groups[i].name);
+            continue;
+        }
+
+        changed[num_changed] = &groups[i];
+        names[num_changed] = groups[i].name;
+        num_changed++;
+    }
+
+    if (num_changed == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_bulk_find_existing(tmp_ctx, domain, SYSDB_GROUP,
+                                   names, num_changed, &existing);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot search for cached groups [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (i = 0; i < num_changed; i++) {
+        g = changed[i];
+
+        attrs = g->attrs;
+        if (attrs == NULL) {
+            attrs = sysdb_new_attrs(tmp_ctx);
+            if (attrs == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        if (sysdb_bulk_exists(existing, domain, g->name)) {
+            ret = sysdb_store_group_attrs(domain, g->name, g->gid, attrs,
+                                          cache_timeout, now);
+        } else {
+            ret = sysdb_store_new_group(domain, g->name, g->gid, attrs,
+                                        cache_timeout, now);
+            if (ret == EOK) {
+                ret = sysdb_bulk_add_name(existing, domain, g->name);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot store group %s [%d]: %s\n",
+                  g->name, ret, sss_strerror(ret));
+            failed++;
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_LIBS, "Group \"%s\" has been stored\n", g->name);
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Stored %zu groups, %zu unchanged, %zu failed\n",
+          num_changed - failed, count - num_changed, failed);
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    if (ret == EOK && _failed != NULL) {
+        *_failed = failed;
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 /* =Add-User-to-Group(Native/Legacy)====================================== */
 static int
 sysdb_group_membership_mod(struct sss_domain_info *domain,
@@ -596,6 +596,182 @@ done:
     return ret;
 }
 
+/* Keeps only the page_size entries with the lowest names that sort after
+ * the cursor while the search runs, so a page does not need memory for all
+ * the entries that match the filter. */
+struct sysdb_enum_page_state {
+    const char *after;
+    size_t page_size;
+    struct ldb_message **msgs;
+    size_t count;
+};
+
+static const char *sysdb_enum_page_name(struct ldb_message *msg)
+{
+    return ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+}
+
+static void sysdb_enum_page_add(struct sysdb_enum_page_state *state,
+                                struct ldb_message *msg)
+{
+    const char *name;
+    size_t low;
+    size_t high;
+    size_t mid;
+
+    name = sysdb_enum_page_name(msg);
+    if (name == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Entry [%s] has no name, skipping\n",
+              ldb_dn_get_linearized(msg->dn));
+        return;
+    }
+
+    if (state->after != NULL && strcmp(name, state->after) <= 0) {
+        return;
+    }
+
+    if (state->count == state->page_size
+            && strcmp(name, sysdb_enum_page_name(
+                                state->msgs[state->count - 1])) >= 0) {
+        return;
+    }
+
+    low = 0;
+    high = state->count;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (strcmp(sysdb_enum_page_name(state->msgs[mid]), name) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (state->count == state->page_size) {
+        state->count--;
+        talloc_free(state->msgs[state->count]);
+    }
+
+    memmove(&state->msgs[low + 1], &state->msgs[low],
+            (state->count - low) * sizeof(struct ldb_message *));
+    state->msgs[low] = talloc_steal(state->msgs, msg);
+    state->count++;
+}
+
+static int sysdb_enum_page_callback(struct ldb_request *req,
+                                    struct ldb_reply *ares)
+{
+    struct sysdb_enum_page_state *state;
+
+    state = talloc_get_type(req->context, struct sysdb_enum_page_state);
+
+    if (ares == NULL) {
+        return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+    }
+
+    if (ares->error != LDB_SUCCESS) {
+        return ldb_request_done(req, ares->error);
+    }
+
+    switch (ares->type) {
+    case LDB_REPLY_ENTRY:
+        sysdb_enum_page_add(state, ares->message);
+        break;
+    case LDB_REPLY_REFERRAL:
+        break;
+    case LDB_REPLY_DONE:
+        talloc_free(ares);
+        return ldb_request_done(req, LDB_SUCCESS);
+    }
+
+    talloc_free(ares);
+    return LDB_SUCCESS;
+}
+
+static errno_t sysdb_enum_page(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_dn *base_dn,
+                               const char *filter,
+                               const char **attrs,
+                               const char *after,
+                               size_t page_size,
+                               struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_enum_page_state *state;
+    struct ldb_request *req;
+    struct ldb_result *res;
+    errno_t ret;
+
+    if (page_size == 0 || page_size > SYSDB_ENUM_PAGE_MAX_SIZE) {
+        DEBUG(SSSDBG_OP_FAILURE, "Invalid page size [%zu]\n", page_size);
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    state = talloc_zero(tmp_ctx, struct sysdb_enum_page_state);
+    if (state == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->after = after;
+    state->page_size = page_size;
+    state->msgs = talloc_zero_array(state, struct ldb_message *,
+                                    page_size + 1);
+    if (state->msgs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Searching cache with [%s] after [%s]\n",
+          filter, after == NULL ? "" : after);
+
+    ret = ldb_build_search_req(&req, domain->sysdb->ldb, tmp_ctx,
+                               base_dn, LDB_SCOPE_SUBTREE, filter, attrs,
+                               NULL, state, sysdb_enum_page_callback, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    ret = ldb_request(domain->sysdb->ldb, req);
+    if (ret == LDB_SUCCESS) {
+        ret = ldb_wait(req->handle, LDB_WAIT_ALL);
+    }
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    res = talloc_zero(tmp_ctx, struct ldb_result);
+    if (res == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    res->count = state->count;
+    res->msgs = talloc_steal(res, state->msgs);
+
+    /* Merge in the timestamps from the fast ts db */
+    ret = sysdb_merge_res_ts_attrs(domain->sysdb, res, attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot merge timestamp cache values\n");
+        /* non-fatal */
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+    ret = EOK;
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
 int sysdb_enumpwent_filter(TALLOC_CTX *mem_ctx,
                            struct sss_domain_info *domain,
                            const char *name_filter,
@@ -747,6 +923,89 @@ int sysdb_enumpwent_with_views(TALLOC_CTX *mem_ctx,
     return sysdb_enumpwent_filter_with_views(mem_ctx, domain, NULL, NULL, _res);
 }
 
+int sysdb_enumpwent_page(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *domain,
+                         const char *name_filter,
+                         const char *after,
+                         size_t page_size,
+                         struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = SYSDB_PW_ATTRS;
+    struct ldb_dn *base_dn;
+    char *filter;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    base_dn = sysdb_user_base_dn(tmp_ctx, domain);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = enum_filter(tmp_ctx, SYSDB_PWENT_FILTER, name_filter, NULL);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_enum_page(mem_ctx, domain, base_dn, filter, attrs, after,
+                          page_size, _res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+int sysdb_enumpwent_page_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    const char *after,
+                                    size_t page_size,
+                                    struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    size_t c;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    ret = sysdb_enumpwent_page(tmp_ctx, domain, name_filter, after,
+                               page_size, &res);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sysdb_enumpwent_page failed.\n");
+        goto done;
+    }
+
+    if (DOM_HAS_VIEWS(domain)) {
+        for (c = 0; c < res->count; c++) {
+            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                NULL);
+            /* enumeration assumes that the cache is up-to-date, hence we do not
+             * need to handle ENOENT separately. */
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
+                goto done;
+            }
+        }
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
 /* groups */
 
 static int mpg_convert(struct ldb_message *msg)
@@ -1365,6 +1624,115 @@ int sysdb_enumgrent_with_views(TALLOC_CTX *mem_ctx,
     return sysdb_enumgrent_filter_with_views(mem_ctx, domain, NULL, NULL, _res);
 }
 
+int sysdb_enumgrent_page(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *domain,
+                         const char *name_filter,
+                         const char *after,
+                         size_t page_size,
+                         struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = SYSDB_GRSRC_ATTRS;
+    const char *base_filter;
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    char *filter;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (sss_domain_is_mpg(domain)) {
+        base_filter = SYSDB_GRENT_MPG_FILTER;
+        base_dn = sysdb_domain_dn(tmp_ctx, domain);
+    } else {
+        base_filter = SYSDB_GRENT_FILTER;
+        base_dn = sysdb_group_base_dn(tmp_ctx, domain);
+    }
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = enum_filter(tmp_ctx, base_filter, name_filter, NULL);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_enum_page(tmp_ctx, domain, base_dn, filter, attrs, after,
+                          page_size, &res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = mpg_res_convert(res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+int sysdb_enumgrent_page_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    const char *after,
+                                    size_t page_size,
+                                    struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    size_t c;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    ret = sysdb_enumgrent_page(tmp_ctx, domain, name_filter, after,
+                               page_size, &res);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sysdb_enumgrent_page failed.\n");
+        goto done;
+    }
+
+    for (c = 0; c < res->count; c++) {
+        if (DOM_HAS_VIEWS(domain)) {
+            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                NULL);
+            /* enumeration assumes that the cache is up-to-date, hence we do not
+             * need to handle ENOENT separately. */
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
+                goto done;
+            }
+        }
+
+        ret = sysdb_add_group_member_overrides(domain, res->msgs[c],
+                                               DOM_HAS_VIEWS(domain));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_add_group_member_overrides failed.\n");
+            goto done;
+        }
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
 int sysdb_initgroups(TALLOC_CTX *mem_ctx,
                      struct sss_domain_info *domain,
                      const char *name,
@@ -225,6 +225,205 @@ static int entry_is_group_object(struct ldb_message *entry)
     return entry_has_objectclass(entry, DB_GROUP_CLASS);
 }
 
+/* Transaction scoped cache of the memberof values (the ancestors) of
+ * groups. When a member removal cascades through nested groups the
+ * ancestors of the same parent groups are needed for every member below
+ * them, the cache spares a base search per member and parent.
+ *
+ * memberof is readonly for everybody but this module, so the cache stays
+ * valid as long as each memberof write done here updates or drops the
+ * cached value. It is emptied whenever a transaction starts or ends. */
+struct mbof_cache {
+    TALLOC_CTX *mem_ctx;
+    hash_table_t *ancestors;
+    int trans_depth;
+};
+
+static struct mbof_cache *mbof_cache_from_module(struct ldb_module *module)
+{
+    return talloc_get_type(ldb_module_get_private(module), struct mbof_cache);
+}
+
+static void mbof_cache_reset(struct ldb_module *module)
+{
+    struct mbof_cache *cache;
+
+    cache = mbof_cache_from_module(module);
+    if (cache == NULL) {
+        return;
+    }
+
+    talloc_zfree(cache->mem_ctx);
+    cache->ancestors = NULL;
+}
+
+static bool mbof_cache_key(struct ldb_dn *dn, hash_key_t *key)
+{
+    const char *casefold;
+
+    casefold = ldb_dn_get_casefold(dn);
+    if (casefold == NULL) {
+        return false;
+    }
+
+    key->type = HASH_KEY_STRING;
+    key->str = discard_const(casefold);
+    return true;
+}
+
+static struct mbof_dn_array *mbof_cache_lookup(struct ldb_module *module,
+                                               struct ldb_dn *dn)
+{
+    struct mbof_cache *cache;
+    hash_key_t key;
+    hash_value_t value;
+    int ret;
+
+    cache = mbof_cache_from_module(module);
+    if (cache == NULL || cache->trans_depth == 0 || cache->ancestors == NULL) {
+        return NULL;
+    }
+
+    if (!mbof_cache_key(dn, &key)) {
+        return NULL;
+    }
+
+    ret = hash_lookup(cache->ancestors, &key, &value);
+    if (ret != HASH_SUCCESS) {
+        return NULL;
+    }
+
+    return talloc_get_type(value.ptr, struct mbof_dn_array);
+}
+
+static void mbof_cache_invalidate(struct ldb_module *module,
+                                  struct ldb_dn *dn)
+{
+    struct mbof_cache *cache;
+    struct mbof_dn_array *anc;
+    hash_key_t key;
+
+    anc = mbof_cache_lookup(module, dn);
+    if (anc == NULL) {
+        return;
+    }
+
+    cache = mbof_cache_from_module(module);
+    if (!mbof_cache_key(dn, &key)
+            || hash_delete(cache->ancestors, &key) != HASH_SUCCESS) {
+        mbof_cache_reset(module);
+        return;
+    }
+    talloc_free(anc);
+}
+
+/* Remember the ancestors of a group, dn itself is skipped if it is in the
+ * list. Errors are not fatal, they just empty the cache. */
+static void mbof_cache_store(struct ldb_module *module,
+                             struct ldb_dn *dn,
+                             struct ldb_dn **dns, int num)
+{
+    struct mbof_cache *cache;
+    struct mbof_dn_array *anc;
+    hash_key_t key;
+    hash_value_t value;
+    int i;
+    int ret;
+
+    cache = mbof_cache_from_module(module);
+    if (cache == NULL || cache->trans_depth == 0) {
+        return;
+    }
+
+    mbof_cache_invalidate(module, dn);
+
+    if (cache->ancestors == NULL) {
+        cache->mem_ctx = talloc_new(cache);
+        if (cache->mem_ctx == NULL) {
+            return;
+        }
+
+        ret = hash_create_ex(1024, &cache->ancestors, 0, 0, 0, 0,
+                             hash_alloc, hash_free, cache->mem_ctx,
+                             NULL, NULL);
+        if (ret != HASH_SUCCESS) {
+            goto fail;
+        }
+    }
+
+    anc = talloc_zero(cache->mem_ctx, struct mbof_dn_array);
+    if (anc == NULL) {
+        goto fail;
+    }
+
+    anc->dns = talloc_array(anc, struct ldb_dn *, num);
+    if (anc->dns == NULL) {
+        goto fail;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (ldb_dn_compare(dns[i], dn) == 0) {
+            continue;
+        }
+        anc->dns[anc->num] = ldb_dn_copy(anc, dns[i]);
+        if (anc->dns[anc->num] == NULL) {
+            goto fail;
+        }
+        anc->num++;
+    }
+
+    if (!mbof_cache_key(dn, &key)) {
+        goto fail;
+    }
+    value.type = HASH_VALUE_PTR;
+    value.ptr = anc;
+
+    ret = hash_enter(cache->ancestors, &key, &value);
+    if (ret != HASH_SUCCESS) {
+        goto fail;
+    }
+
+    return;
+
+fail:
+    mbof_cache_reset(module);
+}
+
+static void mbof_cache_store_el(struct ldb_module *module,
+                                struct ldb_dn *dn,
+                                const struct ldb_message_element *el)
+{
+    struct ldb_context *ldb = ldb_module_get_ctx(module);
+    struct ldb_dn **dns;
+    int num = 0;
+    int i;
+
+    if (el == NULL) {
+        mbof_cache_store(module, dn, NULL, 0);
+        return;
+    }
+
+    dns = talloc_array(NULL, struct ldb_dn *, el->num_values);
+    if (dns == NULL) {
+        mbof_cache_invalidate(module, dn);
+        return;
+    }
+
+    for (i = 0; i < el->num_values; i++) {
+        dns[num] = ldb_dn_from_ldb_val(dns, ldb, &el->values[i]);
+        if (dns[num] == NULL || !ldb_dn_validate(dns[num])) {
+            /* do not cache what cannot be parsed */
+            mbof_cache_invalidate(module, dn);
+            talloc_free(dns);
+            return;
+        }
+        num++;
+    }
+
+    mbof_cache_store(module, dn, dns, num);
+    talloc_free(dns);
+}
+
 static int mbof_append_muop(TALLOC_CTX *memctx,
                             struct mbof_memberuid_op **_muops,
                             int *_num_muops,
@@ -511,6 +710,9 @@ static int memberof_add(struct ldb_module *module, struct ldb_request *req)
     }
     add_ctx->msg_dn = add_ctx->msg->dn;
 
+    /* a new entry never inherits a stale memberof */
+    mbof_cache_invalidate(module, add_ctx->msg_dn);
+
     /* continue with normal ops if there are no members */
     el = ldb_msg_find_element(add_ctx->msg, DB_MEMBER);
     if (!el) {
@@ -949,6 +1151,8 @@ static int mbof_add_operation(struct mbof_add_operation *addop)
     }
     el->num_values = j;
 
+    mbof_cache_invalidate(ctx->module, addop->entry_dn);
+
     ret = ldb_build_mod_req(&mod_req, ldb, add_ctx,
                             msg, NULL,
                             add_ctx, mbof_add_callback,
@@ -1310,6 +1514,10 @@ static int mbof_del_ghop(struct mbof_del_ctx *del_ctx);
 static int mbof_del_ghop_callback(struct ldb_request *req,
                                   struct ldb_reply *ares);
 static void free_delop_contents(struct mbof_del_operation *delop);
+static int mbof_fill_dn_array(TALLOC_CTX *memctx,
+                              struct ldb_context *ldb,
+                              const struct ldb_message_element *el,
+                              struct mbof_dn_array **dn_array);
 
 
 static int memberof_del(struct ldb_module *module, struct ldb_request *req)
@@ -1333,6 +1541,8 @@ static int memberof_del(struct ldb_module *module, struct ldb_request *req)
         return ldb_next_request(module, req);
     }
 
+    mbof_cache_invalidate(module, req->op.del.dn);
+
     ctx = mbof_init(module, req);
     if (!ctx) {
         return LDB_ERR_OPERATIONS_ERROR;
@@ -1881,6 +2091,8 @@ static int mbof_del_exop_search_callback(struct ldb_request *req,
                                    LDB_ERR_OPERATIONS_ERROR);
         }
 
+        talloc_zfree(ares);
+
         /* ok process the entry */
         ret = mbof_del_execute_cont(delop);
 
@@ -1888,6 +2100,7 @@ static int mbof_del_exop_search_callback(struct ldb_request *req,
             return ldb_module_done(ctx->req, NULL, NULL,
                                    LDB_ERR_OPERATIONS_ERROR);
         }
+        return LDB_SUCCESS;
     }
 
     talloc_zfree(ares);
@@ -1944,6 +2157,37 @@ static int mbof_del_execute_cont(struct mbof_del_operation *delop)
     return mbof_del_ancestors(delop);
 }
 
+static int mbof_del_merge_ancestors(struct mbof_dn_array *new_list,
+                                    struct mbof_dn_array *anc)
+{
+    int i, j;
+
+    for (i = 0; i < anc->num; i++) {
+        for (j = 0; j < new_list->num; j++) {
+            if (ldb_dn_compare(anc->dns[i], new_list->dns[j]) == 0)
+                break;
+        }
+        if (j < new_list->num) {
+            continue;
+        }
+
+        new_list->dns = talloc_realloc(new_list,
+                                       new_list->dns,
+                                       struct ldb_dn *,
+                                       new_list->num + 1);
+        if (!new_list->dns) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
+        new_list->dns[new_list->num] = ldb_dn_copy(new_list, anc->dns[i]);
+        if (!new_list->dns[new_list->num]) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
+        new_list->num++;
+    }
+
+    return LDB_SUCCESS;
+}
+
 static int mbof_del_ancestors(struct mbof_del_operation *delop)
 {
     struct mbof_del_ancestors_ctx *anc_ctx;
@@ -1951,6 +2195,7 @@ static int mbof_del_ancestors(struct mbof_del_operation *delop)
     struct mbof_ctx *ctx;
     struct ldb_context *ldb;
     struct mbof_dn_array *new_list;
+    struct mbof_dn_array *anc;
     static const char *attrs[] = { DB_MEMBEROF, NULL };
     struct ldb_request *search;
     int ret;
@@ -1961,7 +2206,27 @@ static int mbof_del_ancestors(struct mbof_del_operation *delop)
     anc_ctx = delop->anc_ctx;
     new_list = anc_ctx->new_list;
 
-    ret = ldb_build_search_req(&search, ldb, anc_ctx,
+    /* siblings share their parents, so the ancestors of most of the
+     * parents are usually known already */
+    while (anc_ctx->cur < anc_ctx->num_direct) {
+        anc = mbof_cache_lookup(ctx->module, new_list->dns[anc_ctx->cur]);
+        if (anc == NULL) {
+            break;
+        }
+
+        ret = mbof_del_merge_ancestors(new_list, anc);
+        if (ret != LDB_SUCCESS) {
+            return ret;
+        }
+        anc_ctx->cur++;
+    }
+
+    if (anc_ctx->cur >= anc_ctx->num_direct) {
+        /* ok, end of the story, proceed to modify the entry */
+        return mbof_del_mod_entry(delop);
+    }
+
+    ret = ldb_build_search_req(&search, ldb, delop,
                                new_list->dns[anc_ctx->cur],
                                LDB_SCOPE_BASE, NULL, attrs, NULL,
                                delop, mbof_del_anc_callback,
@@ -2069,30 +2334,141 @@ static int mbof_del_anc_callback(struct ldb_request *req,
             }
         }
 
+        mbof_cache_store_el(ctx->module, anc_ctx->entry->dn, el);
+
         /* done with this one */
         talloc_free(anc_ctx->entry);
         anc_ctx->entry = NULL;
         anc_ctx->cur++;
+        talloc_zfree(ares);
 
-        /* check if we need to process any more */
-        if (anc_ctx->cur < anc_ctx->num_direct) {
-            /* ok process the next one */
-            ret = mbof_del_ancestors(delop);
-        } else {
-            /* ok, end of the story, proceed to modify the entry */
-            ret = mbof_del_mod_entry(delop);
-        }
+        /* process the next one, or modify the entry if none is left, the
+         * latter may complete the operation right away when memberof does
+         * not change */
+        ret = mbof_del_ancestors(delop);
 
         if (ret != LDB_SUCCESS) {
             return ldb_module_done(ctx->req, NULL, NULL,
                                    LDB_ERR_OPERATIONS_ERROR);
         }
+        return LDB_SUCCESS;
     }
 
     talloc_zfree(ares);
     return LDB_SUCCESS;
 }
 
+static int mbof_msg_add_memberof(struct ldb_message *msg, int flags,
+                                 struct ldb_dn **dns, int num)
+{
+    struct ldb_message_element *el;
+    const char *val;
+    int i, j, ret;
+
+    ret = ldb_msg_add_empty(msg, DB_MEMBEROF, flags, &el);
+    if (ret != LDB_SUCCESS) {
+        return ret;
+    }
+    if (num == 0) {
+        return LDB_SUCCESS;
+    }
+
+    el->values = talloc_array(msg, struct ldb_val, num);
+    if (!el->values) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+    for (i = 0, j = 0; i < num; i++) {
+        if (ldb_dn_compare(dns[i], msg->dn) == 0)
+            continue;
+        val = ldb_dn_get_linearized(dns[i]);
+        if (!val) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
+        el->values[j].length = strlen(val);
+        el->values[j].data = (uint8_t *)talloc_strdup(el->values, val);
+        if (!el->values[j].data) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
+        j++;
+    }
+    el->num_values = j;
+
+    return LDB_SUCCESS;
+}
+
+/* fill msg with the memberof values to remove from and to add to entry so
+ * that it ends up with new_list, nothing is added if they already match */
+static int mbof_del_memberof_delta(struct ldb_message *msg,
+                                   struct ldb_context *ldb,
+                                   struct ldb_message *entry,
+                                   struct mbof_dn_array *new_list)
+{
+    struct mbof_dn_array *old_list;
+    struct ldb_dn **dns;
+    int num, i, j;
+    int ret;
+
+    ret = mbof_fill_dn_array(msg, ldb,
+                             ldb_msg_find_element(entry, DB_MEMBEROF),
+                             &old_list);
+    if (ret == LDB_ERR_INVALID_DN_SYNTAX) {
+        /* do not try to diff a broken attribute, rewrite it all */
+        return mbof_msg_add_memberof(msg, new_list->num ?
+                                          LDB_FLAG_MOD_REPLACE :
+                                          LDB_FLAG_MOD_DELETE,
+                                     new_list->dns, new_list->num);
+    } else if (ret != LDB_SUCCESS) {
+        return ret;
+    }
+
+    dns = talloc_array(msg, struct ldb_dn *,
+                       MAX(old_list->num, new_list->num));
+    if (!dns) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    /* values not inherited anymore */
+    for (i = 0, num = 0; i < old_list->num; i++) {
+        for (j = 0; j < new_list->num; j++) {
+            if (ldb_dn_compare(old_list->dns[i], new_list->dns[j]) == 0)
+                break;
+        }
+        if (j == new_list->num) {
+            dns[num] = old_list->dns[i];
+            num++;
+        }
+    }
+    if (num > 0) {
+        ret = mbof_msg_add_memberof(msg, LDB_FLAG_MOD_DELETE, dns, num);
+        if (ret != LDB_SUCCESS) {
+            return ret;
+        }
+    }
+
+    /* newly inherited values */
+    for (i = 0, num = 0; i < new_list->num; i++) {
+        if (ldb_dn_compare(new_list->dns[i], msg->dn) == 0)
+            continue;
+        for (j = 0; j < old_list->num; j++) {
+            if (ldb_dn_compare(new_list->dns[i], old_list->dns[j]) == 0)
+                break;
+        }
+        if (j == old_list->num) {
+            dns[num] = new_list->dns[i];
+            num++;
+        }
+    }
+    if (num > 0) {
+        ret = mbof_msg_add_memberof(msg, LDB_FLAG_MOD_ADD, dns, num);
+        if (ret != LDB_SUCCESS) {
+            return ret;
+        }
+    }
+
+    talloc_free(dns);
+    return LDB_SUCCESS;
+}
+
 static int mbof_del_mod_entry(struct mbof_del_operation *delop)
 {
     struct mbof_del_ctx *del_ctx;
@@ -2104,7 +2480,6 @@ static int mbof_del_mod_entry(struct mbof_del_operation *delop)
     struct ldb_message_element *el;
     struct ldb_dn **diff = NULL;
     const char *name;
-    const char *val;
     int i, j, k;
     bool is_user;
     int ret;
@@ -2160,6 +2535,24 @@ static int mbof_del_mod_entry(struct mbof_del_operation *delop)
         }
         /* zero terminate array */
         diff[j] = NULL;
+
+        /* compare the entry's original memberof list with the new
+         * one and for each missing entry add a memberuid removal
+         * operation */
+        for (i = 0; i < new_list->num; i++) {
+            for (k = 0; diff[k]; k++) {
+                if (ldb_dn_compare(new_list->dns[i], diff[k]) == 0) {
+                    break;
+                }
+            }
+            if (diff[k]) {
+                talloc_zfree(diff[k]);
+                for (; diff[k + 1]; k++) {
+                    diff[k] = diff[k + 1];
+                }
+                diff[k] = NULL;
+            }
+        }
     }
 
     /* change memberof on entry */
@@ -2168,56 +2561,14 @@ static int mbof_del_mod_entry(struct mbof_del_operation *delop)
 
     msg->dn = delop->entry_dn;
 
-    if (new_list->num) {
-        ret = ldb_msg_add_empty(msg, DB_MEMBEROF, LDB_FLAG_MOD_REPLACE, &el);
-        if (ret != LDB_SUCCESS) {
-            return ret;
-        }
-
-        el->values = talloc_array(el, struct ldb_val, new_list->num);
-        if (!el->values) {
-            return LDB_ERR_OPERATIONS_ERROR;
-        }
-        for (i = 0, j = 0; i < new_list->num; i++) {
-            if (ldb_dn_compare(new_list->dns[i], msg->dn) == 0)
-                continue;
-            val = ldb_dn_get_linearized(new_list->dns[i]);
-            if (!val) {
-                return LDB_ERR_OPERATIONS_ERROR;
-            }
-            el->values[j].length = strlen(val);
-            el->values[j].data = (uint8_t *)talloc_strdup(el->values, val);
-            if (!el->values[j].data) {
-                return LDB_ERR_OPERATIONS_ERROR;
-            }
-            j++;
-
-            if (is_user) {
-                /* compare the entry's original memberof list with the new
-                 * one and for each missing entry add a memberuid removal
-                 * operation */
-                for (k = 0; diff[k]; k++) {
-                    if (ldb_dn_compare(new_list->dns[i], diff[k]) == 0) {
-                        break;
-                    }
-                }
-                if (diff[k]) {
-                    talloc_zfree(diff[k]);
-                    for (; diff[k + 1]; k++) {
-                        diff[k] = diff[k + 1];
-                    }
-                    diff[k] = NULL;
-                }
-            }
-        }
-        el->num_values = j;
-
+    ret = mbof_del_memberof_delta(msg, ldb, delop->entry, new_list);
+    if (ret != LDB_SUCCESS) {
+        return ret;
     }
-    else {
-        ret = ldb_msg_add_empty(msg, DB_MEMBEROF, LDB_FLAG_MOD_DELETE, &el);
-        if (ret != LDB_SUCCESS) {
-            return ret;
-        }
+
+    if (entry_is_group_object(delop->entry) == LDB_SUCCESS) {
+        mbof_cache_store(ctx->module, delop->entry_dn,
+                         new_list->dns, new_list->num);
     }
 
     if (is_user && diff[0]) {
@@ -2240,6 +2591,12 @@ static int mbof_del_mod_entry(struct mbof_del_operation *delop)
         }
     }
 
+    if (msg->num_elements == 0) {
+        /* memberof is unchanged, go on with the members */
+        talloc_free(msg);
+        return mbof_del_progeny(delop);
+    }
+
     ret = ldb_build_mod_req(&mod_req, ldb, delop,
                             msg, NULL,
                             delop, mbof_del_mod_callback,
@@ -2846,10 +3203,6 @@ static int mbof_mod_process_ghel(TALLOC_CTX *mem_ctx,
 static int mbof_mod_delete(struct mbof_mod_ctx *mod_ctx,
                            struct mbof_dn_array *del,
                            struct mbof_val_array *delgh);
-static int mbof_fill_dn_array(TALLOC_CTX *memctx,
-                              struct ldb_context *ldb,
-                              const struct ldb_message_element *el,
-                              struct mbof_dn_array **dn_array);
 static int mbof_fill_vals_array(TALLOC_CTX *memctx,
                                 unsigned int num_values,
                                 struct ldb_val *values,
@@ -2870,7 +3223,9 @@ static int memberof_mod(struct ldb_module *module, struct ldb_request *req)
     int ret;
 
     if (getenv("SSSD_UPGRADE_DB")) {
-        /* do not do anything during upgrade */
+        /* do not do anything during upgrade, memberof may be written
+         * directly so do not trust the cache either */
+        mbof_cache_reset(module);
         return ldb_next_request(module, req);
     }
 
@@ -3929,6 +4284,9 @@ static int memberof_recompute_task(struct ldb_module *module,
     struct ldb_request *src_req;
     int ret;
 
+    /* every memberof value is about to be rewritten */
+    mbof_cache_reset(module);
+
     ctx = talloc_zero(req, struct mbof_rcmp_context);
     if (!ctx) {
         return LDB_ERR_OPERATIONS_ERROR;
@@ -4546,13 +4904,67 @@ static int mbof_rcmp_mod_callback(struct ldb_request *req,
 
 
 
+/* rename and transactions */
+
+static int memberof_rename(struct ldb_module *module, struct ldb_request *req)
+{
+    /* the cache is keyed by DN, just start over */
+    mbof_cache_reset(module);
+
+    return ldb_next_request(module, req);
+}
+
+static int memberof_start_transaction(struct ldb_module *module)
+{
+    struct mbof_cache *cache;
+
+    cache = mbof_cache_from_module(module);
+    mbof_cache_reset(module);
+    cache->trans_depth++;
+
+    return ldb_next_start_trans(module);
+}
+
+static int memberof_end_transaction(struct ldb_module *module)
+{
+    struct mbof_cache *cache;
+
+    cache = mbof_cache_from_module(module);
+    mbof_cache_reset(module);
+    if (cache->trans_depth > 0) {
+        cache->trans_depth--;
+    }
+
+    return ldb_next_end_trans(module);
+}
+
+static int memberof_del_transaction(struct ldb_module *module)
+{
+    struct mbof_cache *cache;
+
+    cache = mbof_cache_from_module(module);
+    mbof_cache_reset(module);
+    if (cache->trans_depth > 0) {
+        cache->trans_depth--;
+    }
+
+    return ldb_next_del_trans(module);
+}
+
 /* module init code */
 
 static int memberof_init(struct ldb_module *module)
 {
     struct ldb_context *ldb = ldb_module_get_ctx(module);
+    struct mbof_cache *cache;
     int ret;
 
+    cache = talloc_zero(module, struct mbof_cache);
+    if (cache == NULL) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+    ldb_module_set_private(module, cache);
+
     /* set syntaxes for member and memberof so that comparisons in filters and
      * such are done right */
     ret = ldb_schema_attribute_add(ldb, DB_MEMBER, 0, LDB_SYNTAX_DN);
@@ -4570,6 +4982,10 @@ const struct ldb_module_ops ldb_memberof_module_ops = {
     .add = memberof_add,
     .modify = memberof_mod,
     .del = memberof_del,
+    .rename = memberof_rename,
+    .start_transaction = memberof_start_transaction,
+    .end_transaction = memberof_end_transaction,
+    .del_transaction = memberof_del_transaction,
 };
 
 int ldb_init_module(const char *version)
@@ -33,6 +33,8 @@
 
 #define SID_FMT "%s-%d"
 #define SID_STR_MAX_LEN 1024
+#define SID_TABLE_MIN_SIZE 64
+#define RANGE_TABLE_MIN_SIZE 16
 
 /* Hold all parameters for unix<->sid mapping relevant for
  * given slice. */
@@ -58,6 +60,15 @@ struct idmap_domain_info {
 
     idmap_store_cb cb;
     void *pvt;
+
+    /* SID index, the newest domain of each SID is linked into the hash
+     * table and the older ones with the same SID hang off it in the same
+     * order as in the domain list. */
+    uint32_t seq;
+    uint32_t sid_hash;
+    size_t sid_len;
+    struct idmap_domain_info *hash_next;
+    struct idmap_domain_info *sid_next;
 };
 
 static void *default_alloc(size_t size, void *pvt)
@@ -105,50 +116,343 @@ static bool ranges_eq(const struct idmap_range_params *a,
     return false;
 }
 
+static bool id_is_in_range(uint32_t id,
+                           struct idmap_range_params *rp,
+                           uint32_t *rid)
+{
+    if (id == 0 || rp == NULL) {
+        return false;
+    }
+
+    if (id >= rp->min_id && id <= rp->max_id) {
+        if (rid != NULL) {
+            *rid = rp->first_rid + (id - rp->min_id);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+static bool is_sid_from_dom(const char *dom_sid, const char *sid,
+                            size_t *_dom_sid_len)
+{
+    size_t dom_sid_len;
+
+    if (dom_sid == NULL) {
+        return false;
+    }
+
+    dom_sid_len = strlen(dom_sid);
+    *_dom_sid_len = dom_sid_len;
+
+    if (strlen(sid) < dom_sid_len || sid[dom_sid_len] != '-') {
+        return false;
+    }
+
+    return strncmp(sid, dom_sid, dom_sid_len) == 0;
+}
+
+static uint32_t sid_hash(const char *sid, size_t len)
+{
+    return murmurhash3(sid, len, 0xdeadbeef);
+}
+
+static struct idmap_domain_info *sid_table_get(struct sss_idmap_ctx *ctx,
+                                               const char *sid,
+                                               size_t len)
+{
+    struct idmap_domain_info *it;
+    uint32_t hash;
+
+    if (ctx->sid_table == NULL) {
+        return NULL;
+    }
+
+    hash = sid_hash(sid, len);
+    for (it = ctx->sid_table[hash & (ctx->sid_table_size - 1)];
+         it != NULL;
+         it = it->hash_next) {
+        if (it->sid_hash == hash && it->sid_len == len
+                && memcmp(it->sid, sid, len) == 0) {
+            return it;
+        }
+    }
+
+    return NULL;
+}
+
+/* Make sure one more SID fits into the hash table. */
+static enum idmap_error_code sid_table_reserve(struct sss_idmap_ctx *ctx)
+{
+    struct idmap_domain_info **table;
+    struct idmap_domain_info *it;
+    struct idmap_domain_info *next;
+    size_t size;
+    size_t i;
+
+    if (ctx->sid_count < ctx->sid_table_size) {
+        return IDMAP_SUCCESS;
+    }
+
+    size = ctx->sid_table_size == 0 ? SID_TABLE_MIN_SIZE
+                                    : ctx->sid_table_size * 2;
+
+    table = ctx->alloc_func(size * sizeof(struct idmap_domain_info *),
+                            ctx->alloc_pvt);
+    if (table == NULL) {
+        return IDMAP_OUT_OF_MEMORY;
+    }
+    memset(table, 0, size * sizeof(struct idmap_domain_info *));
+
+    for (i = 0; i < ctx->sid_table_size; i++) {
+        for (it = ctx->sid_table[i]; it != NULL; it = next) {
+            next = it->hash_next;
+            it->hash_next = table[it->sid_hash & (size - 1)];
+            table[it->sid_hash & (size - 1)] = it;
+        }
+    }
+
+    if (ctx->sid_table != NULL) {
+        ctx->free_func(ctx->sid_table, ctx->alloc_pvt);
+    }
+    ctx->sid_table = table;
+    ctx->sid_table_size = size;
+
+    return IDMAP_SUCCESS;
+}
+
+static void sid_table_add(struct sss_idmap_ctx *ctx,
+                          struct idmap_domain_info *dom)
+{
+    struct idmap_domain_info **bucket;
+    struct idmap_domain_info *head;
+
+    dom->sid_len = strlen(dom->sid);
+    dom->sid_hash = sid_hash(dom->sid, dom->sid_len);
+
+    head = sid_table_get(ctx, dom->sid, dom->sid_len);
+    bucket = &ctx->sid_table[dom->sid_hash & (ctx->sid_table_size - 1)];
+
+    if (head == NULL) {
+        dom->hash_next = *bucket;
+        *bucket = dom;
+        ctx->sid_count++;
+        return;
+    }
+
+    /* The new domain replaces the head, like in the domain list. */
+    while (*bucket != head) {
+        bucket = &(*bucket)->hash_next;
+    }
+
+    dom->hash_next = head->hash_next;
+    dom->sid_next = head;
+    head->hash_next = NULL;
+    *bucket = dom;
+}
+
+/* Returns the domains the SID can belong to. If *_by_sid is true only the
+ * domains with the same domain SID have to be checked, they are linked by
+ * sid_next. Otherwise all domains have to be checked, this happens only if
+ * the SID has more components after a known domain SID, so the search
+ * reports the same error as before. */
+static struct idmap_domain_info *sid_domains(struct sss_idmap_ctx *ctx,
+                                             const char *sid,
+                                             bool *_by_sid)
+{
+    struct idmap_domain_info *dom;
+    const char *sep;
+    const char *p;
+
+    *_by_sid = false;
+
+    sep = strrchr(sid, '-');
+    if (sep == NULL) {
+        return NULL;
+    }
+
+    dom = sid_table_get(ctx, sid, sep - sid);
+    if (dom != NULL) {
+        *_by_sid = true;
+        return dom;
+    }
+
+    for (p = sep - 1; p > sid; p--) {
+        if (*p == '-' && sid_table_get(ctx, sid, p - sid) != NULL) {
+            return ctx->idmap_domain_info;
+        }
+    }
+
+    return NULL;
+}
+
+static struct idmap_domain_info *
+next_sid_domain(struct idmap_domain_info *dom, bool by_sid)
+{
+    return by_sid ? dom->sid_next : dom->next;
+}
+
+/* Number of entries with min_id less than or equal to id. */
+static size_t range_table_bound(struct idmap_range_table *table, uint32_t id)
+{
+    size_t lo = 0;
+    size_t hi = table->count;
+    size_t mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (table->entries[mid].min_id <= id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
 static enum idmap_error_code
-construct_range(struct sss_idmap_ctx *ctx,
-                const struct idmap_range_params *src,
-                char *id,
-                struct idmap_range_params **_dst)
+range_table_reserve(struct sss_idmap_ctx *ctx,
+                    struct idmap_range_table *table,
+                    size_t num)
 {
-    struct idmap_range_params *dst;
+    struct idmap_range_entry *entries;
+    size_t size;
 
-    if (src == NULL || id == NULL || _dst == NULL) {
-        return IDMAP_ERROR;
+    if (table->count + num <= table->size) {
+        return IDMAP_SUCCESS;
     }
 
-    dst = ctx->alloc_func(sizeof(struct idmap_range_params), ctx->alloc_pvt);
-    if (dst == NULL) {
+    size = table->size == 0 ? RANGE_TABLE_MIN_SIZE : table->size * 2;
+    while (size < table->count + num) {
+        size *= 2;
+    }
+
+    entries = ctx->alloc_func(size * sizeof(struct idmap_range_entry),
+                              ctx->alloc_pvt);
+    if (entries == NULL) {
         return IDMAP_OUT_OF_MEMORY;
     }
 
-    dst->min_id = src->min_id;
-    dst->max_id = src->max_id;
-    dst->first_rid = src->first_rid;
-    dst->next = NULL;
-    dst->range_id = id;
+    if (table->entries != NULL) {
+        memcpy(entries, table->entries,
+               table->count * sizeof(struct idmap_range_entry));
+        ctx->free_func(table->entries, ctx->alloc_pvt);
+    }
+    table->entries = entries;
+    table->size = size;
 
-    *_dst = dst;
     return IDMAP_SUCCESS;
 }
 
-static bool id_is_in_range(uint32_t id,
-                           struct idmap_range_params *rp,
-                           uint32_t *rid)
+static void range_table_add(struct idmap_range_table *table,
+                            struct idmap_range_params *range,
+                            struct idmap_domain_info *dom,
+                            uint64_t rank)
 {
-    if (id == 0 || rp == NULL) {
-        return false;
+    struct idmap_range_entry *entry;
+    size_t pos;
+    size_t i;
+
+    pos = range_table_bound(table, range->min_id);
+    memmove(&table->entries[pos + 1], &table->entries[pos],
+            (table->count - pos) * sizeof(struct idmap_range_entry));
+    table->count++;
+
+    entry = &table->entries[pos];
+    entry->min_id = range->min_id;
+    entry->max_id = range->max_id;
+    entry->rank = rank;
+    entry->range = range;
+    entry->dom = dom;
+
+    for (i = pos; i < table->count; i++) {
+        entry = &table->entries[i];
+        entry->max_end = entry->max_id;
+        if (i > 0 && table->entries[i - 1].max_end > entry->max_end) {
+            entry->max_end = table->entries[i - 1].max_end;
+        }
     }
+}
 
-    if (id >= rp->min_id && id <= rp->max_id) {
-        if (rid != NULL) {
-            *rid = rp->first_rid + (id - rp->min_id);
+/* Returns the entry with the highest rank whose range contains id. */
+static struct idmap_range_entry *
+range_table_find(struct idmap_range_table *table, uint32_t id)
+{
+    struct idmap_range_entry *entry;
+    struct idmap_range_entry *found = NULL;
+    size_t i;
+
+    for (i = range_table_bound(table, id); i > 0; i--) {
+        entry = &table->entries[i - 1];
+        if (entry->max_end < id) {
+            break;
         }
 
-        return true;
+        if (entry->max_id >= id
+                && (found == NULL || entry->rank > found->rank)) {
+            found = entry;
+        }
     }
 
-    return false;
+    return found;
+}
+
+static enum idmap_error_code idmap_index_reserve(struct sss_idmap_ctx *ctx)
+{
+    enum idmap_error_code err;
+
+    err = sid_table_reserve(ctx);
+    if (err != IDMAP_SUCCESS) {
+        return err;
+    }
+
+    return range_table_reserve(ctx, &ctx->dom_ranges, 1);
+}
+
+/* Adds a domain which was just put at the head of the domain list,
+ * idmap_index_reserve() must have been called before. Newer domains get
+ * a higher rank since the domain list is searched from the head. */
+static void idmap_index_add(struct sss_idmap_ctx *ctx,
+                            struct idmap_domain_info *dom)
+{
+    dom->seq = ++ctx->dom_seq;
+
+    range_table_add(&ctx->dom_ranges, &dom->range_params, dom, dom->seq);
+
+    if (dom->sid != NULL) {
+        sid_table_add(ctx, dom);
+    }
+}
+
+/* Adds the secondary slices owned by dom. Slices of newer domains come
+ * first and the slices of one domain in their list order. */
+static enum idmap_error_code idmap_index_helpers(struct sss_idmap_ctx *ctx,
+                                                 struct idmap_domain_info *dom)
+{
+    struct idmap_range_params *it;
+    enum idmap_error_code err;
+    uint32_t num = 0;
+
+    for (it = dom->helpers; it != NULL; it = it->next) {
+        num++;
+    }
+
+    err = range_table_reserve(ctx, &ctx->helper_ranges, num);
+    if (err != IDMAP_SUCCESS) {
+        return err;
+    }
+
+    num = 0;
+    for (it = dom->helpers; it != NULL; it = it->next) {
+        range_table_add(&ctx->helper_ranges, it, dom,
+                        ((uint64_t)dom->seq << 32) | (UINT32_MAX - num));
+        num++;
+    }
+
+    return IDMAP_SUCCESS;
 }
 
 const char *idmap_error_string(enum idmap_error_code err)
@@ -291,13 +595,15 @@ static void free_helpers(struct sss_idmap_ctx *ctx,
     }
 }
 
+/* Secondary slices are named after the domain SID and their first RID, so
+ * the first RID is sufficient to find them. */
 static struct idmap_range_params*
-get_helper_by_id(struct idmap_range_params *helpers, const char *id)
+get_helper_by_rid(struct idmap_range_params *helpers, uint32_t first_rid)
 {
     struct idmap_range_params *it;
 
     for (it = helpers; it != NULL; it = it->next) {
-        if (strcmp(it->range_id, id) == 0) {
+        if (it->first_rid == first_rid) {
             return it;
         }
     }
@@ -335,6 +641,16 @@ enum idmap_error_code sss_idmap_free(struct sss_idmap_ctx *ctx)
         sss_idmap_free_domain(ctx, dom);
     }
 
+    if (ctx->sid_table != NULL) {
+        ctx->free_func(ctx->sid_table, ctx->alloc_pvt);
+    }
+    if (ctx->dom_ranges.entries != NULL) {
+        ctx->free_func(ctx->dom_ranges.entries, ctx->alloc_pvt);
+    }
+    if (ctx->helper_ranges.entries != NULL) {
+        ctx->free_func(ctx->helper_ranges.entries, ctx->alloc_pvt);
+    }
+
     ctx->free_func(ctx, ctx->alloc_pvt);
 
     return IDMAP_SUCCESS;
@@ -793,8 +1109,14 @@ enum idmap_error_code sss_idmap_add_domain_ex(struct sss_idmap_ctx *ctx,
         goto fail;
     }
 
+    err = idmap_index_reserve(ctx);
+    if (err != IDMAP_SUCCESS) {
+        goto fail;
+    }
+
     dom->next = ctx->idmap_domain_info;
     ctx->idmap_domain_info = dom;
+    idmap_index_add(ctx, dom);
 
     return IDMAP_SUCCESS;
 
@@ -847,6 +1169,14 @@ sss_idmap_add_auto_domain_ex(struct sss_idmap_ctx *ctx,
     rid += ctx->idmap_opts.rangesize;
     err = get_helpers(ctx, domain_sid, rid,
                       &ctx->idmap_domain_info->helpers);
+    if (err == IDMAP_SUCCESS) {
+        err = idmap_index_helpers(ctx, ctx->idmap_domain_info);
+        if (err != IDMAP_SUCCESS) {
+            free_helpers(ctx, ctx->idmap_domain_info->helpers, true);
+            ctx->idmap_domain_info->helpers = NULL;
+        }
+    }
+
     if (err == IDMAP_SUCCESS) {
         ctx->idmap_domain_info->auto_add_ranges = true;
         ctx->idmap_domain_info->helpers_owner = true;
@@ -899,25 +1229,6 @@ static bool parse_rid(const char *sid, size_t dom_prefix_len, long long *_rid)
     return true;
 }
 
-static bool is_sid_from_dom(const char *dom_sid, const char *sid,
-                            size_t *_dom_sid_len)
-{
-    size_t dom_sid_len;
-
-    if (dom_sid == NULL) {
-        return false;
-    }
-
-    dom_sid_len = strlen(dom_sid);
-    *_dom_sid_len = dom_sid_len;
-
-    if (strlen(sid) < dom_sid_len || sid[dom_sid_len] != '-') {
-        return false;
-    }
-
-    return strncmp(sid, dom_sid, dom_sid_len) == 0;
-}
-
 static bool comp_id(struct idmap_range_params *range_params, long long rid,
                     uint32_t *_id)
 {
@@ -935,41 +1246,47 @@ static bool comp_id(struct idmap_range_params *range_params, long long rid,
     return false;
 }
 
+/* Returns the predeclared secondary slice for the RID if there is one,
+ * otherwise a newly generated slice which has to be freed by the caller,
+ * *_generated is set accordingly. */
 static enum idmap_error_code
 get_range(struct sss_idmap_ctx *ctx,
           struct idmap_range_params *helpers,
           const char *dom_sid,
           long long rid,
-          struct idmap_range_params **_range)
+          struct idmap_range_params **_range,
+          bool *_generated)
 {
     char *secondary_name = NULL;
     enum idmap_error_code err;
-    int first_rid;
+    uint32_t first_rid;
     struct idmap_range_params *range;
     struct idmap_range_params *helper;
 
     first_rid = (rid / ctx->idmap_opts.rangesize) * ctx->idmap_opts.rangesize;
 
+    helper = get_helper_by_rid(helpers, first_rid);
+    if (helper != NULL) {
+        /* Utilize helper's range. */
+        *_range = helper;
+        *_generated = false;
+        return IDMAP_SUCCESS;
+    }
+
     secondary_name = generate_sec_slice_name(ctx, dom_sid, first_rid);
     if (secondary_name == NULL) {
         err = IDMAP_OUT_OF_MEMORY;
         goto error;
     }
 
-    helper = get_helper_by_id(helpers, secondary_name);
-    if (helper != NULL) {
-        /* Utilize helper's range. */
-        err = construct_range(ctx, helper, secondary_name, &range);
-    } else {
-        /* Have to generate a whole new range. */
-        err = generate_slice(ctx, secondary_name, first_rid, &range);
-    }
-
+    /* Have to generate a whole new range. */
+    err = generate_slice(ctx, secondary_name, first_rid, &range);
     if (err != IDMAP_SUCCESS) {
         goto error;
     }
 
     *_range = range;
+    *_generated = true;
     return IDMAP_SUCCESS;
 
 error:
@@ -1047,13 +1364,15 @@ add_dom_for_sid(struct sss_idmap_ctx *ctx,
     enum idmap_error_code err;
     long long rid;
     struct idmap_range_params *range = NULL;
+    bool generated = false;
 
     if (parse_rid(sid, strlen(matched_dom->sid), &rid) == false) {
         err = IDMAP_SID_INVALID;
         goto done;
     }
 
-    err = get_range(ctx, matched_dom->helpers, matched_dom->sid, rid, &range);
+    err = get_range(ctx, matched_dom->helpers, matched_dom->sid, rid, &range,
+                    &generated);
     if (err != IDMAP_SUCCESS) {
         goto done;
     }
@@ -1071,10 +1390,10 @@ add_dom_for_sid(struct sss_idmap_ctx *ctx,
     err =  IDMAP_SUCCESS;
 
 done:
-    if (range != NULL) {
+    if (generated) {
         ctx->free_func(range->range_id, ctx->alloc_pvt);
+        ctx->free_func(range, ctx->alloc_pvt);
     }
-    ctx->free_func(range, ctx->alloc_pvt);
     return err;
 }
 
@@ -1086,6 +1405,7 @@ enum idmap_error_code sss_idmap_sid_to_unix(struct sss_idmap_ctx *ctx,
     struct idmap_domain_info *matched_dom = NULL;
     size_t dom_len;
     long long rid;
+    bool by_sid;
 
     if (sid == NULL || _id == NULL) {
         return IDMAP_ERROR;
@@ -1093,33 +1413,34 @@ enum idmap_error_code sss_idmap_sid_to_unix(struct sss_idmap_ctx *ctx,
 
     CHECK_IDMAP_CTX(ctx, IDMAP_CONTEXT_INVALID);
 
-    idmap_domain_info = ctx->idmap_domain_info;
-
     if (sss_idmap_sid_is_builtin(sid)) {
         return IDMAP_BUILTIN_SID;
     }
 
     /* Try primary slices */
-    while (idmap_domain_info != NULL) {
-
-        if (is_sid_from_dom(idmap_domain_info->sid, sid, &dom_len)) {
-
-            if (idmap_domain_info->external_mapping == true) {
-                return IDMAP_EXTERNAL;
-            }
+    for (idmap_domain_info = sid_domains(ctx, sid, &by_sid);
+         idmap_domain_info != NULL;
+         idmap_domain_info = next_sid_domain(idmap_domain_info, by_sid)) {
+
+        if (by_sid) {
+            dom_len = idmap_domain_info->sid_len;
+        } else if (!is_sid_from_dom(idmap_domain_info->sid, sid, &dom_len)) {
+            continue;
+        }
 
-            if (parse_rid(sid, dom_len, &rid) == false) {
-                return IDMAP_SID_INVALID;
-            }
+        if (idmap_domain_info->external_mapping == true) {
+            return IDMAP_EXTERNAL;
+        }
 
-            if (comp_id(&idmap_domain_info->range_params, rid, _id)) {
-                return IDMAP_SUCCESS;
-            }
+        if (parse_rid(sid, dom_len, &rid) == false) {
+            return IDMAP_SID_INVALID;
+        }
 
-            matched_dom = idmap_domain_info;
+        if (comp_id(&idmap_domain_info->range_params, rid, _id)) {
+            return IDMAP_SUCCESS;
         }
 
-        idmap_domain_info = idmap_domain_info->next;
+        matched_dom = idmap_domain_info;
     }
 
     if (matched_dom != NULL && matched_dom->auto_add_ranges) {
@@ -1136,6 +1457,7 @@ enum idmap_error_code sss_idmap_check_sid_unix(struct sss_idmap_ctx *ctx,
     struct idmap_domain_info *idmap_domain_info;
     size_t dom_len;
     bool no_range = false;
+    bool by_sid;
 
     if (sid == NULL) {
         return IDMAP_ERROR;
@@ -1147,28 +1469,25 @@ enum idmap_error_code sss_idmap_check_sid_unix(struct sss_idmap_ctx *ctx,
         return IDMAP_NO_DOMAIN;
     }
 
-    idmap_domain_info = ctx->idmap_domain_info;
-
     if (sss_idmap_sid_is_builtin(sid)) {
         return IDMAP_BUILTIN_SID;
     }
 
-    while (idmap_domain_info != NULL) {
-        if (idmap_domain_info->sid != NULL) {
-            dom_len = strlen(idmap_domain_info->sid);
-            if (strlen(sid) > dom_len && sid[dom_len] == '-'
-                    && strncmp(sid, idmap_domain_info->sid, dom_len) == 0) {
+    for (idmap_domain_info = sid_domains(ctx, sid, &by_sid);
+         idmap_domain_info != NULL;
+         idmap_domain_info = next_sid_domain(idmap_domain_info, by_sid)) {
 
-                if (id >= idmap_domain_info->range_params.min_id
-                    && id <= idmap_domain_info->range_params.max_id) {
-                    return IDMAP_SUCCESS;
-                }
+        if (!by_sid
+                && !is_sid_from_dom(idmap_domain_info->sid, sid, &dom_len)) {
+            continue;
+        }
 
-                no_range = true;
-            }
+        if (id >= idmap_domain_info->range_params.min_id
+            && id <= idmap_domain_info->range_params.max_id) {
+            return IDMAP_SUCCESS;
         }
 
-        idmap_domain_info = idmap_domain_info->next;
+        no_range = true;
     }
 
     return no_range ? IDMAP_NO_RANGE : IDMAP_SID_UNKNOWN;
@@ -1208,57 +1527,43 @@ enum idmap_error_code sss_idmap_unix_to_sid(struct sss_idmap_ctx *ctx,
                                             char **_sid)
 {
     struct idmap_domain_info *idmap_domain_info;
+    struct idmap_range_entry *entry;
+    struct idmap_range_params *helper;
     uint32_t rid;
     enum idmap_error_code err;
 
     CHECK_IDMAP_CTX(ctx, IDMAP_CONTEXT_INVALID);
 
-    idmap_domain_info = ctx->idmap_domain_info;
-
-    while (idmap_domain_info != NULL) {
-        if (id_is_in_range(id, &idmap_domain_info->range_params, &rid)) {
-
-            if (idmap_domain_info->external_mapping == true
-                    || idmap_domain_info->sid == NULL) {
-                return IDMAP_EXTERNAL;
-            }
+    entry = range_table_find(&ctx->dom_ranges, id);
+    if (entry != NULL && id_is_in_range(id, entry->range, &rid)) {
+        idmap_domain_info = entry->dom;
 
-            return generate_sid(ctx, idmap_domain_info->sid, rid, _sid);
+        if (idmap_domain_info->external_mapping == true
+                || idmap_domain_info->sid == NULL) {
+            return IDMAP_EXTERNAL;
         }
 
-        idmap_domain_info = idmap_domain_info->next;
+        return generate_sid(ctx, idmap_domain_info->sid, rid, _sid);
     }
 
-    /* Check secondary ranges. */
-    idmap_domain_info = ctx->idmap_domain_info;
-    while (idmap_domain_info != NULL) {
-
-        for (struct idmap_range_params *it = idmap_domain_info->helpers;
-             it != NULL;
-             it = it->next) {
+    /* Check secondary ranges, only the owners of the helpers are indexed. */
+    entry = range_table_find(&ctx->helper_ranges, id);
+    if (entry != NULL && id_is_in_range(id, entry->range, &rid)) {
+        /* spawn_dom() may reallocate the tables */
+        idmap_domain_info = entry->dom;
+        helper = entry->range;
 
-            if (idmap_domain_info->helpers_owner == false) {
-                /* Checking helpers on owner is sufficient. */
-                continue;
-            }
-
-            if (id_is_in_range(id, it, &rid)) {
-
-                if (idmap_domain_info->external_mapping == true
-                    || idmap_domain_info->sid == NULL) {
-                    return IDMAP_EXTERNAL;
-                }
-
-                err = spawn_dom(ctx, idmap_domain_info, it);
-                if (err != IDMAP_SUCCESS) {
-                    return err;
-                }
+        if (idmap_domain_info->external_mapping == true
+            || idmap_domain_info->sid == NULL) {
+            return IDMAP_EXTERNAL;
+        }
 
-                return generate_sid(ctx, idmap_domain_info->sid, rid, _sid);
-            }
+        err = spawn_dom(ctx, idmap_domain_info, helper);
+        if (err != IDMAP_SUCCESS) {
+            return err;
         }
 
-        idmap_domain_info = idmap_domain_info->next;
+        return generate_sid(ctx, idmap_domain_info->sid, rid, _sid);
     }
 
     return IDMAP_NO_DOMAIN;
@@ -54,12 +54,44 @@ struct sss_idmap_opts {
     int extra_slice_init;
 };
 
+/* One ID range of a domain in a range table. */
+struct idmap_range_entry {
+    uint32_t min_id;
+    uint32_t max_id;
+
+    /* highest max_id of this and all preceding entries */
+    uint32_t max_end;
+
+    /* if ranges overlap, the entry with the highest rank wins */
+    uint64_t rank;
+
+    struct idmap_range_params *range;
+    struct idmap_domain_info *dom;
+};
+
+/* ID ranges sorted by min_id. */
+struct idmap_range_table {
+    struct idmap_range_entry *entries;
+    size_t count;
+    size_t size;
+};
+
 struct sss_idmap_ctx {
     idmap_alloc_func *alloc_func;
     void *alloc_pvt;
     idmap_free_func *free_func;
     struct sss_idmap_opts idmap_opts;
     struct idmap_domain_info *idmap_domain_info;
+
+    /* Lookup indexes over idmap_domain_info. Domains are hashed by their
+     * SID and the ranges of all domains and of the secondary slices which
+     * were not used yet are kept in sorted tables. */
+    struct idmap_domain_info **sid_table;
+    size_t sid_table_size;
+    size_t sid_count;
+    uint32_t dom_seq;
+    struct idmap_range_table dom_ranges;
+    struct idmap_range_table helper_ranges;
 };
 
 /* This is a copy of the definition in the samba gen_ndr/security.h header
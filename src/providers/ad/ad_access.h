@@ -49,6 +49,10 @@ struct ad_access_ctx {
     } gpo_map_type;
     hash_table_t *gpo_map_options_table;
     enum gpo_map_type gpo_default_right;
+    /* cached access decisions, NULL if disabled */
+    int gpo_decision_timeout;
+    hash_table_t *gpo_decision_table;
+    char *gpo_fingerprint;
 };
 
 struct tevent_req *
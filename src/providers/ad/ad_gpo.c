@@ -65,6 +65,8 @@
 #define AD_AT_MACHINE_EXT_NAMES "gPCMachineExtensionNames"
 #define AD_AT_FUNC_VERSION "gPCFunctionalityVersion"
 #define AD_AT_FLAGS "flags"
+#define AD_AT_VERSION_NUMBER "versionNumber"
+#define AD_AT_WHEN_CHANGED "whenChanged"
 
 #define UAC_WORKSTATION_TRUST_ACCOUNT 0x00001000
 #define UAC_SERVER_TRUST_ACCOUNT 0x00002000
@@ -130,6 +132,8 @@ struct gp_gpo {
     int num_gpo_cse_guids;
     int gpo_func_version;
     int gpo_flags;
+    int gpo_version;
+    const char *gpo_when_changed;
     bool send_to_child;
     const char *policy_filename;
 };
@@ -1585,6 +1589,231 @@ ad_gpo_perform_hbac_processing(TALLOC_CTX *mem_ctx,
 
 /* == ad_gpo_access_send/recv implementation ================================*/
 
+/* == GPO access decision cache ============================================ */
+
+/*
+ * Access decisions of full online evaluations are kept in memory, keyed by
+ * the logon right, the host and the user's SIDs, so repeated logins of the
+ * same user skip the LDAP and SMB round-trips. A decision is dropped after
+ * ad_gpo_decision_cache_timeout seconds or as soon as any evaluation sees
+ * a different set of GPOs, or GPOs with a different versionNumber or
+ * whenChanged, than the one the decision was made with.
+ */
+
+#define AD_GPO_DECISION_MAX_ENTRIES 4096
+
+struct ad_gpo_decision {
+    time_t expire;
+    errno_t result;
+    const char *fingerprint;
+};
+
+static int
+ad_gpo_sid_cmp(const void *a, const void *b)
+{
+    return strcmp(*(const char * const *) a, *(const char * const *) b);
+}
+
+static char *
+ad_gpo_decision_key(TALLOC_CTX *mem_ctx,
+                    enum gpo_map_type gpo_map_type,
+                    const char *host,
+                    const char *user_sid,
+                    const char **group_sids,
+                    int group_size)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char **sorted;
+    char *key = NULL;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return NULL;
+    }
+
+    /* the order of the groups does not matter */
+    sorted = talloc_array(tmp_ctx, const char *, group_size);
+    if (sorted == NULL) {
+        goto done;
+    }
+    for (i = 0; i < group_size; i++) {
+        sorted[i] = group_sids[i];
+    }
+    qsort(sorted, group_size, sizeof(const char *), ad_gpo_sid_cmp);
+
+    key = talloc_asprintf(tmp_ctx, "%d:%s:%s", gpo_map_type,
+                          host != NULL ? host : "",
+                          user_sid != NULL ? user_sid : "");
+    for (i = 0; key != NULL && i < group_size; i++) {
+        key = talloc_asprintf_append(key, ",%s", sorted[i]);
+    }
+
+    key = talloc_steal(mem_ctx, key);
+
+done:
+    talloc_free(tmp_ctx);
+    return key;
+}
+
+/* Identifies the GPOs that apply to the host and their versions */
+static char *
+ad_gpo_fingerprint(TALLOC_CTX *mem_ctx,
+                   struct gp_gpo **gpos,
+                   int num_gpos)
+{
+    char *fingerprint;
+    int i;
+
+    fingerprint = talloc_strdup(mem_ctx, "");
+    for (i = 0; fingerprint != NULL && i < num_gpos; i++) {
+        fingerprint = talloc_asprintf_append(fingerprint, "%s:%d:%s;",
+                              gpos[i]->gpo_guid != NULL ? gpos[i]->gpo_guid
+                                                        : gpos[i]->gpo_dn,
+                              gpos[i]->gpo_version,
+                              gpos[i]->gpo_when_changed != NULL ?
+                                        gpos[i]->gpo_when_changed : "");
+    }
+
+    return fingerprint;
+}
+
+static void
+ad_gpo_decision_reset(struct ad_access_ctx *ctx)
+{
+    errno_t ret;
+
+    if (ctx->gpo_decision_table == NULL) {
+        return;
+    }
+
+    /* the decisions are allocated on the table */
+    talloc_zfree(ctx->gpo_decision_table);
+    ret = sss_hash_create(ctx, 0, &ctx->gpo_decision_table);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to recreate the GPO decision "
+              "cache, it is disabled now [%d]: %s\n", ret, sss_strerror(ret));
+    }
+}
+
+/* Called with the fingerprint of every online evaluation, all decisions
+ * made with other GPOs are forgotten */
+static errno_t
+ad_gpo_decision_set_fingerprint(struct ad_access_ctx *ctx,
+                                const char *fingerprint)
+{
+    char *copy;
+
+    if (ctx->gpo_fingerprint != NULL
+            && strcmp(ctx->gpo_fingerprint, fingerprint) == 0) {
+        return EOK;
+    }
+
+    copy = talloc_strdup(ctx, fingerprint);
+    if (copy == NULL) {
+        return ENOMEM;
+    }
+
+    if (ctx->gpo_fingerprint != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "GPOs have changed, dropping cached access decisions\n");
+        ad_gpo_decision_reset(ctx);
+    }
+
+    talloc_free(ctx->gpo_fingerprint);
+    ctx->gpo_fingerprint = copy;
+
+    return EOK;
+}
+
+static bool
+ad_gpo_decision_lookup(struct ad_access_ctx *ctx,
+                       const char *key,
+                       errno_t *_result)
+{
+    struct ad_gpo_decision *decision;
+    hash_key_t hkey;
+    hash_value_t value;
+    int hret;
+
+    if (ctx->gpo_decision_table == NULL || ctx->gpo_fingerprint == NULL) {
+        return false;
+    }
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+
+    hret = hash_lookup(ctx->gpo_decision_table, &hkey, &value);
+    if (hret != HASH_SUCCESS) {
+        return false;
+    }
+
+    decision = talloc_get_type(value.ptr, struct ad_gpo_decision);
+    if (decision->expire <= time(NULL)
+            || strcmp(decision->fingerprint, ctx->gpo_fingerprint) != 0) {
+        hash_delete(ctx->gpo_decision_table, &hkey);
+        talloc_free(decision);
+        return false;
+    }
+
+    *_result = decision->result;
+    return true;
+}
+
+static void
+ad_gpo_decision_store(struct ad_access_ctx *ctx,
+                      const char *key,
+                      const char *fingerprint,
+                      errno_t result)
+{
+    struct ad_gpo_decision *decision;
+    hash_key_t hkey;
+    hash_value_t value;
+    int hret;
+
+    if (ctx->gpo_decision_table == NULL) {
+        return;
+    }
+
+    if (hash_count(ctx->gpo_decision_table) >= AD_GPO_DECISION_MAX_ENTRIES) {
+        ad_gpo_decision_reset(ctx);
+        if (ctx->gpo_decision_table == NULL) {
+            return;
+        }
+    }
+
+    decision = talloc_zero(ctx->gpo_decision_table, struct ad_gpo_decision);
+    if (decision == NULL) {
+        return;
+    }
+
+    decision->expire = time(NULL) + ctx->gpo_decision_timeout;
+    decision->result = result;
+    decision->fingerprint = talloc_strdup(decision, fingerprint);
+    if (decision->fingerprint == NULL) {
+        talloc_free(decision);
+        return;
+    }
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+
+    hret = hash_lookup(ctx->gpo_decision_table, &hkey, &value);
+    if (hret == HASH_SUCCESS) {
+        hash_delete(ctx->gpo_decision_table, &hkey);
+        talloc_free(value.ptr);
+    }
+
+    value.type = HASH_VALUE_PTR;
+    value.ptr = decision;
+    hret = hash_enter(ctx->gpo_decision_table, &hkey, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache GPO decision: %s\n",
+              hash_error_string(hret));
+        talloc_free(decision);
+    }
+}
+
 struct ad_gpo_access_state {
     struct tevent_context *ev;
     struct ldb_context *ldb_ctx;
@@ -1608,8 +1837,27 @@ struct ad_gpo_access_state {
     struct gp_gpo **cse_filtered_gpos;
     int num_cse_filtered_gpos;
     int cse_gpo_index;
+    /* where to cache the decision, NULL if it is not cached */
+    char *decision_key;
+    const char *fingerprint;
 };
 
+/* Remember the outcome of a full online evaluation */
+static void
+ad_gpo_access_cache_result(struct ad_gpo_access_state *state, errno_t ret)
+{
+    if (state->decision_key == NULL || state->fingerprint == NULL) {
+        return;
+    }
+
+    if (ret != EOK && ret != ERR_ACCESS_DENIED) {
+        return;
+    }
+
+    ad_gpo_decision_store(state->access_ctx, state->decision_key,
+                          state->fingerprint, ret);
+}
+
 static void ad_gpo_connect_done(struct tevent_req *subreq);
 static void ad_gpo_target_dn_retrieval_done(struct tevent_req *subreq);
 static void ad_gpo_process_som_done(struct tevent_req *subreq);
@@ -1634,6 +1882,9 @@ ad_gpo_access_send(TALLOC_CTX *mem_ctx,
     hash_key_t key;
     hash_value_t val;
     enum gpo_map_type gpo_map_type;
+    const char *user_sid;
+    const char **group_sids;
+    int group_size;
 
     /* setup logging for gpo child */
     gpo_child_init();
@@ -1722,6 +1973,29 @@ ad_gpo_access_send(TALLOC_CTX *mem_ctx,
     state->access_ctx = ctx;
     state->opts = ctx->sdap_access_ctx->id_ctx->opts;
     state->timeout = dp_opt_get_int(state->opts->basic, SDAP_SEARCH_TIMEOUT);
+
+    if (ctx->gpo_decision_table != NULL) {
+        ret = ad_gpo_get_sids(state, user, state->user_domain,
+                              &user_sid, &group_sids, &group_size);
+        if (ret == EOK) {
+            state->decision_key = ad_gpo_decision_key(state, gpo_map_type,
+                                                      state->ad_hostname,
+                                                      user_sid, group_sids,
+                                                      group_size);
+        } else {
+            DEBUG(SSSDBG_TRACE_FUNC, "Unable to get SIDs of %s, the access "
+                  "decision is not cached [%d]: %s\n",
+                  user, ret, sss_strerror(ret));
+        }
+
+        if (state->decision_key != NULL
+                && ad_gpo_decision_lookup(ctx, state->decision_key, &ret)) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Using cached GPO access decision for "
+                  "%s: [%d]: %s\n", user, ret, sss_strerror(ret));
+            goto immediately;
+        }
+    }
+
     state->conn = ad_get_dom_ldap_conn(ctx->ad_id_ctx, state->host_domain);
     state->sdap_op = sdap_id_op_create(state, state->conn->conn_cache);
     if (state->sdap_op == NULL) {
@@ -2118,7 +2392,22 @@ ad_gpo_process_gpo_done(struct tevent_req *subreq)
               "Unable to get GPO list: [%d](%s)\n",
               ret, sss_strerror(ret));
         goto done;
-    } else if (ret == ENOENT) {
+    }
+
+    if (state->access_ctx->gpo_decision_table != NULL) {
+        /* the GPOs (and their versions) the decision is based on */
+        state->fingerprint = ad_gpo_fingerprint(state, candidate_gpos,
+                                                ret == EOK ? num_candidate_gpos
+                                                           : 0);
+        if (state->fingerprint == NULL
+                || ad_gpo_decision_set_fingerprint(state->access_ctx,
+                                                   state->fingerprint) != EOK) {
+            /* not fatal, the decision is just not cached */
+            state->fingerprint = NULL;
+        }
+    }
+
+    if (ret == ENOENT) {
         DEBUG(SSSDBG_TRACE_FUNC,
               "No GPOs found that apply to this system.\n");
         /*
@@ -2263,6 +2552,8 @@ ad_gpo_process_gpo_done(struct tevent_req *subreq)
 
  done:
 
+    ad_gpo_access_cache_result(state, ret);
+
     if (ret == EOK) {
         tevent_req_done(req);
     } else if (ret != EAGAIN) {
@@ -2441,6 +2732,8 @@ ad_gpo_cse_done(struct tevent_req *subreq)
 
  done:
 
+    ad_gpo_access_cache_result(state, ret);
+
     if (ret == EOK) {
         tevent_req_done(req);
     } else if (ret != EAGAIN) {
@@ -3931,6 +4224,7 @@ ad_gpo_sd_process_attrs(struct tevent_req *req,
     int ret;
     struct ldb_message_element *el = NULL;
     const char *gpo_guid = NULL;
+    const char *when_changed = NULL;
     const char *raw_file_sys_path = NULL;
     char *file_sys_path = NULL;
     uint8_t *raw_machine_ext_names = NULL;
@@ -3959,6 +4253,31 @@ ad_gpo_sd_process_attrs(struct tevent_req *req,
     DEBUG(SSSDBG_TRACE_ALL, "populating attrs for gpo_guid: %s\n",
           gp_gpo->gpo_guid);
 
+    /* retrieve AD_AT_VERSION_NUMBER and AD_AT_WHEN_CHANGED; both are
+     * optional and only used to notice that the GPO was changed */
+    ret = sysdb_attrs_get_int32_t(result, AD_AT_VERSION_NUMBER,
+                                  &gp_gpo->gpo_version);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "sysdb_attrs_get_int32_t failed: [%d](%s)\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = sysdb_attrs_get_string(result, AD_AT_WHEN_CHANGED, &when_changed);
+    if (ret == EOK) {
+        gp_gpo->gpo_when_changed = talloc_strdup(gp_gpo, when_changed);
+        if (gp_gpo->gpo_when_changed == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    } else if (ret != ENOENT) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "sysdb_attrs_get_string failed: [%d](%s)\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
     /* retrieve AD_AT_FILE_SYS_PATH */
     ret = sysdb_attrs_get_string(result,
                                  AD_AT_FILE_SYS_PATH,
@@ -32,6 +32,8 @@
                       AD_AT_MACHINE_EXT_NAMES, \
                       AD_AT_FUNC_VERSION, \
                       AD_AT_FLAGS, \
+                      AD_AT_VERSION_NUMBER, \
+                      AD_AT_WHEN_CHANGED, \
                       NULL}
 
 /*
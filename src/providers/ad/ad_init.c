@@ -289,6 +289,19 @@ static errno_t ad_init_gpo(struct ad_access_ctx *access_ctx)
     gpo_cache_timeout = dp_opt_get_int(options, AD_GPO_CACHE_TIMEOUT);
     access_ctx->gpo_cache_timeout = gpo_cache_timeout;
 
+    /* GPO access decision cache */
+    access_ctx->gpo_decision_timeout = dp_opt_get_int(options,
+                                              AD_GPO_DECISION_CACHE_TIMEOUT);
+    if (access_ctx->gpo_decision_timeout > 0) {
+        ret = sss_hash_create(access_ctx, 0,
+                              &access_ctx->gpo_decision_table);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Could not create GPO decision "
+                  "hash table [%d]: %s\n", ret, sss_strerror(ret));
+            return ret;
+        }
+    }
+
     /* GPO logon maps */
     ret = sss_hash_create(access_ctx, 10, &access_ctx->gpo_map_options_table);
     if (ret != EOK) {
@@ -41,6 +41,7 @@ struct dp_option ad_basic_opts[] = {
     { "ad_gpo_implicit_deny", DP_OPT_BOOL, BOOL_FALSE, BOOL_FALSE },
     { "ad_gpo_ignore_unreadable", DP_OPT_BOOL, BOOL_FALSE, BOOL_FALSE },
     { "ad_gpo_cache_timeout", DP_OPT_NUMBER, { .number = 5 }, NULL_NUMBER },
+    { "ad_gpo_decision_cache_timeout", DP_OPT_NUMBER, { .number = 30 }, NULL_NUMBER },
     { "ad_gpo_map_interactive", DP_OPT_STRING, NULL_STRING, NULL_STRING },
     { "ad_gpo_map_remote_interactive", DP_OPT_STRING, NULL_STRING, NULL_STRING },
     { "ad_gpo_map_network", DP_OPT_STRING, NULL_STRING, NULL_STRING },
@@ -151,6 +152,10 @@ struct dp_option ad_def_ldap_opts[] = {
     { "ldap_max_id", DP_OPT_NUMBER, NULL_NUMBER, NULL_NUMBER},
     { "ldap_pwdlockout_dn", DP_OPT_STRING, NULL_STRING, NULL_STRING },
     { "wildcard_limit", DP_OPT_NUMBER, { .number = 1000 }, NULL_NUMBER},
+    { "ldap_connection_pool_size", DP_OPT_NUMBER, { .number = 1 }, NULL_NUMBER },
+    { "ldap_nested_group_batch_size", DP_OPT_NUMBER, { .number = 50 }, NULL_NUMBER },
+    { "ldap_change_stream", DP_OPT_STRING, { "none" }, NULL_STRING },
+    { "ldap_change_stream_interval", DP_OPT_NUMBER, { .number = 60 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
@@ -176,6 +181,8 @@ struct dp_option ad_def_krb5_opts[] = {
     { "krb5_use_kdcinfo", DP_OPT_BOOL, BOOL_TRUE, BOOL_TRUE },
     { "krb5_kdcinfo_lookahead", DP_OPT_STRING, NULL_STRING, NULL_STRING },
     { "krb5_map_user", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "krb5_child_pool_size", DP_OPT_NUMBER, { .number = 0 }, NULL_NUMBER },
+    { "krb5_child_pool_max_requests", DP_OPT_NUMBER, { .number = 100 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
@@ -266,6 +266,8 @@ enum dp_res_opts {
     DP_RES_OPT_RESOLVER_TIMEOUT,
     DP_RES_OPT_RESOLVER_OP_TIMEOUT,
     DP_RES_OPT_DNS_DOMAIN,
+    DP_RES_OPT_PROBE_TIMEOUT,
+    DP_RES_OPT_CACHE_MAX_TTL,
 
     DP_RES_OPTS /* attrs counter */
 };
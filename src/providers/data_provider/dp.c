@@ -165,6 +165,13 @@ dp_init_send(TALLOC_CTX *mem_ctx,
     state->provider->gid = gid;
     state->provider->be_ctx = be_ctx;
 
+    state->provider->requests.pending = sss_ptr_hash_create(state->provider,
+                                                            NULL, NULL);
+    if (state->provider->requests.pending == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     state->sbus_name = sss_iface_domain_bus(state, be_ctx->domain);
     if (state->sbus_name == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Could not get sbus backend name.\n");
@@ -179,6 +186,13 @@ dp_init_send(TALLOC_CTX *mem_ctx,
      */
     talloc_set_destructor(state->provider, dp_destructor);
 
+    /* Responders fall back to D-Bus if the frame server is missing. */
+    ret = dp_init_frame_server(state->provider, sbus_address);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to initialize frame transport "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+
     subreq = sbus_server_create_and_connect_send(state->provider, ev,
                                                  state->sbus_name,
                                                  NULL, sbus_address, true, 1000,
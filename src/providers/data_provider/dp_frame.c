@@ -0,0 +1,190 @@
+/*
+    SSSD
+
+    Data Provider frame transport
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+
+#include "confdb/confdb.h"
+#include "providers/backend.h"
+#include "providers/data_provider/dp_private.h"
+#include "providers/data_provider/dp_iface.h"
+#include "sbus/frame/sbus_frame.h"
+#include "sss_iface/sbus_sss_arguments.h"
+#include "util/util.h"
+
+struct dp_frame_get_account_info_state {
+    uint16_t dp_error;
+    uint32_t error;
+    const char *err_msg;
+};
+
+static void dp_frame_get_account_info_done(struct tevent_req *subreq);
+
+/* Frame variant of sssd.dataprovider.getAccountInfo, it takes and returns
+ * the same arguments as the D-Bus method. */
+static struct tevent_req *
+dp_frame_get_account_info_send(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               struct sbus_frame_reader *in,
+                               void *data)
+{
+    struct dp_frame_get_account_info_state *state;
+    struct _sbus_sss_invoker_args_uusss args;
+    struct data_provider *provider;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct dp_frame_get_account_info_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    provider = talloc_get_type(data, struct data_provider);
+
+    ret = _sbus_sss_invoker_frame_read_uusss(state, in, &args);
+    if (ret == EOK && !sbus_frame_reader_done(in)) {
+        ret = EINVAL;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Invalid getAccountInfo arguments "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* There is no D-Bus request behind this call. */
+    subreq = dp_get_account_info_send(state, ev, NULL, provider,
+                                      args.arg0, args.arg1, args.arg2,
+                                      args.arg3, args.arg4);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, dp_frame_get_account_info_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void dp_frame_get_account_info_done(struct tevent_req *subreq)
+{
+    struct dp_frame_get_account_info_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct dp_frame_get_account_info_state);
+
+    ret = dp_get_account_info_recv(state, subreq, &state->dp_error,
+                                   &state->error, &state->err_msg);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t
+dp_frame_get_account_info_recv(TALLOC_CTX *mem_ctx,
+                               struct tevent_req *req,
+                               struct sbus_frame_writer *out)
+{
+    struct dp_frame_get_account_info_state *state;
+    struct _sbus_sss_invoker_args_qus args;
+    state = tevent_req_data(req, struct dp_frame_get_account_info_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    args.arg0 = state->dp_error;
+    args.arg1 = state->error;
+    args.arg2 = state->err_msg;
+
+    return _sbus_sss_invoker_frame_write_qus(out, &args);
+}
+
+errno_t dp_init_frame_server(struct data_provider *provider,
+                             const char *sbus_address)
+{
+    struct sbus_frame_method *methods;
+    struct be_ctx *be_ctx = provider->be_ctx;
+    char *socket_path;
+    bool enabled;
+    errno_t ret;
+
+    ret = confdb_get_bool(be_ctx->cdb, be_ctx->conf_path,
+                          CONFDB_DOMAIN_FRAME_TRANSPORT, false, &enabled);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (!enabled) {
+        return EOK;
+    }
+
+    /* Terminated by the zeroed entry. */
+    methods = talloc_zero_array(provider, struct sbus_frame_method, 2);
+    if (methods == NULL) {
+        return ENOMEM;
+    }
+
+    methods[0].iface = "sssd.dataprovider";
+    methods[0].method = "getAccountInfo";
+    methods[0].send_fn = dp_frame_get_account_info_send;
+    methods[0].recv_fn = dp_frame_get_account_info_recv;
+    methods[0].data = provider;
+
+    socket_path = sbus_frame_socket_path(methods, sbus_address);
+    if (socket_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sbus_frame_server_create(provider, provider->ev, socket_path,
+                                   provider->uid, provider->gid, methods,
+                                   &provider->frame_server);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(methods);
+    }
+
+    return ret;
+}
@@ -26,6 +26,7 @@
 
 #include "providers/data_provider/dp.h"
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 
 #define DP_REQ_DEBUG(level, name, fmt, ...) \
     DEBUG(level, "DP Request [%s]: " fmt "\n", (name ?: "Unknown"), ##__VA_ARGS__)
@@ -44,6 +45,7 @@ enum dp_clients {
 
 struct dp_req;
 struct dp_client;
+struct sbus_frame_server;
 
 struct dp_module {
     bool initialized;
@@ -80,6 +82,7 @@ struct data_provider {
     struct tevent_context *ev;
     struct sbus_server *sbus_server;
     struct sbus_connection *sbus_conn;
+    struct sbus_frame_server *frame_server;
     struct dp_client *clients[DP_CLIENT_SENTINEL];
     bool terminating;
 
@@ -90,6 +93,11 @@ struct data_provider {
         /* List of all ongoing requests. */
         uint32_t num_active;
         struct dp_req *active;
+
+        /* Ongoing requests that identical requests can join, indexed by
+         * their coalescing key. */
+        hash_table_t *pending;
+        uint32_t num_coalesced;
     } requests;
 
     struct dp_module **modules;
@@ -132,4 +140,9 @@ struct data_provider *dp_client_provider(struct dp_client *dp_cli);
 struct be_ctx *dp_client_be(struct dp_client *dp_cli);
 struct sbus_connection *dp_client_conn(struct dp_client *dp_cli);
 
+/* Frame transport. */
+
+errno_t dp_init_frame_server(struct data_provider *provider,
+                             const char *sbus_address);
+
 #endif /* _DP_PRIVATE_H_ */
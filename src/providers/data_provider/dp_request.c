@@ -23,11 +23,14 @@
 #include <dbus/dbus.h>
 
 #include "providers/data_provider/dp_private.h"
+#include "providers/data_provider/dp_custom_data.h"
 #include "providers/backend.h"
 #include "util/dlinklist.h"
 #include "util/util.h"
 #include "util/probes.h"
 
+struct dp_req_state;
+
 struct dp_req {
     struct data_provider *provider;
     uint32_t dp_flags;
@@ -40,9 +43,18 @@ struct dp_req {
     const char *name;
     uint32_t num;
 
-    struct tevent_req *req;
     struct tevent_req *handler_req;
     void *request_data;
+    void *output_data;
+
+    /* Callers waiting for the result. The first one files the request,
+     * the others are identical requests that were coalesced into it.
+     * The dp_req is always owned by one of the waiters. */
+    struct dp_req_state *waiters;
+    uint32_t num_waiters;
+
+    /* Set while identical requests can still join this one. */
+    const char *key;
 
     /* Active request list. */
     struct dp_req *prev;
@@ -136,7 +148,6 @@ dp_req_new(TALLOC_CTX *mem_ctx,
            enum dp_methods method,
            uint32_t dp_flags,
            void *request_data,
-           struct tevent_req *req,
            struct dp_req **_dp_req)
 {
     struct dp_req *dp_req;
@@ -156,7 +167,6 @@ dp_req_new(TALLOC_CTX *mem_ctx,
     dp_req->target = target;
     dp_req->method = method;
     dp_req->request_data = request_data;
-    dp_req->req = req;
 
     ret = dp_attach_req(dp_req, provider, name, dp_flags);
     if (ret != EOK) {
@@ -196,7 +206,6 @@ file_dp_request(TALLOC_CTX *mem_ctx,
                 enum dp_methods method,
                 uint32_t dp_flags,
                 void *request_data,
-                struct tevent_req *req,
                 struct dp_req **_dp_req)
 {
     struct dp_req_params *dp_params;
@@ -208,7 +217,7 @@ file_dp_request(TALLOC_CTX *mem_ctx,
     be_ctx = provider->be_ctx;
 
     ret = dp_req_new(mem_ctx, provider, domainname, name, target,
-                     method, dp_flags, request_data, req, &dp_req);
+                     method, dp_flags, request_data, &dp_req);
     if (ret != EOK) {
         *_dp_req = dp_req;
         goto done;
@@ -246,6 +255,15 @@ file_dp_request(TALLOC_CTX *mem_ctx,
     dp_params->target = dp_req->target;
     dp_params->method = dp_req->method;
 
+    dp_req->output_data = talloc_zero_size(dp_req,
+                                           dp_req->execute->output_size);
+    if (dp_req->output_data == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    talloc_set_name_const(dp_req->output_data, dp_req->execute->output_dtype);
+
     send_fn = dp_req->execute->send_fn;
     dp_req->handler_req = send_fn(dp_req, dp_req->execute->method_data,
                                   dp_req->request_data, dp_params);
@@ -263,11 +281,84 @@ done:
 }
 
 struct dp_req_state {
+    struct tevent_req *req;
     struct dp_req *dp_req;
-    dp_req_recv_fn recv_fn;
     void *output_data;
+
+    struct dp_req_state *prev;
+    struct dp_req_state *next;
 };
 
+static int dp_req_state_destructor(struct dp_req_state *state)
+{
+    struct dp_req *dp_req = state->dp_req;
+
+    if (dp_req == NULL) {
+        return 0;
+    }
+
+    DLIST_REMOVE(dp_req->waiters, state);
+    dp_req->num_waiters--;
+
+    /* Coalesced requests are still waiting for the result, hand the dp
+     * request over to one of them so the handler keeps running. */
+    if (dp_req->waiters != NULL && talloc_parent(dp_req) == state) {
+        talloc_steal(dp_req->waiters, dp_req);
+    }
+
+    return 0;
+}
+
+static void dp_req_add_waiter(struct dp_req *dp_req,
+                              struct dp_req_state *state)
+{
+    state->dp_req = dp_req;
+    DLIST_ADD_END(dp_req->waiters, state, struct dp_req_state *);
+    dp_req->num_waiters++;
+
+    talloc_set_destructor(state, dp_req_state_destructor);
+}
+
+/* Only account requests answered with dp_reply_std are coalesced. Their
+ * result depends only on the values in the key and the reply is simple
+ * to hand out to all callers. */
+static const char *
+dp_req_coalesce_key(TALLOC_CTX *mem_ctx,
+                    struct data_provider *provider,
+                    const char *domain,
+                    enum dp_targets target,
+                    enum dp_methods method,
+                    uint32_t dp_flags,
+                    void *request_data)
+{
+    struct dp_id_data *data;
+    struct dp_method *execute;
+    errno_t ret;
+
+    if (provider->requests.pending == NULL) {
+        return NULL;
+    }
+
+    data = talloc_get_type(request_data, struct dp_id_data);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    ret = dp_find_method(provider, target, method, &execute);
+    if (ret != EOK || execute->output_dtype == NULL
+            || strcmp(execute->output_dtype, "struct dp_reply_std") != 0) {
+        return NULL;
+    }
+
+    return talloc_asprintf(mem_ctx, "%d:%d:%s:%#x:%#x:%#x:%s:%s",
+                           target, method, domain == NULL ? "" : domain,
+                           dp_flags, data->entry_type, data->filter_type,
+                           data->filter_value == NULL ? ""
+                                                      : data->filter_value,
+                           data->extra_value == NULL ? ""
+                                                     : data->extra_value);
+}
+
 static void dp_req_done(struct tevent_req *subreq);
 
 struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
@@ -284,6 +375,7 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
     const char *request_name;
     struct tevent_req *req;
     struct dp_req *dp_req;
+    const char *key;
     errno_t ret;
 
     req = tevent_req_create(mem_ctx, &state, struct dp_req_state);
@@ -292,8 +384,43 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->req = req;
+
+    key = dp_req_coalesce_key(state, provider, domain, target, method,
+                              dp_flags, request_data);
+    dp_req = NULL;
+    if (key != NULL) {
+        dp_req = sss_ptr_hash_lookup(provider->requests.pending, key,
+                                     struct dp_req);
+    }
+
+    if (dp_req != NULL) {
+        /* An identical request is already running, wait for its result
+         * instead of running the handler again. */
+        if (_request_name != NULL) {
+            request_name = talloc_strdup(mem_ctx, dp_req->name);
+            if (request_name == NULL) {
+                *_request_name = "Request Not Yet Created";
+                ret = ENOMEM;
+                goto immediately;
+            }
+            *_request_name = request_name;
+        }
+
+        talloc_steal(state, request_data);
+        dp_req_add_waiter(dp_req, state);
+        provider->requests.num_coalesced++;
+
+        DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, dp_req->name,
+                     "Coalesced identical request [%s], %u callers are "
+                     "waiting. Coalesced requests in total: %u", name,
+                     dp_req->num_waiters, provider->requests.num_coalesced);
+
+        return req;
+    }
+
     ret = file_dp_request(state, provider, domain, name, target,
-                          method, dp_flags, request_data, req, &dp_req);
+                          method, dp_flags, request_data, &dp_req);
 
     if (dp_req == NULL) {
         /* An error occurred before request could be created. */
@@ -305,7 +432,7 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
     }
 
     PROBE(DP_REQ_SEND, domain, dp_req->name, target, method);
-    state->dp_req = dp_req;
+    dp_req_add_waiter(dp_req, state);
     if (_request_name != NULL) {
         request_name = talloc_strdup(mem_ctx, dp_req->name);
         if (request_name == NULL) {
@@ -320,16 +447,20 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
         goto immediately;
     }
 
-    state->recv_fn = dp_req->execute->recv_fn;
-    state->output_data = talloc_zero_size(state, dp_req->execute->output_size);
-    if (state->output_data == NULL) {
-        ret = ENOMEM;
-        goto immediately;
+    if (key != NULL) {
+        ret = sss_ptr_hash_add(provider->requests.pending, key, dp_req,
+                               struct dp_req);
+        if (ret == EOK) {
+            dp_req->key = talloc_steal(dp_req, key);
+        } else {
+            /* Identical requests will just run on their own. */
+            DP_REQ_DEBUG(SSSDBG_MINOR_FAILURE, dp_req->name,
+                         "Unable to register request for coalescing "
+                         "[%d]: %s", ret, sss_strerror(ret));
+        }
     }
 
-    talloc_set_name_const(state->output_data, dp_req->execute->output_dtype);
-
-    tevent_req_set_callback(dp_req->handler_req, dp_req_done, req);
+    tevent_req_set_callback(dp_req->handler_req, dp_req_done, dp_req);
 
     return req;
 
@@ -344,33 +475,116 @@ immediately:
     return req;
 }
 
-static void dp_req_done(struct tevent_req *subreq)
+static void dp_req_unregister(struct dp_req *dp_req)
+{
+    if (dp_req->key == NULL) {
+        return;
+    }
+
+    sss_ptr_hash_delete(dp_req->provider->requests.pending, dp_req->key,
+                        false);
+    talloc_zfree(dp_req->key);
+}
+
+static errno_t dp_req_share_output(struct dp_req *dp_req,
+                                   struct dp_req_state *state)
+{
+    struct dp_reply_std *reply;
+    struct dp_reply_std *copy;
+
+    if (dp_req->num_waiters == 1) {
+        state->output_data = talloc_steal(state, dp_req->output_data);
+        return EOK;
+    }
+
+    /* Only requests answered with dp_reply_std are coalesced. */
+    reply = talloc_get_type(dp_req->output_data, struct dp_reply_std);
+    if (reply == NULL) {
+        return ERR_INVALID_DATA_TYPE;
+    }
+
+    copy = talloc_zero(state, struct dp_reply_std);
+    if (copy == NULL) {
+        return ENOMEM;
+    }
+
+    copy->dp_error = reply->dp_error;
+    copy->error = reply->error;
+    if (reply->message != NULL) {
+        copy->message = talloc_strdup(copy, reply->message);
+        if (copy->message == NULL) {
+            talloc_free(copy);
+            return ENOMEM;
+        }
+    }
+
+    state->output_data = copy;
+
+    return EOK;
+}
+
+static void dp_req_notify(struct dp_req *dp_req, errno_t ret)
 {
     struct dp_req_state *state;
-    struct tevent_req *req;
+    struct dp_req_state *next;
+    errno_t share_ret;
+    bool defer;
+
+    /* The first callback may free the dp request together with its
+     * caller, so callbacks of coalesced requests are deferred. */
+    defer = dp_req->num_waiters > 1;
+    if (defer) {
+        DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, dp_req->name,
+                     "Sharing result with %u coalesced requests.",
+                     dp_req->num_waiters - 1);
+    }
+
+    for (state = dp_req->waiters; state != NULL; state = next) {
+        next = state->next;
+
+        if (defer) {
+            tevent_req_defer_callback(state->req, dp_req->provider->ev);
+        }
+
+        if (ret != EOK) {
+            tevent_req_error(state->req, ret);
+            continue;
+        }
+
+        share_ret = dp_req_share_output(dp_req, state);
+        if (share_ret != EOK) {
+            tevent_req_error(state->req, share_ret);
+            continue;
+        }
+
+        tevent_req_done(state->req);
+    }
+}
+
+static void dp_req_done(struct tevent_req *subreq)
+{
+    struct dp_req *dp_req;
     errno_t ret;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct dp_req_state);
+    dp_req = tevent_req_callback_data(subreq, struct dp_req);
 
-    ret = state->recv_fn(state->output_data, subreq, state->output_data);
+    ret = dp_req->execute->recv_fn(dp_req->output_data, subreq,
+                                   dp_req->output_data);
 
     /* subreq is the same as dp_req->handler_req */
     talloc_zfree(subreq);
-    state->dp_req->handler_req = NULL;
+    dp_req->handler_req = NULL;
 
-    PROBE(DP_REQ_DONE, state->dp_req->name, state->dp_req->target,
-          state->dp_req->method, ret, sss_strerror(ret));
+    /* New requests must not join a request that has already finished. */
+    dp_req_unregister(dp_req);
 
-    DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->dp_req->name,
-                 "Request handler finished [%d]: %s", ret, sss_strerror(ret));
+    PROBE(DP_REQ_DONE, dp_req->name, dp_req->target,
+          dp_req->method, ret, sss_strerror(ret));
 
-    if (ret != EOK) {
-        tevent_req_error(req, ret);
-        return;
-    }
+    DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, dp_req->name,
+                 "Request handler finished [%d]: %s", ret, sss_strerror(ret));
 
-    tevent_req_done(req);
+    dp_req_notify(dp_req, ret);
 }
 
 errno_t _dp_req_recv(TALLOC_CTX *mem_ctx,
@@ -416,7 +630,8 @@ static void dp_terminate_request(struct dp_req *dp_req)
     DP_REQ_DEBUG(SSSDBG_TRACE_ALL, dp_req->name, "Terminating.");
 
     talloc_zfree(dp_req->handler_req);
-    tevent_req_error(dp_req->req, ERR_TERMINATED);
+    dp_req_unregister(dp_req);
+    dp_req_notify(dp_req, ERR_TERMINATED);
 }
 
 static void dp_terminate_request_list(struct data_provider *provider,
@@ -30,9 +30,11 @@
 
 #define FILTER_TYPE(str, type) {str "=", sizeof(str "=") - 1, type}
 
-static bool check_and_parse_filter(struct dp_id_data *data,
-                                   const char *filter,
-                                   const char *extra)
+/* The values are copied into @data. Coalesced requests share @data, so it
+ * can outlive the caller and the message it came in. */
+static errno_t check_and_parse_filter(struct dp_id_data *data,
+                                      const char *filter,
+                                      const char *extra)
 {
     /* We will use sizeof() to determine the length of a string so we don't
      * call strlen over and over again with each request. Not a bottleneck,
@@ -47,18 +49,34 @@ static bool check_and_parse_filter(struct dp_id_data *data,
                  FILTER_TYPE(DP_CERT, BE_FILTER_CERT),
                  FILTER_TYPE(DP_WILDCARD, BE_FILTER_WILDCARD),
                  {0, 0, 0}};
+    const char *value;
     int i;
 
     if (SBUS_REQ_STRING_IS_EMPTY(filter)) {
-        return false;
+        return EINVAL;
     }
 
     for (i = 0; types[i].name != NULL; i++) {
         if (strncmp(filter, types[i].name, types[i].lenght) == 0) {
             data->filter_type = types[i].type;
-            data->filter_value = SBUS_REQ_STRING(&filter[types[i].lenght]);
-            data->extra_value = SBUS_REQ_STRING(extra);
-            return true;
+
+            value = SBUS_REQ_STRING(&filter[types[i].lenght]);
+            if (value != NULL) {
+                data->filter_value = talloc_strdup(data, value);
+                if (data->filter_value == NULL) {
+                    return ENOMEM;
+                }
+            }
+
+            value = SBUS_REQ_STRING(extra);
+            if (value != NULL) {
+                data->extra_value = talloc_strdup(data, value);
+                if (data->extra_value == NULL) {
+                    return ENOMEM;
+                }
+            }
+
+            return EOK;
         }
     }
 
@@ -66,10 +84,10 @@ static bool check_and_parse_filter(struct dp_id_data *data,
         data->filter_type = BE_FILTER_ENUM;
         data->filter_value = NULL;
         data->extra_value = NULL;
-        return true;
+        return EOK;
     }
 
-    return false;
+    return EINVAL;
 }
 
 struct dp_initgr_ctx {
@@ -108,8 +126,15 @@ dp_create_initgroups_ctx(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
-    ctx->domain = data->domain;
-    ctx->filter_value = data->filter_value;
+    /* data belongs to the dp request which may be gone by the time the
+     * initgroups post-processing runs. */
+    ctx->domain = talloc_strdup(ctx, data->domain);
+    ctx->filter_value = talloc_strdup(ctx, data->filter_value);
+    if ((data->domain != NULL && ctx->domain == NULL)
+            || (data->filter_value != NULL && ctx->filter_value == NULL)) {
+        ret = ENOMEM;
+        goto done;
+    }
     ctx->domain_info = domain;
 
     ret = sysdb_initgroups(ctx, domain, data->filter_value, &res);
@@ -502,10 +527,17 @@ dp_get_account_info_send(TALLOC_CTX *mem_ctx,
     state->request_name = "Account";
     state->initgroups = false;
     state->data->entry_type = entry_type;
-    state->data->domain = domain;
 
-    if (!check_and_parse_filter(state->data, filter, extra)) {
-        ret = EINVAL;
+    if (domain != NULL) {
+        state->data->domain = talloc_strdup(state->data, domain);
+        if (state->data->domain == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    ret = check_and_parse_filter(state->data, filter, extra);
+    if (ret != EOK) {
         goto done;
     }
 
@@ -49,6 +49,8 @@ static int be_fo_get_options(struct be_ctx *ctx,
     opts->retry_timeout = 30;
     opts->srv_retry_neg_timeout = 15;
     opts->family_order = ctx->be_res->family_order;
+    opts->probe_timeout = dp_opt_get_int(ctx->be_res->opts,
+                                         DP_RES_OPT_PROBE_TIMEOUT);
 
     return EOK;
 }
@@ -834,6 +836,8 @@ static struct dp_option dp_res_default_opts[] = {
     { "dns_resolver_timeout", DP_OPT_NUMBER, { .number = 6 }, NULL_NUMBER },
     { "dns_resolver_op_timeout", DP_OPT_NUMBER, { .number = 6 }, NULL_NUMBER },
     { "dns_discovery_domain", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "failover_probe_timeout", DP_OPT_NUMBER, { .number = 0 }, NULL_NUMBER },
+    { "dns_resolver_cache_max_ttl", DP_OPT_NUMBER, { .number = 300 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
@@ -874,6 +878,7 @@ static errno_t be_res_get_opts(struct be_resolv_ctx *res_ctx,
 
 errno_t be_res_init(struct be_ctx *ctx)
 {
+    int cache_max_ttl;
     errno_t ret;
 
     if (ctx->be_res != NULL) {
@@ -900,5 +905,20 @@ errno_t be_res_init(struct be_ctx *ctx)
         return ret;
     }
 
+    cache_max_ttl = dp_opt_get_int(ctx->be_res->opts,
+                                   DP_RES_OPT_CACHE_MAX_TTL);
+    if (cache_max_ttl < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Negative value for option %s, "
+              "disabling the DNS cache\n",
+              dp_res_default_opts[DP_RES_OPT_CACHE_MAX_TTL].opt_name);
+        cache_max_ttl = 0;
+    }
+
+    ret = resolv_set_cache(ctx->be_res->resolv, cache_max_ttl);
+    if (ret != EOK) {
+        /* not fatal, every lookup goes to the DNS server */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to set up the DNS cache\n");
+    }
+
     return EOK;
 }
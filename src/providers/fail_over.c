@@ -29,10 +29,12 @@
 #include <stdbool.h>
 #include <strings.h>
 #include <talloc.h>
+#include <unistd.h>
 
 #include "util/dlinklist.h"
 #include "util/refcount.h"
 #include "util/util.h"
+#include "util/sss_sockets.h"
 #include "providers/fail_over.h"
 #include "resolv/async_resolv.h"
 
@@ -43,6 +45,9 @@
 #define DEFAULT_SERVER_STATUS SERVER_NAME_NOT_RESOLVED
 #define DEFAULT_SRV_STATUS SRV_NEUTRAL
 
+/* how many servers are probed at once at most */
+#define FO_PROBE_MAX_SERVERS 8
+
 enum srv_lookup_status {
     SRV_NEUTRAL,        /* We didn't try this SRV lookup yet */
     SRV_RESOLVED,       /* This SRV lookup is resolved       */
@@ -93,6 +98,11 @@ struct fo_server {
     struct timeval last_status_change;
     struct server_common *common;
 
+    /* SRV priority, 0 for servers that were not discovered */
+    unsigned short priority;
+    /* connect time measured by the last probe in ms, -1 if unknown */
+    int rtt;
+
     TALLOC_CTX *fo_internal_owner;
 };
 
@@ -159,6 +169,7 @@ fo_context_init(TALLOC_CTX *mem_ctx, struct fo_options *opts)
     ctx->opts->retry_timeout = opts->retry_timeout;
     ctx->opts->family_order  = opts->family_order;
     ctx->opts->service_resolv_timeout = opts->service_resolv_timeout;
+    ctx->opts->probe_timeout = opts->probe_timeout;
 
     DEBUG(SSSDBG_TRACE_FUNC,
           "Created new fail over context, retry timeout is %ld\n",
@@ -576,6 +587,8 @@ fo_server_alloc(struct fo_service *service, int port,
     server->service = service;
     server->port_status = DEFAULT_PORT_STATUS;
     server->primary = primary;
+    server->priority = 0;
+    server->rtt = -1;
 
     return server;
 }
@@ -817,6 +830,7 @@ static errno_t fo_add_server_list(struct fo_service *service,
         }
 
         server->srv_data = srv_data;
+        server->priority = servers[i].priority;
 
         ret = fo_add_server_to_list(&srv_list, service->server_list,
                                     server, service->name);
@@ -869,6 +883,53 @@ void fo_ref_server(TALLOC_CTX *ref_ctx,
     }
 }
 
+/* Servers that are interchangeable with server: the same SRV lookup and
+ * priority, or the same primary/backup list for configured servers */
+static bool
+fo_is_peer_server(struct fo_server *server, struct fo_server *other)
+{
+    if (other->common == NULL || other->port <= 0) {
+        return false;
+    }
+
+    if (other == server) {
+        return true;
+    }
+
+    return other->primary == server->primary
+            && other->priority == server->priority
+            && other->srv_data == server->srv_data
+            && !fo_is_srv_lookup(other)
+            && service_works(other);
+}
+
+/* Of server and its peers, return the one with the shortest connect time
+ * measured by a probe. server is returned if no peer was measured. */
+static struct fo_server *
+fo_fastest_peer_server(struct fo_server *server)
+{
+    struct fo_server *fastest = server;
+    struct fo_server *other;
+
+    DLIST_FOR_EACH(other, server->service->server_list) {
+        if (other->rtt < 0 || !fo_is_peer_server(server, other)) {
+            continue;
+        }
+
+        if (fastest->rtt < 0 || other->rtt < fastest->rtt) {
+            fastest = other;
+        }
+    }
+
+    if (fastest != server) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Preferring '%s:%d' (%d ms) over '%s:%d'\n",
+              SERVER_NAME(fastest), fastest->port, fastest->rtt,
+              SERVER_NAME(server), server->port);
+    }
+
+    return fastest;
+}
+
 static int
 get_first_server_entity(struct fo_service *service, struct fo_server **_server)
 {
@@ -895,7 +956,7 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
         if (service->last_tried_server->port_status == PORT_NEUTRAL &&
             server_works(service->last_tried_server)) {
             server = service->last_tried_server;
-            goto done;
+            goto found;
         }
 
         DLIST_FOR_EACH(server, service->last_tried_server->next) {
@@ -903,7 +964,7 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
             if (!server->primary) continue;
 
             if (service_works(server)) {
-                goto done;
+                goto found;
             }
         }
     }
@@ -914,7 +975,7 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
         if (!server->primary) continue;
 
         if (service_works(server)) {
-            goto done;
+            goto found;
         }
         if (server == service->last_tried_server) {
             break;
@@ -926,13 +987,18 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
         if (server->primary) continue;
 
         if (service_works(server)) {
-            goto done;
+            goto found;
         }
     }
 
     service->last_tried_server = NULL;
     return ENOENT;
 
+found:
+    /* Servers of the same priority are equal, use the one that answered
+     * the last probes fastest */
+    server = fo_fastest_peer_server(server);
+
 done:
     service->last_tried_server = server;
     *_server = server;
@@ -1002,10 +1068,11 @@ resolve_srv_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 static int
 resolve_srv_recv(struct tevent_req *req, struct fo_server **server);
 
-struct tevent_req *
-fo_resolve_service_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
-                        struct resolv_ctx *resolv, struct fo_ctx *ctx,
-                        struct fo_service *service)
+/* Pick the next server of the service and resolve its name */
+static struct tevent_req *
+fo_select_server_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                      struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                      struct fo_service *service)
 {
     int ret;
     struct fo_server *server;
@@ -1128,34 +1195,38 @@ fo_resolve_service_cont(struct tevent_req *subreq)
     fo_resolve_service_server(req);
 }
 
+/* Finish req once the name of server is resolved. Returns true if req
+ * was finished right away. */
 static bool
-fo_resolve_service_server(struct tevent_req *req)
+fo_resolve_server_name(struct tevent_req *req,
+                       struct tevent_context *ev,
+                       struct resolv_ctx *resolv,
+                       struct fo_ctx *fo_ctx,
+                       struct fo_server *server)
 {
-    struct resolve_service_state *state = tevent_req_data(req,
-                                        struct resolve_service_state);
     struct tevent_req *subreq;
     int ret;
 
-    switch (get_server_status(state->server)) {
+    switch (get_server_status(server)) {
     case SERVER_NAME_NOT_RESOLVED: /* Request name resolution. */
-        subreq = resolv_gethostbyname_send(state->server->common,
-                                           state->ev, state->resolv,
-                                           state->server->common->name,
-                                           state->fo_ctx->opts->family_order,
+        subreq = resolv_gethostbyname_send(server->common,
+                                           ev, resolv,
+                                           server->common->name,
+                                           fo_ctx->opts->family_order,
                                            default_host_dbs);
         if (subreq == NULL) {
             tevent_req_error(req, ENOMEM);
             return true;
         }
         tevent_req_set_callback(subreq, fo_resolve_service_done,
-                                state->server->common);
-        fo_set_server_status(state->server, SERVER_RESOLVING_NAME);
+                                server->common);
+        fo_set_server_status(server, SERVER_RESOLVING_NAME);
         /* FALLTHROUGH */
         SSS_ATTRIBUTE_FALLTHROUGH;
     case SERVER_RESOLVING_NAME:
         /* Name resolution is already under way. Just add ourselves into the
          * waiting queue so we get notified after the operation is finished. */
-        ret = set_lookup_hook(state->ev, state->server, req);
+        ret = set_lookup_hook(ev, server, req);
         if (ret != EOK) {
             tevent_req_error(req, ret);
             return true;
@@ -1169,6 +1240,16 @@ fo_resolve_service_server(struct tevent_req *req)
     return false;
 }
 
+static bool
+fo_resolve_service_server(struct tevent_req *req)
+{
+    struct resolve_service_state *state = tevent_req_data(req,
+                                        struct resolve_service_state);
+
+    return fo_resolve_server_name(req, state->ev, state->resolv,
+                                  state->fo_ctx, state->server);
+}
+
 static void
 fo_resolve_service_done(struct tevent_req *subreq)
 {
@@ -1222,14 +1303,421 @@ fo_resolve_service_done(struct tevent_req *subreq)
     }
 }
 
+static int
+fo_select_server_recv(struct tevent_req *req,
+                      TALLOC_CTX *ref_ctx,
+                      struct fo_server **server)
+{
+    struct resolve_service_state *state;
+
+    state = tevent_req_data(req, struct resolve_service_state);
+
+    /* always return the server if asked for, otherwise the caller
+     * cannot mark it as faulty in case we return an error */
+    if (server != NULL) {
+        fo_ref_server(ref_ctx, state->server);
+        *server = state->server;
+    }
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+/*******************************************************************
+ * Probe servers of the same priority concurrently.                *
+ *******************************************************************/
+
+struct fo_server_name_state {
+    struct fo_server *server;
+};
+
+/* Wait for the name of server to be resolved, joining a lookup that is
+ * already in progress */
+static struct tevent_req *
+fo_server_name_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                    struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                    struct fo_server *server)
+{
+    struct fo_server_name_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct fo_server_name_state);
+    if (req == NULL) {
+        return NULL;
+    }
+    state->server = server;
+
+    if (fo_resolve_server_name(req, ev, resolv, ctx, server)) {
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static int
+fo_server_name_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct fo_probe_server_state {
+    struct tevent_context *ev;
+    struct fo_ctx *fo_ctx;
+    struct fo_server *server;
+    struct timeval start;
+};
+
+static void fo_probe_server_resolved(struct tevent_req *subreq);
+static void fo_probe_server_connected(struct tevent_req *subreq);
+
+/* Measure how long it takes to open a TCP connection to server */
+static struct tevent_req *
+fo_probe_server_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                     struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                     struct fo_server *server)
+{
+    struct fo_probe_server_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+
+    req = tevent_req_create(mem_ctx, &state, struct fo_probe_server_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->fo_ctx = ctx;
+    /* the server list may be rebuilt by a SRV lookup in the meantime */
+    fo_ref_server(state, server);
+    state->server = server;
+
+    subreq = fo_server_name_send(state, ev, resolv, ctx, server);
+    if (subreq == NULL) {
+        talloc_free(req);
+        return NULL;
+    }
+    tevent_req_set_callback(subreq, fo_probe_server_resolved, req);
+
+    return req;
+}
+
+static void fo_probe_server_resolved(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_probe_server_state *state = tevent_req_data(req,
+                                            struct fo_probe_server_state);
+    struct resolv_hostent *hostent;
+    struct sockaddr_storage *addr;
+    int ret;
+
+    ret = fo_server_name_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    hostent = fo_get_server_hostent(state->server);
+    if (hostent == NULL) {
+        tevent_req_error(req, EINVAL);
+        return;
+    }
+
+    addr = resolv_get_sockaddr_address(state, hostent, state->server->port);
+    if (addr == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    state->start = tevent_timeval_current();
+    subreq = sssd_async_socket_init_send(state, state->ev, addr,
+                                         sizeof(struct sockaddr_storage),
+                                         state->fo_ctx->opts->probe_timeout);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, fo_probe_server_connected, req);
+}
+
+static void fo_probe_server_connected(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_probe_server_state *state = tevent_req_data(req,
+                                            struct fo_probe_server_state);
+    struct timeval now;
+    int64_t usec;
+    int ret;
+    int sd;
+
+    ret = sssd_async_socket_init_recv(subreq, &sd);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        /* do not prefer it in get_first_server_entity() any more */
+        state->server->rtt = -1;
+        tevent_req_error(req, ret);
+        return;
+    }
+    close(sd);
+
+    now = tevent_timeval_current();
+    usec = (now.tv_sec - state->start.tv_sec) * 1000000
+           + (now.tv_usec - state->start.tv_usec);
+    state->server->rtt = usec < 0 ? 0 : usec / 1000;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Server '%s:%d' answered in %d ms\n",
+          SERVER_NAME(state->server), state->server->port,
+          state->server->rtt);
+
+    tevent_req_done(req);
+}
+
+static int
+fo_probe_server_recv(struct tevent_req *req,
+                     TALLOC_CTX *ref_ctx,
+                     struct fo_server **_server)
+{
+    struct fo_probe_server_state *state = tevent_req_data(req,
+                                            struct fo_probe_server_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    fo_ref_server(ref_ctx, state->server);
+    *_server = state->server;
+
+    return EOK;
+}
+
+struct fo_probe_state {
+    struct fo_server *best;
+    size_t pending;
+};
+
+static void fo_probe_done(struct tevent_req *subreq);
+
+/* Probe server and its peers at the same time and return the one that
+ * accepted a connection first, NULL if none did */
+static struct tevent_req *
+fo_probe_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+              struct resolv_ctx *resolv, struct fo_ctx *ctx,
+              struct fo_server *server)
+{
+    struct fo_probe_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct fo_server *other;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct fo_probe_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    DLIST_FOR_EACH(other, server->service->server_list) {
+        if (state->pending >= FO_PROBE_MAX_SERVERS) {
+            break;
+        }
+
+        if (!fo_is_peer_server(server, other)) {
+            continue;
+        }
+
+        subreq = fo_probe_server_send(state, ev, resolv, ctx, other);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        tevent_req_set_callback(subreq, fo_probe_done, req);
+        state->pending++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Probing %zu servers of service '%s'\n",
+          state->pending, server->service->name);
+
+    ret = state->pending == 0 ? EOK : EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void fo_probe_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_probe_state *state = tevent_req_data(req,
+                                                   struct fo_probe_state);
+    struct fo_server *server = NULL;
+    int ret;
+
+    ret = fo_probe_server_recv(subreq, state, &server);
+    talloc_zfree(subreq);
+    state->pending--;
+
+    if (ret == EOK) {
+        /* the fastest one wins, the probes still running are cancelled
+         * when the request is freed */
+        state->best = server;
+        tevent_req_done(req);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Probe failed [%d]: %s\n",
+          ret, sss_strerror(ret));
+
+    if (state->pending == 0) {
+        tevent_req_done(req);
+    }
+}
+
+static int
+fo_probe_recv(struct tevent_req *req,
+              TALLOC_CTX *ref_ctx,
+              struct fo_server **_server)
+{
+    struct fo_probe_state *state = tevent_req_data(req,
+                                                   struct fo_probe_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (state->best != NULL) {
+        fo_ref_server(ref_ctx, state->best);
+    }
+    *_server = state->best;
+
+    return EOK;
+}
+
+/*******************************************************************
+ * Get server to connect to, probing its peers if enabled.         *
+ *******************************************************************/
+
+struct fo_resolve_service_state {
+    struct tevent_context *ev;
+    struct resolv_ctx *resolv;
+    struct fo_ctx *fo_ctx;
+    struct fo_service *service;
+
+    struct fo_server *server;
+};
+
+static void fo_resolve_service_selected(struct tevent_req *subreq);
+static void fo_resolve_service_probed(struct tevent_req *subreq);
+
+struct tevent_req *
+fo_resolve_service_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                        struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                        struct fo_service *service)
+{
+    struct fo_resolve_service_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+
+    req = tevent_req_create(mem_ctx, &state, struct fo_resolve_service_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->resolv = resolv;
+    state->fo_ctx = ctx;
+    state->service = service;
+
+    subreq = fo_select_server_send(state, ev, resolv, ctx, service);
+    if (subreq == NULL) {
+        talloc_free(req);
+        return NULL;
+    }
+    tevent_req_set_callback(subreq, fo_resolve_service_selected, req);
+
+    return req;
+}
+
+static void fo_resolve_service_selected(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_resolve_service_state *state = tevent_req_data(req,
+                                        struct fo_resolve_service_state);
+    int ret;
+
+    ret = fo_select_server_recv(subreq, state, &state->server);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    /* Probing only helps when a new server is about to be used */
+    if (state->fo_ctx->opts->probe_timeout <= 0
+            || state->server == state->service->active_server
+            || state->server->common == NULL
+            || state->server->port <= 0) {
+        tevent_req_done(req);
+        return;
+    }
+
+    subreq = fo_probe_send(state, state->ev, state->resolv,
+                           state->fo_ctx, state->server);
+    if (subreq == NULL) {
+        /* not fatal, go on with the selected server */
+        tevent_req_done(req);
+        return;
+    }
+    tevent_req_set_callback(subreq, fo_resolve_service_probed, req);
+}
+
+static void fo_resolve_service_probed(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_resolve_service_state *state = tevent_req_data(req,
+                                        struct fo_resolve_service_state);
+    struct fo_server *best = NULL;
+    int ret;
+
+    ret = fo_probe_recv(subreq, state, &best);
+    talloc_zfree(subreq);
+    if (ret != EOK || best == NULL) {
+        /* none answered, let the caller find out the usual way */
+        DEBUG(SSSDBG_TRACE_FUNC, "No server of service '%s' answered the "
+              "probe, using '%s'\n", state->service->name,
+              SERVER_NAME(state->server));
+        tevent_req_done(req);
+        return;
+    }
+
+    if (best != state->server) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Using '%s:%d' instead of '%s:%d', it "
+              "answered first\n", SERVER_NAME(best), best->port,
+              SERVER_NAME(state->server), state->server->port);
+        state->server = best;
+        state->service->last_tried_server = best;
+    }
+
+    tevent_req_done(req);
+}
+
 int
 fo_resolve_service_recv(struct tevent_req *req,
                         TALLOC_CTX *ref_ctx,
                         struct fo_server **server)
 {
-    struct resolve_service_state *state;
+    struct fo_resolve_service_state *state;
 
-    state = tevent_req_data(req, struct resolve_service_state);
+    state = tevent_req_data(req, struct fo_resolve_service_state);
 
     /* always return the server if asked for, otherwise the caller
      * cannot mark it as faulty in case we return an error */
@@ -76,12 +76,17 @@ struct fo_server;
  *
  * The family_order member specifies the order of address families to
  * try when looking up the service.
+ *
+ * The 'probe_timeout' member specifies how long, in seconds, to wait for a
+ * TCP connection when the servers of the same priority are probed before
+ * switching to a new one. Zero disables probing.
  */
 struct fo_options {
     time_t srv_retry_neg_timeout;
     time_t retry_timeout;
     int service_resolv_timeout;
     enum restrict_family family_order;
+    int probe_timeout;
 };
 
 /*
@@ -139,6 +144,9 @@ int fo_add_srv_server(struct fo_service *service,
  * Request the first server from the service's list of servers. It is only
  * considered if it is not marked as not working (or the retry interval already
  * passed). If the server address wasn't resolved yet, it will be done.
+ * When probing is enabled and a new server has to be picked, the working
+ * servers of the same priority are probed at once and the one that accepts
+ * a connection first is returned.
  */
 struct tevent_req *fo_resolve_service_send(TALLOC_CTX *mem_ctx,
                                            struct tevent_context *ev,
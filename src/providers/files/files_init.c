@@ -180,6 +180,15 @@ int sssm_files_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = confdb_get_bool(be_ctx->cdb, be_ctx->conf_path,
+                          CONFDB_FILES_INCREMENTAL_RELOAD, false,
+                          &ctx->incremental_reload);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to retrieve confdb "
+              "incremental reload setting!\n");
+        goto done;
+    }
+
     ctx->fctx = sf_init(ctx, be_ctx->ev,
                         ctx->passwd_files,
                         ctx->group_files,
@@ -281,64 +281,100 @@ done:
     return ret;
 }
 
-static errno_t save_file_user(struct files_id_ctx *id_ctx,
-                              struct passwd *pw)
+static bool sf_skip_user(struct passwd *pw)
 {
-    errno_t ret;
-    char *fqname;
-    TALLOC_CTX *tmp_ctx = NULL;
-    const char *shell;
-    const char *gecos;
-    struct sysdb_attrs *attrs = NULL;
-
-    if (strcmp(pw->pw_name, "root") == 0
+    return strcmp(pw->pw_name, "root") == 0
             || pw->pw_uid == 0
-            || pw->pw_gid == 0) {
-        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", pw->pw_name);
-        return EOK;
-    }
+            || pw->pw_gid == 0;
+}
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
+static bool sf_skip_group(struct group *grp)
+{
+    return strcmp(grp->gr_name, "root") == 0 || grp->gr_gid == 0;
+}
+
+/* Fill in the cache entry of a user, the entry is allocated on mem_ctx */
+static errno_t sf_user_entry(TALLOC_CTX *mem_ctx,
+                             struct files_id_ctx *id_ctx,
+                             struct passwd *pw,
+                             struct sysdb_store_user_entry *entry)
+{
+    char **remove_attrs;
+    int ri = 0;
+
+    memset(entry, 0, sizeof(*entry));
+
+    entry->name = sss_create_internal_fqname(mem_ctx, pw->pw_name,
+                                             id_ctx->domain->name);
+    if (entry->name == NULL) {
         return ENOMEM;
     }
 
-    fqname = sss_create_internal_fqname(tmp_ctx, pw->pw_name,
-                                        id_ctx->domain->name);
-    if (fqname == NULL) {
-        ret = ENOMEM;
-        goto done;
+    entry->attrs = sysdb_new_attrs(mem_ctx);
+    if (entry->attrs == NULL) {
+        return ENOMEM;
     }
 
-    attrs = sysdb_new_attrs(tmp_ctx);
-    if (attrs == NULL) {
-        ret = ENOMEM;
-        goto done;
+    remove_attrs = talloc_zero_array(mem_ctx, char *, 3);
+    if (remove_attrs == NULL) {
+        return ENOMEM;
     }
 
+    /* Attributes that are empty in the file are removed from an already
+     * cached user, this only matters if the entry was not deleted before */
     if (pw->pw_shell && pw->pw_shell[0] != '\0') {
-        shell = pw->pw_shell;
+        entry->shell = pw->pw_shell;
     } else {
-        shell = NULL;
+        remove_attrs[ri++] = discard_const(SYSDB_SHELL);
     }
 
     if (pw->pw_gecos && pw->pw_gecos[0] != '\0') {
-        gecos = pw->pw_gecos;
+        entry->gecos = pw->pw_gecos;
     } else {
-        gecos = NULL;
+        remove_attrs[ri++] = discard_const(SYSDB_GECOS);
+    }
+
+    entry->pwd = pw->pw_passwd;
+    entry->uid = pw->pw_uid;
+    entry->gid = pw->pw_gid;
+    entry->homedir = pw->pw_dir;
+    entry->remove_attrs = ri > 0 ? remove_attrs : NULL;
+
+    return EOK;
+}
+
+static errno_t save_file_user(struct files_id_ctx *id_ctx,
+                              struct passwd *pw)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx = NULL;
+    struct sysdb_store_user_entry entry;
+
+    if (sf_skip_user(pw)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", pw->pw_name);
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sf_user_entry(tmp_ctx, id_ctx, pw, &entry);
+    if (ret != EOK) {
+        goto done;
     }
 
-    /* FIXME - optimize later */
     ret = sysdb_store_user(id_ctx->domain,
-                           fqname,
-                           pw->pw_passwd,
-                           pw->pw_uid,
-                           pw->pw_gid,
-                           gecos,
-                           pw->pw_dir,
-                           shell,
-                           NULL, attrs,
-                           NULL, 0, 0);
+                           entry.name,
+                           entry.pwd,
+                           entry.uid,
+                           entry.gid,
+                           entry.gecos,
+                           entry.homedir,
+                           entry.shell,
+                           NULL, entry.attrs,
+                           entry.remove_attrs, 0, 0);
     if (ret != EOK) {
         goto done;
     }
@@ -459,6 +495,10 @@ errno_t sf_enum_users(struct files_id_ctx *id_ctx,
     errno_t ret;
     TALLOC_CTX *tmp_ctx = NULL;
     struct passwd **users = NULL;
+    struct sysdb_store_user_entry *entries;
+    size_t num_users;
+    size_t n = 0;
+    size_t failed;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -471,14 +511,41 @@ errno_t sf_enum_users(struct files_id_ctx *id_ctx,
         goto done;
     }
 
+    num_users = 0;
+    while (users[num_users] != NULL) {
+        num_users++;
+    }
+
+    entries = talloc_array(tmp_ctx, struct sysdb_store_user_entry,
+                           num_users);
+    if (entries == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     for (size_t i = 0; users[i]; i++) {
-        ret = save_file_user(id_ctx, users[i]);
+        if (sf_skip_user(users[i])) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", users[i]->pw_name);
+            continue;
+        }
+
+        ret = sf_user_entry(entries, id_ctx, users[i], &entries[n]);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "Cannot save user %s: [%d]: %s\n",
                   users[i]->pw_name, ret, sss_strerror(ret));
             continue;
         }
+        n++;
+    }
+
+    ret = sysdb_store_users(id_ctx->domain, entries, n, 0, 0, &failed);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot save users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    } else if (failed > 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "%zu users could not be saved\n", failed);
     }
 
     ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_USER);
@@ -561,58 +628,45 @@ done:
     return ret;
 }
 
-static errno_t save_file_group(struct files_id_ctx *id_ctx,
-                               struct group *grp,
-                               const char **cached_users)
+/* Fill in the cache entry of a group, members which are not cached users
+ * become ghosts. The entry is allocated on mem_ctx */
+static errno_t sf_group_entry(TALLOC_CTX *mem_ctx,
+                              struct files_id_ctx *id_ctx,
+                              struct group *grp,
+                              const char **cached_users,
+                              struct sysdb_store_group_entry *entry)
 {
     errno_t ret;
     char *fqname;
     struct sysdb_attrs *attrs = NULL;
-    TALLOC_CTX *tmp_ctx = NULL;
     char **fq_gr_files_mem;
     const char **fq_gr_mem;
     unsigned mi = 0;
 
-    if (strcmp(grp->gr_name, "root") == 0
-            || grp->gr_gid == 0) {
-        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", grp->gr_name);
-        return EOK;
-    }
-
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        return ENOMEM;
-    }
-
-    fqname = sss_create_internal_fqname(tmp_ctx, grp->gr_name,
+    fqname = sss_create_internal_fqname(mem_ctx, grp->gr_name,
                                         id_ctx->domain->name);
     if (fqname == NULL) {
-        ret = ENOMEM;
-        goto done;
-
+        return ENOMEM;
     }
 
-    attrs = sysdb_new_attrs(tmp_ctx);
+    attrs = sysdb_new_attrs(mem_ctx);
     if (attrs == NULL) {
-        ret = ENOMEM;
-        goto done;
+        return ENOMEM;
     }
 
     if (grp->gr_mem && grp->gr_mem[0]) {
         fq_gr_files_mem = sss_create_internal_fqname_list(
-                                            tmp_ctx,
+                                            attrs,
                                             (const char *const*) grp->gr_mem,
                                             id_ctx->domain->name);
         if (fq_gr_files_mem == NULL) {
-            ret = ENOMEM;
-            goto done;
+            return ENOMEM;
         }
 
-        fq_gr_mem = talloc_zero_array(tmp_ctx, const char *,
+        fq_gr_mem = talloc_zero_array(attrs, const char *,
                                       talloc_array_length(fq_gr_files_mem));
         if (fq_gr_mem == NULL) {
-            ret = ENOMEM;
-            goto done;
+            return ENOMEM;
         }
 
         for (unsigned i=0; fq_gr_files_mem[i] != NULL; i++) {
@@ -648,14 +702,44 @@ static errno_t save_file_group(struct files_id_ctx *id_ctx,
                     (const char *const *) fq_gr_mem);
             if (ret) {
                 DEBUG(SSSDBG_OP_FAILURE, "Could not add group members\n");
-                goto done;
+                return ret;
             }
         }
 
     }
 
-    ret = sysdb_store_group(id_ctx->domain, fqname, grp->gr_gid,
-                            attrs, 0, 0);
+    entry->name = fqname;
+    entry->gid = grp->gr_gid;
+    entry->attrs = attrs;
+
+    return EOK;
+}
+
+static errno_t save_file_group(struct files_id_ctx *id_ctx,
+                               struct group *grp,
+                               const char **cached_users)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx = NULL;
+    struct sysdb_store_group_entry entry;
+
+    if (sf_skip_group(grp)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", grp->gr_name);
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sf_group_entry(tmp_ctx, id_ctx, grp, cached_users, &entry);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_store_group(id_ctx->domain, entry.name, entry.gid,
+                            entry.attrs, 0, 0);
     if (ret) {
         DEBUG(SSSDBG_OP_FAILURE, "Could not add group to cache\n");
         goto done;
@@ -674,6 +758,10 @@ static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
     TALLOC_CTX *tmp_ctx = NULL;
     struct group **groups = NULL;
     const char **cached_users = NULL;
+    struct sysdb_store_group_entry *entries;
+    size_t num_groups;
+    size_t n = 0;
+    size_t failed;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -691,13 +779,42 @@ static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
         goto done;
     }
 
+    num_groups = 0;
+    while (groups[num_groups] != NULL) {
+        num_groups++;
+    }
+
+    entries = talloc_array(tmp_ctx, struct sysdb_store_group_entry,
+                           num_groups);
+    if (entries == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     for (size_t i = 0; groups[i]; i++) {
-        ret = save_file_group(id_ctx, groups[i], cached_users);
+        if (sf_skip_group(groups[i])) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", groups[i]->gr_name);
+            continue;
+        }
+
+        ret = sf_group_entry(entries, id_ctx, groups[i], cached_users,
+                             &entries[n]);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "Cannot save group %s\n", groups[i]->gr_name);
             continue;
         }
+        n++;
+    }
+
+    ret = sysdb_store_groups(id_ctx->domain, entries, n, 0, 0, &failed);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot save groups [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    } else if (failed > 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "%zu groups could not be saved\n",
+              failed);
     }
 
     ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_GROUP);
@@ -713,23 +830,562 @@ done:
     return ret;
 }
 
-static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
-                             uint8_t flags)
+/* Empty and missing values are equal, see save_file_user() */
+static bool sf_str_equal(const char *cached, const char *file)
+{
+    if (cached == NULL || cached[0] == '\0') {
+        return file == NULL || file[0] == '\0';
+    }
+
+    return file != NULL && strcmp(cached, file) == 0;
+}
+
+static bool sf_user_changed(struct ldb_message *msg, struct passwd *pw)
+{
+    if (ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0) != pw->pw_uid
+            || ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0) != pw->pw_gid) {
+        return true;
+    }
+
+    return !sf_str_equal(ldb_msg_find_attr_as_string(msg, SYSDB_PWD, NULL),
+                         pw->pw_passwd)
+        || !sf_str_equal(ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL),
+                         pw->pw_gecos)
+        || !sf_str_equal(ldb_msg_find_attr_as_string(msg, SYSDB_HOMEDIR, NULL),
+                         pw->pw_dir)
+        || !sf_str_equal(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL),
+                         pw->pw_shell);
+}
+
+static int sf_strcmp_qsort(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+/* Sort the list and drop duplicates, returns the new number of items */
+static size_t sf_sort_unique(const char **list, size_t count)
+{
+    size_t i;
+    size_t n;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    qsort(list, count, sizeof(const char *), sf_strcmp_qsort);
+
+    for (i = 1, n = 1; i < count; i++) {
+        if (strcmp(list[i], list[n - 1]) != 0) {
+            list[n++] = list[i];
+        }
+    }
+
+    return n;
+}
+
+/* Members of a cached group are either linked users, whose names are
+ * listed in memberuid by the memberof plugin, or ghost users. */
+static errno_t sf_group_changed(TALLOC_CTX *mem_ctx,
+                                struct files_id_ctx *id_ctx,
+                                struct ldb_message *msg,
+                                struct group *grp,
+                                bool *_changed)
 {
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message_element *el;
+    const char *attrs[] = { SYSDB_MEMBERUID, SYSDB_GHOST, NULL };
+    const char **cached = NULL;
+    char **fq_gr_mem = NULL;
+    size_t num_cached = 0;
+    size_t num_file = 0;
+    size_t i;
+    size_t a;
     errno_t ret;
-    errno_t tret;
-    bool in_transaction = false;
 
-    ret = sysdb_transaction_start(id_ctx->domain->sysdb);
+    if (ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0) != grp->gr_gid) {
+        *_changed = true;
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    for (a = 0; attrs[a] != NULL; a++) {
+        el = ldb_msg_find_element(msg, attrs[a]);
+        if (el != NULL) {
+            num_cached += el->num_values;
+        }
+    }
+
+    cached = talloc_zero_array(tmp_ctx, const char *, num_cached + 1);
+    if (cached == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    num_cached = 0;
+    for (a = 0; attrs[a] != NULL; a++) {
+        el = ldb_msg_find_element(msg, attrs[a]);
+        if (el == NULL) {
+            continue;
+        }
+
+        for (i = 0; i < el->num_values; i++) {
+            cached[num_cached++] = (const char *) el->values[i].data;
+        }
+    }
+
+    if (grp->gr_mem != NULL && grp->gr_mem[0] != NULL) {
+        fq_gr_mem = sss_create_internal_fqname_list(
+                                            tmp_ctx,
+                                            (const char *const*) grp->gr_mem,
+                                            id_ctx->domain->name);
+        if (fq_gr_mem == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (num_file = 0; fq_gr_mem[num_file] != NULL; num_file++);
+    }
+
+    num_cached = sf_sort_unique(cached, num_cached);
+    num_file = sf_sort_unique((const char **) fq_gr_mem, num_file);
+
+    *_changed = false;
+    if (num_cached != num_file) {
+        *_changed = true;
+    } else {
+        for (i = 0; i < num_file; i++) {
+            if (strcmp(cached[i], fq_gr_mem[i]) != 0) {
+                *_changed = true;
+                break;
+            }
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sf_hash_insert(hash_table_t *table,
+                              const char *fqname,
+                              void *entry)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(fqname);
+    value.type = HASH_VALUE_PTR;
+    value.ptr = entry;
+
+    /* an entry from a later file replaces the earlier one */
+    hret = hash_enter(table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to hash %s [%d]: %s\n",
+              fqname, hret, hash_error_string(hret));
+        return EIO;
+    }
+
+    return EOK;
+}
+
+/* Look up and remove the entry, entries left in the table after all
+ * cached entries were processed are new */
+static void *sf_hash_take(hash_table_t *table, const char *fqname)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(fqname);
+
+    hret = hash_lookup(table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        return NULL;
+    }
+
+    hash_delete(table, &key);
+    return value.ptr;
+}
+
+static errno_t sf_hash_file_users(TALLOC_CTX *mem_ctx,
+                                  struct files_id_ctx *id_ctx,
+                                  hash_table_t **_table)
+{
+    hash_table_t *table = NULL;
+    struct passwd **users = NULL;
+    char *fqname;
+    errno_t ret;
+
+    ret = sss_hash_create(mem_ctx, 0, &table);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (size_t f = 0; id_ctx->passwd_files[f] != NULL; f++) {
+        ret = enum_files_users(mem_ctx, id_ctx, id_ctx->passwd_files[f],
+                               &users);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->passwd_files[f]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate users from %s, aborting\n",
+                  id_ctx->passwd_files[f]);
+            goto done;
+        }
+
+        for (size_t i = 0; users[i] != NULL; i++) {
+            if (sf_skip_user(users[i])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", users[i]->pw_name);
+                continue;
+            }
+
+            fqname = sss_create_internal_fqname(users, users[i]->pw_name,
+                                                id_ctx->domain->name);
+            if (fqname == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sf_hash_insert(table, fqname, users[i]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    *_table = table;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(table);
+    }
+    return ret;
+}
+
+static errno_t sf_hash_file_groups(TALLOC_CTX *mem_ctx,
+                                   struct files_id_ctx *id_ctx,
+                                   hash_table_t **_table)
+{
+    hash_table_t *table = NULL;
+    struct group **groups = NULL;
+    char *fqname;
+    errno_t ret;
+
+    ret = sss_hash_create(mem_ctx, 0, &table);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (size_t f = 0; id_ctx->group_files[f] != NULL; f++) {
+        ret = enum_files_groups(mem_ctx, id_ctx, id_ctx->group_files[f],
+                                &groups);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->group_files[f]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate groups from %s, aborting\n",
+                  id_ctx->group_files[f]);
+            goto done;
+        }
+
+        for (size_t i = 0; groups[i] != NULL; i++) {
+            if (sf_skip_group(groups[i])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", groups[i]->gr_name);
+                continue;
+            }
+
+            fqname = sss_create_internal_fqname(groups, groups[i]->gr_name,
+                                                id_ctx->domain->name);
+            if (fqname == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sf_hash_insert(table, fqname, groups[i]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    *_table = table;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(table);
+    }
+    return ret;
+}
+
+/* Compare the passwd files with the cached users and only store the users
+ * that were added or changed and delete the users that were removed. */
+static errno_t sf_update_users(struct files_id_ctx *id_ctx)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *table = NULL;
+    hash_value_t *values = NULL;
+    unsigned long count;
+    struct ldb_message **msgs = NULL;
+    size_t num_msgs = 0;
+    struct passwd *pw;
+    const char *name;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                            SYSDB_PWD, SYSDB_GECOS, SYSDB_HOMEDIR,
+                            SYSDB_SHELL, NULL };
+    size_t added = 0;
+    size_t changed = 0;
+    size_t removed = 0;
+    int hret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sf_hash_file_users(tmp_ctx, id_ctx, &table);
     if (ret != EOK) {
         goto done;
     }
-    in_transaction = true;
+
+    ret = sysdb_search_users(tmp_ctx, id_ctx->domain, "("SYSDB_NAME"=*)",
+                             attrs, &num_msgs, &msgs);
+    if (ret == ENOENT) {
+        num_msgs = 0;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot search cached users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (size_t i = 0; i < num_msgs; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        pw = sf_hash_take(table, name);
+        if (pw == NULL) {
+            DEBUG(SSSDBG_TRACE_LIBS, "User %s was removed\n", name);
+            ret = sysdb_delete_user(id_ctx->domain, name, 0);
+            if (ret != EOK && ret != ENOENT) {
+                DEBUG(SSSDBG_OP_FAILURE, "Cannot delete user %s [%d]: %s\n",
+                      name, ret, sss_strerror(ret));
+                goto done;
+            }
+            removed++;
+            continue;
+        }
+
+        if (!sf_user_changed(msgs[i], pw)) {
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_LIBS, "User %s was changed\n", name);
+        ret = save_file_user(id_ctx, pw);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot save user %s: [%d]: %s\n",
+                  pw->pw_name, ret, sss_strerror(ret));
+            continue;
+        }
+        changed++;
+    }
+
+    hret = hash_values(table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "hash_values failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    for (unsigned long i = 0; i < count; i++) {
+        pw = talloc_get_type(values[i].ptr, struct passwd);
+
+        ret = save_file_user(id_ctx, pw);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot save user %s: [%d]: %s\n",
+                  pw->pw_name, ret, sss_strerror(ret));
+            continue;
+        }
+        added++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Users: %zu added, %zu changed, %zu removed\n",
+          added, changed, removed);
+
+    if (added > 0) {
+        ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_USER);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to refresh override attributes, "
+                  "override values might not be available.\n");
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Compare the group files with the cached groups. A changed group is
+ * deleted and stored again so that removed members are dropped. */
+static errno_t sf_update_groups(struct files_id_ctx *id_ctx)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *table = NULL;
+    hash_value_t *values = NULL;
+    unsigned long count;
+    struct ldb_message **msgs = NULL;
+    size_t num_msgs = 0;
+    struct group *grp;
+    const char **cached_users = NULL;
+    const char *name;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, SYSDB_MEMBERUID,
+                            SYSDB_GHOST, NULL };
+    bool grp_changed;
+    size_t added = 0;
+    size_t changed = 0;
+    size_t removed = 0;
+    int hret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sf_hash_file_groups(tmp_ctx, id_ctx, &table);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    cached_users = get_cached_user_names(tmp_ctx, id_ctx->domain);
+    if (cached_users == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_search_groups(tmp_ctx, id_ctx->domain, "("SYSDB_NAME"=*)",
+                              attrs, &num_msgs, &msgs);
+    if (ret == ENOENT) {
+        num_msgs = 0;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot search cached groups [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (size_t i = 0; i < num_msgs; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        grp = sf_hash_take(table, name);
+        if (grp != NULL) {
+            ret = sf_group_changed(tmp_ctx, id_ctx, msgs[i], grp,
+                                   &grp_changed);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            if (!grp_changed) {
+                continue;
+            }
+        }
+
+        ret = sysdb_delete_group(id_ctx->domain, name, 0);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot delete group %s [%d]: %s\n",
+                  name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        if (grp == NULL) {
+            DEBUG(SSSDBG_TRACE_LIBS, "Group %s was removed\n", name);
+            removed++;
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_LIBS, "Group %s was changed\n", name);
+        ret = save_file_group(id_ctx, grp, cached_users);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot save group %s\n", grp->gr_name);
+            continue;
+        }
+        changed++;
+    }
+
+    hret = hash_values(table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "hash_values failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    for (unsigned long i = 0; i < count; i++) {
+        grp = talloc_get_type(values[i].ptr, struct group);
+
+        ret = save_file_group(id_ctx, grp, cached_users);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot save group %s\n", grp->gr_name);
+            continue;
+        }
+        added++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Groups: %zu added, %zu changed, %zu removed\n",
+          added, changed, removed);
+
+    if (added > 0 || changed > 0) {
+        ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_GROUP);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to refresh override attributes, "
+                  "override values might not be available.\n");
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Delete all cached entries and store everything from the files again */
+static errno_t sf_reload_files(struct files_id_ctx *id_ctx,
+                               uint8_t flags)
+{
+    errno_t ret;
 
     if (flags & SF_UPDATE_PASSWD) {
         ret = delete_all_users(id_ctx->domain);
         if (ret != EOK) {
-            goto done;
+            return ret;
         }
 
         /* All users were deleted, therefore we need to enumerate each file again */
@@ -744,7 +1400,7 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
                 DEBUG(SSSDBG_OP_FAILURE,
                       "Cannot enumerate users from %s, aborting\n",
                       id_ctx->passwd_files[i]);
-                goto done;
+                return ret;
             }
         }
     }
@@ -752,7 +1408,7 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
     if (flags & SF_UPDATE_GROUP) {
         ret = delete_all_groups(id_ctx->domain);
         if (ret != EOK) {
-            goto done;
+            return ret;
         }
 
         /* All groups were deleted, therefore we need to enumerate each file again */
@@ -767,11 +1423,60 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
                 DEBUG(SSSDBG_OP_FAILURE,
                       "Cannot enumerate groups from %s, aborting\n",
                       id_ctx->group_files[i]);
-                goto done;
+                return ret;
             }
         }
     }
 
+    return EOK;
+}
+
+/* Only write the entries that differ from the cache. Users are processed
+ * first so that group members can be linked with the users that exist. */
+static errno_t sf_update_files(struct files_id_ctx *id_ctx,
+                               uint8_t flags)
+{
+    errno_t ret;
+
+    if (flags & SF_UPDATE_PASSWD) {
+        ret = sf_update_users(id_ctx);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (flags & SF_UPDATE_GROUP) {
+        ret = sf_update_groups(id_ctx);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
+                             uint8_t flags)
+{
+    errno_t ret;
+    errno_t tret;
+    bool in_transaction = false;
+
+    ret = sysdb_transaction_start(id_ctx->domain->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    if (id_ctx->incremental_reload) {
+        ret = sf_update_files(id_ctx, flags);
+    } else {
+        ret = sf_reload_files(id_ctx, flags);
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
     ret = dp_add_sr_attribute(id_ctx->be);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -42,6 +42,7 @@ struct files_id_ctx {
 
     const char **passwd_files;
     const char **group_files;
+    bool incremental_reload;
 
     bool updating_passwd;
     bool updating_groups;
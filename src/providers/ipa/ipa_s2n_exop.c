@@ -1090,27 +1090,39 @@ static const char *ipa_s2n_reqinp2str(TALLOC_CTX *mem_ctx,
     return str;
 }
 
+/* One object of the list, the replies are kept until all objects are
+ * received and saved together. */
+struct ipa_s2n_get_list_item {
+    struct tevent_req *req;
+    struct req_input req_input;
+    struct sss_domain_info *obj_domain;
+    struct resp_attrs *attrs;
+    struct sysdb_attrs *override_attrs;
+};
+
 struct ipa_s2n_get_list_state {
     struct tevent_context *ev;
     struct ipa_id_ctx *ipa_ctx;
     struct sss_domain_info *dom;
     struct sdap_handle *sh;
-    struct req_input req_input;
     char **list;
     size_t list_idx;
+    struct ipa_s2n_get_list_item *items;
+    size_t num_pending;
+    size_t window;
     int exop_timeout;
     int entry_type;
     enum request_types request_type;
-    struct resp_attrs *attrs;
-    struct sss_domain_info *obj_domain;
-    struct sysdb_attrs *override_attrs;
+    enum req_input_type list_type;
     struct sysdb_attrs *mapped_attrs;
 };
 
+static errno_t ipa_s2n_get_list_fill(struct tevent_req *req);
 static errno_t ipa_s2n_get_list_step(struct tevent_req *req);
 static void ipa_s2n_get_list_get_override_done(struct tevent_req *subreq);
 static void ipa_s2n_get_list_next(struct tevent_req *subreq);
-static errno_t ipa_s2n_get_list_save_step(struct tevent_req *req);
+static void ipa_s2n_get_list_item_done(struct tevent_req *req);
+static errno_t ipa_s2n_get_list_save(struct tevent_req *req);
 
 static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
                                                 struct tevent_context *ev,
@@ -1127,6 +1139,8 @@ static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
     int ret;
     struct ipa_s2n_get_list_state *state;
     struct tevent_req *req;
+    size_t list_len;
+    int window;
 
     req = tevent_req_create(mem_ctx, &state, struct ipa_s2n_get_list_state);
     if (req == NULL) {
@@ -1147,35 +1161,83 @@ static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
     state->sh = sh;
     state->list = list;
     state->list_idx = 0;
-    state->req_input.type = list_type;
-    state->req_input.inp.name = NULL;
+    state->num_pending = 0;
     state->exop_timeout = exop_timeout;
     state->entry_type = entry_type;
     state->request_type = request_type;
-    state->attrs = NULL;
-    state->override_attrs = NULL;
+    state->list_type = list_type;
     state->mapped_attrs = mapped_attrs;
 
-    ret = ipa_s2n_get_list_step(req);
+    for (list_len = 0; list[list_len] != NULL; list_len++);
+
+    if (list_len == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    state->items = talloc_zero_array(state, struct ipa_s2n_get_list_item,
+                                     list_len);
+    if (state->items == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    window = dp_opt_get_int(ipa_ctx->ipa_options->basic,
+                            IPA_EXTDOM_REQUEST_WINDOW);
+    state->window = window > 0 ? window : 1;
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Requesting %zu objects with up to %zu parallel requests.\n",
+          list_len, state->window);
+
+    ret = ipa_s2n_get_list_fill(req);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_step failed.\n");
+        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_fill failed.\n");
         goto done;
     }
 
+    return req;
+
 done:
     if (ret != EOK) {
         tevent_req_error(req, ret);
-        tevent_req_post(req, ev);
+    } else {
+        tevent_req_done(req);
     }
+    tevent_req_post(req, ev);
 
     return req;
 }
 
+/* Sends requests until the window is full or the list is exhausted. */
+static errno_t ipa_s2n_get_list_fill(struct tevent_req *req)
+{
+    struct ipa_s2n_get_list_state *state = tevent_req_data(req,
+                                               struct ipa_s2n_get_list_state);
+    errno_t ret;
+
+    while (state->num_pending < state->window
+            && state->list[state->list_idx] != NULL) {
+        ret = ipa_s2n_get_list_step(req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_step failed.\n");
+            return ret;
+        }
+
+        state->list_idx++;
+        state->num_pending++;
+    }
+
+    return EOK;
+}
+
 static errno_t ipa_s2n_get_list_step(struct tevent_req *req)
 {
     int ret;
     struct ipa_s2n_get_list_state *state = tevent_req_data(req,
                                                struct ipa_s2n_get_list_state);
+    struct ipa_s2n_get_list_item *item = &state->items[state->list_idx];
+    const char *obj_name = state->list[state->list_idx];
     struct berval *bv_req;
     struct tevent_req *subreq;
     struct sss_domain_info *parent_domain;
@@ -1185,66 +1247,67 @@ static errno_t ipa_s2n_get_list_step(struct tevent_req *req)
     char *endptr;
     bool need_v1 = false;
 
+    item->req = req;
+    item->req_input.type = state->list_type;
+
     parent_domain = get_domains_head(state->dom);
-    switch (state->req_input.type) {
+    switch (item->req_input.type) {
     case REQ_INP_NAME:
 
-        ret = sss_parse_name(state, state->dom->names, state->list[state->list_idx],
+        ret = sss_parse_name(state->items, state->dom->names, obj_name,
                              &domain_name, &short_name);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse name '%s' [%d]: %s\n",
-                                        state->list[state->list_idx],
-                                        ret, sss_strerror(ret));
+                                        obj_name, ret, sss_strerror(ret));
             return ret;
         }
 
         if (domain_name) {
-            state->obj_domain = find_domain_by_name(parent_domain,
-                                                    domain_name, true);
-            if (state->obj_domain == NULL) {
+            item->obj_domain = find_domain_by_name(parent_domain,
+                                                   domain_name, true);
+            if (item->obj_domain == NULL) {
                 DEBUG(SSSDBG_OP_FAILURE, "find_domain_by_name failed.\n");
                 return ENOMEM;
             }
         } else {
-            state->obj_domain = parent_domain;
+            item->obj_domain = parent_domain;
         }
 
-        state->req_input.inp.name = short_name;
+        item->req_input.inp.name = short_name;
 
         break;
     case REQ_INP_ID:
         errno = 0;
-        id = strtouint32(state->list[state->list_idx], &endptr, 10);
-        if (errno != 0 || *endptr != '\0'
-                || (state->list[state->list_idx] == endptr)) {
+        id = strtouint32(obj_name, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || (obj_name == endptr)) {
             DEBUG(SSSDBG_OP_FAILURE, "strtouint32 failed.\n");
             return EINVAL;
         }
-        state->req_input.inp.id = id;
-        state->obj_domain = state->dom;
+        item->req_input.inp.id = id;
+        item->obj_domain = state->dom;
 
         break;
     case REQ_INP_SECID:
-        state->req_input.inp.secid = state->list[state->list_idx];
-        state->obj_domain = find_domain_by_sid(parent_domain,
-                                               state->req_input.inp.secid);
-        if (state->obj_domain == NULL) {
+        item->req_input.inp.secid = state->list[state->list_idx];
+        item->obj_domain = find_domain_by_sid(parent_domain,
+                                              item->req_input.inp.secid);
+        if (item->obj_domain == NULL) {
             DEBUG(SSSDBG_OP_FAILURE,
                   "find_domain_by_sid failed for SID [%s].\n",
-                  state->req_input.inp.secid);
+                  item->req_input.inp.secid);
             return EINVAL;
         }
 
         break;
     default:
         DEBUG(SSSDBG_OP_FAILURE, "Unexpected input type [%d].\n",
-                                 state->req_input.type);
+                                 item->req_input.type);
         return EINVAL;
     }
 
-    ret = s2n_encode_request(state, state->obj_domain->name, state->entry_type,
+    ret = s2n_encode_request(state, item->obj_domain->name, state->entry_type,
                              state->request_type,
-                             &state->req_input, &bv_req);
+                             &item->req_input, &bv_req);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "s2n_encode_request failed.\n");
         return ret;
@@ -1254,12 +1317,11 @@ static errno_t ipa_s2n_get_list_step(struct tevent_req *req)
         need_v1 = true;
     }
 
-    if (state->req_input.type == REQ_INP_NAME
-            && state->req_input.inp.name != NULL) {
+    if (item->req_input.type == REQ_INP_NAME
+            && item->req_input.inp.name != NULL) {
         DEBUG(SSSDBG_TRACE_FUNC,
               "Sending request_type: [%s] for object [%s].\n",
-              ipa_s2n_reqtype2str(state->request_type),
-              state->list[state->list_idx]);
+              ipa_s2n_reqtype2str(state->request_type), obj_name);
     }
 
     subreq = ipa_s2n_exop_send(state, state->ev, state->sh, need_v1,
@@ -1268,7 +1330,7 @@ static errno_t ipa_s2n_get_list_step(struct tevent_req *req)
         DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_exop_send failed.\n");
         return ENOMEM;
     }
-    tevent_req_set_callback(subreq, ipa_s2n_get_list_next, req);
+    tevent_req_set_callback(subreq, ipa_s2n_get_list_next, item);
 
     return EOK;
 }
@@ -1276,8 +1338,9 @@ static errno_t ipa_s2n_get_list_step(struct tevent_req *req)
 static void ipa_s2n_get_list_next(struct tevent_req *subreq)
 {
     int ret;
-    struct tevent_req *req = tevent_req_callback_data(subreq,
-                                                      struct tevent_req);
+    struct ipa_s2n_get_list_item *item = tevent_req_callback_data(subreq,
+                                                struct ipa_s2n_get_list_item);
+    struct tevent_req *req = item->req;
     struct ipa_s2n_get_list_state *state = tevent_req_data(req,
                                                struct ipa_s2n_get_list_state);
     char *retoid = NULL;
@@ -1292,40 +1355,34 @@ static void ipa_s2n_get_list_next(struct tevent_req *subreq)
         goto fail;
     }
 
-    talloc_zfree(state->attrs);
-    ret = s2n_response_to_attrs(state, state->dom, retoid, retdata,
-                                &state->attrs);
+    ret = s2n_response_to_attrs(state->items, state->dom, retoid, retdata,
+                                &item->attrs);
+    talloc_free(retoid);
+    talloc_free(retdata);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "s2n_response_to_attrs failed.\n");
         goto fail;
     }
 
     DEBUG(SSSDBG_TRACE_FUNC, "Received [%s] attributes from IPA server.\n",
-                             state->attrs->a.name);
+                             item->attrs->a.name);
 
     if (is_default_view(state->ipa_ctx->view_name)) {
-        ret = ipa_s2n_get_list_save_step(req);
-        if (ret == EOK) {
-            tevent_req_done(req);
-        } else if (ret != EAGAIN) {
-            DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_save_step failed.\n");
-            goto fail;
-        }
-
+        ipa_s2n_get_list_item_done(req);
         return;
     }
 
-    ret = sysdb_attrs_get_string(state->attrs->sysdb_attrs, SYSDB_SID_STR,
+    ret = sysdb_attrs_get_string(item->attrs->sysdb_attrs, SYSDB_SID_STR,
                                  &sid_str);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Object [%s] has no SID, please check the "
               "ipaNTSecurityIdentifier attribute on the server-side",
-              state->attrs->a.name);
+              item->attrs->a.name);
         goto fail;
     }
 
-    ret = get_dp_id_data_for_sid(state, sid_str, state->obj_domain->name, &ar);
+    ret = get_dp_id_data_for_sid(state, sid_str, item->obj_domain->name, &ar);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "get_dp_id_data_for_sid failed.\n");
         goto fail;
@@ -1343,7 +1400,7 @@ static void ipa_s2n_get_list_next(struct tevent_req *subreq)
         ret = ENOMEM;
         goto fail;
     }
-    tevent_req_set_callback(subreq, ipa_s2n_get_list_get_override_done, req);
+    tevent_req_set_callback(subreq, ipa_s2n_get_list_get_override_done, item);
 
     return;
 
@@ -1355,60 +1412,102 @@ fail:
 static void ipa_s2n_get_list_get_override_done(struct tevent_req *subreq)
 {
     int ret;
-    struct tevent_req *req = tevent_req_callback_data(subreq,
-                                                      struct tevent_req);
+    struct ipa_s2n_get_list_item *item = tevent_req_callback_data(subreq,
+                                                struct ipa_s2n_get_list_item);
+    struct tevent_req *req = item->req;
     struct ipa_s2n_get_list_state *state = tevent_req_data(req,
                                                struct ipa_s2n_get_list_state);
 
-    ret = ipa_get_ad_override_recv(subreq, NULL, state, &state->override_attrs);
+    ret = ipa_get_ad_override_recv(subreq, NULL, state->items,
+                                   &item->override_attrs);
     talloc_zfree(subreq);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "IPA override lookup failed: %d\n", ret);
-        goto fail;
+        tevent_req_error(req, ret);
+        return;
     }
 
-    ret = ipa_s2n_get_list_save_step(req);
-    if (ret == EOK) {
-        tevent_req_done(req);
-    } else if (ret != EAGAIN) {
-        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_save_step failed.\n");
-        goto fail;
+    ipa_s2n_get_list_item_done(req);
+}
+
+static void ipa_s2n_get_list_item_done(struct tevent_req *req)
+{
+    struct ipa_s2n_get_list_state *state = tevent_req_data(req,
+                                               struct ipa_s2n_get_list_state);
+    errno_t ret;
+
+    state->num_pending--;
+
+    if (state->list[state->list_idx] != NULL) {
+        ret = ipa_s2n_get_list_fill(req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_fill failed.\n");
+            tevent_req_error(req, ret);
+        }
+        return;
     }
 
-    return;
+    if (state->num_pending > 0) {
+        return;
+    }
 
-fail:
-    tevent_req_error(req,ret);
-    return;
+    ret = ipa_s2n_get_list_save(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_save failed.\n");
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
 }
 
-static errno_t ipa_s2n_get_list_save_step(struct tevent_req *req)
+/* Saves all received objects in a single transaction. */
+static errno_t ipa_s2n_get_list_save(struct tevent_req *req)
 {
     int ret;
+    int tret;
     struct ipa_s2n_get_list_state *state = tevent_req_data(req,
                                                struct ipa_s2n_get_list_state);
+    struct ipa_s2n_get_list_item *item;
+    bool in_transaction = false;
+    size_t c;
 
-    ret = ipa_s2n_save_objects(state->dom, &state->req_input, state->attrs,
-                               NULL, state->ipa_ctx->view_name,
-                               state->override_attrs, state->mapped_attrs,
-                               false);
+    ret = sysdb_transaction_start(state->dom->sysdb);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_save_objects failed.\n");
-        return ret;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
     }
+    in_transaction = true;
 
-    state->list_idx++;
-    if (state->list[state->list_idx] == NULL) {
-        return EOK;
+    for (c = 0; c < state->list_idx; c++) {
+        item = &state->items[c];
+
+        ret = ipa_s2n_save_objects(state->dom, &item->req_input, item->attrs,
+                                   NULL, state->ipa_ctx->view_name,
+                                   item->override_attrs, state->mapped_attrs,
+                                   false);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_save_objects failed.\n");
+            goto done;
+        }
     }
 
-    ret = ipa_s2n_get_list_step(req);
+    ret = sysdb_transaction_commit(state->dom->sysdb);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "ipa_s2n_get_list_step failed.\n");
-        return ret;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+done:
+    if (in_transaction) {
+        tret = sysdb_transaction_cancel(state->dom->sysdb);
+        if (tret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
     }
 
-    return EAGAIN;
+    return ret;
 }
 
 static int ipa_s2n_get_list_recv(struct tevent_req *req)
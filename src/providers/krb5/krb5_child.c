@@ -28,6 +28,9 @@
 #include <fcntl.h>
 #include <ctype.h>
 #include <popt.h>
+#ifdef HAVE_PRCTL
+#include <sys/prctl.h>
+#endif
 
 #include <security/pam_modules.h>
 
@@ -3211,6 +3214,164 @@ static void try_open_krb5_conf(void)
     }
 }
 
+static errno_t k5c_worker_read_response(TALLOC_CTX *mem_ctx, int fd,
+                                        uint8_t **_buf, size_t *_len)
+{
+    uint8_t chunk[CHILD_MSG_CHUNK];
+    uint8_t *buf = NULL;
+    size_t len = 0;
+    ssize_t res;
+    errno_t ret;
+
+    while (true) {
+        errno = 0;
+        res = sss_atomic_read_s(fd, chunk, sizeof(chunk));
+        if (res == -1) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "read failed [%d][%s].\n", ret, strerror(ret));
+            talloc_free(buf);
+            return ret;
+        } else if (res == 0) {
+            break;
+        }
+
+        buf = talloc_realloc(mem_ctx, buf, uint8_t, len + res);
+        if (buf == NULL) {
+            return ENOMEM;
+        }
+        memcpy(buf + len, chunk, res);
+        len += res;
+    }
+
+    *_buf = buf;
+    *_len = len;
+    return EOK;
+}
+
+/* In worker mode krb5_child serves requests of the backend's child pool
+ * until the backend closes the pipe. Every request is handled by a process
+ * forked from the worker because krb5_child drops its privileges to the
+ * ones of the user and this cannot be undone. This still saves the exec()
+ * and the start up of a new krb5_child for each request.
+ *
+ * The function only returns in the forked process, with the request in
+ * _buf and the descriptor the response has to be written to in _out_fd. */
+static errno_t k5c_worker_run(uint8_t **_buf, size_t *_len, int *_out_fd)
+{
+    TALLOC_CTX *tmp_ctx;
+    uint8_t *buf;
+    size_t len;
+    uint8_t *resp;
+    size_t resp_len;
+    int pipefd[2] = PIPE_INIT;
+    char *prg_name;
+    int status;
+    pid_t pid;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "krb5_child worker waiting for requests.\n");
+
+    while (true) {
+        ret = child_worker_read_request(tmp_ctx, STDIN_FILENO, &buf, &len);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Backend closed the pipe, krb5_child worker exits.\n");
+            talloc_free(tmp_ctx);
+            exit(0);
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        ret = pipe(pipefd);
+        if (ret == -1) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "pipe failed [%d][%s].\n", ret, strerror(ret));
+            goto done;
+        }
+
+        pid = fork();
+        if (pid == 0) {
+            PIPE_FD_CLOSE(pipefd[0]);
+            close(STDIN_FILENO);
+
+            /* STDOUT_FILENO is the framed pipe to the backend. Replace it
+             * with the pipe to the worker so that a stray write from a
+             * library can only spoil the response of this request. */
+            ret = dup2(pipefd[1], STDOUT_FILENO);
+            if (ret == -1) {
+                ret = errno;
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "dup2 failed [%d][%s].\n", ret, strerror(ret));
+                goto done;
+            }
+            PIPE_FD_CLOSE(pipefd[1]);
+#ifdef HAVE_PRCTL
+            /* The backend kills the worker if the request times out */
+            if (prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0) != 0) {
+                DEBUG(SSSDBG_MINOR_FAILURE, "prctl failed [%d].\n", errno);
+            }
+#endif
+            prg_name = talloc_asprintf(NULL, "[sssd[krb5_child[%d]]]",
+                                       getpid());
+            if (prg_name != NULL) {
+                talloc_free(discard_const(debug_prg_name));
+                debug_prg_name = prg_name;
+            }
+
+            *_buf = talloc_steal(NULL, buf);
+            *_len = len;
+            *_out_fd = STDOUT_FILENO;
+            talloc_free(tmp_ctx);
+            return EOK;
+        } else if (pid == -1) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "fork failed [%d][%s].\n", ret, strerror(ret));
+            goto done;
+        }
+
+        PIPE_FD_CLOSE(pipefd[1]);
+        safezero(buf, len);
+        talloc_free(buf);
+
+        DEBUG(SSSDBG_TRACE_INTERNAL,
+              "Request handed over to process [%d].\n", pid);
+
+        ret = k5c_worker_read_response(tmp_ctx, pipefd[0], &resp, &resp_len);
+        PIPE_FD_CLOSE(pipefd[0]);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        do {
+            ret = waitpid(pid, &status, 0);
+        } while (ret == -1 && errno == EINTR);
+        if (ret == pid && WIFEXITED(status)) {
+            DEBUG(SSSDBG_TRACE_INTERNAL, "Process [%d] exited with [%d].\n",
+                  pid, WEXITSTATUS(status));
+        }
+
+        /* An empty response tells the backend that the request failed */
+        ret = child_worker_send_response(STDOUT_FILENO, resp, resp_len);
+        talloc_free(resp);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+done:
+    PIPE_CLOSE(pipefd);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 int main(int argc, const char *argv[])
 {
     struct krb5_req *kr = NULL;
@@ -3225,6 +3386,10 @@ int main(int argc, const char *argv[])
     gid_t fast_gid = 0;
     struct cli_opts cli_opts = { 0 };
     int sss_creds_password = 0;
+    int worker = 0;
+    uint8_t *req_buf = NULL;
+    size_t req_len = 0;
+    int out_fd = STDOUT_FILENO;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -3259,6 +3424,8 @@ int main(int argc, const char *argv[])
          _("Requests canonicalization of the principal name"), NULL},
         {CHILD_OPT_SSS_CREDS_PASSWORD, 0, POPT_ARG_NONE, &sss_creds_password,
          0, _("Use custom version of krb5_get_init_creds_password"), NULL},
+        {CHILD_OPT_WORKER, 0, POPT_ARG_NONE, &worker, 0,
+         _("Serve requests until the backend closes the pipe"), NULL},
         POPT_TABLEEND
     };
 
@@ -3305,6 +3472,15 @@ int main(int argc, const char *argv[])
 
     DEBUG(SSSDBG_TRACE_FUNC, "krb5_child started.\n");
 
+    if (worker != 0) {
+        /* Returns only in the process forked for a single request */
+        ret = k5c_worker_run(&req_buf, &req_len, &out_fd);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "krb5_child worker failed.\n");
+            goto done;
+        }
+    }
+
     kr = talloc_zero(NULL, struct krb5_req);
     if (kr == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
@@ -3322,12 +3498,22 @@ int main(int argc, const char *argv[])
         kr->krb5_get_init_creds_password = krb5_get_init_creds_password;
     }
 
-    ret = k5c_recv_data(kr, STDIN_FILENO, &offline);
-    if (ret != EOK) {
-        goto done;
-    }
+    if (req_buf != NULL) {
+        talloc_steal(kr, req_buf);
+        ret = unpack_buffer(req_buf, req_len, kr, &offline);
+        safezero(req_buf, req_len);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "unpack_buffer failed.\n");
+            goto done;
+        }
+    } else {
+        ret = k5c_recv_data(kr, STDIN_FILENO, &offline);
+        if (ret != EOK) {
+            goto done;
+        }
 
-    close(STDIN_FILENO);
+        close(STDIN_FILENO);
+    }
 
     kerr = privileged_krb5_setup(kr, offline);
     if (kerr != 0) {
@@ -3412,7 +3598,7 @@ int main(int argc, const char *argv[])
         goto done;
     }
 
-    ret = k5c_send_data(kr, STDOUT_FILENO, ret);
+    ret = k5c_send_data(kr, out_fd, ret);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to send reply\n");
     }
@@ -53,6 +53,7 @@ struct handle_child_state {
     pid_t child_pid;
 
     struct child_io_fds *io;
+    struct io_buffer *send_buf;
 };
 
 static errno_t pack_authtok(struct io_buffer *buf, size_t *rp,
@@ -509,8 +510,97 @@ fail:
     return ret;
 }
 
+errno_t krb5_child_pool_init(struct krb5_ctx *krb5_ctx,
+                             struct tevent_context *ev)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char **extra_args;
+    const char **worker_args;
+    int size;
+    int max_requests;
+    size_t c;
+    errno_t ret;
+
+    size = dp_opt_get_int(krb5_ctx->opts, KRB5_CHILD_POOL_SIZE);
+    if (size <= 0) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "krb5_child pool disabled, forking a child per request.\n");
+        return EOK;
+    }
+
+    max_requests = dp_opt_get_int(krb5_ctx->opts,
+                                  KRB5_CHILD_POOL_MAX_REQUESTS);
+    if (max_requests < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Invalid value [%d] of krb5_child_pool_max_requests, "
+              "using no limit.\n", max_requests);
+        max_requests = 0;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = set_extra_args(tmp_ctx, krb5_ctx, &extra_args);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "set_extra_args failed.\n");
+        goto done;
+    }
+
+    for (c = 0; extra_args[c] != NULL; c++);
+
+    worker_args = talloc_zero_array(tmp_ctx, const char *, c + 2);
+    if (worker_args == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(worker_args, extra_args, c * sizeof(const char *));
+    worker_args[c] = "--" CHILD_OPT_WORKER;
+
+    ret = sss_child_pool_init(krb5_ctx, ev, KRB5_CHILD,
+                              krb5_ctx->child_debug_fd, worker_args,
+                              size, max_requests,
+                              dp_opt_get_int(krb5_ctx->opts, KRB5_AUTH_TIMEOUT),
+                              &krb5_ctx->child_pool);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sss_child_pool_init failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static void handle_child_step(struct tevent_req *subreq);
 static void handle_child_done(struct tevent_req *subreq);
+static void handle_child_pool_done(struct tevent_req *subreq);
+
+static errno_t handle_child_fork(struct tevent_req *req)
+{
+    struct handle_child_state *state = tevent_req_data(req,
+                                                     struct handle_child_state);
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    ret = fork_child(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "fork_child failed.\n");
+        return ret;
+    }
+
+    subreq = write_pipe_send(state, state->ev, state->send_buf->data,
+                             state->send_buf->size,
+                             state->io->write_to_child_fd);
+    if (subreq == NULL) {
+        return ENOMEM;
+    }
+    tevent_req_set_callback(subreq, handle_child_step, req);
+
+    return EOK;
+}
 
 struct tevent_req *handle_child_send(TALLOC_CTX *mem_ctx,
                                      struct tevent_context *ev,
@@ -548,20 +638,24 @@ struct tevent_req *handle_child_send(TALLOC_CTX *mem_ctx,
         DEBUG(SSSDBG_CRIT_FAILURE, "create_send_buffer failed.\n");
         goto fail;
     }
+    state->send_buf = buf;
 
-    ret = fork_child(req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "fork_child failed.\n");
-        goto fail;
+    if (kr->krb5_ctx->child_pool != NULL) {
+        subreq = sss_child_pool_send(state, ev, kr->krb5_ctx->child_pool,
+                                     buf->data, buf->size);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+        tevent_req_set_callback(subreq, handle_child_pool_done, req);
+
+        return req;
     }
 
-    subreq = write_pipe_send(state, ev, buf->data, buf->size,
-                             state->io->write_to_child_fd);
-    if (!subreq) {
-        ret = ENOMEM;
+    ret = handle_child_fork(req);
+    if (ret != EOK) {
         goto fail;
     }
-    tevent_req_set_callback(subreq, handle_child_step, req);
 
     return req;
 
@@ -619,6 +713,39 @@ static void handle_child_done(struct tevent_req *subreq)
     return;
 }
 
+static void handle_child_pool_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct handle_child_state *state = tevent_req_data(req,
+                                                    struct handle_child_state);
+    int ret;
+
+    ret = sss_child_pool_recv(subreq, state, &state->buf, &state->len);
+    talloc_zfree(subreq);
+    if (ret == EBUSY) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "All krb5_child workers are busy, forking a new krb5_child.\n");
+        ret = handle_child_fork(req);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+        }
+        return;
+    } else if (ret == ETIMEDOUT) {
+        DEBUG(SSSDBG_IMPORTANT_INFO,
+              "Timeout for krb5_child worker reached. In case KDC is distant "
+              "or network is slow you may consider increasing value of "
+              "krb5_auth_timeout.\n");
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
 int handle_child_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
                       uint8_t **buf, ssize_t *len)
 {
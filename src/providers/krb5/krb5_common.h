@@ -63,6 +63,8 @@ enum krb5_opts {
     KRB5_USE_KDCINFO,
     KRB5_KDCINFO_LOOKAHEAD,
     KRB5_MAP_USER,
+    KRB5_CHILD_POOL_SIZE,
+    KRB5_CHILD_POOL_MAX_REQUESTS,
 
     KRB5_OPTS
 };
@@ -82,6 +84,7 @@ struct krb5_service {
 struct fo_service;
 struct deferred_auth_ctx;
 struct renew_tgt_ctx;
+struct sss_child_pool;
 
 enum krb5_config_type {
     K5C_GENERIC,
@@ -125,6 +128,7 @@ struct krb5_ctx {
     struct krb5_service *service;
     struct krb5_service *kpasswd_service;
     int child_debug_fd;
+    struct sss_child_pool *child_pool;
 
     pcre *illegal_path_re;
 
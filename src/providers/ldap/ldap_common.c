@@ -36,6 +36,7 @@
 #include "util/crypto/sss_crypto.h"
 
 #include "providers/ldap/sdap_idmap.h"
+#include "providers/ldap/sdap_sync.h"
 
 /* a fd the child process would log into */
 int ldap_child_debug_fd = -1;
@@ -55,10 +56,28 @@ int sdap_id_setup_tasks(struct be_ctx *be_ctx,
                         be_ptask_recv_t recv_fn,
                         void *pvt)
 {
+    enum sdap_change_stream stream;
     int ret;
 
-    /* set up enumeration task */
-    if (sdom->dom->enumerate) {
+    ret = sdap_change_stream_get(ctx->opts, sdom, &stream);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (stream != SDAP_CHANGE_STREAM_NONE) {
+        /* the change stream replaces enumeration, objects which left the
+         * search scope without being reported are still purged by the
+         * cleanup task */
+        DEBUG(SSSDBG_TRACE_FUNC, "Setting up change stream for %s\n",
+                                  sdom->dom->name);
+        ret = sdap_change_stream_setup(ctx, sdom, send_fn, recv_fn, pvt);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = ldap_setup_cleanup(ctx, sdom);
+    } else if (sdom->dom->enumerate) {
+        /* set up enumeration task */
         DEBUG(SSSDBG_TRACE_FUNC, "Setting up enumeration for %s\n",
                                   sdom->dom->name);
         ret = ldap_setup_enumeration(be_ctx, ctx->opts, sdom,
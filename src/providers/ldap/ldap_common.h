@@ -243,6 +243,17 @@ errno_t ldap_setup_cleanup(struct sdap_id_ctx *id_ctx,
 errno_t ldap_id_cleanup(struct sdap_options *opts,
                         struct sdap_domain *sdom);
 
+struct tevent_req *users_get_send(TALLOC_CTX *memctx,
+                                  struct tevent_context *ev,
+                                  struct sdap_id_ctx *ctx,
+                                  struct sdap_domain *sdom,
+                                  struct sdap_id_conn_ctx *conn,
+                                  const char *filter_value,
+                                  int filter_type,
+                                  const char *extra_value,
+                                  bool noexist_delete);
+int users_get_recv(struct tevent_req *req, int *dp_error_out, int *sdap_ret);
+
 struct tevent_req *groups_get_send(TALLOC_CTX *memctx,
                                    struct tevent_context *ev,
                                    struct sdap_id_ctx *ctx,
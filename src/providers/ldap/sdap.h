@@ -236,6 +236,10 @@ enum sdap_basic_opt {
     SDAP_MAX_ID,
     SDAP_PWDLOCKOUT_DN,
     SDAP_WILDCARD_LIMIT,
+    SDAP_CONNECTION_POOL_SIZE,
+    SDAP_NESTED_GROUP_BATCH_SIZE,
+    SDAP_CHANGE_STREAM,
+    SDAP_CHANGE_STREAM_INTERVAL,
 
     SDAP_OPTS_BASIC /* opts counter */
 };
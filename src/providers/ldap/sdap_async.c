@@ -301,7 +301,9 @@ static void sdap_process_message(struct tevent_context *ev,
     switch (msgtype) {
     case LDAP_RES_SEARCH_ENTRY:
     case LDAP_RES_SEARCH_REFERENCE:
-        /* go and process entry */
+    case LDAP_RES_INTERMEDIATE:
+        /* go and process entry, an intermediate response is never the
+         * final one (e.g. syncrepl sync info messages) */
         break;
 
     case LDAP_RES_BIND:
@@ -312,7 +314,6 @@ static void sdap_process_message(struct tevent_context *ev,
     case LDAP_RES_MODDN:
     case LDAP_RES_COMPARE:
     case LDAP_RES_EXTENDED:
-    case LDAP_RES_INTERMEDIATE:
         /* no more results expected with this msgid */
         op->done = true;
         break;
@@ -354,7 +355,7 @@ static void sdap_process_message(struct tevent_context *ev,
     }
 }
 
-static void sdap_unlock_next_reply(struct sdap_op *op)
+void sdap_unlock_next_reply(struct sdap_op *op)
 {
     struct timeval tv;
     struct tevent_timer *te;
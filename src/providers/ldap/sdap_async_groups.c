@@ -340,38 +340,6 @@ done:
     /* FIXME: support non legacy */
     /* FIXME: support storing additional attributes */
 
-static errno_t
-sdap_store_group_with_gid(struct sss_domain_info *domain,
-                          const char *name,
-                          gid_t gid,
-                          struct sysdb_attrs *group_attrs,
-                          uint64_t cache_timeout,
-                          bool posix_group,
-                          time_t now)
-{
-    errno_t ret;
-
-    /* make sure that non-POSIX (empty or explicit gid=0) groups have the
-     * gidNumber set to zero even if updating existing group */
-    if (!posix_group) {
-        ret = sysdb_attrs_add_uint32(group_attrs, SYSDB_GIDNUM, 0);
-        if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "Could not set explicit GID 0 for %s\n", name);
-            return ret;
-        }
-    }
-
-    ret = sysdb_store_group(domain, name, gid, group_attrs,
-                            cache_timeout, now);
-    if (ret) {
-        DEBUG(SSSDBG_OP_FAILURE, "Could not store group %s\n", name);
-        return ret;
-    }
-
-    return ret;
-}
-
 static errno_t
 sdap_process_ghost_members(struct sysdb_attrs *attrs,
                            struct sdap_options *opts,
@@ -491,15 +459,20 @@ sdap_process_ghost_members(struct sysdb_attrs *attrs,
     return EOK;
 }
 
-static int sdap_save_group(TALLOC_CTX *memctx,
-                           struct sdap_options *opts,
-                           struct sss_domain_info *dom,
-                           struct sysdb_attrs *attrs,
-                           bool populate_members,
-                           bool store_original_member,
-                           hash_table_t *ghosts,
-                           char **_usn_value,
-                           time_t now)
+/* Converts the LDAP attributes of a group into the arguments of
+ * sysdb_store_group(). The group might belong to a subdomain of dom, the
+ * domain it has to be stored in is returned in _dom. _dom is set to NULL
+ * if the group should not be stored at all. */
+static int sdap_save_group_prepare(TALLOC_CTX *memctx,
+                                   struct sdap_options *opts,
+                                   struct sss_domain_info *dom,
+                                   struct sysdb_attrs *attrs,
+                                   bool populate_members,
+                                   bool store_original_member,
+                                   hash_table_t *ghosts,
+                                   struct sss_domain_info **_dom,
+                                   struct sysdb_store_group_entry *_entry,
+                                   char **_usn_value)
 {
     struct ldb_message_element *el;
     struct sysdb_attrs *group_attrs;
@@ -514,13 +487,15 @@ static int sdap_save_group(TALLOC_CTX *memctx,
     char *sid_str;
     struct sss_domain_info *subdomain;
 
+    *_dom = NULL;
+
     tmpctx = talloc_new(NULL);
     if (!tmpctx) {
         ret = ENOMEM;
         goto done;
     }
 
-    group_attrs = sysdb_new_attrs(tmpctx);
+    group_attrs = sysdb_new_attrs(memctx);
     if (group_attrs == NULL) {
         ret = ENOMEM;
         goto done;
@@ -571,7 +546,7 @@ static int sdap_save_group(TALLOC_CTX *memctx,
         }
     }
 
-    ret = sdap_get_group_primary_name(tmpctx, opts, attrs, dom, &group_name);
+    ret = sdap_get_group_primary_name(memctx, opts, attrs, dom, &group_name);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Failed to get group name\n");
         goto done;
@@ -744,23 +719,27 @@ static int sdap_save_group(TALLOC_CTX *memctx,
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to save group names\n");
         goto done;
     }
-    DEBUG(SSSDBG_TRACE_FUNC, "Storing info for group %s\n", group_name);
 
-    ret = sdap_store_group_with_gid(dom, group_name, gid, group_attrs,
-                                    dom->group_timeout,
-                                    posix_group, now);
-    if (ret) {
-        DEBUG(SSSDBG_MINOR_FAILURE,
-              "Could not store group with GID: [%s]\n",
-               sss_strerror(ret));
-        goto done;
+    /* make sure that non-POSIX (empty or explicit gid=0) groups have the
+     * gidNumber set to zero even if updating existing group */
+    if (!posix_group) {
+        ret = sysdb_attrs_add_uint32(group_attrs, SYSDB_GIDNUM, 0);
+        if (ret) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Could not set explicit GID 0 for %s\n", group_name);
+            goto done;
+        }
     }
 
+    _entry->name = group_name;
+    _entry->gid = gid;
+    _entry->attrs = group_attrs;
+    *_dom = dom;
+
     if (_usn_value) {
         *_usn_value = talloc_steal(memctx, usn_value);
     }
 
-    talloc_steal(memctx, group_attrs);
     ret = EOK;
 
 done:
@@ -1043,6 +1022,15 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
     int i;
     struct sysdb_attrs **saved_groups = NULL;
     int nsaved_groups = 0;
+    struct sysdb_store_group_entry *entries;
+    struct sysdb_store_group_entry *batch;
+    struct sss_domain_info **entry_doms;
+    struct sss_domain_info *store_dom;
+    size_t count = 0;
+    size_t batch_count;
+    size_t failed;
+    size_t j;
+    size_t k;
     time_t now;
     bool in_transaction = false;
 
@@ -1067,6 +1055,17 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
         return ENOMEM;
     }
 
+    entries = talloc_zero_array(tmpctx, struct sysdb_store_group_entry,
+                                num_groups);
+    batch = talloc_zero_array(tmpctx, struct sysdb_store_group_entry,
+                              num_groups);
+    entry_doms = talloc_zero_array(tmpctx, struct sss_domain_info *,
+                                   num_groups);
+    if (entries == NULL || batch == NULL || entry_doms == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     ret = sysdb_transaction_start(sysdb);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
@@ -1088,10 +1087,11 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
         usn_value = NULL;
 
         /* if 2 pass savemembers = false */
-        ret = sdap_save_group(tmpctx, opts, dom, groups[i],
-                              populate_members,
-                              has_nesting && save_orig_member,
-                              ghosts, &usn_value, now);
+        ret = sdap_save_group_prepare(tmpctx, opts, dom, groups[i],
+                                      populate_members,
+                                      has_nesting && save_orig_member,
+                                      ghosts, &entry_doms[count],
+                                      &entries[count], &usn_value);
 
         /* Do not fail completely on errors.
          * Just report the failure to save and go on */
@@ -1100,6 +1100,9 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
                   "Failed to store group %d. Ignoring.\n", i);
         } else {
             DEBUG(SSSDBG_TRACE_ALL, "Group %d processed!\n", i);
+            if (entry_doms[count] != NULL) {
+                count++;
+            }
             if (twopass && !populate_members) {
                 saved_groups[nsaved_groups] = groups[i];
                 nsaved_groups++;
@@ -1121,6 +1124,37 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
         }
     }
 
+    /* Groups whose SID belongs to a subdomain are stored in that domain, so
+     * the groups are stored in one batch per domain. The members are saved
+     * in the second pass below, once all the groups exist. */
+    for (j = 0; j < count; j++) {
+        store_dom = entry_doms[j];
+        if (store_dom == NULL) {
+            continue;
+        }
+
+        batch_count = 0;
+        for (k = j; k < count; k++) {
+            if (entry_doms[k] == store_dom) {
+                batch[batch_count++] = entries[k];
+                entry_doms[k] = NULL;
+            }
+        }
+
+        ret = sysdb_store_groups(store_dom, batch, batch_count,
+                                 store_dom->group_timeout, now, &failed);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store groups of domain %s "
+                  "[%d]: %s\n", store_dom->name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        if (failed != 0) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to store %zu groups of domain "
+                  "%s. Ignoring.\n", failed, store_dom->name);
+        }
+    }
+
     if (twopass && !populate_members) {
 
         for (i = 0; i < nsaved_groups; i++) {
@@ -57,6 +57,19 @@ struct sdap_nested_group_member {
     const char *group_filter;
 };
 
+/* Members of the same type stored directly in the same container,
+ * they are looked up with a single search for their RDN values */
+struct sdap_nested_group_batch {
+    enum sdap_nested_group_dn_type type;
+    struct ldb_dn *parent_dn;
+    const char *rdn_attr;
+    const char *filter;
+
+    struct sdap_nested_group_member **members;
+    struct ldb_dn **member_dns;
+    int num_members;
+};
+
 #ifndef EXTERNAL_MEMBERS_CHUNK
 #define EXTERNAL_MEMBERS_CHUNK  16
 #endif /* EXTERNAL_MEMBERS_CHUNK */
@@ -78,6 +91,7 @@ struct sdap_nested_group_ctx {
     bool try_deref;
     int deref_threshold;
     int max_nesting_level;
+    int batch_size;
 };
 
 static struct tevent_req *
@@ -120,6 +134,17 @@ static errno_t sdap_nested_group_lookup_group_recv(TALLOC_CTX *mem_ctx,
                                                    struct tevent_req *req,
                                                    struct sysdb_attrs **_group);
 
+static struct tevent_req *
+sdap_nested_group_lookup_batch_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct sdap_nested_group_ctx *group_ctx,
+                                    struct sdap_nested_group_batch *batch);
+
+static errno_t sdap_nested_group_lookup_batch_recv(TALLOC_CTX *mem_ctx,
+                                                   struct tevent_req *req,
+                                                   struct sysdb_attrs ***_entries,
+                                                   size_t *_num_entries);
+
 static struct tevent_req *
 sdap_nested_group_lookup_unknown_send(TALLOC_CTX *mem_ctx,
                                       struct tevent_context *ev,
@@ -832,6 +857,8 @@ sdap_nested_group_send(TALLOC_CTX *mem_ctx,
                                                       SDAP_DEREF_THRESHOLD);
     state->group_ctx->max_nesting_level = dp_opt_get_int(opts->basic,
                                                          SDAP_NESTING_LEVEL);
+    state->group_ctx->batch_size = dp_opt_get_int(opts->basic,
+                                                  SDAP_NESTED_GROUP_BATCH_SIZE);
     state->group_ctx->domain = sdom->dom;
     state->group_ctx->opts = opts;
     state->group_ctx->user_search_bases = sdom->user_search_bases;
@@ -1340,12 +1367,174 @@ static errno_t sdap_nested_group_recurse_recv(struct tevent_req *req)
     return EOK;
 }
 
+static bool
+sdap_nested_group_batch_matches(struct sdap_nested_group_batch *batch,
+                                enum sdap_nested_group_dn_type type,
+                                struct ldb_dn *parent_dn,
+                                const char *rdn_attr,
+                                const char *filter,
+                                int batch_size)
+{
+    if (batch->num_members >= batch_size
+            || batch->type != type
+            || strcasecmp(batch->rdn_attr, rdn_attr) != 0) {
+        return false;
+    }
+
+    if (batch->filter == NULL || filter == NULL) {
+        if (batch->filter != filter) {
+            return false;
+        }
+    } else if (strcmp(batch->filter, filter) != 0) {
+        return false;
+    }
+
+    return ldb_dn_compare(batch->parent_dn, parent_dn) == 0;
+}
+
+/* Split members into batches that can be looked up with a single search
+ * and members that have to be looked up individually. Members of unknown
+ * type and IPA users, whose names are guessed from the DN, are never
+ * batched, a batch with a single member is looked up individually too. */
+static errno_t
+sdap_nested_group_batch_members(TALLOC_CTX *mem_ctx,
+                                struct sdap_nested_group_ctx *group_ctx,
+                                struct sdap_nested_group_member *members,
+                                int num_members,
+                                struct sdap_nested_group_batch **_batches,
+                                int *_num_batches,
+                                struct sdap_nested_group_member **_singles,
+                                int *_num_singles)
+{
+    struct ldb_context *ldb = sysdb_ctx_get_ldb(group_ctx->domain->sysdb);
+    struct sdap_nested_group_batch *batches = NULL;
+    struct sdap_nested_group_batch *batch;
+    struct sdap_nested_group_member *singles = NULL;
+    struct sdap_nested_group_member *member;
+    struct ldb_dn *dn;
+    struct ldb_dn *parent_dn;
+    const char *rdn_attr;
+    const char *filter;
+    int num_batches = 0;
+    int num_singles = 0;
+    int i;
+    int j;
+
+    if (group_ctx->batch_size <= 1 || num_members <= 1) {
+        *_batches = NULL;
+        *_num_batches = 0;
+        *_singles = members;
+        *_num_singles = num_members;
+        return EOK;
+    }
+
+    batches = talloc_zero_array(mem_ctx, struct sdap_nested_group_batch,
+                                num_members);
+    singles = talloc_zero_array(mem_ctx, struct sdap_nested_group_member,
+                                num_members);
+    if (batches == NULL || singles == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_members; i++) {
+        member = &members[i];
+
+        if (member->type == SDAP_NESTED_GROUP_DN_UNKNOWN
+                || (member->type == SDAP_NESTED_GROUP_DN_USER
+                    && group_ctx->opts->schema_type == SDAP_SCHEMA_IPA_V1)) {
+            singles[num_singles++] = *member;
+            continue;
+        }
+
+        dn = ldb_dn_new(batches, ldb, member->dn);
+        if (dn == NULL || !ldb_dn_validate(dn)
+                || ldb_dn_get_comp_num(dn) < 2) {
+            singles[num_singles++] = *member;
+            talloc_free(dn);
+            continue;
+        }
+
+        rdn_attr = ldb_dn_get_rdn_name(dn);
+        parent_dn = ldb_dn_get_parent(batches, dn);
+        if (rdn_attr == NULL || parent_dn == NULL) {
+            singles[num_singles++] = *member;
+            talloc_free(dn);
+            continue;
+        }
+
+        filter = member->type == SDAP_NESTED_GROUP_DN_USER ? \
+                            member->user_filter : member->group_filter;
+
+        batch = NULL;
+        for (j = 0; j < num_batches; j++) {
+            if (sdap_nested_group_batch_matches(&batches[j], member->type,
+                                                parent_dn, rdn_attr, filter,
+                                                group_ctx->batch_size)) {
+                batch = &batches[j];
+                break;
+            }
+        }
+
+        if (batch == NULL) {
+            batch = &batches[num_batches++];
+            batch->type = member->type;
+            batch->parent_dn = parent_dn;
+            batch->rdn_attr = rdn_attr;
+            batch->filter = filter;
+            batch->members = talloc_zero_array(batches,
+                                               struct sdap_nested_group_member *,
+                                               group_ctx->batch_size);
+            batch->member_dns = talloc_zero_array(batches, struct ldb_dn *,
+                                                  group_ctx->batch_size);
+            if (batch->members == NULL || batch->member_dns == NULL) {
+                return ENOMEM;
+            }
+        } else {
+            talloc_free(parent_dn);
+        }
+
+        batch->members[batch->num_members] = member;
+        batch->member_dns[batch->num_members] = dn;
+        batch->num_members++;
+    }
+
+    /* a base search is cheaper than a batch with a single member */
+    for (i = 0, j = 0; i < num_batches; i++) {
+        if (batches[i].num_members == 1) {
+            singles[num_singles++] = *batches[i].members[0];
+            continue;
+        }
+
+        if (i != j) {
+            batches[j] = batches[i];
+        }
+        j++;
+    }
+    num_batches = j;
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "%d members will be looked up in %d "
+          "batches, %d individually\n", num_members - num_singles,
+          num_batches, num_singles);
+
+    *_batches = batches;
+    *_num_batches = num_batches;
+    *_singles = singles;
+    *_num_singles = num_singles;
+
+    return EOK;
+}
+
 struct sdap_nested_group_single_state {
     struct tevent_context *ev;
     struct sdap_nested_group_ctx *group_ctx;
     struct sdap_nested_group_member *members;
     int nesting_level;
 
+    struct sdap_nested_group_batch *batches;
+    int num_batches;
+    int batch_index;
+    struct sdap_nested_group_batch *current_batch;
+
     struct sdap_nested_group_member *current_member;
     int num_members;
     int member_index;
@@ -1380,11 +1569,11 @@ sdap_nested_group_single_send(TALLOC_CTX *mem_ctx,
 
     state->ev = ev;
     state->group_ctx = group_ctx;
-    state->members = members;
     state->nesting_level = nesting_level;
     state->current_member = NULL;
-    state->num_members = num_members;
     state->member_index = 0;
+    state->current_batch = NULL;
+    state->batch_index = 0;
     state->nested_groups = talloc_zero_array(state, struct sysdb_attrs *,
                                              num_groups_max);
     if (state->nested_groups == NULL) {
@@ -1393,7 +1582,17 @@ sdap_nested_group_single_send(TALLOC_CTX *mem_ctx,
     }
     state->num_groups = 0; /* we will count exact number of the groups */
 
-    /* process each member individually */
+    ret = sdap_nested_group_batch_members(state, group_ctx,
+                                          members, num_members,
+                                          &state->batches, &state->num_batches,
+                                          &state->members, &state->num_members);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to batch members "
+                                    "[%d]: %s\n", ret, sss_strerror(ret));
+        goto immediately;
+    }
+
+    /* process batches first, then each remaining member individually */
     ret = sdap_nested_group_single_step(req);
     if (ret != EAGAIN) {
         goto immediately;
@@ -1419,6 +1618,25 @@ static errno_t sdap_nested_group_single_step(struct tevent_req *req)
 
     state = tevent_req_data(req, struct sdap_nested_group_single_state);
 
+    if (state->batch_index < state->num_batches) {
+        state->current_batch = &state->batches[state->batch_index];
+        state->batch_index++;
+
+        subreq = sdap_nested_group_lookup_batch_send(state, state->ev,
+                                                     state->group_ctx,
+                                                     state->current_batch);
+        if (subreq == NULL) {
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, sdap_nested_group_single_step_done,
+                                req);
+
+        return EAGAIN;
+    }
+
+    state->current_batch = NULL;
+
     if (state->member_index >= state->num_members) {
         /* we're done */
         return EOK;
@@ -1454,6 +1672,89 @@ static errno_t sdap_nested_group_single_step(struct tevent_req *req)
     return EAGAIN;
 }
 
+static errno_t
+sdap_nested_group_single_save_user(struct sdap_nested_group_single_state *state,
+                                   struct sysdb_attrs *entry)
+{
+    errno_t ret;
+
+    /* save user in hash table */
+    ret = sdap_nested_group_hash_user(state->group_ctx, entry);
+    if (ret == EEXIST) {
+        /* the user is already present, skip it */
+        talloc_zfree(entry);
+        return EOK;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save user in hash table "
+                                    "[%d]: %s\n", ret, strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+static errno_t
+sdap_nested_group_single_save_group(struct sdap_nested_group_single_state *state,
+                                    struct sysdb_attrs *entry)
+{
+    errno_t ret;
+
+    /* save group in hash table */
+    ret = sdap_nested_group_hash_group(state->group_ctx, entry);
+    if (ret == EEXIST) {
+        /* the group is already present, skip it */
+        talloc_zfree(entry);
+        return EOK;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save group in hash table "
+                                    "[%d]: %s\n", ret, strerror(ret));
+        return ret;
+    }
+
+    /* remember the group for later processing */
+    state->nested_groups[state->num_groups] = entry;
+    state->num_groups++;
+
+    return EOK;
+}
+
+static errno_t
+sdap_nested_group_single_batch_process(struct tevent_req *subreq)
+{
+    struct sdap_nested_group_single_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct sysdb_attrs **entries = NULL;
+    size_t num_entries = 0;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_nested_group_single_state);
+
+    ret = sdap_nested_group_lookup_batch_recv(state, subreq,
+                                              &entries, &num_entries);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < num_entries; i++) {
+        if (state->current_batch->type == SDAP_NESTED_GROUP_DN_USER) {
+            ret = sdap_nested_group_single_save_user(state, entries[i]);
+        } else {
+            ret = sdap_nested_group_single_save_group(state, entries[i]);
+        }
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(entries);
+    return ret;
+}
+
 static errno_t
 sdap_nested_group_single_step_process(struct tevent_req *subreq)
 {
@@ -1467,6 +1768,10 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
     req = tevent_req_callback_data(subreq, struct tevent_req);
     state = tevent_req_data(req, struct sdap_nested_group_single_state);
 
+    if (state->current_batch != NULL) {
+        return sdap_nested_group_single_batch_process(subreq);
+    }
+
     /* set correct type if possible */
     if (state->current_member->type == SDAP_NESTED_GROUP_DN_UNKNOWN) {
         ret = sdap_nested_group_lookup_unknown_recv(state, subreq,
@@ -1495,16 +1800,8 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
             }
         }
 
-        /* save user in hash table */
-        ret = sdap_nested_group_hash_user(state->group_ctx, entry);
-        if (ret == EEXIST) {
-            /* the user is already present, skip it */
-            talloc_zfree(entry);
-            ret = EOK;
-            goto done;
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save user in hash table "
-                                        "[%d]: %s\n", ret, strerror(ret));
+        ret = sdap_nested_group_single_save_user(state, entry);
+        if (ret != EOK) {
             goto done;
         }
         break;
@@ -1538,23 +1835,10 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
             }
         }
 
-        /* save group in hash table */
-        ret = sdap_nested_group_hash_group(state->group_ctx, entry);
-        if (ret == EEXIST) {
-            /* the group is already present, skip it */
-            talloc_zfree(entry);
-            ret = EOK;
-            goto done;
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save group in hash table "
-                                        "[%d]: %s\n", ret, strerror(ret));
+        ret = sdap_nested_group_single_save_group(state, entry);
+        if (ret != EOK) {
             goto done;
         }
-
-        /* remember the group for later processing */
-        state->nested_groups[state->num_groups] = entry;
-        state->num_groups++;
-
         break;
     case SDAP_NESTED_GROUP_DN_UNKNOWN:
         /* not found in users nor nested_groups, continue */
@@ -2000,6 +2284,266 @@ static errno_t sdap_nested_group_lookup_group_recv(TALLOC_CTX *mem_ctx,
      return EOK;
 }
 
+struct sdap_nested_group_lookup_batch_state {
+    struct sdap_nested_group_ctx *group_ctx;
+    struct sdap_nested_group_batch *batch;
+    struct sysdb_attrs **entries;
+    size_t num_entries;
+};
+
+static void sdap_nested_group_lookup_batch_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sdap_nested_group_lookup_batch_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct sdap_nested_group_ctx *group_ctx,
+                                    struct sdap_nested_group_batch *batch)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct tevent_req *subreq = NULL;
+    struct sdap_attr_map *map = NULL;
+    size_t map_cnt;
+    const char **attrs = NULL;
+    const char *base_filter = NULL;
+    const char *filter = NULL;
+    const struct ldb_val *rdn_val = NULL;
+    char *oc_list;
+    char *value;
+    char *sanitized;
+    char *or_filter;
+    int i;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sdap_nested_group_lookup_batch_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->group_ctx = group_ctx;
+    state->batch = batch;
+
+    if (batch->type == SDAP_NESTED_GROUP_DN_USER) {
+        map = group_ctx->opts->user_map;
+        map_cnt = group_ctx->opts->user_map_cnt;
+
+        /* only pull down username and originalDN */
+        attrs = talloc_array(state, const char *, 3);
+        if (attrs == NULL) {
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        attrs[0] = "objectClass";
+        attrs[1] = map[SDAP_AT_USER_NAME].name;
+        attrs[2] = NULL;
+
+        base_filter = talloc_asprintf(state, "(objectclass=%s)",
+                                      map[SDAP_OC_USER].name);
+    } else {
+        map = group_ctx->opts->group_map;
+        map_cnt = SDAP_OPTS_GROUP;
+
+        ret = build_attrs_from_map(state, map, map_cnt, NULL, &attrs, NULL);
+        if (ret != EOK) {
+            goto immediately;
+        }
+
+        oc_list = sdap_make_oc_list(state, map);
+        if (oc_list == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to create objectClass list.\n");
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        base_filter = talloc_asprintf(state, "(&(%s)(%s=*))", oc_list,
+                                      map[SDAP_AT_GROUP_NAME].name);
+    }
+    if (base_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    /* match all members by their RDN value */
+    or_filter = talloc_strdup(state, "(|");
+    if (or_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    for (i = 0; i < batch->num_members; i++) {
+        rdn_val = ldb_dn_get_rdn_val(batch->member_dns[i]);
+        if (rdn_val == NULL) {
+            ret = EINVAL;
+            goto immediately;
+        }
+
+        value = talloc_strndup(state, (const char *)rdn_val->data,
+                               rdn_val->length);
+        if (value == NULL) {
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        ret = sss_filter_sanitize(state, value, &sanitized);
+        if (ret != EOK) {
+            goto immediately;
+        }
+
+        or_filter = talloc_asprintf_append_buffer(or_filter, "(%s=%s)",
+                                                  batch->rdn_attr, sanitized);
+        if (or_filter == NULL) {
+            ret = ENOMEM;
+            goto immediately;
+        }
+    }
+
+    base_filter = talloc_asprintf(state, "(&%s%s))", base_filter, or_filter);
+    if (base_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    /* use search base filter if needed */
+    filter = sdap_combine_filters(state, base_filter, batch->filter);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Looking up %d members under [%s]\n",
+          batch->num_members, ldb_dn_get_linearized(batch->parent_dn));
+
+    /* search */
+    subreq = sdap_get_generic_send(state, ev, group_ctx->opts, group_ctx->sh,
+                                   ldb_dn_get_linearized(batch->parent_dn),
+                                   LDAP_SCOPE_ONELEVEL, filter, attrs,
+                                   map, map_cnt,
+                                   dp_opt_get_int(group_ctx->opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   false);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    tevent_req_set_callback(subreq, sdap_nested_group_lookup_batch_done, req);
+
+    return req;
+
+immediately:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void sdap_nested_group_lookup_batch_done(struct tevent_req *subreq)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct ldb_context *ldb = NULL;
+    struct sysdb_attrs **entries = NULL;
+    struct ldb_dn *dn = NULL;
+    const char *orig_dn = NULL;
+    bool *matched = NULL;
+    size_t count = 0;
+    size_t i;
+    int j;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_nested_group_lookup_batch_state);
+
+    ret = sdap_get_generic_recv(subreq, state, &count, &entries);
+    talloc_zfree(subreq);
+    if (ret == ENOENT) {
+        count = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    state->entries = talloc_zero_array(state, struct sysdb_attrs *,
+                                       state->batch->num_members);
+    matched = talloc_zero_array(state, bool, state->batch->num_members);
+    if (state->entries == NULL || matched == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* the filter matches RDN values only, keep entries whose DN is
+     * really one of the members */
+    ldb = sysdb_ctx_get_ldb(state->group_ctx->domain->sysdb);
+    for (i = 0; i < count; i++) {
+        ret = sysdb_attrs_get_string(entries[i], SYSDB_ORIG_DN, &orig_dn);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Entry without original DN, "
+                  "skipping\n");
+            continue;
+        }
+
+        dn = ldb_dn_new(matched, ldb, orig_dn);
+        if (dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (j = 0; j < state->batch->num_members; j++) {
+            if (!matched[j]
+                    && ldb_dn_compare(dn, state->batch->member_dns[j]) == 0) {
+                matched[j] = true;
+                state->entries[state->num_entries] =
+                                    talloc_steal(state->entries, entries[i]);
+                state->num_entries++;
+                break;
+            }
+        }
+        talloc_free(dn);
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu of %d members\n",
+          state->num_entries, state->batch->num_members);
+
+    ret = EOK;
+
+done:
+    talloc_free(matched);
+    talloc_free(entries);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t sdap_nested_group_lookup_batch_recv(TALLOC_CTX *mem_ctx,
+                                                   struct tevent_req *req,
+                                                   struct sysdb_attrs ***_entries,
+                                                   size_t *_num_entries)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    state = tevent_req_data(req, struct sdap_nested_group_lookup_batch_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_entries != NULL) {
+        *_entries = talloc_steal(mem_ctx, state->entries);
+    }
+
+    if (_num_entries != NULL) {
+        *_num_entries = state->num_entries;
+    }
+
+    return EOK;
+}
+
 struct sdap_nested_group_lookup_unknown_state {
     struct tevent_context *ev;
     struct sdap_nested_group_ctx *group_ctx;
@@ -61,6 +61,10 @@ int sdap_op_add(TALLOC_CTX *memctx, struct tevent_context *ev,
                 sdap_op_callback_t *callback, void *data,
                 int timeout, struct sdap_op **_op);
 
+/* Release the reply the operation callback was called with and schedule
+ * the processing of the next queued one */
+void sdap_unlock_next_reply(struct sdap_op *op);
+
 struct tevent_req *sdap_get_rootdse_send(TALLOC_CTX *memctx,
                                          struct tevent_context *ev,
                                          struct sdap_options *opts,
@@ -168,14 +168,18 @@ static int sdap_user_set_mpg(struct sysdb_attrs *user_attrs,
     return EOK;
 }
 
-/* FIXME: support storing additional attributes */
-int sdap_save_user(TALLOC_CTX *memctx,
-                   struct sdap_options *opts,
-                   struct sss_domain_info *dom,
-                   struct sysdb_attrs *attrs,
-                   struct sysdb_attrs *mapped_attrs,
-                   char **_usn_value,
-                   time_t now)
+/* Converts the LDAP attributes of a user into the arguments of
+ * sysdb_store_user(). The strings in _entry are allocated on memctx or
+ * point into attrs. The user might belong to a subdomain of dom, the
+ * domain it has to be stored in is returned in _dom. _dom is set to NULL
+ * if the user should not be stored at all. */
+static int sdap_save_user_prepare(TALLOC_CTX *memctx,
+                                  struct sdap_options *opts,
+                                  struct sss_domain_info *dom,
+                                  struct sysdb_attrs *attrs,
+                                  struct sss_domain_info **_dom,
+                                  struct sysdb_store_user_entry *_entry,
+                                  char **_usn_value)
 {
     struct ldb_message_element *el;
     int ret;
@@ -191,7 +195,6 @@ int sdap_save_user(TALLOC_CTX *memctx,
     struct sysdb_attrs *user_attrs;
     char *upn = NULL;
     size_t i;
-    int cache_timeout;
     char *usn_value = NULL;
     char **missing = NULL;
     TALLOC_CTX *tmpctx = NULL;
@@ -206,13 +209,15 @@ int sdap_save_user(TALLOC_CTX *memctx,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Save user\n");
 
+    *_dom = NULL;
+
     tmpctx = talloc_new(NULL);
     if (!tmpctx) {
         ret = ENOMEM;
         goto done;
     }
 
-    user_attrs = sysdb_new_attrs(tmpctx);
+    user_attrs = sysdb_new_attrs(memctx);
     if (user_attrs == NULL) {
         ret = ENOMEM;
         goto done;
@@ -598,8 +603,6 @@ int sdap_save_user(TALLOC_CTX *memctx,
         }
     }
 
-    cache_timeout = dom->user_timeout;
-
     ret = sdap_save_all_names(user_name, attrs, dom,
                               SYSDB_MEMBER_USER, user_attrs);
     if (ret != EOK) {
@@ -616,23 +619,22 @@ int sdap_save_user(TALLOC_CTX *memctx,
         goto done;
     }
 
-    DEBUG(SSSDBG_TRACE_FUNC, "Storing info for user %s\n", user_name);
-
-    ret = sysdb_store_user(dom, user_name, pwd, uid, gid,
-                           gecos, homedir, shell, orig_dn,
-                           user_attrs, missing, cache_timeout, now);
-    if (ret) goto done;
-
-    if (mapped_attrs != NULL) {
-        ret = sysdb_set_user_attr(dom, user_name, mapped_attrs, SYSDB_MOD_ADD);
-        if (ret) return ret;
-    }
+    _entry->name = user_name;
+    _entry->pwd = pwd;
+    _entry->uid = uid;
+    _entry->gid = gid;
+    _entry->gecos = gecos;
+    _entry->homedir = homedir;
+    _entry->shell = shell;
+    _entry->orig_dn = orig_dn;
+    _entry->attrs = user_attrs;
+    _entry->remove_attrs = missing;
+    *_dom = dom;
 
     if (_usn_value) {
         *_usn_value = talloc_steal(memctx, usn_value);
     }
 
-    talloc_steal(memctx, user_attrs);
     ret = EOK;
 
 done:
@@ -645,6 +647,58 @@ done:
     return ret;
 }
 
+/* FIXME: support storing additional attributes */
+int sdap_save_user(TALLOC_CTX *memctx,
+                   struct sdap_options *opts,
+                   struct sss_domain_info *dom,
+                   struct sysdb_attrs *attrs,
+                   struct sysdb_attrs *mapped_attrs,
+                   char **_usn_value,
+                   time_t now)
+{
+    TALLOC_CTX *tmpctx;
+    struct sysdb_store_user_entry user;
+    struct sss_domain_info *user_dom;
+    char *usn_value = NULL;
+    int ret;
+
+    tmpctx = talloc_new(NULL);
+    if (tmpctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sdap_save_user_prepare(tmpctx, opts, dom, attrs, &user_dom, &user,
+                                 &usn_value);
+    if (ret != EOK || user_dom == NULL) {
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Storing info for user %s\n", user.name);
+
+    ret = sysdb_store_user(user_dom, user.name, user.pwd, user.uid, user.gid,
+                           user.gecos, user.homedir, user.shell, user.orig_dn,
+                           user.attrs, user.remove_attrs,
+                           user_dom->user_timeout, now);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to save user [%s]\n", user.name);
+        goto done;
+    }
+
+    if (mapped_attrs != NULL) {
+        ret = sysdb_set_user_attr(user_dom, user.name, mapped_attrs,
+                                  SYSDB_MOD_ADD);
+        if (ret) goto done;
+    }
+
+    if (_usn_value) {
+        *_usn_value = talloc_steal(memctx, usn_value);
+    }
+
+done:
+    talloc_free(tmpctx);
+    return ret;
+}
+
 
 /* ==Generic-Function-to-save-multiple-users============================= */
 
@@ -658,8 +712,17 @@ int sdap_save_users(TALLOC_CTX *memctx,
                     char **_usn_value)
 {
     TALLOC_CTX *tmpctx;
+    struct sysdb_store_user_entry *entries;
+    struct sysdb_store_user_entry *batch;
+    struct sss_domain_info **entry_doms;
+    struct sss_domain_info *store_dom;
     char *higher_usn = NULL;
     char *usn_value;
+    size_t count = 0;
+    size_t batch_count;
+    size_t failed;
+    size_t j;
+    size_t k;
     int ret;
     errno_t sret;
     int i;
@@ -676,6 +739,17 @@ int sdap_save_users(TALLOC_CTX *memctx,
         return ENOMEM;
     }
 
+    entries = talloc_zero_array(tmpctx, struct sysdb_store_user_entry,
+                                num_users);
+    batch = talloc_zero_array(tmpctx, struct sysdb_store_user_entry,
+                              num_users);
+    entry_doms = talloc_zero_array(tmpctx, struct sss_domain_info *,
+                                   num_users);
+    if (entries == NULL || batch == NULL || entry_doms == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     ret = sysdb_transaction_start(sysdb);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
@@ -695,8 +769,9 @@ int sdap_save_users(TALLOC_CTX *memctx,
     for (i = 0; i < num_users; i++) {
         usn_value = NULL;
 
-        ret = sdap_save_user(tmpctx, opts, dom, users[i], mapped_attrs,
-                             &usn_value, now);
+        ret = sdap_save_user_prepare(tmpctx, opts, dom, users[i],
+                                     &entry_doms[count], &entries[count],
+                                     &usn_value);
 
         /* Do not fail completely on errors.
          * Just report the failure to save and go on */
@@ -704,6 +779,9 @@ int sdap_save_users(TALLOC_CTX *memctx,
             DEBUG(SSSDBG_OP_FAILURE, "Failed to store user %d. Ignoring.\n", i);
         } else {
             DEBUG(SSSDBG_TRACE_ALL, "User %d processed!\n", i);
+            if (entry_doms[count] != NULL) {
+                count++;
+            }
         }
 
         if (usn_value) {
@@ -721,6 +799,49 @@ int sdap_save_users(TALLOC_CTX *memctx,
         }
     }
 
+    /* Users whose SID belongs to a subdomain are stored in that domain, so
+     * the users are stored in one batch per domain. */
+    for (j = 0; j < count; j++) {
+        store_dom = entry_doms[j];
+        if (store_dom == NULL) {
+            continue;
+        }
+
+        batch_count = 0;
+        for (k = j; k < count; k++) {
+            if (entry_doms[k] == store_dom) {
+                batch[batch_count++] = entries[k];
+                entry_doms[k] = NULL;
+            }
+        }
+
+        ret = sysdb_store_users(store_dom, batch, batch_count,
+                                store_dom->user_timeout, now, &failed);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store users of domain %s "
+                  "[%d]: %s\n", store_dom->name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        if (failed != 0) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to store %zu users of domain %s. "
+                  "Ignoring.\n", failed, store_dom->name);
+        }
+
+        if (mapped_attrs == NULL) {
+            continue;
+        }
+
+        for (k = 0; k < batch_count; k++) {
+            ret = sysdb_set_user_attr(store_dom, batch[k].name, mapped_attrs,
+                                      SYSDB_MOD_ADD);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Failed to add mapped attributes to "
+                      "user %s. Ignoring.\n", batch[k].name);
+            }
+        }
+    }
+
     ret = sysdb_transaction_commit(sysdb);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction!\n");
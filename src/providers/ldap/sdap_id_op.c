@@ -26,14 +26,18 @@
 #include "providers/ldap/sdap_async.h"
 #include "providers/ldap/sdap_id_op.h"
 
+/* upper bound of ldap_connection_pool_size */
+#define SDAP_ID_CONN_POOL_MAX 16
+
 /* LDAP async connection cache */
 struct sdap_id_conn_cache {
     struct sdap_id_conn_ctx *id_conn;
 
     /* list of all open connections */
     struct sdap_id_conn_data *connections;
-    /* cached (current) connection */
-    struct sdap_id_conn_data *cached_connection;
+    /* cached (current) connections, the pool is filled on demand
+     * up to ldap_connection_pool_size connections */
+    struct sdap_id_conn_data *cached_connections[SDAP_ID_CONN_POOL_MAX];
 };
 
 /* LDAP async operation tracker:
@@ -76,11 +80,19 @@ struct sdap_id_conn_data {
      * connection will be disconnected and should
      * not be used any more */
     bool disconnecting;
+    /* number of operations currently using the connection */
+    int num_ops;
+    /* the highest num_ops seen */
+    int max_ops;
+    /* number of operations that used the connection */
+    uint64_t total_ops;
 };
 
 static void sdap_id_conn_cache_be_offline_cb(void *pvt);
 static void sdap_id_conn_cache_fo_reconnect_cb(void *pvt);
 
+static int sdap_id_conn_cache_slot(struct sdap_id_conn_data *conn_data);
+static void sdap_id_conn_cache_drop(struct sdap_id_conn_data *conn_data);
 static void sdap_id_release_conn_data(struct sdap_id_conn_data *conn_data);
 static int sdap_id_conn_data_destroy(struct sdap_id_conn_data *conn_data);
 static bool sdap_is_connection_expired(struct sdap_id_conn_data *conn_data, int timeout);
@@ -140,16 +152,103 @@ fail:
     return ret;
 }
 
+/* Number of connections the cache may keep open */
+static int sdap_id_conn_cache_pool_size(struct sdap_id_conn_cache *conn_cache)
+{
+    int pool_size;
+
+    pool_size = dp_opt_get_int(conn_cache->id_conn->id_ctx->opts->basic,
+                               SDAP_CONNECTION_POOL_SIZE);
+    if (pool_size < 1) {
+        pool_size = 1;
+    } else if (pool_size > SDAP_ID_CONN_POOL_MAX) {
+        pool_size = SDAP_ID_CONN_POOL_MAX;
+    }
+
+    return pool_size;
+}
+
+/* Get the pool slot of a cached connection, -1 if it is not cached */
+static int sdap_id_conn_cache_slot(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int i;
+
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        if (conn_cache->cached_connections[i] == conn_data) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Remove connection from the pool so it is not used for new operations */
+static void sdap_id_conn_cache_drop(struct sdap_id_conn_data *conn_data)
+{
+    int slot;
+
+    slot = sdap_id_conn_cache_slot(conn_data);
+    if (slot >= 0) {
+        conn_data->conn_cache->cached_connections[slot] = NULL;
+    }
+}
+
+/* Put connection into a free pool slot, returns false if the pool is full */
+static bool sdap_id_conn_cache_add(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int pool_size;
+    int i;
+
+    if (sdap_id_conn_cache_slot(conn_data) >= 0) {
+        return true;
+    }
+
+    pool_size = sdap_id_conn_cache_pool_size(conn_cache);
+    for (i = 0; i < pool_size; i++) {
+        if (conn_cache->cached_connections[i] == NULL) {
+            conn_cache->cached_connections[i] = conn_data;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Number of usable connections in the pool, exclude is not counted */
+static int sdap_id_conn_cache_num_usable(struct sdap_id_conn_cache *conn_cache,
+                                         struct sdap_id_conn_data *exclude)
+{
+    struct sdap_id_conn_data *conn_data;
+    int count = 0;
+    int i;
+
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        conn_data = conn_cache->cached_connections[i];
+        if (conn_data != NULL && conn_data != exclude
+                && sdap_can_reuse_connection(conn_data)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 /* Callback on BE going offline */
 static void sdap_id_conn_cache_be_offline_cb(void *pvt)
 {
     struct sdap_id_conn_cache *conn_cache = talloc_get_type(pvt, struct sdap_id_conn_cache);
-    struct sdap_id_conn_data *cached_connection = conn_cache->cached_connection;
+    struct sdap_id_conn_data *cached_connection;
+    int i;
 
     /* Release any cached connection on going offline */
-    if (cached_connection != NULL) {
-        conn_cache->cached_connection = NULL;
-        sdap_id_release_conn_data(cached_connection);
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        cached_connection = conn_cache->cached_connections[i];
+        if (cached_connection != NULL) {
+            conn_cache->cached_connections[i] = NULL;
+            sdap_id_release_conn_data(cached_connection);
+        }
     }
 }
 
@@ -157,11 +256,13 @@ static void sdap_id_conn_cache_be_offline_cb(void *pvt)
 static void sdap_id_conn_cache_fo_reconnect_cb(void *pvt)
 {
     struct sdap_id_conn_cache *conn_cache = talloc_get_type(pvt, struct sdap_id_conn_cache);
-    struct sdap_id_conn_data *cached_connection = conn_cache->cached_connection;
+    int i;
 
     /* Release any cached connection on going offline */
-    if (cached_connection != NULL) {
-        cached_connection->disconnecting = true;
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        if (conn_cache->cached_connections[i] != NULL) {
+            conn_cache->cached_connections[i]->disconnecting = true;
+        }
     }
 }
 
@@ -175,11 +276,13 @@ static void sdap_id_release_conn_data(struct sdap_id_conn_data *conn_data)
     }
 
     conn_cache = conn_data->conn_cache;
-    if (conn_data == conn_cache->cached_connection) {
+    if (sdap_id_conn_cache_slot(conn_data) >= 0) {
         return;
     }
 
-    DEBUG(SSSDBG_TRACE_ALL, "releasing unused connection\n");
+    DEBUG(SSSDBG_TRACE_FUNC, "releasing unused connection, it served "
+          "%"PRIu64" operations, at most %d at once\n",
+          conn_data->total_ops, conn_data->max_ops);
 
     DLIST_REMOVE(conn_cache->connections, conn_data);
     talloc_zfree(conn_data);
@@ -190,6 +293,9 @@ static int sdap_id_conn_data_destroy(struct sdap_id_conn_data *conn_data)
 {
     struct sdap_id_op *op;
 
+    /* make sure the pool does not point to freed connection */
+    sdap_id_conn_cache_drop(conn_data);
+
     /* we clean out list of ops to make sure that order of destruction does not matter */
     while ((op = conn_data->ops) != NULL) {
         op->conn_data = NULL;
@@ -275,13 +381,12 @@ static void sdap_id_conn_data_expire_handler(struct tevent_context *ev,
 {
     struct sdap_id_conn_data *conn_data = talloc_get_type(pvt,
                                                           struct sdap_id_conn_data);
-    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
 
     DEBUG(SSSDBG_MINOR_FAILURE,
           "connection is about to expire, releasing it\n");
 
-    if (conn_cache->cached_connection == conn_data) {
-        conn_cache->cached_connection = NULL;
+    if (sdap_id_conn_cache_slot(conn_data) >= 0) {
+        sdap_id_conn_cache_drop(conn_data);
 
         sdap_id_release_conn_data(conn_data);
     }
@@ -316,12 +421,18 @@ static void sdap_id_op_hook_conn_data(struct sdap_id_op *op, struct sdap_id_conn
 
     if (current) {
         DLIST_REMOVE(current->ops, op);
+        current->num_ops--;
     }
 
     op->conn_data = conn_data;
 
     if (conn_data) {
         DLIST_ADD_END(conn_data->ops, op, struct sdap_id_op*);
+        conn_data->num_ops++;
+        conn_data->total_ops++;
+        if (conn_data->num_ops > conn_data->max_ops) {
+            conn_data->max_ops = conn_data->num_ops;
+        }
     }
 
     if (current) {
@@ -458,26 +569,50 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
 
     int ret = EOK;
     struct sdap_id_conn_data *conn_data;
+    struct sdap_id_conn_data *best = NULL;
     struct tevent_req *subreq = NULL;
+    int pool_size;
+    int free_slot = -1;
+    int i;
+
+    /* Try to reuse context cached connection, the one with the least
+     * operations in progress is preferred */
+    pool_size = sdap_id_conn_cache_pool_size(conn_cache);
+    for (i = 0; i < pool_size; i++) {
+        conn_data = conn_cache->cached_connections[i];
+        if (conn_data == NULL) {
+            if (free_slot == -1) {
+                free_slot = i;
+            }
+            continue;
+        }
 
-    /* Try to reuse context cached connection */
-    conn_data = conn_cache->cached_connection;
-    if (conn_data) {
-        if (conn_data->connect_req) {
-            DEBUG(SSSDBG_TRACE_ALL, "waiting for connection to complete\n");
-            sdap_id_op_hook_conn_data(op, conn_data);
-            goto done;
+        if (!conn_data->connect_req && !sdap_can_reuse_connection(conn_data)) {
+            DEBUG(SSSDBG_TRACE_ALL, "releasing expired cached connection\n");
+            conn_cache->cached_connections[i] = NULL;
+            sdap_id_release_conn_data(conn_data);
+            if (free_slot == -1) {
+                free_slot = i;
+            }
+            continue;
         }
 
-        if (sdap_can_reuse_connection(conn_data)) {
-            DEBUG(SSSDBG_TRACE_ALL, "reusing cached connection\n");
-            sdap_id_op_hook_conn_data(op, conn_data);
-            goto done;
+        if (best == NULL || conn_data->num_ops < best->num_ops) {
+            best = conn_data;
         }
+    }
 
-        DEBUG(SSSDBG_TRACE_ALL, "releasing expired cached connection\n");
-        conn_cache->cached_connection = NULL;
-        sdap_id_release_conn_data(conn_data);
+    /* Open another connection only if all cached ones are busy */
+    if (best != NULL && (best->num_ops == 0 || free_slot == -1)) {
+        if (best->connect_req) {
+            DEBUG(SSSDBG_TRACE_ALL, "waiting for connection to complete\n");
+        } else {
+            DEBUG(SSSDBG_TRACE_ALL, "reusing cached connection with "
+                  "%d operations in progress\n", best->num_ops);
+        }
+        sdap_id_op_hook_conn_data(op, best);
+        conn_data = NULL;
+        goto done;
     }
 
     DEBUG(SSSDBG_TRACE_ALL, "beginning to connect\n");
@@ -506,7 +641,7 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
     conn_data->connect_req = subreq;
 
     DLIST_ADD(conn_cache->connections, conn_data);
-    conn_cache->cached_connection = conn_data;
+    conn_cache->cached_connections[free_slot] = conn_data;
 
     sdap_id_op_hook_conn_data(op, conn_data);
 
@@ -536,6 +671,7 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
     bool is_offline = false;
     struct tevent_req *reinit_req = NULL;
     bool reinit = false;
+    int num_usable;
     int ret;
 
     ret = sdap_cli_connect_recv(subreq, conn_data, &can_retry,
@@ -656,9 +792,7 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
             bool retry = false;
 
             /* drop connection from cache now */
-            if (conn_cache->cached_connection == conn_data) {
-                conn_cache->cached_connection = NULL;
-            }
+            sdap_id_conn_cache_drop(conn_data);
 
             if (can_retry) {
                 /* determining whether retry is possible */
@@ -718,19 +852,23 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
 
     if ((ret == EOK) &&
         conn_data->sh->connected &&
-        !be_is_offline(conn_cache->id_conn->id_ctx->be)) {
-        DEBUG(SSSDBG_TRACE_ALL,
-              "caching successful connection after %d notifies\n", notify_count);
-        conn_cache->cached_connection = conn_data;
-
-        /* Run any post-connection routines */
-        be_run_unconditional_online_cb(conn_cache->id_conn->id_ctx->be);
-        be_run_online_cb(conn_cache->id_conn->id_ctx->be);
+        !be_is_offline(conn_cache->id_conn->id_ctx->be) &&
+        sdap_id_conn_cache_add(conn_data)) {
+        num_usable = sdap_id_conn_cache_num_usable(conn_cache, conn_data);
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "caching successful connection after %d notifies, the pool "
+              "now has %d of at most %d usable connections\n", notify_count,
+              num_usable + 1, sdap_id_conn_cache_pool_size(conn_cache));
+
+        /* Run any post-connection routines, but only for the first usable
+         * connection and not when the pool just grows */
+        if (num_usable == 0) {
+            be_run_unconditional_online_cb(conn_cache->id_conn->id_ctx->be);
+            be_run_online_cb(conn_cache->id_conn->id_ctx->be);
+        }
 
     } else {
-        if (conn_cache->cached_connection == conn_data) {
-            conn_cache->cached_connection = NULL;
-        }
+        sdap_id_conn_cache_drop(conn_data);
 
         sdap_id_release_conn_data(conn_data);
     }
@@ -820,6 +958,7 @@ int sdap_id_op_done(struct sdap_id_op *op, int retval, int *dp_err_out)
 {
     bool communication_error;
     struct sdap_id_conn_data *current_conn = op->conn_data;
+    int i;
     switch (retval) {
         case EIO:
         case ETIMEDOUT:
@@ -833,9 +972,16 @@ int sdap_id_op_done(struct sdap_id_op *op, int retval, int *dp_err_out)
     }
 
     if (communication_error && current_conn != 0
-            && current_conn == op->conn_cache->cached_connection) {
+            && sdap_id_conn_cache_slot(current_conn) >= 0) {
         /* do not reuse failed connection */
-        op->conn_cache->cached_connection = NULL;
+        sdap_id_conn_cache_drop(current_conn);
+
+        /* the rest of the pool is connected to the same server */
+        for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+            if (op->conn_cache->cached_connections[i] != NULL) {
+                op->conn_cache->cached_connections[i]->disconnecting = true;
+            }
+        }
 
         DEBUG(SSSDBG_FUNC_DATA,
               "communication error on cached connection, moving to next server\n");
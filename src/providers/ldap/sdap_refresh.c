@@ -23,6 +23,7 @@
 
 #include "providers/ldap/sdap.h"
 #include "providers/ldap/ldap_common.h"
+#include "providers/ldap/sdap_sync.h"
 
 struct sdap_refresh_state {
     struct tevent_context *ev;
@@ -258,24 +259,36 @@ static errno_t sdap_refresh_netgroups_recv(struct tevent_req *req)
 errno_t sdap_refresh_init(struct be_refresh_ctx *refresh_ctx,
                           struct sdap_id_ctx *id_ctx)
 {
+    enum sdap_change_stream stream;
     errno_t ret;
 
-    ret = be_refresh_add_cb(refresh_ctx, BE_REFRESH_TYPE_USERS,
-                            sdap_refresh_users_send,
-                            sdap_refresh_users_recv,
-                            id_ctx);
-    if (ret != EOK && ret != EEXIST) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "Periodical refresh of users "
-              "will not work [%d]: %s\n", ret, strerror(ret));
+    ret = sdap_change_stream_get(id_ctx->opts, id_ctx->opts->sdom, &stream);
+    if (ret != EOK) {
+        return ret;
     }
 
-    ret = be_refresh_add_cb(refresh_ctx, BE_REFRESH_TYPE_GROUPS,
-                            sdap_refresh_groups_send,
-                            sdap_refresh_groups_recv,
-                            id_ctx);
-    if (ret != EOK && ret != EEXIST) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "Periodical refresh of groups "
-              "will not work [%d]: %s\n", ret, strerror(ret));
+    if (stream != SDAP_CHANGE_STREAM_NONE) {
+        /* users and groups are kept up to date by the change stream */
+        DEBUG(SSSDBG_TRACE_FUNC, "Change stream enabled, users and groups "
+              "are not refreshed periodically\n");
+    } else {
+        ret = be_refresh_add_cb(refresh_ctx, BE_REFRESH_TYPE_USERS,
+                                sdap_refresh_users_send,
+                                sdap_refresh_users_recv,
+                                id_ctx);
+        if (ret != EOK && ret != EEXIST) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Periodical refresh of users "
+                  "will not work [%d]: %s\n", ret, strerror(ret));
+        }
+
+        ret = be_refresh_add_cb(refresh_ctx, BE_REFRESH_TYPE_GROUPS,
+                                sdap_refresh_groups_send,
+                                sdap_refresh_groups_recv,
+                                id_ctx);
+        if (ret != EOK && ret != EEXIST) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Periodical refresh of groups "
+                  "will not work [%d]: %s\n", ret, strerror(ret));
+        }
     }
 
     ret = be_refresh_add_cb(refresh_ctx, BE_REFRESH_TYPE_NETGROUPS,
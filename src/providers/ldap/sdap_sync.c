@@ -0,0 +1,1924 @@
+/*
+    SSSD
+
+    LDAP change stream (syncrepl / DirSync)
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The change stream keeps a long running search open against the server
+ * (syncrepl refreshAndPersist) or polls it with the Active Directory
+ * DirSync control. Changed objects are not stored directly, they are
+ * queued and refreshed one by one with the regular user and group lookup
+ * code so that all the usual processing (ID mapping, nesting, memberships)
+ * applies. Deleted objects are removed from the cache by their UUID.
+ *
+ * The server cookie is stored in the domain entry of the cache only after
+ * all the changes it covers were applied, so a restart of the back end
+ * continues where it stopped. */
+
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/sss_ldap.h"
+#include "util/sss_ptr_hash.h"
+#include "util/crypto/sss_crypto.h"
+#include "db/sysdb.h"
+#include "providers/ldap/ldap_common.h"
+#include "providers/ldap/sdap_async_private.h"
+#include "providers/ldap/sdap_sync.h"
+
+#ifndef LDAP_CONTROL_SYNC
+#define LDAP_CONTROL_SYNC           "1.3.6.1.4.1.4203.1.9.1.1"
+#define LDAP_CONTROL_SYNC_STATE     "1.3.6.1.4.1.4203.1.9.1.2"
+#define LDAP_CONTROL_SYNC_DONE      "1.3.6.1.4.1.4203.1.9.1.3"
+#define LDAP_SYNC_INFO              "1.3.6.1.4.1.4203.1.9.1.4"
+#endif /* LDAP_CONTROL_SYNC */
+
+#ifndef LDAP_SYNC_REFRESH_AND_PERSIST
+#define LDAP_SYNC_REFRESH_AND_PERSIST   3
+#endif /* LDAP_SYNC_REFRESH_AND_PERSIST */
+
+#ifndef LDAP_SYNC_PRESENT
+#define LDAP_SYNC_PRESENT           0
+#define LDAP_SYNC_ADD               1
+#define LDAP_SYNC_MODIFY            2
+#define LDAP_SYNC_DELETE            3
+#endif /* LDAP_SYNC_PRESENT */
+
+#ifndef LDAP_TAG_SYNC_NEW_COOKIE
+#define LDAP_TAG_SYNC_NEW_COOKIE        ((ber_tag_t) 0x80U)
+#define LDAP_TAG_SYNC_REFRESH_DELETE    ((ber_tag_t) 0xa1U)
+#define LDAP_TAG_SYNC_REFRESH_PRESENT   ((ber_tag_t) 0xa2U)
+#define LDAP_TAG_SYNC_ID_SET            ((ber_tag_t) 0xa3U)
+#define LDAP_TAG_SYNC_COOKIE            ((ber_tag_t) 0x04U)
+#define LDAP_TAG_REFRESHDELETES         ((ber_tag_t) 0x01U)
+#define LDAP_TAG_REFRESHDONE            ((ber_tag_t) 0x01U)
+#endif /* LDAP_TAG_SYNC_NEW_COOKIE */
+
+#ifndef LDAP_SYNC_REFRESH_REQUIRED
+#define LDAP_SYNC_REFRESH_REQUIRED  0x1000
+#endif /* LDAP_SYNC_REFRESH_REQUIRED */
+
+/* With more pending lookups than this an enumerating domain is refreshed
+ * with a single enumeration instead of one lookup per object */
+#define SDAP_SYNC_MAX_LOOKUPS 1000
+
+#define SDAP_SYNC_DEFAULT_INTERVAL 60
+
+#define SDAP_SYNC_IS_DELETED "isDeleted"
+
+enum sdap_sync_change_type {
+    SDAP_SYNC_USER,
+    SDAP_SYNC_GROUP,
+    SDAP_SYNC_DELETE
+};
+
+struct sdap_sync_change {
+    struct sdap_sync_change *prev;
+    struct sdap_sync_change *next;
+
+    enum sdap_sync_change_type type;
+    char *value;
+};
+
+struct sdap_sync_ctx {
+    struct tevent_context *ev;
+    struct sdap_id_ctx *id_ctx;
+    struct sdap_domain *sdom;
+    struct sss_domain_info *dom;
+
+    enum sdap_change_stream mode;
+    time_t interval;
+    const char *filter;
+    const char **attrs;
+
+    /* the running search */
+    bool running;
+    struct sdap_id_op *op;
+    struct sdap_op *sop;
+    struct tevent_timer *start_te;
+
+    /* DirSync entries which did not carry enough attributes to classify
+     * them, they are read with a base search once the poll finished */
+    char **resolve;
+    size_t num_resolve;
+    size_t resolve_idx;
+    struct berval dirsync_cookie;
+    bool dirsync_more;
+
+    /* changes waiting to be applied, the hash avoids duplicates */
+    struct sdap_sync_change *changes;
+    hash_table_t *queued;
+    size_t num_queued;
+    struct tevent_req *apply_req;
+    enum sdap_sync_change_type apply_type;
+    bool full_refresh;
+    bool apply_failed;
+    struct tevent_timer *rewind_te;
+
+    /* the enumeration of the provider, used for full refreshes */
+    be_ptask_send_t enum_send;
+    be_ptask_recv_t enum_recv;
+    struct ldap_enum_ctx *enum_ctx;
+
+    /* base64 encoded server cookie */
+    char *cookie;
+    bool cookie_dirty;
+
+    struct {
+        uint64_t received;
+        uint64_t applied;
+        uint64_t deleted;
+        uint64_t full_refreshes;
+    } stats;
+};
+
+static void sdap_sync_start(struct sdap_sync_ctx *sctx);
+static void sdap_sync_apply_next(struct sdap_sync_ctx *sctx);
+
+/* The base all user and group searches of the domain have in common.
+ * Returns ENOTSUP if they use different bases or scopes, a single
+ * syncrepl search would then follow the wrong set of objects. */
+static errno_t sdap_sync_search_base(struct sdap_domain *sdom,
+                                     const char **_base,
+                                     int *_scope)
+{
+    struct sdap_search_base **lists[2];
+    struct sdap_search_base **bases;
+    const char *base = NULL;
+    int scope = LDAP_SCOPE_SUBTREE;
+    int l;
+    int i;
+
+    lists[0] = sdom->user_search_bases != NULL ? sdom->user_search_bases
+                                               : sdom->search_bases;
+    lists[1] = sdom->group_search_bases != NULL ? sdom->group_search_bases
+                                                : sdom->search_bases;
+
+    for (l = 0; l < 2; l++) {
+        bases = lists[l];
+        for (i = 0; bases != NULL && bases[i] != NULL; i++) {
+            if (base == NULL) {
+                base = bases[i]->basedn;
+                scope = bases[i]->scope;
+                continue;
+            }
+
+            if (strcasecmp(base, bases[i]->basedn) != 0
+                    || scope != bases[i]->scope) {
+                return ENOTSUP;
+            }
+        }
+    }
+
+    if (base == NULL) {
+        base = sdom->basedn;
+    }
+
+    *_base = base;
+    *_scope = scope;
+    return EOK;
+}
+
+errno_t sdap_change_stream_get(struct sdap_options *opts,
+                               struct sdap_domain *sdom,
+                               enum sdap_change_stream *_mode)
+{
+    const char *base;
+    const char *str;
+    int scope;
+    errno_t ret;
+
+    str = dp_opt_get_string(opts->basic, SDAP_CHANGE_STREAM);
+    if (str == NULL || strcasecmp(str, "none") == 0) {
+        *_mode = SDAP_CHANGE_STREAM_NONE;
+    } else if (strcasecmp(str, "syncrepl") == 0) {
+        *_mode = SDAP_CHANGE_STREAM_SYNCREPL;
+    } else if (strcasecmp(str, "dirsync") == 0) {
+        *_mode = SDAP_CHANGE_STREAM_DIRSYNC;
+    } else {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unsupported value [%s] of ldap_change_stream\n", str);
+        return EINVAL;
+    }
+
+    /* DirSync always reads the whole naming context */
+    if (*_mode == SDAP_CHANGE_STREAM_SYNCREPL) {
+        ret = sdap_sync_search_base(sdom, &base, &scope);
+        if (ret == ENOTSUP) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "syncrepl needs the same single search base for users "
+                  "and groups, the change stream of %s is disabled\n",
+                  sdom->dom->name);
+            *_mode = SDAP_CHANGE_STREAM_NONE;
+        }
+    }
+
+    return EOK;
+}
+
+static const char *sdap_sync_type_str(enum sdap_sync_change_type type)
+{
+    switch (type) {
+    case SDAP_SYNC_USER:
+        return "user";
+    case SDAP_SYNC_GROUP:
+        return "group";
+    case SDAP_SYNC_DELETE:
+        return "delete";
+    }
+
+    return "unknown";
+}
+
+/* ==Scheduling============================================================ */
+
+static void sdap_sync_start_handler(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+
+    sctx->start_te = NULL;
+    sdap_sync_start(sctx);
+}
+
+static void sdap_sync_schedule(struct sdap_sync_ctx *sctx, time_t delay)
+{
+    struct timeval tv;
+
+    talloc_zfree(sctx->start_te);
+
+    tv = tevent_timeval_current_ofs(delay, 0);
+    sctx->start_te = tevent_add_timer(sctx->ev, sctx, tv,
+                                      sdap_sync_start_handler, sctx);
+    if (sctx->start_te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to schedule the change stream of %s, changes on the "
+              "server will not be followed\n", sctx->dom->name);
+    }
+}
+
+/* Stop the running search and start a new one after delay seconds */
+static void sdap_sync_finish(struct sdap_sync_ctx *sctx,
+                             errno_t ret, time_t delay)
+{
+    int dp_error;
+
+    talloc_zfree(sctx->sop);
+    talloc_zfree(sctx->resolve);
+    sctx->num_resolve = 0;
+    sctx->resolve_idx = 0;
+    talloc_zfree(sctx->dirsync_cookie.bv_val);
+    sctx->dirsync_cookie.bv_len = 0;
+
+    if (sctx->op != NULL) {
+        sdap_id_op_done(sctx->op, ret, &dp_error);
+        talloc_zfree(sctx->op);
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Change stream of %s stopped [%d]: %s, restarting in %ld "
+              "seconds\n", sctx->dom->name, ret, sss_strerror(ret),
+              (long)delay);
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Change stream of %s: %"PRIu64" changes received, %"PRIu64
+          " objects refreshed, %"PRIu64" deleted, %"PRIu64
+          " full refreshes\n", sctx->dom->name, sctx->stats.received,
+          sctx->stats.applied, sctx->stats.deleted,
+          sctx->stats.full_refreshes);
+
+    sctx->running = false;
+    sdap_sync_schedule(sctx, delay);
+}
+
+static void sdap_sync_online_cb(void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+
+    if (sctx->running) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Back online, restarting the change stream of %s\n",
+          sctx->dom->name);
+    sdap_sync_schedule(sctx, 0);
+}
+
+/* ==Change queue========================================================== */
+
+static errno_t sdap_sync_set_cookie(struct sdap_sync_ctx *sctx,
+                                    struct berval *bv)
+{
+    char *cookie;
+
+    if (bv == NULL || bv->bv_val == NULL || bv->bv_len == 0) {
+        return EOK;
+    }
+
+    cookie = sss_base64_encode(sctx, (const uint8_t *)bv->bv_val,
+                               bv->bv_len);
+    if (cookie == NULL) {
+        return ENOMEM;
+    }
+
+    talloc_free(sctx->cookie);
+    sctx->cookie = cookie;
+    sctx->cookie_dirty = true;
+
+    return EOK;
+}
+
+static void sdap_sync_store_cookie(struct sdap_sync_ctx *sctx)
+{
+    errno_t ret;
+
+    if (!sctx->cookie_dirty) {
+        return;
+    }
+
+    ret = sysdb_set_change_stream_cookie(sctx->dom, sctx->cookie);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unable to store the change stream cookie of %s [%d]: %s\n",
+              sctx->dom->name, ret, sss_strerror(ret));
+        return;
+    }
+
+    sctx->cookie_dirty = false;
+}
+
+static void sdap_sync_drop_changes(struct sdap_sync_ctx *sctx,
+                                   bool lookups_only)
+{
+    struct sdap_sync_change *change;
+    struct sdap_sync_change *next;
+
+    for (change = sctx->changes; change != NULL; change = next) {
+        next = change->next;
+
+        if (lookups_only && change->type == SDAP_SYNC_DELETE) {
+            continue;
+        }
+
+        DLIST_REMOVE(sctx->changes, change);
+        sctx->num_queued--;
+        /* removes the key from sctx->queued as well */
+        talloc_free(change);
+    }
+}
+
+static errno_t sdap_sync_queue(struct sdap_sync_ctx *sctx,
+                               enum sdap_sync_change_type type,
+                               const char *value)
+{
+    struct sdap_sync_change *change;
+    char *key;
+    errno_t ret;
+
+    sctx->stats.received++;
+
+    if (type != SDAP_SYNC_DELETE && sctx->full_refresh) {
+        /* the pending enumeration reads the object anyway */
+        return EOK;
+    }
+
+    key = talloc_asprintf(sctx, "%s:%s", sdap_sync_type_str(type), value);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    if (sss_ptr_hash_has_key(sctx->queued, key)) {
+        DEBUG(SSSDBG_TRACE_ALL, "[%s] is already queued\n", key);
+        ret = EOK;
+        goto done;
+    }
+
+    change = talloc_zero(sctx, struct sdap_sync_change);
+    if (change == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    change->type = type;
+    change->value = talloc_strdup(change, value);
+    if (change->value == NULL) {
+        talloc_free(change);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(sctx->queued, key, change,
+                           struct sdap_sync_change);
+    if (ret != EOK) {
+        talloc_free(change);
+        goto done;
+    }
+
+    DLIST_ADD_END(sctx->changes, change, struct sdap_sync_change *);
+    sctx->num_queued++;
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Queued change [%s]\n", key);
+
+    if (sctx->num_queued > SDAP_SYNC_MAX_LOOKUPS
+            && sctx->dom->enumerate
+            && !sctx->full_refresh) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "More than %d changes pending in %s, enumerating instead\n",
+              SDAP_SYNC_MAX_LOOKUPS, sctx->dom->name);
+        sdap_sync_drop_changes(sctx, true);
+        sctx->full_refresh = true;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(key);
+    return ret;
+}
+
+static errno_t sdap_sync_delete(struct sdap_sync_ctx *sctx,
+                                const char *uuid)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_OBJECTCATEGORY, NULL };
+    struct ldb_result *res;
+    const char *name;
+    const char *category;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_search_object_by_uuid(tmp_ctx, sctx->dom, uuid, attrs, &res);
+    if (ret == ENOENT) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "[%s] is not cached\n", uuid);
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    name = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_NAME, NULL);
+    category = ldb_msg_find_attr_as_string(res->msgs[0],
+                                           SYSDB_OBJECTCATEGORY, NULL);
+    if (name == NULL || category == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Malformed cache entry for [%s]\n", uuid);
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (strcasecmp(category, SYSDB_USER_CLASS) == 0) {
+        ret = sysdb_delete_user(sctx->dom, name, 0);
+    } else if (strcasecmp(category, SYSDB_GROUP_CLASS) == 0) {
+        ret = sysdb_delete_group(sctx->dom, name, 0);
+    } else {
+        DEBUG(SSSDBG_TRACE_INTERNAL,
+              "[%s] is neither a user nor a group, ignoring\n", name);
+        ret = EOK;
+        goto done;
+    }
+
+    if (ret == ENOENT) {
+        ret = EOK;
+    } else if (ret == EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Deleted [%s]\n", name);
+        sctx->stats.deleted++;
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sdap_sync_is_cached(struct sdap_sync_ctx *sctx,
+                                   enum sdap_sync_change_type type,
+                                   const char *name,
+                                   bool *_cached)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    struct ldb_message *msg;
+    char *fqname;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    fqname = sss_create_internal_fqname(tmp_ctx, name, sctx->dom->name);
+    if (fqname == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (type == SDAP_SYNC_USER) {
+        ret = sysdb_search_user_by_name(tmp_ctx, sctx->dom, fqname,
+                                        attrs, &msg);
+    } else {
+        ret = sysdb_search_group_by_name(tmp_ctx, sctx->dom, fqname,
+                                         attrs, &msg);
+    }
+
+    if (ret == EOK) {
+        *_cached = true;
+    } else if (ret == ENOENT) {
+        *_cached = false;
+        ret = EOK;
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static void sdap_sync_lookup_done(struct tevent_req *subreq);
+static void sdap_sync_full_refresh_done(struct tevent_req *subreq);
+
+/* Returns EAGAIN if a lookup was started for the change */
+static errno_t sdap_sync_apply_change(struct sdap_sync_ctx *sctx,
+                                      struct sdap_sync_change *change)
+{
+    struct tevent_req *subreq;
+    bool cached;
+    errno_t ret;
+
+    if (change->type == SDAP_SYNC_DELETE) {
+        return sdap_sync_delete(sctx, change->value);
+    }
+
+    /* Objects nobody asked for yet are read on their first lookup */
+    if (!sctx->dom->enumerate) {
+        ret = sdap_sync_is_cached(sctx, change->type, change->value, &cached);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (!cached) {
+            DEBUG(SSSDBG_TRACE_INTERNAL,
+                  "[%s] is not cached, skipping\n", change->value);
+            return EOK;
+        }
+    }
+
+    if (change->type == SDAP_SYNC_USER) {
+        subreq = users_get_send(sctx, sctx->ev, sctx->id_ctx, sctx->sdom,
+                                sctx->id_ctx->conn, change->value,
+                                BE_FILTER_NAME, NULL, true);
+    } else {
+        subreq = groups_get_send(sctx, sctx->ev, sctx->id_ctx, sctx->sdom,
+                                 sctx->id_ctx->conn, change->value,
+                                 BE_FILTER_NAME, true, false);
+    }
+    if (subreq == NULL) {
+        return ENOMEM;
+    }
+
+    /* the change is freed by the caller, keep the name for the request */
+    talloc_steal(subreq, change->value);
+    tevent_req_set_callback(subreq, sdap_sync_lookup_done, sctx);
+    sctx->apply_req = subreq;
+    sctx->apply_type = change->type;
+
+    return EAGAIN;
+}
+
+static void sdap_sync_rewind_handler(struct tevent_context *ev,
+                                     struct tevent_timer *te,
+                                     struct timeval tv,
+                                     void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+    const char *cookie;
+    errno_t ret;
+
+    sctx->rewind_te = NULL;
+
+    DEBUG(SSSDBG_MINOR_FAILURE,
+          "Not all changes of %s could be applied, they will be requested "
+          "again\n", sctx->dom->name);
+
+    talloc_zfree(sctx->apply_req);
+    sdap_sync_drop_changes(sctx, false);
+    sctx->full_refresh = false;
+    sctx->apply_failed = false;
+
+    /* continue from the last cookie whose changes were all applied */
+    talloc_zfree(sctx->cookie);
+    sctx->cookie_dirty = false;
+    ret = sysdb_get_change_stream_cookie(sctx, sctx->dom, &cookie);
+    if (ret == EOK) {
+        sctx->cookie = discard_const(cookie);
+    } else {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unable to read the change stream cookie of %s [%d]: %s\n",
+              sctx->dom->name, ret, sss_strerror(ret));
+    }
+
+    sdap_sync_finish(sctx, EOK, sctx->interval);
+}
+
+static void sdap_sync_apply_next(struct sdap_sync_ctx *sctx)
+{
+    struct sdap_sync_change *change;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    if (sctx->apply_req != NULL || sctx->rewind_te != NULL) {
+        return;
+    }
+
+    if (sctx->full_refresh) {
+        subreq = sctx->enum_send(sctx, sctx->ev, sctx->id_ctx->be, NULL,
+                                 sctx->enum_ctx);
+        if (subreq == NULL) {
+            sctx->apply_failed = true;
+        } else {
+            tevent_req_set_callback(subreq, sdap_sync_full_refresh_done,
+                                    sctx);
+            sctx->apply_req = subreq;
+            return;
+        }
+    }
+
+    while (sctx->apply_req == NULL && sctx->changes != NULL) {
+        change = sctx->changes;
+        DLIST_REMOVE(sctx->changes, change);
+        sctx->num_queued--;
+
+        ret = sdap_sync_apply_change(sctx, change);
+        if (ret != EOK && ret != EAGAIN) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Unable to apply change of [%s] [%d]: %s\n",
+                  change->value, ret, sss_strerror(ret));
+            sctx->apply_failed = true;
+        }
+
+        talloc_free(change);
+    }
+
+    if (sctx->apply_req != NULL) {
+        return;
+    }
+
+    if (sctx->apply_failed) {
+        /* Never called from within an LDAP reply handler, rewinding
+         * restarts the search */
+        sctx->rewind_te = tevent_add_timer(sctx->ev, sctx,
+                                           tevent_timeval_current(),
+                                           sdap_sync_rewind_handler, sctx);
+        if (sctx->rewind_te == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule rewind\n");
+        }
+        return;
+    }
+
+    sdap_sync_store_cookie(sctx);
+}
+
+static void sdap_sync_lookup_done(struct tevent_req *subreq)
+{
+    struct sdap_sync_ctx *sctx;
+    int dp_error;
+    int sdap_ret;
+    errno_t ret;
+
+    sctx = tevent_req_callback_data(subreq, struct sdap_sync_ctx);
+
+    if (sctx->apply_type == SDAP_SYNC_USER) {
+        ret = users_get_recv(subreq, &dp_error, &sdap_ret);
+    } else {
+        ret = groups_get_recv(subreq, &dp_error, &sdap_ret);
+    }
+    talloc_zfree(subreq);
+    sctx->apply_req = NULL;
+
+    if (ret == EOK && sdap_ret != EOK && sdap_ret != ENOENT) {
+        ret = sdap_ret;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to refresh changed %s [%d]: %s\n",
+              sdap_sync_type_str(sctx->apply_type), ret, sss_strerror(ret));
+        sctx->apply_failed = true;
+    } else {
+        sctx->stats.applied++;
+    }
+
+    sdap_sync_apply_next(sctx);
+}
+
+static void sdap_sync_full_refresh_done(struct tevent_req *subreq)
+{
+    struct sdap_sync_ctx *sctx;
+    errno_t ret;
+
+    sctx = tevent_req_callback_data(subreq, struct sdap_sync_ctx);
+
+    ret = sctx->enum_recv(subreq);
+    talloc_zfree(subreq);
+    sctx->apply_req = NULL;
+    sctx->full_refresh = false;
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Enumeration of %s failed [%d]: %s\n",
+              sctx->dom->name, ret, sss_strerror(ret));
+        sctx->apply_failed = true;
+    } else {
+        sctx->stats.full_refreshes++;
+    }
+
+    sdap_sync_apply_next(sctx);
+}
+
+/* ==Entry helpers========================================================= */
+
+static bool sdap_sync_entry_has_value(LDAP *ld, LDAPMessage *entry,
+                                      const char *attr, const char *value)
+{
+    struct berval **vals;
+    size_t len;
+    bool found = false;
+    int i;
+
+    if (value == NULL) {
+        return false;
+    }
+
+    vals = ldap_get_values_len(ld, entry, attr);
+    if (vals == NULL) {
+        return false;
+    }
+
+    len = strlen(value);
+    for (i = 0; vals[i] != NULL; i++) {
+        if (vals[i]->bv_len == len
+                && strncasecmp(vals[i]->bv_val, value, len) == 0) {
+            found = true;
+            break;
+        }
+    }
+
+    ldap_value_free_len(vals);
+    return found;
+}
+
+static char *sdap_sync_entry_get_string(TALLOC_CTX *mem_ctx,
+                                        LDAP *ld, LDAPMessage *entry,
+                                        const char *attr)
+{
+    struct berval **vals;
+    char *str = NULL;
+
+    vals = ldap_get_values_len(ld, entry, attr);
+    if (vals == NULL) {
+        return NULL;
+    }
+
+    if (vals[0] != NULL && vals[0]->bv_len > 0) {
+        str = talloc_strndup(mem_ctx, vals[0]->bv_val, vals[0]->bv_len);
+    }
+
+    ldap_value_free_len(vals);
+    return str;
+}
+
+/* Returns ENOENT if the entry does not carry enough attributes to tell
+ * which user or group it is */
+static errno_t sdap_sync_queue_entry(struct sdap_sync_ctx *sctx,
+                                     LDAP *ld, LDAPMessage *entry)
+{
+    struct sdap_options *opts = sctx->id_ctx->opts;
+    enum sdap_sync_change_type type;
+    const char *name_attr;
+    char *name;
+    errno_t ret;
+
+    if (sdap_sync_entry_has_value(ld, entry, "objectClass",
+                                  opts->user_map[SDAP_OC_USER].name)) {
+        type = SDAP_SYNC_USER;
+        name_attr = opts->user_map[SDAP_AT_USER_NAME].name;
+    } else if (sdap_sync_entry_has_value(ld, entry, "objectClass",
+                                     opts->group_map[SDAP_OC_GROUP].name)
+            || sdap_sync_entry_has_value(ld, entry, "objectClass",
+                                  opts->group_map[SDAP_OC_GROUP_ALT].name)) {
+        type = SDAP_SYNC_GROUP;
+        name_attr = opts->group_map[SDAP_AT_GROUP_NAME].name;
+    } else {
+        return ENOENT;
+    }
+
+    name = sdap_sync_entry_get_string(sctx, ld, entry, name_attr);
+    if (name == NULL) {
+        return ENOENT;
+    }
+
+    ret = sdap_sync_queue(sctx, type, name);
+    talloc_free(name);
+    return ret;
+}
+
+static errno_t sdap_sync_build_request(struct sdap_sync_ctx *sctx)
+{
+    struct sdap_options *opts = sctx->id_ctx->opts;
+    const char *group_alt = opts->group_map[SDAP_OC_GROUP_ALT].name;
+    const char **attrs;
+    size_t n = 0;
+
+    if (group_alt != NULL) {
+        sctx->filter = talloc_asprintf(sctx,
+                                 "(|(objectClass=%s)(objectClass=%s)"
+                                 "(objectClass=%s))",
+                                 opts->user_map[SDAP_OC_USER].name,
+                                 opts->group_map[SDAP_OC_GROUP].name,
+                                 group_alt);
+    } else {
+        sctx->filter = talloc_asprintf(sctx,
+                                 "(|(objectClass=%s)(objectClass=%s))",
+                                 opts->user_map[SDAP_OC_USER].name,
+                                 opts->group_map[SDAP_OC_GROUP].name);
+    }
+    if (sctx->filter == NULL) {
+        return ENOMEM;
+    }
+
+    attrs = talloc_zero_array(sctx, const char *, 7);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    attrs[n++] = "objectClass";
+    attrs[n++] = opts->user_map[SDAP_AT_USER_NAME].name;
+    if (strcasecmp(opts->user_map[SDAP_AT_USER_NAME].name,
+                   opts->group_map[SDAP_AT_GROUP_NAME].name) != 0) {
+        attrs[n++] = opts->group_map[SDAP_AT_GROUP_NAME].name;
+    }
+    if (sctx->mode == SDAP_CHANGE_STREAM_DIRSYNC) {
+        if (opts->user_map[SDAP_AT_USER_UUID].name != NULL) {
+            attrs[n++] = opts->user_map[SDAP_AT_USER_UUID].name;
+        }
+        attrs[n++] = SDAP_SYNC_IS_DELETED;
+    }
+    attrs[n] = NULL;
+
+    sctx->attrs = attrs;
+    return EOK;
+}
+
+static errno_t sdap_sync_cookie_berval(TALLOC_CTX *mem_ctx,
+                                       const char *cookie,
+                                       struct berval *bv)
+{
+    size_t len;
+
+    bv->bv_val = NULL;
+    bv->bv_len = 0;
+
+    if (cookie == NULL) {
+        return EOK;
+    }
+
+    bv->bv_val = (char *)sss_base64_decode(mem_ctx, cookie, &len);
+    if (bv->bv_val == NULL) {
+        return EINVAL;
+    }
+    bv->bv_len = len;
+
+    return EOK;
+}
+
+/* ==syncrepl============================================================== */
+
+static void sdap_syncrepl_reply(struct sdap_op *op, struct sdap_msg *reply,
+                                int error, void *pvt);
+
+static errno_t sdap_syncrepl_search(struct sdap_sync_ctx *sctx,
+                                    struct sdap_handle *sh)
+{
+    TALLOC_CTX *tmp_ctx;
+    LDAPControl *ctrls[2] = { NULL, NULL };
+    BerElement *ber = NULL;
+    struct berval *ctrlval = NULL;
+    struct berval cookie;
+    const char *base;
+    int scope;
+    int msgid;
+    int lret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* the search bases might have been read from the rootDSE meanwhile */
+    ret = sdap_sync_search_base(sctx->sdom, &base, &scope);
+    if (ret == ENOTSUP) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "syncrepl needs the same single search base for users and "
+              "groups, set ldap_change_stream to none for domain %s\n",
+              sctx->dom->name);
+        goto done;
+    } else if (ret != EOK || base == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "No search base for %s\n", sctx->dom->name);
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (!sdap_is_control_supported(sh, LDAP_CONTROL_SYNC)) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "The server does not support syncrepl, set ldap_change_stream "
+              "to none for domain %s\n", sctx->dom->name);
+        ret = ENOTSUP;
+        goto done;
+    }
+
+    ret = sdap_sync_cookie_berval(tmp_ctx, sctx->cookie, &cookie);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Invalid cookie, starting over\n");
+        talloc_zfree(sctx->cookie);
+        sctx->cookie_dirty = true;
+    }
+
+    ber = ber_alloc_t(LBER_USE_DER);
+    if (ber == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ber_alloc_t failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (cookie.bv_len > 0) {
+        lret = ber_printf(ber, "{eO}", LDAP_SYNC_REFRESH_AND_PERSIST,
+                          &cookie);
+    } else {
+        lret = ber_printf(ber, "{e}", LDAP_SYNC_REFRESH_AND_PERSIST);
+    }
+    if (lret == -1) {
+        DEBUG(SSSDBG_OP_FAILURE, "ber_printf failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    lret = ber_flatten(ber, &ctrlval);
+    if (lret == -1) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ber_flatten failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    lret = sdap_control_create(sh, LDAP_CONTROL_SYNC, 1, ctrlval, 1,
+                               &ctrls[0]);
+    if (lret != LDAP_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Starting syncrepl on [%s][%s] %s cookie\n",
+          base, sctx->filter, cookie.bv_len > 0 ? "with" : "without");
+
+    lret = ldap_search_ext(sh->ldap, base, scope, sctx->filter,
+                           discard_const(sctx->attrs), 0, ctrls, NULL,
+                           NULL, 0, &msgid);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "ldap_search_ext failed: %s\n", sss_ldap_err2string(lret));
+        ret = lret == LDAP_SERVER_DOWN ? ETIMEDOUT : EIO;
+        goto done;
+    }
+
+    /* the search never ends on its own, no timeout */
+    ret = sdap_op_add(sctx, sctx->ev, sh, msgid,
+                      sdap_syncrepl_reply, sctx, 0, &sctx->sop);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set up operation!\n");
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ber_bvfree(ctrlval);
+    ldap_control_free(ctrls[0]);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sdap_syncrepl_uuid(struct berval *bv, char *buf, size_t size)
+{
+    const uint8_t *b = (const uint8_t *)bv->bv_val;
+    int ret;
+
+    if (bv->bv_len != GUID_BIN_LENGTH) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unexpected entryUUID length %zu\n",
+              (size_t)bv->bv_len);
+        return EINVAL;
+    }
+
+    ret = snprintf(buf, size,
+                   "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-"
+                   "%02x%02x%02x%02x%02x%02x",
+                   b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                   b[8], b[9], b[10], b[11], b[12], b[13], b[14], b[15]);
+    if (ret < 0 || (size_t)ret >= size) {
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
+static errno_t sdap_syncrepl_queue_delete(struct sdap_sync_ctx *sctx,
+                                          struct berval *bv)
+{
+    char uuid[GUID_STR_BUF_SIZE];
+    errno_t ret;
+
+    ret = sdap_syncrepl_uuid(bv, uuid, sizeof(uuid));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sdap_sync_queue(sctx, SDAP_SYNC_DELETE, uuid);
+}
+
+static errno_t sdap_syncrepl_entry(struct sdap_sync_ctx *sctx,
+                                   LDAP *ld, LDAPMessage *entry)
+{
+    LDAPControl **ctrls = NULL;
+    LDAPControl *ctrl;
+    BerElement *ber = NULL;
+    struct berval uuid;
+    struct berval cookie = { 0, NULL };
+    ber_len_t len;
+    ber_int_t state;
+    int lret;
+    errno_t ret;
+
+    lret = ldap_get_entry_controls(ld, entry, &ctrls);
+    if (lret != LDAP_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    ctrl = ldap_control_find(LDAP_CONTROL_SYNC_STATE, ctrls, NULL);
+    if (ctrl == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Entry without sync state, ignoring\n");
+        ret = EOK;
+        goto done;
+    }
+
+    ber = ber_init(&ctrl->ldctl_value);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (ber_scanf(ber, "{em", &state, &uuid) == LBER_ERROR) {
+        DEBUG(SSSDBG_OP_FAILURE, "Malformed sync state control\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE) {
+        if (ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+            ret = EINVAL;
+            goto done;
+        }
+    }
+
+    switch (state) {
+    case LDAP_SYNC_ADD:
+    case LDAP_SYNC_MODIFY:
+        ret = sdap_sync_queue_entry(sctx, ld, entry);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_TRACE_ALL, "Entry is not a user or group\n");
+            ret = EOK;
+        }
+        break;
+    case LDAP_SYNC_DELETE:
+        ret = sdap_syncrepl_queue_delete(sctx, &uuid);
+        break;
+    case LDAP_SYNC_PRESENT:
+    default:
+        /* unchanged */
+        ret = EOK;
+        break;
+    }
+
+    if (ret == EOK) {
+        ret = sdap_sync_set_cookie(sctx, &cookie);
+    }
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_controls_free(ctrls);
+    return ret;
+}
+
+static errno_t sdap_syncrepl_info(struct sdap_sync_ctx *sctx,
+                                  LDAP *ld, LDAPMessage *msg)
+{
+    char *oid = NULL;
+    struct berval *data = NULL;
+    BerElement *ber = NULL;
+    struct berval cookie = { 0, NULL };
+    BerVarray uuids = NULL;
+    ber_int_t refresh_deletes = 0;
+    ber_len_t len;
+    ber_tag_t tag;
+    int lret;
+    int i;
+    errno_t ret;
+
+    lret = ldap_parse_intermediate(ld, msg, &oid, &data, NULL, 0);
+    if (lret != LDAP_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    if (oid == NULL || strcmp(oid, LDAP_SYNC_INFO) != 0 || data == NULL) {
+        DEBUG(SSSDBG_TRACE_ALL, "Ignoring intermediate response [%s]\n",
+              oid ? oid : "no oid");
+        ret = EOK;
+        goto done;
+    }
+
+    ber = ber_init(data);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tag = ber_peek_tag(ber, &len);
+    switch (tag) {
+    case LDAP_TAG_SYNC_NEW_COOKIE:
+        if (ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+            ret = EINVAL;
+            goto done;
+        }
+        break;
+    case LDAP_TAG_SYNC_REFRESH_DELETE:
+    case LDAP_TAG_SYNC_REFRESH_PRESENT:
+        /* end of the refresh phase, the persist phase follows */
+        if (ber_scanf(ber, "{") == LBER_ERROR) {
+            ret = EINVAL;
+            goto done;
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE) {
+            if (ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+                ret = EINVAL;
+                goto done;
+            }
+        }
+        DEBUG(SSSDBG_TRACE_FUNC, "Refresh phase of %s finished\n",
+              sctx->dom->name);
+        break;
+    case LDAP_TAG_SYNC_ID_SET:
+        if (ber_scanf(ber, "{") == LBER_ERROR) {
+            ret = EINVAL;
+            goto done;
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE) {
+            if (ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+                ret = EINVAL;
+                goto done;
+            }
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_REFRESHDELETES) {
+            if (ber_scanf(ber, "b", &refresh_deletes) == LBER_ERROR) {
+                ret = EINVAL;
+                goto done;
+            }
+        }
+        if (ber_scanf(ber, "[W]}", &uuids) == LBER_ERROR) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        /* present sets are caught by the cleanup task */
+        if (refresh_deletes && uuids != NULL) {
+            for (i = 0; uuids[i].bv_val != NULL; i++) {
+                ret = sdap_syncrepl_queue_delete(sctx, &uuids[i]);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+        break;
+    default:
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unknown sync info tag [0x%lx]\n",
+              (unsigned long)tag);
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sdap_sync_set_cookie(sctx, &cookie);
+
+done:
+    if (uuids != NULL) {
+        ber_bvarray_free(uuids);
+    }
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_memfree(oid);
+    ber_bvfree(data);
+    return ret;
+}
+
+static void sdap_syncrepl_result(struct sdap_sync_ctx *sctx,
+                                 LDAP *ld, LDAPMessage *msg)
+{
+    LDAPControl **ctrls = NULL;
+    LDAPControl *ctrl;
+    BerElement *ber = NULL;
+    struct berval cookie = { 0, NULL };
+    char *errmsg = NULL;
+    ber_len_t len;
+    time_t delay = sctx->interval;
+    int result;
+    int lret;
+    errno_t ret;
+
+    lret = ldap_parse_result(ld, msg, &result, NULL, &errmsg, NULL,
+                             &ctrls, 0);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldap_parse_result failed\n");
+        ret = EIO;
+        goto done;
+    }
+
+    if (result == LDAP_SYNC_REFRESH_REQUIRED) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "The server requires a full reload of %s\n", sctx->dom->name);
+        talloc_zfree(sctx->cookie);
+        sctx->cookie_dirty = true;
+        delay = 0;
+        ret = EOK;
+        goto done;
+    } else if (result != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "syncrepl search failed: %s(%d), %s\n",
+              sss_ldap_err2string(result), result,
+              errmsg ? errmsg : "no errmsg set");
+        ret = result == LDAP_UNAVAILABLE_CRITICAL_EXTENSION ? ENOTSUP : EIO;
+        goto done;
+    }
+
+    /* the server ended the persist phase */
+    ctrl = ldap_control_find(LDAP_CONTROL_SYNC_DONE, ctrls, NULL);
+    if (ctrl != NULL && ctrl->ldctl_value.bv_len > 0) {
+        ber = ber_init(&ctrl->ldctl_value);
+        if (ber == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        if (ber_scanf(ber, "{") != LBER_ERROR
+                && ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE
+                && ber_scanf(ber, "m", &cookie) != LBER_ERROR) {
+            ret = sdap_sync_set_cookie(sctx, &cookie);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_controls_free(ctrls);
+    ldap_memfree(errmsg);
+
+    sdap_sync_apply_next(sctx);
+    sdap_sync_finish(sctx, ret, delay);
+}
+
+static void sdap_syncrepl_reply(struct sdap_op *op, struct sdap_msg *reply,
+                                int error, void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+    LDAP *ld;
+    errno_t ret;
+
+    if (error != EOK) {
+        sdap_sync_finish(sctx, error, sctx->interval);
+        return;
+    }
+
+    ld = sdap_id_op_handle(sctx->op)->ldap;
+
+    switch (ldap_msgtype(reply->msg)) {
+    case LDAP_RES_SEARCH_ENTRY:
+        ret = sdap_syncrepl_entry(sctx, ld, reply->msg);
+        break;
+    case LDAP_RES_INTERMEDIATE:
+        ret = sdap_syncrepl_info(sctx, ld, reply->msg);
+        break;
+    case LDAP_RES_SEARCH_RESULT:
+        sdap_syncrepl_result(sctx, ld, reply->msg);
+        return;
+    case LDAP_RES_SEARCH_REFERENCE:
+    default:
+        /* referrals are not followed */
+        ret = EOK;
+        break;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to process syncrepl message "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        sdap_sync_finish(sctx, ret, sctx->interval);
+        return;
+    }
+
+    sdap_sync_apply_next(sctx);
+    sdap_unlock_next_reply(op);
+}
+
+/* ==DirSync=============================================================== */
+
+static void sdap_dirsync_reply(struct sdap_op *op, struct sdap_msg *reply,
+                               int error, void *pvt);
+static void sdap_dirsync_resolve_reply(struct sdap_op *op,
+                                       struct sdap_msg *reply,
+                                       int error, void *pvt);
+
+static errno_t sdap_dirsync_search(struct sdap_sync_ctx *sctx,
+                                   struct sdap_handle *sh)
+{
+    TALLOC_CTX *tmp_ctx;
+    LDAPControl *ctrls[2] = { NULL, NULL };
+    BerElement *ber = NULL;
+    struct berval *ctrlval = NULL;
+    struct berval cookie;
+    int msgid;
+    int lret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (!sdap_is_control_supported(sh, LDAP_SERVER_DIRSYNC_OID)) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "The server does not support DirSync, set ldap_change_stream "
+              "to none for domain %s\n", sctx->dom->name);
+        ret = ENOTSUP;
+        goto done;
+    }
+
+    ret = sdap_sync_cookie_berval(tmp_ctx, sctx->cookie, &cookie);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Invalid cookie, starting over\n");
+        talloc_zfree(sctx->cookie);
+        sctx->cookie_dirty = true;
+    }
+
+    ber = ber_alloc_t(LBER_USE_DER);
+    if (ber == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ber_alloc_t failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* flags, maximum size of the reply (server default), cookie */
+    lret = ber_printf(ber, "{iiO}", 0, 0, &cookie);
+    if (lret == -1) {
+        DEBUG(SSSDBG_OP_FAILURE, "ber_printf failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    lret = ber_flatten(ber, &ctrlval);
+    if (lret == -1) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ber_flatten failed.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    lret = sdap_control_create(sh, LDAP_SERVER_DIRSYNC_OID, 1, ctrlval, 1,
+                               &ctrls[0]);
+    if (lret != LDAP_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Polling DirSync on [%s][%s] %s cookie\n",
+          sctx->sdom->basedn, sctx->filter,
+          cookie.bv_len > 0 ? "with" : "without");
+
+    /* DirSync only accepts the root of the naming context */
+    lret = ldap_search_ext(sh->ldap, sctx->sdom->basedn, LDAP_SCOPE_SUBTREE,
+                           sctx->filter, discard_const(sctx->attrs), 0,
+                           ctrls, NULL, NULL, 0, &msgid);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "ldap_search_ext failed: %s\n", sss_ldap_err2string(lret));
+        ret = lret == LDAP_SERVER_DOWN ? ETIMEDOUT : EIO;
+        goto done;
+    }
+
+    ret = sdap_op_add(sctx, sctx->ev, sh, msgid, sdap_dirsync_reply, sctx,
+                      dp_opt_get_int(sctx->id_ctx->opts->basic,
+                                     SDAP_ENUM_SEARCH_TIMEOUT),
+                      &sctx->sop);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set up operation!\n");
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ber_bvfree(ctrlval);
+    ldap_control_free(ctrls[0]);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sdap_dirsync_entry(struct sdap_sync_ctx *sctx,
+                                  LDAP *ld, LDAPMessage *entry)
+{
+    const char *uuid_attr;
+    struct berval **vals;
+    char uuid[GUID_STR_BUF_SIZE];
+    char *dn;
+    errno_t ret;
+
+    if (sdap_sync_entry_has_value(ld, entry, SDAP_SYNC_IS_DELETED, "TRUE")) {
+        uuid_attr = sctx->id_ctx->opts->user_map[SDAP_AT_USER_UUID].name;
+        if (uuid_attr == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "ldap_user_uuid is not set, deletions are not followed\n");
+            return EOK;
+        }
+
+        vals = ldap_get_values_len(ld, entry, uuid_attr);
+        if (vals == NULL || vals[0] == NULL
+                || vals[0]->bv_len != GUID_BIN_LENGTH) {
+            ldap_value_free_len(vals);
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Deleted object without [%s], ignoring\n", uuid_attr);
+            return EOK;
+        }
+
+        ret = guid_blob_to_string_buf((const uint8_t *)vals[0]->bv_val,
+                                      uuid, sizeof(uuid));
+        ldap_value_free_len(vals);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        return sdap_sync_queue(sctx, SDAP_SYNC_DELETE, uuid);
+    }
+
+    ret = sdap_sync_queue_entry(sctx, ld, entry);
+    if (ret != ENOENT) {
+        return ret;
+    }
+
+    /* Only the changed attributes are returned for modified objects */
+    dn = ldap_get_dn(ld, entry);
+    if (dn == NULL) {
+        return EINVAL;
+    }
+
+    sctx->resolve = talloc_realloc(sctx, sctx->resolve, char *,
+                                   sctx->num_resolve + 1);
+    if (sctx->resolve == NULL) {
+        ldap_memfree(dn);
+        return ENOMEM;
+    }
+
+    sctx->resolve[sctx->num_resolve] = talloc_strdup(sctx->resolve, dn);
+    ldap_memfree(dn);
+    if (sctx->resolve[sctx->num_resolve] == NULL) {
+        return ENOMEM;
+    }
+    sctx->num_resolve++;
+
+    return EOK;
+}
+
+/* Read the objects DirSync returned only partially, one at a time, and
+ * finish the poll once all of them were queued */
+static void sdap_dirsync_resolve_next(struct sdap_sync_ctx *sctx)
+{
+    struct sdap_handle *sh;
+    int msgid;
+    int lret;
+    errno_t ret;
+
+    talloc_zfree(sctx->sop);
+
+    if (sctx->resolve_idx >= sctx->num_resolve) {
+        ret = sdap_sync_set_cookie(sctx, &sctx->dirsync_cookie);
+        sdap_sync_apply_next(sctx);
+        sdap_sync_finish(sctx, ret, sctx->dirsync_more ? 0 : sctx->interval);
+        return;
+    }
+
+    sh = sdap_id_op_handle(sctx->op);
+
+    lret = ldap_search_ext(sh->ldap, sctx->resolve[sctx->resolve_idx],
+                           LDAP_SCOPE_BASE, sctx->filter,
+                           discard_const(sctx->attrs), 0, NULL, NULL,
+                           NULL, 0, &msgid);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "ldap_search_ext failed: %s\n", sss_ldap_err2string(lret));
+        ret = lret == LDAP_SERVER_DOWN ? ETIMEDOUT : EIO;
+        goto fail;
+    }
+
+    ret = sdap_op_add(sctx, sctx->ev, sh, msgid,
+                      sdap_dirsync_resolve_reply, sctx,
+                      dp_opt_get_int(sctx->id_ctx->opts->basic,
+                                     SDAP_SEARCH_TIMEOUT),
+                      &sctx->sop);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set up operation!\n");
+        goto fail;
+    }
+
+    return;
+
+fail:
+    sdap_sync_finish(sctx, ret, sctx->interval);
+}
+
+static void sdap_dirsync_resolve_reply(struct sdap_op *op,
+                                       struct sdap_msg *reply,
+                                       int error, void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+    LDAP *ld;
+    errno_t ret;
+
+    if (error != EOK) {
+        sdap_sync_finish(sctx, error, sctx->interval);
+        return;
+    }
+
+    ld = sdap_id_op_handle(sctx->op)->ldap;
+
+    switch (ldap_msgtype(reply->msg)) {
+    case LDAP_RES_SEARCH_ENTRY:
+        ret = sdap_sync_queue_entry(sctx, ld, reply->msg);
+        if (ret == ENOENT) {
+            ret = EOK;
+        }
+        if (ret != EOK) {
+            sdap_sync_finish(sctx, ret, sctx->interval);
+            return;
+        }
+        break;
+    case LDAP_RES_SEARCH_RESULT:
+        /* the object might have been removed meanwhile, which DirSync
+         * reports on the next poll */
+        sctx->resolve_idx++;
+        sdap_dirsync_resolve_next(sctx);
+        return;
+    default:
+        break;
+    }
+
+    sdap_unlock_next_reply(op);
+}
+
+static void sdap_dirsync_result(struct sdap_sync_ctx *sctx,
+                                LDAP *ld, LDAPMessage *msg)
+{
+    LDAPControl **ctrls = NULL;
+    LDAPControl *ctrl;
+    BerElement *ber = NULL;
+    struct berval cookie;
+    ber_int_t more;
+    ber_int_t unused;
+    char *errmsg = NULL;
+    int result;
+    int lret;
+    errno_t ret;
+
+    lret = ldap_parse_result(ld, msg, &result, NULL, &errmsg, NULL,
+                             &ctrls, 0);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldap_parse_result failed\n");
+        ret = EIO;
+        goto fail;
+    }
+
+    if (result != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "DirSync search failed: %s(%d), %s\n",
+              sss_ldap_err2string(result), result,
+              errmsg ? errmsg : "no errmsg set");
+        ret = result == LDAP_UNAVAILABLE_CRITICAL_EXTENSION ? ENOTSUP : EIO;
+        goto fail;
+    }
+
+    ctrl = ldap_control_find(LDAP_SERVER_DIRSYNC_OID, ctrls, NULL);
+    if (ctrl == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "DirSync reply without a cookie\n");
+        ret = EIO;
+        goto fail;
+    }
+
+    ber = ber_init(&ctrl->ldctl_value);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+
+    if (ber_scanf(ber, "{iim}", &more, &unused, &cookie) == LBER_ERROR) {
+        DEBUG(SSSDBG_OP_FAILURE, "Malformed DirSync reply control\n");
+        ret = EINVAL;
+        goto fail;
+    }
+
+    /* kept until the partial entries are resolved */
+    sctx->dirsync_cookie.bv_val = talloc_memdup(sctx, cookie.bv_val,
+                                                cookie.bv_len);
+    if (sctx->dirsync_cookie.bv_val == NULL && cookie.bv_len > 0) {
+        ret = ENOMEM;
+        goto fail;
+    }
+    sctx->dirsync_cookie.bv_len = cookie.bv_len;
+    sctx->dirsync_more = (more != 0);
+
+    ber_free(ber, 1);
+    ldap_controls_free(ctrls);
+    ldap_memfree(errmsg);
+
+    sctx->resolve_idx = 0;
+    sdap_dirsync_resolve_next(sctx);
+    return;
+
+fail:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_controls_free(ctrls);
+    ldap_memfree(errmsg);
+    sdap_sync_finish(sctx, ret, sctx->interval);
+}
+
+static void sdap_dirsync_reply(struct sdap_op *op, struct sdap_msg *reply,
+                               int error, void *pvt)
+{
+    struct sdap_sync_ctx *sctx = talloc_get_type(pvt, struct sdap_sync_ctx);
+    LDAP *ld;
+    errno_t ret;
+
+    if (error != EOK) {
+        sdap_sync_finish(sctx, error, sctx->interval);
+        return;
+    }
+
+    ld = sdap_id_op_handle(sctx->op)->ldap;
+
+    switch (ldap_msgtype(reply->msg)) {
+    case LDAP_RES_SEARCH_ENTRY:
+        ret = sdap_dirsync_entry(sctx, ld, reply->msg);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to process DirSync entry "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            sdap_sync_finish(sctx, ret, sctx->interval);
+            return;
+        }
+        break;
+    case LDAP_RES_SEARCH_RESULT:
+        sdap_dirsync_result(sctx, ld, reply->msg);
+        return;
+    default:
+        break;
+    }
+
+    sdap_unlock_next_reply(op);
+}
+
+/* ==Connection============================================================ */
+
+static void sdap_sync_connect_done(struct tevent_req *subreq);
+
+static void sdap_sync_start(struct sdap_sync_ctx *sctx)
+{
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    if (sctx->running) {
+        return;
+    }
+
+    if (be_is_offline(sctx->id_ctx->be)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Offline, the change stream of %s waits for reconnection\n",
+              sctx->dom->name);
+        sdap_sync_schedule(sctx, sctx->interval);
+        return;
+    }
+
+    sctx->op = sdap_id_op_create(sctx, sctx->id_ctx->conn->conn_cache);
+    if (sctx->op == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed\n");
+        sdap_sync_schedule(sctx, sctx->interval);
+        return;
+    }
+
+    subreq = sdap_id_op_connect_send(sctx->op, sctx, &ret);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_connect_send failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_zfree(sctx->op);
+        sdap_sync_schedule(sctx, sctx->interval);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_sync_connect_done, sctx);
+    sctx->running = true;
+}
+
+static void sdap_sync_connect_done(struct tevent_req *subreq)
+{
+    struct sdap_sync_ctx *sctx;
+    struct sdap_handle *sh;
+    int dp_error;
+    errno_t ret;
+
+    sctx = tevent_req_callback_data(subreq, struct sdap_sync_ctx);
+
+    ret = sdap_id_op_connect_recv(subreq, &dp_error);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Unable to connect [%d]: %s\n",
+              ret, sss_strerror(ret));
+        sdap_sync_finish(sctx, ret, sctx->interval);
+        return;
+    }
+
+    sh = sdap_id_op_handle(sctx->op);
+
+    if (sctx->mode == SDAP_CHANGE_STREAM_SYNCREPL) {
+        ret = sdap_syncrepl_search(sctx, sh);
+    } else {
+        ret = sdap_dirsync_search(sctx, sh);
+    }
+    if (ret != EOK) {
+        sdap_sync_finish(sctx, ret, sctx->interval);
+        return;
+    }
+}
+
+static errno_t sdap_sync_ctx_init(TALLOC_CTX *mem_ctx,
+                                  struct sdap_id_ctx *id_ctx,
+                                  struct sdap_domain *sdom,
+                                  enum sdap_change_stream mode,
+                                  be_ptask_send_t send_fn,
+                                  be_ptask_recv_t recv_fn,
+                                  void *pvt,
+                                  struct sdap_sync_ctx **_sctx)
+{
+    struct sdap_sync_ctx *sctx;
+    const char *cookie;
+    errno_t ret;
+
+    sctx = talloc_zero(mem_ctx, struct sdap_sync_ctx);
+    if (sctx == NULL) {
+        return ENOMEM;
+    }
+
+    sctx->ev = id_ctx->be->ev;
+    sctx->id_ctx = id_ctx;
+    sctx->sdom = sdom;
+    sctx->dom = sdom->dom;
+    sctx->mode = mode;
+    sctx->enum_send = send_fn;
+    sctx->enum_recv = recv_fn;
+
+    sctx->enum_ctx = talloc_zero(sctx, struct ldap_enum_ctx);
+    if (sctx->enum_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    sctx->enum_ctx->sdom = sdom;
+    sctx->enum_ctx->pvt = pvt;
+
+    sctx->interval = dp_opt_get_int(id_ctx->opts->basic,
+                                    SDAP_CHANGE_STREAM_INTERVAL);
+    if (sctx->interval <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Invalid ldap_change_stream_interval, using %d\n",
+              SDAP_SYNC_DEFAULT_INTERVAL);
+        sctx->interval = SDAP_SYNC_DEFAULT_INTERVAL;
+    }
+
+    sctx->queued = sss_ptr_hash_create(sctx, NULL, NULL);
+    if (sctx->queued == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sdap_sync_build_request(sctx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_get_change_stream_cookie(sctx, sctx->dom, &cookie);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unable to read the change stream cookie [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+    sctx->cookie = discard_const(cookie);
+
+    *_sctx = sctx;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(sctx);
+    }
+
+    return ret;
+}
+
+errno_t sdap_change_stream_setup(struct sdap_id_ctx *id_ctx,
+                                 struct sdap_domain *sdom,
+                                 be_ptask_send_t send_fn,
+                                 be_ptask_recv_t recv_fn,
+                                 void *pvt)
+{
+    struct sdap_sync_ctx *sctx = NULL;
+    enum sdap_change_stream mode;
+    errno_t ret;
+
+    ret = sdap_change_stream_get(id_ctx->opts, sdom, &mode);
+    if (ret != EOK || mode == SDAP_CHANGE_STREAM_NONE) {
+        return ret;
+    }
+
+    ret = sdap_sync_ctx_init(sdom, id_ctx, sdom, mode, send_fn, recv_fn, pvt,
+                             &sctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = be_add_online_cb(sctx, id_ctx->be, sdap_sync_online_cb,
+                           sctx, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "be_add_online_cb failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    sdap_sync_schedule(sctx, 0);
+    if (sctx->start_te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(sctx);
+    }
+
+    return ret;
+}
@@ -0,0 +1,50 @@
+/*
+    SSSD
+
+    LDAP change stream (syncrepl / DirSync)
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SDAP_SYNC_H_
+#define _SDAP_SYNC_H_
+
+#include "providers/ldap/ldap_common.h"
+
+enum sdap_change_stream {
+    SDAP_CHANGE_STREAM_NONE,
+    SDAP_CHANGE_STREAM_SYNCREPL,  /* RFC 4533 refreshAndPersist */
+    SDAP_CHANGE_STREAM_DIRSYNC    /* Active Directory DirSync polling */
+};
+
+/* Read ldap_change_stream, returns EINVAL for unknown values. syncrepl
+ * is reported as SDAP_CHANGE_STREAM_NONE if the users and groups of the
+ * domain are searched in more than one base. */
+errno_t sdap_change_stream_get(struct sdap_options *opts,
+                               struct sdap_domain *sdom,
+                               enum sdap_change_stream *_mode);
+
+/* Start following the changes of the given domain. The cache is kept
+ * up to date from the stream instead of enumeration and the periodic
+ * refresh of users and groups. send_fn and recv_fn are the enumeration
+ * of the provider, they are run when too many changes are pending. */
+errno_t sdap_change_stream_setup(struct sdap_id_ctx *id_ctx,
+                                 struct sdap_domain *sdom,
+                                 be_ptask_send_t send_fn,
+                                 be_ptask_recv_t recv_fn,
+                                 void *pvt);
+
+#endif /* _SDAP_SYNC_H_ */
@@ -57,11 +57,26 @@
                           ((unsigned int)((unsigned char)(p)[3]))))
 
 #define DNS_HEADER_ANCOUNT(h)           DNS__16BIT((h) + 6)
+#define DNS_HEADER_NSCOUNT(h)           DNS__16BIT((h) + 8)
+#define DNS_RR_TYPE(r)                  DNS__16BIT(r)
 #define DNS_RR_LEN(r)                   DNS__16BIT((r) + 8)
 #define DNS_RR_TTL(r)                   DNS__32BIT((r) + 4)
 
 #define RESOLV_TIMEOUTMS  2000
 
+/* At most this many answers are kept in the cache */
+#define RESOLV_CACHE_MAX_ENTRIES 1024
+/* How long to keep a negative answer that does not carry a SOA record */
+#define RESOLV_CACHE_NEG_TTL 15
+/* How often the cache hit rate is logged, in seconds */
+#define RESOLV_CACHE_STATS_INTERVAL 300
+
+struct resolv_cache_stats {
+    uint64_t hits;          /* lookups answered from the cache */
+    uint64_t negative_hits; /* of which said the name does not exist */
+    uint64_t misses;        /* lookups sent to the DNS server */
+};
+
 enum host_database default_host_dbs[] = { DB_FILES, DB_DNS, DB_SENTINEL };
 
 struct fd_watch {
@@ -87,6 +102,22 @@ struct resolv_ctx {
      * if our pending requests didn't timeout. */
     int pending_requests;
     struct tevent_timer *timeout_watcher;
+
+    /* DNS answers are cached for their TTL, but no longer than
+     * cache_max_ttl seconds. The cache is disabled if it is 0. */
+    uint32_t cache_max_ttl;
+    hash_table_t *cache;
+    struct resolv_cache_stats cache_stats;
+    time_t cache_stats_logged;
+};
+
+struct resolv_cache_entry {
+    time_t expire;
+    /* ARES_SUCCESS, ARES_ENOTFOUND or ARES_ENODATA */
+    int status;
+    /* The raw answer, NULL for negative answers */
+    unsigned char *abuf;
+    int alen;
 };
 
 struct request_watch {
@@ -483,10 +514,295 @@ done:
     return ret;
 }
 
+static void resolv_cache_flush(struct resolv_ctx *ctx);
+static void resolv_cache_log_stats(struct resolv_ctx *ctx);
+
 void
 resolv_reread_configuration(struct resolv_ctx *ctx)
 {
     recreate_ares_channel(ctx);
+
+    /* the new name servers may give different answers */
+    resolv_cache_flush(ctx);
+}
+
+/*******************************************************************
+ * Cache of DNS answers.                                           *
+ *******************************************************************/
+
+static bool
+resolv_get_ttl(const unsigned char *abuf, const int alen, uint32_t *_ttl);
+static bool
+resolv_get_negative_ttl(const unsigned char *abuf, const int alen,
+                        uint32_t *_ttl);
+
+errno_t
+resolv_set_cache(struct resolv_ctx *ctx, uint32_t max_ttl)
+{
+    errno_t ret;
+
+    if (ctx->cache != NULL) {
+        resolv_cache_log_stats(ctx);
+        talloc_zfree(ctx->cache);
+    }
+    ctx->cache_max_ttl = max_ttl;
+
+    if (max_ttl == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "DNS answer cache is disabled\n");
+        return EOK;
+    }
+
+    ret = sss_hash_create(ctx, 0, &ctx->cache);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create the DNS answer cache "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        ctx->cache_max_ttl = 0;
+        return ret;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "DNS answers are cached for at most %"PRIu32
+          " seconds\n", max_ttl);
+    ctx->cache_stats_logged = time(NULL);
+
+    return EOK;
+}
+
+static void
+resolv_cache_log_stats(struct resolv_ctx *ctx)
+{
+    struct resolv_cache_stats *stats = &ctx->cache_stats;
+    uint64_t lookups = stats->hits + stats->misses;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "DNS cache: %"PRIu64" hits (%"PRIu64
+          " negative), %"PRIu64" misses, hit rate %"PRIu64"%%, "
+          "%lu answers cached\n",
+          stats->hits, stats->negative_hits, stats->misses,
+          lookups > 0 ? stats->hits * 100 / lookups : 0,
+          ctx->cache != NULL ? hash_count(ctx->cache) : 0);
+
+    ctx->cache_stats_logged = time(NULL);
+}
+
+static void
+resolv_cache_flush(struct resolv_ctx *ctx)
+{
+    if (ctx->cache == NULL) {
+        return;
+    }
+
+    resolv_cache_log_stats(ctx);
+
+    /* the entries are allocated on the table */
+    talloc_zfree(ctx->cache);
+    if (sss_hash_create(ctx, 0, &ctx->cache) != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to recreate the DNS answer cache, disabling it\n");
+        ctx->cache_max_ttl = 0;
+    }
+}
+
+static char *
+resolv_cache_key(TALLOC_CTX *mem_ctx, int type, const char *name)
+{
+    return talloc_asprintf(mem_ctx, "%d:%s", type, name);
+}
+
+static void
+resolv_cache_delete(struct resolv_ctx *ctx, hash_key_t *key,
+                    struct resolv_cache_entry *entry)
+{
+    hash_delete(ctx->cache, key);
+    talloc_free(entry);
+}
+
+/* Drop expired answers, and all of them if the cache is still full */
+static void
+resolv_cache_prune(struct resolv_ctx *ctx, time_t now)
+{
+    struct resolv_cache_entry *entry;
+    hash_entry_t *entries;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    hret = hash_entries(ctx->cache, &count, &entries);
+    if (hret != HASH_SUCCESS) {
+        resolv_cache_flush(ctx);
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        entry = talloc_get_type(entries[i].value.ptr,
+                                struct resolv_cache_entry);
+        if (entry->expire <= now) {
+            resolv_cache_delete(ctx, &entries[i].key, entry);
+        }
+    }
+    talloc_free(entries);
+
+    if (hash_count(ctx->cache) >= RESOLV_CACHE_MAX_ENTRIES) {
+        resolv_cache_flush(ctx);
+    }
+}
+
+/* Returns the cached answer to the query or NULL. The entry stays owned
+ * by the cache and is valid until the next call into the resolver. */
+static struct resolv_cache_entry *
+resolv_cache_lookup(struct resolv_ctx *ctx, int type, const char *name)
+{
+    struct resolv_cache_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    time_t now;
+    int hret;
+
+    if (ctx->cache == NULL) {
+        return NULL;
+    }
+
+    now = time(NULL);
+    if (now - ctx->cache_stats_logged >= RESOLV_CACHE_STATS_INTERVAL) {
+        resolv_cache_log_stats(ctx);
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = resolv_cache_key(ctx, type, name);
+    if (key.str == NULL) {
+        return NULL;
+    }
+
+    hret = hash_lookup(ctx->cache, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        ctx->cache_stats.misses++;
+        entry = NULL;
+        goto done;
+    }
+
+    entry = talloc_get_type(value.ptr, struct resolv_cache_entry);
+    if (entry->expire <= now) {
+        resolv_cache_delete(ctx, &key, entry);
+        ctx->cache_stats.misses++;
+        entry = NULL;
+        goto done;
+    }
+
+    ctx->cache_stats.hits++;
+    if (entry->status != ARES_SUCCESS) {
+        ctx->cache_stats.negative_hits++;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Using cached %s answer for '%s', "
+          "%"PRIu64" of %"PRIu64" lookups answered from the cache\n",
+          entry->status == ARES_SUCCESS ? "positive" : "negative", name,
+          ctx->cache_stats.hits,
+          ctx->cache_stats.hits + ctx->cache_stats.misses);
+
+done:
+    talloc_free(key.str);
+    return entry;
+}
+
+/* Remember the answer to the query for its TTL. Only successful answers
+ * and answers saying that the name or record does not exist are kept. */
+static void
+resolv_cache_store(struct resolv_ctx *ctx, int type, const char *name,
+                   int status, const unsigned char *abuf, int alen)
+{
+    struct resolv_cache_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    hash_value_t old;
+    uint32_t ttl;
+    time_t now;
+    bool ok;
+    int hret;
+
+    if (ctx->cache == NULL) {
+        return;
+    }
+
+    switch (status) {
+    case ARES_SUCCESS:
+        ok = abuf != NULL && resolv_get_ttl(abuf, alen, &ttl);
+        if (!ok) {
+            return;
+        }
+        break;
+    case ARES_ENOTFOUND:
+    case ARES_ENODATA:
+        ok = abuf != NULL && resolv_get_negative_ttl(abuf, alen, &ttl);
+        if (!ok) {
+            ttl = RESOLV_CACHE_NEG_TTL;
+        }
+        break;
+    default:
+        /* server failures and timeouts are not cached */
+        return;
+    }
+
+    ttl = MIN(ttl, ctx->cache_max_ttl);
+    if (ttl == 0) {
+        return;
+    }
+
+    now = time(NULL);
+    if (hash_count(ctx->cache) >= RESOLV_CACHE_MAX_ENTRIES) {
+        resolv_cache_prune(ctx, now);
+        if (ctx->cache == NULL) {
+            return;
+        }
+    }
+
+    entry = talloc_zero(ctx->cache, struct resolv_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->expire = now + ttl;
+    entry->status = status;
+    if (status == ARES_SUCCESS) {
+        entry->abuf = talloc_memdup(entry, abuf, alen);
+        if (entry->abuf == NULL) {
+            talloc_free(entry);
+            return;
+        }
+        entry->alen = alen;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = resolv_cache_key(entry, type, name);
+    if (key.str == NULL) {
+        talloc_free(entry);
+        return;
+    }
+
+    /* replace an answer that was stored by a concurrent query */
+    hret = hash_lookup(ctx->cache, &key, &old);
+    if (hret == HASH_SUCCESS) {
+        resolv_cache_delete(ctx, &key, old.ptr);
+    }
+
+    value.type = HASH_VALUE_PTR;
+    value.ptr = entry;
+    hret = hash_enter(ctx->cache, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache the answer for '%s': "
+              "%s\n", name, hash_error_string(hret));
+        talloc_free(entry);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Cached %s answer for '%s' for %"PRIu32
+          " seconds\n", status == ARES_SUCCESS ? "positive" : "negative",
+          name, ttl);
+}
+
+static uint32_t
+resolv_cache_remaining(struct resolv_cache_entry *entry)
+{
+    time_t now = time(NULL);
+
+    return entry->expire > now ? entry->expire - now : 0;
 }
 
 static errno_t
@@ -782,6 +1098,9 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
 static int
 resolv_gethostbyname_dns_parse(struct gethostbyname_dns_state *state,
                                int status, unsigned char *abuf, int alen);
+static errno_t
+resolv_gethostbyname_dns_answer(struct gethostbyname_dns_state *state,
+                                int status, unsigned char *abuf, int alen);
 
 static struct tevent_req *
 resolv_gethostbyname_dns_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
@@ -856,10 +1175,37 @@ resolv_gethostbyname_dns_query(struct tevent_req *req,
                                struct gethostbyname_dns_state *state)
 {
     struct resolv_request *rreq;
+    struct resolv_cache_entry *entry;
+    uint32_t remaining;
+    errno_t ret;
+    int i;
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Trying to resolve %s record of '%s' in DNS\n",
               state->family == AF_INET ? "A" : "AAAA", state->name);
 
+    entry = resolv_cache_lookup(state->resolv_ctx,
+                                (state->family == AF_INET) ? ns_t_a : ns_t_aaaa,
+                                state->name);
+    if (entry != NULL) {
+        state->status = entry->status;
+        ret = resolv_gethostbyname_dns_answer(state, entry->status,
+                                              entry->abuf, entry->alen);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        /* the addresses expire together with the cached answer */
+        remaining = resolv_cache_remaining(entry);
+        for (i = 0; state->rhostent->addr_list[i] != NULL; i++) {
+            state->rhostent->addr_list[i]->ttl =
+                    MIN(state->rhostent->addr_list[i]->ttl, remaining);
+        }
+
+        tevent_req_done(req);
+        return;
+    }
+
     rreq = schedule_timeout_watcher(state->ev, state->resolv_ctx, req);
     if (!rreq) {
         tevent_req_error(req, ENOMEM);
@@ -907,28 +1253,38 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
         return;
     }
 
+    ret = resolv_gethostbyname_dns_answer(state, status, abuf, alen);
+    if (ret == EOK || ret == ENOENT) {
+        resolv_cache_store(state->resolv_ctx,
+                           (state->family == AF_INET) ? ns_t_a : ns_t_aaaa,
+                           state->name, status, abuf, alen);
+    }
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t
+resolv_gethostbyname_dns_answer(struct gethostbyname_dns_state *state,
+                                int status, unsigned char *abuf, int alen)
+{
     if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
         /* Just say we didn't find anything and let the caller decide
          * about retrying */
-        tevent_req_error(req, ENOENT);
-        return;
+        return ENOENT;
     }
 
     if (status != ARES_SUCCESS) {
         /* Any other error indicates a server error,
          * so don't bother trying again
          */
-        tevent_req_error(req, return_code(status));
-        return;
-    }
-
-    ret = resolv_gethostbyname_dns_parse(state, status, abuf, alen);
-    if (ret != EOK) {
-        tevent_req_error(req, ret);
-        return;
+        return return_code(status);
     }
 
-    tevent_req_done(req);
+    return resolv_gethostbyname_dns_parse(state, status, abuf, alen);
 }
 
 static int
@@ -1573,6 +1929,9 @@ ares_getsrv_wakeup(struct tevent_req *subreq);
 static void
 resolv_getsrv_query(struct tevent_req *req,
                     struct getsrv_state *state);
+static errno_t
+resolv_getsrv_answer(struct tevent_req *req, struct getsrv_state *state,
+                     int status, unsigned char *abuf, int alen);
 
 struct tevent_req *
 resolv_getsrv_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
@@ -1702,6 +2061,78 @@ resolv_get_ttl(const unsigned char *abuf, const int alen, uint32_t *_ttl)
     return true;
 }
 
+/*
+ * Read how long a negative answer may be cached, as described in
+ * http://tools.ietf.org/html/rfc2308#section-5 - the lower of the TTL
+ * of the SOA record in the authority section and its MINIMUM field.
+ *
+ * On success, returns true and sets the TTL in the _ttl parameter. If
+ * there is no SOA record, returns false and _ttl is undefined.
+ */
+static bool
+resolv_get_negative_ttl(const unsigned char *abuf, const int alen,
+                        uint32_t *_ttl)
+{
+    const unsigned char *aptr;
+    const unsigned char *end = abuf + alen;
+    char *name = NULL;
+    long len;
+    unsigned int rr_len;
+    unsigned int count;
+    unsigned int i;
+    int ret;
+
+    if (alen < NS_HFIXEDSZ) {
+        return false;
+    }
+
+    /* answers and authority records are read in one go */
+    count = DNS_HEADER_ANCOUNT(abuf) + DNS_HEADER_NSCOUNT(abuf);
+    aptr = abuf + NS_HFIXEDSZ;
+
+    /* Skip past the question */
+    ret = ares_expand_name(aptr, abuf, alen, &name, &len);
+    ares_free_string(name);
+    if (ret != ARES_SUCCESS) {
+        return false;
+    }
+
+    aptr += len + NS_QFIXEDSZ;
+    if (aptr > end) {
+        return false;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = ares_expand_name(aptr, abuf, alen, &name, &len);
+        ares_free_string(name);
+        if (ret != ARES_SUCCESS) {
+            return false;
+        }
+
+        aptr += len;
+        if (aptr + NS_RRFIXEDSZ > end) {
+            return false;
+        }
+
+        rr_len = DNS_RR_LEN(aptr);
+        if (aptr + NS_RRFIXEDSZ + rr_len > end) {
+            return false;
+        }
+
+        if (DNS_RR_TYPE(aptr) == ns_t_soa && rr_len >= 5 * NS_INT32SZ) {
+            /* MINIMUM is the last field of the SOA data */
+            *_ttl = MIN(DNS_RR_TTL(aptr),
+                        DNS__32BIT(aptr + NS_RRFIXEDSZ + rr_len
+                                   - NS_INT32SZ));
+            return true;
+        }
+
+        aptr += NS_RRFIXEDSZ + rr_len;
+    }
+
+    return false;
+}
+
 static void
 resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int alen)
 {
@@ -1709,8 +2140,6 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     struct tevent_req *req;
     struct getsrv_state *state;
     int ret;
-    bool ok;
-    struct ares_srv_reply *reply_list;
 
     if (rreq->rwatch == NULL) {
         /* The tevent request was cancelled while the ares call was still in
@@ -1733,6 +2162,27 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     state->status = status;
     state->timeouts = timeouts;
 
+    ret = resolv_getsrv_answer(req, state, status, abuf, alen);
+    if (ret == EOK || status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        resolv_cache_store(state->resolv_ctx, ns_t_srv, state->query,
+                           status, abuf, alen);
+    }
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t
+resolv_getsrv_answer(struct tevent_req *req, struct getsrv_state *state,
+                     int status, unsigned char *abuf, int alen)
+{
+    struct ares_srv_reply *reply_list;
+    bool ok;
+    int ret;
+
     if (status != ARES_SUCCESS) {
         ret = return_code(status);
         goto fail;
@@ -1757,12 +2207,11 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     }
     DEBUG(SSSDBG_TRACE_LIBS, "Using TTL [%"PRIu32"]\n", state->ttl);
 
-    tevent_req_done(req);
-    return;
+    return EOK;
 
 fail:
     state->reply_list = NULL;
-    tevent_req_error(req, ret);
+    return ret;
 }
 
 int
@@ -1815,6 +2264,24 @@ resolv_getsrv_query(struct tevent_req *req,
                     struct getsrv_state *state)
 {
     struct resolv_request *rreq;
+    struct resolv_cache_entry *entry;
+    errno_t ret;
+
+    entry = resolv_cache_lookup(state->resolv_ctx, ns_t_srv, state->query);
+    if (entry != NULL) {
+        state->status = entry->status;
+        ret = resolv_getsrv_answer(req, state, entry->status,
+                                   entry->abuf, entry->alen);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        /* refresh the servers when the cached answer expires */
+        state->ttl = MIN(state->ttl, resolv_cache_remaining(entry));
+        tevent_req_done(req);
+        return;
+    }
 
     rreq = schedule_timeout_watcher(state->ev, state->resolv_ctx, req);
     if (!rreq) {
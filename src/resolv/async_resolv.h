@@ -56,6 +56,14 @@ int resolv_init(TALLOC_CTX *mem_ctx, struct tevent_context *ev_ctx,
 
 void resolv_reread_configuration(struct resolv_ctx *ctx);
 
+/*
+ * Keep A, AAAA and SRV answers, including negative ones, for their TTL
+ * but no longer than max_ttl seconds. The cache is shared by all users
+ * of the context and is flushed when resolv.conf changes. It is disabled
+ * by default, 0 disables it again.
+ */
+errno_t resolv_set_cache(struct resolv_ctx *ctx, uint32_t max_ttl);
+
 const char *resolv_strerror(int ares_code);
 
 struct resolv_hostent *
@@ -26,6 +26,7 @@
 #include "util/nss_dl_load.h"
 #include "confdb/confdb.h"
 #include "responder/common/negcache_files.h"
+#include "responder/common/negcache_hash.h"
 #include "responder/common/responder.h"
 #include "responder/common/negcache.h"
 
@@ -44,6 +45,7 @@
 
 struct sss_nc_ctx {
     struct tdb_context *tdb;
+    struct sss_nc_hash *hash;
     uint32_t timeout;
     uint32_t local_timeout;
     struct sss_nss_ops ops;
@@ -94,6 +96,15 @@ static errno_t ncache_load_nss_symbols(struct sss_nss_ops *ops)
 
 int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
                     uint32_t local_timeout, struct sss_nc_ctx **_ctx)
+{
+    return sss_ncache_init_ex(memctx, timeout, local_timeout,
+                              SSS_NCACHE_BACKEND_TDB, _ctx);
+}
+
+int sss_ncache_init_ex(TALLOC_CTX *memctx, uint32_t timeout,
+                       uint32_t local_timeout,
+                       enum sss_ncache_backend backend,
+                       struct sss_nc_ctx **_ctx)
 {
     errno_t ret;
     struct sss_nc_ctx *ctx;
@@ -109,10 +120,26 @@ int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
         return ret;
     }
 
-    errno = 0;
-    /* open a memory only tdb with default hash size */
-    ctx->tdb = tdb_open("memcache", 0, TDB_INTERNAL, O_RDWR|O_CREAT, 0);
-    if (!ctx->tdb) return errno;
+    switch (backend) {
+    case SSS_NCACHE_BACKEND_TDB:
+        errno = 0;
+        /* open a memory only tdb with default hash size */
+        ctx->tdb = tdb_open("memcache", 0, TDB_INTERNAL, O_RDWR|O_CREAT, 0);
+        if (!ctx->tdb) return errno;
+        break;
+    case SSS_NCACHE_BACKEND_HASH:
+        ret = sss_nc_hash_init(ctx, &ctx->hash);
+        if (ret != EOK) {
+            talloc_free(ctx);
+            return ret;
+        }
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unknown negative cache backend [%d]\n",
+              backend);
+        talloc_free(ctx);
+        return EINVAL;
+    }
 
     ctx->timeout = timeout;
     ctx->local_timeout = local_timeout;
@@ -126,6 +153,20 @@ uint32_t sss_ncache_get_timeout(struct sss_nc_ctx *ctx)
     return ctx->timeout;
 }
 
+static int sss_ncache_check_str_hash(struct sss_nc_ctx *ctx, char *str)
+{
+    time_t expire;
+    errno_t ret;
+
+    /* expired entries are dropped by the backend itself */
+    ret = sss_nc_hash_fetch(ctx->hash, str, &expire);
+    if (ret != EOK) {
+        return ENOENT;
+    }
+
+    return EEXIST;
+}
+
 static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
 {
     TDB_DATA key;
@@ -137,6 +178,10 @@ static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Checking negative cache for [%s]\n", str);
 
+    if (ctx->hash != NULL) {
+        return sss_ncache_check_str_hash(ctx, str);
+    }
+
     data.dptr = NULL;
 
     ret = string_to_tdb_data(str, &key);
@@ -163,7 +208,7 @@ static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
         goto done;
     }
 
-    if (timestamp >= time(NULL)) {
+    if (!sss_nc_expired((time_t)timestamp, time(NULL))) {
         /* still valid */
         ret = EEXIST;
         goto done;
@@ -188,15 +233,13 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
     TDB_DATA key;
     TDB_DATA data;
     char *timest;
-    unsigned long long int timell;
+    unsigned long long int timell = 0;
     int ret;
 
     ret = string_to_tdb_data(str, &key);
     if (ret != EOK) return ret;
 
-    if (permanent) {
-        timest = talloc_strdup(ctx, "0");
-    } else {
+    if (!permanent) {
         if (use_local_negative == true && ctx->local_timeout > ctx->timeout) {
             timell = ctx->local_timeout;
         } else {
@@ -207,6 +250,25 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
             timell = ctx->timeout;
         }
         timell += (unsigned long long int)time(NULL);
+    }
+
+    if (ctx->hash != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Adding [%s] to negative cache%s\n",
+              str, permanent?" permanently":"");
+
+        /* a 0 expire time means this is a permanent entry */
+        ret = sss_nc_hash_store(ctx->hash, str, (time_t)timell);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Negative cache failed to set entry: [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+        return ret;
+    }
+
+    if (permanent) {
+        timest = talloc_strdup(ctx, "0");
+    } else {
         timest = talloc_asprintf(ctx, "%llu", timell);
     }
     if (!timest) return ENOMEM;
@@ -892,10 +954,21 @@ done:
     return 0;
 }
 
+static bool hash_match_permanent(const char *key, time_t expire, void *pvt)
+{
+    return strncmp(key, NC_ENTRY_PREFIX, sizeof(NC_ENTRY_PREFIX) - 1) == 0
+            && expire == 0;
+}
+
 int sss_ncache_reset_permanent(struct sss_nc_ctx *ctx)
 {
     int ret;
 
+    if (ctx->hash != NULL) {
+        sss_nc_hash_delete_if(ctx->hash, hash_match_permanent, NULL);
+        return EOK;
+    }
+
     ret = tdb_traverse(ctx->tdb, delete_permanent, NULL);
     if (ret < 0)
         return EIO;
@@ -916,6 +989,13 @@ static int delete_prefix(struct tdb_context *tdb,
     return tdb_delete(tdb, key);
 }
 
+static bool hash_match_prefix(const char *key, time_t expire, void *pvt)
+{
+    const char *prefix = (const char *) pvt;
+
+    return strncmp(key, prefix, strlen(prefix) - 1) == 0;
+}
+
 static int sss_ncache_reset_pfx(struct sss_nc_ctx *ctx,
                                 const char **prefixes)
 {
@@ -926,6 +1006,12 @@ static int sss_ncache_reset_pfx(struct sss_nc_ctx *ctx,
     }
 
     for (int i = 0; prefixes[i] != NULL; i++) {
+        if (ctx->hash != NULL) {
+            sss_nc_hash_delete_if(ctx->hash, hash_match_prefix,
+                                  discard_const(prefixes[i]));
+            continue;
+        }
+
         ret = tdb_traverse(ctx->tdb,
                            delete_prefix,
                            discard_const(prefixes[i]));
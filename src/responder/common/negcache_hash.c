@@ -0,0 +1,378 @@
+/*
+   SSSD
+
+   NSS Responder - hash table backend of the negative cache
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <time.h>
+#include "util/util.h"
+#include "shared/murmurhash3.h"
+#include "responder/common/negcache_hash.h"
+
+#define NC_HASH_SEED 0x6e656763
+/* both sizes must be a power of 2 */
+#define NC_HASH_MIN_SIZE 1024
+#define NC_WHEEL_SIZE 256
+
+#define NC_NO_SLOT UINT32_MAX
+
+enum nc_slot_state {
+    NC_SLOT_EMPTY = 0,
+    NC_SLOT_USED,
+    NC_SLOT_DELETED,
+};
+
+struct nc_slot {
+    uint32_t hash;
+    uint32_t state;
+    char *key;
+    time_t expire;
+
+    /* list of entries in the same wheel bucket */
+    uint32_t wheel_prev;
+    uint32_t wheel_next;
+};
+
+struct sss_nc_hash {
+    struct nc_slot *slots;
+    uint32_t size;
+    uint32_t used;
+    uint32_t deleted;
+
+    /* Non-permanent entries are linked into the bucket selected by their
+     * expire time modulo the wheel size. All entries that expired before
+     * wheel_time were already removed. */
+    uint32_t wheel[NC_WHEEL_SIZE];
+    time_t wheel_time;
+};
+
+static uint32_t nc_hash_key(const char *key)
+{
+    return murmurhash3(key, strlen(key), NC_HASH_SEED);
+}
+
+static uint32_t nc_hash_lookup(struct sss_nc_hash *table,
+                               const char *key, uint32_t hash)
+{
+    uint32_t mask = table->size - 1;
+    uint32_t idx = hash & mask;
+    struct nc_slot *slot;
+    uint32_t n;
+
+    for (n = 0; n < table->size; n++) {
+        slot = &table->slots[idx];
+
+        if (slot->state == NC_SLOT_EMPTY) {
+            break;
+        }
+
+        if (slot->state == NC_SLOT_USED
+                && slot->hash == hash
+                && strcmp(slot->key, key) == 0) {
+            return idx;
+        }
+
+        idx = (idx + 1) & mask;
+    }
+
+    return NC_NO_SLOT;
+}
+
+static uint32_t nc_hash_free_slot(struct nc_slot *slots, uint32_t size,
+                                  uint32_t hash)
+{
+    uint32_t mask = size - 1;
+    uint32_t idx = hash & mask;
+
+    /* the table is never full, see nc_hash_reserve() */
+    while (slots[idx].state == NC_SLOT_USED) {
+        idx = (idx + 1) & mask;
+    }
+
+    return idx;
+}
+
+static void nc_wheel_link(struct sss_nc_hash *table, uint32_t idx)
+{
+    struct nc_slot *slot = &table->slots[idx];
+    uint32_t bucket;
+
+    slot->wheel_prev = NC_NO_SLOT;
+    slot->wheel_next = NC_NO_SLOT;
+
+    if (slot->expire == 0) {
+        /* permanent entries never expire */
+        return;
+    }
+
+    bucket = slot->expire & (NC_WHEEL_SIZE - 1);
+    slot->wheel_next = table->wheel[bucket];
+    if (slot->wheel_next != NC_NO_SLOT) {
+        table->slots[slot->wheel_next].wheel_prev = idx;
+    }
+    table->wheel[bucket] = idx;
+}
+
+static void nc_wheel_unlink(struct sss_nc_hash *table, uint32_t idx)
+{
+    struct nc_slot *slot = &table->slots[idx];
+    uint32_t bucket;
+
+    if (slot->expire == 0) {
+        return;
+    }
+
+    if (slot->wheel_prev != NC_NO_SLOT) {
+        table->slots[slot->wheel_prev].wheel_next = slot->wheel_next;
+    } else {
+        bucket = slot->expire & (NC_WHEEL_SIZE - 1);
+        table->wheel[bucket] = slot->wheel_next;
+    }
+
+    if (slot->wheel_next != NC_NO_SLOT) {
+        table->slots[slot->wheel_next].wheel_prev = slot->wheel_prev;
+    }
+}
+
+static void nc_hash_remove(struct sss_nc_hash *table, uint32_t idx)
+{
+    struct nc_slot *slot = &table->slots[idx];
+
+    nc_wheel_unlink(table, idx);
+
+    talloc_free(slot->key);
+    slot->key = NULL;
+    slot->state = NC_SLOT_DELETED;
+
+    table->used--;
+    table->deleted++;
+}
+
+/* Drop all entries that expired between the last run and now. Only the
+ * buckets of the elapsed seconds are visited, entries in these buckets
+ * that belong to a later turn of the wheel are kept. */
+static void nc_wheel_advance(struct sss_nc_hash *table, time_t now)
+{
+    time_t steps;
+    time_t t;
+    uint32_t idx;
+    uint32_t next;
+
+    if (now <= table->wheel_time) {
+        return;
+    }
+
+    steps = now - table->wheel_time;
+    if (steps > NC_WHEEL_SIZE) {
+        steps = NC_WHEEL_SIZE;
+    }
+
+    for (t = table->wheel_time; steps > 0; t++, steps--) {
+        idx = table->wheel[t & (NC_WHEEL_SIZE - 1)];
+        while (idx != NC_NO_SLOT) {
+            next = table->slots[idx].wheel_next;
+            if (sss_nc_expired(table->slots[idx].expire, now)) {
+                nc_hash_remove(table, idx);
+            }
+            idx = next;
+        }
+    }
+
+    table->wheel_time = now;
+}
+
+static errno_t nc_hash_rebuild(struct sss_nc_hash *table, uint32_t size)
+{
+    struct nc_slot *old_slots = table->slots;
+    uint32_t old_size = table->size;
+    struct nc_slot *slots;
+    uint32_t idx;
+    uint32_t i;
+
+    slots = talloc_zero_array(table, struct nc_slot, size);
+    if (slots == NULL) {
+        return ENOMEM;
+    }
+
+    table->slots = slots;
+    table->size = size;
+    table->deleted = 0;
+    for (i = 0; i < NC_WHEEL_SIZE; i++) {
+        table->wheel[i] = NC_NO_SLOT;
+    }
+
+    for (i = 0; i < old_size; i++) {
+        if (old_slots[i].state != NC_SLOT_USED) {
+            continue;
+        }
+
+        idx = nc_hash_free_slot(slots, size, old_slots[i].hash);
+        slots[idx].hash = old_slots[i].hash;
+        slots[idx].state = NC_SLOT_USED;
+        slots[idx].key = old_slots[i].key;
+        slots[idx].expire = old_slots[i].expire;
+        nc_wheel_link(table, idx);
+    }
+
+    talloc_free(old_slots);
+    return EOK;
+}
+
+/* Make sure there is room for one more entry. The table is rebuilt once
+ * used and deleted slots fill 3/4 of it so probe sequences stay short,
+ * the new table is at most half full. */
+static errno_t nc_hash_reserve(struct sss_nc_hash *table)
+{
+    uint32_t size;
+
+    if ((uint64_t)(table->used + table->deleted + 1) * 4
+            <= (uint64_t)table->size * 3) {
+        return EOK;
+    }
+
+    size = NC_HASH_MIN_SIZE;
+    while ((uint64_t)(table->used + 1) * 2 > size) {
+        if (size > UINT32_MAX / 2) {
+            return ENOMEM;
+        }
+        size *= 2;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL,
+          "Resizing negative cache table from %u to %u slots\n",
+          table->size, size);
+
+    return nc_hash_rebuild(table, size);
+}
+
+errno_t sss_nc_hash_init(TALLOC_CTX *mem_ctx, struct sss_nc_hash **_table)
+{
+    struct sss_nc_hash *table;
+    errno_t ret;
+    uint32_t i;
+
+    table = talloc_zero(mem_ctx, struct sss_nc_hash);
+    if (table == NULL) {
+        return ENOMEM;
+    }
+
+    table->slots = talloc_zero_array(table, struct nc_slot, NC_HASH_MIN_SIZE);
+    if (table->slots == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    table->size = NC_HASH_MIN_SIZE;
+
+    for (i = 0; i < NC_WHEEL_SIZE; i++) {
+        table->wheel[i] = NC_NO_SLOT;
+    }
+    table->wheel_time = time(NULL);
+
+    *_table = table;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(table);
+    }
+    return ret;
+}
+
+errno_t sss_nc_hash_store(struct sss_nc_hash *table, const char *key,
+                          time_t expire)
+{
+    uint32_t hash;
+    uint32_t idx;
+    struct nc_slot *slot;
+    char *key_copy;
+    errno_t ret;
+
+    nc_wheel_advance(table, time(NULL));
+
+    hash = nc_hash_key(key);
+    idx = nc_hash_lookup(table, key, hash);
+    if (idx != NC_NO_SLOT) {
+        nc_wheel_unlink(table, idx);
+        table->slots[idx].expire = expire;
+        nc_wheel_link(table, idx);
+        return EOK;
+    }
+
+    ret = nc_hash_reserve(table);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key_copy = talloc_strdup(table, key);
+    if (key_copy == NULL) {
+        return ENOMEM;
+    }
+
+    idx = nc_hash_free_slot(table->slots, table->size, hash);
+    slot = &table->slots[idx];
+    if (slot->state == NC_SLOT_DELETED) {
+        table->deleted--;
+    }
+
+    slot->hash = hash;
+    slot->state = NC_SLOT_USED;
+    slot->key = key_copy;
+    slot->expire = expire;
+    nc_wheel_link(table, idx);
+    table->used++;
+
+    return EOK;
+}
+
+errno_t sss_nc_hash_fetch(struct sss_nc_hash *table, const char *key,
+                          time_t *_expire)
+{
+    time_t now = time(NULL);
+    uint32_t idx;
+
+    nc_wheel_advance(table, now);
+
+    idx = nc_hash_lookup(table, key, nc_hash_key(key));
+    if (idx == NC_NO_SLOT) {
+        return ENOENT;
+    }
+
+    if (sss_nc_expired(table->slots[idx].expire, now)) {
+        nc_hash_remove(table, idx);
+        return ENOENT;
+    }
+
+    *_expire = table->slots[idx].expire;
+    return EOK;
+}
+
+void sss_nc_hash_delete_if(struct sss_nc_hash *table,
+                           sss_nc_hash_match_fn_t fn, void *pvt)
+{
+    uint32_t i;
+
+    for (i = 0; i < table->size; i++) {
+        if (table->slots[i].state != NC_SLOT_USED) {
+            continue;
+        }
+
+        if (fn(table->slots[i].key, table->slots[i].expire, pvt)) {
+            nc_hash_remove(table, i);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+   SSSD
+
+   NSS Responder - hash table backend of the negative cache
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _NEGCACHE_HASH_H_
+#define _NEGCACHE_HASH_H_
+
+#include <stdbool.h>
+#include <time.h>
+#include <talloc.h>
+
+#include "util/util_errors.h"
+
+struct sss_nc_hash;
+
+/* Non-permanent entries are valid up to and including their expire time.
+ * Both negative cache backends use this check. */
+static inline bool sss_nc_expired(time_t expire, time_t now)
+{
+    return expire != 0 && expire < now;
+}
+
+/* Callback used by sss_nc_hash_delete_if(), return true to delete the
+ * entry. The expire time of permanent entries is 0. */
+typedef bool (*sss_nc_hash_match_fn_t)(const char *key, time_t expire,
+                                       void *pvt);
+
+/* Create an empty table. Entries are kept in an open addressing hash
+ * table and non-permanent entries are also linked into a timing wheel
+ * so that expired entries are dropped without traversing the table. */
+errno_t sss_nc_hash_init(TALLOC_CTX *mem_ctx, struct sss_nc_hash **_table);
+
+/* Add or replace an entry, expire == 0 means the entry never expires */
+errno_t sss_nc_hash_store(struct sss_nc_hash *table, const char *key,
+                          time_t expire);
+
+/* Return EOK and the expire time if the key is present and not expired,
+ * ENOENT otherwise. */
+errno_t sss_nc_hash_fetch(struct sss_nc_hash *table, const char *key,
+                          time_t *_expire);
+
+void sss_nc_hash_delete_if(struct sss_nc_hash *table,
+                           sss_nc_hash_match_fn_t fn, void *pvt);
+
+#endif /* _NEGCACHE_HASH_H_ */
@@ -38,6 +38,7 @@
 #include "sss_client/sss_cli.h"
 #include "responder/common/cache_req/cache_req_domain.h"
 #include "util/session_recording.h"
+#include "sbus/frame/sbus_frame.h"
 
 extern hash_table_t *dp_requests;
 
@@ -97,6 +98,11 @@ struct be_conn {
     char *bus_name;
     char *sbus_address;
     struct sbus_connection *conn;
+
+    /* Optional binary frame connection, account requests are sent over it
+     * when it is available. */
+    bool frame_transport;
+    struct sbus_frame_conn *frame_conn;
 };
 
 struct resp_ctx {
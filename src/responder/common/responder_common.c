@@ -683,6 +683,9 @@ sss_dp_on_reconnect(struct sbus_connection *conn,
 static void
 sss_dp_init_done(struct tevent_req *req);
 
+static void
+sss_dp_frame_connect(struct be_conn *be_conn);
+
 static errno_t
 sss_dp_init(struct resp_ctx *rctx,
             const char *conn_name,
@@ -691,6 +694,7 @@ sss_dp_init(struct resp_ctx *rctx,
 {
     struct tevent_req *req;
     struct be_conn *be_conn;
+    char *conf_path;
     int max_retries;
     errno_t ret;
 
@@ -709,6 +713,22 @@ sss_dp_init(struct resp_ctx *rctx,
     be_conn->domain = domain;
     be_conn->rctx = rctx;
 
+    conf_path = talloc_asprintf(be_conn, CONFDB_DOMAIN_PATH_TMPL,
+                                domain->name);
+    if (conf_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = confdb_get_bool(rctx->cdb, conf_path, CONFDB_DOMAIN_FRAME_TRANSPORT,
+                          false, &be_conn->frame_transport);
+    talloc_free(conf_path);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
     be_conn->sbus_address = sss_iface_domain_address(be_conn, domain);
     if (be_conn->sbus_address == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Could not locate DP address.\n");
@@ -754,6 +774,8 @@ sss_dp_init(struct resp_ctx *rctx,
 
     tevent_req_set_callback(req, sss_dp_init_done, be_conn);
 
+    sss_dp_frame_connect(be_conn);
+
     ret = EOK;
 
 done:
@@ -779,6 +801,10 @@ sss_dp_on_reconnect(struct sbus_connection *conn,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Reconnected to the Data Provider.\n");
 
+    /* The back end was restarted, so was its frame server. */
+    talloc_zfree(be_conn->frame_conn);
+    sss_dp_frame_connect(be_conn);
+
     /* Identify ourselves to the DP */
     req = sbus_call_dp_client_Register_send(be_conn, be_conn->conn,
                                             be_conn->bus_name,
@@ -808,6 +834,60 @@ sss_dp_init_done(struct tevent_req *req)
     DEBUG(SSSDBG_TRACE_FUNC, "Client is registered with DP\n");
 }
 
+static void
+sss_dp_frame_connect_done(struct tevent_req *req);
+
+static void
+sss_dp_frame_connect(struct be_conn *be_conn)
+{
+    struct tevent_req *req;
+    char *socket_path;
+
+    if (!be_conn->frame_transport) {
+        return;
+    }
+
+    socket_path = sbus_frame_socket_path(be_conn, be_conn->sbus_address);
+    if (socket_path == NULL) {
+        return;
+    }
+
+    req = sbus_frame_connect_send(be_conn, be_conn->rctx->ev, socket_path);
+    talloc_free(socket_path);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return;
+    }
+
+    tevent_req_set_callback(req, sss_dp_frame_connect_done, be_conn);
+}
+
+static void
+sss_dp_frame_connect_done(struct tevent_req *req)
+{
+    struct sbus_frame_conn *frame_conn;
+    struct be_conn *be_conn;
+    errno_t ret;
+
+    be_conn = tevent_req_callback_data(req, struct be_conn);
+
+    ret = sbus_frame_connect_recv(be_conn, req, &frame_conn);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        /* Requests keep going over D-Bus. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Frame transport to %s provider is not "
+              "available [%d]: %s\n", be_conn->domain->name,
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    talloc_free(be_conn->frame_conn);
+    be_conn->frame_conn = frame_conn;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Using frame transport to %s provider\n",
+          be_conn->domain->name);
+}
+
 int create_pipe_fd(const char *sock_name, int *_fd, mode_t umaskval)
 {
     struct sockaddr_un addr;
@@ -1102,6 +1182,8 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
 {
     uint32_t neg_timeout;
     uint32_t locals_timeout;
+    enum sss_ncache_backend backend;
+    char *backend_str = NULL;
     int tmp_value;
     int ret;
 
@@ -1142,8 +1224,31 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
 
     locals_timeout = tmp_value;
 
+    /* backend */
+    ret = confdb_get_string(cdb, mem_ctx, CONFDB_NSS_CONF_ENTRY,
+                            CONFDB_NSS_NEG_CACHE_BACKEND,
+                            CONFDB_NSS_NEG_CACHE_BACKEND_DEFAULT,
+                            &backend_str);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Fatal failure of setup negative cache backend.\n");
+        goto done;
+    }
+
+    if (strcasecmp(backend_str, "tdb") == 0) {
+        backend = SSS_NCACHE_BACKEND_TDB;
+    } else if (strcasecmp(backend_str, "hash") == 0) {
+        backend = SSS_NCACHE_BACKEND_HASH;
+    } else {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Unknown negative cache backend [%s]\n", backend_str);
+        ret = EINVAL;
+        goto done;
+    }
+
     /* negative cache init */
-    ret = sss_ncache_init(mem_ctx, neg_timeout, locals_timeout, ncache);
+    ret = sss_ncache_init_ex(mem_ctx, neg_timeout, locals_timeout, backend,
+                             ncache);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE,
               "Fatal failure of initializing negative cache.\n");
@@ -1153,6 +1258,7 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
     ret = EOK;
 
 done:
+    talloc_free(backend_str);
     return ret;
 }
 
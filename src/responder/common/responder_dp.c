@@ -26,6 +26,7 @@
 #include "responder/common/responder_packet.h"
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
+#include "sss_iface/sbus_sss_arguments.h"
 
 static errno_t
 sss_dp_account_files_params(struct sss_domain_info *dom,
@@ -160,12 +161,20 @@ sss_dp_get_account_filter(TALLOC_CTX *mem_ctx,
 }
 
 struct sss_dp_get_account_state {
+    struct be_conn *be_conn;
+    uint32_t dp_flags;
+    uint32_t entry_type;
+    const char *filter;
+    const char *domain;
+    const char *extra;
+
     uint16_t dp_error;
     uint32_t error;
     const char *error_message;
 };
 
-static void sss_dp_get_account_done(struct tevent_req *subreq);
+static errno_t sss_dp_get_account_dbus(struct tevent_req *req);
+static errno_t sss_dp_get_account_frame(struct tevent_req *req);
 
 struct tevent_req *
 sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
@@ -178,11 +187,8 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
                         const char *extra)
 {
     struct sss_dp_get_account_state *state;
-    struct tevent_req *subreq;
     struct tevent_req *req;
     struct be_conn *be_conn;
-    uint32_t entry_type;
-    uint32_t dp_flags;
     char *filter;
     errno_t ret;
 
@@ -252,27 +258,39 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
 
     /* Build filter. */
     ret = sss_dp_get_account_filter(state, type, fast_reply, opt_name, opt_id,
-                                    &dp_flags, &entry_type, &filter);
+                                    &state->dp_flags, &state->entry_type,
+                                    &filter);
     if (ret != EOK) {
         goto done;
     }
 
+    state->be_conn = be_conn;
+    state->filter = filter;
+    state->domain = dom->name;
+
+    /* Kept for a possible D-Bus retry. */
+    if (extra != NULL) {
+        state->extra = talloc_strdup(state, extra);
+        if (state->extra == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
     DEBUG(SSSDBG_TRACE_FUNC,
           "Creating request for [%s][%#x][%s][%s:%s]\n",
-          dom->name, entry_type, be_req2str(entry_type),
+          dom->name, state->entry_type, be_req2str(state->entry_type),
           filter, extra == NULL ? "-" : extra);
 
-    subreq = sbus_call_dp_dp_getAccountInfo_send(state, be_conn->conn,
-                 be_conn->bus_name, SSS_BUS_PATH, dp_flags,
-                 entry_type, filter, dom->name, extra);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        ret = ENOMEM;
+    if (be_conn->frame_conn != NULL) {
+        ret = sss_dp_get_account_frame(req);
+    } else {
+        ret = sss_dp_get_account_dbus(req);
+    }
+    if (ret != EOK) {
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sss_dp_get_account_done, req);
-
     ret = EAGAIN;
 
 done:
@@ -287,7 +305,30 @@ done:
     return req;
 }
 
-static void sss_dp_get_account_done(struct tevent_req *subreq)
+static void sss_dp_get_account_dbus_done(struct tevent_req *subreq);
+
+static errno_t sss_dp_get_account_dbus(struct tevent_req *req)
+{
+    struct sss_dp_get_account_state *state;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    subreq = sbus_call_dp_dp_getAccountInfo_send(state, state->be_conn->conn,
+                 state->be_conn->bus_name, SSS_BUS_PATH, state->dp_flags,
+                 state->entry_type, state->filter, state->domain,
+                 state->extra);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, sss_dp_get_account_dbus_done, req);
+
+    return EOK;
+}
+
+static void sss_dp_get_account_dbus_done(struct tevent_req *subreq)
 {
     struct sss_dp_get_account_state *state;
     struct tevent_req *req;
@@ -309,6 +350,113 @@ static void sss_dp_get_account_done(struct tevent_req *subreq)
     return;
 }
 
+static void sss_dp_get_account_frame_done(struct tevent_req *subreq);
+
+static errno_t sss_dp_get_account_frame(struct tevent_req *req)
+{
+    struct _sbus_sss_invoker_args_uusss args;
+    struct sss_dp_get_account_state *state;
+    struct sbus_frame_writer *writer;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    writer = sbus_frame_call_writer(state, "sssd.dataprovider",
+                                    "getAccountInfo");
+    if (writer == NULL) {
+        return ENOMEM;
+    }
+
+    args.arg0 = state->dp_flags;
+    args.arg1 = state->entry_type;
+    args.arg2 = state->filter;
+    args.arg3 = state->domain;
+    args.arg4 = state->extra;
+
+    ret = _sbus_sss_invoker_frame_write_uusss(writer, &args);
+    if (ret != EOK) {
+        talloc_free(writer);
+        return ret;
+    }
+
+    subreq = sbus_frame_call_send(state, state->be_conn->frame_conn, writer);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, sss_dp_get_account_frame_done, req);
+
+    return EOK;
+}
+
+/* The frame connection can not be used anymore. */
+static bool sss_dp_frame_unavailable(errno_t ret)
+{
+    switch (ret) {
+    case ERR_SBUS_NOSUP:
+    case ERR_SBUS_UNKNOWN_INTERFACE:
+    case ENOTCONN:
+    case EPIPE:
+    case ECONNRESET:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void sss_dp_get_account_frame_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoker_args_qus args;
+    struct sss_dp_get_account_state *state;
+    struct sbus_frame_reader *reply;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    ret = sbus_frame_call_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (sss_dp_frame_unavailable(ret)) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Frame transport failed [%d]: %s, "
+              "falling back to D-Bus\n", ret, sss_strerror(ret));
+
+        talloc_zfree(state->be_conn->frame_conn);
+
+        ret = sss_dp_get_account_dbus(req);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+        }
+        return;
+    } else if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_frame_read_qus(state, reply, &args);
+    if (ret != EOK) {
+        talloc_free(reply);
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    state->dp_error = args.arg0;
+    state->error = args.arg1;
+
+    /* The message points into the reply, recv steals it. */
+    state->error_message = talloc_strdup(state, args.arg2);
+    talloc_free(reply);
+    if (state->error_message == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
 errno_t
 sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
                         struct tevent_req *req,
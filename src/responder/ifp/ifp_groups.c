@@ -521,6 +521,57 @@ ifp_groups_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static const struct ifp_list_page_ops ifp_groups_page_ops = {
+    .dp_type = SSS_DP_WILDCARD_GROUP,
+    .page_fn = sysdb_enumgrent_page_with_views,
+    .build_path_fn = ifp_groups_build_path_from_msg,
+};
+
+struct tevent_req *
+ifp_groups_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sbus_request *sbus_req,
+                                   struct ifp_ctx *ctx,
+                                   const char *filter,
+                                   const char *cursor,
+                                   uint32_t page_size)
+{
+    return ifp_list_page_send(mem_ctx, ev, ctx, &ifp_groups_page_ops, NULL,
+                              filter, cursor, page_size);
+}
+
+errno_t
+ifp_groups_list_by_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                   struct tevent_req *req,
+                                   const char ***_paths,
+                                   const char **_next_cursor)
+{
+    return ifp_list_page_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
+struct tevent_req *
+ifp_groups_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                              struct tevent_context *ev,
+                                              struct sbus_request *sbus_req,
+                                              struct ifp_ctx *ctx,
+                                              const char *domain,
+                                              const char *filter,
+                                              const char *cursor,
+                                              uint32_t page_size)
+{
+    return ifp_list_page_send(mem_ctx, ev, ctx, &ifp_groups_page_ops, domain,
+                              filter, cursor, page_size);
+}
+
+errno_t
+ifp_groups_list_by_domain_and_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                              struct tevent_req *req,
+                                              const char ***_paths,
+                                              const char **_next_cursor)
+{
+    return ifp_list_page_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
 static errno_t
 ifp_groups_get_from_cache(TALLOC_CTX *mem_ctx,
                           struct sss_domain_info *domain,
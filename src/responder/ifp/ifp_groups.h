@@ -82,6 +82,37 @@ ifp_groups_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
                                         struct tevent_req *req,
                                         const char ***_paths);
 
+struct tevent_req *
+ifp_groups_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sbus_request *sbus_req,
+                                   struct ifp_ctx *ctx,
+                                   const char *filter,
+                                   const char *cursor,
+                                   uint32_t page_size);
+
+errno_t
+ifp_groups_list_by_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                   struct tevent_req *req,
+                                   const char ***_paths,
+                                   const char **_next_cursor);
+
+struct tevent_req *
+ifp_groups_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                              struct tevent_context *ev,
+                                              struct sbus_request *sbus_req,
+                                              struct ifp_ctx *ctx,
+                                              const char *domain,
+                                              const char *filter,
+                                              const char *cursor,
+                                              uint32_t page_size);
+
+errno_t
+ifp_groups_list_by_domain_and_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                              struct tevent_req *req,
+                                              const char ***_paths,
+                                              const char **_next_cursor);
+
 /* org.freedesktop.sssd.infopipe.Groups.Group */
 
 struct tevent_req *
@@ -25,6 +25,7 @@
 
 #include "sbus/interface/sbus_iterator_readers.h"
 #include "sbus/interface/sbus_iterator_writers.h"
+#include "sbus/frame/sbus_frame.h"
 #include "responder/ifp/ifp_iface/sbus_ifp_arguments.h"
 
 errno_t _sbus_ifp_invoker_read_ao
@@ -56,6 +57,45 @@ errno_t _sbus_ifp_invoker_write_ao
     return EOK;
 }
 
+errno_t _sbus_ifp_invoker_read_aos
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_read_ao(mem_ctx, iter, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_write_aos
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_write_ao(iter, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
 errno_t _sbus_ifp_invoker_read_as
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
@@ -279,6 +319,65 @@ errno_t _sbus_ifp_invoker_write_ss
     return EOK;
 }
 
+errno_t _sbus_ifp_invoker_read_sssu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_u(iter, &args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_write_sssu
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_write_s(iter, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_u(iter, args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
 errno_t _sbus_ifp_invoker_read_ssu
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
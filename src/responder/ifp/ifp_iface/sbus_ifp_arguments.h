@@ -26,6 +26,7 @@
 #include <stdbool.h>
 #include <dbus/dbus.h>
 
+#include "sbus/frame/sbus_frame.h"
 #include "responder/ifp/ifp_iface/ifp_iface_types.h"
 
 struct _sbus_ifp_invoker_args_ao {
@@ -43,6 +44,22 @@ _sbus_ifp_invoker_write_ao
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_ao *args);
 
+struct _sbus_ifp_invoker_args_aos {
+    const char ** arg0;
+    const char * arg1;
+};
+
+errno_t
+_sbus_ifp_invoker_read_aos
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args);
+
+errno_t
+_sbus_ifp_invoker_write_aos
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args);
+
 struct _sbus_ifp_invoker_args_as {
     const char ** arg0;
 };
@@ -150,6 +167,24 @@ _sbus_ifp_invoker_write_ss
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_ss *args);
 
+struct _sbus_ifp_invoker_args_sssu {
+    const char * arg0;
+    const char * arg1;
+    const char * arg2;
+    uint32_t arg3;
+};
+
+errno_t
+_sbus_ifp_invoker_read_sssu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args);
+
+errno_t
+_sbus_ifp_invoker_write_sssu
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args);
+
 struct _sbus_ifp_invoker_args_ssu {
     const char * arg0;
     const char * arg1;
@@ -600,6 +600,69 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_sssu_out_aos
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     const char * arg1,
+     const char * arg2,
+     uint32_t arg3,
+     const char *** _arg0,
+     const char ** _arg1)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_sssu in;
+    struct _sbus_ifp_invoker_args_aos *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_aos);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+    in.arg3 = arg3;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_sssu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_aos, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_ssu_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -659,6 +722,67 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_ssu_out_aos
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     const char * arg1,
+     uint32_t arg2,
+     const char *** _arg0,
+     const char ** _arg1)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_ssu in;
+    struct _sbus_ifp_invoker_args_aos *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_aos);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_ssu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_aos, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_su_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -1079,6 +1203,25 @@ sbus_call_ifp_groups_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_sssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_cursor, arg_page_size,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_groups_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1094,6 +1237,24 @@ sbus_call_ifp_groups_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_ssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByNamePaged", arg_name_filter, arg_cursor, arg_page_size,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_group_UpdateMemberList
     (struct sbus_sync_connection *conn,
@@ -1192,6 +1353,25 @@ sbus_call_ifp_users_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_sssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_cursor, arg_page_size,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_users_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1207,6 +1387,24 @@ sbus_call_ifp_users_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_ssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByNamePaged", arg_name_filter, arg_cursor, arg_page_size,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_user_UpdateGroupsList
     (struct sbus_sync_connection *conn,
@@ -222,6 +222,19 @@ sbus_call_ifp_groups_ListByDomainAndName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_groups_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor);
+
 errno_t
 sbus_call_ifp_groups_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -232,6 +245,18 @@ sbus_call_ifp_groups_ListByName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_groups_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor);
+
 errno_t
 sbus_call_ifp_group_UpdateMemberList
     (struct sbus_sync_connection *conn,
@@ -296,6 +321,19 @@ sbus_call_ifp_users_ListByDomainAndName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_users_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor);
+
 errno_t
 sbus_call_ifp_users_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -306,6 +344,18 @@ sbus_call_ifp_users_ListByName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_users_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_page_size,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor);
+
 errno_t
 sbus_call_ifp_user_UpdateGroupsList
     (struct sbus_sync_connection *conn,
@@ -1238,6 +1238,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Groups.ListByDomainAndNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, const char *, uint32_t, const char ***, const char **); \
+    sbus_method_sync("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_sssu_out_aos_send, \
+        _sbus_ifp_key_sssu_0_1_2_3, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, const char *, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, const char **); \
+    sbus_method_async("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_sssu_out_aos_send, \
+        _sbus_ifp_key_sssu_0_1_2_3, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: org.freedesktop.sssd.infopipe.Groups.ListByName */
 #define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByName(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, const char ***); \
@@ -1260,6 +1282,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Groups.ListByNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, uint32_t, const char ***, const char **); \
+    sbus_method_sync("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssu_out_aos_send, \
+        _sbus_ifp_key_ssu_0_1_2, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, const char **); \
+    sbus_method_async("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssu_out_aos_send, \
+        _sbus_ifp_key_ssu_0_1_2, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: org.freedesktop.sssd.infopipe.Groups.Group */
 #define SBUS_IFACE_org_freedesktop_sssd_infopipe_Groups_Group(methods, signals, properties) ({ \
     sbus_interface("org.freedesktop.sssd.infopipe.Groups.Group", NULL, \
@@ -1601,6 +1645,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Users.ListByDomainAndNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, const char *, uint32_t, const char ***, const char **); \
+    sbus_method_sync("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_sssu_out_aos_send, \
+        _sbus_ifp_key_sssu_0_1_2_3, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, const char *, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, const char **); \
+    sbus_method_async("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_sssu_out_aos_send, \
+        _sbus_ifp_key_sssu_0_1_2_3, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: org.freedesktop.sssd.infopipe.Users.ListByName */
 #define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByName(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, const char ***); \
@@ -1623,6 +1689,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Users.ListByNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, uint32_t, const char ***, const char **); \
+    sbus_method_sync("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssu_out_aos_send, \
+        _sbus_ifp_key_ssu_0_1_2, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Users_ListByNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, const char **); \
+    sbus_method_async("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssu_out_aos_send, \
+        _sbus_ifp_key_ssu_0_1_2, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: org.freedesktop.sssd.infopipe.Users.User */
 #define SBUS_IFACE_org_freedesktop_sssd_infopipe_Users_User(methods, signals, properties) ({ \
     sbus_interface("org.freedesktop.sssd.infopipe.Users.User", NULL, \
@@ -53,7 +53,9 @@ _sbus_ifp_declare_invoker(s, o);
 _sbus_ifp_declare_invoker(s, s);
 _sbus_ifp_declare_invoker(sas, raw);
 _sbus_ifp_declare_invoker(ss, o);
+_sbus_ifp_declare_invoker(sssu, aos);
 _sbus_ifp_declare_invoker(ssu, ao);
+_sbus_ifp_declare_invoker(ssu, aos);
 _sbus_ifp_declare_invoker(su, ao);
 _sbus_ifp_declare_invoker(u, o);
 
@@ -36,6 +36,12 @@ _sbus_ifp_key_s_0
     struct sbus_request *sbus_req,
     struct _sbus_ifp_invoker_args_s *args);
 
+const char *
+_sbus_ifp_key_sssu_0_1_2_3
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_request *sbus_req,
+    struct _sbus_ifp_invoker_args_sssu *args);
+
 const char *
 _sbus_ifp_key_ssu_0_1_2
    (TALLOC_CTX *mem_ctx,
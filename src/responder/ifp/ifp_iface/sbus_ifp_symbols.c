@@ -287,6 +287,22 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "page_size"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -300,6 +316,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "page_size"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_Group_UpdateMemberList = {
     .input = (const struct sbus_argument[]){
@@ -386,6 +417,22 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "page_size"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -399,6 +446,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "page_size"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_User_UpdateGroupsList = {
     .input = (const struct sbus_argument[]){
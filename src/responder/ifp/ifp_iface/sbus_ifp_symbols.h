@@ -91,9 +91,15 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_FindByName;
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndName;
 
+extern const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged;
+
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName;
 
+extern const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged;
+
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_Group_UpdateMemberList;
 
@@ -115,9 +121,15 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByCertificate;
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndName;
 
+extern const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged;
+
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName;
 
+extern const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged;
+
 extern const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_User_UpdateGroupsList;
 
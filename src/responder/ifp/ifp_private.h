@@ -124,6 +124,54 @@ errno_t ifp_list_ctx_remaining_capacity(struct ifp_list_ctx *list_ctx,
                                         size_t entries,
                                         size_t *_capacity);
 
+/* Used for paged list calls. The cursor is an opaque string that names the
+ * domain and the last entry returned, an empty cursor starts at the first
+ * entry of the first domain. Larger page sizes are cut down to
+ * IFP_LIST_MAX_PAGE_SIZE. */
+#define IFP_LIST_DEFAULT_PAGE_SIZE 100
+#define IFP_LIST_MAX_PAGE_SIZE 1000
+
+char *ifp_list_cursor_compose(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *dom,
+                              const char *name);
+
+errno_t ifp_list_cursor_parse(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domains,
+                              const char *cursor,
+                              struct sss_domain_info **_dom,
+                              char **_name);
+
+struct ifp_list_page_ops {
+    enum sss_dp_acct_type dp_type;
+
+    int (*page_fn)(TALLOC_CTX *mem_ctx,
+                   struct sss_domain_info *domain,
+                   const char *name_filter,
+                   const char *after,
+                   size_t page_size,
+                   struct ldb_result **_res);
+
+    char *(*build_path_fn)(TALLOC_CTX *mem_ctx,
+                           struct sss_domain_info *domain,
+                           struct ldb_message *msg);
+};
+
+/* Lists one page of objects whose names match the filter, in all domains
+ * if domain is NULL. An empty next cursor is returned with the last page. */
+struct tevent_req *ifp_list_page_send(TALLOC_CTX *mem_ctx,
+                                      struct tevent_context *ev,
+                                      struct ifp_ctx *ctx,
+                                      const struct ifp_list_page_ops *ops,
+                                      const char *domain,
+                                      const char *filter,
+                                      const char *cursor,
+                                      uint32_t page_size);
+
+errno_t ifp_list_page_recv(TALLOC_CTX *mem_ctx,
+                           struct tevent_req *req,
+                           const char ***_paths,
+                           const char **_next_cursor);
+
 errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
                                struct ldb_message *msg,
                                const char *el_name,
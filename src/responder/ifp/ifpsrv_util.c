@@ -356,6 +356,360 @@ done:
     return ret;
 }
 
+#define IFP_LIST_CURSOR_SEP '/'
+
+char *ifp_list_cursor_compose(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *dom,
+                              const char *name)
+{
+    if (dom == NULL) {
+        return talloc_strdup(mem_ctx, "");
+    }
+
+    return talloc_asprintf(mem_ctx, "%s%c%s", dom->name, IFP_LIST_CURSOR_SEP,
+                           name == NULL ? "" : name);
+}
+
+errno_t ifp_list_cursor_parse(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domains,
+                              const char *cursor,
+                              struct sss_domain_info **_dom,
+                              char **_name)
+{
+    struct sss_domain_info *dom;
+    const char *sep;
+    char *domname;
+    char *name = NULL;
+
+    if (cursor == NULL || cursor[0] == '\0') {
+        *_dom = NULL;
+        *_name = NULL;
+        return EOK;
+    }
+
+    sep = strchr(cursor, IFP_LIST_CURSOR_SEP);
+    if (sep == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Malformed cursor [%s]\n", cursor);
+        return EINVAL;
+    }
+
+    domname = talloc_strndup(NULL, cursor, sep - cursor);
+    if (domname == NULL) {
+        return ENOMEM;
+    }
+
+    dom = find_domain_by_name(domains, domname, false);
+    talloc_free(domname);
+    if (dom == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unknown domain in cursor [%s]\n", cursor);
+        return ERR_DOMAIN_NOT_FOUND;
+    }
+
+    if (sep[1] != '\0') {
+        name = talloc_strdup(mem_ctx, sep + 1);
+        if (name == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    *_dom = dom;
+    *_name = name;
+
+    return EOK;
+}
+
+struct ifp_list_page_state {
+    struct ifp_ctx *ctx;
+    const struct ifp_list_page_ops *ops;
+    const char *filter;
+    bool all_domains;
+
+    /* position of the next page */
+    struct sss_domain_info *dom;
+    char *after;
+    bool refreshed;
+
+    const char **paths;
+    size_t page_size;
+    size_t path_count;
+    const char *next_cursor;
+};
+
+static errno_t ifp_list_page_step(struct tevent_req *req);
+static void ifp_list_page_done(struct tevent_req *subreq);
+
+struct tevent_req *ifp_list_page_send(TALLOC_CTX *mem_ctx,
+                                      struct tevent_context *ev,
+                                      struct ifp_ctx *ctx,
+                                      const struct ifp_list_page_ops *ops,
+                                      const char *domain,
+                                      const char *filter,
+                                      const char *cursor,
+                                      uint32_t page_size)
+{
+    struct ifp_list_page_state *state;
+    struct sss_domain_info *dom;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct ifp_list_page_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->ctx = ctx;
+    state->ops = ops;
+    state->filter = filter;
+    state->all_domains = (domain == NULL);
+
+    state->page_size = ifp_list_limit(ctx, page_size);
+    if (state->page_size == 0) {
+        state->page_size = IFP_LIST_DEFAULT_PAGE_SIZE;
+    } else if (state->page_size > IFP_LIST_MAX_PAGE_SIZE) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Page size %zu is cut down to %d\n",
+              state->page_size, IFP_LIST_MAX_PAGE_SIZE);
+        state->page_size = IFP_LIST_MAX_PAGE_SIZE;
+    }
+
+    state->paths = talloc_zero_array(state, const char *,
+                                     state->page_size + 1);
+    if (state->paths == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ifp_list_cursor_parse(state, ctx->rctx->domains, cursor,
+                                &state->dom, &state->after);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (state->all_domains) {
+        if (state->dom == NULL) {
+            state->dom = ctx->rctx->domains;
+        }
+    } else {
+        dom = find_domain_by_name(ctx->rctx->domains, domain, true);
+        if (dom == NULL) {
+            ret = ERR_DOMAIN_NOT_FOUND;
+            goto done;
+        }
+
+        if (state->dom == NULL) {
+            state->dom = dom;
+        } else if (state->dom != dom) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cursor [%s] does not belong to "
+                  "domain %s\n", cursor, domain);
+            ret = EINVAL;
+            goto done;
+        }
+    }
+
+    ret = ifp_list_page_step(req);
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static char *ifp_list_page_filter(TALLOC_CTX *mem_ctx,
+                                  struct ifp_list_page_state *state)
+{
+    char *name;
+
+    name = sss_get_cased_name(mem_ctx, state->filter,
+                              state->dom->case_sensitive);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    return sss_reverse_replace_space(mem_ctx, name,
+                                     state->ctx->rctx->override_space);
+}
+
+/* Reads the rest of the page from the current domain and moves to the next
+ * domain once the current one has no more entries. Only one entry more than
+ * fits into the page is read to find out whether the domain is done. */
+static errno_t ifp_list_page_fetch(struct ifp_list_page_state *state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    const char *filter;
+    const char *name;
+    size_t remaining;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    filter = ifp_list_page_filter(tmp_ctx, state);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    remaining = state->page_size - state->path_count;
+    ret = state->ops->page_fn(tmp_ctx, state->dom, filter, state->after,
+                              remaining + 1, &res);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to read a page from domain %s "
+              "[%d]: %s\n", state->dom->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (i = 0; i < res->count && i < remaining; i++) {
+        state->paths[state->path_count] = \
+                    state->ops->build_path_fn(state->paths, state->dom,
+                                              res->msgs[i]);
+        if (state->paths[state->path_count] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        state->path_count++;
+    }
+
+    if (res->count > remaining) {
+        name = ldb_msg_find_attr_as_string(res->msgs[remaining - 1],
+                                           SYSDB_NAME, NULL);
+        talloc_free(state->after);
+        state->after = talloc_strdup(state, name);
+        if (state->after == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    } else {
+        talloc_zfree(state->after);
+        state->refreshed = false;
+        state->dom = state->all_domains
+                            ? get_next_domain(state->dom, SSS_GND_DESCEND)
+                            : NULL;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t ifp_list_page_step(struct tevent_req *req)
+{
+    struct ifp_list_page_state *state;
+    struct tevent_req *subreq;
+    const char *filter;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct ifp_list_page_state);
+
+    while (state->dom != NULL) {
+        if (state->path_count == state->page_size) {
+            state->next_cursor = ifp_list_cursor_compose(state, state->dom,
+                                                         state->after);
+            if (state->next_cursor == NULL) {
+                return ENOMEM;
+            }
+
+            return EOK;
+        }
+
+        /* Refresh the domain before its first page only, the following
+         * pages are read from the cache. */
+        if (state->after == NULL && !state->refreshed
+                && NEED_CHECK_PROVIDER(state->dom->provider)) {
+            filter = ifp_list_page_filter(state, state);
+            if (filter == NULL) {
+                return ENOMEM;
+            }
+
+            subreq = sss_dp_get_account_send(state, state->ctx->rctx,
+                                             state->dom, true,
+                                             state->ops->dp_type, filter,
+                                             0, NULL);
+            if (subreq == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+                return ENOMEM;
+            }
+
+            tevent_req_set_callback(subreq, ifp_list_page_done, req);
+            return EAGAIN;
+        }
+
+        ret = ifp_list_page_fetch(state);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    state->next_cursor = "";
+    return EOK;
+}
+
+static void ifp_list_page_done(struct tevent_req *subreq)
+{
+    struct ifp_list_page_state *state;
+    struct tevent_req *req;
+    const char *err_msg;
+    uint16_t err_maj;
+    uint32_t err_min;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ifp_list_page_state);
+
+    /* Use subreq as memory context so err_msg is freed with it. */
+    ret = sss_dp_get_account_recv(subreq, subreq, &err_maj, &err_min,
+                                  &err_msg);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not refresh domain %s [%d]: %s, "
+              "returning cached data\n", state->dom->name,
+              ret, sss_strerror(ret));
+    } else if (err_maj) {
+        DEBUG(SSSDBG_OP_FAILURE, "Data Provider Error: %u, %u, %s, "
+              "returning cached data\n", (unsigned int)err_maj,
+              (unsigned int)err_min, err_msg);
+    }
+    talloc_zfree(subreq);
+
+    state->refreshed = true;
+
+    ret = ifp_list_page_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+errno_t ifp_list_page_recv(TALLOC_CTX *mem_ctx,
+                           struct tevent_req *req,
+                           const char ***_paths,
+                           const char **_next_cursor)
+{
+    struct ifp_list_page_state *state;
+    state = tevent_req_data(req, struct ifp_list_page_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_paths = talloc_steal(mem_ctx, state->paths);
+    *_next_cursor = talloc_strdup(mem_ctx, state->next_cursor);
+    if (*_next_cursor == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
 errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
                                struct ldb_message *msg,
                                const char *el_name,
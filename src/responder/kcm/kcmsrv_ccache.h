@@ -121,10 +121,13 @@ struct kcm_cred *kcm_cc_next_cred(struct kcm_cred *crd);
 struct kcm_ccdb;
 
 /*
- * Initialize a ccache database of type cc_be
+ * Initialize a ccache database of type cc_be, the back end reads its
+ * options from the confdb_service_path section of cdb
  */
 struct kcm_ccdb *kcm_ccdb_init(TALLOC_CTX *mem_ctx,
                                struct tevent_context *ev,
+                               struct confdb_ctx *cdb,
+                               const char *confdb_service_path,
                                enum kcm_ccdb_be cc_be);
 
 /*
@@ -342,4 +345,34 @@ errno_t kcm_ccache_to_sec_input(TALLOC_CTX *mem_ctx,
                                 struct cli_creds *client,
                                 struct sss_iobuf **_payload);
 
+/*
+ * ccache marshalling to and from the binary format used by the secdb
+ * back end. Unlike JSON, the credentials can be appended and the KDC
+ * offset changed without decoding the whole ccache.
+ */
+
+/* Returns true if sec_value is a ccache in the binary format */
+bool sec_binary_is_ccache(struct sss_iobuf *sec_value);
+
+errno_t kcm_ccache_to_sec_binary(TALLOC_CTX *mem_ctx,
+                                 struct kcm_ccache *cc,
+                                 struct sss_iobuf **_payload);
+
+errno_t sec_binary_to_ccache(TALLOC_CTX *mem_ctx,
+                             const char *sec_key,
+                             struct sss_iobuf *sec_value,
+                             struct cli_creds *client,
+                             struct kcm_ccache **_cc);
+
+/* Return a copy of sec_value with the credentials appended */
+errno_t sec_binary_append_cred(TALLOC_CTX *mem_ctx,
+                               struct sss_iobuf *sec_value,
+                               uuid_t uuid,
+                               struct sss_iobuf *cred_blob,
+                               struct sss_iobuf **_payload);
+
+/* Change the KDC offset of sec_value in place */
+errno_t sec_binary_set_offset(struct sss_iobuf *sec_value,
+                              int32_t kdc_offset);
+
 #endif /* _KCMSRV_CCACHE_H_ */
@@ -0,0 +1,572 @@
+/*
+   SSSD
+
+   KCM Server - binary ccache (un)marshalling for storing ccaches in
+                the secrets database
+
+   Copyright (C) Red Hat, 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/util_creds.h"
+#include "responder/kcm/kcmsrv_ccache_pvt.h"
+
+/*
+ * The binary ccache is formatted as:
+ *
+ *      uint32 magic
+ *      uint32 version
+ *      int32  kdc_offset
+ *      uint32 number of credentials
+ *      uint32 1 if the principal is set, 0 otherwise
+ *          int32  type
+ *          uint32 realm length, realm
+ *          uint32 number of components
+ *              uint32 component length, component
+ *      credentials:
+ *          16 bytes uuid
+ *          uint32 blob length, blob
+ *
+ * The fields before the principal have a fixed position so that the
+ * kdc_offset can be changed and a credential can be appended without
+ * parsing the rest of the ccache. Credentials are stored in the order
+ * they were added.
+ */
+#define KS_BINARY_MAGIC         0x4b434d42 /* KCMB */
+#define KS_BINARY_VERSION       1
+
+#define KS_BINARY_OFFSET_POS    (2 * sizeof(uint32_t))
+#define KS_BINARY_NCREDS_POS    (3 * sizeof(uint32_t))
+#define KS_BINARY_HEADER_SIZE   (4 * sizeof(uint32_t))
+
+bool sec_binary_is_ccache(struct sss_iobuf *sec_value)
+{
+    uint32_t magic;
+
+    if (sec_value == NULL
+            || sss_iobuf_get_size(sec_value) < KS_BINARY_HEADER_SIZE) {
+        return false;
+    }
+
+    memcpy(&magic, sss_iobuf_get_data(sec_value), sizeof(uint32_t));
+    return magic == KS_BINARY_MAGIC;
+}
+
+static errno_t krb5_data_to_binary(struct sss_iobuf *buf,
+                                   krb5_data *data)
+{
+    errno_t ret;
+
+    ret = sss_iobuf_write_uint32(buf, data->length);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sss_iobuf_write_len(buf, (uint8_t *) data->data, data->length);
+}
+
+static errno_t princ_to_binary(struct sss_iobuf *buf,
+                               krb5_principal princ)
+{
+    errno_t ret;
+
+    if (princ == NULL) {
+        return sss_iobuf_write_uint32(buf, 0);
+    }
+
+    ret = sss_iobuf_write_uint32(buf, 1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_write_int32(buf, princ->type);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = krb5_data_to_binary(buf, &princ->realm);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, princ->length);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (krb5_int32 i = 0; i < princ->length; i++) {
+        ret = krb5_data_to_binary(buf, &princ->data[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t cred_to_binary(struct sss_iobuf *buf,
+                              uuid_t uuid,
+                              struct sss_iobuf *cred_blob)
+{
+    errno_t ret;
+
+    ret = sss_iobuf_write_len(buf, uuid, sizeof(uuid_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, sss_iobuf_get_size(cred_blob));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sss_iobuf_write_len(buf,
+                               sss_iobuf_get_data(cred_blob),
+                               sss_iobuf_get_size(cred_blob));
+}
+
+errno_t kcm_ccache_to_sec_binary(TALLOC_CTX *mem_ctx,
+                                 struct kcm_ccache *cc,
+                                 struct sss_iobuf **_payload)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_iobuf *buf;
+    struct sss_iobuf *payload;
+    struct kcm_cred **creds;
+    struct kcm_cred *crd;
+    uint32_t ncreds = 0;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    buf = sss_iobuf_init_empty(tmp_ctx, KS_BINARY_HEADER_SIZE, 0);
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        ncreds++;
+    }
+
+    /* The list starts with the newest credential */
+    creds = talloc_array(tmp_ctx, struct kcm_cred *, ncreds);
+    if (creds == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ncreds = 0;
+    DLIST_FOR_EACH(crd, cc->creds) {
+        creds[ncreds++] = crd;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, KS_BINARY_MAGIC);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, KS_BINARY_VERSION);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_write_int32(buf, cc->kdc_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, ncreds);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = princ_to_binary(buf, cc->client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot store the principal\n");
+        goto done;
+    }
+
+    for (uint32_t i = ncreds; i > 0; i--) {
+        ret = cred_to_binary(buf, creds[i - 1]->uuid,
+                             creds[i - 1]->cred_blob);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot store credentials\n");
+            goto done;
+        }
+    }
+
+    /* The buffer grows in steps, only return what was written */
+    payload = sss_iobuf_init_readonly(mem_ctx,
+                                      sss_iobuf_get_data(buf),
+                                      sss_iobuf_get_len(buf));
+    if (payload == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    *_payload = payload;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t binary_to_krb5_data(TALLOC_CTX *mem_ctx,
+                                   struct sss_iobuf *buf,
+                                   krb5_data *data)
+{
+    uint32_t len;
+    errno_t ret;
+
+    ret = sss_iobuf_read_uint32(buf, &len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (len > sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf)) {
+        return EINVAL;
+    }
+
+    /* Keep the data NULL terminated like the JSON representation does */
+    data->data = talloc_zero_array(mem_ctx, char, len + 1);
+    if (data->data == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_read_len(buf, len, (uint8_t *) data->data);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data->length = len;
+    data->magic = 0;
+
+    return EOK;
+}
+
+static errno_t binary_to_princ(TALLOC_CTX *mem_ctx,
+                               struct sss_iobuf *buf,
+                               krb5_principal *_princ)
+{
+    krb5_principal princ;
+    uint32_t has_princ;
+    uint32_t ncomp;
+    errno_t ret;
+
+    ret = sss_iobuf_read_uint32(buf, &has_princ);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (has_princ == 0) {
+        *_princ = NULL;
+        return EOK;
+    }
+
+    princ = talloc_zero(mem_ctx, struct krb5_principal_data);
+    if (princ == NULL) {
+        return ENOMEM;
+    }
+    princ->magic = KV5M_PRINCIPAL;
+
+    ret = sss_iobuf_read_int32(buf, &princ->type);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = binary_to_krb5_data(princ, buf, &princ->realm);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_read_uint32(buf, &ncomp);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* every component takes at least its length */
+    if (ncomp > INT32_MAX
+            || ncomp > (sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf))
+                            / sizeof(uint32_t)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Too many principal components.\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    princ->data = talloc_zero_array(princ, krb5_data, ncomp);
+    if (princ->data == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (uint32_t i = 0; i < ncomp; i++) {
+        ret = binary_to_krb5_data(princ->data, buf, &princ->data[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+    princ->length = (krb5_int32) ncomp;
+
+    *_princ = princ;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(princ);
+    }
+    return ret;
+}
+
+static errno_t binary_to_cred(TALLOC_CTX *mem_ctx,
+                              struct sss_iobuf *buf,
+                              struct kcm_cred **_crd)
+{
+    struct sss_iobuf *cred_blob;
+    struct kcm_cred *crd;
+    uuid_t uuid;
+    uint32_t len;
+    errno_t ret;
+
+    ret = sss_iobuf_read_len(buf, sizeof(uuid_t), uuid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_read_uint32(buf, &len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (len > sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf)) {
+        return EINVAL;
+    }
+
+    cred_blob = sss_iobuf_init_readonly(mem_ctx, NULL, len);
+    if (cred_blob == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_read_len(buf, len, sss_iobuf_get_data(cred_blob));
+    if (ret != EOK) {
+        talloc_free(cred_blob);
+        return ret;
+    }
+
+    crd = kcm_cred_new(mem_ctx, uuid, cred_blob);
+    if (crd == NULL) {
+        talloc_free(cred_blob);
+        return ENOMEM;
+    }
+
+    *_crd = crd;
+    return EOK;
+}
+
+errno_t sec_binary_to_ccache(TALLOC_CTX *mem_ctx,
+                             const char *sec_key,
+                             struct sss_iobuf *sec_value,
+                             struct cli_creds *client,
+                             struct kcm_ccache **_cc)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct kcm_ccache *cc;
+    struct kcm_cred *crd;
+    struct sss_iobuf *buf;
+    const char *name;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ncreds;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* read from a private copy, the caller's position is left intact */
+    buf = sss_iobuf_init_readonly(tmp_ctx,
+                                  sss_iobuf_get_data(sec_value),
+                                  sss_iobuf_get_size(sec_value));
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    cc = talloc_zero(tmp_ctx, struct kcm_ccache);
+    if (cc == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* We rely on the secrets database only searching the user's subtree
+     * so we set the ownership to the client
+     */
+    cc->owner.uid = cli_creds_get_uid(client);
+    cc->owner.gid = cli_creds_get_gid(client);
+
+    name = sec_key_get_name(sec_key);
+    if (name == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    cc->name = talloc_strdup(cc, name);
+    if (cc->name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sec_key_get_uuid(sec_key, cc->uuid);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_read_uint32(buf, &magic);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_read_uint32(buf, &version);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (magic != KS_BINARY_MAGIC || version != KS_BINARY_VERSION) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unexpected binary ccache magic %#x or version %u\n",
+              magic, version);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = sss_iobuf_read_int32(buf, &cc->kdc_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_read_uint32(buf, &ncreds);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = binary_to_princ(cc, buf, &cc->client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot read the principal [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (uint32_t i = 0; i < ncreds; i++) {
+        ret = binary_to_cred(cc, buf, &crd);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot read credential %u of %u [%d]: %s\n",
+                  i, ncreds, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        ret = kcm_cc_store_creds(cc, crd);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    *_cc = talloc_steal(mem_ctx, cc);
+    ret = EOK;
+
+done:
+    if (ret == ENOBUFS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Binary ccache is truncated\n");
+        ret = EINVAL;
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sec_binary_append_cred(TALLOC_CTX *mem_ctx,
+                               struct sss_iobuf *sec_value,
+                               uuid_t uuid,
+                               struct sss_iobuf *cred_blob,
+                               struct sss_iobuf **_payload)
+{
+    struct sss_iobuf *buf;
+    uint32_t ncreds;
+    errno_t ret;
+
+    if (!sec_binary_is_ccache(sec_value)) {
+        return EINVAL;
+    }
+
+    buf = sss_iobuf_init_empty(mem_ctx,
+                               sss_iobuf_get_size(sec_value)
+                                    + sizeof(uuid_t) + sizeof(uint32_t)
+                                    + sss_iobuf_get_size(cred_blob),
+                               0);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_write_len(buf,
+                              sss_iobuf_get_data(sec_value),
+                              sss_iobuf_get_size(sec_value));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = cred_to_binary(buf, uuid, cred_blob);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    memcpy(&ncreds, sss_iobuf_get_data(buf) + KS_BINARY_NCREDS_POS,
+           sizeof(uint32_t));
+    ncreds++;
+    memcpy(sss_iobuf_get_data(buf) + KS_BINARY_NCREDS_POS, &ncreds,
+           sizeof(uint32_t));
+
+    *_payload = buf;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(buf);
+    }
+    return ret;
+}
+
+errno_t sec_binary_set_offset(struct sss_iobuf *sec_value,
+                              int32_t kdc_offset)
+{
+    if (!sec_binary_is_ccache(sec_value)) {
+        return EINVAL;
+    }
+
+    memcpy(sss_iobuf_get_data(sec_value) + KS_BINARY_OFFSET_POS,
+           &kdc_offset, sizeof(int32_t));
+
+    return EOK;
+}
@@ -59,4 +59,10 @@ struct kcm_ccache {
     struct kcm_cred *creds;
 };
 
+/* In order to provide a consistent interface, we need to let the caller
+ * of getbyXXX own the ccache, therefore the back ends that keep ccaches
+ * in memory return a shallow copy of the ccache
+ */
+struct kcm_ccache *kcm_cc_dup(TALLOC_CTX *mem_ctx, struct kcm_ccache *in);
+
 #endif /* _KCMSRV_CCACHE_PVT_H */
@@ -23,8 +23,11 @@
 
 #include <talloc.h>
 #include <stdio.h>
+#include <signal.h>
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "confdb/confdb.h"
 #include "util/secrets/secrets.h"
 #include "util/crypto/sss_crypto.h"
 #include "responder/kcm/kcmsrv_ccache_pvt.h"
@@ -35,6 +38,13 @@
 #define KCM_SECDB_CCACHE_FMT  KCM_SECDB_BASE_FMT"ccache/"
 #define KCM_SECDB_DFL_FMT     KCM_SECDB_BASE_FMT"default"
 
+/* Pending writes must be flushed before the responder exits because it
+ * is idle, the minimal idle timeout is 60 seconds */
+#define KCM_SECDB_MAX_WRITE_BACK_INTERVAL 30
+
+/* A change that could not be written this many times is dropped */
+#define KCM_SECDB_MAX_FLUSH_ATTEMPTS 5
+
 static errno_t sec_get_b64(TALLOC_CTX *mem_ctx,
                            struct sss_sec_req *req,
                            struct sss_iobuf **_buf)
@@ -206,7 +216,7 @@ static errno_t kcm_ccache_to_secdb_kv(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = kcm_ccache_to_sec_input(mem_ctx, cc, client, &payload);
+    ret = kcm_ccache_to_sec_binary(mem_ctx, cc, &payload);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Cannot convert ccache to a secret [%d][%s]\n", ret, sss_strerror(ret));
@@ -222,8 +232,76 @@ done:
     return ret;
 }
 
+/* The keys of all ccaches of a user, indexed by UUID and by name. The
+ * same entry is stored in both tables so freeing it removes it from both.
+ */
+struct secdb_index {
+    hash_table_t *by_uuid;
+    hash_table_t *by_name;
+
+    const char *uid;
+    const char *container_url;
+
+    /* The default ccache, only cached in the write-back mode */
+    bool dfl_loaded;
+    uuid_t dfl;
+
+    /* Number of the user's ccaches that were not stored yet */
+    unsigned int unstored;
+};
+
+struct secdb_index_entry {
+    const char *key;
+    const char *url;
+    const char *container_url;
+    struct ccdb_secdb *secdb;
+    struct secdb_index *idx;
+
+    /* In the write-back mode the ccache is kept in memory once it was
+     * read or created. A dirty ccache was changed since it was written
+     * to the database, a ccache that was not stored yet is only in
+     * memory. */
+    struct kcm_ccache *cc;
+    bool stored;
+    bool dirty;
+    unsigned int flush_failures;
+
+    struct secdb_index_entry *prev;
+    struct secdb_index_entry *next;
+};
+
+/* A ccache that was deleted in the write-back mode but is still in the
+ * database */
+struct secdb_pending_delete {
+    const char *uid;
+    const char *url;
+    const char *container_url;
+    unsigned int flush_failures;
+
+    struct secdb_pending_delete *prev;
+    struct secdb_pending_delete *next;
+};
+
 struct ccdb_secdb {
     struct sss_sec_ctx *sctx;
+
+    /* uid -> struct secdb_index. The KCM responder is the only writer
+     * of the database, so the index is built from a single listing of
+     * the user's container and kept up to date on create and delete.
+     */
+    hash_table_t *index;
+
+    /* If non-zero, ccaches are served from memory and changes are
+     * written to the database at most this many seconds later */
+    uint32_t write_back_interval;
+    struct tevent_context *ev;
+    struct tevent_timer *flush_te;
+    struct secdb_index_entry *dirty;
+    struct secdb_pending_delete *deleted;
+
+    /* Number of ccaches that were not stored yet, the quotas of the
+     * database do not see them */
+    unsigned int unstored;
 };
 
 /* Since with the synchronous database, the database operations are just
@@ -365,162 +443,959 @@ done:
     return ret;
 }
 
-static errno_t key_by_uuid(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
-                           struct cli_creds *client,
-                           uuid_t uuid,
-                           char **_key)
+static const char *secdb_index_uid(TALLOC_CTX *mem_ctx,
+                                   struct cli_creds *client)
 {
-    TALLOC_CTX *tmp_ctx;
+    return talloc_asprintf(mem_ctx, "%"SPRIuid, cli_creds_get_uid(client));
+}
+
+static void secdb_entry_set_stored(struct secdb_index_entry *entry,
+                                   bool stored)
+{
+    if (entry->stored == stored) {
+        return;
+    }
+
+    if (stored) {
+        entry->idx->unstored--;
+        entry->secdb->unstored--;
+    } else {
+        entry->idx->unstored++;
+        entry->secdb->unstored++;
+    }
+
+    entry->stored = stored;
+}
+
+static int secdb_index_entry_destructor(struct secdb_index_entry *entry)
+{
+    if (entry->dirty) {
+        DLIST_REMOVE(entry->secdb->dirty, entry);
+    }
+
+    secdb_entry_set_stored(entry, true);
+    return 0;
+}
+
+static errno_t secdb_index_add(struct ccdb_secdb *secdb,
+                               struct secdb_index *idx,
+                               const char *secdb_key,
+                               struct secdb_index_entry **_entry)
+{
+    struct secdb_index_entry *entry;
+    char uuid_str[UUID_STR_SIZE];
+    const char *name;
+    uuid_t uuid;
     errno_t ret;
-    char *key_match = NULL;
+
+    name = sec_key_get_name(secdb_key);
+    if (name == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed key %s\n", secdb_key);
+        return EINVAL;
+    }
+
+    ret = sec_key_get_uuid(secdb_key, uuid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed key %s\n", secdb_key);
+        return ret;
+    }
+    uuid_unparse(uuid, uuid_str);
+
+    entry = talloc_zero(idx, struct secdb_index_entry);
+    if (entry == NULL) {
+        return ENOMEM;
+    }
+
+    entry->key = talloc_strdup(entry, secdb_key);
+    if (entry->key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    entry->url = talloc_asprintf(entry, "%s%s",
+                                 idx->container_url, secdb_key);
+    if (entry->url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    entry->container_url = idx->container_url;
+    entry->secdb = secdb;
+    entry->idx = idx;
+    entry->stored = true;
+    talloc_set_destructor(entry, secdb_index_entry_destructor);
+
+    ret = sss_ptr_hash_add_or_override(idx->by_uuid, uuid_str, entry,
+                                       struct secdb_index_entry);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add_or_override(idx->by_name, name, entry,
+                                       struct secdb_index_entry);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_entry != NULL) {
+        *_entry = entry;
+    }
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(entry);
+    }
+    return ret;
+}
+
+static errno_t secdb_index_build(struct ccdb_secdb *secdb,
+                                 struct cli_creds *client,
+                                 struct secdb_index **_idx)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct secdb_index *idx;
+    struct sss_sec_req *sreq;
     char **keys = NULL;
     size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
+    errno_t ret;
 
-    tmp_ctx = talloc_new(mem_ctx);
+    tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
+    idx = talloc_zero(tmp_ctx, struct secdb_index);
+    if (idx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    idx->by_uuid = sss_ptr_hash_create(idx, NULL, NULL);
+    idx->by_name = sss_ptr_hash_create(idx, NULL, NULL);
+    if (idx->by_uuid == NULL || idx->by_name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    idx->uid = secdb_index_uid(idx, client);
+    idx->container_url = secdb_container_url_create(idx, client);
+    if (idx->uid == NULL || idx->container_url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = secdb_container_url_req(tmp_ctx, secdb->sctx, client, &sreq);
     if (ret != EOK) {
         goto done;
     }
 
     ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
     if (ret == ENOENT) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
-        goto done;
+        nkeys = 0;
     } else if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot list keys [%d]: %s\n", ret, sss_strerror(ret));
         goto done;
     }
 
     for (size_t i = 0; i < nkeys; i++) {
-        if (sec_key_match_uuid(keys[i], uuid)) {
-            key_match = keys[i];
-            break;
+        ret = secdb_index_add(secdb, idx, keys[i], NULL);
+        if (ret != EOK) {
+            goto done;
         }
     }
 
-    if (key_match == NULL) {
-        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
-        ret = ENOENT;
+    DEBUG(SSSDBG_TRACE_INTERNAL,
+          "Indexed %zu ccaches of user %"SPRIuid"\n",
+          nkeys, cli_creds_get_uid(client));
+
+    *_idx = talloc_steal(secdb, idx);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t secdb_index_get(struct ccdb_secdb *secdb,
+                               struct cli_creds *client,
+                               struct secdb_index **_idx)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct secdb_index *idx;
+    const char *uid;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    uid = secdb_index_uid(tmp_ctx, client);
+    if (uid == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    idx = sss_ptr_hash_lookup(secdb->index, uid, struct secdb_index);
+    if (idx != NULL) {
+        *_idx = idx;
+        ret = EOK;
+        goto done;
+    }
+
+    ret = secdb_index_build(secdb, client, &idx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(secdb->index, uid, idx, struct secdb_index);
+    if (ret != EOK) {
+        talloc_free(idx);
         goto done;
     }
 
+    *_idx = idx;
     ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", key_match);
-    *_key = talloc_steal(mem_ctx, key_match);
+
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
+/* Forget the index of the user, it is rebuilt on the next lookup. Used
+ * when the database does not match the index anymore. */
+static void secdb_index_drop(struct ccdb_secdb *secdb,
+                             struct cli_creds *client)
+{
+    const char *uid;
+
+    uid = secdb_index_uid(NULL, client);
+    if (uid == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_MINOR_FAILURE,
+          "Dropping the ccache index of user %s\n", uid);
+    sss_ptr_hash_delete(secdb->index, uid, true);
+    talloc_free(discard_const(uid));
+}
+
+static errno_t entry_by_uuid(struct ccdb_secdb *secdb,
+                             struct cli_creds *client,
+                             uuid_t uuid,
+                             struct secdb_index_entry **_entry)
+{
+    struct secdb_index_entry *entry;
+    struct secdb_index *idx;
+    char uuid_str[UUID_STR_SIZE];
+    errno_t ret;
+
+    ret = secdb_index_get(secdb, client, &idx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    uuid_unparse(uuid, uuid_str);
+    entry = sss_ptr_hash_lookup(idx->by_uuid, uuid_str,
+                                struct secdb_index_entry);
+    if (entry == NULL) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
+        return ENOENT;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", entry->key);
+    *_entry = entry;
+    return EOK;
+}
+
+static errno_t entry_by_name(struct ccdb_secdb *secdb,
+                             struct cli_creds *client,
+                             const char *name,
+                             struct secdb_index_entry **_entry)
+{
+    struct secdb_index_entry *entry;
+    struct secdb_index *idx;
+    errno_t ret;
+
+    ret = secdb_index_get(secdb, client, &idx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    entry = sss_ptr_hash_lookup(idx->by_name, name,
+                                struct secdb_index_entry);
+    if (entry == NULL) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
+        return ENOENT;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", entry->key);
+    *_entry = entry;
+    return EOK;
+}
+
+static errno_t key_by_uuid(TALLOC_CTX *mem_ctx,
+                           struct ccdb_secdb *secdb,
+                           struct cli_creds *client,
+                           uuid_t uuid,
+                           char **_key)
+{
+    struct secdb_index_entry *entry;
+    char *key;
+    errno_t ret;
+
+    ret = entry_by_uuid(secdb, client, uuid, &entry);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key = talloc_strdup(mem_ctx, entry->key);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    *_key = key;
+    return EOK;
+}
+
 static errno_t key_by_name(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
+                           struct ccdb_secdb *secdb,
                            struct cli_creds *client,
                            const char *name,
                            char **_key)
 {
-    TALLOC_CTX *tmp_ctx;
+    struct secdb_index_entry *entry;
+    char *key;
     errno_t ret;
-    char *key_match = NULL;
-    char **keys = NULL;
-    size_t nkeys;
+
+    ret = entry_by_name(secdb, client, name, &entry);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key = talloc_strdup(mem_ctx, entry->key);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    *_key = key;
+    return EOK;
+}
+
+static errno_t secdb_get_cc_payload(TALLOC_CTX *mem_ctx,
+                                    struct sss_sec_ctx *sctx,
+                                    const char *secdb_key,
+                                    struct cli_creds *client,
+                                    struct sss_iobuf **_ccbuf)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct sss_iobuf *ccbuf;
 
     tmp_ctx = talloc_new(mem_ctx);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
+    ret = secdb_cc_key_req(tmp_ctx, sctx, client, secdb_key, &sreq);
     if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot create secdb request [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
     }
 
-    ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
+    ret = sec_get_b64(tmp_ctx, sreq, &ccbuf);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the secret [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
-    } else if (ret != EOK) {
+    }
+
+    ret = EOK;
+    *_ccbuf = talloc_steal(mem_ctx, ccbuf);
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* ccaches are written in the binary format, ccaches written by older
+ * versions are stored as JSON and converted when they are modified. */
+static errno_t secdb_payload_to_cc(TALLOC_CTX *mem_ctx,
+                                   const char *secdb_key,
+                                   struct sss_iobuf *ccbuf,
+                                   struct cli_creds *client,
+                                   struct kcm_ccache **_cc)
+{
+    errno_t ret;
+
+    if (sec_binary_is_ccache(ccbuf)) {
+        ret = sec_binary_to_ccache(mem_ctx, secdb_key, ccbuf, client, _cc);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot convert binary ccache [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+        return ret;
+    }
+
+    ret = sec_kv_to_ccache(mem_ctx,
+                           secdb_key,
+                           (const char *) sss_iobuf_get_data(ccbuf),
+                           client,
+                           _cc);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot convert JSON keyval to ccache blob [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+    return ret;
+}
+
+static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
+                            struct sss_sec_ctx *sctx,
+                            const char *secdb_key,
+                            struct cli_creds *client,
+                            struct kcm_ccache **_cc)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx = NULL;
+    struct kcm_ccache *cc = NULL;
+    struct sss_iobuf *ccbuf;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = secdb_get_cc_payload(tmp_ctx, sctx, secdb_key, client, &ccbuf);
+    if (ret != EOK) {
         goto done;
     }
 
-    for (size_t i = 0; i < nkeys; i++) {
-        if (sec_key_match_name(keys[i], name)) {
-            key_match = keys[i];
-            break;
+    ret = secdb_payload_to_cc(tmp_ctx, secdb_key, ccbuf, client, &cc);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = EOK;
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache\n");
+    *_cc = talloc_steal(mem_ctx, cc);
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Check that cc could be written as secdb_key by the next flush, so that
+ * the client gets the error instead of the flush. entry is NULL for a new
+ * ccache. The quotas of the database only count the ccaches that were
+ * written, add the ones which are only in memory. A stored ccache does not
+ * change the number of secrets. */
+static errno_t secdb_check_write(struct ccdb_secdb *secdb,
+                                 struct secdb_index *idx,
+                                 struct cli_creds *client,
+                                 const char *secdb_key,
+                                 struct secdb_index_entry *entry,
+                                 struct kcm_ccache *cc)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    struct sss_iobuf *payload;
+    unsigned int pending = secdb->unstored;
+    unsigned int pending_uid = idx->unstored;
+    size_t b64_len;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = secdb_cc_key_req(tmp_ctx, secdb->sctx, client, secdb_key, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (entry == NULL || !entry->stored) {
+        if (entry != NULL) {
+            /* The ccache is one of the pending ones */
+            pending--;
+            pending_uid--;
+        }
+
+        ret = sss_sec_check_quota(sreq, pending, pending_uid);
+        if (ret != EOK) {
+            goto done;
         }
     }
 
-    if (key_match == NULL) {
-        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
-        ret = ENOENT;
-        goto done;
-    }
+    ret = kcm_ccache_to_sec_binary(tmp_ctx, cc, &payload);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* The payload is stored base64 encoded */
+    b64_len = (sss_iobuf_get_size(payload) + 2) / 3 * 4;
+    ret = sss_sec_check_payload_size(sreq, b64_len);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot write ccache %s [%d]: %s\n",
+              secdb_key, ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static bool secdb_write_back(struct ccdb_secdb *secdb)
+{
+    return secdb->write_back_interval > 0;
+}
+
+static errno_t secdb_flush_delete(struct ccdb_secdb *secdb,
+                                  struct secdb_pending_delete *del)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, NULL, del->url, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_sec_delete(sreq);
+    if (ret != EOK && ret != ENOENT) {
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Remove the container of a user who has no ccaches left, the container
+ * is not removed if it still contains ccaches that are being deleted */
+static void secdb_flush_container(struct ccdb_secdb *secdb,
+                                  struct secdb_pending_delete *del)
+{
+    struct secdb_index *idx;
+    struct sss_sec_req *sreq;
+    errno_t ret;
+
+    idx = sss_ptr_hash_lookup(secdb->index, del->uid, struct secdb_index);
+    if (idx == NULL || hash_count(idx->by_uuid) > 0) {
+        return;
+    }
+
+    ret = secdb_cc_url_req(del, secdb->sctx, NULL, del->container_url, &sreq);
+    if (ret != EOK) {
+        return;
+    }
+
+    ret = sss_sec_delete(sreq);
+    if (ret != EOK && ret != ENOENT && ret != EEXIST) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot remove ccache container %s [%d]: %s\n",
+              del->container_url, ret, sss_strerror(ret));
+    }
+    talloc_free(sreq);
+}
+
+static errno_t secdb_flush_entry(struct ccdb_secdb *secdb,
+                                 struct secdb_index_entry *entry)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *container_req;
+    struct sss_sec_req *sreq;
+    struct sss_iobuf *payload;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = kcm_ccache_to_sec_binary(tmp_ctx, entry->cc, &payload);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, NULL, entry->url, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (entry->stored) {
+        ret = sec_update_b64(tmp_ctx, sreq, payload);
+        goto done;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, NULL,
+                           entry->container_url, &container_req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_sec_create_container(container_req);
+    if (ret != EOK && ret != EEXIST) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to create the ccache container\n");
+        goto done;
+    }
+
+    ret = sec_put_b64(tmp_ctx, sreq, payload);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    secdb_entry_set_stored(entry, true);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Errors that writing the same change again cannot fix */
+static bool secdb_flush_error_is_permanent(errno_t ret)
+{
+    switch (ret) {
+    case EINVAL:
+    case ERR_SEC_INVALID_CONTAINERS_NEST_LEVEL:
+    case ERR_SEC_INVALID_TOO_MANY_SECRETS:
+    case ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Give up on a change that cannot be written. A ccache that was never
+ * stored is removed, otherwise its changes are dropped and the ccache is
+ * read from the database again when it is needed. */
+static void secdb_entry_discard(struct secdb_index_entry *entry,
+                                errno_t error)
+{
+    if (!entry->stored) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot write %s [%d]: %s, removing the ccache\n",
+              entry->url, error, sss_strerror(error));
+        talloc_free(entry);
+        return;
+    }
+
+    DEBUG(SSSDBG_CRIT_FAILURE,
+          "Cannot write %s [%d]: %s, reverting to the stored ccache\n",
+          entry->url, error, sss_strerror(error));
+    DLIST_REMOVE(entry->secdb->dirty, entry);
+    entry->dirty = false;
+    entry->flush_failures = 0;
+    talloc_zfree(entry->cc);
+}
+
+static void secdb_schedule_flush(struct ccdb_secdb *secdb);
+
+/* Write all pending changes to the database. Deletions go first so that
+ * emptied containers can be removed. Failed writes are retried later
+ * unless retry is false, which is the case when the responder exits, or
+ * the change cannot be written at all. */
+static void secdb_flush(struct ccdb_secdb *secdb, bool retry)
+{
+    struct secdb_pending_delete *del;
+    struct secdb_pending_delete *del_next;
+    struct secdb_index_entry *entry;
+    struct secdb_index_entry *entry_next;
+    unsigned int written = 0;
+    errno_t ret;
+
+    for (del = secdb->deleted; del != NULL; del = del_next) {
+        del_next = del->next;
+
+        ret = secdb_flush_delete(secdb, del);
+        if (ret != EOK) {
+            del->flush_failures++;
+            if (secdb_flush_error_is_permanent(ret)
+                    || del->flush_failures >= KCM_SECDB_MAX_FLUSH_ATTEMPTS) {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "Cannot delete %s [%d]: %s, giving up\n",
+                      del->url, ret, sss_strerror(ret));
+                DLIST_REMOVE(secdb->deleted, del);
+                talloc_free(del);
+                continue;
+            }
+
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot delete %s [%d]: %s\n",
+                  del->url, ret, sss_strerror(ret));
+            continue;
+        }
+
+        secdb_flush_container(secdb, del);
+        DLIST_REMOVE(secdb->deleted, del);
+        talloc_free(del);
+        written++;
+    }
+
+    for (entry = secdb->dirty; entry != NULL; entry = entry_next) {
+        entry_next = entry->next;
+
+        ret = secdb_flush_entry(secdb, entry);
+        if (ret != EOK) {
+            entry->flush_failures++;
+            if (secdb_flush_error_is_permanent(ret)
+                    || entry->flush_failures >= KCM_SECDB_MAX_FLUSH_ATTEMPTS) {
+                secdb_entry_discard(entry, ret);
+                continue;
+            }
+
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot write %s [%d]: %s\n",
+                  entry->url, ret, sss_strerror(ret));
+            continue;
+        }
+
+        DLIST_REMOVE(secdb->dirty, entry);
+        entry->dirty = false;
+        entry->flush_failures = 0;
+        written++;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Flushed %u ccache changes\n", written);
+
+    if (retry && (secdb->deleted != NULL || secdb->dirty != NULL)) {
+        secdb_schedule_flush(secdb);
+    }
+}
+
+static void secdb_flush_handler(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval current_time,
+                                void *pvt)
+{
+    struct ccdb_secdb *secdb = talloc_get_type(pvt, struct ccdb_secdb);
+
+    secdb->flush_te = NULL;
+    secdb_flush(secdb, true);
+}
+
+static void secdb_schedule_flush(struct ccdb_secdb *secdb)
+{
+    struct timeval tv;
+
+    if (secdb->flush_te != NULL) {
+        /* the pending flush picks up this change as well */
+        return;
+    }
+
+    tv = tevent_timeval_current_ofs(secdb->write_back_interval, 0);
+    secdb->flush_te = tevent_add_timer(secdb->ev, secdb, tv,
+                                       secdb_flush_handler, secdb);
+    if (secdb->flush_te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot schedule a flush, writing changes now\n");
+        secdb_flush(secdb, false);
+    }
+}
+
+static void secdb_entry_dirty(struct secdb_index_entry *entry)
+{
+    if (!entry->dirty) {
+        entry->dirty = true;
+        DLIST_ADD_END(entry->secdb->dirty, entry,
+                      struct secdb_index_entry *);
+    }
+
+    secdb_schedule_flush(entry->secdb);
+}
+
+static errno_t secdb_entry_delete(struct ccdb_secdb *secdb,
+                                  struct secdb_index *idx,
+                                  struct secdb_index_entry *entry)
+{
+    struct secdb_pending_delete *del;
+
+    if (entry->stored) {
+        del = talloc_zero(secdb, struct secdb_pending_delete);
+        if (del == NULL) {
+            return ENOMEM;
+        }
+
+        /* The strings belong to the index and the entry which may be
+         * gone by the time the deletion is flushed */
+        del->uid = talloc_strdup(del, idx->uid);
+        del->url = talloc_strdup(del, entry->url);
+        del->container_url = talloc_strdup(del, idx->container_url);
+        if (del->uid == NULL || del->url == NULL
+                || del->container_url == NULL) {
+            talloc_free(del);
+            return ENOMEM;
+        }
+
+        DLIST_ADD_END(secdb->deleted, del, struct secdb_pending_delete *);
+        secdb_schedule_flush(secdb);
+    }
+
+    /* Removes the entry from the index and from the dirty list */
+    talloc_free(entry);
+    return EOK;
+}
+
+/* Return a shallow copy of the in-memory ccache, read it from the
+ * database first if it was not needed yet */
+static errno_t secdb_entry_get_cc(TALLOC_CTX *mem_ctx,
+                                  struct ccdb_secdb *secdb,
+                                  struct cli_creds *client,
+                                  struct secdb_index_entry *entry,
+                                  struct kcm_ccache **_cc)
+{
+    struct kcm_ccache *cc;
+    errno_t ret;
+
+    if (entry->cc == NULL) {
+        ret = secdb_get_cc(entry, secdb->sctx, entry->key, client,
+                           &entry->cc);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "ccache %s disappeared from the database\n", entry->key);
+            talloc_free(entry);
+            return ENOENT;
+        } else if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (mem_ctx == NULL) {
+        /* the caller only needs the ccache in memory */
+        return EOK;
+    }
+
+    cc = kcm_cc_dup(mem_ctx, entry->cc);
+    if (cc == NULL) {
+        return ENOMEM;
+    }
+
+    *_cc = cc;
+    return EOK;
+}
+
+/* Find the entry of a ccache that is about to be modified and make sure
+ * its ccache is in memory */
+static errno_t secdb_entry_load(struct ccdb_secdb *secdb,
+                                struct cli_creds *client,
+                                uuid_t uuid,
+                                struct secdb_index_entry **_entry)
+{
+    struct secdb_index_entry *entry;
+    errno_t ret;
+
+    ret = entry_by_uuid(secdb, client, uuid, &entry);
+    if (ret != EOK) {
+        return ret == ENOENT ? ERR_NO_CREDS : ret;
+    }
+
+    ret = secdb_entry_get_cc(NULL, secdb, client, entry, NULL);
+    if (ret != EOK) {
+        return ret == ENOENT ? ERR_NO_CREDS : ret;
+    }
+
+    *_entry = entry;
+    return EOK;
+}
+
+static int ccdb_secdb_destructor(struct ccdb_secdb *secdb)
+{
+    if (secdb->deleted != NULL || secdb->dirty != NULL) {
+        talloc_zfree(secdb->flush_te);
+        secdb_flush(secdb, false);
+    }
+
+    return 0;
+}
 
-    ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", key_match);
-    *_key = talloc_steal(mem_ctx, key_match);
-done:
-    talloc_free(tmp_ctx);
-    return ret;
+static void ccdb_secdb_sigterm(struct tevent_context *ev,
+                               struct tevent_signal *se,
+                               int signum,
+                               int count,
+                               void *siginfo,
+                               void *private_data)
+{
+    struct ccdb_secdb *secdb = talloc_get_type(private_data,
+                                               struct ccdb_secdb);
+
+    /* The default handler terminates the process right after this one,
+     * write the pending changes so that they are not lost */
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing ccache changes before exiting\n");
+    talloc_zfree(secdb->flush_te);
+    secdb_flush(secdb, false);
 }
 
-static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
-                            struct sss_sec_ctx *sctx,
-                            const char *secdb_key,
-                            struct cli_creds *client,
-                            struct kcm_ccache **_cc)
+static errno_t ccdb_secdb_write_back_init(struct ccdb_secdb *secdb,
+                                          struct tevent_context *ev,
+                                          struct confdb_ctx *cdb,
+                                          const char *confdb_service_path)
 {
+    struct tevent_signal *sige;
+    int interval;
     errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct kcm_ccache *cc = NULL;
-    struct sss_sec_req *sreq = NULL;
-    struct sss_iobuf *ccbuf;
-
-    tmp_ctx = talloc_new(mem_ctx);
-    if (tmp_ctx == NULL) {
-        return ENOMEM;
-    }
 
-    ret = secdb_cc_key_req(tmp_ctx, sctx, client, secdb_key, &sreq);
+    ret = confdb_get_int(cdb, confdb_service_path,
+                         CONFDB_KCM_WRITE_BACK_INTERVAL, 0, &interval);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot create secdb request [%d][%s]\n", ret, sss_strerror(ret));
-        goto done;
+              "Cannot get the write back interval [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
     }
 
-    ret = sec_get_b64(tmp_ctx, sreq, &ccbuf);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot get the secret [%d][%s]\n", ret, sss_strerror(ret));
-        goto done;
+    if (interval <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "ccache write-back is disabled\n");
+        return EOK;
     }
 
-    ret = sec_kv_to_ccache(tmp_ctx,
-                           secdb_key,
-                           (const char *) sss_iobuf_get_data(ccbuf),
-                           client,
-                           &cc);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot convert JSON keyval to ccache blob [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
+    if (interval > KCM_SECDB_MAX_WRITE_BACK_INTERVAL) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "%s is larger than the maximum, using %d seconds\n",
+              CONFDB_KCM_WRITE_BACK_INTERVAL,
+              KCM_SECDB_MAX_WRITE_BACK_INTERVAL);
+        interval = KCM_SECDB_MAX_WRITE_BACK_INTERVAL;
     }
 
-    ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache\n");
-    *_cc = talloc_steal(mem_ctx, cc);
-done:
-    talloc_free(tmp_ctx);
-    return ret;
+    BlockSignals(false, SIGTERM);
+    sige = tevent_add_signal(ev, secdb, SIGTERM, 0,
+                             ccdb_secdb_sigterm, secdb);
+    if (sige == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_signal failed.\n");
+        return ENOMEM;
+    }
+
+    secdb->ev = ev;
+    secdb->write_back_interval = interval;
+    talloc_set_destructor(secdb, ccdb_secdb_destructor);
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "ccache changes are written every %d seconds\n", interval);
+    return EOK;
 }
 
-static errno_t ccdb_secdb_init(struct kcm_ccdb *db)
+static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
+                               struct confdb_ctx *cdb,
+                               const char *confdb_service_path)
 {
     struct ccdb_secdb *secdb = NULL;
     errno_t ret;
@@ -530,9 +1405,11 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db)
         return ENOMEM;
     }
 
-    /* TODO: read configuration from the config file, adjust quotas */
+    /* TODO: adjust quotas */
 
-    ret = sss_sec_init(db, NULL, &secdb->sctx);
+    /* The database must outlive the pending writes flushed by the
+     * destructor */
+    ret = sss_sec_init(secdb, NULL, &secdb->sctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Cannot initialize the security database\n");
@@ -540,6 +1417,18 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db)
         return ret;
     }
 
+    secdb->index = sss_ptr_hash_create(secdb, NULL, NULL);
+    if (secdb->index == NULL) {
+        talloc_free(secdb);
+        return ENOMEM;
+    }
+
+    ret = ccdb_secdb_write_back_init(secdb, db->ev, cdb, confdb_service_path);
+    if (ret != EOK) {
+        talloc_free(secdb);
+        return ret;
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "secdb initialized\n");
     db->db_handle = secdb;
     return EOK;
@@ -549,15 +1438,9 @@ struct ccdb_secdb_nextid_state {
     unsigned int nextid;
 };
 
-static bool is_in_use(char **keys, size_t nkeys, const char *nextid_name)
+static bool is_in_use(struct secdb_index *idx, const char *nextid_name)
 {
-    for (size_t i = 0; i < nkeys; i++) {
-        if (sec_key_match_name(keys[i], nextid_name) == true) {
-            return true;
-        }
-    }
-
-    return false;
+    return sss_ptr_hash_has_key(idx->by_name, nextid_name);
 }
 
 static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
@@ -571,9 +1454,7 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
     const int maxtries = 3;
     int numtry;
     errno_t ret;
-    struct sss_sec_req *sreq = NULL;
-    char **keys = NULL;
-    size_t nkeys;
+    struct secdb_index *idx;
     char *nextid_name = NULL;
 
     DEBUG(SSSDBG_TRACE_LIBS, "Generating a new ID\n");
@@ -589,22 +1470,11 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
+    ret = secdb_index_get(secdb, client, &idx);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        keys = NULL;
-        nkeys = 0;
-    } else if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot list keys [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto immediate;
-    }
-
     for (numtry = 0; numtry  < maxtries; numtry++) {
         state->nextid = rand() % MAX_CC_NUM;
         nextid_name = talloc_asprintf(state, "%"SPRIuid":%u",
@@ -615,7 +1485,7 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
             goto immediate;
         }
 
-        if (!is_in_use(keys, nkeys, nextid_name)) {
+        if (!is_in_use(idx, nextid_name)) {
             break;
         }
     }
@@ -663,6 +1533,7 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
     char uuid_str[UUID_STR_SIZE];
     struct sss_sec_req *sreq = NULL;
     struct sss_iobuf *iobuf;
+    struct secdb_index *idx;
     char *cur_default;
 
     uuid_unparse(uuid, uuid_str);
@@ -698,6 +1569,17 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    if (secdb_write_back(secdb)) {
+        /* The default is written right away, only remember it */
+        ret = secdb_index_get(secdb, client, &idx);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        uuid_copy(idx->dfl, uuid);
+        idx->dfl_loaded = true;
+    }
+
     ret = EOK;
     DEBUG(SSSDBG_TRACE_INTERNAL, "Set the default ccache\n");
 immediate:
@@ -731,6 +1613,7 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     struct sss_sec_req *sreq = NULL;
     struct sss_iobuf *dfl_iobuf = NULL;
+    struct secdb_index *idx = NULL;
     size_t uuid_size;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting the default ccache\n");
@@ -740,6 +1623,19 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    if (secdb_write_back(secdb)) {
+        ret = secdb_index_get(secdb, client, &idx);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        if (idx->dfl_loaded) {
+            uuid_copy(state->uuid, idx->dfl);
+            ret = EOK;
+            goto immediate;
+        }
+    }
+
     ret = secdb_dfl_url_req(state, secdb->sctx, client, &sreq);
     if (ret != EOK) {
         goto immediate;
@@ -765,6 +1661,11 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_INTERNAL, "Got the default ccache\n");
     ret = EOK;
 immediate:
+    if (ret == EOK && idx != NULL) {
+        uuid_copy(idx->dfl, state->uuid);
+        idx->dfl_loaded = true;
+    }
+
     if (ret == EOK) {
         tevent_req_done(req);
     } else {
@@ -798,10 +1699,12 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_list_state *state = NULL;
+    struct secdb_index_entry *entry;
+    struct secdb_index *idx;
+    hash_value_t *values = NULL;
+    unsigned long nkeys;
     errno_t ret;
-    char **keys = NULL;
-    size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
+    int hret;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Listing all ccaches\n");
 
@@ -810,19 +1713,18 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
+    /* The index also contains ccaches that were not written yet */
+    ret = secdb_index_get(secdb, client, &idx);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        nkeys = 0;
-        /* Fall through and return an empty list */
-    } else if (ret != EOK) {
+    hret = hash_values(idx->by_uuid, &nkeys, &values);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
         goto immediate;
     }
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu ccaches\n", nkeys);
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Found %lu ccaches\n", nkeys);
 
     state->uuid_list = talloc_array(state, uuid_t, nkeys + 1);
     if (state->uuid_list == NULL) {
@@ -830,9 +1732,14 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    for (size_t i = 0; i < nkeys; i++) {
-        ret = sec_key_get_uuid(keys[i],
-                               state->uuid_list[i]);
+    for (unsigned long i = 0; i < nkeys; i++) {
+        entry = sss_ptr_get_value(&values[i], struct secdb_index_entry);
+        if (entry == NULL) {
+            ret = EINVAL;
+            goto immediate;
+        }
+
+        ret = sec_key_get_uuid(entry->key, state->uuid_list[i]);
         if (ret != EOK) {
             goto immediate;
         }
@@ -843,6 +1750,7 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_INTERNAL, "Listing all caches done\n");
     ret = EOK;
 immediate:
+    talloc_zfree(values);
     if (ret == EOK) {
         tevent_req_done(req);
     } else {
@@ -879,6 +1787,7 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb_getbyuuid_state *state = NULL;
     errno_t ret;
     char *secdb_key = NULL;
+    struct secdb_index_entry *entry;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting ccache by UUID\n");
 
@@ -887,7 +1796,20 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    if (secdb_write_back(secdb)) {
+        ret = entry_by_uuid(secdb, client, uuid, &entry);
+        if (ret == EOK) {
+            ret = secdb_entry_get_cc(state, secdb, client, entry, &state->cc);
+        }
+
+        if (ret == ENOENT) {
+            state->cc = NULL;
+            ret = EOK;
+        }
+        goto immediate;
+    }
+
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -897,7 +1819,12 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
     }
 
     ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
-    if (ret != EOK) {
+    if (ret == ENOENT) {
+        secdb_index_drop(secdb, client);
+        state->cc = NULL;
+        ret = EOK;
+        goto immediate;
+    } else if (ret != EOK) {
         goto immediate;
     }
 
@@ -940,6 +1867,7 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb_getbyname_state *state = NULL;
     errno_t ret;
     char *secdb_key = NULL;
+    struct secdb_index_entry *entry;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting ccache by name\n");
 
@@ -948,7 +1876,20 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &secdb_key);
+    if (secdb_write_back(secdb)) {
+        ret = entry_by_name(secdb, client, name, &entry);
+        if (ret == EOK) {
+            ret = secdb_entry_get_cc(state, secdb, client, entry, &state->cc);
+        }
+
+        if (ret == ENOENT) {
+            state->cc = NULL;
+            ret = EOK;
+        }
+        goto immediate;
+    }
+
+    ret = key_by_name(state, secdb, client, name, &secdb_key);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -958,7 +1899,12 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
     }
 
     ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
-    if (ret != EOK) {
+    if (ret == ENOENT) {
+        secdb_index_drop(secdb, client);
+        state->cc = NULL;
+        ret = EOK;
+        goto immediate;
+    } else if (ret != EOK) {
         goto immediate;
     }
 
@@ -1011,7 +1957,7 @@ struct tevent_req *ccdb_secdb_name_by_uuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &key);
+    ret = key_by_uuid(state, secdb, client, uuid, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1078,7 +2024,7 @@ struct tevent_req *ccdb_secdb_uuid_by_name_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &key);
+    ret = key_by_name(state, secdb, client, name, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1129,7 +2075,10 @@ static struct tevent_req *ccdb_secdb_create_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     struct sss_sec_req *container_req = NULL;
     struct sss_sec_req *ccache_req = NULL;
+    struct secdb_index *idx;
+    struct secdb_index_entry *entry;
     const char *url;
+    const char *secdb_key;
     struct sss_iobuf *ccache_payload;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Creating ccache storage for %s\n", cc->name);
@@ -1139,16 +2088,52 @@ static struct tevent_req *ccdb_secdb_create_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    if (secdb_write_back(secdb)) {
+        ret = secdb_index_get(secdb, client, &idx);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        secdb_key = sec_key_create(state, cc->name, cc->uuid);
+        if (secdb_key == NULL) {
+            ret = ENOMEM;
+            goto immediate;
+        }
+
+        /* Refuse the ccache now rather than failing to write it later */
+        ret = secdb_check_write(secdb, idx, client, secdb_key, NULL, cc);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        ret = secdb_index_add(secdb, idx, secdb_key, &entry);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        /* Like the memory back end, take over the ccache */
+        entry->cc = talloc_steal(entry, cc);
+        secdb_entry_set_stored(entry, false);
+        secdb_entry_dirty(entry);
+        goto immediate;
+    }
+
     /* Do the encoding asap so that if we fail, we don't even attempt any
      * writes */
     ret = kcm_ccache_to_secdb_kv(state, cc, client, &url, &ccache_payload);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot convert cache %s to JSON [%d]: %s\n",
+              "Cannot convert cache %s to binary [%d]: %s\n",
               cc->name, ret, sss_strerror(ret));
         goto immediate;
     }
 
+    /* Index the existing ccaches before this one is added */
+    ret = secdb_index_get(secdb, client, &idx);
+    if (ret != EOK) {
+        goto immediate;
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "Creating the ccache container\n");
     ret = secdb_container_url_req(state, secdb->sctx, client, &container_req);
     if (ret != EOK) {
@@ -1177,6 +2162,18 @@ static struct tevent_req *ccdb_secdb_create_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    secdb_key = sec_key_create(state, cc->name, cc->uuid);
+    if (secdb_key == NULL) {
+        ret = ENOMEM;
+        goto immediate;
+    }
+
+    ret = secdb_index_add(secdb, idx, secdb_key, NULL);
+    if (ret != EOK) {
+        secdb_index_drop(secdb, client);
+        ret = EOK;
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "payload created\n");
     ret = EOK;
 immediate:
@@ -1210,6 +2207,8 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
     struct kcm_ccache *cc = NULL;
     struct sss_iobuf *payload = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct secdb_index_entry *entry;
+    int32_t kdc_offset;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Modifying ccache\n");
 
@@ -1218,7 +2217,27 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    if (secdb_write_back(secdb)) {
+        ret = secdb_entry_load(secdb, client, uuid, &entry);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        kdc_offset = entry->cc->kdc_offset;
+        kcm_mod_cc(entry->cc, mod_cc);
+
+        ret = secdb_check_write(secdb, entry->idx, client, entry->key,
+                                entry, entry->cc);
+        if (ret != EOK) {
+            entry->cc->kdc_offset = kdc_offset;
+            goto immediate;
+        }
+
+        secdb_entry_dirty(entry);
+        goto immediate;
+    }
+
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1226,16 +2245,35 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
+    ret = secdb_get_cc_payload(state, secdb->sctx, secdb_key, client,
+                               &payload);
     if (ret != EOK) {
         goto immediate;
     }
 
-    kcm_mod_cc(cc, mod_cc);
+    if (sec_binary_is_ccache(payload)) {
+        /* Only the KDC offset can be modified, patch it in place */
+        if (mod_cc->kdc_offset == INT32_MAX) {
+            ret = EOK;
+            goto immediate;
+        }
 
-    ret = kcm_ccache_to_sec_input(state, cc, client, &payload);
-    if (ret != EOK) {
-        goto immediate;
+        ret = sec_binary_set_offset(payload, mod_cc->kdc_offset);
+        if (ret != EOK) {
+            goto immediate;
+        }
+    } else {
+        ret = secdb_payload_to_cc(state, secdb_key, payload, client, &cc);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        kcm_mod_cc(cc, mod_cc);
+
+        ret = kcm_ccache_to_sec_binary(state, cc, &payload);
+        if (ret != EOK) {
+            goto immediate;
+        }
     }
 
     ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
@@ -1277,8 +2315,12 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb_state *state = NULL;
     char *secdb_key = NULL;
     struct kcm_ccache *cc = NULL;
+    struct sss_iobuf *stored = NULL;
     struct sss_iobuf *payload = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct secdb_index_entry *entry;
+    struct kcm_cred *kcreds;
+    uuid_t cred_uuid;
     errno_t ret;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Storing creds in ccache\n");
@@ -1288,7 +2330,43 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    if (secdb_write_back(secdb)) {
+        ret = secdb_entry_load(secdb, client, uuid, &entry);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        /* Keep the credentials at hand to take them back if the ccache
+         * cannot be written with them */
+        uuid_generate(cred_uuid);
+        kcreds = kcm_cred_new(entry->cc, cred_uuid, cred_blob);
+        if (kcreds == NULL) {
+            ret = ENOMEM;
+            goto immediate;
+        }
+
+        ret = kcm_cc_store_creds(entry->cc, kcreds);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot store credentials to ccache [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            talloc_free(kcreds);
+            goto immediate;
+        }
+
+        ret = secdb_check_write(secdb, entry->idx, client, entry->key,
+                                entry, entry->cc);
+        if (ret != EOK) {
+            DLIST_REMOVE(entry->cc->creds, kcreds);
+            talloc_free(kcreds);
+            goto immediate;
+        }
+
+        secdb_entry_dirty(entry);
+        goto immediate;
+    }
+
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1296,22 +2374,41 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
+    ret = secdb_get_cc_payload(state, secdb->sctx, secdb_key, client,
+                               &stored);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = kcm_cc_store_cred_blob(cc, cred_blob);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot store credentials to ccache [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto immediate;
-    }
+    if (sec_binary_is_ccache(stored)) {
+        /* Append the credentials without decoding the ccache */
+        uuid_generate(cred_uuid);
+        ret = sec_binary_append_cred(state, stored, cred_uuid, cred_blob,
+                                     &payload);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot append credentials to ccache [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto immediate;
+        }
+    } else {
+        ret = secdb_payload_to_cc(state, secdb_key, stored, client, &cc);
+        if (ret != EOK) {
+            goto immediate;
+        }
 
-    ret = kcm_ccache_to_sec_input(state, cc, client, &payload);
-    if (ret != EOK) {
-        goto immediate;
+        ret = kcm_cc_store_cred_blob(cc, cred_blob);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot store credentials to ccache [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto immediate;
+        }
+
+        ret = kcm_ccache_to_sec_binary(state, cc, &payload);
+        if (ret != EOK) {
+            goto immediate;
+        }
     }
 
     ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
@@ -1352,8 +2449,10 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct sss_sec_req *container_req = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct secdb_index *idx;
+    struct secdb_index_entry *entry;
     char *secdb_key = NULL;
-    char **keys = NULL;
+    char uuid_str[UUID_STR_SIZE];
     size_t nkeys;
     errno_t ret;
 
@@ -1364,24 +2463,51 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    if (secdb_write_back(secdb)) {
+        ret = secdb_index_get(secdb, client, &idx);
+        if (ret != EOK) {
+            goto immediate;
+        }
+
+        if (hash_count(idx->by_uuid) == 0) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
+            ret = ENOENT;
+            goto immediate;
+        }
+
+        ret = entry_by_uuid(secdb, client, uuid, &entry);
+        if (ret == ENOENT) {
+            ret = ERR_NO_CREDS;
+            goto immediate;
+        } else if (ret != EOK) {
+            goto immediate;
+        }
+
+        ret = secdb_entry_delete(secdb, idx, entry);
+        goto immediate;
+    }
+
     ret = secdb_container_url_req(state, secdb->sctx, client, &container_req);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = sss_sec_list(state, container_req, &keys, &nkeys);
+    ret = secdb_index_get(secdb, client, &idx);
     if (ret != EOK) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
         goto immediate;
     }
+
+    nkeys = hash_count(idx->by_uuid);
     DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu ccaches\n", nkeys);
 
     if (nkeys == 0) {
-        ret = EOK;
+        /* the container is removed together with the last ccache */
+        DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
+        ret = ENOENT;
         goto immediate;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1395,10 +2521,17 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
     }
 
     ret = sss_sec_delete(sreq);
-    if (ret != EOK) {
+    if (ret == ENOENT) {
+        secdb_index_drop(secdb, client);
+        ret = ERR_NO_CREDS;
+        goto immediate;
+    } else if (ret != EOK) {
         goto immediate;
     }
 
+    uuid_unparse(uuid, uuid_str);
+    sss_ptr_hash_delete(idx->by_uuid, uuid_str, true);
+
     if (nkeys > 1) {
         DEBUG(SSSDBG_TRACE_INTERNAL, "There are other ccaches, done\n");
         ret = EOK;
@@ -222,7 +222,9 @@ static errno_t nss_getby_svc(struct cli_ctx *cli_ctx,
         goto done;
     }
 
+    cmd_ctx->svc_name = name;
     cmd_ctx->svc_protocol = protocol;
+    cmd_ctx->svc_port = port;
 
     data = cache_req_data_svc(cmd_ctx, type, name, protocol, port);
     if (data == NULL) {
@@ -1120,34 +1122,39 @@ static errno_t nss_cmd_endservent(struct cli_ctx *cli_ctx)
 
 static errno_t nss_cmd_getsidbyname(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    /* The name is needed to store the object in the SID memory cache. */
+    const char *attrs[] = { SYSDB_SID_STR, ORIGINALAD_PREFIX SYSDB_NAME,
+                            NULL };
 
     return nss_getby_name(cli_ctx, false, CACHE_REQ_OBJECT_BY_NAME, attrs,
-                          SSS_MC_NONE, nss_protocol_fill_sid);
+                          SSS_MC_SID, nss_protocol_fill_sid);
 }
 
 static errno_t nss_cmd_getsidbyid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                            NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_OBJECT_BY_ID, attrs,
-                        SSS_MC_NONE, nss_protocol_fill_sid);
+                        SSS_MC_SID, nss_protocol_fill_sid);
 }
 
 static errno_t nss_cmd_getsidbyuid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                            NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_USER_BY_ID, attrs,
-                        SSS_MC_NONE, nss_protocol_fill_sid);
+                        SSS_MC_SID, nss_protocol_fill_sid);
 }
 
 static errno_t nss_cmd_getsidbygid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                            NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_GROUP_BY_ID, attrs,
-                        SSS_MC_NONE, nss_protocol_fill_sid);
+                        SSS_MC_SID, nss_protocol_fill_sid);
 }
 
 static errno_t nss_cmd_getnamebysid(struct cli_ctx *cli_ctx)
@@ -24,6 +24,7 @@
 #include "util/util.h"
 #include "responder/nss/nss_private.h"
 #include "responder/nss/nsssrv_mmap_cache.h"
+#include "util/mmap_cache.h"
 
 static errno_t
 memcache_delete_entry_by_name(struct nss_ctx *nss_ctx,
@@ -42,6 +43,9 @@ memcache_delete_entry_by_name(struct nss_ctx *nss_ctx,
     case SSS_MC_INITGROUPS:
         ret = sss_mmap_cache_initgr_invalidate(nss_ctx->initgr_mc_ctx, name);
         break;
+    case SSS_MC_SID:
+        ret = sss_mmap_cache_sid_invalidate(nss_ctx->sid_mc_ctx, name);
+        break;
     default:
         return EINVAL;
     }
@@ -71,6 +75,9 @@ memcache_delete_entry_by_id(struct nss_ctx *nss_ctx,
     case SSS_MC_GROUP:
         ret = sss_mmap_cache_gr_invalidate_gid(nss_ctx->grp_mc_ctx, (gid_t)id);
         break;
+    case SSS_MC_SID:
+        ret = sss_mmap_cache_sid_invalidate_id(nss_ctx->sid_mc_ctx, id);
+        break;
     default:
         return EINVAL;
     }
@@ -349,6 +356,61 @@ static void nss_get_object_done(struct tevent_req *subreq)
     return;
 }
 
+/* Kind of the negative memory cache record for this request, 0 if the
+ * request is not cached. */
+static char nss_get_object_neg_kind(struct nss_get_object_state *state)
+{
+    switch (state->memcache) {
+    case SSS_MC_PASSWD:
+        return state->input_name != NULL ? SSS_MC_NEG_USER : SSS_MC_NEG_UID;
+    case SSS_MC_GROUP:
+        return state->input_name != NULL ? SSS_MC_NEG_GROUP : SSS_MC_NEG_GID;
+    default:
+        return 0;
+    }
+}
+
+static void nss_get_object_update_neg_mc(struct nss_get_object_state *state,
+                                         bool found)
+{
+    uint32_t timeout;
+    char kind;
+    errno_t ret;
+
+    kind = nss_get_object_neg_kind(state);
+    if (kind == 0 || state->nss_ctx->neg_mc_ctx == NULL) {
+        return;
+    }
+
+    if (found) {
+        ret = sss_mmap_cache_neg_invalidate(state->nss_ctx->neg_mc_ctx, kind,
+                                            state->input_name,
+                                            state->input_id);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to remove negative memory cache entry [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+        return;
+    }
+
+    /* Same lifetime as the entries in the negative cache, a zero timeout
+     * means that non-permanent entries are not stored at all. */
+    timeout = sss_ncache_get_timeout(state->rctx->ncache);
+    if (timeout == 0) {
+        return;
+    }
+
+    ret = sss_mmap_cache_neg_store(&state->nss_ctx->neg_mc_ctx, kind,
+                                   state->input_name, state->input_id,
+                                   timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to store negative memory cache entry [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
 static void nss_get_object_finish_req(struct tevent_req *req,
                                       errno_t ret)
 {
@@ -367,6 +429,7 @@ static void nss_get_object_finish_req(struct tevent_req *req,
                                   state->memcache);
         }
 
+        nss_get_object_update_neg_mc(state, true);
         tevent_req_done(req);
         break;
     case ENOENT:
@@ -377,6 +440,7 @@ static void nss_get_object_finish_req(struct tevent_req *req,
                                   state->memcache);
         }
 
+        nss_get_object_update_neg_mc(state, false);
         tevent_req_error(req, ENOENT);
         break;
     default:
@@ -154,6 +154,8 @@ nss_memorycache_invalidate_users(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all users in memory cache\n");
     sss_mmap_cache_reset(nctx->pwd_mc_ctx);
+    sss_mmap_cache_reset(nctx->sid_mc_ctx);
+    sss_mmap_cache_reset(nctx->neg_mc_ctx);
 
     return EOK;
 }
@@ -165,6 +167,8 @@ nss_memorycache_invalidate_groups(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all groups in memory cache\n");
     sss_mmap_cache_reset(nctx->grp_mc_ctx);
+    sss_mmap_cache_reset(nctx->sid_mc_ctx);
+    sss_mmap_cache_reset(nctx->neg_mc_ctx);
 
     return EOK;
 }
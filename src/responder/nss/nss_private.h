@@ -87,6 +87,10 @@ struct nss_ctx {
     struct sss_mc_ctx *pwd_mc_ctx;
     struct sss_mc_ctx *grp_mc_ctx;
     struct sss_mc_ctx *initgr_mc_ctx;
+    struct sss_mc_ctx *sid_mc_ctx;
+    struct sss_mc_ctx *svc_mc_ctx;
+    struct sss_mc_ctx *netgr_mc_ctx;
+    struct sss_mc_ctx *neg_mc_ctx;
     uid_t mc_uid;
     gid_t mc_gid;
 };
@@ -62,7 +62,9 @@ struct nss_cmd_ctx {
     uint32_t enum_limit;
 
     /* For services. */
+    const char *svc_name;
     const char *svc_protocol;
+    uint16_t svc_port;
 
     /* For SID lookups. */
     enum sss_id_type sid_id_type;
@@ -101,6 +101,33 @@ nss_protocol_fill_netgr_member(struct sss_packet *packet,
     return EOK;
 }
 
+static void
+nss_netgr_mc_store(struct nss_ctx *nss_ctx,
+                   struct nss_cmd_ctx *cmd_ctx,
+                   struct sss_packet *packet)
+{
+    struct sized_string name;
+    size_t body_len;
+    uint8_t *body;
+    errno_t ret;
+
+    if (nss_ctx->netgr_mc_ctx == NULL) {
+        return;
+    }
+
+    /* The key is the name exactly as requested by the client. */
+    to_sized_string(&name, cmd_ctx->state_ctx->netgroup);
+    sss_packet_get_body(packet, &body, &body_len);
+
+    ret = sss_mmap_cache_netgr_store(&nss_ctx->netgr_mc_ctx, &name,
+                                     body, body_len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store netgroup [%s] in mmap cache [%d]: %s\n",
+              name.str, ret, sss_strerror(ret));
+    }
+}
+
 errno_t
 nss_protocol_fill_netgrent(struct nss_ctx *nss_ctx,
                            struct nss_cmd_ctx *cmd_ctx,
@@ -116,6 +143,7 @@ nss_protocol_fill_netgrent(struct nss_ctx *nss_ctx,
     uint8_t *body;
     errno_t ret;
     unsigned int start;
+    bool complete = false;
 
     idx = cmd_ctx->enum_index;
     entries = cmd_ctx->enum_ctx->netgroup;
@@ -171,6 +199,10 @@ nss_protocol_fill_netgrent(struct nss_ctx *nss_ctx,
         num_results++;
     }
 
+    /* Only a netgroup that fits into a single reply can be answered from
+     * the memory cache. */
+    complete = (start == 0 && num_results > 0 && entries[idx->result] == NULL);
+
     ret = EOK;
 
 done:
@@ -183,6 +215,10 @@ done:
     SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
     SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
 
+    if (complete) {
+        nss_netgr_mc_store(nss_ctx, cmd_ctx, packet);
+    }
+
     return EOK;
 }
 
@@ -19,6 +19,7 @@
 */
 
 #include "util/crypto/sss_crypto.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nss_protocol.h"
 
 static errno_t
@@ -87,6 +88,90 @@ nss_get_id_type(struct nss_cmd_ctx *cmd_ctx,
     return EOK;
 }
 
+static void
+nss_sid_mc_store_id(struct nss_ctx *nss_ctx,
+                    struct nss_cmd_ctx *cmd_ctx,
+                    struct cache_req_result *result,
+                    struct sized_string *sz_sid,
+                    enum sss_id_type id_type)
+{
+    struct ldb_message *msg = result->msgs[0];
+    uint32_t populated_by;
+    uint64_t id64;
+    errno_t ret;
+
+    if (nss_ctx->sid_mc_ctx == NULL || result->well_known_object
+            || cmd_ctx->sid_id_type != SSS_ID_TYPE_NOT_SPECIFIED) {
+        return;
+    }
+
+    switch (cmd_ctx->type) {
+    case CACHE_REQ_OBJECT_BY_ID:
+        populated_by = SSS_MC_SID_BY_ID;
+        break;
+    case CACHE_REQ_USER_BY_ID:
+        populated_by = SSS_MC_SID_BY_UID;
+        break;
+    case CACHE_REQ_GROUP_BY_ID:
+        populated_by = SSS_MC_SID_BY_GID;
+        break;
+    case CACHE_REQ_OBJECT_BY_SID:
+        populated_by = SSS_MC_SID_BY_SID;
+        break;
+    default:
+        return;
+    }
+
+    if (id_type == SSS_ID_TYPE_GID) {
+        id64 = ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0);
+    } else {
+        id64 = ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0);
+    }
+
+    if (id64 == 0 || id64 >= UINT32_MAX) {
+        /* object without POSIX ID, nothing to cache */
+        return;
+    }
+
+    ret = sss_mmap_cache_sid_store(&nss_ctx->sid_mc_ctx, sz_sid,
+                                   (uint32_t)id64, id_type, populated_by);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store SID [%s] in mmap cache [%d]: %s\n",
+              sz_sid->str, ret, sss_strerror(ret));
+    }
+}
+
+static void
+nss_sid_mc_store_name(struct nss_ctx *nss_ctx,
+                      struct nss_cmd_ctx *cmd_ctx,
+                      struct cache_req_result *result,
+                      struct sized_string *sz_name,
+                      struct sized_string *sz_sid,
+                      enum sss_id_type id_type)
+{
+    errno_t ret;
+
+    if (nss_ctx->sid_mc_ctx == NULL || result->well_known_object
+            || cmd_ctx->sid_id_type != SSS_ID_TYPE_NOT_SPECIFIED) {
+        return;
+    }
+
+    ret = sss_mmap_cache_sid_name_store(&nss_ctx->sid_mc_ctx, sz_name, sz_sid,
+                                        id_type);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store name [%s] in SID mmap cache [%d]: %s\n",
+              sz_name->str, ret, sss_strerror(ret));
+    }
+}
+
+static errno_t
+nss_get_ad_name(TALLOC_CTX *mem_ctx,
+                struct resp_ctx *rctx,
+                struct cache_req_result *result,
+                struct sized_string **_sz_name);
+
 errno_t
 nss_protocol_fill_sid(struct nss_ctx *nss_ctx,
                       struct nss_cmd_ctx *cmd_ctx,
@@ -94,6 +179,7 @@ nss_protocol_fill_sid(struct nss_ctx *nss_ctx,
                       struct cache_req_result *result)
 {
     struct ldb_message *msg = result->msgs[0];
+    struct sized_string *sz_name;
     struct sized_string sz_sid;
     enum sss_id_type id_type;
     const char *sid;
@@ -128,6 +214,19 @@ nss_protocol_fill_sid(struct nss_ctx *nss_ctx,
     SAFEALIGN_SET_UINT32(&body[rp], id_type, &rp);
     SAFEALIGN_SET_STRING(&body[rp], sz_sid.str, sz_sid.len, &rp);
 
+    if (cmd_ctx->type == CACHE_REQ_OBJECT_BY_NAME) {
+        if (nss_ctx->sid_mc_ctx != NULL && !result->well_known_object) {
+            ret = nss_get_ad_name(cmd_ctx, nss_ctx->rctx, result, &sz_name);
+            if (ret == EOK) {
+                nss_sid_mc_store_name(nss_ctx, cmd_ctx, result, sz_name,
+                                      &sz_sid, id_type);
+                talloc_free(sz_name);
+            }
+        }
+    } else {
+        nss_sid_mc_store_id(nss_ctx, cmd_ctx, result, &sz_sid, id_type);
+    }
+
     return EOK;
 }
 
@@ -412,7 +511,9 @@ nss_protocol_fill_name(struct nss_ctx *nss_ctx,
                        struct cache_req_result *result)
 {
     struct sized_string *sz_name;
+    struct sized_string sz_sid;
     enum sss_id_type id_type;
+    const char *sid;
     size_t rp = 0;
     size_t body_len;
     uint8_t *body;
@@ -442,6 +543,15 @@ nss_protocol_fill_name(struct nss_ctx *nss_ctx,
     SAFEALIGN_SET_UINT32(&body[rp], id_type, &rp);
     SAFEALIGN_SET_STRING(&body[rp], sz_name->str, sz_name->len, &rp);
 
+    if (cmd_ctx->type == CACHE_REQ_OBJECT_BY_SID && !result->well_known_object) {
+        sid = ldb_msg_find_attr_as_string(result->msgs[0], SYSDB_SID_STR, NULL);
+        if (sid != NULL) {
+            to_sized_string(&sz_sid, sid);
+            nss_sid_mc_store_name(nss_ctx, cmd_ctx, result, sz_name, &sz_sid,
+                                  id_type);
+        }
+    }
+
     talloc_free(sz_name);
 
     return EOK;
@@ -454,7 +564,9 @@ nss_protocol_fill_id(struct nss_ctx *nss_ctx,
                      struct cache_req_result *result)
 {
     struct ldb_message *msg = result->msgs[0];
+    struct sized_string sz_sid;
     enum sss_id_type id_type;
+    const char *sid;
     uint64_t id64;
     uint32_t id;
     size_t rp = 0;
@@ -498,6 +610,12 @@ nss_protocol_fill_id(struct nss_ctx *nss_ctx,
     SAFEALIGN_SET_UINT32(&body[rp], id_type, &rp);
     SAFEALIGN_SET_UINT32(&body[rp], id, &rp);
 
+    sid = ldb_msg_find_attr_as_string(msg, SYSDB_SID_STR, NULL);
+    if (sid != NULL) {
+        to_sized_string(&sz_sid, sid);
+        nss_sid_mc_store_id(nss_ctx, cmd_ctx, result, &sz_sid, id_type);
+    }
+
     return EOK;
 }
 
@@ -20,6 +20,7 @@
 
 #include "db/sysdb.h"
 #include "db/sysdb_services.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nss_protocol.h"
 
 static errno_t
@@ -163,6 +164,56 @@ done:
     return ret;
 }
 
+static void
+nss_svc_mc_store(struct nss_ctx *nss_ctx,
+                 struct nss_cmd_ctx *cmd_ctx,
+                 struct sss_packet *packet)
+{
+    struct sized_string key;
+    const char *protocol;
+    char *keystr;
+    size_t body_len;
+    uint8_t *body;
+    errno_t ret;
+
+    if (nss_ctx->svc_mc_ctx == NULL) {
+        return;
+    }
+
+    protocol = cmd_ctx->svc_protocol == NULL ? "" : cmd_ctx->svc_protocol;
+
+    switch (cmd_ctx->type) {
+    case CACHE_REQ_SVC_BY_NAME:
+        keystr = talloc_asprintf(cmd_ctx, SSS_MC_SVC_NAME_KEY_FMT,
+                                 cmd_ctx->svc_name, protocol);
+        break;
+    case CACHE_REQ_SVC_BY_PORT:
+        keystr = talloc_asprintf(cmd_ctx, SSS_MC_SVC_PORT_KEY_FMT,
+                                 cmd_ctx->svc_port, protocol);
+        break;
+    default:
+        /* enumeration is not cached */
+        return;
+    }
+
+    if (keystr == NULL) {
+        return;
+    }
+
+    to_sized_string(&key, keystr);
+    sss_packet_get_body(packet, &body, &body_len);
+
+    ret = sss_mmap_cache_svc_store(&nss_ctx->svc_mc_ctx, &key,
+                                   body, body_len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store service [%s] in mmap cache [%d]: %s\n",
+              keystr, ret, sss_strerror(ret));
+    }
+
+    talloc_free(keystr);
+}
+
 errno_t
 nss_protocol_fill_svcent(struct nss_ctx *nss_ctx,
                          struct nss_cmd_ctx *cmd_ctx,
@@ -266,5 +317,9 @@ done:
     SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
     SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
 
+    if (num_results == 1) {
+        nss_svc_mc_store(nss_ctx, cmd_ctx, packet);
+    }
+
     return EOK;
 }
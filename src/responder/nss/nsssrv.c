@@ -54,8 +54,22 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
                    struct sbus_request *sbus_req,
                    struct nss_ctx *nctx)
 {
+    struct {
+        const char *name;
+        struct sss_mc_ctx **mc_ctx;
+    } caches[] = {
+        { "passwd", &nctx->pwd_mc_ctx },
+        { "group", &nctx->grp_mc_ctx },
+        { "initgroups", &nctx->initgr_mc_ctx },
+        { "SID", &nctx->sid_mc_ctx },
+        { "services", &nctx->svc_mc_ctx },
+        { "netgroup", &nctx->netgr_mc_ctx },
+        { "negative", &nctx->neg_mc_ctx },
+        { NULL, NULL }
+    };
     int memcache_timeout;
     errno_t ret;
+    int i;
 
     ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
     if (ret != 0) {
@@ -83,36 +97,22 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
         return ret;
     }
 
-    /* TODO: read cache sizes from configuration */
     DEBUG(SSSDBG_TRACE_FUNC, "Clearing memory caches.\n");
-    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
-                                (time_t) memcache_timeout,
-                                &nctx->pwd_mc_ctx);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "passwd mmap cache invalidation failed\n");
-        return ret;
-    }
-
-    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
-                                (time_t) memcache_timeout,
-                                &nctx->grp_mc_ctx);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "group mmap cache invalidation failed\n");
-        return ret;
-    }
+    for (i = 0; caches[i].name != NULL; i++) {
+        if (*caches[i].mc_ctx == NULL) {
+            /* this cache is disabled */
+            continue;
+        }
 
-    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
-                                (time_t)memcache_timeout,
-                                &nctx->initgr_mc_ctx);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "initgroups mmap cache invalidation failed\n");
-        return ret;
+        /* keep the current size, the cache may have grown already */
+        ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
+                                    -1, (time_t)memcache_timeout,
+                                    caches[i].mc_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "%s mmap cache invalidation failed\n", caches[i].name);
+            return ret;
+        }
     }
 
     return EOK;
@@ -126,6 +126,7 @@ nss_clear_netgroup_hash_table(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_FUNC, "Invalidating netgroup hash table\n");
 
     sss_ptr_hash_delete_all(nss_ctx->netgrent, false);
+    sss_mmap_cache_reset(nss_ctx->netgr_mc_ctx);
 
     return EOK;
 }
@@ -208,10 +209,55 @@ done:
     return ret;
 }
 
+static errno_t nss_memcache_init(struct nss_ctx *nctx,
+                                 const char *name,
+                                 enum sss_mc_type type,
+                                 const char *size_option,
+                                 int max_growth,
+                                 int memcache_timeout,
+                                 struct sss_mc_ctx **_mc_ctx)
+{
+    int size;
+    errno_t ret;
+
+    ret = confdb_get_int(nctx->rctx->cdb,
+                         CONFDB_NSS_CONF_ENTRY,
+                         size_option,
+                         SSS_MC_CACHE_ELEMENTS, &size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get '%s' option from confdb.\n", size_option);
+        return ret;
+    }
+
+    if (size < 0) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value of '%s' option: %d\n", size_option, size);
+        return EINVAL;
+    }
+
+    if (size == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "%s mmap cache is disabled by configuration\n", name);
+        return EOK;
+    }
+
+    ret = sss_mmap_cache_init(nctx, name,
+                              nctx->mc_uid, nctx->mc_gid,
+                              type, size, (size_t)size * max_growth,
+                              (time_t)memcache_timeout, _mc_ctx);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "%s mmap cache is DISABLED\n", name);
+    }
+
+    return EOK;
+}
+
 static int setup_memcaches(struct nss_ctx *nctx)
 {
     int ret;
     int memcache_timeout;
+    int max_growth;
 
     /* Remove the CLEAR_MC_FLAG file if exists. */
     ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
@@ -239,32 +285,78 @@ static int setup_memcaches(struct nss_ctx *nctx)
         return EOK;
     }
 
-    /* TODO: read cache sizes from configuration */
-    ret = sss_mmap_cache_init(nctx, "passwd",
-                              nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_PASSWD,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->pwd_mc_ctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "passwd mmap cache is DISABLED\n");
+    ret = confdb_get_int(nctx->rctx->cdb,
+                         CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_MEMCACHE_MAX_GROWTH,
+                         SSS_MC_CACHE_MAX_GROWTH, &max_growth);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get '%s' option from confdb.\n",
+              CONFDB_NSS_MEMCACHE_MAX_GROWTH);
+        return ret;
     }
 
-    ret = sss_mmap_cache_init(nctx, "group",
-                              nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_GROUP,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->grp_mc_ctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "group mmap cache is DISABLED\n");
+    if (max_growth < 1) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value of '%s' option: %d\n",
+              CONFDB_NSS_MEMCACHE_MAX_GROWTH, max_growth);
+        return EINVAL;
     }
 
-    ret = sss_mmap_cache_init(nctx, "initgroups",
-                              nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_INITGROUPS,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->initgr_mc_ctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "initgroups mmap cache is DISABLED\n");
+    ret = nss_memcache_init(nctx, "passwd", SSS_MC_PASSWD,
+                            CONFDB_NSS_MEMCACHE_SIZE_PASSWD,
+                            max_growth, memcache_timeout,
+                            &nctx->pwd_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "group", SSS_MC_GROUP,
+                            CONFDB_NSS_MEMCACHE_SIZE_GROUP,
+                            max_growth, memcache_timeout,
+                            &nctx->grp_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "initgroups", SSS_MC_INITGROUPS,
+                            CONFDB_NSS_MEMCACHE_SIZE_INITGROUPS,
+                            max_growth, memcache_timeout,
+                            &nctx->initgr_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "sid", SSS_MC_SID,
+                            CONFDB_NSS_MEMCACHE_SIZE_SID,
+                            max_growth, memcache_timeout,
+                            &nctx->sid_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "services", SSS_MC_SERVICES,
+                            CONFDB_NSS_MEMCACHE_SIZE_SERVICES,
+                            max_growth, memcache_timeout,
+                            &nctx->svc_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "netgroup", SSS_MC_NETGROUP,
+                            CONFDB_NSS_MEMCACHE_SIZE_NETGROUP,
+                            max_growth, memcache_timeout,
+                            &nctx->netgr_mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = nss_memcache_init(nctx, "negative", SSS_MC_NEGATIVE,
+                            CONFDB_NSS_MEMCACHE_SIZE_NEGATIVE,
+                            max_growth, memcache_timeout,
+                            &nctx->neg_mc_ctx);
+    if (ret != EOK) {
+        return ret;
     }
 
     return EOK;
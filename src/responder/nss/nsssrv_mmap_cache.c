@@ -33,6 +33,21 @@
 #define SSS_AVG_GROUP_PAYLOAD (MC_SLOT_SIZE * 3)
 /* average place for 40 supplementary groups + 2 names */
 #define SSS_AVG_INITGROUP_PAYLOAD (MC_SLOT_SIZE * 5)
+/* domain SID with RID + fully qualified name */
+#define SSS_AVG_SID_PAYLOAD (MC_SLOT_SIZE * 4)
+/* service name, protocol and a couple of aliases */
+#define SSS_AVG_SERVICES_PAYLOAD (MC_SLOT_SIZE * 3)
+/* a handful of triples or member netgroups */
+#define SSS_AVG_NETGROUP_PAYLOAD (MC_SLOT_SIZE * 8)
+/* key only */
+#define SSS_AVG_NEGATIVE_PAYLOAD (MC_SLOT_SIZE * 2)
+
+/* The cache is grown when at least SSS_MC_GROW_EVICTION_RATE percent of
+ * allocations had to evict records that were not expired yet. The rate is
+ * evaluated after every ft_size allocations (an eighth of the elements),
+ * but at least after SSS_MC_GROW_MIN_ALLOCS. */
+#define SSS_MC_GROW_EVICTION_RATE 10
+#define SSS_MC_GROW_MIN_ALLOCS 64
 
 #define MC_NEXT_BARRIER(val) ((((val) + 1) & 0x00ffffff) | 0xf0000000)
 
@@ -72,9 +87,17 @@ struct sss_mc_ctx {
     uint8_t *free_table;    /* free list bitmaps */
     uint32_t ft_size;       /* size of free table */
     uint32_t next_slot;     /* the next slot after last allocation */
+    uint8_t *ref_table;     /* records stored again since the eviction hand
+                             * passed them, same layout as free table but
+                             * kept out of the mmap */
 
     uint8_t *data_table;    /* data table address (in mmap) */
     uint32_t dt_size;       /* size of data table */
+
+    int payload;            /* average payload of an element */
+    size_t max_elem;        /* number of elements the cache can grow to */
+    uint32_t allocs;        /* allocations since the last growth check */
+    uint32_t evictions;     /* unexpired records evicted since then */
 };
 
 #define MC_FIND_BIT(base, num) \
@@ -377,87 +400,224 @@ static bool sss_mc_is_valid_rec(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
     return true;
 }
 
-/* FIXME: This is a very simplistic, inefficient, memory allocator,
- * it will just free the oldest entries regardless of expiration if it
- * cycled the whole free bits map and found no empty slot */
+/* Return 64 slots of the free table starting at @base, which must be a
+ * multiple of 64. The first slot is in the most significant bit, slots
+ * after the end of the table are reported as used. */
+static inline uint64_t sss_mc_free_word(struct sss_mc_ctx *mcc, uint32_t base)
+{
+    uint32_t byte = base / 8;
+    uint64_t word = 0;
+    uint32_t i;
+
+    if (byte + sizeof(uint64_t) <= mcc->ft_size) {
+        for (i = 0; i < sizeof(uint64_t); i++) {
+            word = (word << 8) | mcc->free_table[byte + i];
+        }
+        return word;
+    }
+
+    for (i = 0; i < sizeof(uint64_t); i++) {
+        word <<= 8;
+        word |= byte + i < mcc->ft_size ? mcc->free_table[byte + i] : 0xff;
+    }
+
+    return word;
+}
+
+/* Search [from, to) for num_slots consecutive free slots a word at a time,
+ * runs of free and used slots inside a word are skipped with clz. */
+static bool sss_mc_find_free_run(struct sss_mc_ctx *mcc,
+                                 uint32_t from, uint32_t to,
+                                 uint32_t num_slots, uint32_t *_slot)
+{
+    uint32_t run_start = 0;
+    uint32_t run_len = 0;
+    uint32_t base;
+    uint32_t pos;
+    uint32_t len;
+    uint64_t word;
+    uint64_t bits;
+
+    for (base = from & ~63; base < to; base += 64) {
+        word = sss_mc_free_word(mcc, base);
+
+        /* slots outside of the range are handled as used */
+        if (base < from) {
+            word |= ~(~0ULL >> (from - base));
+        }
+        if (to - base < 64) {
+            word |= ~0ULL >> (to - base);
+        }
+
+        if (word == ~0ULL) {
+            run_len = 0;
+            continue;
+        }
+
+        if (word == 0) {
+            if (run_len == 0) {
+                run_start = base;
+            }
+            run_len += 64;
+            if (run_len >= num_slots) {
+                *_slot = run_start;
+                return true;
+            }
+            continue;
+        }
+
+        pos = 0;
+        while (pos < 64) {
+            /* free slots at pos */
+            bits = word << pos;
+            len = bits == 0 ? 64 - pos : __builtin_clzll(bits);
+            if (len > 0) {
+                if (run_len == 0) {
+                    run_start = base + pos;
+                }
+                run_len += len;
+                if (run_len >= num_slots) {
+                    *_slot = run_start;
+                    return true;
+                }
+                pos += len;
+                if (pos >= 64) {
+                    break;
+                }
+            }
+
+            /* used slots at pos */
+            bits = ~(word << pos);
+            len = bits == 0 ? 64 - pos : __builtin_clzll(bits);
+            run_len = 0;
+            pos += len;
+        }
+    }
+
+    return false;
+}
+
+/* Look for a record in the num_slots slots at cur that was stored again
+ * since the eviction hand passed it and did not expire. Such record gets
+ * a second chance: its reference is dropped and _next is set to the slot
+ * following it. */
+static errno_t sss_mc_find_referenced(struct sss_mc_ctx *mcc,
+                                      uint32_t cur, uint32_t num_slots,
+                                      uint64_t now, uint32_t *_next)
+{
+    struct sss_mc_rec *rec;
+    uint32_t i;
+    bool used;
+
+    for (i = 0; i < num_slots; i++) {
+        MC_PROBE_BIT(mcc->free_table, cur + i, used);
+        if (!used) {
+            continue;
+        }
+
+        /* the first used slot should be a record header, however we
+         * carefully check it is a valid header and hardfail if not */
+        rec = MC_SLOT_TO_PTR(mcc->data_table, cur + i, struct sss_mc_rec);
+        if (!sss_mc_is_valid_rec(mcc, rec)) {
+            return EFAULT;
+        }
+
+        MC_PROBE_BIT(mcc->ref_table, cur + i, used);
+        if (used && rec->expire > now) {
+            MC_CLEAR_BIT(mcc->ref_table, cur + i);
+            *_next = cur + i + MC_SIZE_TO_SLOTS(rec->len);
+            return EOK;
+        }
+
+        /* next loop skip the whole record */
+        i += MC_SIZE_TO_SLOTS(rec->len) - 1;
+    }
+
+    return ENOENT;
+}
+
+/* Free slots are searched from the last allocation on. If there are not
+ * enough consecutive free slots, records are evicted at the same position
+ * using the CLOCK policy, records that were stored again since the last
+ * pass are skipped once. */
 static errno_t sss_mc_find_free_slots(struct sss_mc_ctx *mcc,
                                       int num_slots, uint32_t *free_slot)
 {
     struct sss_mc_rec *rec;
     uint32_t tot_slots;
+    uint32_t tries;
+    uint32_t next;
     uint32_t cur;
+    uint32_t end;
     uint32_t i;
-    uint32_t t;
+    uint64_t now;
+    errno_t ret;
     bool used;
 
     tot_slots = mcc->ft_size * 8;
+    if (num_slots > tot_slots) {
+        return ENOMEM;
+    }
 
-    /* Try to find a free slot w/o removing anything first */
-    /* FIXME: Is it really worth it? Maybe it is easier to
-     * just recycle the next set of slots? */
     if ((mcc->next_slot + num_slots) > tot_slots) {
         cur = 0;
     } else {
         cur = mcc->next_slot;
     }
 
-    /* search for enough (num_slots) consecutive zero bits, indicating
-     * consecutive empty slots */
-    for (i = 0; i < mcc->ft_size; i++) {
-        t = cur / 8;
-        /* if all full in this byte skip directly to the next */
-        if (mcc->free_table[t] == 0xff) {
-            cur = ((cur + 8) & ~7);
-            if (cur >= tot_slots) {
-                cur = 0;
-            }
-            continue;
-        }
+    /* Try to find free slots w/o removing anything first, a run that
+     * starts before cur is found by the second search */
+    end = cur + num_slots - 1;
+    if (end > tot_slots) {
+        end = tot_slots;
+    }
+    if (sss_mc_find_free_run(mcc, cur, tot_slots, num_slots, free_slot)
+            || (cur > 0
+                && sss_mc_find_free_run(mcc, 0, end, num_slots, free_slot))) {
+        mcc->next_slot = *free_slot + num_slots;
+        return EOK;
+    }
 
-        /* at least one bit in this byte is marked as empty */
-        for (t = ((cur + 8) & ~7) ; cur < t; cur++) {
-            MC_PROBE_BIT(mcc->free_table, cur, used);
-            if (!used) break;
-        }
-        /* check if we have enough slots before hitting the table end */
+    /* no free slots found, move the hand past referenced records and free
+     * occupied slots there */
+    now = time(NULL);
+    for (tries = 0; ; tries++) {
         if ((cur + num_slots) > tot_slots) {
             cur = 0;
-            continue;
         }
 
-        /* check if we have at least num_slots empty starting from the first
-         * we found in the previous steps */
-        for (t = cur + num_slots; cur < t; cur++) {
-            MC_PROBE_BIT(mcc->free_table, cur, used);
-            if (used) break;
+        /* every try drops one reference, give up once they could all
+         * have been dropped */
+        if (tries == tot_slots) {
+            break;
         }
-        if (cur == t) {
-            /* ok found num_slots consecutive free bits */
-            *free_slot = cur - num_slots;
-            return EOK;
+
+        ret = sss_mc_find_referenced(mcc, cur, num_slots, now, &next);
+        if (ret == ENOENT) {
+            break;
+        } else if (ret != EOK) {
+            /* this is a fatal error, the caller should probably just
+             * invalidate the whole cache */
+            return ret;
         }
-    }
 
-    /* no free slots found, free occupied slots after next_slot */
-    if ((mcc->next_slot + num_slots) > tot_slots) {
-        cur = 0;
-    } else {
-        cur = mcc->next_slot;
+        cur = next;
     }
+
     for (i = 0; i < num_slots; i++) {
         MC_PROBE_BIT(mcc->free_table, cur + i, used);
         if (used) {
-            /* the first used slot should be a record header, however we
-             * carefully check it is a valid header and hardfail if not */
             rec = MC_SLOT_TO_PTR(mcc->data_table, cur + i, struct sss_mc_rec);
             if (!sss_mc_is_valid_rec(mcc, rec)) {
-                /* this is a fatal error, the caller should probably just
-                 * invalidate the whole cache */
                 return EFAULT;
             }
             /* next loop skip the whole record */
             i += MC_SIZE_TO_SLOTS(rec->len) - 1;
 
+            if (rec->expire > now) {
+                mcc->evictions++;
+            }
+
             /* finally invalidate record completely */
             sss_mc_invalidate_rec(mcc, rec);
         }
@@ -481,6 +641,14 @@ static errno_t sss_mc_get_strs_offset(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_offset = offsetof(struct sss_mc_initgr_data, gids);
         return EOK;
+    case SSS_MC_SID:
+        *_offset = offsetof(struct sss_mc_sid_data, strs);
+        return EOK;
+    case SSS_MC_SERVICES:
+    case SSS_MC_NETGROUP:
+    case SSS_MC_NEGATIVE:
+        *_offset = offsetof(struct sss_mc_reply_data, strs);
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -501,6 +669,14 @@ static errno_t sss_mc_get_strs_len(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_len = ((struct sss_mc_initgr_data *)&rec->data)->data_len;
         return EOK;
+    case SSS_MC_SID:
+        *_len = ((struct sss_mc_sid_data *)&rec->data)->strs_len;
+        return EOK;
+    case SSS_MC_SERVICES:
+    case SSS_MC_NETGROUP:
+    case SSS_MC_NEGATIVE:
+        *_len = ((struct sss_mc_reply_data *)&rec->data)->strs_len;
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -590,6 +766,8 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
     return rec;
 }
 
+static void sss_mc_check_growth(struct sss_mc_ctx *mcc);
+
 static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
                                  size_t rec_len,
                                  struct sized_string *key,
@@ -598,6 +776,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     struct sss_mc_ctx *mcc = *_mcc;
     struct sss_mc_rec *old_rec = NULL;
     struct sss_mc_rec *rec;
+    bool referenced = false;
     int old_slots;
     int num_slots;
     uint32_t base_slot;
@@ -608,9 +787,14 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
 
     old_rec = sss_mc_find_record(mcc, key);
     if (old_rec) {
+        /* the record is requested again, protect it from the next
+         * eviction pass */
+        referenced = true;
         old_slots = MC_SIZE_TO_SLOTS(old_rec->len);
 
         if (old_slots == num_slots) {
+            MC_SET_BIT(mcc->ref_table,
+                       MC_PTR_TO_SLOT(mcc->data_table, old_rec));
             *_rec = old_rec;
             return EOK;
         }
@@ -620,7 +804,10 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
         sss_mc_invalidate_rec(mcc, old_rec);
     }
 
-    /* we are going to use more space, find enough free slots */
+    /* we are going to use more space, grow the cache if it is too small
+     * and find enough free slots */
+    sss_mc_check_growth(mcc);
+
     ret = sss_mc_find_free_slots(mcc, num_slots, &base_slot);
     if (ret != EOK) {
         if (ret == EFAULT) {
@@ -648,6 +835,12 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
         MC_SET_BIT(mcc->free_table, base_slot + i);
     }
 
+    if (referenced) {
+        MC_SET_BIT(mcc->ref_table, base_slot);
+    } else {
+        MC_CLEAR_BIT(mcc->ref_table, base_slot);
+    }
+
     *_rec = rec;
     return EOK;
 }
@@ -1055,6 +1248,340 @@ errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
     return sss_mmap_cache_invalidate(mcc, name);
 }
 
+/***************************************************************************
+ * SID map
+ ***************************************************************************/
+
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *sid,
+                                 uint32_t id,
+                                 uint32_t type,
+                                 uint32_t populated_by)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    struct sized_string idkey;
+    char idstr[11];
+    size_t rec_len;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    ret = snprintf(idstr, 11, "%ld", (long)id);
+    if (ret > 10) {
+        return EINVAL;
+    }
+    to_sized_string(&idkey, idstr);
+
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_sid_data) +
+              sid->len;
+    if (rec_len > mcc->dt_size) {
+        return ENOMEM;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, sid, &rec);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+
+    MC_RAISE_BARRIER(rec);
+
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            sid->str, sid->len, idkey.str, idkey.len);
+
+    data->name = MC_PTR_DIFF(data->strs, data);
+    data->sid = data->name;
+    data->type = type;
+    data->id = id;
+    data->populated_by = populated_by;
+    data->strs_len = sid->len;
+    memcpy(data->strs, sid->str, sid->len);
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    return EOK;
+}
+
+errno_t sss_mmap_cache_sid_name_store(struct sss_mc_ctx **_mcc,
+                                      struct sized_string *name,
+                                      struct sized_string *sid,
+                                      uint32_t type)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    size_t data_len;
+    size_t rec_len;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    data_len = name->len + sid->len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_sid_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        return ENOMEM;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, name, &rec);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+
+    MC_RAISE_BARRIER(rec);
+
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            name->str, name->len, sid->str, sid->len);
+
+    data->name = MC_PTR_DIFF(data->strs, data);
+    data->sid = MC_PTR_DIFF(&data->strs[name->len], data);
+    data->type = type;
+    data->id = 0;
+    data->populated_by = SSS_MC_SID_BY_NAME;
+    data->strs_len = data_len;
+    memcpy(data->strs, name->str, name->len);
+    memcpy(&data->strs[name->len], sid->str, sid->len);
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    return EOK;
+}
+
+/* key is either the SID of an ID record or the name of a name record */
+errno_t sss_mmap_cache_sid_invalidate(struct sss_mc_ctx *mcc,
+                                      struct sized_string *key)
+{
+    return sss_mmap_cache_invalidate(mcc, key);
+}
+
+errno_t sss_mmap_cache_sid_invalidate_id(struct sss_mc_ctx *mcc, uint32_t id)
+{
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    uint32_t hash;
+    uint32_t slot;
+    char *idstr;
+    errno_t ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    idstr = talloc_asprintf(NULL, "%ld", (long)id);
+    if (!idstr) {
+        return ENOMEM;
+    }
+
+    hash = sss_mc_hash(mcc, idstr, strlen(idstr) + 1);
+
+    /* there can be one record for each kind of lookup by ID */
+    ret = ENOENT;
+    slot = mcc->hash_table[hash];
+    while (slot != MC_INVALID_VAL) {
+        if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Corrupted fastcache.\n");
+            sss_mc_save_corrupted(mcc);
+            sss_mmap_cache_reset(mcc);
+            ret = ENOENT;
+            goto done;
+        }
+
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        data = (struct sss_mc_sid_data *)(&rec->data);
+        slot = sss_mc_next_slot_with_hash(rec, hash);
+
+        if (data->populated_by != SSS_MC_SID_BY_NAME && id == data->id) {
+            sss_mc_invalidate_rec(mcc, rec);
+            ret = EOK;
+        }
+    }
+
+done:
+    talloc_zfree(idstr);
+    return ret;
+}
+
+/***************************************************************************
+ * services and netgroups
+ ***************************************************************************/
+
+static errno_t sss_mmap_cache_reply_store(struct sss_mc_ctx **_mcc,
+                                          struct sized_string *key,
+                                          uint8_t *reply, size_t reply_len,
+                                          time_t ttl)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_reply_data *data;
+    size_t data_len;
+    size_t rec_len;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    data_len = key->len + reply_len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_reply_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        return ENOMEM;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, key, &rec);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data = (struct sss_mc_reply_data *)rec->data;
+
+    MC_RAISE_BARRIER(rec);
+
+    /* there is a single lookup key, both hashes are the same */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, ttl,
+                            key->str, key->len, key->str, key->len);
+
+    data->name = MC_PTR_DIFF(data->strs, data);
+    data->reply = MC_PTR_DIFF(&data->strs[key->len], data);
+    data->reply_len = reply_len;
+    data->strs_len = data_len;
+    memcpy(data->strs, key->str, key->len);
+    if (reply_len > 0) {
+        memcpy(&data->strs[key->len], reply, reply_len);
+    }
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    return EOK;
+}
+
+errno_t sss_mmap_cache_svc_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *key,
+                                 uint8_t *reply, size_t reply_len)
+{
+    if (*_mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    return sss_mmap_cache_reply_store(_mcc, key, reply, reply_len,
+                                      (*_mcc)->valid_time_slot);
+}
+
+errno_t sss_mmap_cache_netgr_store(struct sss_mc_ctx **_mcc,
+                                   struct sized_string *name,
+                                   uint8_t *reply, size_t reply_len)
+{
+    if (*_mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    return sss_mmap_cache_reply_store(_mcc, name, reply, reply_len,
+                                      (*_mcc)->valid_time_slot);
+}
+
+errno_t sss_mmap_cache_netgr_invalidate(struct sss_mc_ctx *mcc,
+                                        struct sized_string *name)
+{
+    return sss_mmap_cache_invalidate(mcc, name);
+}
+
+/***************************************************************************
+ * negative entries
+ ***************************************************************************/
+
+static char *sss_mmap_cache_neg_key(TALLOC_CTX *mem_ctx, char kind,
+                                    const char *name, uint32_t id)
+{
+    if (name != NULL) {
+        return talloc_asprintf(mem_ctx, SSS_MC_NEG_NAME_KEY_FMT, kind, name);
+    }
+
+    return talloc_asprintf(mem_ctx, SSS_MC_NEG_ID_KEY_FMT, kind, id);
+}
+
+errno_t sss_mmap_cache_neg_store(struct sss_mc_ctx **_mcc, char kind,
+                                 const char *name, uint32_t id,
+                                 uint32_t timeout)
+{
+    struct sized_string key;
+    char *keystr;
+    time_t ttl;
+    errno_t ret;
+
+    if (*_mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    /* Records never outlive the memory cache timeout. */
+    ttl = (*_mcc)->valid_time_slot;
+    if (timeout < ttl) {
+        ttl = timeout;
+    }
+
+    keystr = sss_mmap_cache_neg_key(NULL, kind, name, id);
+    if (keystr == NULL) {
+        return ENOMEM;
+    }
+    to_sized_string(&key, keystr);
+
+    ret = sss_mmap_cache_reply_store(_mcc, &key, NULL, 0, ttl);
+    talloc_free(keystr);
+
+    return ret;
+}
+
+errno_t sss_mmap_cache_neg_invalidate(struct sss_mc_ctx *mcc, char kind,
+                                      const char *name, uint32_t id)
+{
+    struct sized_string key;
+    char *keystr;
+    errno_t ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    keystr = sss_mmap_cache_neg_key(NULL, kind, name, id);
+    if (keystr == NULL) {
+        return ENOMEM;
+    }
+    to_sized_string(&key, keystr);
+
+    ret = sss_mmap_cache_invalidate(mcc, &key);
+    talloc_free(keystr);
+
+    return ret;
+}
+
 /***************************************************************************
  * initialization
  ***************************************************************************/
@@ -1092,47 +1619,21 @@ static errno_t sss_mc_set_recycled(int fd)
     return EOK;
 }
 
-/*
- * When we (re)create a new file we must mark the current file as recycled
- * so active clients will abandon its use ASAP.
- * We unlink the current file and make a new one.
- */
-static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
+/* Create and lock a new file at @file and store its descriptor in mc_ctx.
+ * A stale file at that path is removed first. */
+static errno_t sss_mc_new_file(struct sss_mc_ctx *mc_ctx, const char *file)
 {
     mode_t old_mask;
-    int ofd;
     int ret, uret;
     useconds_t t = 50000;
     int retries = 3;
 
-    ofd = open(mc_ctx->file, O_RDWR);
-    if (ofd != -1) {
-        ret = sss_br_lock_file(ofd, 0, 1, retries, t);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_FATAL_FAILURE,
-                  "Failed to lock file %s.\n", mc_ctx->file);
-        }
-        ret = sss_mc_set_recycled(ofd);
-        if (ret) {
-            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to mark mmap file %s as"
-                                         " recycled: %d(%s)\n",
-                                         mc_ctx->file, ret, strerror(ret));
-        }
-
-        close(ofd);
-    } else if (errno != ENOENT) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Failed to open old memory cache file %s: %d(%s).\n",
-               mc_ctx->file, ret, strerror(ret));
-    }
-
     errno = 0;
-    ret = unlink(mc_ctx->file);
+    ret = unlink(file);
     if (ret == -1 && errno != ENOENT) {
         ret = errno;
         DEBUG(SSSDBG_TRACE_FUNC, "Failed to rm mmap file %s: %d(%s)\n",
-                                  mc_ctx->file, ret, strerror(ret));
+                                  file, ret, strerror(ret));
     }
 
     /* temporarily relax umask as we need the file to be readable
@@ -1140,12 +1641,12 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
     old_mask = umask(0022);
 
     errno = 0;
-    mc_ctx->fd = open(mc_ctx->file, O_CREAT | O_EXCL | O_RDWR, 0644);
+    mc_ctx->fd = open(file, O_CREAT | O_EXCL | O_RDWR, 0644);
     umask(old_mask);
     if (mc_ctx->fd == -1) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to open mmap file %s: %d(%s)\n",
-                                    mc_ctx->file, ret, strerror(ret));
+                                    file, ret, strerror(ret));
         return ret;
     }
 
@@ -1157,7 +1658,7 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
     if (ret != 0) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to chown mmap file %s: %d(%s)\n",
-                                   mc_ctx->file, ret, strerror(ret));
+                                   file, ret, strerror(ret));
         return ret;
     }
 
@@ -1165,14 +1666,14 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
     if (ret == -1) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to chmod mmap file %s: %d(%s)\n",
-                                   mc_ctx->file, ret, strerror(ret));
+                                   file, ret, strerror(ret));
         return ret;
     }
 
     ret = sss_br_lock_file(mc_ctx->fd, 0, 1, retries, t);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE,
-              "Failed to lock file %s.\n", mc_ctx->file);
+              "Failed to lock file %s.\n", file);
         close(mc_ctx->fd);
         mc_ctx->fd = -1;
 
@@ -1180,11 +1681,11 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
          * from sss_br_lock_file
          */
         errno = 0;
-        uret = unlink(mc_ctx->file);
+        uret = unlink(file);
         if (uret == -1) {
             uret = errno;
             DEBUG(SSSDBG_TRACE_FUNC, "Failed to rm mmap file %s: %d(%s)\n",
-                                    mc_ctx->file, uret, strerror(uret));
+                                    file, uret, strerror(uret));
         }
 
         return ret;
@@ -1193,6 +1694,43 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
     return ret;
 }
 
+/*
+ * When we (re)create a new file we must mark the current file as recycled
+ * so active clients will abandon its use ASAP.
+ * We unlink the current file and make a new one.
+ */
+static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
+{
+    int ofd;
+    int ret;
+    useconds_t t = 50000;
+    int retries = 3;
+
+    ofd = open(mc_ctx->file, O_RDWR);
+    if (ofd != -1) {
+        ret = sss_br_lock_file(ofd, 0, 1, retries, t);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Failed to lock file %s.\n", mc_ctx->file);
+        }
+        ret = sss_mc_set_recycled(ofd);
+        if (ret) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to mark mmap file %s as"
+                                         " recycled: %d(%s)\n",
+                                         mc_ctx->file, ret, strerror(ret));
+        }
+
+        close(ofd);
+    } else if (errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to open old memory cache file %s: %d(%s).\n",
+               mc_ctx->file, ret, strerror(ret));
+    }
+
+    return sss_mc_new_file(mc_ctx, mc_ctx->file);
+}
+
 static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
 {
     struct sss_mc_header *h;
@@ -1248,13 +1786,216 @@ static int mc_ctx_destructor(struct sss_mc_ctx *mc_ctx)
     return 0;
 }
 
+/* Compute sizes of the data and free tables for n_elem elements, the hash
+ * table size must be already set. */
+static void sss_mc_set_size(struct sss_mc_ctx *mc_ctx, size_t n_elem)
+{
+    mc_ctx->dt_size = MC_DT_SIZE(n_elem, mc_ctx->payload);
+    mc_ctx->ft_size = MC_FT_SIZE(n_elem);
+    mc_ctx->mmap_size = MC_HEADER_SIZE +
+                        MC_ALIGN64(mc_ctx->dt_size) +
+                        MC_ALIGN64(mc_ctx->ft_size) +
+                        MC_ALIGN64(mc_ctx->ht_size);
+}
+
+static errno_t sss_mc_map_file(struct sss_mc_ctx *mc_ctx, const char *file)
+{
+    int ret;
+
+    ret = ftruncate(mc_ctx->fd, mc_ctx->mmap_size);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to resize file %s: %d(%s)\n",
+                                    file, ret, strerror(ret));
+        return ret;
+    }
+
+    mc_ctx->mmap_base = mmap(NULL, mc_ctx->mmap_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED, mc_ctx->fd, 0);
+    if (mc_ctx->mmap_base == MAP_FAILED) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to mmap file %s(%zu): %d(%s)\n",
+                                    file, mc_ctx->mmap_size,
+                                    ret, strerror(ret));
+        mc_ctx->mmap_base = NULL;
+        return ret;
+    }
+
+    mc_ctx->data_table = MC_PTR_ADD(mc_ctx->mmap_base, MC_HEADER_SIZE);
+    mc_ctx->free_table = MC_PTR_ADD(mc_ctx->data_table,
+                                    MC_ALIGN64(mc_ctx->dt_size));
+    mc_ctx->hash_table = MC_PTR_ADD(mc_ctx->free_table,
+                                    MC_ALIGN64(mc_ctx->ft_size));
+
+    return EOK;
+}
+
+/* Move the cache into a file with room for more elements. The hash table
+ * keeps its size and the data and free tables only get longer, so the
+ * contents are copied as they are and all slot numbers stay valid. The new
+ * file is renamed over the current one once it is complete and the current
+ * one is marked as recycled, so clients switch to the new file on their next
+ * lookup. */
+static errno_t sss_mc_grow(struct sss_mc_ctx *mcc)
+{
+    struct sss_mc_ctx *new_mc;
+    uint8_t *old_ref_table;
+    void *old_base;
+    size_t old_size;
+    size_t n_elem;
+    int old_fd;
+    int dret;
+    errno_t ret;
+
+    n_elem = mcc->ft_size * 8 * 2;
+    if (n_elem > mcc->max_elem) {
+        n_elem = mcc->max_elem;
+    }
+
+    new_mc = talloc_zero(mcc, struct sss_mc_ctx);
+    if (new_mc == NULL) {
+        return ENOMEM;
+    }
+    new_mc->fd = -1;
+    talloc_set_destructor(new_mc, mc_ctx_destructor);
+
+    new_mc->file = talloc_asprintf(new_mc, "%s.grow", mcc->file);
+    if (new_mc->file == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    new_mc->uid = mcc->uid;
+    new_mc->gid = mcc->gid;
+    new_mc->seed = mcc->seed;
+    new_mc->payload = mcc->payload;
+    new_mc->ht_size = mcc->ht_size;
+    sss_mc_set_size(new_mc, n_elem);
+
+    new_mc->ref_table = talloc_zero_size(new_mc, new_mc->ft_size);
+    if (new_mc->ref_table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(new_mc->ref_table, mcc->ref_table, mcc->ft_size);
+
+    ret = sss_mc_new_file(new_mc, new_mc->file);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_mc_map_file(new_mc, new_mc->file);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    memcpy(new_mc->data_table, mcc->data_table, mcc->dt_size);
+    memset(new_mc->data_table + mcc->dt_size, 0xff,
+           new_mc->dt_size - mcc->dt_size);
+    memcpy(new_mc->free_table, mcc->free_table, mcc->ft_size);
+    memset(new_mc->free_table + mcc->ft_size, 0x00,
+           new_mc->ft_size - mcc->ft_size);
+    memcpy(new_mc->hash_table, mcc->hash_table, mcc->ht_size);
+
+    sss_mc_header_update(new_mc, SSS_MC_HEADER_ALIVE);
+
+    ret = rename(new_mc->file, mcc->file);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to rename %s to %s: %d(%s)\n",
+              new_mc->file, mcc->file, ret, strerror(ret));
+        goto done;
+    }
+
+    sss_mc_header_update(mcc, SSS_MC_HEADER_RECYCLED);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%s mmap cache grown from %u to %zu elements\n",
+          mcc->name, mcc->ft_size * 8, n_elem);
+
+    /* Switch to the new mapping, the old one is released with new_mc. */
+    old_base = mcc->mmap_base;
+    old_size = mcc->mmap_size;
+    old_fd = mcc->fd;
+    old_ref_table = mcc->ref_table;
+
+    mcc->mmap_base = new_mc->mmap_base;
+    mcc->mmap_size = new_mc->mmap_size;
+    mcc->fd = new_mc->fd;
+    mcc->data_table = new_mc->data_table;
+    mcc->dt_size = new_mc->dt_size;
+    mcc->free_table = new_mc->free_table;
+    mcc->ft_size = new_mc->ft_size;
+    mcc->hash_table = new_mc->hash_table;
+    mcc->ref_table = talloc_steal(mcc, new_mc->ref_table);
+
+    new_mc->mmap_base = old_base;
+    new_mc->mmap_size = old_size;
+    new_mc->fd = old_fd;
+    new_mc->ref_table = talloc_steal(new_mc, old_ref_table);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK && new_mc->fd != -1) {
+        dret = unlink(new_mc->file);
+        if (dret == -1) {
+            dret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to rm mmap file %s: %d(%s)\n", new_mc->file,
+                   dret, strerror(dret));
+        }
+    }
+
+    talloc_free(new_mc);
+    return ret;
+}
+
+static void sss_mc_check_growth(struct sss_mc_ctx *mcc)
+{
+    uint32_t window;
+    errno_t ret;
+
+    mcc->allocs++;
+
+    window = mcc->ft_size;
+    if (window < SSS_MC_GROW_MIN_ALLOCS) {
+        window = SSS_MC_GROW_MIN_ALLOCS;
+    }
+
+    if (mcc->allocs < window) {
+        return;
+    }
+
+    if (mcc->ft_size * 8 < mcc->max_elem
+            && (uint64_t)mcc->evictions * 100
+                    >= (uint64_t)mcc->allocs * SSS_MC_GROW_EVICTION_RATE) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "%u of last %u allocations in %s mmap cache evicted valid "
+              "records, growing the cache\n",
+              mcc->evictions, mcc->allocs, mcc->name);
+
+        ret = sss_mc_grow(mcc);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to grow %s mmap cache [%d]: %s\n",
+                  mcc->name, ret, sss_strerror(ret));
+        }
+    }
+
+    mcc->allocs = 0;
+    mcc->evictions = 0;
+}
+
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             uid_t uid, gid_t gid,
-                            enum sss_mc_type type, size_t n_elem,
+                            enum sss_mc_type type,
+                            size_t n_elem, size_t max_elem,
                             time_t timeout, struct sss_mc_ctx **mcc)
 {
     struct sss_mc_ctx *mc_ctx = NULL;
     unsigned int rseed;
+    size_t limit;
     int payload;
     int ret, dret;
 
@@ -1268,6 +2009,18 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     case SSS_MC_INITGROUPS:
         payload = SSS_AVG_INITGROUP_PAYLOAD;
         break;
+    case SSS_MC_SID:
+        payload = SSS_AVG_SID_PAYLOAD;
+        break;
+    case SSS_MC_SERVICES:
+        payload = SSS_AVG_SERVICES_PAYLOAD;
+        break;
+    case SSS_MC_NETGROUP:
+        payload = SSS_AVG_NETGROUP_PAYLOAD;
+        break;
+    case SSS_MC_NEGATIVE:
+        payload = SSS_AVG_NEGATIVE_PAYLOAD;
+        break;
     default:
         return EINVAL;
     }
@@ -1303,17 +2056,43 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
      * so we increase by the necessary amount if they are not a multiple */
     /* We can use MC_ALIGN64 for this */
     n_elem = MC_ALIGN64(n_elem);
+    max_elem = MC_ALIGN64(max_elem);
+    if (max_elem < n_elem) {
+        max_elem = n_elem;
+    }
+
+    /* all tables must be addressable with 32-bit offsets */
+    limit = (UINT32_MAX - MC_HEADER_SIZE) / (payload + MC_HT_SIZE(2) + 1);
+    limit -= limit % 8;
+    if (n_elem > limit) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "%s mmap cache cannot hold %zu elements, the maximum is %zu\n",
+              name, n_elem, limit);
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (max_elem > limit) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "%s mmap cache will not grow beyond %zu elements\n",
+              name, limit);
+        max_elem = limit;
+    }
+
+    mc_ctx->payload = payload;
+    mc_ctx->max_elem = max_elem;
 
     /* hash table is double the size because it will store both forward and
-     * reverse keys (name/uid, name/gid, ..) */
-    mc_ctx->ht_size = MC_HT_SIZE(n_elem * 2);
-    mc_ctx->dt_size = MC_DT_SIZE(n_elem, payload);
-    mc_ctx->ft_size = MC_FT_SIZE(n_elem);
-    mc_ctx->mmap_size = MC_HEADER_SIZE +
-                        MC_ALIGN64(mc_ctx->dt_size) +
-                        MC_ALIGN64(mc_ctx->ft_size) +
-                        MC_ALIGN64(mc_ctx->ht_size);
+     * reverse keys (name/uid, name/gid, ..), it is sized for the maximal
+     * number of elements so growing the cache does not require rehashing */
+    mc_ctx->ht_size = MC_HT_SIZE(max_elem * 2);
+    sss_mc_set_size(mc_ctx, n_elem);
 
+    mc_ctx->ref_table = talloc_zero_size(mc_ctx, mc_ctx->ft_size);
+    if (mc_ctx->ref_table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
 
     /* for now ALWAYS create a new file on restart */
 
@@ -1322,31 +2101,11 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
         goto done;
     }
 
-    ret = ftruncate(mc_ctx->fd, mc_ctx->mmap_size);
-    if (ret == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to resize file %s: %d(%s)\n",
-                                    mc_ctx->file, ret, strerror(ret));
-        goto done;
-    }
-
-    mc_ctx->mmap_base = mmap(NULL, mc_ctx->mmap_size,
-                             PROT_READ | PROT_WRITE,
-                             MAP_SHARED, mc_ctx->fd, 0);
-    if (mc_ctx->mmap_base == MAP_FAILED) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to mmap file %s(%zu): %d(%s)\n",
-                                    mc_ctx->file, mc_ctx->mmap_size,
-                                    ret, strerror(ret));
+    ret = sss_mc_map_file(mc_ctx, mc_ctx->file);
+    if (ret != EOK) {
         goto done;
     }
 
-    mc_ctx->data_table = MC_PTR_ADD(mc_ctx->mmap_base, MC_HEADER_SIZE);
-    mc_ctx->free_table = MC_PTR_ADD(mc_ctx->data_table,
-                                    MC_ALIGN64(mc_ctx->dt_size));
-    mc_ctx->hash_table = MC_PTR_ADD(mc_ctx->free_table,
-                                    MC_ALIGN64(mc_ctx->ft_size));
-
     memset(mc_ctx->data_table, 0xff, mc_ctx->dt_size);
     memset(mc_ctx->free_table, 0x00, mc_ctx->ft_size);
     memset(mc_ctx->hash_table, 0xff, mc_ctx->ht_size);
@@ -1390,6 +2149,7 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
     TALLOC_CTX* tmp_ctx = NULL;
     char *name;
     enum sss_mc_type type;
+    size_t max_elem;
 
     if (mc_ctx == NULL || (*mc_ctx) == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1411,6 +2171,7 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
     }
 
     type = (*mc_ctx)->type;
+    max_elem = (*mc_ctx)->max_elem;
 
     if (n_elem == (size_t)-1) {
         n_elem = (*mc_ctx)->ft_size * 8;
@@ -1438,6 +2199,7 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               uid, gid,
                               type,
                               n_elem,
+                              max_elem,
                               timeout,
                               mc_ctx);
     if (ret != EOK) {
@@ -1466,6 +2228,7 @@ void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx)
     memset(mc_ctx->data_table, 0xff, mc_ctx->dt_size);
     memset(mc_ctx->free_table, 0x00, mc_ctx->ft_size);
     memset(mc_ctx->hash_table, 0xff, mc_ctx->ht_size);
+    memset(mc_ctx->ref_table, 0x00, mc_ctx->ft_size);
 
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
 }
@@ -23,6 +23,7 @@
 #define _NSSSRV_MMAP_CACHE_H_
 
 #define SSS_MC_CACHE_ELEMENTS 50000
+#define SSS_MC_CACHE_MAX_GROWTH 4
 
 struct sss_mc_ctx;
 
@@ -31,11 +32,18 @@ enum sss_mc_type {
     SSS_MC_PASSWD,
     SSS_MC_GROUP,
     SSS_MC_INITGROUPS,
+    SSS_MC_SID,
+    SSS_MC_SERVICES,
+    SSS_MC_NETGROUP,
+    SSS_MC_NEGATIVE,
 };
 
+/* The cache is created for n_elem elements and grows online up to
+ * max_elem elements when it is too small to keep the active records. */
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             uid_t uid, gid_t gid,
-                            enum sss_mc_type type, size_t n_elem,
+                            enum sss_mc_type type,
+                            size_t n_elem, size_t max_elem,
                             time_t valid_time, struct sss_mc_ctx **mcc);
 
 errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
@@ -58,6 +66,30 @@ errno_t sss_mmap_cache_initgr_store(struct sss_mc_ctx **_mcc,
                                     uint32_t num_groups,
                                     uint8_t *gids_buf);
 
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *sid,
+                                 uint32_t id,
+                                 uint32_t type,
+                                 uint32_t populated_by);
+
+errno_t sss_mmap_cache_sid_name_store(struct sss_mc_ctx **_mcc,
+                                      struct sized_string *name,
+                                      struct sized_string *sid,
+                                      uint32_t type);
+
+errno_t sss_mmap_cache_svc_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *key,
+                                 uint8_t *reply, size_t reply_len);
+
+errno_t sss_mmap_cache_netgr_store(struct sss_mc_ctx **_mcc,
+                                   struct sized_string *name,
+                                   uint8_t *reply, size_t reply_len);
+
+/* kind is one of SSS_MC_NEG_*, name is NULL for the ID kinds */
+errno_t sss_mmap_cache_neg_store(struct sss_mc_ctx **_mcc, char kind,
+                                 const char *name, uint32_t id,
+                                 uint32_t timeout);
+
 errno_t sss_mmap_cache_pw_invalidate(struct sss_mc_ctx *mcc,
                                      struct sized_string *name);
 
@@ -71,6 +103,17 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid);
 errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
                                          struct sized_string *name);
 
+errno_t sss_mmap_cache_sid_invalidate(struct sss_mc_ctx *mcc,
+                                      struct sized_string *key);
+
+errno_t sss_mmap_cache_sid_invalidate_id(struct sss_mc_ctx *mcc, uint32_t id);
+
+errno_t sss_mmap_cache_netgr_invalidate(struct sss_mc_ctx *mcc,
+                                        struct sized_string *name);
+
+errno_t sss_mmap_cache_neg_invalidate(struct sss_mc_ctx *mcc, char kind,
+                                      const char *name, uint32_t id);
+
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               uid_t uid, gid_t gid,
                               size_t n_elem,
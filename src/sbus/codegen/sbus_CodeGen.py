@@ -41,6 +41,9 @@ class CodeGen:
         - codegen.CustomOutputHandler
           - boolean, default is false
           - handler parses its output parameters manually
+        - codegen.FrameTransport
+          - boolean, default is false
+          - generate binary frame readers and writers for method arguments
 
         * Annotations on interfaces, methods or properties:
         - codegen.Name
@@ -257,11 +260,12 @@ def InitializeDataTypes():
 
     # Custom types
     DataType.Create("pam_data", "struct pam_data *",
-                    DBusType="issssssuayuayiu", RequireTalloc=True)
+                    DBusType="issssssuayuayiu", RequireTalloc=True,
+                    Frame=False)
     DataType.Create("pam_response", "struct pam_data *",
-                    DBusType="uua(uay)", RequireTalloc=True)
+                    DBusType="uua(uay)", RequireTalloc=True, Frame=False)
     DataType.Create("ifp_extra", "hash_table_t *",
-                    DBusType="a{sas}", RequireTalloc=True)
+                    DBusType="a{sas}", RequireTalloc=True, Frame=False)
 
 
 def main():
@@ -30,11 +30,14 @@ class DataType:
     available = {}
 
     def __init__(self, sbus_type, dbus_type, c_type, key_format,
-                 require_talloc):
+                 require_talloc, frame):
         self.sbus_type = sbus_type
         self.dbus_type = dbus_type
         self.RequireTalloc = require_talloc
 
+        # True if the type can be sent over binary frame transport
+        self.Frame = frame
+
         # Printf formatter (without leading %) if the type supports keying
         self.keyFormat = key_format
 
@@ -64,14 +67,16 @@ class DataType:
 
     @staticmethod
     def Create(sbus_type, c_type, KeyFormat=None, DBusType=None,
-               RequireTalloc=False):
+               RequireTalloc=False, Frame=True):
         """ Create a new SBus type. Specify DBusType if it differes from
             the SBus type. Specify printf formatter KeyFormat if this type
-            can be used as a key.
+            can be used as a key. Set Frame to False if the type has no
+            binary frame reader and writer.
         """
         dbus_type = DBusType if DBusType is not None else sbus_type
 
-        type = DataType(sbus_type, dbus_type, c_type, KeyFormat, RequireTalloc)
+        type = DataType(sbus_type, dbus_type, c_type, KeyFormat, RequireTalloc,
+                        Frame)
         DataType.available[sbus_type] = type
 
         return type
@@ -43,6 +43,7 @@ class Generator:
 
         invokers = Invoker.GatherInvokers(interfaces)
         arguments = InvokerArgumentType.GatherArgumentTypes(interfaces)
+        frame_signatures = InvokerArgumentType.GatherFrameSignatures(interfaces)
         keygens = InvokerKeygen.GatherKeygens(interfaces)
         sync_callers = Callers(interfaces, "sync")
         async_callers = Callers(interfaces, "async")
@@ -57,7 +58,7 @@ class Generator:
 
             Generator.Arguments(templates.get("arguments.c"),
                                 templates.get("arguments.h"),
-                                arguments),
+                                arguments, frame_signatures),
 
             Generator.Invokers(templates.get("invokers.c"),
                                templates.get("invokers.h"),
@@ -433,17 +434,34 @@ class Generator:
             - arguments.h
         """
 
-        def __init__(self, source, header, invoker_arguments):
+        def __init__(self, source, header, invoker_arguments,
+                     frame_signatures):
             super(Generator.Arguments, self).__init__()
 
             self.source = source
             self.header = header
             self.invoker_arguments = invoker_arguments
+            self.frame_signatures = frame_signatures
 
         def generate(self):
             self.generateSource()
             self.generateHeader()
 
+        def hasFrame(self, signature, args):
+            """
+                Return true if the signature belongs to a method that uses
+                binary frame transport and all its arguments can be sent
+                over it.
+            """
+            if signature not in self.frame_signatures:
+                return False
+
+            for arg in args.values():
+                if not DataType.Find(arg.signature).Frame:
+                    return False
+
+            return True
+
         def generateSource(self):
             tpl = self.source.get("arguments")
             for signature, args in self.invoker_arguments.items():
@@ -455,6 +473,10 @@ class Generator:
                             "index": idx}
                     tpl.add('read-argument', keys)
                     tpl.add('write-argument', keys)
+                    tpl.add('frame-read-argument', keys)
+                    tpl.add('frame-write-argument', keys)
+
+                tpl.show("if-frame", self.hasFrame(signature, args))
 
                 keys = {"signature": signature}
                 tpl.set(keys)
@@ -467,6 +489,8 @@ class Generator:
                             "index": idx}
                     tpl.add('args', keys)
 
+                tpl.show("if-frame", self.hasFrame(signature, args))
+
                 keys = {"signature": signature}
                 tpl.set(keys)
 
@@ -178,6 +178,31 @@ class InvokerArgumentType:
 
         dict[sbus_signature.signature] = sbus_signature.arguments
 
+    @staticmethod
+    def GatherFrameSignatures(interfaces):
+        """
+            Gather input and output signatures of methods that are annotated
+            with codegen.FrameTransport.
+        """
+        signatures = set()
+        for iface in interfaces.values():
+            for method in iface.methods.values():
+                if not InvokerArgumentType.IsFrameTransport(method):
+                    continue
+
+                for sbus_signature in [method.input, method.output]:
+                    if sbus_signature is None:
+                        continue
+                    signatures.add(sbus_signature.signature)
+
+        return signatures
+
+    @staticmethod
+    def IsFrameTransport(method):
+        names = ["codegen.FrameTransport"]
+
+        return SBus.Annotation.CheckIfTrue(names, method.annotations)
+
 
 class InvokerKeygen:
     """ Invoker Keygen is a piece of C code that takes care of
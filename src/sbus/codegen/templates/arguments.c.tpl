@@ -26,6 +26,7 @@
 
     #include "${sbus-path}/interface/sbus_iterator_readers.h"
     #include "${sbus-path}/interface/sbus_iterator_writers.h"
+    #include "${sbus-path}/frame/sbus_frame.h"
     #include "${header:arguments}"
 
 </template>
@@ -64,4 +65,39 @@
         return EOK;
     }
 
+    <toggle name="if-frame">
+    errno_t _sbus_invoker_frame_read_${signature}
+       (TALLOC_CTX *mem_ctx,
+        struct sbus_frame_reader *reader,
+        struct _sbus_invoker_args_${signature} *args)
+    {
+        errno_t ret;
+
+        <loop name="frame-read-argument">
+        ret = sbus_frame_read_${arg-signature}(${talloc-context}reader, &args->arg${index});
+        if (ret != EOK) {
+            return ret;
+        }
+
+        </loop>
+        return EOK;
+    }
+
+    errno_t _sbus_invoker_frame_write_${signature}
+       (struct sbus_frame_writer *writer,
+        struct _sbus_invoker_args_${signature} *args)
+    {
+        errno_t ret;
+
+        <loop name="frame-write-argument">
+        ret = sbus_frame_write_${arg-signature}(writer, args->arg${index});
+        if (ret != EOK) {
+            return ret;
+        }
+
+        </loop>
+        return EOK;
+    }
+
+    </toggle>
 </template>
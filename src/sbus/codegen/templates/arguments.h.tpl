@@ -27,6 +27,7 @@
     #include <stdbool.h>
     #include <dbus/dbus.h>
 
+    #include "${sbus-path}/frame/sbus_frame.h"
     <loop name="custom-type-header">
     #include "${custom-type-header}"
     </loop>
@@ -51,6 +52,19 @@
        (DBusMessageIter *iter,
         struct _sbus_invoker_args_${signature} *args);
 
+    <toggle name="if-frame">
+    errno_t
+    _sbus_invoker_frame_read_${signature}
+       (TALLOC_CTX *mem_ctx,
+        struct sbus_frame_reader *reader,
+        struct _sbus_invoker_args_${signature} *args);
+
+    errno_t
+    _sbus_invoker_frame_write_${signature}
+       (struct sbus_frame_writer *writer,
+        struct _sbus_invoker_args_${signature} *args);
+
+    </toggle>
 </template>
 
 <template name="file-footer">
@@ -0,0 +1,255 @@
+/*
+    SSSD
+
+    sbus binary framing
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SBUS_FRAME_H_
+#define _SBUS_FRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+
+/* Binary framing is a private transport between SSSD processes that
+ * bypasses D-Bus message marshalling. Both peers run on the same host,
+ * so values are stored in host byte order without any padding:
+ *
+ * - fixed size values are stored as is, bool as one byte
+ * - strings are stored as uint32_t length, the bytes and a terminating
+ *   zero so they can be read directly from the received buffer
+ * - arrays are stored as uint32_t number of elements and the elements
+ *
+ * Every frame starts with struct sbus_frame_header. */
+
+#define SBUS_FRAME_MAGIC 0x53424652 /* SBFR */
+#define SBUS_FRAME_VERSION 1
+#define SBUS_FRAME_MAX_SIZE (16 * 1024 * 1024)
+
+enum sbus_frame_type {
+    SBUS_FRAME_HELLO = 1,
+    SBUS_FRAME_CALL,
+    SBUS_FRAME_REPLY,
+    SBUS_FRAME_ERROR
+};
+
+struct sbus_frame_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t serial;
+    uint32_t length; /* payload length */
+};
+
+struct sbus_frame_writer;
+
+/* Reads values from a received payload. Strings that are read with the
+ * const variants (s, o, as, ao) point into the payload so they are valid
+ * only as long as the payload is. */
+struct sbus_frame_reader {
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+};
+
+/* Create a new frame, header space is reserved at the beginning. */
+struct sbus_frame_writer *
+sbus_frame_writer_create(TALLOC_CTX *mem_ctx);
+
+/* Fill in the header and return the whole frame. The frame is owned
+ * by the writer. */
+errno_t sbus_frame_writer_finish(struct sbus_frame_writer *writer,
+                                 enum sbus_frame_type type,
+                                 uint32_t serial,
+                                 uint8_t **_frame,
+                                 size_t *_frame_len);
+
+void sbus_frame_reader_init(struct sbus_frame_reader *reader,
+                            const uint8_t *data,
+                            size_t length);
+
+/* Return true if the whole payload was read. */
+bool sbus_frame_reader_done(struct sbus_frame_reader *reader);
+
+errno_t sbus_frame_write_y(struct sbus_frame_writer *writer, uint8_t value);
+errno_t sbus_frame_write_b(struct sbus_frame_writer *writer, bool value);
+errno_t sbus_frame_write_n(struct sbus_frame_writer *writer, int16_t value);
+errno_t sbus_frame_write_q(struct sbus_frame_writer *writer, uint16_t value);
+errno_t sbus_frame_write_i(struct sbus_frame_writer *writer, int32_t value);
+errno_t sbus_frame_write_u(struct sbus_frame_writer *writer, uint32_t value);
+errno_t sbus_frame_write_x(struct sbus_frame_writer *writer, int64_t value);
+errno_t sbus_frame_write_t(struct sbus_frame_writer *writer, uint64_t value);
+errno_t sbus_frame_write_d(struct sbus_frame_writer *writer, double value);
+errno_t sbus_frame_write_s(struct sbus_frame_writer *writer,
+                           const char *value);
+errno_t sbus_frame_write_S(struct sbus_frame_writer *writer, char *value);
+errno_t sbus_frame_write_o(struct sbus_frame_writer *writer,
+                           const char *value);
+errno_t sbus_frame_write_O(struct sbus_frame_writer *writer, char *value);
+errno_t sbus_frame_write_ay(struct sbus_frame_writer *writer, uint8_t *value);
+errno_t sbus_frame_write_ab(struct sbus_frame_writer *writer, bool *value);
+errno_t sbus_frame_write_an(struct sbus_frame_writer *writer, int16_t *value);
+errno_t sbus_frame_write_aq(struct sbus_frame_writer *writer,
+                            uint16_t *value);
+errno_t sbus_frame_write_ai(struct sbus_frame_writer *writer, int32_t *value);
+errno_t sbus_frame_write_au(struct sbus_frame_writer *writer,
+                            uint32_t *value);
+errno_t sbus_frame_write_ax(struct sbus_frame_writer *writer, int64_t *value);
+errno_t sbus_frame_write_at(struct sbus_frame_writer *writer,
+                            uint64_t *value);
+errno_t sbus_frame_write_ad(struct sbus_frame_writer *writer, double *value);
+errno_t sbus_frame_write_as(struct sbus_frame_writer *writer,
+                            const char **value);
+errno_t sbus_frame_write_aS(struct sbus_frame_writer *writer, char **value);
+errno_t sbus_frame_write_ao(struct sbus_frame_writer *writer,
+                            const char **value);
+errno_t sbus_frame_write_aO(struct sbus_frame_writer *writer, char **value);
+
+errno_t sbus_frame_read_y(struct sbus_frame_reader *reader, uint8_t *_value);
+errno_t sbus_frame_read_b(struct sbus_frame_reader *reader, bool *_value);
+errno_t sbus_frame_read_n(struct sbus_frame_reader *reader, int16_t *_value);
+errno_t sbus_frame_read_q(struct sbus_frame_reader *reader, uint16_t *_value);
+errno_t sbus_frame_read_i(struct sbus_frame_reader *reader, int32_t *_value);
+errno_t sbus_frame_read_u(struct sbus_frame_reader *reader, uint32_t *_value);
+errno_t sbus_frame_read_x(struct sbus_frame_reader *reader, int64_t *_value);
+errno_t sbus_frame_read_t(struct sbus_frame_reader *reader, uint64_t *_value);
+errno_t sbus_frame_read_d(struct sbus_frame_reader *reader, double *_value);
+errno_t sbus_frame_read_s(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          const char **_value);
+errno_t sbus_frame_read_S(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          char **_value);
+errno_t sbus_frame_read_o(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          const char **_value);
+errno_t sbus_frame_read_O(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          char **_value);
+errno_t sbus_frame_read_ay(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint8_t **_value);
+errno_t sbus_frame_read_ab(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           bool **_value);
+errno_t sbus_frame_read_an(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int16_t **_value);
+errno_t sbus_frame_read_aq(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint16_t **_value);
+errno_t sbus_frame_read_ai(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int32_t **_value);
+errno_t sbus_frame_read_au(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint32_t **_value);
+errno_t sbus_frame_read_ax(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int64_t **_value);
+errno_t sbus_frame_read_at(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint64_t **_value);
+errno_t sbus_frame_read_ad(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           double **_value);
+errno_t sbus_frame_read_as(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           const char ***_value);
+errno_t sbus_frame_read_aS(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           char ***_value);
+errno_t sbus_frame_read_ao(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           const char ***_value);
+errno_t sbus_frame_read_aO(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           char ***_value);
+
+/* Transport */
+
+struct sbus_frame_conn;
+struct sbus_frame_server;
+
+/* Method handler of the frame server. Input arguments are read from @in
+ * in send, output arguments are written into @out in recv. */
+typedef struct tevent_req *
+(*sbus_frame_handler_send_fn)(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              struct sbus_frame_reader *in,
+                              void *data);
+
+typedef errno_t
+(*sbus_frame_handler_recv_fn)(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              struct sbus_frame_writer *out);
+
+struct sbus_frame_method {
+    const char *iface;
+    const char *method;
+    sbus_frame_handler_send_fn send_fn;
+    sbus_frame_handler_recv_fn recv_fn;
+    void *data;
+};
+
+/* Path of the frame socket that accompanies the given D-Bus address. */
+char *sbus_frame_socket_path(TALLOC_CTX *mem_ctx, const char *dbus_address);
+
+/* Listen on @socket_path and serve @methods, which is terminated by an
+ * entry with iface set to NULL and must outlive the server. */
+errno_t sbus_frame_server_create(TALLOC_CTX *mem_ctx,
+                                 struct tevent_context *ev,
+                                 const char *socket_path,
+                                 uid_t uid,
+                                 gid_t gid,
+                                 const struct sbus_frame_method *methods,
+                                 struct sbus_frame_server **_server);
+
+/* Connect to a frame server and negotiate the protocol version. If the
+ * server does not exist or speaks a different version, ERR_SBUS_NOSUP is
+ * returned and the caller is expected to keep using D-Bus. */
+struct tevent_req *
+sbus_frame_connect_send(TALLOC_CTX *mem_ctx,
+                        struct tevent_context *ev,
+                        const char *socket_path);
+
+errno_t sbus_frame_connect_recv(TALLOC_CTX *mem_ctx,
+                                struct tevent_req *req,
+                                struct sbus_frame_conn **_conn);
+
+/* Writer for a method call, input arguments are appended to it. */
+struct sbus_frame_writer *
+sbus_frame_call_writer(TALLOC_CTX *mem_ctx,
+                       const char *iface,
+                       const char *method);
+
+/* Send the call, @call is stolen by the request. */
+struct tevent_req *
+sbus_frame_call_send(TALLOC_CTX *mem_ctx,
+                     struct sbus_frame_conn *conn,
+                     struct sbus_frame_writer *call);
+
+/* Return reader of the output arguments. */
+errno_t sbus_frame_call_recv(TALLOC_CTX *mem_ctx,
+                             struct tevent_req *req,
+                             struct sbus_frame_reader **_reply);
+
+#endif /* _SBUS_FRAME_H_ */
@@ -0,0 +1,727 @@
+/*
+    SSSD
+
+    sbus binary framing - encoding and decoding of values
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_utf8.h"
+#include "sbus/frame/sbus_frame.h"
+
+#define SBUS_FRAME_INITIAL_SIZE 256
+
+struct sbus_frame_writer {
+    uint8_t *buf;
+    size_t used;
+    size_t size;
+};
+
+struct sbus_frame_writer *
+sbus_frame_writer_create(TALLOC_CTX *mem_ctx)
+{
+    struct sbus_frame_writer *writer;
+
+    writer = talloc_zero(mem_ctx, struct sbus_frame_writer);
+    if (writer == NULL) {
+        return NULL;
+    }
+
+    writer->buf = talloc_zero_size(writer, SBUS_FRAME_INITIAL_SIZE);
+    if (writer->buf == NULL) {
+        talloc_free(writer);
+        return NULL;
+    }
+
+    writer->size = SBUS_FRAME_INITIAL_SIZE;
+    writer->used = sizeof(struct sbus_frame_header);
+
+    return writer;
+}
+
+errno_t sbus_frame_writer_finish(struct sbus_frame_writer *writer,
+                                 enum sbus_frame_type type,
+                                 uint32_t serial,
+                                 uint8_t **_frame,
+                                 size_t *_frame_len)
+{
+    struct sbus_frame_header header;
+
+    header.magic = SBUS_FRAME_MAGIC;
+    header.version = SBUS_FRAME_VERSION;
+    header.type = type;
+    header.serial = serial;
+    header.length = writer->used - sizeof(struct sbus_frame_header);
+
+    memcpy(writer->buf, &header, sizeof(struct sbus_frame_header));
+
+    *_frame = writer->buf;
+    *_frame_len = writer->used;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_writer_reserve(struct sbus_frame_writer *writer,
+                                         size_t len,
+                                         uint8_t **_ptr)
+{
+    uint8_t *buf;
+    size_t size;
+
+    if (len > SBUS_FRAME_MAX_SIZE - writer->used) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Frame exceeds the maximum size\n");
+        return EMSGSIZE;
+    }
+
+    if (writer->used + len > writer->size) {
+        size = writer->size;
+        while (writer->used + len > size) {
+            size *= 2;
+        }
+
+        buf = talloc_realloc(writer, writer->buf, uint8_t, size);
+        if (buf == NULL) {
+            return ENOMEM;
+        }
+
+        writer->buf = buf;
+        writer->size = size;
+    }
+
+    *_ptr = writer->buf + writer->used;
+    writer->used += len;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_write_raw(struct sbus_frame_writer *writer,
+                                    const void *data,
+                                    size_t len)
+{
+    uint8_t *ptr;
+    errno_t ret;
+
+    ret = sbus_frame_writer_reserve(writer, len, &ptr);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (len > 0) {
+        memcpy(ptr, data, len);
+    }
+
+    return EOK;
+}
+
+static errno_t sbus_frame_write_string(struct sbus_frame_writer *writer,
+                                       const char *value,
+                                       const char *default_value)
+{
+    uint32_t len;
+    errno_t ret;
+
+    /* Keep the same semantics as D-Bus transport. */
+    value = value == NULL ? default_value : value;
+    if (value == NULL) {
+        return ERR_SBUS_EMPTY_STRING;
+    }
+
+    len = strlen(value);
+    if (!sss_utf8_check((const uint8_t *)value, len)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "String with non-utf8 characters was "
+              "given [%s]\n", value);
+        return ERR_SBUS_INVALID_STRING;
+    }
+
+    ret = sbus_frame_write_raw(writer, &len, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sbus_frame_write_raw(writer, value, len + 1);
+}
+
+static errno_t sbus_frame_write_fixed_array(struct sbus_frame_writer *writer,
+                                            void *value,
+                                            size_t element_size)
+{
+    uint32_t count;
+    errno_t ret;
+
+    count = value == NULL ? 0 : talloc_get_size(value) / element_size;
+
+    ret = sbus_frame_write_raw(writer, &count, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sbus_frame_write_raw(writer, value, count * element_size);
+}
+
+static errno_t sbus_frame_write_string_array(struct sbus_frame_writer *writer,
+                                             const char **value)
+{
+    uint32_t count;
+    uint32_t i;
+    errno_t ret;
+
+    for (count = 0; value != NULL && value[count] != NULL; count++);
+
+    ret = sbus_frame_write_raw(writer, &count, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = sbus_frame_write_string(writer, value[i], NULL);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+#define sbus_frame_write_fixed(writer, value) \
+    sbus_frame_write_raw((writer), &(value), sizeof(value))
+
+errno_t sbus_frame_write_y(struct sbus_frame_writer *writer, uint8_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_b(struct sbus_frame_writer *writer, bool value)
+{
+    uint8_t byte = value ? 1 : 0;
+
+    return sbus_frame_write_fixed(writer, byte);
+}
+
+errno_t sbus_frame_write_n(struct sbus_frame_writer *writer, int16_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_q(struct sbus_frame_writer *writer, uint16_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_i(struct sbus_frame_writer *writer, int32_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_u(struct sbus_frame_writer *writer, uint32_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_x(struct sbus_frame_writer *writer, int64_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_t(struct sbus_frame_writer *writer, uint64_t value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_d(struct sbus_frame_writer *writer, double value)
+{
+    return sbus_frame_write_fixed(writer, value);
+}
+
+errno_t sbus_frame_write_s(struct sbus_frame_writer *writer,
+                           const char *value)
+{
+    return sbus_frame_write_string(writer, value, "");
+}
+
+errno_t sbus_frame_write_S(struct sbus_frame_writer *writer, char *value)
+{
+    return sbus_frame_write_string(writer, value, "");
+}
+
+errno_t sbus_frame_write_o(struct sbus_frame_writer *writer,
+                           const char *value)
+{
+    return sbus_frame_write_string(writer, value, "/");
+}
+
+errno_t sbus_frame_write_O(struct sbus_frame_writer *writer, char *value)
+{
+    return sbus_frame_write_string(writer, value, "/");
+}
+
+errno_t sbus_frame_write_ay(struct sbus_frame_writer *writer, uint8_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(uint8_t));
+}
+
+errno_t sbus_frame_write_ab(struct sbus_frame_writer *writer, bool *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(bool));
+}
+
+errno_t sbus_frame_write_an(struct sbus_frame_writer *writer, int16_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(int16_t));
+}
+
+errno_t sbus_frame_write_aq(struct sbus_frame_writer *writer,
+                            uint16_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(uint16_t));
+}
+
+errno_t sbus_frame_write_ai(struct sbus_frame_writer *writer, int32_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(int32_t));
+}
+
+errno_t sbus_frame_write_au(struct sbus_frame_writer *writer,
+                            uint32_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(uint32_t));
+}
+
+errno_t sbus_frame_write_ax(struct sbus_frame_writer *writer, int64_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(int64_t));
+}
+
+errno_t sbus_frame_write_at(struct sbus_frame_writer *writer,
+                            uint64_t *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(uint64_t));
+}
+
+errno_t sbus_frame_write_ad(struct sbus_frame_writer *writer, double *value)
+{
+    return sbus_frame_write_fixed_array(writer, value, sizeof(double));
+}
+
+errno_t sbus_frame_write_as(struct sbus_frame_writer *writer,
+                            const char **value)
+{
+    return sbus_frame_write_string_array(writer, value);
+}
+
+errno_t sbus_frame_write_aS(struct sbus_frame_writer *writer, char **value)
+{
+    return sbus_frame_write_string_array(writer, (const char **)value);
+}
+
+errno_t sbus_frame_write_ao(struct sbus_frame_writer *writer,
+                            const char **value)
+{
+    return sbus_frame_write_string_array(writer, value);
+}
+
+errno_t sbus_frame_write_aO(struct sbus_frame_writer *writer, char **value)
+{
+    return sbus_frame_write_string_array(writer, (const char **)value);
+}
+
+void sbus_frame_reader_init(struct sbus_frame_reader *reader,
+                            const uint8_t *data,
+                            size_t length)
+{
+    reader->data = data;
+    reader->length = length;
+    reader->pos = 0;
+}
+
+bool sbus_frame_reader_done(struct sbus_frame_reader *reader)
+{
+    return reader->pos == reader->length;
+}
+
+static errno_t sbus_frame_read_raw(struct sbus_frame_reader *reader,
+                                   size_t len,
+                                   const uint8_t **_ptr)
+{
+    if (len > reader->length - reader->pos) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Frame is truncated\n");
+        return ERR_SBUS_INVALID_TYPE;
+    }
+
+    *_ptr = reader->data + reader->pos;
+    reader->pos += len;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_fixed(struct sbus_frame_reader *reader,
+                                     void *_value,
+                                     size_t size)
+{
+    const uint8_t *ptr;
+    errno_t ret;
+
+    ret = sbus_frame_read_raw(reader, size, &ptr);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    memcpy(_value, ptr, size);
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_string(struct sbus_frame_reader *reader,
+                                      const char **_value)
+{
+    const uint8_t *ptr;
+    uint32_t len;
+    errno_t ret;
+
+    ret = sbus_frame_read_fixed(reader, &len, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (len == UINT32_MAX) {
+        return ERR_SBUS_INVALID_TYPE;
+    }
+
+    ret = sbus_frame_read_raw(reader, len + 1, &ptr);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (ptr[len] != '\0' || memchr(ptr, '\0', len) != NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid string in frame\n");
+        return ERR_SBUS_INVALID_STRING;
+    }
+
+    *_value = (const char *)ptr;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_string_copy(TALLOC_CTX *mem_ctx,
+                                           struct sbus_frame_reader *reader,
+                                           char **_value)
+{
+    const char *value;
+    char *copy;
+    errno_t ret;
+
+    ret = sbus_frame_read_string(reader, &value);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    copy = talloc_strdup(mem_ctx, value);
+    if (copy == NULL) {
+        return ENOMEM;
+    }
+
+    *_value = copy;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_count(struct sbus_frame_reader *reader,
+                                     size_t min_element_size,
+                                     uint32_t *_count)
+{
+    uint32_t count;
+    errno_t ret;
+
+    ret = sbus_frame_read_fixed(reader, &count, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* Do not allocate more than the frame can actually contain. */
+    if (count > (reader->length - reader->pos) / min_element_size) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Frame is truncated\n");
+        return ERR_SBUS_INVALID_TYPE;
+    }
+
+    *_count = count;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_fixed_array(TALLOC_CTX *mem_ctx,
+                                           struct sbus_frame_reader *reader,
+                                           size_t element_size,
+                                           void **_value)
+{
+    const uint8_t *ptr;
+    uint32_t count;
+    void *array;
+    errno_t ret;
+
+    ret = sbus_frame_read_count(reader, element_size, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* Keep the same semantics as D-Bus transport. */
+    if (count == 0) {
+        *_value = NULL;
+        return EOK;
+    }
+
+    ret = sbus_frame_read_raw(reader, count * element_size, &ptr);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    array = talloc_memdup(mem_ctx, ptr, count * element_size);
+    if (array == NULL) {
+        return ENOMEM;
+    }
+
+    *_value = array;
+
+    return EOK;
+}
+
+static errno_t sbus_frame_read_string_array(TALLOC_CTX *mem_ctx,
+                                            struct sbus_frame_reader *reader,
+                                            bool copy,
+                                            char ***_value)
+{
+    uint32_t count;
+    uint32_t i;
+    char **array;
+    errno_t ret;
+
+    /* Each string takes at least its length and the terminating zero. */
+    ret = sbus_frame_read_count(reader, sizeof(uint32_t) + 1, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (count == 0) {
+        *_value = NULL;
+        return EOK;
+    }
+
+    array = talloc_zero_array(mem_ctx, char *, count + 1);
+    if (array == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (copy) {
+            ret = sbus_frame_read_string_copy(array, reader, &array[i]);
+        } else {
+            ret = sbus_frame_read_string(reader,
+                                         discard_const_p(const char *,
+                                                         &array[i]));
+        }
+        if (ret != EOK) {
+            talloc_free(array);
+            return ret;
+        }
+    }
+
+    *_value = array;
+
+    return EOK;
+}
+
+errno_t sbus_frame_read_y(struct sbus_frame_reader *reader, uint8_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(uint8_t));
+}
+
+errno_t sbus_frame_read_b(struct sbus_frame_reader *reader, bool *_value)
+{
+    uint8_t byte;
+    errno_t ret;
+
+    ret = sbus_frame_read_fixed(reader, &byte, sizeof(uint8_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *_value = byte != 0;
+
+    return EOK;
+}
+
+errno_t sbus_frame_read_n(struct sbus_frame_reader *reader, int16_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(int16_t));
+}
+
+errno_t sbus_frame_read_q(struct sbus_frame_reader *reader, uint16_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(uint16_t));
+}
+
+errno_t sbus_frame_read_i(struct sbus_frame_reader *reader, int32_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(int32_t));
+}
+
+errno_t sbus_frame_read_u(struct sbus_frame_reader *reader, uint32_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(uint32_t));
+}
+
+errno_t sbus_frame_read_x(struct sbus_frame_reader *reader, int64_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(int64_t));
+}
+
+errno_t sbus_frame_read_t(struct sbus_frame_reader *reader, uint64_t *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(uint64_t));
+}
+
+errno_t sbus_frame_read_d(struct sbus_frame_reader *reader, double *_value)
+{
+    return sbus_frame_read_fixed(reader, _value, sizeof(double));
+}
+
+errno_t sbus_frame_read_s(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          const char **_value)
+{
+    return sbus_frame_read_string(reader, _value);
+}
+
+errno_t sbus_frame_read_S(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          char **_value)
+{
+    return sbus_frame_read_string_copy(mem_ctx, reader, _value);
+}
+
+errno_t sbus_frame_read_o(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          const char **_value)
+{
+    return sbus_frame_read_string(reader, _value);
+}
+
+errno_t sbus_frame_read_O(TALLOC_CTX *mem_ctx,
+                          struct sbus_frame_reader *reader,
+                          char **_value)
+{
+    return sbus_frame_read_string_copy(mem_ctx, reader, _value);
+}
+
+#define sbus_frame_read_array(mem_ctx, reader, c_type, dest) \
+    sbus_frame_read_fixed_array((mem_ctx), (reader), sizeof(c_type), \
+                                (void **)(dest))
+
+errno_t sbus_frame_read_ay(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint8_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, uint8_t, _value);
+}
+
+errno_t sbus_frame_read_ab(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           bool **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, bool, _value);
+}
+
+errno_t sbus_frame_read_an(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int16_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, int16_t, _value);
+}
+
+errno_t sbus_frame_read_aq(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint16_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, uint16_t, _value);
+}
+
+errno_t sbus_frame_read_ai(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int32_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, int32_t, _value);
+}
+
+errno_t sbus_frame_read_au(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint32_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, uint32_t, _value);
+}
+
+errno_t sbus_frame_read_ax(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           int64_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, int64_t, _value);
+}
+
+errno_t sbus_frame_read_at(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           uint64_t **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, uint64_t, _value);
+}
+
+errno_t sbus_frame_read_ad(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           double **_value)
+{
+    return sbus_frame_read_array(mem_ctx, reader, double, _value);
+}
+
+errno_t sbus_frame_read_as(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           const char ***_value)
+{
+    return sbus_frame_read_string_array(mem_ctx, reader, false,
+                                        discard_const_p(char **, _value));
+}
+
+errno_t sbus_frame_read_aS(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           char ***_value)
+{
+    return sbus_frame_read_string_array(mem_ctx, reader, true, _value);
+}
+
+errno_t sbus_frame_read_ao(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           const char ***_value)
+{
+    return sbus_frame_read_string_array(mem_ctx, reader, false,
+                                        discard_const_p(char **, _value));
+}
+
+errno_t sbus_frame_read_aO(TALLOC_CTX *mem_ctx,
+                           struct sbus_frame_reader *reader,
+                           char ***_value)
+{
+    return sbus_frame_read_string_array(mem_ctx, reader, true, _value);
+}
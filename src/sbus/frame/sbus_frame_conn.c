@@ -0,0 +1,1063 @@
+/*
+    SSSD
+
+    sbus binary framing - connections
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "sbus/frame/sbus_frame.h"
+
+#define SBUS_FRAME_SOCKET_SUFFIX ".frame"
+#define SBUS_FRAME_HELLO_TIMEOUT 5
+
+struct sbus_frame_out {
+    uint8_t *data;
+    size_t len;
+    size_t written;
+
+    struct sbus_frame_out *prev;
+    struct sbus_frame_out *next;
+};
+
+struct sbus_frame_call_state;
+
+struct sbus_frame_conn {
+    struct tevent_context *ev;
+    struct sbus_frame_server *server; /* NULL for client connections */
+    struct tevent_fd *fde;
+    int fd;
+
+    bool negotiated;
+    uint32_t serial;
+
+    /* Frame that is being received. */
+    struct sbus_frame_header header;
+    size_t header_read;
+    uint8_t *payload;
+    size_t payload_read;
+
+    struct sbus_frame_out *out;
+    struct sbus_frame_call_state *calls;
+    struct tevent_req *hello_req;
+};
+
+struct sbus_frame_server {
+    struct tevent_context *ev;
+    const struct sbus_frame_method *methods;
+    const char *socket_path;
+    struct tevent_fd *fde;
+    uid_t uid;
+    int fd;
+};
+
+struct sbus_frame_call_state {
+    struct tevent_req *req;
+    struct sbus_frame_conn *conn;
+    uint32_t serial;
+
+    uint8_t *payload;
+    size_t payload_len;
+
+    struct sbus_frame_call_state *prev;
+    struct sbus_frame_call_state *next;
+};
+
+struct sbus_frame_dispatch {
+    struct sbus_frame_conn *conn;
+    const struct sbus_frame_method *method;
+    uint32_t serial;
+
+    /* Input strings point into the payload. */
+    uint8_t *payload;
+    struct sbus_frame_reader reader;
+};
+
+static void sbus_frame_conn_handler(struct tevent_context *ev,
+                                    struct tevent_fd *fde,
+                                    uint16_t flags,
+                                    void *pvt);
+
+char *sbus_frame_socket_path(TALLOC_CTX *mem_ctx, const char *dbus_address)
+{
+    const char *filename;
+    size_t len;
+
+    filename = strchr(dbus_address, '/');
+    if (filename == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unexpected dbus address [%s].\n",
+              dbus_address);
+        return NULL;
+    }
+
+    len = strcspn(filename, ",");
+
+    return talloc_asprintf(mem_ctx, "%.*s%s", (int)len, filename,
+                           SBUS_FRAME_SOCKET_SUFFIX);
+}
+
+static void sbus_frame_call_finish(struct sbus_frame_call_state *state,
+                                   errno_t ret)
+{
+    if (state->conn != NULL) {
+        DLIST_REMOVE(state->conn->calls, state);
+        tevent_req_defer_callback(state->req, state->conn->ev);
+        state->conn = NULL;
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(state->req, ret);
+        return;
+    }
+
+    tevent_req_done(state->req);
+}
+
+static void sbus_frame_conn_fail_calls(struct sbus_frame_conn *conn,
+                                       errno_t error)
+{
+    struct sbus_frame_call_state *state;
+    struct tevent_req *hello_req;
+
+    while ((state = conn->calls) != NULL) {
+        sbus_frame_call_finish(state, error);
+    }
+
+    if (conn->hello_req != NULL) {
+        hello_req = conn->hello_req;
+        conn->hello_req = NULL;
+        tevent_req_defer_callback(hello_req, conn->ev);
+        tevent_req_error(hello_req, error);
+    }
+}
+
+static int sbus_frame_conn_destructor(struct sbus_frame_conn *conn)
+{
+    sbus_frame_conn_fail_calls(conn, ENOTCONN);
+
+    talloc_zfree(conn->fde);
+    if (conn->fd != -1) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+
+    return 0;
+}
+
+/* Stop using the connection. Server connections are freed, client
+ * connections are kept around so the owner can notice that they are
+ * broken. */
+static void sbus_frame_conn_terminate(struct sbus_frame_conn *conn,
+                                      errno_t error)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Frame connection terminated [%d]: %s\n",
+          error, sss_strerror(error));
+
+    if (conn->server != NULL) {
+        talloc_free(conn);
+        return;
+    }
+
+    sbus_frame_conn_fail_calls(conn, error);
+
+    talloc_zfree(conn->fde);
+    if (conn->fd != -1) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+
+    conn->negotiated = false;
+}
+
+static struct sbus_frame_conn *
+sbus_frame_conn_create(TALLOC_CTX *mem_ctx,
+                       struct tevent_context *ev,
+                       struct sbus_frame_server *server,
+                       int fd)
+{
+    struct sbus_frame_conn *conn;
+
+    conn = talloc_zero(mem_ctx, struct sbus_frame_conn);
+    if (conn == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    conn->ev = ev;
+    conn->server = server;
+    conn->fd = fd;
+    talloc_set_destructor(conn, sbus_frame_conn_destructor);
+
+    conn->fde = tevent_add_fd(ev, conn, fd, TEVENT_FD_READ,
+                              sbus_frame_conn_handler, conn);
+    if (conn->fde == NULL) {
+        talloc_free(conn);
+        return NULL;
+    }
+
+    return conn;
+}
+
+static errno_t sbus_frame_conn_queue(struct sbus_frame_conn *conn,
+                                     struct sbus_frame_writer *writer,
+                                     enum sbus_frame_type type,
+                                     uint32_t serial)
+{
+    struct sbus_frame_out *out;
+    errno_t ret;
+
+    if (conn->fde == NULL) {
+        return ENOTCONN;
+    }
+
+    out = talloc_zero(conn, struct sbus_frame_out);
+    if (out == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sbus_frame_writer_finish(writer, type, serial,
+                                   &out->data, &out->len);
+    if (ret != EOK) {
+        talloc_free(out);
+        return ret;
+    }
+
+    talloc_steal(out, writer);
+    DLIST_ADD_END(conn->out, out, struct sbus_frame_out *);
+    TEVENT_FD_WRITEABLE(conn->fde);
+
+    return EOK;
+}
+
+static errno_t sbus_frame_conn_queue_error(struct sbus_frame_conn *conn,
+                                           uint32_t serial,
+                                           errno_t error)
+{
+    struct sbus_frame_writer *writer;
+    errno_t ret;
+
+    writer = sbus_frame_writer_create(conn);
+    if (writer == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sbus_frame_write_u(writer, error);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_frame_write_s(writer, sss_strerror(error));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_frame_conn_queue(conn, writer, SBUS_FRAME_ERROR, serial);
+
+done:
+    if (ret != EOK) {
+        talloc_free(writer);
+    }
+
+    return ret;
+}
+
+static errno_t sbus_frame_conn_write(struct sbus_frame_conn *conn)
+{
+    struct sbus_frame_out *out;
+    ssize_t len;
+
+    while ((out = conn->out) != NULL) {
+        /* A closed peer is reported as EPIPE, not by a signal. */
+        len = send(conn->fd, out->data + out->written,
+                   out->len - out->written, MSG_NOSIGNAL);
+        if (len == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return EOK;
+            }
+
+            return errno;
+        }
+
+        out->written += len;
+        if (out->written < out->len) {
+            continue;
+        }
+
+        DLIST_REMOVE(conn->out, out);
+        talloc_free(out);
+    }
+
+    TEVENT_FD_NOT_WRITEABLE(conn->fde);
+
+    return EOK;
+}
+
+static void sbus_frame_dispatch_done(struct tevent_req *subreq);
+
+static errno_t sbus_frame_dispatch(struct sbus_frame_conn *conn,
+                                   uint32_t serial,
+                                   uint8_t *payload,
+                                   size_t payload_len)
+{
+    const struct sbus_frame_method *method;
+    struct sbus_frame_dispatch *dispatch;
+    struct tevent_req *subreq;
+    const char *iface;
+    const char *name;
+    errno_t ret;
+
+    dispatch = talloc_zero(conn, struct sbus_frame_dispatch);
+    if (dispatch == NULL) {
+        return ENOMEM;
+    }
+
+    dispatch->conn = conn;
+    dispatch->serial = serial;
+    dispatch->payload = talloc_steal(dispatch, payload);
+    sbus_frame_reader_init(&dispatch->reader, payload, payload_len);
+
+    ret = sbus_frame_read_s(dispatch, &dispatch->reader, &iface);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_frame_read_s(dispatch, &dispatch->reader, &name);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (method = conn->server->methods; method->iface != NULL; method++) {
+        if (strcmp(method->iface, iface) == 0
+                && strcmp(method->method, name) == 0) {
+            break;
+        }
+    }
+
+    if (method->iface == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unknown method %s.%s\n", iface, name);
+        ret = ERR_SBUS_UNKNOWN_INTERFACE;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Received frame call %s.%s\n", iface, name);
+
+    dispatch->method = method;
+    subreq = method->send_fn(dispatch, conn->ev, &dispatch->reader,
+                             method->data);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_frame_dispatch_done, dispatch);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(dispatch);
+        return sbus_frame_conn_queue_error(conn, serial, ret);
+    }
+
+    return EOK;
+}
+
+static void sbus_frame_dispatch_done(struct tevent_req *subreq)
+{
+    struct sbus_frame_dispatch *dispatch;
+    struct sbus_frame_writer *writer;
+    struct sbus_frame_conn *conn;
+    uint32_t serial;
+    errno_t ret;
+
+    dispatch = tevent_req_callback_data(subreq, struct sbus_frame_dispatch);
+    conn = dispatch->conn;
+    serial = dispatch->serial;
+
+    writer = sbus_frame_writer_create(dispatch);
+    if (writer == NULL) {
+        ret = ENOMEM;
+    } else {
+        ret = dispatch->method->recv_fn(writer, subreq, writer);
+    }
+    talloc_zfree(subreq);
+
+    if (ret == EOK) {
+        ret = sbus_frame_conn_queue(conn, writer, SBUS_FRAME_REPLY, serial);
+    }
+
+    talloc_free(dispatch);
+
+    if (ret != EOK) {
+        ret = sbus_frame_conn_queue_error(conn, serial, ret);
+        if (ret != EOK) {
+            sbus_frame_conn_terminate(conn, ret);
+        }
+    }
+}
+
+static errno_t sbus_frame_conn_reply(struct sbus_frame_conn *conn,
+                                     enum sbus_frame_type type,
+                                     uint32_t serial,
+                                     uint8_t *payload,
+                                     size_t payload_len)
+{
+    struct sbus_frame_call_state *state;
+    struct sbus_frame_reader reader;
+    uint32_t error;
+    errno_t ret;
+
+    DLIST_FOR_EACH(state, conn->calls) {
+        if (state->serial == serial) {
+            break;
+        }
+    }
+
+    if (state == NULL) {
+        /* The caller is not interested anymore. */
+        talloc_free(payload);
+        return EOK;
+    }
+
+    if (type == SBUS_FRAME_ERROR) {
+        sbus_frame_reader_init(&reader, payload, payload_len);
+        ret = sbus_frame_read_u(&reader, &error);
+        talloc_free(payload);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        sbus_frame_call_finish(state, error == EOK ? EIO : error);
+        return EOK;
+    }
+
+    state->payload = talloc_steal(state, payload);
+    state->payload_len = payload_len;
+    sbus_frame_call_finish(state, EOK);
+
+    return EOK;
+}
+
+static errno_t sbus_frame_conn_process(struct sbus_frame_conn *conn,
+                                       struct sbus_frame_header *header,
+                                       uint8_t *payload)
+{
+    struct sbus_frame_writer *writer;
+    struct tevent_req *hello_req;
+    errno_t ret;
+
+    switch (header->type) {
+    case SBUS_FRAME_HELLO:
+        if (conn->negotiated) {
+            break;
+        }
+
+        talloc_free(payload);
+        conn->negotiated = true;
+
+        if (conn->server != NULL) {
+            writer = sbus_frame_writer_create(conn);
+            if (writer == NULL) {
+                return ENOMEM;
+            }
+
+            ret = sbus_frame_conn_queue(conn, writer, SBUS_FRAME_HELLO,
+                                        header->serial);
+            if (ret != EOK) {
+                talloc_free(writer);
+            }
+
+            return ret;
+        }
+
+        if (conn->hello_req != NULL) {
+            hello_req = conn->hello_req;
+            conn->hello_req = NULL;
+            tevent_req_defer_callback(hello_req, conn->ev);
+            tevent_req_done(hello_req);
+        }
+
+        return EOK;
+    case SBUS_FRAME_CALL:
+        if (!conn->negotiated || conn->server == NULL) {
+            break;
+        }
+
+        return sbus_frame_dispatch(conn, header->serial, payload,
+                                   header->length);
+    case SBUS_FRAME_REPLY:
+    case SBUS_FRAME_ERROR:
+        if (!conn->negotiated || conn->server != NULL) {
+            break;
+        }
+
+        return sbus_frame_conn_reply(conn, header->type, header->serial,
+                                     payload, header->length);
+    }
+
+    DEBUG(SSSDBG_CRIT_FAILURE, "Unexpected frame type %u\n", header->type);
+    talloc_free(payload);
+
+    return EPROTO;
+}
+
+static errno_t sbus_frame_conn_read(struct sbus_frame_conn *conn)
+{
+    uint8_t *payload;
+    ssize_t len;
+    errno_t ret;
+
+    while (true) {
+        if (conn->header_read < sizeof(struct sbus_frame_header)) {
+            len = read(conn->fd, (uint8_t *)&conn->header + conn->header_read,
+                       sizeof(struct sbus_frame_header) - conn->header_read);
+        } else if (conn->payload_read < conn->header.length) {
+            len = read(conn->fd, conn->payload + conn->payload_read,
+                       conn->header.length - conn->payload_read);
+        } else {
+            len = 0; /* not reached */
+        }
+
+        if (len == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return EOK;
+            }
+
+            return errno;
+        } else if (len == 0) {
+            return EPIPE;
+        }
+
+        if (conn->header_read < sizeof(struct sbus_frame_header)) {
+            conn->header_read += len;
+            if (conn->header_read < sizeof(struct sbus_frame_header)) {
+                continue;
+            }
+
+            if (conn->header.magic != SBUS_FRAME_MAGIC
+                    || conn->header.version != SBUS_FRAME_VERSION) {
+                DEBUG(SSSDBG_OP_FAILURE, "Peer does not speak frame protocol "
+                      "version %d\n", SBUS_FRAME_VERSION);
+                return ERR_SBUS_NOSUP;
+            }
+
+            if (conn->header.length > SBUS_FRAME_MAX_SIZE) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Frame is too large\n");
+                return EMSGSIZE;
+            }
+
+            /* Keep one extra byte so empty payloads have a buffer as well. */
+            conn->payload = talloc_size(conn, conn->header.length + 1);
+            if (conn->payload == NULL) {
+                return ENOMEM;
+            }
+            conn->payload_read = 0;
+        } else {
+            conn->payload_read += len;
+        }
+
+        if (conn->payload_read < conn->header.length) {
+            continue;
+        }
+
+        /* The whole frame was received. */
+        payload = conn->payload;
+        conn->payload = NULL;
+        conn->header_read = 0;
+
+        ret = sbus_frame_conn_process(conn, &conn->header, payload);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+}
+
+static void sbus_frame_conn_handler(struct tevent_context *ev,
+                                    struct tevent_fd *fde,
+                                    uint16_t flags,
+                                    void *pvt)
+{
+    struct sbus_frame_conn *conn;
+    errno_t ret;
+
+    conn = talloc_get_type(pvt, struct sbus_frame_conn);
+
+    if (flags & TEVENT_FD_WRITE) {
+        ret = sbus_frame_conn_write(conn);
+        if (ret != EOK) {
+            sbus_frame_conn_terminate(conn, ret);
+            return;
+        }
+    }
+
+    if (flags & TEVENT_FD_READ) {
+        ret = sbus_frame_conn_read(conn);
+        if (ret != EOK) {
+            sbus_frame_conn_terminate(conn, ret);
+            return;
+        }
+    }
+}
+
+static int sbus_frame_server_destructor(struct sbus_frame_server *server)
+{
+    talloc_zfree(server->fde);
+    if (server->fd != -1) {
+        close(server->fd);
+        server->fd = -1;
+    }
+
+    unlink(server->socket_path);
+
+    return 0;
+}
+
+static void sbus_frame_server_accept(struct tevent_context *ev,
+                                     struct tevent_fd *fde,
+                                     uint16_t flags,
+                                     void *pvt)
+{
+    struct sbus_frame_server *server;
+    struct sbus_frame_conn *conn;
+    struct ucred cred;
+    socklen_t len;
+    errno_t ret;
+    int fd;
+
+    server = talloc_get_type(pvt, struct sbus_frame_server);
+
+    fd = accept4(server->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to accept connection [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    len = sizeof(cred);
+    ret = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len);
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to get peer credentials [%d]: %s\n",
+              ret, sss_strerror(ret));
+        close(fd);
+        return;
+    }
+
+    /* Same rule as for D-Bus connections. */
+    if (cred.uid != 0 && cred.uid != server->uid) {
+        DEBUG(SSSDBG_OP_FAILURE, "Rejecting frame connection from uid %u\n",
+              (unsigned int)cred.uid);
+        close(fd);
+        return;
+    }
+
+    conn = sbus_frame_conn_create(server, ev, server, fd);
+    if (conn == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to create frame connection\n");
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "New frame connection from pid %u\n",
+          (unsigned int)cred.pid);
+}
+
+errno_t sbus_frame_server_create(TALLOC_CTX *mem_ctx,
+                                 struct tevent_context *ev,
+                                 const char *socket_path,
+                                 uid_t uid,
+                                 gid_t gid,
+                                 const struct sbus_frame_method *methods,
+                                 struct sbus_frame_server **_server)
+{
+    struct sbus_frame_server *server;
+    struct sockaddr_un addr;
+    errno_t ret;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Socket path is too long [%s]\n",
+              socket_path);
+        return EINVAL;
+    }
+
+    server = talloc_zero(mem_ctx, struct sbus_frame_server);
+    if (server == NULL) {
+        return ENOMEM;
+    }
+
+    server->ev = ev;
+    server->methods = methods;
+    server->uid = uid;
+    server->fd = -1;
+    server->socket_path = talloc_strdup(server, socket_path);
+    if (server->socket_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    server->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        0);
+    if (server->fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    talloc_set_destructor(server, sbus_frame_server_destructor);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    /* Remove socket left behind by previous instance. */
+    unlink(socket_path);
+
+    ret = bind(server->fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to bind [%s] [%d]: %s\n",
+              socket_path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = chmod(socket_path, S_IRUSR | S_IWUSR);
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "chmod failed for [%s] [%d]: %s\n",
+              socket_path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (getuid() == 0 && (uid != 0 || gid != 0)) {
+        ret = chown(socket_path, uid, gid);
+        if (ret != 0) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE, "chown failed for [%s] [%d]: %s\n",
+                  socket_path, ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    ret = listen(server->fd, 10);
+    if (ret != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    server->fde = tevent_add_fd(ev, server, server->fd, TEVENT_FD_READ,
+                                sbus_frame_server_accept, server);
+    if (server->fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Frame server is listening on [%s]\n",
+          socket_path);
+
+    *_server = server;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create frame server "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        talloc_free(server);
+    }
+
+    return ret;
+}
+
+struct sbus_frame_connect_state {
+    struct sbus_frame_conn *conn;
+};
+
+static int sbus_frame_connect_destructor(struct sbus_frame_connect_state *state)
+{
+    /* The connection is freed together with the request if the handshake
+     * did not finish, do not try to finish the request from there. */
+    if (state->conn != NULL) {
+        state->conn->hello_req = NULL;
+    }
+
+    return 0;
+}
+
+static void sbus_frame_connect_timeout(struct tevent_context *ev,
+                                       struct tevent_timer *te,
+                                       struct timeval tv,
+                                       void *pvt);
+
+struct tevent_req *
+sbus_frame_connect_send(TALLOC_CTX *mem_ctx,
+                        struct tevent_context *ev,
+                        const char *socket_path)
+{
+    struct sbus_frame_connect_state *state;
+    struct sbus_frame_writer *writer;
+    struct sockaddr_un addr;
+    struct tevent_timer *te;
+    struct tevent_req *req;
+    struct timeval tv;
+    errno_t ret;
+    int fd;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_frame_connect_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    /* Connecting to a local socket does not block. */
+    ret = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_TRACE_FUNC, "Frame server is not available at [%s] "
+              "[%d]: %s\n", socket_path, ret, sss_strerror(ret));
+        close(fd);
+        if (ret == ENOENT || ret == ECONNREFUSED) {
+            /* The peer does not have the frame transport enabled. */
+            ret = ERR_SBUS_NOSUP;
+        }
+        goto done;
+    }
+
+    ret = sss_fd_nonblocking(fd);
+    if (ret != EOK) {
+        close(fd);
+        goto done;
+    }
+
+    state->conn = sbus_frame_conn_create(state, ev, NULL, fd);
+    if (state->conn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    talloc_set_destructor(state, sbus_frame_connect_destructor);
+
+    writer = sbus_frame_writer_create(state);
+    if (writer == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sbus_frame_conn_queue(state->conn, writer, SBUS_FRAME_HELLO, 0);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    tv = tevent_timeval_current_ofs(SBUS_FRAME_HELLO_TIMEOUT, 0);
+    te = tevent_add_timer(ev, state, tv, sbus_frame_connect_timeout, req);
+    if (te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->conn->hello_req = req;
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void sbus_frame_connect_timeout(struct tevent_context *ev,
+                                       struct tevent_timer *te,
+                                       struct timeval tv,
+                                       void *pvt)
+{
+    struct sbus_frame_connect_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_frame_connect_state);
+
+    if (!tevent_req_is_in_progress(req)) {
+        /* The handshake has already finished. */
+        return;
+    }
+
+    DEBUG(SSSDBG_OP_FAILURE, "Frame server did not answer in time\n");
+
+    state->conn->hello_req = NULL;
+    tevent_req_error(req, ETIMEDOUT);
+}
+
+errno_t sbus_frame_connect_recv(TALLOC_CTX *mem_ctx,
+                                struct tevent_req *req,
+                                struct sbus_frame_conn **_conn)
+{
+    struct sbus_frame_connect_state *state;
+    state = tevent_req_data(req, struct sbus_frame_connect_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_conn = talloc_steal(mem_ctx, state->conn);
+    state->conn = NULL;
+
+    return EOK;
+}
+
+struct sbus_frame_writer *
+sbus_frame_call_writer(TALLOC_CTX *mem_ctx,
+                       const char *iface,
+                       const char *method)
+{
+    struct sbus_frame_writer *writer;
+    errno_t ret;
+
+    writer = sbus_frame_writer_create(mem_ctx);
+    if (writer == NULL) {
+        return NULL;
+    }
+
+    ret = sbus_frame_write_s(writer, iface);
+    if (ret != EOK) {
+        talloc_free(writer);
+        return NULL;
+    }
+
+    ret = sbus_frame_write_s(writer, method);
+    if (ret != EOK) {
+        talloc_free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+static int sbus_frame_call_destructor(struct sbus_frame_call_state *state)
+{
+    if (state->conn != NULL) {
+        DLIST_REMOVE(state->conn->calls, state);
+        state->conn = NULL;
+    }
+
+    return 0;
+}
+
+struct tevent_req *
+sbus_frame_call_send(TALLOC_CTX *mem_ctx,
+                     struct sbus_frame_conn *conn,
+                     struct sbus_frame_writer *call)
+{
+    struct sbus_frame_call_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_frame_call_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->req = req;
+
+    if (!conn->negotiated) {
+        ret = ENOTCONN;
+        goto done;
+    }
+
+    /* Zero is used by the handshake. */
+    conn->serial++;
+    if (conn->serial == 0) {
+        conn->serial++;
+    }
+    state->serial = conn->serial;
+
+    ret = sbus_frame_conn_queue(conn, call, SBUS_FRAME_CALL, state->serial);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    state->conn = conn;
+    DLIST_ADD(conn->calls, state);
+    talloc_set_destructor(state, sbus_frame_call_destructor);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        talloc_free(call);
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+errno_t sbus_frame_call_recv(TALLOC_CTX *mem_ctx,
+                             struct tevent_req *req,
+                             struct sbus_frame_reader **_reply)
+{
+    struct sbus_frame_call_state *state;
+    struct sbus_frame_reader *reply;
+    state = tevent_req_data(req, struct sbus_frame_call_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    reply = talloc_zero(mem_ctx, struct sbus_frame_reader);
+    if (reply == NULL) {
+        return ENOMEM;
+    }
+
+    /* Output strings point into the payload, keep them together. */
+    talloc_steal(reply, state->payload);
+    sbus_frame_reader_init(reply, state->payload, state->payload_len);
+
+    *_reply = reply;
+
+    return EOK;
+}
@@ -25,6 +25,7 @@
 
 #include "sbus/interface/sbus_iterator_readers.h"
 #include "sbus/interface/sbus_iterator_writers.h"
+#include "sbus/frame/sbus_frame.h"
 #include "sbus/interface_dbus/sbus_dbus_arguments.h"
 
 errno_t _sbus_dbus_invoker_read_as
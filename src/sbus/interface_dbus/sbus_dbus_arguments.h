@@ -26,6 +26,7 @@
 #include <stdbool.h>
 #include <dbus/dbus.h>
 
+#include "sbus/frame/sbus_frame.h"
 
 struct _sbus_dbus_invoker_args_as {
     const char ** arg0;
@@ -36,6 +36,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <strings.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <time.h>
@@ -64,8 +65,17 @@
 
 /* common functions */
 
+#ifdef HAVE_PTHREAD_EXT
+/* In lock-free mode every thread talks to the responder over its own
+ * connection, so independent requests are not serialized. */
+static pthread_key_t sss_sd_key;
+static pthread_once_t sss_sd_key_initialized = PTHREAD_ONCE_INIT;
+static __thread int sss_cli_sd = -1; /* the sss client socket descriptor */
+static __thread struct stat sss_cli_sb; /* the sss client stat buffer */
+#else
 static int sss_cli_sd = -1; /* the sss client socket descriptor */
 static struct stat sss_cli_sb; /* the sss client stat buffer */
+#endif
 
 #if HAVE_FUNCTION_ATTRIBUTE_DESTRUCTOR
 __attribute__((destructor))
@@ -78,6 +88,18 @@ static void sss_cli_close_socket(void)
     }
 }
 
+#ifdef HAVE_PTHREAD_EXT
+static void sss_at_thread_exit(void *v)
+{
+    sss_cli_close_socket();
+}
+
+static void init_sd_key(void)
+{
+    pthread_key_create(&sss_sd_key, sss_at_thread_exit);
+}
+#endif
+
 /* Requests:
  *
  * byte 0-3: 32bit unsigned with length (the complete packet length: 0 to X)
@@ -708,6 +730,14 @@ static enum sss_status sss_cli_check_socket(int *errnop,
 
     sss_cli_sd = mysd;
 
+#ifdef HAVE_PTHREAD_EXT
+    pthread_once(&sss_sd_key_initialized, init_sd_key); /* once for all threads */
+
+    /* The value does not matter, it only has to be non-NULL so that the
+     * destructor closing the per-thread socket runs at thread exit. */
+    pthread_setspecific(sss_sd_key, &sss_cli_sd);
+#endif
+
     if (sss_cli_check_version(socket_name, timeout)) {
         return SSS_STATUS_SUCCESS;
     }
@@ -1145,6 +1175,31 @@ static struct sss_mutex sss_nss_mc_mtx = { .mtx  = PTHREAD_MUTEX_INITIALIZER };
 
 static struct sss_mutex sss_pac_mtx = { .mtx  = PTHREAD_MUTEX_INITIALIZER };
 
+#ifdef HAVE_PTHREAD_EXT
+static bool sss_lock_free = true;
+static pthread_once_t sss_lock_mode_initialized = PTHREAD_ONCE_INIT;
+
+static void init_lock_mode(void)
+{
+    const char *env = getenv("SSS_LOCKFREE");
+
+    if ((env != NULL) && (strcasecmp(env, "NO") == 0)) {
+        sss_lock_free = false;
+    }
+}
+
+bool sss_is_lockfree_mode(void)
+{
+    pthread_once(&sss_lock_mode_initialized, init_lock_mode);
+    return sss_lock_free;
+}
+#else
+bool sss_is_lockfree_mode(void)
+{
+    return false;
+}
+#endif
+
 static void sss_mt_lock(struct sss_mutex *m)
 {
     pthread_mutex_lock(&m->mtx);
@@ -1160,20 +1215,36 @@ static void sss_mt_unlock(struct sss_mutex *m)
 /* NSS mutex wrappers */
 void sss_nss_lock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_lock(&sss_nss_mtx);
 }
 void sss_nss_unlock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_unlock(&sss_nss_mtx);
 }
 
 /* NSS mutex wrappers */
 void sss_pam_lock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_lock(&sss_pam_mtx);
 }
 void sss_pam_unlock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_unlock(&sss_pam_mtx);
 }
 
@@ -1190,16 +1261,25 @@ void sss_nss_mc_unlock(void)
 /* PAC mutex wrappers */
 void sss_pac_lock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_lock(&sss_pac_mtx);
 }
 void sss_pac_unlock(void)
 {
+    if (sss_is_lockfree_mode()) {
+        return;
+    }
+
     sss_mt_unlock(&sss_pac_mtx);
 }
 
 #else
 
 /* sorry no mutexes available */
+bool sss_is_lockfree_mode(void) { return false; }
 void sss_nss_lock(void) { return; }
 void sss_nss_unlock(void) { return; }
 void sss_pam_lock(void) { return; }
@@ -71,6 +71,16 @@ int sss_nss_timedlock(unsigned int timeout_ms, int *time_left_ms)
         timeout_ms = INT_MAX;
     }
 
+    /* each thread has its own connection, there is nothing to wait for */
+    if (sss_is_lockfree_mode()) {
+        if (timeout_ms > SSS_CLI_SOCKET_TIMEOUT) {
+            *time_left_ms = SSS_CLI_SOCKET_TIMEOUT;
+        } else {
+            *time_left_ms = timeout_ms;
+        }
+        return 0;
+    }
+
     ret = clock_gettime(CLOCK_REALTIME, &starttime);
     if (ret != 0) {
         return ret;
@@ -29,6 +29,7 @@
 #include "sss_client/sss_cli.h"
 #include "sss_client/idmap/sss_nss_idmap.h"
 #include "sss_client/idmap/sss_nss_idmap_private.h"
+#include "sss_client/nss_mc.h"
 #include "util/strtonum.h"
 
 #define DATA_START (3 * sizeof(uint32_t))
@@ -201,11 +202,59 @@ done:
     return ret;
 }
 
+/* Try to answer SID lookups from the memory cache, returns ENOENT if the
+ * request has to be sent to the responder. */
+static int sss_nss_mc_getyyybyxxx(union input inp, size_t inp_len,
+                                  enum sss_cli_command cmd,
+                                  struct output *out)
+{
+    uint32_t type;
+    char *str = NULL;
+    uint32_t id = 0;
+    int ret;
+
+    switch (cmd) {
+    case SSS_NSS_GETSIDBYNAME:
+        ret = sss_nss_mc_get_sid_by_name(inp.str, inp_len, &str, &type);
+        break;
+    case SSS_NSS_GETNAMEBYSID:
+        ret = sss_nss_mc_get_name_by_sid(inp.str, inp_len, &str, &type);
+        break;
+    case SSS_NSS_GETIDBYSID:
+        ret = sss_nss_mc_get_id_by_sid(inp.str, inp_len, &id, &type);
+        break;
+    case SSS_NSS_GETSIDBYID:
+        ret = sss_nss_mc_get_sid_by_id(inp.id, SSS_MC_SID_BY_ID, &str, &type);
+        break;
+    case SSS_NSS_GETSIDBYUID:
+        ret = sss_nss_mc_get_sid_by_id(inp.id, SSS_MC_SID_BY_UID, &str, &type);
+        break;
+    case SSS_NSS_GETSIDBYGID:
+        ret = sss_nss_mc_get_sid_by_id(inp.id, SSS_MC_SID_BY_GID, &str, &type);
+        break;
+    default:
+        return ENOENT;
+    }
+
+    if (ret != 0) {
+        return ENOENT;
+    }
+
+    out->type = (enum sss_id_type) type;
+    if (cmd == SSS_NSS_GETIDBYSID) {
+        out->d.id = id;
+    } else {
+        out->d.str = str;
+    }
+
+    return EOK;
+}
+
 static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd,
                                unsigned int timeout, struct output *out)
 {
     int ret;
-    size_t inp_len;
+    size_t inp_len = 0;
     struct sss_cli_req_data rd;
     uint8_t *repbuf = NULL;
     size_t replen;
@@ -256,6 +305,11 @@ static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd,
         return EINVAL;
     }
 
+    ret = sss_nss_mc_getyyybyxxx(inp, inp_len, cmd, out);
+    if (ret == EOK) {
+        return EOK;
+    }
+
     if (timeout == NO_TIMEOUT) {
         sss_nss_lock();
     } else {
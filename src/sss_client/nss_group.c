@@ -53,7 +53,9 @@ enum sss_nss_gr_type {
     GETGR_GID
 };
 
-static struct sss_nss_getgr_data {
+/* The reply saved for the retry after ERANGE belongs to the thread that got
+ * it, the lookups of other threads must not replace or consume it. */
+static __thread struct sss_nss_getgr_data {
     enum sss_nss_gr_type type;
     union {
         char *grname;
@@ -422,6 +424,11 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
     case ENOENT:
+        if (sss_nss_mc_check_negative_name(SSS_MC_NEG_GROUP, name) == 0) {
+            /* the responder recently reported that there is no such entry */
+            *errnop = 0;
+            return NSS_STATUS_NOTFOUND;
+        }
         /* fall through, we need to actively ask the parent
          * if no entry is found */
         break;
@@ -536,6 +543,11 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
     case ENOENT:
+        if (sss_nss_mc_check_negative_id(SSS_MC_NEG_GID, gid) == 0) {
+            /* the responder recently reported that there is no such entry */
+            *errnop = 0;
+            return NSS_STATUS_NOTFOUND;
+        }
         /* fall through, we need to actively ask the parent
          * if no entry is found */
         break;
@@ -68,6 +68,10 @@ errno_t sss_nss_str_ptr_from_buffer(char **str, void **cookie,
                                     char *buf, size_t len);
 uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
                                         uint32_t hash);
+errno_t sss_nss_mc_get_reply(const char *cache_name,
+                             struct sss_cli_mc_ctx *ctx,
+                             const char *key, size_t key_len,
+                             uint8_t **_reply, size_t *_reply_len);
 
 /* passwd db */
 errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
@@ -90,4 +94,28 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
                                   gid_t group, long int *start, long int *size,
                                   gid_t **groups, long int limit);
 
+/* services db, the reply is in the format of the socket reply */
+errno_t sss_nss_mc_getservbyname(const char *name, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len);
+errno_t sss_nss_mc_getservbyport(uint16_t port, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len);
+
+/* netgroup db, the reply is in the format of the socket reply */
+errno_t sss_nss_mc_getnetgr(const char *name, size_t name_len,
+                            uint8_t **_reply, size_t *_reply_len);
+
+/* negative entries, return 0 if the key is known not to exist */
+errno_t sss_nss_mc_check_negative_name(char kind, const char *name);
+errno_t sss_nss_mc_check_negative_id(char kind, uint32_t id);
+
+/* SID db */
+errno_t sss_nss_mc_get_sid_by_id(uint32_t id, uint32_t populated_by,
+                                 char **_sid, uint32_t *_type);
+errno_t sss_nss_mc_get_id_by_sid(const char *sid, size_t sid_len,
+                                 uint32_t *_id, uint32_t *_type);
+errno_t sss_nss_mc_get_sid_by_name(const char *name, size_t name_len,
+                                   char **_sid, uint32_t *_type);
+errno_t sss_nss_mc_get_name_by_sid(const char *sid, size_t sid_len,
+                                   char **_name, uint32_t *_type);
+
 #endif /* _NSS_MC_H_ */
@@ -30,6 +30,8 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
 #include "nss_mc.h"
 #include "sss_cli.h"
 #include "shared/io.h"
@@ -381,3 +383,100 @@ uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
     }
 
 }
+
+errno_t sss_nss_mc_get_reply(const char *cache_name,
+                             struct sss_cli_mc_ctx *ctx,
+                             const char *key, size_t key_len,
+                             uint8_t **_reply, size_t *_reply_len)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_reply_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_reply_data, strs);
+    uint8_t *reply;
+    uint32_t hash;
+    uint32_t slot;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx(cache_name, ctx);
+    if (ret) {
+        return ret;
+    }
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(ctx, key, key_len + 1);
+    slot = ctx->hash_table[hash];
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, ctx->dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* check key only if the hash matches */
+        if (hash != rec->hash1) {
+            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
+        data = (struct sss_mc_reply_data *)rec->data;
+        /* Integrity check
+         * - data->name must point to the start of strs
+         * - data->reply cannot point outside strs
+         * - the reply must end within strs
+         * - all strings must be within copy of record
+         * - the key is zero-terminated */
+        if (data->name != strs_offset
+            || data->strs_len > rec->len
+            || data->reply <= strs_offset
+            || data->reply_len > data->strs_len
+            || data->reply - strs_offset > data->strs_len - data->reply_len
+            || data->strs[data->reply - strs_offset - 1] != '\0') {
+            ret = ENOENT;
+            goto done;
+        }
+
+        if (strcmp(key, data->strs) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, ctx->dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    if ((time_t)rec->expire < time(NULL)) {
+        /* entry is now invalid */
+        ret = EINVAL;
+        goto done;
+    }
+
+    /* callers checking only the presence of the key pass NULL */
+    if (_reply != NULL) {
+        reply = malloc(data->reply_len);
+        if (reply == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        memcpy(reply, (uint8_t *)data + data->reply, data->reply_len);
+
+        *_reply = reply;
+        *_reply_len = data->reply_len;
+    }
+
+    ret = 0;
+
+done:
+    free(rec);
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+    return ret;
+}
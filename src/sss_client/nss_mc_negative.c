@@ -0,0 +1,66 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Negative entries using mmap cache */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx neg_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
+                                            NULL, 0, 0 };
+
+static errno_t sss_nss_mc_check_negative_key(char *key, int key_len)
+{
+    errno_t ret;
+
+    if (key_len < 0) {
+        return ENOMEM;
+    }
+
+    ret = sss_nss_mc_get_reply("negative", &neg_mc_ctx, key, key_len,
+                               NULL, NULL);
+    free(key);
+    return ret;
+}
+
+errno_t sss_nss_mc_check_negative_name(char kind, const char *name)
+{
+    char *key;
+    int key_len;
+
+    key_len = asprintf(&key, SSS_MC_NEG_NAME_KEY_FMT, kind, name);
+
+    return sss_nss_mc_check_negative_key(key, key_len);
+}
+
+errno_t sss_nss_mc_check_negative_id(char kind, uint32_t id)
+{
+    char *key;
+    int key_len;
+
+    key_len = asprintf(&key, SSS_MC_NEG_ID_KEY_FMT, kind, id);
+
+    return sss_nss_mc_check_negative_key(key, key_len);
+}
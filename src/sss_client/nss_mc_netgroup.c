@@ -0,0 +1,37 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* NETGROUP database NSS interface using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx netgr_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0,
+                                              NULL, 0, NULL, 0, 0 };
+
+errno_t sss_nss_mc_getnetgr(const char *name, size_t name_len,
+                            uint8_t **_reply, size_t *_reply_len)
+{
+    return sss_nss_mc_get_reply("netgroup", &netgr_mc_ctx, name, name_len,
+                                _reply, _reply_len);
+}
@@ -0,0 +1,253 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SID-to-ID and SID-to-name mappings using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx sid_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
+                                            NULL, 0, 0 };
+
+enum sss_nss_mc_sid_key {
+    SID_KEY_ID,         /* find SID by ID, the key is the ID string */
+    SID_KEY_SID,        /* find ID by SID */
+    SID_KEY_NAME,       /* find SID by name */
+    SID_KEY_NAME_SID,   /* find name by SID */
+};
+
+static bool sss_nss_mc_sid_rec_matches(struct sss_mc_rec *rec,
+                                       uint32_t hash,
+                                       enum sss_nss_mc_sid_key key_type,
+                                       const char *key,
+                                       uint32_t id,
+                                       uint32_t populated_by)
+{
+    struct sss_mc_sid_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_sid_data, strs);
+
+    data = (struct sss_mc_sid_data *)rec->data;
+
+    /* Integrity check
+     * - data->name and data->sid cannot point outside strings
+     * - all strings must be within copy of record
+     * - the last string is zero-terminated */
+    if (data->name < strs_offset
+        || data->name >= strs_offset + data->strs_len
+        || data->sid < strs_offset
+        || data->sid >= strs_offset + data->strs_len
+        || data->strs_len > rec->len
+        || data->strs_len == 0
+        || data->strs[data->strs_len - 1] != '\0') {
+        return false;
+    }
+
+    switch (key_type) {
+    case SID_KEY_ID:
+        return hash == rec->hash2
+                && data->populated_by == populated_by
+                && data->id == id;
+    case SID_KEY_SID:
+        return hash == rec->hash1
+                && (data->populated_by == SSS_MC_SID_BY_SID
+                    || data->populated_by == SSS_MC_SID_BY_ID)
+                && data->id != 0
+                && strcmp(key, (char *)data + data->sid) == 0;
+    case SID_KEY_NAME:
+        return hash == rec->hash1
+                && data->populated_by == SSS_MC_SID_BY_NAME
+                && strcmp(key, (char *)data + data->name) == 0;
+    case SID_KEY_NAME_SID:
+        return hash == rec->hash2
+                && data->populated_by == SSS_MC_SID_BY_NAME
+                && strcmp(key, (char *)data + data->sid) == 0;
+    }
+
+    return false;
+}
+
+static errno_t sss_nss_mc_get_sid_rec(enum sss_nss_mc_sid_key key_type,
+                                      const char *key, size_t key_len,
+                                      uint32_t id, uint32_t populated_by,
+                                      struct sss_mc_rec **_rec)
+{
+    struct sss_mc_rec *rec = NULL;
+    uint32_t hash;
+    uint32_t slot;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sid", &sid_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(&sid_mc_ctx, key, key_len + 1);
+    slot = sid_mc_ctx.hash_table[hash];
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&sid_mc_ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        if (sss_nss_mc_sid_rec_matches(rec, hash, key_type, key,
+                                       id, populated_by)) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    if ((time_t)rec->expire < time(NULL)) {
+        /* entry is now invalid */
+        ret = EINVAL;
+        goto done;
+    }
+
+    *_rec = rec;
+    rec = NULL;
+    ret = 0;
+
+done:
+    free(rec);
+    __sync_sub_and_fetch(&sid_mc_ctx.active_threads, 1);
+    return ret;
+}
+
+static errno_t sss_nss_mc_sid_copy_str(struct sss_mc_rec *rec,
+                                       rel_ptr_t ptr,
+                                       uint32_t *_type,
+                                       char **_str)
+{
+    struct sss_mc_sid_data *data;
+    char *str;
+
+    data = (struct sss_mc_sid_data *)rec->data;
+
+    str = strdup((char *)data + ptr);
+    if (str == NULL) {
+        return ENOMEM;
+    }
+
+    *_type = data->type;
+    *_str = str;
+
+    return 0;
+}
+
+errno_t sss_nss_mc_get_sid_by_id(uint32_t id, uint32_t populated_by,
+                                 char **_sid, uint32_t *_type)
+{
+    struct sss_mc_rec *rec;
+    char idstr[11];
+    int len;
+    int ret;
+
+    len = snprintf(idstr, 11, "%ld", (long)id);
+    if (len > 10) {
+        return EINVAL;
+    }
+
+    ret = sss_nss_mc_get_sid_rec(SID_KEY_ID, idstr, len, id, populated_by,
+                                 &rec);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_sid_copy_str(rec,
+                                  ((struct sss_mc_sid_data *)rec->data)->sid,
+                                  _type, _sid);
+    free(rec);
+    return ret;
+}
+
+errno_t sss_nss_mc_get_id_by_sid(const char *sid, size_t sid_len,
+                                 uint32_t *_id, uint32_t *_type)
+{
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    int ret;
+
+    ret = sss_nss_mc_get_sid_rec(SID_KEY_SID, sid, sid_len, 0, 0, &rec);
+    if (ret) {
+        return ret;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+    *_id = data->id;
+    *_type = data->type;
+
+    free(rec);
+    return 0;
+}
+
+errno_t sss_nss_mc_get_sid_by_name(const char *name, size_t name_len,
+                                   char **_sid, uint32_t *_type)
+{
+    struct sss_mc_rec *rec;
+    int ret;
+
+    ret = sss_nss_mc_get_sid_rec(SID_KEY_NAME, name, name_len, 0, 0, &rec);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_sid_copy_str(rec,
+                                  ((struct sss_mc_sid_data *)rec->data)->sid,
+                                  _type, _sid);
+    free(rec);
+    return ret;
+}
+
+errno_t sss_nss_mc_get_name_by_sid(const char *sid, size_t sid_len,
+                                   char **_name, uint32_t *_type)
+{
+    struct sss_mc_rec *rec;
+    int ret;
+
+    ret = sss_nss_mc_get_sid_rec(SID_KEY_NAME_SID, sid, sid_len, 0, 0, &rec);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_sid_copy_str(rec,
+                                  ((struct sss_mc_sid_data *)rec->data)->name,
+                                  _type, _name);
+    free(rec);
+    return ret;
+}
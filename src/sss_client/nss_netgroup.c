@@ -32,6 +32,7 @@
 #include <string.h>
 #include "sss_cli.h"
 #include "nss_compat.h"
+#include "nss_mc.h"
 
 #define CLEAR_NETGRENT_DATA(netgrent) do { \
         free(netgrent->data); \
@@ -53,6 +54,62 @@
  *  ... repeated N times
  */
 #define NETGR_METADATA_COUNT 2 * sizeof(uint32_t)
+
+/* Value of the reserved field of a reply read from the memory cache. Such
+ * a reply always holds the complete netgroup so no further requests must be
+ * sent to the responder. */
+#define NETGR_REP_FROM_MC 1
+
+static bool sss_nss_netgr_from_mc(struct __netgrent *result)
+{
+    uint32_t reserved;
+
+    if (result->data == NULL || result->data_size < NETGR_METADATA_COUNT) {
+        return false;
+    }
+
+    SAFEALIGN_COPY_UINT32(&reserved, result->data + sizeof(uint32_t), NULL);
+
+    return reserved == NETGR_REP_FROM_MC;
+}
+
+static bool sss_nss_setnetgrent_mc(const char *netgroup, size_t name_len,
+                                   struct __netgrent *result)
+{
+    uint8_t *repbuf;
+    size_t replen;
+    uint32_t num_results;
+    errno_t ret;
+
+    ret = sss_nss_mc_getnetgr(netgroup, name_len, &repbuf, &replen);
+    if (ret != 0) {
+        return false;
+    }
+
+    if (replen <= NETGR_METADATA_COUNT) {
+        free(repbuf);
+        return false;
+    }
+
+    SAFEALIGN_COPY_UINT32(&num_results, repbuf, NULL);
+    if (num_results == 0) {
+        free(repbuf);
+        return false;
+    }
+
+    SAFEALIGN_SETMEM_UINT32(repbuf + sizeof(uint32_t), NETGR_REP_FROM_MC,
+                            NULL);
+
+    /* make sure we do not have leftovers, and release memory */
+    CLEAR_NETGRENT_DATA(result);
+
+    result->data = (char *) repbuf;
+    result->data_size = replen;
+    /* skip metadata fields */
+    result->idx.position = NETGR_METADATA_COUNT;
+
+    return true;
+}
 struct sss_nss_netgr_rep {
     struct __netgrent *result;
     char *buffer;
@@ -170,17 +227,20 @@ enum nss_status _nss_sss_setnetgrent(const char *netgroup,
 
     if (!netgroup) return NSS_STATUS_NOTFOUND;
 
+    ret = sss_strnlen(netgroup, SSS_NAME_MAX, &name_len);
+    if (ret != 0) {
+        return NSS_STATUS_NOTFOUND;
+    }
+
+    if (sss_nss_setnetgrent_mc(netgroup, name_len, result)) {
+        return NSS_STATUS_SUCCESS;
+    }
+
     sss_nss_lock();
 
     /* make sure we do not have leftovers, and release memory */
     CLEAR_NETGRENT_DATA(result);
 
-    ret = sss_strnlen(netgroup, SSS_NAME_MAX, &name_len);
-    if (ret != 0) {
-        nret = NSS_STATUS_NOTFOUND;
-        goto out;
-    }
-
     name = malloc(sizeof(char)*name_len + 1);
     if (name == NULL) {
         nret = NSS_STATUS_TRYAGAIN;
@@ -260,6 +320,11 @@ static enum nss_status internal_getnetgrent_r(struct __netgrent *result,
         return NSS_STATUS_SUCCESS;
     }
 
+    /* A reply from the memory cache holds the whole netgroup. */
+    if (sss_nss_netgr_from_mc(result)) {
+        return NSS_STATUS_RETURN;
+    }
+
     /* Release memory, if any */
     CLEAR_NETGRENT_DATA(result);
 
@@ -298,6 +363,11 @@ enum nss_status _nss_sss_getnetgrent_r(struct __netgrent *result,
 {
     enum nss_status nret;
 
+    if (sss_nss_netgr_from_mc(result)) {
+        /* the responder is not contacted, no need to lock */
+        return internal_getnetgrent_r(result, buffer, buflen, errnop);
+    }
+
     sss_nss_lock();
     nret = internal_getnetgrent_r(result, buffer, buflen, errnop);
     sss_nss_unlock();
@@ -310,6 +380,12 @@ enum nss_status _nss_sss_endnetgrent(struct __netgrent *result)
     enum nss_status nret;
     int errnop;
 
+    if (sss_nss_netgr_from_mc(result)) {
+        /* no state was created in the responder */
+        CLEAR_NETGRENT_DATA(result);
+        return NSS_STATUS_SUCCESS;
+    }
+
     sss_nss_lock();
 
     /* make sure we do not have leftovers, and release memory */
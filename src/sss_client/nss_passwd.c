@@ -159,6 +159,11 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
     case ENOENT:
+        if (sss_nss_mc_check_negative_name(SSS_MC_NEG_USER, name) == 0) {
+            /* the responder recently reported that there is no such entry */
+            *errnop = 0;
+            return NSS_STATUS_NOTFOUND;
+        }
         /* fall through, we need to actively ask the parent
          * if no entry is found */
         break;
@@ -265,6 +270,11 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
     case ENOENT:
+        if (sss_nss_mc_check_negative_id(SSS_MC_NEG_UID, uid) == 0) {
+            /* the responder recently reported that there is no such entry */
+            *errnop = 0;
+            return NSS_STATUS_NOTFOUND;
+        }
         /* fall through, we need to actively ask the parent
          * if no entry is found */
         break;
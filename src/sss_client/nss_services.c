@@ -22,6 +22,7 @@
 
 #include <nss.h>
 #include <netdb.h>
+#include <arpa/inet.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -30,6 +31,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "sss_cli.h"
+#include "nss_mc.h"
 
 static struct sss_nss_getservent_data {
     size_t len;
@@ -157,6 +159,33 @@ sss_nss_getsvc_readrep(struct sss_nss_svc_rep *sr,
 
     return EOK;
 }
+/* Parse a reply fetched from the memory cache. */
+static errno_t
+sss_nss_getsvc_mc_readrep(struct servent *result,
+                          char *buffer, size_t buflen,
+                          uint8_t *repbuf, size_t replen)
+{
+    struct sss_nss_svc_rep svcrep;
+    uint32_t num_results;
+    size_t len;
+
+    if (replen <= SVC_METADATA_COUNT) {
+        return EBADMSG;
+    }
+
+    /* only 1 result is ever cached */
+    SAFEALIGN_COPY_UINT32(&num_results, repbuf, NULL);
+    if (num_results != 1) {
+        return EBADMSG;
+    }
+
+    svcrep.result = result;
+    svcrep.buffer = buffer;
+    svcrep.buflen = buflen;
+
+    len = replen - SVC_METADATA_COUNT;
+    return sss_nss_getsvc_readrep(&svcrep, repbuf + SVC_METADATA_COUNT, &len);
+}
 
 enum nss_status
 _nss_sss_getservbyname_r(const char *name,
@@ -196,6 +225,25 @@ _nss_sss_getservbyname_r(const char *name,
         }
     }
 
+    ret = sss_nss_mc_getservbyname(name, protocol, &repbuf, &replen);
+    if (ret == 0) {
+        ret = sss_nss_getsvc_mc_readrep(result, buffer, buflen,
+                                        repbuf, replen);
+        free(repbuf);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            return NSS_STATUS_SUCCESS;
+        case ERANGE:
+            *errnop = ERANGE;
+            return NSS_STATUS_TRYAGAIN;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
+    }
+
     rd.len = name_len + proto_len + 2;
     data = malloc(sizeof(uint8_t)*rd.len);
     if (data == NULL) {
@@ -294,6 +342,26 @@ _nss_sss_getservbyport_r(int port, const char *protocol,
         }
     }
 
+    ret = sss_nss_mc_getservbyport(ntohs(port), protocol,
+                                   &repbuf, &replen);
+    if (ret == 0) {
+        ret = sss_nss_getsvc_mc_readrep(result, buffer, buflen,
+                                        repbuf, replen);
+        free(repbuf);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            return NSS_STATUS_SUCCESS;
+        case ERANGE:
+            *errnop = ERANGE;
+            return NSS_STATUS_TRYAGAIN;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
+    }
+
     rd.len = sizeof(uint32_t)*2 + proto_len + 1;
     data = malloc(sizeof(uint8_t)*rd.len);
     if (data == NULL) {
@@ -29,6 +29,7 @@
 #include <pwd.h>
 #include <grp.h>
 #include <string.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <limits.h>
 
@@ -703,6 +704,12 @@ int sss_ssh_make_request(enum sss_cli_command cmd,
  */
 errno_t sss_strnlen(const char *str, size_t maxlen, size_t *len);
 
+/* Returns true if the NSS, PAM and PAC locks are not taken. Can be disabled
+ * by setting the environment variable SSS_LOCKFREE to "NO", which serializes
+ * the requests again. Each thread keeps its own connection in both modes if
+ * the client was built with lock-free support. */
+bool sss_is_lockfree_mode(void);
+
 void sss_nss_lock(void);
 void sss_nss_unlock(void);
 void sss_pam_lock(void);
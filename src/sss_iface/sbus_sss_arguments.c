@@ -25,6 +25,7 @@
 
 #include "sbus/interface/sbus_iterator_readers.h"
 #include "sbus/interface/sbus_iterator_writers.h"
+#include "sbus/frame/sbus_frame.h"
 #include "sss_iface/sbus_sss_arguments.h"
 
 errno_t _sbus_sss_invoker_read_as
@@ -250,6 +251,55 @@ errno_t _sbus_sss_invoker_write_qus
     return EOK;
 }
 
+errno_t _sbus_sss_invoker_frame_read_qus
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_frame_reader *reader,
+    struct _sbus_sss_invoker_args_qus *args)
+{
+    errno_t ret;
+
+    ret = sbus_frame_read_q(reader, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_u(reader, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_s(mem_ctx, reader, &args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_sss_invoker_frame_write_qus
+   (struct sbus_frame_writer *writer,
+    struct _sbus_sss_invoker_args_qus *args)
+{
+    errno_t ret;
+
+    ret = sbus_frame_write_q(writer, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_u(writer, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_s(writer, args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
 errno_t _sbus_sss_invoker_read_s
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
@@ -651,3 +701,72 @@ errno_t _sbus_sss_invoker_write_uusss
     return EOK;
 }
 
+errno_t _sbus_sss_invoker_frame_read_uusss
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_frame_reader *reader,
+    struct _sbus_sss_invoker_args_uusss *args)
+{
+    errno_t ret;
+
+    ret = sbus_frame_read_u(reader, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_u(reader, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_s(mem_ctx, reader, &args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_s(mem_ctx, reader, &args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_read_s(mem_ctx, reader, &args->arg4);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_sss_invoker_frame_write_uusss
+   (struct sbus_frame_writer *writer,
+    struct _sbus_sss_invoker_args_uusss *args)
+{
+    errno_t ret;
+
+    ret = sbus_frame_write_u(writer, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_u(writer, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_s(writer, args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_s(writer, args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_frame_write_s(writer, args->arg4);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
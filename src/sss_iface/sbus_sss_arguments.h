@@ -26,6 +26,7 @@
 #include <stdbool.h>
 #include <dbus/dbus.h>
 
+#include "sbus/frame/sbus_frame.h"
 #include "sss_iface/sss_iface_types.h"
 
 struct _sbus_sss_invoker_args_as {
@@ -135,6 +136,17 @@ _sbus_sss_invoker_write_qus
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_qus *args);
 
+errno_t
+_sbus_sss_invoker_frame_read_qus
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_frame_reader *reader,
+    struct _sbus_sss_invoker_args_qus *args);
+
+errno_t
+_sbus_sss_invoker_frame_write_qus
+   (struct sbus_frame_writer *writer,
+    struct _sbus_sss_invoker_args_qus *args);
+
 struct _sbus_sss_invoker_args_s {
     const char * arg0;
 };
@@ -284,4 +296,15 @@ _sbus_sss_invoker_write_uusss
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_uusss *args);
 
+errno_t
+_sbus_sss_invoker_frame_read_uusss
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_frame_reader *reader,
+    struct _sbus_sss_invoker_args_uusss *args);
+
+errno_t
+_sbus_sss_invoker_frame_write_uusss
+   (struct sbus_frame_writer *writer,
+    struct _sbus_sss_invoker_args_uusss *args);
+
 #endif /* _SBUS_SSS_ARGUMENTS_H_ */
@@ -74,6 +74,8 @@ struct data_provider *mock_dp(TALLOC_CTX *mem_ctx,
     provider->requests.index = 0;
     provider->requests.num_active = 0;
     provider->requests.active = NULL;
+    provider->requests.pending = sss_ptr_hash_create(provider, NULL, NULL);
+    assert_non_null(provider->requests.pending);
     provider->targets = mock_dp_targets(provider);
     provider->modules = NULL;
 
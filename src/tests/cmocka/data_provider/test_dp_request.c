@@ -23,6 +23,8 @@
 #include "providers/backend.h"
 #include "providers/data_provider/dp_private.h"
 #include "providers/data_provider/dp.h"
+#include "providers/data_provider/dp_custom_data.h"
+#include "providers/data_provider/dp_iface.h"
 #include "tests/cmocka/common_mock.h"
 #include "tests/common.h"
 #include "tests/cmocka/common_mock_be.h"
@@ -408,6 +410,262 @@ static void test_fast_reply(void **state)
     talloc_free(md);
 }
 
+static int num_account_lookups;
+
+struct account_state
+{
+    struct dp_id_data *data;
+};
+
+static void get_account_done(struct tevent_context *ev,
+                             struct tevent_timer *tt,
+                             struct timeval tv,
+                             void *pvt)
+{
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    tevent_req_done(req);
+}
+
+static struct tevent_req *
+get_account_send(TALLOC_CTX *mem_ctx,
+                 struct method_data *md,
+                 struct dp_id_data *data,
+                 struct dp_req_params *params)
+{
+    struct tevent_req *req;
+    struct account_state *state;
+    struct tevent_timer *tt;
+    struct timeval tv;
+
+    req = tevent_req_create(mem_ctx, &state, struct account_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create failed.\n");
+        return NULL;
+    }
+
+    /* The request data is read only when the lookup finishes. */
+    num_account_lookups++;
+    state->data = data;
+
+    /* Mock lookup */
+    tv = tevent_timeval_current_ofs(1, 0);
+    tt = tevent_add_timer(params->ev, req, tv, get_account_done, req);
+    if (tt == NULL) {
+        return NULL;
+    }
+
+    return req;
+}
+
+static errno_t
+get_account_recv(TALLOC_CTX *mem_ctx,
+                 struct tevent_req *req,
+                 struct dp_reply_std *data)
+{
+    struct account_state *state;
+
+    state = tevent_req_data(req, struct account_state);
+
+    data->dp_error = DP_ERR_OK;
+    data->error = EOK;
+    data->message = talloc_strdup(mem_ctx, state->data->filter_value);
+    if (data->message == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static struct dp_id_data *account_data(TALLOC_CTX *mem_ctx,
+                                       const char *filter_value)
+{
+    struct dp_id_data *data;
+
+    data = talloc_zero(mem_ctx, struct dp_id_data);
+    assert_non_null(data);
+
+    data->entry_type = BE_REQ_USER;
+    data->filter_type = BE_FILTER_IDNUM;
+    data->filter_value = talloc_strdup(data, filter_value);
+    assert_non_null(data->filter_value);
+
+    return data;
+}
+
+static void assert_account_reply(struct test_ctx *test_ctx,
+                                 struct tevent_req *req,
+                                 const char *filter_value)
+{
+    struct dp_reply_std *reply;
+    errno_t ret;
+
+    ret = dp_req_recv_ptr(test_ctx, req, struct dp_reply_std, &reply);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(reply->dp_error, DP_ERR_OK);
+    assert_int_equal(reply->error, EOK);
+    assert_string_equal(reply->message, filter_value);
+    talloc_free(reply);
+}
+
+static void test_coalesce(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char *req_name;
+    struct tevent_req *req;
+    struct tevent_req *req2;
+    struct tevent_req *req3;
+    struct tevent_req *req4;
+    struct method_data *md;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    md = talloc(test_ctx, struct method_data);
+    assert_non_null(md);
+
+    dp_set_method(test_ctx->dp_methods,
+                  DPM_ACCOUNT_HANDLER,
+                  get_account_send, get_account_recv,
+                  md,
+                  struct method_data, struct dp_id_data, struct dp_reply_std);
+
+    num_account_lookups = 0;
+
+    req = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                      DPT_ID, DPM_ACCOUNT_HANDLER, 0,
+                      account_data(test_ctx, "100001"), &req_name);
+    assert_non_null(req);
+    assert_string_equal(req_name, REQ_NAME" #0");
+    talloc_zfree(req_name);
+
+    /* Identical requests join the first one. */
+    req2 = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                       DPT_ID, DPM_ACCOUNT_HANDLER, 0,
+                       account_data(test_ctx, "100001"), &req_name);
+    assert_non_null(req2);
+    assert_string_equal(req_name, REQ_NAME" #0");
+    talloc_zfree(req_name);
+
+    req3 = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                       DPT_ID, DPM_ACCOUNT_HANDLER, 0,
+                       account_data(test_ctx, "100001"), &req_name);
+    assert_non_null(req3);
+    assert_string_equal(req_name, REQ_NAME" #0");
+    talloc_zfree(req_name);
+
+    /* A different lookup runs on its own. */
+    req4 = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                       DPT_ID, DPM_ACCOUNT_HANDLER, 0,
+                       account_data(test_ctx, "100002"), &req_name);
+    assert_non_null(req4);
+    assert_string_equal(req_name, REQ_NAME" #1");
+    talloc_zfree(req_name);
+
+    assert_int_equal(test_ctx->provider->requests.num_coalesced, 2);
+    assert_int_equal(num_account_lookups, 2);
+
+    /* The caller that filed the request goes away, the others
+     * must still get the result. */
+    talloc_zfree(req);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    assert_account_reply(test_ctx, req2, "100001");
+    assert_account_reply(test_ctx, req3, "100001");
+    assert_account_reply(test_ctx, req4, "100002");
+
+    talloc_free(req2);
+    talloc_free(req3);
+    talloc_free(req4);
+
+    /* Once finished, the same lookup is run again. */
+    req = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                      DPT_ID, DPM_ACCOUNT_HANDLER, 0,
+                      account_data(test_ctx, "100001"), NULL);
+    assert_non_null(req);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    assert_account_reply(test_ctx, req, "100001");
+    assert_int_equal(num_account_lookups, 3);
+    assert_int_equal(test_ctx->provider->requests.num_coalesced, 2);
+
+    talloc_free(req);
+    talloc_free(md);
+}
+
+/* The caller that filed a coalesced account request is freed together
+ * with the message its filter came in while the handler still runs. */
+static void test_coalesce_account_info(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct tevent_req *req;
+    struct tevent_req *req2;
+    struct method_data *md;
+    const char *err_msg;
+    uint16_t dp_error;
+    uint32_t error;
+    char *filter;
+    char *filter2;
+    char *domain;
+    errno_t ret;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    md = talloc(test_ctx, struct method_data);
+    assert_non_null(md);
+
+    dp_set_method(test_ctx->dp_methods,
+                  DPM_ACCOUNT_HANDLER,
+                  get_account_send, get_account_recv,
+                  md,
+                  struct method_data, struct dp_id_data, struct dp_reply_std);
+
+    num_account_lookups = 0;
+
+    filter = talloc_strdup(test_ctx, "idnumber=100001");
+    assert_non_null(filter);
+    domain = talloc_strdup(test_ctx, TEST_DOM_NAME);
+    assert_non_null(domain);
+
+    req = dp_get_account_info_send(test_ctx, test_ctx->tctx->ev, NULL,
+                                   test_ctx->provider, 0, BE_REQ_USER,
+                                   filter, domain, NULL);
+    assert_non_null(req);
+
+    filter2 = talloc_strdup(test_ctx, "idnumber=100001");
+    assert_non_null(filter2);
+
+    req2 = dp_get_account_info_send(test_ctx, test_ctx->tctx->ev, NULL,
+                                    test_ctx->provider, 0, BE_REQ_USER,
+                                    filter2, TEST_DOM_NAME, NULL);
+    assert_non_null(req2);
+
+    assert_int_equal(num_account_lookups, 1);
+    assert_int_equal(test_ctx->provider->requests.num_coalesced, 1);
+
+    /* Overwrite the strings so a stale pointer can not go unnoticed. */
+    memset(filter, 'X', strlen(filter));
+    memset(domain, 'X', strlen(domain));
+    talloc_free(filter);
+    talloc_free(domain);
+    talloc_zfree(req);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    ret = dp_get_account_info_recv(test_ctx, req2, &dp_error, &error,
+                                   &err_msg);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_error, DP_ERR_OK);
+    assert_int_equal(error, EOK);
+    assert_string_equal(err_msg, "100001");
+
+    talloc_free(req2);
+    talloc_free(filter2);
+    talloc_free(md);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -435,6 +693,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_nonexist_dom,
                                         test_setup,
                                         test_teardown),
+        cmocka_unit_test_setup_teardown(test_coalesce,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_coalesce_account_info,
+                                        test_setup,
+                                        test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
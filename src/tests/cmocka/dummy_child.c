@@ -43,6 +43,10 @@ int main(int argc, const char *argv[])
     const char *action = NULL;
     const char *guitar;
     const char *drums;
+    uint8_t *req_buf;
+    size_t req_len;
+    uint8_t *resp_buf;
+    pid_t pid;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -107,6 +111,33 @@ int main(int argc, const char *argv[])
                       "debug_timestamp was not passed as expected\n");
                 _exit(1);
             }
+        } else if (strcasecmp(action, "worker") == 0) {
+            /* Answer every request with the pid followed by the request */
+            while ((ret = child_worker_read_request(NULL, STDIN_FILENO,
+                                                    &req_buf,
+                                                    &req_len)) == EOK) {
+                resp_buf = talloc_size(NULL, sizeof(pid_t) + req_len);
+                if (resp_buf == NULL) {
+                    _exit(1);
+                }
+                pid = getpid();
+                memcpy(resp_buf, &pid, sizeof(pid_t));
+                memcpy(resp_buf + sizeof(pid_t), req_buf, req_len);
+
+                ret = child_worker_send_response(STDOUT_FILENO, resp_buf,
+                                                 sizeof(pid_t) + req_len);
+                talloc_free(req_buf);
+                talloc_free(resp_buf);
+                if (ret != EOK) {
+                    _exit(1);
+                }
+            }
+
+            if (ret != ENOENT) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Reading request failed [%d]\n",
+                      ret);
+                _exit(1);
+            }
         } else if (strcasecmp(action, "echo") == 0) {
             errno = 0;
             len = sss_atomic_read_s(STDIN_FILENO, buf, IN_BUF_SIZE);
@@ -0,0 +1,431 @@
+/*
+    SSSD
+
+    sbus binary framing tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <unistd.h>
+
+#include "util/util.h"
+#include "sbus/frame/sbus_frame.h"
+#include "tests/cmocka/common_mock.h"
+#include "tests/common.h"
+
+#define TEST_SOCKET "test_sbus_frame.sock"
+#define TEST_IFACE "test.frame"
+
+static void frame_finish(struct sbus_frame_writer *writer,
+                         struct sbus_frame_reader *reader)
+{
+    struct sbus_frame_header *header;
+    uint8_t *frame;
+    size_t len;
+    errno_t ret;
+
+    ret = sbus_frame_writer_finish(writer, SBUS_FRAME_CALL, 42, &frame, &len);
+    assert_int_equal(ret, EOK);
+    assert_true(len >= sizeof(struct sbus_frame_header));
+
+    header = (struct sbus_frame_header *)frame;
+    assert_int_equal(header->magic, SBUS_FRAME_MAGIC);
+    assert_int_equal(header->version, SBUS_FRAME_VERSION);
+    assert_int_equal(header->type, SBUS_FRAME_CALL);
+    assert_int_equal(header->serial, 42);
+    assert_int_equal(header->length, len - sizeof(struct sbus_frame_header));
+
+    sbus_frame_reader_init(reader, frame + sizeof(struct sbus_frame_header),
+                           header->length);
+}
+
+void test_sbus_frame_basic(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_frame_writer *writer;
+    struct sbus_frame_reader reader;
+    const char *str;
+    char *copy;
+    uint8_t y;
+    bool b;
+    int16_t n;
+    uint16_t q;
+    int32_t i;
+    uint32_t u;
+    int64_t x;
+    uint64_t t;
+    double d;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    writer = sbus_frame_writer_create(tmp_ctx);
+    assert_non_null(writer);
+
+    assert_int_equal(sbus_frame_write_y(writer, 0xAB), EOK);
+    assert_int_equal(sbus_frame_write_b(writer, true), EOK);
+    assert_int_equal(sbus_frame_write_n(writer, -16), EOK);
+    assert_int_equal(sbus_frame_write_q(writer, 0xFFFF), EOK);
+    assert_int_equal(sbus_frame_write_i(writer, -32), EOK);
+    assert_int_equal(sbus_frame_write_u(writer, 0xFFFFFFFF), EOK);
+    assert_int_equal(sbus_frame_write_x(writer, -64), EOK);
+    assert_int_equal(sbus_frame_write_t(writer, 0xFFFFFFFFFFFFFFFF), EOK);
+    assert_int_equal(sbus_frame_write_d(writer, 3.5), EOK);
+    assert_int_equal(sbus_frame_write_s(writer, "string"), EOK);
+    assert_int_equal(sbus_frame_write_s(writer, NULL), EOK);
+    assert_int_equal(sbus_frame_write_O(writer, NULL), EOK);
+
+    frame_finish(writer, &reader);
+
+    assert_int_equal(sbus_frame_read_y(&reader, &y), EOK);
+    assert_int_equal(y, 0xAB);
+    assert_int_equal(sbus_frame_read_b(&reader, &b), EOK);
+    assert_true(b);
+    assert_int_equal(sbus_frame_read_n(&reader, &n), EOK);
+    assert_int_equal(n, -16);
+    assert_int_equal(sbus_frame_read_q(&reader, &q), EOK);
+    assert_int_equal(q, 0xFFFF);
+    assert_int_equal(sbus_frame_read_i(&reader, &i), EOK);
+    assert_int_equal(i, -32);
+    assert_int_equal(sbus_frame_read_u(&reader, &u), EOK);
+    assert_int_equal(u, 0xFFFFFFFF);
+    assert_int_equal(sbus_frame_read_x(&reader, &x), EOK);
+    assert_true(x == -64);
+    assert_int_equal(sbus_frame_read_t(&reader, &t), EOK);
+    assert_true(t == 0xFFFFFFFFFFFFFFFF);
+    assert_int_equal(sbus_frame_read_d(&reader, &d), EOK);
+    assert_true(d == 3.5);
+    assert_int_equal(sbus_frame_read_s(tmp_ctx, &reader, &str), EOK);
+    assert_string_equal(str, "string");
+    assert_int_equal(sbus_frame_read_s(tmp_ctx, &reader, &str), EOK);
+    assert_string_equal(str, "");
+    assert_int_equal(sbus_frame_read_O(tmp_ctx, &reader, &copy), EOK);
+    assert_string_equal(copy, "/");
+    assert_true(talloc_parent(copy) == tmp_ctx);
+    assert_true(sbus_frame_reader_done(&reader));
+
+    /* Nothing more to read. */
+    ret = sbus_frame_read_u(&reader, &u);
+    assert_int_equal(ret, ERR_SBUS_INVALID_TYPE);
+
+    talloc_free(tmp_ctx);
+}
+
+void test_sbus_frame_arrays(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_frame_writer *writer;
+    struct sbus_frame_reader reader;
+    const char *strings[] = {"one", "two", "three", NULL};
+    const char **read_strings;
+    char **copied_strings;
+    uint32_t *numbers;
+    uint32_t *read_numbers;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    numbers = talloc_array(tmp_ctx, uint32_t, 3);
+    assert_non_null(numbers);
+    numbers[0] = 1;
+    numbers[1] = 2;
+    numbers[2] = 3;
+
+    writer = sbus_frame_writer_create(tmp_ctx);
+    assert_non_null(writer);
+
+    assert_int_equal(sbus_frame_write_au(writer, numbers), EOK);
+    assert_int_equal(sbus_frame_write_au(writer, NULL), EOK);
+    assert_int_equal(sbus_frame_write_as(writer, strings), EOK);
+    assert_int_equal(sbus_frame_write_aS(writer,
+                                         discard_const_p(char *, strings)),
+                     EOK);
+
+    frame_finish(writer, &reader);
+
+    assert_int_equal(sbus_frame_read_au(tmp_ctx, &reader, &read_numbers), EOK);
+    assert_non_null(read_numbers);
+    assert_int_equal(talloc_array_length(read_numbers), 3);
+    for (i = 0; i < 3; i++) {
+        assert_int_equal(read_numbers[i], numbers[i]);
+    }
+
+    /* Empty arrays are read as NULL, same as with D-Bus. */
+    assert_int_equal(sbus_frame_read_au(tmp_ctx, &reader, &read_numbers), EOK);
+    assert_null(read_numbers);
+
+    assert_int_equal(sbus_frame_read_as(tmp_ctx, &reader, &read_strings), EOK);
+    for (i = 0; strings[i] != NULL; i++) {
+        assert_string_equal(read_strings[i], strings[i]);
+    }
+    assert_null(read_strings[i]);
+
+    assert_int_equal(sbus_frame_read_aS(tmp_ctx, &reader, &copied_strings),
+                     EOK);
+    for (i = 0; strings[i] != NULL; i++) {
+        assert_string_equal(copied_strings[i], strings[i]);
+        assert_true(talloc_parent(copied_strings[i]) == copied_strings);
+    }
+    assert_null(copied_strings[i]);
+
+    assert_true(sbus_frame_reader_done(&reader));
+
+    talloc_free(tmp_ctx);
+}
+
+void test_sbus_frame_truncated(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_frame_writer *writer;
+    struct sbus_frame_reader reader;
+    uint32_t *numbers;
+    const char *str;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    writer = sbus_frame_writer_create(tmp_ctx);
+    assert_non_null(writer);
+
+    assert_int_equal(sbus_frame_write_s(writer, "string"), EOK);
+    frame_finish(writer, &reader);
+
+    /* The length is read but the string is cut short. */
+    reader.length -= 2;
+    ret = sbus_frame_read_s(tmp_ctx, &reader, &str);
+    assert_int_equal(ret, ERR_SBUS_INVALID_TYPE);
+
+    /* Array length does not match the remaining payload. */
+    writer = sbus_frame_writer_create(tmp_ctx);
+    assert_non_null(writer);
+
+    assert_int_equal(sbus_frame_write_u(writer, 1000), EOK);
+    frame_finish(writer, &reader);
+
+    ret = sbus_frame_read_au(tmp_ctx, &reader, &numbers);
+    assert_int_equal(ret, ERR_SBUS_INVALID_TYPE);
+
+    talloc_free(tmp_ctx);
+}
+
+struct echo_state {
+    uint32_t number;
+    const char *str;
+};
+
+static struct tevent_req *echo_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct sbus_frame_reader *in,
+                                    void *data)
+{
+    struct echo_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct echo_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    ret = sbus_frame_read_u(in, &state->number);
+    if (ret == EOK) {
+        ret = sbus_frame_read_s(state, in, &state->str);
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+    } else {
+        tevent_req_done(req);
+    }
+
+    return tevent_req_post(req, ev);
+}
+
+static errno_t echo_recv(TALLOC_CTX *mem_ctx,
+                         struct tevent_req *req,
+                         struct sbus_frame_writer *out)
+{
+    struct echo_state *state;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct echo_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    ret = sbus_frame_write_u(out, state->number + 1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sbus_frame_write_s(out, state->str);
+}
+
+static const struct sbus_frame_method test_methods[] = {
+    {TEST_IFACE, "Echo", echo_send, echo_recv, NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static errno_t test_call(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct sbus_frame_conn *conn,
+                         const char *method,
+                         uint32_t number,
+                         const char *str,
+                         struct sbus_frame_reader **_reply)
+{
+    struct sbus_frame_writer *writer;
+    struct tevent_req *req;
+    errno_t ret;
+
+    writer = sbus_frame_call_writer(mem_ctx, TEST_IFACE, method);
+    assert_non_null(writer);
+    assert_int_equal(sbus_frame_write_u(writer, number), EOK);
+    assert_int_equal(sbus_frame_write_s(writer, str), EOK);
+
+    req = sbus_frame_call_send(mem_ctx, conn, writer);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, ev));
+
+    ret = sbus_frame_call_recv(mem_ctx, req, _reply);
+    talloc_free(req);
+
+    return ret;
+}
+
+void test_sbus_frame_connect_nosup(void **state)
+{
+    struct tevent_context *ev;
+    struct sbus_frame_conn *conn;
+    struct tevent_req *req;
+    errno_t ret;
+
+    ev = tevent_context_init(NULL);
+    assert_non_null(ev);
+
+    /* Nothing listens there, the caller is told to keep using D-Bus. */
+    unlink(TEST_SOCKET);
+    req = sbus_frame_connect_send(ev, ev, TEST_SOCKET);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, ev));
+
+    ret = sbus_frame_connect_recv(ev, req, &conn);
+    assert_int_equal(ret, ERR_SBUS_NOSUP);
+
+    talloc_free(ev);
+}
+
+void test_sbus_frame_call(void **state)
+{
+    struct tevent_context *ev;
+    struct sbus_frame_server *server;
+    struct sbus_frame_reader *reply;
+    struct sbus_frame_conn *conn;
+    struct tevent_req *req;
+    const char *str;
+    uint32_t number;
+    errno_t ret;
+
+    ev = tevent_context_init(NULL);
+    assert_non_null(ev);
+
+    ret = sbus_frame_server_create(ev, ev, TEST_SOCKET, geteuid(), getegid(),
+                                   test_methods, &server);
+    assert_int_equal(ret, EOK);
+
+    req = sbus_frame_connect_send(ev, ev, TEST_SOCKET);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, ev));
+
+    ret = sbus_frame_connect_recv(ev, req, &conn);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+
+    ret = test_call(ev, ev, conn, "Echo", 41, "hello", &reply);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(sbus_frame_read_u(reply, &number), EOK);
+    assert_int_equal(number, 42);
+    assert_int_equal(sbus_frame_read_s(reply, reply, &str), EOK);
+    assert_string_equal(str, "hello");
+    assert_true(sbus_frame_reader_done(reply));
+    talloc_free(reply);
+
+    /* The connection is still usable after an error reply. */
+    ret = test_call(ev, ev, conn, "Unknown", 1, "", &reply);
+    assert_int_equal(ret, ERR_SBUS_UNKNOWN_INTERFACE);
+
+    ret = test_call(ev, ev, conn, "Echo", 1, "again", &reply);
+    assert_int_equal(ret, EOK);
+    talloc_free(reply);
+
+    /* The server goes away, pending and later calls fail. */
+    talloc_free(server);
+
+    ret = test_call(ev, ev, conn, "Echo", 1, "gone", &reply);
+    assert_int_not_equal(ret, EOK);
+
+    ret = test_call(ev, ev, conn, "Echo", 1, "gone", &reply);
+    assert_int_equal(ret, ENOTCONN);
+
+    talloc_free(ev);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sbus_frame_basic),
+        cmocka_unit_test(test_sbus_frame_arrays),
+        cmocka_unit_test(test_sbus_frame_truncated),
+        cmocka_unit_test(test_sbus_frame_connect_nosup),
+        cmocka_unit_test(test_sbus_frame_call)
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
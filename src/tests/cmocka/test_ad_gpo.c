@@ -329,6 +329,98 @@ void test_ad_gpo_ace_includes_client_sid_false(void **state)
                                         ace_dom_sid, false);
 }
 
+void test_ad_gpo_decision_key(void **state)
+{
+    const char *user_sid = "S-1-5-21-1175337206-4250576914-2321192831-1103";
+    const char *groups1[] = {"S-1-5-21-2-3-4", "S-1-5-21-2-3-5"};
+    const char *groups2[] = {"S-1-5-21-2-3-5", "S-1-5-21-2-3-4"};
+    char *key1;
+    char *key2;
+
+    key1 = ad_gpo_decision_key(test_ctx, GPO_MAP_INTERACTIVE, "host",
+                               user_sid, groups1, 2);
+    assert_non_null(key1);
+
+    /* the group order does not matter */
+    key2 = ad_gpo_decision_key(test_ctx, GPO_MAP_INTERACTIVE, "host",
+                               user_sid, groups2, 2);
+    assert_non_null(key2);
+    assert_string_equal(key1, key2);
+    talloc_free(key2);
+
+    /* different rights and group sets do */
+    key2 = ad_gpo_decision_key(test_ctx, GPO_MAP_NETWORK, "host",
+                               user_sid, groups1, 2);
+    assert_non_null(key2);
+    assert_string_not_equal(key1, key2);
+    talloc_free(key2);
+
+    key2 = ad_gpo_decision_key(test_ctx, GPO_MAP_INTERACTIVE, "host",
+                               user_sid, groups1, 1);
+    assert_non_null(key2);
+    assert_string_not_equal(key1, key2);
+    talloc_free(key2);
+
+    talloc_free(key1);
+}
+
+void test_ad_gpo_decision_cache(void **state)
+{
+    struct ad_access_ctx *ctx;
+    struct gp_gpo gpo;
+    struct gp_gpo *gpos[] = { &gpo, NULL };
+    char *fingerprint;
+    errno_t result;
+    errno_t ret;
+
+    ctx = talloc_zero(test_ctx, struct ad_access_ctx);
+    assert_non_null(ctx);
+    ctx->gpo_decision_timeout = 30;
+    ret = sss_hash_create(ctx, 0, &ctx->gpo_decision_table);
+    assert_int_equal(ret, EOK);
+
+    memset(&gpo, 0, sizeof(gpo));
+    gpo.gpo_guid = "{31B2F340-016D-11D2-945F-00C04FB984F9}";
+    gpo.gpo_version = 3;
+    gpo.gpo_when_changed = "20260101000000.0Z";
+
+    fingerprint = ad_gpo_fingerprint(ctx, gpos, 1);
+    assert_non_null(fingerprint);
+    ret = ad_gpo_decision_set_fingerprint(ctx, fingerprint);
+    assert_int_equal(ret, EOK);
+
+    assert_false(ad_gpo_decision_lookup(ctx, "key", &result));
+
+    ad_gpo_decision_store(ctx, "key", fingerprint, ERR_ACCESS_DENIED);
+    assert_true(ad_gpo_decision_lookup(ctx, "key", &result));
+    assert_int_equal(result, ERR_ACCESS_DENIED);
+
+    /* the same GPOs keep the decisions */
+    ret = ad_gpo_decision_set_fingerprint(ctx, fingerprint);
+    assert_int_equal(ret, EOK);
+    assert_true(ad_gpo_decision_lookup(ctx, "key", &result));
+
+    /* a new version of the GPO drops them */
+    gpo.gpo_version = 4;
+    talloc_free(fingerprint);
+    fingerprint = ad_gpo_fingerprint(ctx, gpos, 1);
+    assert_non_null(fingerprint);
+    ret = ad_gpo_decision_set_fingerprint(ctx, fingerprint);
+    assert_int_equal(ret, EOK);
+    assert_false(ad_gpo_decision_lookup(ctx, "key", &result));
+
+    /* decisions made with old GPOs are not used */
+    ad_gpo_decision_store(ctx, "key", "stale", EOK);
+    assert_false(ad_gpo_decision_lookup(ctx, "key", &result));
+
+    /* neither are expired ones */
+    ctx->gpo_decision_timeout = 0;
+    ad_gpo_decision_store(ctx, "key", fingerprint, EOK);
+    assert_false(ad_gpo_decision_lookup(ctx, "key", &result));
+
+    talloc_free(ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -364,6 +456,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_ad_gpo_ace_includes_client_sid_false,
                                         ad_gpo_test_setup,
                                         ad_gpo_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ad_gpo_decision_key,
+                                        ad_gpo_test_setup,
+                                        ad_gpo_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ad_gpo_decision_cache,
+                                        ad_gpo_test_setup,
+                                        ad_gpo_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
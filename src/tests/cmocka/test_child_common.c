@@ -450,6 +450,210 @@ static void echo_child_read_done(struct tevent_req *subreq)
     echo_state->child_test_ctx->test_ctx->done = true;
 }
 
+#define FRAME_STR_1 "First frame"
+#define FRAME_STR_2 "Second frame"
+
+static void pipe_frame_write_done(struct tevent_req *subreq);
+static void pipe_frame_read_done(struct tevent_req *subreq);
+
+struct pipe_frame_test_state {
+    struct child_test_ctx *child_tctx;
+    int writes;
+    int reads;
+};
+
+/* Two frames in the pipe must be read one by one */
+void test_pipe_frame(void **state)
+{
+    errno_t ret;
+    struct child_test_ctx *child_tctx = talloc_get_type(*state,
+                                                        struct child_test_ctx);
+    struct pipe_frame_test_state *frame_state;
+    struct tevent_req *subreq;
+
+    frame_state = talloc_zero(child_tctx, struct pipe_frame_test_state);
+    assert_non_null(frame_state);
+    frame_state->child_tctx = child_tctx;
+
+    sss_fd_nonblocking(child_tctx->pipefd_to_child[0]);
+    sss_fd_nonblocking(child_tctx->pipefd_to_child[1]);
+
+    subreq = write_pipe_frame_send(frame_state, child_tctx->test_ctx->ev,
+                                   (uint8_t *) FRAME_STR_1,
+                                   sizeof(FRAME_STR_1),
+                                   child_tctx->pipefd_to_child[1]);
+    assert_non_null(subreq);
+    tevent_req_set_callback(subreq, pipe_frame_write_done, frame_state);
+
+    ret = test_ev_loop(child_tctx->test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(frame_state->reads, 2);
+
+    talloc_free(frame_state);
+    PIPE_CLOSE(child_tctx->pipefd_to_child);
+    PIPE_CLOSE(child_tctx->pipefd_from_child);
+}
+
+static void pipe_frame_write_done(struct tevent_req *subreq)
+{
+    struct pipe_frame_test_state *frame_state;
+    struct child_test_ctx *child_tctx;
+    errno_t ret;
+
+    frame_state = tevent_req_callback_data(subreq,
+                                           struct pipe_frame_test_state);
+    child_tctx = frame_state->child_tctx;
+
+    ret = write_pipe_frame_recv(subreq);
+    talloc_zfree(subreq);
+    assert_int_equal(ret, EOK);
+    frame_state->writes++;
+
+    if (frame_state->writes == 1) {
+        subreq = write_pipe_frame_send(frame_state, child_tctx->test_ctx->ev,
+                                       (uint8_t *) FRAME_STR_2,
+                                       sizeof(FRAME_STR_2),
+                                       child_tctx->pipefd_to_child[1]);
+    } else {
+        subreq = read_pipe_frame_send(frame_state, child_tctx->test_ctx->ev,
+                                      child_tctx->pipefd_to_child[0]);
+        assert_non_null(subreq);
+        tevent_req_set_callback(subreq, pipe_frame_read_done, frame_state);
+        return;
+    }
+    assert_non_null(subreq);
+    tevent_req_set_callback(subreq, pipe_frame_write_done, frame_state);
+}
+
+static void pipe_frame_read_done(struct tevent_req *subreq)
+{
+    struct pipe_frame_test_state *frame_state;
+    struct child_test_ctx *child_tctx;
+    errno_t ret;
+    ssize_t len;
+    uint8_t *buf;
+
+    frame_state = tevent_req_callback_data(subreq,
+                                           struct pipe_frame_test_state);
+    child_tctx = frame_state->child_tctx;
+
+    ret = read_pipe_frame_recv(subreq, frame_state, &buf, &len);
+    talloc_zfree(subreq);
+    assert_int_equal(ret, EOK);
+    frame_state->reads++;
+
+    if (frame_state->reads == 1) {
+        assert_int_equal(len, sizeof(FRAME_STR_1));
+        assert_string_equal(buf, FRAME_STR_1);
+        talloc_free(buf);
+
+        subreq = read_pipe_frame_send(frame_state, child_tctx->test_ctx->ev,
+                                      child_tctx->pipefd_to_child[0]);
+        assert_non_null(subreq);
+        tevent_req_set_callback(subreq, pipe_frame_read_done, frame_state);
+        return;
+    }
+
+    assert_int_equal(len, sizeof(FRAME_STR_2));
+    assert_string_equal(buf, FRAME_STR_2);
+    talloc_free(buf);
+
+    child_tctx->test_ctx->done = true;
+}
+
+#define POOL_STR "Hello worker"
+
+struct child_pool_test_state {
+    struct child_test_ctx *child_tctx;
+    struct sss_child_pool *pool;
+    pid_t pids[3];
+    int requests;
+};
+
+static void child_pool_done(struct tevent_req *subreq);
+
+/* One worker serves two requests and is replaced by a new one then */
+void test_child_pool(void **state)
+{
+    errno_t ret;
+    struct child_test_ctx *child_tctx = talloc_get_type(*state,
+                                                        struct child_test_ctx);
+    struct child_pool_test_state *pool_state;
+    struct tevent_req *subreq;
+
+    setenv("TEST_CHILD_ACTION", "worker", 1);
+
+    pool_state = talloc_zero(child_tctx, struct child_pool_test_state);
+    assert_non_null(pool_state);
+    pool_state->child_tctx = child_tctx;
+
+    ret = sss_child_pool_init(pool_state, child_tctx->test_ctx->ev,
+                              CHILD_DIR"/"TEST_BIN, 2, NULL, 1, 2, 10,
+                              &pool_state->pool);
+    assert_int_equal(ret, EOK);
+
+    subreq = sss_child_pool_send(pool_state, child_tctx->test_ctx->ev,
+                                 pool_state->pool, (uint8_t *) POOL_STR,
+                                 sizeof(POOL_STR));
+    assert_non_null(subreq);
+    tevent_req_set_callback(subreq, child_pool_done, pool_state);
+
+    /* The only worker is busy with the first request */
+    subreq = sss_child_pool_send(pool_state, child_tctx->test_ctx->ev,
+                                 pool_state->pool, (uint8_t *) POOL_STR,
+                                 sizeof(POOL_STR));
+    assert_non_null(subreq);
+    assert_true(tevent_req_poll(subreq, child_tctx->test_ctx->ev));
+    ret = sss_child_pool_recv(subreq, NULL, NULL, NULL);
+    assert_int_equal(ret, EBUSY);
+    talloc_free(subreq);
+
+    ret = test_ev_loop(child_tctx->test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(pool_state->requests, 3);
+
+    assert_int_equal(pool_state->pids[0], pool_state->pids[1]);
+    assert_int_not_equal(pool_state->pids[1], pool_state->pids[2]);
+
+    talloc_free(pool_state);
+    PIPE_CLOSE(child_tctx->pipefd_to_child);
+    PIPE_CLOSE(child_tctx->pipefd_from_child);
+}
+
+static void child_pool_done(struct tevent_req *subreq)
+{
+    struct child_pool_test_state *pool_state;
+    struct child_test_ctx *child_tctx;
+    errno_t ret;
+    ssize_t len;
+    uint8_t *buf;
+
+    pool_state = tevent_req_callback_data(subreq,
+                                          struct child_pool_test_state);
+    child_tctx = pool_state->child_tctx;
+
+    ret = sss_child_pool_recv(subreq, pool_state, &buf, &len);
+    talloc_zfree(subreq);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(len, sizeof(pid_t) + sizeof(POOL_STR));
+    assert_string_equal(buf + sizeof(pid_t), POOL_STR);
+
+    memcpy(&pool_state->pids[pool_state->requests], buf, sizeof(pid_t));
+    talloc_free(buf);
+    pool_state->requests++;
+
+    if (pool_state->requests == 3) {
+        child_tctx->test_ctx->done = true;
+        return;
+    }
+
+    subreq = sss_child_pool_send(pool_state, child_tctx->test_ctx->ev,
+                                 pool_state->pool, (uint8_t *) POOL_STR,
+                                 sizeof(POOL_STR));
+    assert_non_null(subreq);
+    tevent_req_set_callback(subreq, child_pool_done, pool_state);
+}
+
 void sss_child_cb(int pid, int wait_status, void *pvt);
 
 /* Just make sure the exec works. The child does nothing but exits */
@@ -530,6 +734,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sss_child,
                                         child_test_setup,
                                         child_test_teardown),
+        cmocka_unit_test_setup_teardown(test_pipe_frame,
+                                        child_test_setup,
+                                        child_test_teardown),
+        cmocka_unit_test_setup_teardown(test_child_pool,
+                                        child_test_setup,
+                                        child_test_teardown),
         cmocka_unit_test_setup_teardown(test_exec_child_only_extra_args,
                                         only_extra_args_setup,
                                         only_extra_args_teardown),
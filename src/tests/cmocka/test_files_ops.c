@@ -0,0 +1,451 @@
+/*
+    SSSD
+
+    Tests for the reload of the files provider cache
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <errno.h>
+#include <popt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+
+/* Including private file makes it easier to test with static functions */
+#include "providers/files/files_ops.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_files_ops_conf.ldb"
+#define TEST_DOM_NAME "files_ops_test"
+#define TEST_ID_PROVIDER "files"
+
+#define TEST_PASSWD_FILE TESTS_PATH"/passwd"
+#define TEST_GROUP_FILE TESTS_PATH"/group"
+
+/* Set on the cached entries to find out whether they were written again */
+#define TEST_MARKER "testMarker"
+
+/* Only the reload itself is tested, the data provider is not running */
+errno_t dp_add_sr_attribute(struct be_ctx *be_ctx)
+{
+    return EOK;
+}
+
+void dp_sbus_domain_active(struct data_provider *provider,
+                           struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_domain_inconsistent(struct data_provider *provider,
+                                 struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_reset_users_ncache(struct data_provider *provider,
+                                struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_reset_groups_ncache(struct data_provider *provider,
+                                 struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_reset_users_memcache(struct data_provider *provider)
+{
+}
+
+void dp_sbus_reset_groups_memcache(struct data_provider *provider)
+{
+}
+
+void dp_sbus_reset_initgr_memcache(struct data_provider *provider)
+{
+}
+
+void files_account_info_finished(struct files_id_ctx *id_ctx,
+                                 int req_type,
+                                 errno_t ret)
+{
+}
+
+struct files_ops_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct files_id_ctx *id_ctx;
+};
+
+static void write_file(const char *path, const char *content)
+{
+    FILE *f;
+
+    f = fopen(path, "w");
+    assert_non_null(f);
+    assert_true(fputs(content, f) >= 0);
+    assert_int_equal(fclose(f), 0);
+}
+
+static int files_ops_test_setup(void **state)
+{
+    struct files_ops_test_ctx *test_ctx;
+    static const char *passwd_files[] = { TEST_PASSWD_FILE, NULL };
+    static const char *group_files[] = { TEST_GROUP_FILE, NULL };
+
+    test_ctx = talloc_zero(NULL, struct files_ops_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME,
+                                         TEST_ID_PROVIDER, NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->id_ctx = talloc_zero(test_ctx, struct files_id_ctx);
+    assert_non_null(test_ctx->id_ctx);
+
+    test_ctx->id_ctx->domain = test_ctx->tctx->dom;
+    test_ctx->id_ctx->passwd_files = passwd_files;
+    test_ctx->id_ctx->group_files = group_files;
+
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:10001:10001:User 1:/home/user1:/bin/bash\n"
+               "user2:x:10002:10002:User 2:/home/user2:/bin/bash\n"
+               "user3:x:10003:10003:User 3:/home/user3:/bin/bash\n");
+    write_file(TEST_GROUP_FILE,
+               "group1:x:20001:user1\n"
+               "group2:x:20002:user1,user2\n"
+               "group3:x:20003:user3,ghost1\n");
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int files_ops_test_teardown(void **state)
+{
+    struct files_ops_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct files_ops_test_ctx);
+
+    unlink(TEST_PASSWD_FILE);
+    unlink(TEST_GROUP_FILE);
+
+    talloc_free(test_ctx);
+    return 0;
+}
+
+static void set_marker(struct files_ops_test_ctx *test_ctx,
+                       const char *shortname, bool is_user)
+{
+    struct sysdb_attrs *attrs;
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(test_ctx, shortname,
+                                        test_ctx->tctx->dom->name);
+    assert_non_null(fqname);
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_string(attrs, TEST_MARKER, "1");
+    assert_int_equal(ret, EOK);
+
+    if (is_user) {
+        ret = sysdb_set_user_attr(test_ctx->tctx->dom, fqname, attrs,
+                                  SYSDB_MOD_REP);
+    } else {
+        ret = sysdb_set_group_attr(test_ctx->tctx->dom, fqname, attrs,
+                                   SYSDB_MOD_REP);
+    }
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+    talloc_free(fqname);
+}
+
+static struct ldb_message *get_user(struct files_ops_test_ctx *test_ctx,
+                                    const char *shortname)
+{
+    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_SHELL,
+                            TEST_MARKER, NULL };
+    struct ldb_message *msg = NULL;
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(test_ctx, shortname,
+                                        test_ctx->tctx->dom->name);
+    assert_non_null(fqname);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->tctx->dom, fqname,
+                                    attrs, &msg);
+    talloc_free(fqname);
+    if (ret == ENOENT) {
+        return NULL;
+    }
+    assert_int_equal(ret, EOK);
+
+    return msg;
+}
+
+static struct ldb_message *get_group(struct files_ops_test_ctx *test_ctx,
+                                     const char *shortname)
+{
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, SYSDB_MEMBERUID,
+                            SYSDB_GHOST, TEST_MARKER, NULL };
+    struct ldb_message *msg = NULL;
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(test_ctx, shortname,
+                                        test_ctx->tctx->dom->name);
+    assert_non_null(fqname);
+
+    ret = sysdb_search_group_by_name(test_ctx, test_ctx->tctx->dom, fqname,
+                                     attrs, &msg);
+    talloc_free(fqname);
+    if (ret == ENOENT) {
+        return NULL;
+    }
+    assert_int_equal(ret, EOK);
+
+    return msg;
+}
+
+static bool has_marker(struct ldb_message *msg)
+{
+    return ldb_msg_find_attr_as_string(msg, TEST_MARKER, NULL) != NULL;
+}
+
+static unsigned int num_values(struct ldb_message *msg, const char *attr)
+{
+    struct ldb_message_element *el;
+
+    el = ldb_msg_find_element(msg, attr);
+    return el == NULL ? 0 : el->num_values;
+}
+
+/* Enumerate the initial files and mark every cached entry */
+static void enum_initial_files(struct files_ops_test_ctx *test_ctx)
+{
+    struct ldb_message *msg;
+    errno_t ret;
+
+    ret = sf_enum_files(test_ctx->id_ctx, SF_UPDATE_BOTH);
+    assert_int_equal(ret, EOK);
+
+    msg = get_group(test_ctx, "group3");
+    assert_non_null(msg);
+    assert_int_equal(num_values(msg, SYSDB_MEMBERUID), 1);
+    assert_int_equal(num_values(msg, SYSDB_GHOST), 1);
+    talloc_free(msg);
+
+    set_marker(test_ctx, "user1", true);
+    set_marker(test_ctx, "user2", true);
+    set_marker(test_ctx, "user3", true);
+    set_marker(test_ctx, "group1", false);
+    set_marker(test_ctx, "group2", false);
+    set_marker(test_ctx, "group3", false);
+}
+
+static void test_incremental_reload_users(void **state)
+{
+    struct files_ops_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct files_ops_test_ctx);
+    test_ctx->id_ctx->incremental_reload = true;
+
+    enum_initial_files(test_ctx);
+
+    /* user1 is kept, user2 is removed, user3 loses its shell and
+     * user4 is added */
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:10001:10001:User 1:/home/user1:/bin/bash\n"
+               "user3:x:10003:10003:User 3:/home/user3:\n"
+               "user4:x:10004:10004:User 4:/home/user4:/bin/bash\n");
+
+    ret = sf_enum_files(test_ctx->id_ctx, SF_UPDATE_PASSWD);
+    assert_int_equal(ret, EOK);
+
+    /* Unchanged users are not written again */
+    msg = get_user(test_ctx, "user1");
+    assert_non_null(msg);
+    assert_true(has_marker(msg));
+    assert_string_equal(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL),
+                        "/bin/bash");
+    talloc_free(msg);
+
+    assert_null(get_user(test_ctx, "user2"));
+
+    /* Changed users are updated in place */
+    msg = get_user(test_ctx, "user3");
+    assert_non_null(msg);
+    assert_true(has_marker(msg));
+    assert_null(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL));
+    talloc_free(msg);
+
+    msg = get_user(test_ctx, "user4");
+    assert_non_null(msg);
+    assert_false(has_marker(msg));
+    assert_int_equal(ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0),
+                     10004);
+    talloc_free(msg);
+}
+
+static void test_incremental_reload_groups(void **state)
+{
+    struct files_ops_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct files_ops_test_ctx);
+    test_ctx->id_ctx->incremental_reload = true;
+
+    enum_initial_files(test_ctx);
+
+    /* group1 is kept, group2 loses a member, group3 loses its ghost
+     * member, group4 is added and nothing is removed */
+    write_file(TEST_GROUP_FILE,
+               "group1:x:20001:user1\n"
+               "group2:x:20002:user1\n"
+               "group3:x:20003:user3\n"
+               "group4:x:20004:user2\n");
+
+    ret = sf_enum_files(test_ctx->id_ctx, SF_UPDATE_GROUP);
+    assert_int_equal(ret, EOK);
+
+    msg = get_group(test_ctx, "group1");
+    assert_non_null(msg);
+    assert_true(has_marker(msg));
+    assert_int_equal(num_values(msg, SYSDB_MEMBERUID), 1);
+    talloc_free(msg);
+
+    /* Changed groups are stored again without the removed members */
+    msg = get_group(test_ctx, "group2");
+    assert_non_null(msg);
+    assert_false(has_marker(msg));
+    assert_int_equal(num_values(msg, SYSDB_MEMBERUID), 1);
+    talloc_free(msg);
+
+    msg = get_group(test_ctx, "group3");
+    assert_non_null(msg);
+    assert_false(has_marker(msg));
+    assert_int_equal(num_values(msg, SYSDB_MEMBERUID), 1);
+    assert_int_equal(num_values(msg, SYSDB_GHOST), 0);
+    talloc_free(msg);
+
+    msg = get_group(test_ctx, "group4");
+    assert_non_null(msg);
+    assert_int_equal(ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0),
+                     20004);
+    assert_int_equal(num_values(msg, SYSDB_MEMBERUID), 1);
+    talloc_free(msg);
+
+    /* A removed group is deleted */
+    write_file(TEST_GROUP_FILE,
+               "group1:x:20001:user1\n");
+
+    ret = sf_enum_files(test_ctx->id_ctx, SF_UPDATE_GROUP);
+    assert_int_equal(ret, EOK);
+
+    assert_non_null(get_group(test_ctx, "group1"));
+    assert_null(get_group(test_ctx, "group2"));
+    assert_null(get_group(test_ctx, "group4"));
+}
+
+static void test_full_reload(void **state)
+{
+    struct files_ops_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct files_ops_test_ctx);
+    test_ctx->id_ctx->incremental_reload = false;
+
+    enum_initial_files(test_ctx);
+
+    ret = sf_enum_files(test_ctx->id_ctx, SF_UPDATE_BOTH);
+    assert_int_equal(ret, EOK);
+
+    /* Every entry is stored again even if nothing changed */
+    msg = get_user(test_ctx, "user1");
+    assert_non_null(msg);
+    assert_false(has_marker(msg));
+    talloc_free(msg);
+
+    msg = get_group(test_ctx, "group1");
+    assert_non_null(msg);
+    assert_false(has_marker(msg));
+    talloc_free(msg);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    int no_cleanup = 0;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_incremental_reload_users,
+                                        files_ops_test_setup,
+                                        files_ops_test_teardown),
+        cmocka_unit_test_setup_teardown(test_incremental_reload_groups,
+                                        files_ops_test_setup,
+                                        files_ops_test_teardown),
+        cmocka_unit_test_setup_teardown(test_full_reload,
+                                        files_ops_test_setup,
+                                        files_ops_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+    return rv;
+}
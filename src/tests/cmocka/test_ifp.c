@@ -264,6 +264,64 @@ void test_attr_allowed(void **state)
     assert_false(ifp_attr_allowed(NULL, "name"));
 }
 
+void test_list_cursor(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom1;
+    struct sss_domain_info *dom2;
+    struct sss_domain_info *dom;
+    char *cursor;
+    char *name;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    dom1 = talloc_zero(tmp_ctx, struct sss_domain_info);
+    assert_non_null(dom1);
+    dom1->name = "first";
+
+    dom2 = talloc_zero(tmp_ctx, struct sss_domain_info);
+    assert_non_null(dom2);
+    dom2->name = "second";
+    dom1->next = dom2;
+
+    /* empty cursor starts at the beginning */
+    cursor = ifp_list_cursor_compose(tmp_ctx, NULL, NULL);
+    assert_string_equal(cursor, "");
+
+    ret = ifp_list_cursor_parse(tmp_ctx, dom1, cursor, &dom, &name);
+    assert_int_equal(ret, EOK);
+    assert_null(dom);
+    assert_null(name);
+
+    /* start of a domain */
+    cursor = ifp_list_cursor_compose(tmp_ctx, dom2, NULL);
+    assert_string_equal(cursor, "second/");
+
+    ret = ifp_list_cursor_parse(tmp_ctx, dom1, cursor, &dom, &name);
+    assert_int_equal(ret, EOK);
+    assert_ptr_equal(dom, dom2);
+    assert_null(name);
+
+    /* names may contain the separator */
+    cursor = ifp_list_cursor_compose(tmp_ctx, dom1, "a/b@first");
+    assert_string_equal(cursor, "first/a/b@first");
+
+    ret = ifp_list_cursor_parse(tmp_ctx, dom1, cursor, &dom, &name);
+    assert_int_equal(ret, EOK);
+    assert_ptr_equal(dom, dom1);
+    assert_string_equal(name, "a/b@first");
+
+    ret = ifp_list_cursor_parse(tmp_ctx, dom1, "first", &dom, &name);
+    assert_int_equal(ret, EINVAL);
+
+    ret = ifp_list_cursor_parse(tmp_ctx, dom1, "third/user", &dom, &name);
+    assert_int_equal(ret, ERR_DOMAIN_NOT_FOUND);
+
+    talloc_free(tmp_ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -279,6 +337,7 @@ int main(int argc, const char *argv[])
         cmocka_unit_test(test_attr_acl),
         cmocka_unit_test(test_attr_acl_ex),
         cmocka_unit_test(test_attr_allowed),
+        cmocka_unit_test(test_list_cursor),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -270,6 +270,226 @@ static void test_kcm_ccache_no_princ(void **state)
     assert_cc_equal(cc, cc2);
 }
 
+static void assert_cc_creds_equal(struct kcm_ccache *cc1,
+                                  struct kcm_ccache *cc2)
+{
+    struct kcm_cred *crd1;
+    struct kcm_cred *crd2;
+    struct sss_iobuf *blob1;
+    struct sss_iobuf *blob2;
+    uuid_t u1, u2;
+    errno_t ret;
+
+    for (crd1 = kcm_cc_get_cred(cc1), crd2 = kcm_cc_get_cred(cc2);
+         crd1 != NULL && crd2 != NULL;
+         crd1 = kcm_cc_next_cred(crd1), crd2 = kcm_cc_next_cred(crd2)) {
+        ret = kcm_cred_get_uuid(crd1, u1);
+        assert_int_equal(ret, EOK);
+        ret = kcm_cred_get_uuid(crd2, u2);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(uuid_compare(u1, u2), 0);
+
+        blob1 = kcm_cred_get_creds(crd1);
+        blob2 = kcm_cred_get_creds(crd2);
+        assert_int_equal(sss_iobuf_get_size(blob1),
+                         sss_iobuf_get_size(blob2));
+        assert_memory_equal(sss_iobuf_get_data(blob1),
+                            sss_iobuf_get_data(blob2),
+                            sss_iobuf_get_size(blob1));
+    }
+
+    assert_null(crd1);
+    assert_null(crd2);
+}
+
+static struct sss_iobuf *test_cred_blob(TALLOC_CTX *mem_ctx,
+                                        const char *data)
+{
+    struct sss_iobuf *blob;
+
+    blob = sss_iobuf_init_readonly(mem_ctx,
+                                   (const uint8_t *) data,
+                                   strlen(data) + 1);
+    assert_non_null(blob);
+    return blob;
+}
+
+static void test_kcm_ccache_binary_marshall_unmarshall(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct sss_iobuf *payload;
+    const char *name;
+    const char *key;
+    uuid_t uuid;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     test_ctx->princ,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_store_cred_blob(cc, test_cred_blob(cc, TEST_CREDS"1"));
+    assert_int_equal(ret, EOK);
+    ret = kcm_cc_store_cred_blob(cc, test_cred_blob(cc, TEST_CREDS"2"));
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_ccache_to_sec_binary(test_ctx, cc, &payload);
+    assert_int_equal(ret, EOK);
+    assert_true(sec_binary_is_ccache(payload));
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    ret = sec_binary_to_ccache(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+    assert_cc_creds_equal(cc, cc2);
+
+    /* A truncated ccache must be rejected */
+    payload = sss_iobuf_init_readonly(test_ctx,
+                                      sss_iobuf_get_data(payload),
+                                      sss_iobuf_get_size(payload) - 1);
+    assert_non_null(payload);
+
+    ret = sec_binary_to_ccache(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EINVAL);
+}
+
+static void test_kcm_ccache_binary_no_princ(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct sss_iobuf *payload;
+    const char *name;
+    const char *key;
+    uuid_t uuid;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     NULL,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_ccache_to_sec_binary(test_ctx, cc, &payload);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    ret = sec_binary_to_ccache(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+    assert_null(kcm_cc_get_cred(cc2));
+}
+
+static void test_kcm_ccache_binary_modify(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct sss_iobuf *payload;
+    struct sss_iobuf *json;
+    struct sss_iobuf *blob;
+    const char *name;
+    const char *key;
+    struct kcm_mod_ctx mod_ctx;
+    uuid_t uuid;
+    uuid_t cred_uuid;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     test_ctx->princ,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_store_cred_blob(cc, test_cred_blob(cc, TEST_CREDS"1"));
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_ccache_to_sec_binary(test_ctx, cc, &payload);
+    assert_int_equal(ret, EOK);
+
+    /* Append a credential and change the offset of the stored ccache,
+     * then do the same with the ccache itself */
+    blob = test_cred_blob(test_ctx, TEST_CREDS"2");
+    uuid_generate(cred_uuid);
+    ret = sec_binary_append_cred(test_ctx, payload, cred_uuid, blob,
+                                 &payload);
+    assert_int_equal(ret, EOK);
+
+    ret = sec_binary_set_offset(payload, 42);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_store_creds(cc, kcm_cred_new(cc, cred_uuid, blob));
+    assert_int_equal(ret, EOK);
+    kcm_mod_ctx_clear(&mod_ctx);
+    mod_ctx.kdc_offset = 42;
+    kcm_mod_cc(cc, &mod_ctx);
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    ret = sec_binary_to_ccache(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+    assert_cc_creds_equal(cc, cc2);
+
+    /* JSON ccaches are not patched in place */
+    ret = kcm_ccache_to_sec_input(test_ctx, cc, &owner, &json);
+    assert_int_equal(ret, EOK);
+    assert_false(sec_binary_is_ccache(json));
+
+    ret = sec_binary_set_offset(json, 0);
+    assert_int_equal(ret, EINVAL);
+
+    ret = sec_binary_append_cred(test_ctx, json, cred_uuid, blob, &payload);
+    assert_int_equal(ret, EINVAL);
+}
+
 void test_sec_key_get_uuid(void **state)
 {
     errno_t ret;
@@ -346,6 +566,15 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_kcm_ccache_no_princ,
                                         setup_kcm_marshalling,
                                         teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_binary_marshall_unmarshall,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_binary_no_princ,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_binary_modify,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
         cmocka_unit_test(test_sec_key_get_uuid),
         cmocka_unit_test(test_sec_key_get_name),
         cmocka_unit_test(test_sec_key_match_name),
@@ -0,0 +1,371 @@
+/*
+    SSSD
+
+    Tests for the write-back mode of the KCM secdb back end
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+
+#include "responder/kcm/kcmsrv_ccache_secdb.c"
+
+#define TEST_REALM                "TESTREALM"
+#define TEST_PRINC_COMPONENT      "PRINC_NAME"
+#define TEST_CREDS                "TESTCREDS"
+
+const struct kcm_ccdb_ops ccdb_mem_ops;
+const struct kcm_ccdb_ops ccdb_sec_ops;
+
+/* The database is never touched, every request and quota check is
+ * answered here. */
+errno_t __wrap_sss_sec_new_req(TALLOC_CTX *mem_ctx,
+                               struct sss_sec_ctx *sec_ctx,
+                               const char *url,
+                               uid_t client,
+                               struct sss_sec_req **_req)
+{
+    /* Stands in for the request, it is only passed to the wrappers */
+    *_req = (struct sss_sec_req *) talloc_strdup(mem_ctx, url);
+    return *_req == NULL ? ENOMEM : EOK;
+}
+
+errno_t __wrap_sss_sec_list(TALLOC_CTX *mem_ctx,
+                            struct sss_sec_req *req,
+                            char ***_keys,
+                            size_t *num_keys)
+{
+    /* The user has no ccaches in the database */
+    return ENOENT;
+}
+
+errno_t __wrap_sss_sec_check_quota(struct sss_sec_req *req,
+                                   int pending_secrets,
+                                   int pending_uid_secrets)
+{
+    check_expected(pending_secrets);
+    check_expected(pending_uid_secrets);
+
+    return sss_mock_type(errno_t);
+}
+
+errno_t __wrap_sss_sec_check_payload_size(struct sss_sec_req *req,
+                                          size_t secret_len)
+{
+    return sss_mock_type(errno_t);
+}
+
+static void will_check_quota(int pending, errno_t ret)
+{
+    expect_value(__wrap_sss_sec_check_quota, pending_secrets, pending);
+    expect_value(__wrap_sss_sec_check_quota, pending_uid_secrets, pending);
+    will_return(__wrap_sss_sec_check_quota, ret);
+}
+
+static void will_check_payload_size(errno_t ret)
+{
+    will_return(__wrap_sss_sec_check_payload_size, ret);
+}
+
+struct kcm_write_back_test_ctx {
+    struct tevent_context *ev;
+    krb5_context kctx;
+    krb5_principal princ;
+    struct cli_creds client;
+
+    struct kcm_ccdb *db;
+    struct ccdb_secdb *secdb;
+    struct kcm_ccache *cc;
+    uuid_t uuid;
+};
+
+static int setup_write_back(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx;
+    struct tevent_req *req;
+    krb5_error_code kerr;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct kcm_write_back_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    kerr = krb5_init_context(&test_ctx->kctx);
+    assert_int_equal(kerr, 0);
+
+    kerr = krb5_build_principal(test_ctx->kctx,
+                                &test_ctx->princ,
+                                sizeof(TEST_REALM)-1, TEST_REALM,
+                                TEST_PRINC_COMPONENT, NULL);
+    assert_int_equal(kerr, 0);
+
+    test_ctx->client.ucred.uid = getuid();
+    test_ctx->client.ucred.gid = getgid();
+
+    /* A write-back database without the confdb and the secrets
+     * database behind it */
+    test_ctx->db = talloc_zero(test_ctx, struct kcm_ccdb);
+    assert_non_null(test_ctx->db);
+    test_ctx->db->ev = test_ctx->ev;
+    test_ctx->db->ops = &ccdb_secdb_ops;
+
+    test_ctx->secdb = talloc_zero(test_ctx->db, struct ccdb_secdb);
+    assert_non_null(test_ctx->secdb);
+    test_ctx->secdb->index = sss_ptr_hash_create(test_ctx->secdb, NULL, NULL);
+    assert_non_null(test_ctx->secdb->index);
+    test_ctx->secdb->ev = test_ctx->ev;
+    test_ctx->secdb->write_back_interval = KCM_SECDB_MAX_WRITE_BACK_INTERVAL;
+    test_ctx->db->db_handle = test_ctx->secdb;
+
+    ret = kcm_cc_new(test_ctx, test_ctx->kctx, &test_ctx->client,
+                     "TEST_CCACHE", test_ctx->princ, &test_ctx->cc);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_get_uuid(test_ctx->cc, test_ctx->uuid);
+    assert_int_equal(ret, EOK);
+
+    /* The first ccache of the user, nothing is pending yet */
+    will_check_quota(0, EOK);
+    will_check_payload_size(EOK);
+
+    req = ccdb_secdb_create_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                 &test_ctx->client, test_ctx->cc);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = ccdb_secdb_create_recv(req);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->secdb->unstored, 1);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int teardown_write_back(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_write_back_test_ctx);
+    assert_non_null(test_ctx);
+
+    /* Drops the pending changes and their flush timer */
+    talloc_zfree(test_ctx->db);
+    krb5_free_principal(test_ctx->kctx, test_ctx->princ);
+    krb5_free_context(test_ctx->kctx);
+    talloc_free(test_ctx);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static errno_t store_cred(struct kcm_write_back_test_ctx *test_ctx)
+{
+    struct sss_iobuf *cred_blob;
+    struct tevent_req *req;
+    errno_t ret;
+
+    cred_blob = sss_iobuf_init_readonly(test_ctx,
+                                        (const uint8_t *) TEST_CREDS,
+                                        sizeof(TEST_CREDS));
+    assert_non_null(cred_blob);
+
+    req = ccdb_secdb_store_cred_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                     &test_ctx->client, test_ctx->uuid,
+                                     cred_blob);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = ccdb_secdb_store_cred_recv(req);
+    talloc_free(req);
+
+    return ret;
+}
+
+static errno_t mod_kdc_offset(struct kcm_write_back_test_ctx *test_ctx,
+                              int32_t kdc_offset)
+{
+    struct kcm_mod_ctx mod_cc = { .kdc_offset = kdc_offset };
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = ccdb_secdb_mod_send(test_ctx, test_ctx->ev, test_ctx->db,
+                              &test_ctx->client, test_ctx->uuid, &mod_cc);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = ccdb_secdb_mod_recv(req);
+    talloc_free(req);
+
+    return ret;
+}
+
+static void test_create_over_quota(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_write_back_test_ctx);
+    struct kcm_ccache *cc;
+    struct tevent_req *req;
+    errno_t ret;
+
+    ret = kcm_cc_new(test_ctx, test_ctx->kctx, &test_ctx->client,
+                     "TEST_CCACHE_2", test_ctx->princ, &cc);
+    assert_int_equal(ret, EOK);
+
+    /* The ccache created by the setup is pending */
+    will_check_quota(1, EOK);
+    will_check_payload_size(ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+
+    req = ccdb_secdb_create_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                 &test_ctx->client, cc);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = ccdb_secdb_create_recv(req);
+    talloc_free(req);
+    assert_int_equal(ret, ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+
+    assert_int_equal(test_ctx->secdb->unstored, 1);
+    talloc_free(cc);
+}
+
+static void test_store_cred_over_quota(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_write_back_test_ctx);
+    errno_t ret;
+
+    /* The ccache itself is not counted twice */
+    will_check_quota(0, EOK);
+    will_check_payload_size(ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+
+    ret = store_cred(test_ctx);
+    assert_int_equal(ret, ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+    assert_null(kcm_cc_get_cred(test_ctx->cc));
+
+    will_check_quota(0, ERR_SEC_INVALID_TOO_MANY_SECRETS);
+
+    ret = store_cred(test_ctx);
+    assert_int_equal(ret, ERR_SEC_INVALID_TOO_MANY_SECRETS);
+    assert_null(kcm_cc_get_cred(test_ctx->cc));
+
+    will_check_quota(0, EOK);
+    will_check_payload_size(EOK);
+
+    ret = store_cred(test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_non_null(kcm_cc_get_cred(test_ctx->cc));
+}
+
+static void test_store_cred_stored_ccache(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_write_back_test_ctx);
+    struct secdb_index_entry *entry;
+    errno_t ret;
+
+    ret = entry_by_uuid(test_ctx->secdb, &test_ctx->client, test_ctx->uuid,
+                        &entry);
+    assert_int_equal(ret, EOK);
+    secdb_entry_set_stored(entry, true);
+
+    /* Only the payload size can change for a stored ccache */
+    will_check_payload_size(ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+
+    ret = store_cred(test_ctx);
+    assert_int_equal(ret, ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE);
+    assert_null(kcm_cc_get_cred(test_ctx->cc));
+
+    will_check_payload_size(EOK);
+
+    ret = store_cred(test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_non_null(kcm_cc_get_cred(test_ctx->cc));
+}
+
+static void test_mod_over_quota(void **state)
+{
+    struct kcm_write_back_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_write_back_test_ctx);
+    errno_t ret;
+
+    will_check_quota(0, ERR_SEC_INVALID_TOO_MANY_SECRETS);
+
+    ret = mod_kdc_offset(test_ctx, 42);
+    assert_int_equal(ret, ERR_SEC_INVALID_TOO_MANY_SECRETS);
+    assert_int_equal(test_ctx->cc->kdc_offset, INT32_MAX);
+
+    will_check_quota(0, EOK);
+    will_check_payload_size(EOK);
+
+    ret = mod_kdc_offset(test_ctx, 42);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->cc->kdc_offset, 42);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_create_over_quota,
+                                        setup_write_back,
+                                        teardown_write_back),
+        cmocka_unit_test_setup_teardown(test_store_cred_over_quota,
+                                        setup_write_back,
+                                        teardown_write_back),
+        cmocka_unit_test_setup_teardown(test_store_cred_stored_ccache,
+                                        setup_write_back,
+                                        teardown_write_back),
+        cmocka_unit_test_setup_teardown(test_mod_over_quota,
+                                        setup_write_back,
+                                        teardown_write_back),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
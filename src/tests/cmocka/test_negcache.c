@@ -42,6 +42,7 @@
 #include "db/sysdb_private.h"
 #include "responder/common/responder.h"
 #include "responder/common/negcache.h"
+#include "responder/common/negcache_hash.h"
 
 int test_ncache_setup(void **state);
 int test_ncache_teardown(void **state);
@@ -132,6 +133,23 @@ static int setup(void **state)
     return 0;
 }
 
+static int setup_hash(void **state)
+{
+    int ret;
+    struct test_state *ts;
+
+    ts = talloc(NULL, struct test_state);
+    assert_non_null(ts);
+
+    ret = sss_ncache_init_ex(ts, SHORTSPAN, 0, SSS_NCACHE_BACKEND_HASH,
+                             &ts->ctx);
+    assert_int_equal(ret, EOK);
+    assert_non_null(ts->ctx);
+
+    *state = (void *)ts;
+    return 0;
+}
+
 static int teardown(void **state)
 {
     struct test_state *ts = talloc_get_type_abort(*state, struct test_state);
@@ -155,6 +173,17 @@ static void test_sss_ncache_init(void **state)
     talloc_free(memctx);
 }
 
+/* Entries are valid up to and including their expire time */
+static void test_sss_nc_expired(void **state)
+{
+    time_t now = time(NULL);
+
+    assert_false(sss_nc_expired(0, now));
+    assert_false(sss_nc_expired(now + 1, now));
+    assert_false(sss_nc_expired(now, now));
+    assert_true(sss_nc_expired(now - 1, now));
+}
+
 /* @test_sss_ncache_uid : test following functions
  * sss_ncache_set_uid
  * sss_ncache_check_uid
@@ -1051,6 +1080,7 @@ int main(void)
     int rv;
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_sss_ncache_init),
+        cmocka_unit_test(test_sss_nc_expired),
         cmocka_unit_test_setup_teardown(test_sss_ncache_uid, setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_gid, setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_sid, setup, teardown),
@@ -1077,6 +1107,26 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_sss_ncache_domain_locate_type,
                                         setup, teardown),
 
+        /* hash table backend */
+        cmocka_unit_test_setup_teardown(test_sss_ncache_uid,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_gid,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_sid,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_user,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_group,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_service_port,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_reset_permanent,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_reset,
+                                        setup_hash, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_locate_uid_gid,
+                                        setup_hash, teardown),
+
         /* user */
         cmocka_unit_test_setup_teardown(test_ncache_nocache_user,
                                         test_ncache_setup,
@@ -237,6 +237,67 @@ static void nested_groups_test_one_group_unique_members(void **state)
                                        expected, N_ELEMENTS(expected));
 }
 
+static void nested_groups_test_one_group_batched_members(void **state)
+{
+    struct nested_groups_test_ctx *test_ctx = NULL;
+    struct sysdb_attrs *rootgroup = NULL;
+    struct tevent_req *req = NULL;
+    TALLOC_CTX *req_mem_ctx = NULL;
+    errno_t ret;
+    const char *users[] = { "cn=user1,"USER_BASE_DN,
+                            "cn=user2,"USER_BASE_DN,
+                            NULL };
+    const struct sysdb_attrs *users_reply[3] = { NULL };
+    const char * expected[] = { "user1",
+                                "user2" };
+
+
+    test_ctx = talloc_get_type_abort(*state, struct nested_groups_test_ctx);
+
+    ret = dp_opt_set_int(test_ctx->sdap_opts->basic,
+                         SDAP_NESTED_GROUP_BATCH_SIZE, 10);
+    assert_int_equal(ret, EOK);
+
+    /* mock return values, both users are returned by a single search */
+    rootgroup = mock_sysdb_group_rfc2307bis(test_ctx, GROUP_BASE_DN, 1000,
+                                            "rootgroup", users);
+
+    users_reply[0] = mock_sysdb_user(test_ctx, USER_BASE_DN, 2001, "user1");
+    assert_non_null(users_reply[0]);
+    users_reply[1] = mock_sysdb_user(test_ctx, USER_BASE_DN, 2002, "user2");
+    assert_non_null(users_reply[1]);
+    will_return(sdap_get_generic_recv, 2);
+    will_return(sdap_get_generic_recv, users_reply);
+    will_return(sdap_get_generic_recv, ERR_OK);
+
+    sss_will_return_always(sdap_has_deref_support, false);
+
+    /* run test, check for memory leaks */
+    req_mem_ctx = talloc_new(global_talloc_context);
+    assert_non_null(req_mem_ctx);
+    check_leaks_push(req_mem_ctx);
+
+    req = sdap_nested_group_send(req_mem_ctx, test_ctx->tctx->ev,
+                                 test_ctx->sdap_domain, test_ctx->sdap_opts,
+                                 test_ctx->sdap_handle, rootgroup);
+    assert_non_null(req);
+    tevent_req_set_callback(req, nested_groups_test_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_true(check_leaks_pop(req_mem_ctx) == true);
+    talloc_zfree(req_mem_ctx);
+
+    /* check return code */
+    assert_int_equal(ret, ERR_OK);
+
+    /* Check the users */
+    assert_int_equal(test_ctx->num_users, N_ELEMENTS(expected));
+    assert_int_equal(test_ctx->num_groups, 1);
+
+    compare_sysdb_string_array_noorder(test_ctx->users,
+                                       expected, N_ELEMENTS(expected));
+}
+
 static void nested_groups_test_one_group_dup_users(void **state)
 {
     struct nested_groups_test_ctx *test_ctx = NULL;
@@ -596,6 +657,8 @@ static int nested_groups_test_setup(void **state)
         { "ldap_search_base", OBJECT_BASE_DN },
         { "ldap_user_search_base", USER_BASE_DN },
         { "ldap_group_search_base", GROUP_BASE_DN },
+        /* mocked replies are per member, batches have their own tests */
+        { "ldap_nested_group_batch_size", "1" },
         { NULL, NULL }
     };
 
@@ -1293,6 +1356,7 @@ int main(int argc, const char *argv[])
     const struct CMUnitTest tests[] = {
         new_test(one_group_no_members),
         new_test(one_group_unique_members),
+        new_test(one_group_batched_members),
         new_test(one_group_dup_users),
         new_test(one_group_unique_group_members),
         new_test(one_group_dup_group_members),
@@ -0,0 +1,178 @@
+/*
+    SSSD
+
+    Tests for the group lookups of the NSS client library
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <grp.h>
+#include <nss.h>
+#include <cmocka.h>
+
+#include "sss_client/sss_cli.h"
+
+#define TEST_GID 100001
+
+enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
+                                    char *buffer, size_t buflen, int *errnop);
+
+/* Number of requests sent to the responder */
+static int num_requests;
+
+/* Whether the negative memory cache has a record for every group */
+static bool negative_cached;
+
+/* Nothing is in the memory cache, every lookup goes to the responder. */
+errno_t __wrap_sss_nss_mc_getgrnam(const char *name, size_t name_len,
+                                   struct group *result,
+                                   char *buffer, size_t buflen)
+{
+    return ENOENT;
+}
+
+errno_t __wrap_sss_nss_mc_check_negative_name(char kind, const char *name)
+{
+    return negative_cached ? 0 : ENOENT;
+}
+
+/* Reply with one group that is named as requested and has no members */
+enum nss_status __wrap_sss_nss_make_request(enum sss_cli_command cmd,
+                                            struct sss_cli_req_data *rd,
+                                            uint8_t **repbuf, size_t *replen,
+                                            int *errnop)
+{
+    uint32_t header[4] = { 1, 0, TEST_GID, 0 };
+    size_t name_len;
+    uint8_t *buf;
+
+    num_requests++;
+
+    name_len = strlen(rd->data) + 1;
+    *replen = sizeof(header) + name_len + sizeof("*");
+
+    buf = malloc(*replen);
+    if (buf == NULL) {
+        *errnop = ENOMEM;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    memcpy(buf, header, sizeof(header));
+    memcpy(buf + sizeof(header), rd->data, name_len);
+    memcpy(buf + sizeof(header) + name_len, "*", sizeof("*"));
+
+    *repbuf = buf;
+    *errnop = 0;
+    return NSS_STATUS_SUCCESS;
+}
+
+struct getgrnam_result {
+    enum nss_status status;
+    int errnop;
+    struct group grp;
+    char buffer[128];
+};
+
+static void getgrnam(const char *name, size_t buflen,
+                     struct getgrnam_result *res)
+{
+    memset(res, 0, sizeof(struct getgrnam_result));
+
+    res->status = _nss_sss_getgrnam_r(name, &res->grp, res->buffer, buflen,
+                                      &res->errnop);
+}
+
+/* Runs a lookup that does not fit into the buffer and then its retry,
+ * the way glibc does when it gets ERANGE. */
+static void *getgrnam_retry_thread(void *data)
+{
+    struct getgrnam_result *res = data;
+
+    getgrnam("group2", 2, &res[0]);
+    getgrnam("group2", sizeof(res[1].buffer), &res[1]);
+
+    return NULL;
+}
+
+static void test_getgrnam_erange_retry_per_thread(void **state)
+{
+    struct getgrnam_result thread_res[2];
+    struct getgrnam_result res;
+    pthread_t thread;
+    int ret;
+
+    num_requests = 0;
+
+    /* The reply does not fit, it is kept for the retry of this thread. */
+    getgrnam("group1", 2, &res);
+    assert_int_equal(res.status, NSS_STATUS_TRYAGAIN);
+    assert_int_equal(res.errnop, ERANGE);
+    assert_int_equal(num_requests, 1);
+
+    /* Another thread fails and retries a lookup of a different group. */
+    ret = pthread_create(&thread, NULL, getgrnam_retry_thread, thread_res);
+    assert_int_equal(ret, 0);
+    ret = pthread_join(thread, NULL);
+    assert_int_equal(ret, 0);
+
+    assert_int_equal(thread_res[0].status, NSS_STATUS_TRYAGAIN);
+    assert_int_equal(thread_res[0].errnop, ERANGE);
+    assert_int_equal(thread_res[1].status, NSS_STATUS_SUCCESS);
+    assert_string_equal(thread_res[1].grp.gr_name, "group2");
+    assert_int_equal(num_requests, 2);
+
+    /* The retry of this thread is still served from its saved reply. */
+    getgrnam("group1", sizeof(res.buffer), &res);
+    assert_int_equal(res.status, NSS_STATUS_SUCCESS);
+    assert_string_equal(res.grp.gr_name, "group1");
+    assert_int_equal(res.grp.gr_gid, TEST_GID);
+    assert_null(res.grp.gr_mem[0]);
+    assert_int_equal(num_requests, 2);
+}
+
+/* A record in the negative memory cache answers without the responder */
+static void test_getgrnam_negative_cached(void **state)
+{
+    struct getgrnam_result res;
+
+    num_requests = 0;
+    negative_cached = true;
+
+    getgrnam("nogroup", sizeof(res.buffer), &res);
+    negative_cached = false;
+
+    assert_int_equal(res.status, NSS_STATUS_NOTFOUND);
+    assert_int_equal(res.errnop, 0);
+    assert_int_equal(num_requests, 0);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_getgrnam_erange_retry_per_thread),
+        cmocka_unit_test(test_getgrnam_negative_cached),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
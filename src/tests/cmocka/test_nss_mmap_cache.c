@@ -0,0 +1,669 @@
+/*
+    SSSD
+
+    Tests for the NSS memory cache
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <errno.h>
+#include <popt.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+
+#include "responder/nss/nsssrv_mmap_cache.c"
+#include "sss_client/nss_mc.h"
+#include "sss_client/idmap/sss_nss_idmap.h"
+
+#define TEST_MC_NAME "test_nss_mmap_cache_passwd"
+/* The client library opens the caches by their fixed names */
+#define TEST_SID_MC_NAME "sid"
+#define TEST_SVC_MC_NAME "services"
+#define TEST_NETGR_MC_NAME "netgroup"
+#define TEST_NEG_MC_NAME "negative"
+#define TEST_MC_ELEMENTS 64
+#define TEST_MC_TIMEOUT 300
+
+/* ====================== Utilities =============================== */
+
+/* A cache context with only a free table of ft_size bytes, all slots
+ * are used */
+static struct sss_mc_ctx *free_table_setup(uint32_t ft_size)
+{
+    struct sss_mc_ctx *mcc;
+
+    mcc = talloc_zero(global_talloc_context, struct sss_mc_ctx);
+    assert_non_null(mcc);
+
+    mcc->ft_size = ft_size;
+    mcc->free_table = talloc_size(mcc, ft_size);
+    assert_non_null(mcc->free_table);
+    memset(mcc->free_table, 0xff, ft_size);
+
+    return mcc;
+}
+
+static void free_slots(struct sss_mc_ctx *mcc, uint32_t from, uint32_t to)
+{
+    uint32_t i;
+
+    for (i = from; i < to; i++) {
+        MC_CLEAR_BIT(mcc->free_table, i);
+    }
+}
+
+static void assert_free_run(struct sss_mc_ctx *mcc,
+                            uint32_t from, uint32_t to,
+                            uint32_t num_slots, uint32_t expected)
+{
+    uint32_t slot = MC_INVALID_VAL32;
+
+    assert_true(sss_mc_find_free_run(mcc, from, to, num_slots, &slot));
+    assert_int_equal(slot, expected);
+}
+
+static void assert_no_free_run(struct sss_mc_ctx *mcc,
+                               uint32_t from, uint32_t to,
+                               uint32_t num_slots)
+{
+    uint32_t slot;
+
+    assert_false(sss_mc_find_free_run(mcc, from, to, num_slots, &slot));
+}
+
+static void pw_store(struct sss_mc_ctx **mcc, uint32_t id)
+{
+    struct sized_string name;
+    struct sized_string pw;
+    struct sized_string gecos;
+    struct sized_string homedir;
+    struct sized_string shell;
+    char namebuf[16];
+    errno_t ret;
+
+    snprintf(namebuf, sizeof(namebuf), "user%04u", id);
+    to_sized_string(&name, namebuf);
+    to_sized_string(&pw, "*");
+    to_sized_string(&gecos, "Test User");
+    to_sized_string(&homedir, "/home/user");
+    to_sized_string(&shell, "/bin/sh");
+
+    ret = sss_mmap_cache_pw_store(mcc, &name, &pw, 10000 + id, 10000 + id,
+                                  &gecos, &homedir, &shell);
+    assert_int_equal(ret, EOK);
+}
+
+static struct sss_mc_rec *pw_find(struct sss_mc_ctx *mcc, uint32_t id)
+{
+    struct sized_string name;
+    char namebuf[16];
+
+    snprintf(namebuf, sizeof(namebuf), "user%04u", id);
+    to_sized_string(&name, namebuf);
+
+    return sss_mc_find_record(mcc, &name);
+}
+
+static int mc_setup(void **state, const char *name, enum sss_mc_type type)
+{
+    struct sss_mc_ctx *mcc = NULL;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    ret = sss_mmap_cache_init(global_talloc_context, name,
+                              -1, -1, type,
+                              TEST_MC_ELEMENTS, TEST_MC_ELEMENTS,
+                              TEST_MC_TIMEOUT, &mcc);
+    assert_int_equal(ret, EOK);
+
+    *state = mcc;
+    return 0;
+}
+
+static int test_mc_setup(void **state)
+{
+    return mc_setup(state, TEST_MC_NAME, SSS_MC_PASSWD);
+}
+
+static int test_sid_mc_setup(void **state)
+{
+    return mc_setup(state, TEST_SID_MC_NAME, SSS_MC_SID);
+}
+
+static int test_svc_mc_setup(void **state)
+{
+    return mc_setup(state, TEST_SVC_MC_NAME, SSS_MC_SERVICES);
+}
+
+static int test_netgr_mc_setup(void **state)
+{
+    return mc_setup(state, TEST_NETGR_MC_NAME, SSS_MC_NETGROUP);
+}
+
+static int test_neg_mc_setup(void **state)
+{
+    return mc_setup(state, TEST_NEG_MC_NAME, SSS_MC_NEGATIVE);
+}
+
+static void expire_rec(struct sss_mc_ctx *mcc, const char *key)
+{
+    struct sized_string sz_key;
+    struct sss_mc_rec *rec;
+
+    to_sized_string(&sz_key, key);
+    rec = sss_mc_find_record(mcc, &sz_key);
+    assert_non_null(rec);
+
+    rec->expire = time(NULL) - 1;
+}
+
+static int test_mc_teardown(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+
+    unlink(mcc->file);
+    talloc_free(mcc);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Tests =================================== */
+
+void test_mc_free_run_word_boundary(void **state)
+{
+    struct sss_mc_ctx *mcc;
+
+    assert_true(leak_check_setup());
+    mcc = free_table_setup(32);
+
+    /* 60..69 spans the first and the second word */
+    free_slots(mcc, 60, 70);
+    assert_free_run(mcc, 0, 256, 10, 60);
+    assert_no_free_run(mcc, 0, 256, 11);
+
+    /* a whole free word extends a run started in the previous one */
+    free_slots(mcc, 120, 200);
+    assert_free_run(mcc, 0, 256, 80, 120);
+    assert_no_free_run(mcc, 0, 256, 81);
+
+    /* slots before from are not part of the run */
+    assert_free_run(mcc, 65, 256, 5, 65);
+    assert_no_free_run(mcc, 65, 120, 6);
+
+    /* slots at to and after are not part of the run */
+    assert_no_free_run(mcc, 0, 65, 10);
+    assert_free_run(mcc, 0, 65, 5, 60);
+
+    talloc_free(mcc);
+    assert_true(leak_check_teardown());
+}
+
+void test_mc_free_run_partial_word(void **state)
+{
+    struct sss_mc_ctx *mcc;
+    uint64_t word;
+
+    assert_true(leak_check_setup());
+
+    /* 160 slots, the last word has only 32 of them */
+    mcc = free_table_setup(20);
+    free_slots(mcc, 150, 160);
+
+    /* slots behind the end of the table are reported as used */
+    word = sss_mc_free_word(mcc, 128);
+    assert_true(word == 0xfffffc00ffffffffULL);
+
+    assert_free_run(mcc, 0, 160, 10, 150);
+    assert_no_free_run(mcc, 0, 160, 11);
+
+    /* the whole table is free */
+    free_slots(mcc, 0, 160);
+    assert_free_run(mcc, 0, 160, 160, 0);
+    assert_no_free_run(mcc, 0, 160, 161);
+    assert_free_run(mcc, 100, 160, 60, 100);
+    assert_no_free_run(mcc, 100, 160, 61);
+
+    talloc_free(mcc);
+    assert_true(leak_check_teardown());
+}
+
+void test_mc_free_run_wrap(void **state)
+{
+    struct sss_mc_ctx *mcc;
+    uint32_t slot;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+    mcc = free_table_setup(32);
+
+    /* the run starts before next_slot and ends after it */
+    free_slots(mcc, 95, 105);
+    mcc->next_slot = 100;
+
+    ret = sss_mc_find_free_slots(mcc, 10, &slot);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slot, 95);
+    assert_int_equal(mcc->next_slot, 105);
+
+    /* the only run is before next_slot */
+    memset(mcc->free_table, 0xff, mcc->ft_size);
+    free_slots(mcc, 10, 20);
+    mcc->next_slot = 200;
+
+    ret = sss_mc_find_free_slots(mcc, 10, &slot);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slot, 10);
+    assert_int_equal(mcc->next_slot, 20);
+
+    /* a run after next_slot is preferred */
+    free_slots(mcc, 30, 40);
+    free_slots(mcc, 240, 250);
+    mcc->next_slot = 200;
+
+    ret = sss_mc_find_free_slots(mcc, 10, &slot);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slot, 240);
+    assert_int_equal(mcc->next_slot, 250);
+
+    /* next_slot too close to the end starts the search at the beginning */
+    mcc->next_slot = 250;
+
+    ret = sss_mc_find_free_slots(mcc, 10, &slot);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slot, 10);
+
+    talloc_free(mcc);
+    assert_true(leak_check_teardown());
+}
+
+/* A record stored again since the hand passed it survives one eviction
+ * pass, but only one */
+void test_mc_second_chance(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+    struct sss_mc_rec *rec;
+    uint32_t rec_slots;
+    uint32_t num_recs;
+    uint32_t id;
+    uint32_t i;
+    bool used;
+
+    pw_store(&mcc, 0);
+    rec = pw_find(mcc, 0);
+    assert_non_null(rec);
+    assert_int_equal(MC_PTR_TO_SLOT(mcc->data_table, rec), 0);
+
+    /* fill the cache without evicting anything */
+    rec_slots = MC_SIZE_TO_SLOTS(rec->len);
+    num_recs = mcc->ft_size * 8 / rec_slots;
+    for (id = 1; id < num_recs; id++) {
+        pw_store(&mcc, id);
+    }
+    for (i = 0; i < num_recs; i++) {
+        assert_non_null(pw_find(mcc, i));
+    }
+    assert_int_equal(mcc->evictions, 0);
+
+    /* the first record is requested again */
+    pw_store(&mcc, 0);
+    MC_PROBE_BIT(mcc->ref_table, 0, used);
+    assert_true(used);
+
+    /* the hand skips it and evicts the next one */
+    pw_store(&mcc, id);
+    assert_non_null(pw_find(mcc, 0));
+    assert_null(pw_find(mcc, 1));
+    assert_non_null(pw_find(mcc, id));
+    assert_int_equal(mcc->evictions, 1);
+    MC_PROBE_BIT(mcc->ref_table, 0, used);
+    assert_false(used);
+
+    rec = pw_find(mcc, id);
+    assert_int_equal(MC_PTR_TO_SLOT(mcc->data_table, rec), rec_slots);
+    id++;
+
+    /* one more pass of the hand evicts it */
+    for (i = 2; i < num_recs; i++) {
+        pw_store(&mcc, id);
+        assert_null(pw_find(mcc, i));
+        assert_non_null(pw_find(mcc, 0));
+        id++;
+    }
+
+    pw_store(&mcc, id);
+    assert_null(pw_find(mcc, 0));
+    assert_non_null(pw_find(mcc, id));
+    assert_int_equal(mcc->evictions, num_recs);
+}
+
+#define TEST_SID_UID "S-1-5-21-3623811015-3361044348-30300820-1013"
+#define TEST_SID_GID "S-1-5-21-3623811015-3361044348-30300820-1014"
+#define TEST_SID_NAME "S-1-5-21-3623811015-3361044348-30300820-1015"
+#define TEST_SID_OBJ_NAME "user1@test.example"
+
+static void assert_sid_by_id(uint32_t id, uint32_t populated_by,
+                             const char *expected_sid,
+                             enum sss_id_type expected_type)
+{
+    char *sid = NULL;
+    uint32_t type;
+    errno_t ret;
+
+    ret = sss_nss_mc_get_sid_by_id(id, populated_by, &sid, &type);
+    assert_int_equal(ret, 0);
+    assert_string_equal(sid, expected_sid);
+    assert_int_equal(type, expected_type);
+    free(sid);
+}
+
+/* Records are found by the client library the same way as they were
+ * stored and only answer the kind of lookup that created them */
+void test_mc_sid_store_lookup(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+    struct sized_string sid;
+    struct sized_string name;
+    char *str = NULL;
+    uint32_t type;
+    uint32_t id;
+    errno_t ret;
+
+    to_sized_string(&sid, TEST_SID_UID);
+    ret = sss_mmap_cache_sid_store(&mcc, &sid, 1013, SSS_ID_TYPE_UID,
+                                   SSS_MC_SID_BY_UID);
+    assert_int_equal(ret, EOK);
+
+    to_sized_string(&sid, TEST_SID_GID);
+    ret = sss_mmap_cache_sid_store(&mcc, &sid, 1014, SSS_ID_TYPE_GID,
+                                   SSS_MC_SID_BY_SID);
+    assert_int_equal(ret, EOK);
+
+    to_sized_string(&name, TEST_SID_OBJ_NAME);
+    to_sized_string(&sid, TEST_SID_NAME);
+    ret = sss_mmap_cache_sid_name_store(&mcc, &name, &sid, SSS_ID_TYPE_UID);
+    assert_int_equal(ret, EOK);
+
+    /* ID records */
+    assert_sid_by_id(1013, SSS_MC_SID_BY_UID, TEST_SID_UID, SSS_ID_TYPE_UID);
+
+    ret = sss_nss_mc_get_sid_by_id(1013, SSS_MC_SID_BY_GID, &str, &type);
+    assert_int_equal(ret, ENOENT);
+    ret = sss_nss_mc_get_sid_by_id(1013, SSS_MC_SID_BY_ID, &str, &type);
+    assert_int_equal(ret, ENOENT);
+
+    /* only records created by SID or by ID lookups answer by SID */
+    ret = sss_nss_mc_get_id_by_sid(TEST_SID_UID, strlen(TEST_SID_UID),
+                                   &id, &type);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_nss_mc_get_id_by_sid(TEST_SID_GID, strlen(TEST_SID_GID),
+                                   &id, &type);
+    assert_int_equal(ret, 0);
+    assert_int_equal(id, 1014);
+    assert_int_equal(type, SSS_ID_TYPE_GID);
+
+    /* name records */
+    ret = sss_nss_mc_get_sid_by_name(TEST_SID_OBJ_NAME,
+                                     strlen(TEST_SID_OBJ_NAME), &str, &type);
+    assert_int_equal(ret, 0);
+    assert_string_equal(str, TEST_SID_NAME);
+    assert_int_equal(type, SSS_ID_TYPE_UID);
+    free(str);
+
+    ret = sss_nss_mc_get_name_by_sid(TEST_SID_NAME, strlen(TEST_SID_NAME),
+                                     &str, &type);
+    assert_int_equal(ret, 0);
+    assert_string_equal(str, TEST_SID_OBJ_NAME);
+    assert_int_equal(type, SSS_ID_TYPE_UID);
+    free(str);
+
+    /* a name record does not answer lookups by SID for the ID */
+    ret = sss_nss_mc_get_id_by_sid(TEST_SID_NAME, strlen(TEST_SID_NAME),
+                                   &id, &type);
+    assert_int_equal(ret, ENOENT);
+
+    /* invalidation by ID drops the record of every kind of ID lookup */
+    ret = sss_mmap_cache_sid_invalidate_id(mcc, 1013);
+    assert_int_equal(ret, EOK);
+    ret = sss_nss_mc_get_sid_by_id(1013, SSS_MC_SID_BY_UID, &str, &type);
+    assert_int_equal(ret, ENOENT);
+    ret = sss_mmap_cache_sid_invalidate_id(mcc, 1013);
+    assert_int_equal(ret, ENOENT);
+
+    /* invalidation by SID */
+    to_sized_string(&sid, TEST_SID_GID);
+    ret = sss_mmap_cache_sid_invalidate(mcc, &sid);
+    assert_int_equal(ret, EOK);
+    ret = sss_nss_mc_get_id_by_sid(TEST_SID_GID, strlen(TEST_SID_GID),
+                                   &id, &type);
+    assert_int_equal(ret, ENOENT);
+
+    /* invalidation by name */
+    ret = sss_mmap_cache_sid_invalidate(mcc, &name);
+    assert_int_equal(ret, EOK);
+    ret = sss_nss_mc_get_sid_by_name(TEST_SID_OBJ_NAME,
+                                     strlen(TEST_SID_OBJ_NAME), &str, &type);
+    assert_int_equal(ret, ENOENT);
+    ret = sss_nss_mc_get_name_by_sid(TEST_SID_NAME, strlen(TEST_SID_NAME),
+                                     &str, &type);
+    assert_int_equal(ret, ENOENT);
+
+    /* expired records are not used */
+    to_sized_string(&sid, TEST_SID_UID);
+    ret = sss_mmap_cache_sid_store(&mcc, &sid, 1013, SSS_ID_TYPE_UID,
+                                   SSS_MC_SID_BY_UID);
+    assert_int_equal(ret, EOK);
+    assert_sid_by_id(1013, SSS_MC_SID_BY_UID, TEST_SID_UID, SSS_ID_TYPE_UID);
+
+    expire_rec(mcc, TEST_SID_UID);
+    ret = sss_nss_mc_get_sid_by_id(1013, SSS_MC_SID_BY_UID, &str, &type);
+    assert_int_equal(ret, EINVAL);
+}
+
+static void reply_store(struct sss_mc_ctx **mcc,
+                        errno_t (*store_fn)(struct sss_mc_ctx **,
+                                            struct sized_string *,
+                                            uint8_t *, size_t),
+                        const char *key, const char *reply)
+{
+    struct sized_string sz_key;
+    errno_t ret;
+
+    to_sized_string(&sz_key, key);
+    ret = store_fn(mcc, &sz_key, discard_const(reply), strlen(reply) + 1);
+    assert_int_equal(ret, EOK);
+}
+
+static void assert_reply(errno_t ret, uint8_t *reply, size_t reply_len,
+                         const char *expected)
+{
+    assert_int_equal(ret, 0);
+    assert_int_equal(reply_len, strlen(expected) + 1);
+    assert_memory_equal(reply, expected, reply_len);
+    free(reply);
+}
+
+/* The reply body is returned as stored for the key the client builds from
+ * the service name or port and the protocol */
+void test_mc_svc_store_lookup(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+    uint8_t *reply = NULL;
+    size_t reply_len;
+    errno_t ret;
+
+    reply_store(&mcc, sss_mmap_cache_svc_store, "ssh/tcp", "ssh by name");
+    reply_store(&mcc, sss_mmap_cache_svc_store, "ssh/", "ssh any protocol");
+    reply_store(&mcc, sss_mmap_cache_svc_store, "#22/tcp", "ssh by port");
+
+    ret = sss_nss_mc_getservbyname("ssh", "tcp", &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ssh by name");
+
+    ret = sss_nss_mc_getservbyname("ssh", NULL, &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ssh any protocol");
+
+    ret = sss_nss_mc_getservbyport(22, "tcp", &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ssh by port");
+
+    /* every protocol has its own record */
+    ret = sss_nss_mc_getservbyname("ssh", "udp", &reply, &reply_len);
+    assert_int_equal(ret, ENOENT);
+    ret = sss_nss_mc_getservbyport(22, NULL, &reply, &reply_len);
+    assert_int_equal(ret, ENOENT);
+
+    /* a new reply replaces the old one */
+    reply_store(&mcc, sss_mmap_cache_svc_store, "ssh/tcp", "ssh updated");
+    ret = sss_nss_mc_getservbyname("ssh", "tcp", &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ssh updated");
+
+    /* expired records are not used */
+    expire_rec(mcc, "#22/tcp");
+    ret = sss_nss_mc_getservbyport(22, "tcp", &reply, &reply_len);
+    assert_int_equal(ret, EINVAL);
+
+    ret = sss_nss_mc_getservbyname("ssh", "tcp", &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ssh updated");
+}
+
+void test_mc_netgr_store_lookup(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+    struct sized_string name;
+    uint8_t *reply = NULL;
+    size_t reply_len;
+    errno_t ret;
+
+    reply_store(&mcc, sss_mmap_cache_netgr_store, "ng1", "ng1 triples");
+    reply_store(&mcc, sss_mmap_cache_netgr_store, "ng2", "ng2 triples");
+
+    ret = sss_nss_mc_getnetgr("ng1", strlen("ng1"), &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ng1 triples");
+
+    ret = sss_nss_mc_getnetgr("ng3", strlen("ng3"), &reply, &reply_len);
+    assert_int_equal(ret, ENOENT);
+
+    /* invalidation */
+    to_sized_string(&name, "ng1");
+    ret = sss_mmap_cache_netgr_invalidate(mcc, &name);
+    assert_int_equal(ret, EOK);
+    ret = sss_nss_mc_getnetgr("ng1", strlen("ng1"), &reply, &reply_len);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_nss_mc_getnetgr("ng2", strlen("ng2"), &reply, &reply_len);
+    assert_reply(ret, reply, reply_len, "ng2 triples");
+
+    /* expired records are not used */
+    expire_rec(mcc, "ng2");
+    ret = sss_nss_mc_getnetgr("ng2", strlen("ng2"), &reply, &reply_len);
+    assert_int_equal(ret, EINVAL);
+}
+
+/* The client finds negative records by the kind and the name or ID of the
+ * lookup */
+void test_mc_neg_store_lookup(void **state)
+{
+    struct sss_mc_ctx *mcc = *state;
+    errno_t ret;
+
+    ret = sss_mmap_cache_neg_store(&mcc, SSS_MC_NEG_USER, "nouser", 0,
+                                   TEST_MC_TIMEOUT);
+    assert_int_equal(ret, EOK);
+    ret = sss_mmap_cache_neg_store(&mcc, SSS_MC_NEG_GID, NULL, 1234,
+                                   TEST_MC_TIMEOUT);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(sss_nss_mc_check_negative_name(SSS_MC_NEG_USER,
+                                                    "nouser"), 0);
+    assert_int_equal(sss_nss_mc_check_negative_id(SSS_MC_NEG_GID, 1234), 0);
+
+    /* users and groups, names and IDs do not share records */
+    assert_int_equal(sss_nss_mc_check_negative_name(SSS_MC_NEG_GROUP,
+                                                    "nouser"), ENOENT);
+    assert_int_equal(sss_nss_mc_check_negative_id(SSS_MC_NEG_UID, 1234),
+                     ENOENT);
+    assert_int_equal(sss_nss_mc_check_negative_name(SSS_MC_NEG_GROUP,
+                                                    "1234"), ENOENT);
+
+    /* invalidation */
+    ret = sss_mmap_cache_neg_invalidate(mcc, SSS_MC_NEG_USER, "nouser", 0);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(sss_nss_mc_check_negative_name(SSS_MC_NEG_USER,
+                                                    "nouser"), ENOENT);
+
+    /* expired records are not used */
+    expire_rec(mcc, "g:1234");
+    assert_int_equal(sss_nss_mc_check_negative_id(SSS_MC_NEG_GID, 1234),
+                     EINVAL);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_mc_free_run_word_boundary),
+        cmocka_unit_test(test_mc_free_run_partial_word),
+        cmocka_unit_test(test_mc_free_run_wrap),
+        cmocka_unit_test_setup_teardown(test_mc_second_chance,
+                                        test_mc_setup,
+                                        test_mc_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_sid_store_lookup,
+                                        test_sid_mc_setup,
+                                        test_mc_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_svc_store_lookup,
+                                        test_svc_mc_setup,
+                                        test_mc_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_netgr_store_lookup,
+                                        test_netgr_mc_setup,
+                                        test_mc_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_neg_store_lookup,
+                                        test_neg_mc_setup,
+                                        test_mc_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
@@ -24,17 +24,20 @@
 #include <tevent.h>
 #include <errno.h>
 #include <popt.h>
+#include <unistd.h>
 
 #include "tests/cmocka/common_mock.h"
 #include "tests/cmocka/common_mock_resp.h"
 #include "responder/common/negcache.h"
 #include "responder/nss/nss_private.h"
 #include "responder/nss/nss_protocol.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
 #include "sss_client/idmap/sss_nss_idmap.h"
 #include "util/util_sss_idmap.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/crypto/nss/nss_util.h"
 #include "db/sysdb_private.h"   /* new_subdomain() */
+#include "util/mmap_cache.h"
 
 #define TESTS_PATH "tp_" BASE_FILE_STEM
 #define TEST_CONF_DB "test_nss_conf.ldb"
@@ -787,6 +790,89 @@ void test_nss_getpwnam_neg(void **state)
     assert_int_equal(nss_test_ctx->ncache_hits, 1);
 }
 
+/* Test that a lookup of a nonexistent user or UID is published in the
+ * negative memory cache
+ */
+void test_nss_getpwnam_neg_mc(void **state)
+{
+    struct sss_mc_ctx *neg_mc_ctx = nss_test_ctx->nctx->neg_mc_ctx;
+    errno_t ret;
+
+    mock_input_user_or_group("testuser_neg");
+    mock_account_recv_simple();
+
+    set_cmd_cb(NULL);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with ENOENT */
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, ENOENT);
+
+    nss_test_ctx->tctx->done = false;
+
+    mock_input_id(nss_test_ctx, 102);
+    mock_account_recv_simple();
+
+    set_cmd_cb(NULL);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWUID,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with ENOENT */
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, ENOENT);
+
+    /* Both records exist, they can be removed exactly once */
+    ret = sss_mmap_cache_neg_invalidate(neg_mc_ctx, SSS_MC_NEG_USER,
+                                        "testuser_neg", 0);
+    assert_int_equal(ret, EOK);
+    ret = sss_mmap_cache_neg_invalidate(neg_mc_ctx, SSS_MC_NEG_USER,
+                                        "testuser_neg", 0);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_mmap_cache_neg_invalidate(neg_mc_ctx, SSS_MC_NEG_UID,
+                                        NULL, 102);
+    assert_int_equal(ret, EOK);
+    ret = sss_mmap_cache_neg_invalidate(neg_mc_ctx, SSS_MC_NEG_UID,
+                                        NULL, 102);
+    assert_int_equal(ret, ENOENT);
+}
+
+/* Test that the negative memory cache record of a user is removed once
+ * the user is found
+ */
+void test_nss_getpwnam_neg_mc_found(void **state)
+{
+    errno_t ret;
+
+    ret = sss_mmap_cache_neg_store(&nss_test_ctx->nctx->neg_mc_ctx,
+                                   SSS_MC_NEG_USER, "testuser", 0, 10);
+    assert_int_equal(ret, EOK);
+
+    ret = store_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                     &getpwnam_usr, NULL, 0);
+    assert_int_equal(ret, EOK);
+
+    mock_input_user_or_group("testuser");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETPWNAM);
+    mock_fill_user();
+
+    set_cmd_cb(test_nss_getpwnam_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with EOK */
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_mmap_cache_neg_invalidate(nss_test_ctx->nctx->neg_mc_ctx,
+                                        SSS_MC_NEG_USER, "testuser", 0);
+    assert_int_equal(ret, ENOENT);
+}
+
 struct passwd getpwnam_search_usr = {
     .pw_name = discard_const("testuser_search"),
     .pw_uid = 567,
@@ -3437,6 +3523,21 @@ static int nss_test_setup(void **state)
     return 0;
 }
 
+#define TEST_NEG_MC_NAME "nss_srv_tests_negative"
+
+static int nss_neg_mc_test_setup(void **state)
+{
+    errno_t ret;
+
+    nss_test_setup(state);
+
+    ret = sss_mmap_cache_init(nss_test_ctx->nctx, TEST_NEG_MC_NAME,
+                              -1, -1, SSS_MC_NEGATIVE, 64, 64, 300,
+                              &nss_test_ctx->nctx->neg_mc_ctx);
+    assert_int_equal(ret, EOK);
+    return 0;
+}
+
 static int nss_fqdn_test_setup(void **state)
 {
     struct sss_test_conf_param params[] = {
@@ -3564,6 +3665,12 @@ static int nss_test_teardown(void **state)
     return 0;
 }
 
+static int nss_neg_mc_test_teardown(void **state)
+{
+    unlink(SSS_NSS_MCACHE_DIR "/" TEST_NEG_MC_NAME);
+    return nss_test_teardown(state);
+}
+
 static int nss_subdom_test_teardown(void **state)
 {
     errno_t ret;
@@ -4976,6 +5083,12 @@ int main(int argc, const char *argv[])
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwuid_neg,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getpwnam_neg_mc,
+                                        nss_neg_mc_test_setup,
+                                        nss_neg_mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getpwnam_neg_mc_found,
+                                        nss_neg_mc_test_setup,
+                                        nss_neg_mc_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwnam_search,
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwuid_search,
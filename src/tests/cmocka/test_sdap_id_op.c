@@ -0,0 +1,593 @@
+/*
+    SSSD
+
+    Tests for the LDAP ID operation connection cache
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+
+#include "providers/ldap/ldap_opts.c"
+#include "providers/ldap/sdap_id_op.c"
+
+#define TEST_MAX_CONNECTS (SDAP_ID_CONN_POOL_MAX + 4)
+
+struct test_sdap_id_op_ctx {
+    struct tevent_context *ev;
+    struct be_ctx *be;
+    struct sdap_id_ctx *id_ctx;
+    struct sdap_id_conn_ctx *id_conn;
+    struct sdap_id_conn_cache *conn_cache;
+
+    /* connection attempts started by sdap_cli_connect_send() */
+    struct tevent_req *connects[TEST_MAX_CONNECTS];
+    int num_connects;
+
+    bool offline;
+    int num_next_server;
+    int num_online_cb;
+};
+
+struct test_op {
+    struct sdap_id_op *op;
+    bool done;
+    int ret;
+    int dp_error;
+};
+
+static struct test_sdap_id_op_ctx *test_ctx;
+
+/* ====================== Mocks =================================== */
+
+struct mock_connect_state {
+    int dummy;
+};
+
+struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sdap_options *opts,
+                                         struct be_ctx *be,
+                                         struct sdap_service *service,
+                                         bool skip_rootdse,
+                                         enum connect_tls force_tls,
+                                         bool skip_auth)
+{
+    struct mock_connect_state *state;
+    struct tevent_req *req;
+
+    assert_true(test_ctx->num_connects < TEST_MAX_CONNECTS);
+
+    req = tevent_req_create(memctx, &state, struct mock_connect_state);
+    assert_non_null(req);
+
+    test_ctx->connects[test_ctx->num_connects] = req;
+    test_ctx->num_connects++;
+
+    return req;
+}
+
+int sdap_cli_connect_recv(struct tevent_req *req,
+                          TALLOC_CTX *memctx,
+                          bool *can_retry,
+                          struct sdap_handle **gsh,
+                          struct sdap_server_opts **srv_opts)
+{
+    struct sdap_handle *sh;
+
+    *can_retry = false;
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    sh = talloc_zero(memctx, struct sdap_handle);
+    assert_non_null(sh);
+    sh->connected = true;
+    *gsh = sh;
+
+    *srv_opts = talloc_zero(memctx, struct sdap_server_opts);
+    assert_non_null(*srv_opts);
+    (*srv_opts)->server_id = talloc_strdup(*srv_opts, "ldap.test");
+    assert_non_null((*srv_opts)->server_id);
+
+    return EOK;
+}
+
+void sdap_steal_server_opts(struct sdap_id_ctx *id_ctx,
+                            struct sdap_server_opts **srv_opts)
+{
+    talloc_zfree(id_ctx->srv_opts);
+    id_ctx->srv_opts = talloc_steal(id_ctx, *srv_opts);
+    *srv_opts = NULL;
+}
+
+struct tevent_req *sdap_reinit_cleanup_send(TALLOC_CTX *mem_ctx,
+                                            struct be_ctx *be_ctx,
+                                            struct sdap_id_ctx *id_ctx)
+{
+    return NULL;
+}
+
+errno_t sdap_reinit_cleanup_recv(struct tevent_req *req)
+{
+    return EOK;
+}
+
+int be_add_offline_cb(TALLOC_CTX *mem_ctx,
+                      struct be_ctx *ctx,
+                      be_callback_t cb,
+                      void *pvt,
+                      struct be_cb **online_cb)
+{
+    return EOK;
+}
+
+int be_add_reconnect_cb(TALLOC_CTX *mem_ctx,
+                        struct be_ctx *ctx,
+                        be_callback_t cb,
+                        void *pvt,
+                        struct be_cb **reconnect_cb)
+{
+    return EOK;
+}
+
+bool be_is_offline(struct be_ctx *ctx)
+{
+    return test_ctx->offline;
+}
+
+void be_mark_offline(struct be_ctx *ctx)
+{
+    test_ctx->offline = true;
+}
+
+void be_run_online_cb(struct be_ctx *be)
+{
+    test_ctx->num_online_cb++;
+}
+
+void be_run_unconditional_online_cb(struct be_ctx *be)
+{
+    return;
+}
+
+int be_fo_get_server_count(struct be_ctx *ctx, const char *service_name)
+{
+    return 1;
+}
+
+void be_fo_try_next_server(struct be_ctx *ctx, const char *service_name)
+{
+    test_ctx->num_next_server++;
+}
+
+/* ====================== Utilities =============================== */
+
+static void finish_connect(int idx, errno_t ret)
+{
+    struct tevent_req *req;
+
+    assert_true(idx < test_ctx->num_connects);
+    req = test_ctx->connects[idx];
+    test_ctx->connects[idx] = NULL;
+    assert_non_null(req);
+
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void test_op_connected(struct tevent_req *req)
+{
+    struct test_op *top = tevent_req_callback_data(req, struct test_op);
+
+    top->ret = sdap_id_op_connect_recv(req, &top->dp_error);
+    top->done = true;
+    talloc_free(req);
+}
+
+static struct test_op *start_op(void)
+{
+    struct tevent_req *req;
+    struct test_op *top;
+    int ret;
+
+    top = talloc_zero(test_ctx, struct test_op);
+    assert_non_null(top);
+
+    top->op = sdap_id_op_create(top, test_ctx->conn_cache);
+    assert_non_null(top->op);
+
+    req = sdap_id_op_connect_send(top->op, top, &ret);
+    assert_int_equal(ret, EOK);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_op_connected, top);
+
+    return top;
+}
+
+static void wait_for_op(struct test_op *top)
+{
+    while (!top->done) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static void assert_op_connected(struct test_op *top)
+{
+    assert_true(top->done);
+    assert_int_equal(top->ret, EOK);
+    assert_int_equal(top->dp_error, DP_ERR_OK);
+    assert_non_null(sdap_id_op_handle(top->op));
+}
+
+static void set_pool_size(int pool_size)
+{
+    int ret;
+
+    ret = dp_opt_set_int(test_ctx->id_ctx->opts->basic,
+                         SDAP_CONNECTION_POOL_SIZE, pool_size);
+    assert_int_equal(ret, EOK);
+}
+
+static int count_connections(void)
+{
+    struct sdap_id_conn_data *conn_data;
+    int count = 0;
+
+    DLIST_FOR_EACH(conn_data, test_ctx->conn_cache->connections) {
+        count++;
+    }
+
+    return count;
+}
+
+static int test_sdap_id_op_setup(void **state)
+{
+    int ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_sdap_id_op_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->be = talloc_zero(test_ctx, struct be_ctx);
+    assert_non_null(test_ctx->be);
+    test_ctx->be->ev = test_ctx->ev;
+
+    test_ctx->be->domain = talloc_zero(test_ctx->be, struct sss_domain_info);
+    assert_non_null(test_ctx->be->domain);
+    test_ctx->be->domain->name = talloc_strdup(test_ctx->be->domain,
+                                               "ldap.test");
+    assert_non_null(test_ctx->be->domain->name);
+
+    test_ctx->id_ctx = talloc_zero(test_ctx, struct sdap_id_ctx);
+    assert_non_null(test_ctx->id_ctx);
+    test_ctx->id_ctx->be = test_ctx->be;
+
+    test_ctx->id_ctx->opts = talloc_zero(test_ctx->id_ctx,
+                                         struct sdap_options);
+    assert_non_null(test_ctx->id_ctx->opts);
+
+    ret = dp_copy_defaults(test_ctx->id_ctx->opts, default_basic_opts,
+                           SDAP_OPTS_BASIC, &test_ctx->id_ctx->opts->basic);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->id_conn = talloc_zero(test_ctx, struct sdap_id_conn_ctx);
+    assert_non_null(test_ctx->id_conn);
+    test_ctx->id_conn->id_ctx = test_ctx->id_ctx;
+
+    test_ctx->id_conn->service = talloc_zero(test_ctx->id_conn,
+                                             struct sdap_service);
+    assert_non_null(test_ctx->id_conn->service);
+    test_ctx->id_conn->service->name = talloc_strdup(
+                                            test_ctx->id_conn->service,
+                                            "LDAP");
+    assert_non_null(test_ctx->id_conn->service->name);
+
+    ret = sdap_id_conn_cache_create(test_ctx->id_conn, test_ctx->id_conn,
+                                    &test_ctx->conn_cache);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_sdap_id_op_teardown(void **state)
+{
+    struct test_sdap_id_op_ctx *ctx = talloc_get_type_abort(*state,
+                                                struct test_sdap_id_op_ctx);
+
+    talloc_free(ctx);
+    test_ctx = NULL;
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Tests =================================== */
+
+/* An idle cached connection is used again instead of opening a new one */
+void test_sdap_id_op_pool_reuse(void **state)
+{
+    struct test_op *op1;
+    struct test_op *op2;
+    struct sdap_id_conn_data *conn_data;
+    int dp_error;
+    int ret;
+
+    set_pool_size(2);
+
+    op1 = start_op();
+    assert_int_equal(test_ctx->num_connects, 1);
+    finish_connect(0, EOK);
+    assert_op_connected(op1);
+
+    ret = sdap_id_op_done(op1->op, EOK, &dp_error);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_error, DP_ERR_OK);
+
+    conn_data = test_ctx->conn_cache->cached_connections[0];
+    assert_non_null(conn_data);
+    assert_int_equal(conn_data->num_ops, 0);
+
+    op2 = start_op();
+    wait_for_op(op2);
+    assert_op_connected(op2);
+
+    assert_int_equal(test_ctx->num_connects, 1);
+    assert_int_equal(count_connections(), 1);
+    assert_ptr_equal(sdap_id_op_handle(op2->op), conn_data->sh);
+    assert_int_equal(conn_data->total_ops, 2);
+    assert_int_equal(conn_data->max_ops, 1);
+
+    talloc_free(op1);
+    talloc_free(op2);
+}
+
+/* Busy connections make the pool grow up to its size, further operations
+ * share the least busy connection */
+void test_sdap_id_op_pool_size(void **state)
+{
+    struct test_op *op1;
+    struct test_op *op2;
+    struct test_op *op3;
+    struct sdap_id_conn_data *conn_a;
+    struct sdap_id_conn_data *conn_b;
+
+    set_pool_size(2);
+
+    op1 = start_op();
+    op2 = start_op();
+    op3 = start_op();
+    assert_int_equal(test_ctx->num_connects, 2);
+    assert_int_equal(count_connections(), 2);
+
+    conn_a = test_ctx->conn_cache->cached_connections[0];
+    conn_b = test_ctx->conn_cache->cached_connections[1];
+    assert_non_null(conn_a);
+    assert_non_null(conn_b);
+    assert_int_equal(conn_a->num_ops, 2);
+    assert_int_equal(conn_b->num_ops, 1);
+
+    finish_connect(0, EOK);
+    finish_connect(1, EOK);
+    assert_op_connected(op1);
+    assert_op_connected(op2);
+    assert_op_connected(op3);
+
+    assert_ptr_equal(sdap_id_op_handle(op1->op), conn_a->sh);
+    assert_ptr_equal(sdap_id_op_handle(op2->op), conn_b->sh);
+    assert_ptr_equal(sdap_id_op_handle(op3->op), conn_a->sh);
+    assert_int_equal(conn_a->max_ops, 2);
+
+    talloc_free(op1);
+    talloc_free(op2);
+    talloc_free(op3);
+}
+
+/* ldap_connection_pool_size is capped at SDAP_ID_CONN_POOL_MAX */
+void test_sdap_id_op_pool_size_cap(void **state)
+{
+    struct test_op *ops[SDAP_ID_CONN_POOL_MAX + 1];
+    int i;
+
+    set_pool_size(SDAP_ID_CONN_POOL_MAX * 2);
+    assert_int_equal(sdap_id_conn_cache_pool_size(test_ctx->conn_cache),
+                     SDAP_ID_CONN_POOL_MAX);
+
+    set_pool_size(0);
+    assert_int_equal(sdap_id_conn_cache_pool_size(test_ctx->conn_cache), 1);
+
+    set_pool_size(SDAP_ID_CONN_POOL_MAX * 2);
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX + 1; i++) {
+        ops[i] = start_op();
+    }
+    assert_int_equal(test_ctx->num_connects, SDAP_ID_CONN_POOL_MAX);
+    assert_int_equal(count_connections(), SDAP_ID_CONN_POOL_MAX);
+
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        finish_connect(i, EOK);
+    }
+
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX + 1; i++) {
+        assert_op_connected(ops[i]);
+        talloc_free(ops[i]);
+    }
+}
+
+/* A communication error drops the failing connection, the rest of the pool
+ * is not reused and a failed connection attempt leaves nothing behind */
+void test_sdap_id_op_pool_release_on_error(void **state)
+{
+    struct test_op *op1;
+    struct test_op *op2;
+    struct test_op *op3;
+    struct sdap_id_conn_data *conn_b;
+    int dp_error;
+    int ret;
+    int i;
+
+    set_pool_size(2);
+
+    op1 = start_op();
+    op2 = start_op();
+    finish_connect(0, EOK);
+    finish_connect(1, EOK);
+    assert_op_connected(op1);
+    assert_op_connected(op2);
+
+    conn_b = test_ctx->conn_cache->cached_connections[1];
+    assert_non_null(conn_b);
+
+    ret = sdap_id_op_done(op1->op, EIO, &dp_error);
+    assert_int_equal(ret, EAGAIN);
+    assert_int_equal(dp_error, DP_ERR_OK);
+    assert_int_equal(test_ctx->num_next_server, 1);
+
+    /* the failed connection is gone, the other one is being abandoned */
+    assert_null(test_ctx->conn_cache->cached_connections[0]);
+    assert_int_equal(count_connections(), 1);
+    assert_ptr_equal(test_ctx->conn_cache->connections, conn_b);
+    assert_true(conn_b->disconnecting);
+
+    ret = sdap_id_op_done(op2->op, EOK, &dp_error);
+    assert_int_equal(ret, EOK);
+
+    op3 = start_op();
+    assert_int_equal(test_ctx->num_connects, 3);
+    assert_int_equal(count_connections(), 1);
+    assert_non_null(test_ctx->conn_cache->connections->connect_req);
+
+    finish_connect(2, ECONNREFUSED);
+    assert_true(op3->done);
+    assert_int_equal(op3->ret, EAGAIN);
+    assert_int_equal(op3->dp_error, DP_ERR_OFFLINE);
+    assert_true(test_ctx->offline);
+
+    assert_null(sdap_id_op_handle(op3->op));
+    assert_null(test_ctx->conn_cache->connections);
+    for (i = 0; i < SDAP_ID_CONN_POOL_MAX; i++) {
+        assert_null(test_ctx->conn_cache->cached_connections[i]);
+    }
+
+    talloc_free(op1);
+    talloc_free(op2);
+    talloc_free(op3);
+}
+
+/* Online callbacks run only when the pool gets its first usable connection */
+void test_sdap_id_op_pool_online_cb(void **state)
+{
+    struct test_op *op1;
+    struct test_op *op2;
+    struct test_op *op3;
+    int dp_error;
+    int ret;
+
+    set_pool_size(2);
+
+    op1 = start_op();
+    op2 = start_op();
+    assert_int_equal(test_ctx->num_connects, 2);
+
+    finish_connect(0, EOK);
+    assert_op_connected(op1);
+    assert_int_equal(test_ctx->num_online_cb, 1);
+
+    /* the pool grows, the backend was already online */
+    finish_connect(1, EOK);
+    assert_op_connected(op2);
+    assert_int_equal(test_ctx->num_online_cb, 1);
+
+    /* the remaining connection is abandoned after an error, the next one
+     * is the first usable connection again */
+    ret = sdap_id_op_done(op1->op, EIO, &dp_error);
+    assert_int_equal(ret, EAGAIN);
+    ret = sdap_id_op_done(op2->op, EOK, &dp_error);
+    assert_int_equal(ret, EOK);
+
+    op3 = start_op();
+    assert_int_equal(test_ctx->num_connects, 3);
+    finish_connect(2, EOK);
+    assert_op_connected(op3);
+    assert_int_equal(test_ctx->num_online_cb, 2);
+
+    talloc_free(op1);
+    talloc_free(op2);
+    talloc_free(op3);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sdap_id_op_pool_reuse,
+                                        test_sdap_id_op_setup,
+                                        test_sdap_id_op_teardown),
+        cmocka_unit_test_setup_teardown(test_sdap_id_op_pool_size,
+                                        test_sdap_id_op_setup,
+                                        test_sdap_id_op_teardown),
+        cmocka_unit_test_setup_teardown(test_sdap_id_op_pool_size_cap,
+                                        test_sdap_id_op_setup,
+                                        test_sdap_id_op_teardown),
+        cmocka_unit_test_setup_teardown(test_sdap_id_op_pool_release_on_error,
+                                        test_sdap_id_op_setup,
+                                        test_sdap_id_op_teardown),
+        cmocka_unit_test_setup_teardown(test_sdap_id_op_pool_online_cb,
+                                        test_sdap_id_op_setup,
+                                        test_sdap_id_op_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
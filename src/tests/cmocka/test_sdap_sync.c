@@ -0,0 +1,919 @@
+/*
+    SSSD
+
+    Tests for the LDAP change stream
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_be.h"
+#include "tests/cmocka/common_mock_sdap.h"
+
+#include "providers/ldap/sdap_sync.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_sdap_sync_conf.ldb"
+#define TEST_DOM_NAME "sdap_sync_test"
+#define TEST_ID_PROVIDER "ldap"
+#define TEST_BASE "dc=example,dc=com"
+
+#define TEST_UUID_11 "11111111-1111-1111-1111-111111111111"
+#define TEST_UUID_22 "22222222-2222-2222-2222-222222222222"
+#define TEST_UUID_33 "33333333-3333-3333-3333-333333333333"
+
+struct test_sync_ctx {
+    struct sss_test_ctx *tctx;
+    struct sdap_id_ctx *id_ctx;
+    struct sdap_domain *sdom;
+    struct sdap_sync_ctx *sctx;
+
+    /* lookups and enumerations in the order they were started */
+    char *lookups;
+};
+
+static struct test_sync_ctx *sync_test_ctx;
+
+/* A reply as seen by the wrapped libldap functions */
+struct test_ldap_msg {
+    LDAPControl **ctrls;
+    const char *oid;
+    struct berval *data;
+    int result;
+    const char *object_class;
+    const char *name;
+};
+
+/* ====================== Mocks =================================== */
+
+int __wrap_ldap_get_entry_controls(LDAP *ld, LDAPMessage *entry,
+                                   LDAPControl ***sctrls)
+{
+    struct test_ldap_msg *msg = (struct test_ldap_msg *)(void *)entry;
+
+    *sctrls = ldap_controls_dup(msg->ctrls);
+    return LDAP_SUCCESS;
+}
+
+struct berval **__wrap_ldap_get_values_len(LDAP *ld, LDAPMessage *entry,
+                                           const char *target)
+{
+    struct test_ldap_msg *msg = (struct test_ldap_msg *)(void *)entry;
+    struct berval **vals;
+    const char *value;
+
+    if (strcasecmp(target, "objectClass") == 0) {
+        value = msg->object_class;
+    } else {
+        value = msg->name;
+    }
+
+    if (value == NULL) {
+        return NULL;
+    }
+
+    vals = ber_memcalloc(2, sizeof(struct berval *));
+    assert_non_null(vals);
+    vals[0] = ber_bvstrdup(value);
+    assert_non_null(vals[0]);
+
+    return vals;
+}
+
+int __wrap_ldap_parse_intermediate(LDAP *ld, LDAPMessage *res,
+                                   char **retoidp, struct berval **retdatap,
+                                   LDAPControl ***serverctrls, int freeit)
+{
+    struct test_ldap_msg *msg = (struct test_ldap_msg *)(void *)res;
+
+    *retoidp = msg->oid != NULL ? ber_strdup(msg->oid) : NULL;
+    *retdatap = msg->data != NULL ? ber_bvdup(msg->data) : NULL;
+    return LDAP_SUCCESS;
+}
+
+int __wrap_ldap_parse_result(LDAP *ld, LDAPMessage *res, int *errcodep,
+                             char **matcheddnp, char **errmsgp,
+                             char ***referralsp, LDAPControl ***serverctrls,
+                             int freeit)
+{
+    struct test_ldap_msg *msg = (struct test_ldap_msg *)(void *)res;
+
+    *errcodep = msg->result;
+    if (errmsgp != NULL) {
+        *errmsgp = NULL;
+    }
+    *serverctrls = ldap_controls_dup(msg->ctrls);
+    return LDAP_SUCCESS;
+}
+
+static void record_lookup(const char *type, const char *name)
+{
+    sync_test_ctx->lookups = talloc_asprintf_append(sync_test_ctx->lookups,
+                                                    "%s:%s ", type, name);
+    assert_non_null(sync_test_ctx->lookups);
+}
+
+struct tevent_req *users_get_send(TALLOC_CTX *memctx,
+                                  struct tevent_context *ev,
+                                  struct sdap_id_ctx *ctx,
+                                  struct sdap_domain *sdom,
+                                  struct sdap_id_conn_ctx *conn,
+                                  const char *filter_value,
+                                  int filter_type,
+                                  const char *extra_value,
+                                  bool noexist_delete)
+{
+    assert_int_equal(filter_type, BE_FILTER_NAME);
+    record_lookup("user", filter_value);
+
+    return test_request_send(memctx, ev, sss_mock_type(errno_t));
+}
+
+int users_get_recv(struct tevent_req *req, int *dp_error_out, int *sdap_ret)
+{
+    *dp_error_out = DP_ERR_OK;
+    *sdap_ret = EOK;
+    return test_request_recv(req);
+}
+
+struct tevent_req *groups_get_send(TALLOC_CTX *memctx,
+                                   struct tevent_context *ev,
+                                   struct sdap_id_ctx *ctx,
+                                   struct sdap_domain *sdom,
+                                   struct sdap_id_conn_ctx *conn,
+                                   const char *name,
+                                   int filter_type,
+                                   bool noexist_delete,
+                                   bool no_members)
+{
+    assert_int_equal(filter_type, BE_FILTER_NAME);
+    record_lookup("group", name);
+
+    return test_request_send(memctx, ev, sss_mock_type(errno_t));
+}
+
+int groups_get_recv(struct tevent_req *req, int *dp_error_out, int *sdap_ret)
+{
+    *dp_error_out = DP_ERR_OK;
+    *sdap_ret = EOK;
+    return test_request_recv(req);
+}
+
+static struct tevent_req *test_enum_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         struct be_ctx *be_ctx,
+                                         struct be_ptask *be_ptask,
+                                         void *pvt)
+{
+    struct ldap_enum_ctx *ectx = talloc_get_type_abort(pvt,
+                                                      struct ldap_enum_ctx);
+
+    assert_ptr_equal(ectx->sdom, sync_test_ctx->sdom);
+    assert_ptr_equal(ectx->pvt, sync_test_ctx);
+    record_lookup("enum", ectx->sdom->dom->name);
+
+    return test_request_send(mem_ctx, ev, sss_mock_type(errno_t));
+}
+
+static errno_t test_enum_recv(struct tevent_req *req)
+{
+    return test_request_recv(req);
+}
+
+/* ====================== Utilities =============================== */
+
+static LDAPControl *sync_control(const char *oid, BerElement *ber)
+{
+    struct berval *val = NULL;
+    LDAPControl *ctrl = NULL;
+    int lret;
+
+    lret = ber_flatten(ber, &val);
+    assert_int_equal(lret, 0);
+
+    lret = ldap_control_create(oid, 0, val, 1, &ctrl);
+    assert_int_equal(lret, LDAP_SUCCESS);
+
+    ber_bvfree(val);
+    ber_free(ber, 1);
+    return ctrl;
+}
+
+static void sync_uuid(uint8_t byte, uint8_t *buf, struct berval *bv)
+{
+    memset(buf, byte, GUID_BIN_LENGTH);
+    bv->bv_val = (char *)buf;
+    bv->bv_len = GUID_BIN_LENGTH;
+}
+
+static void feed_entry(struct sdap_sync_ctx *sctx, ber_int_t state,
+                       uint8_t uuid_byte, const char *object_class,
+                       const char *name, const char *cookie)
+{
+    struct test_ldap_msg msg = { 0 };
+    LDAPControl *ctrls[2] = { NULL, NULL };
+    uint8_t uuid_buf[GUID_BIN_LENGTH];
+    struct berval uuid;
+    struct berval cookie_bv;
+    BerElement *ber;
+    errno_t ret;
+
+    sync_uuid(uuid_byte, uuid_buf, &uuid);
+
+    ber = ber_alloc_t(LBER_USE_DER);
+    assert_non_null(ber);
+    if (cookie != NULL) {
+        ber_str2bv(cookie, 0, 0, &cookie_bv);
+        assert_int_not_equal(ber_printf(ber, "{eOO}", state, &uuid,
+                                        &cookie_bv), -1);
+    } else {
+        assert_int_not_equal(ber_printf(ber, "{eO}", state, &uuid), -1);
+    }
+    ctrls[0] = sync_control(LDAP_CONTROL_SYNC_STATE, ber);
+
+    msg.ctrls = ctrls;
+    msg.object_class = object_class;
+    msg.name = name;
+
+    ret = sdap_syncrepl_entry(sctx, NULL, (LDAPMessage *)(void *)&msg);
+    assert_int_equal(ret, EOK);
+
+    ldap_control_free(ctrls[0]);
+}
+
+static void feed_info(struct sdap_sync_ctx *sctx, const char *oid,
+                      BerElement *ber)
+{
+    struct test_ldap_msg msg = { 0 };
+    struct berval *data = NULL;
+    errno_t ret;
+
+    assert_int_equal(ber_flatten(ber, &data), 0);
+    ber_free(ber, 1);
+
+    msg.oid = oid;
+    msg.data = data;
+
+    ret = sdap_syncrepl_info(sctx, NULL, (LDAPMessage *)(void *)&msg);
+    assert_int_equal(ret, EOK);
+
+    ber_bvfree(data);
+}
+
+static void feed_id_set(struct sdap_sync_ctx *sctx, bool refresh_deletes,
+                        uint8_t uuid1, uint8_t uuid2, const char *cookie)
+{
+    uint8_t buf1[GUID_BIN_LENGTH];
+    uint8_t buf2[GUID_BIN_LENGTH];
+    struct berval uuids[3] = { { 0, NULL }, { 0, NULL }, { 0, NULL } };
+    struct berval cookie_bv;
+    BerElement *ber;
+
+    sync_uuid(uuid1, buf1, &uuids[0]);
+    sync_uuid(uuid2, buf2, &uuids[1]);
+    ber_str2bv(cookie, 0, 0, &cookie_bv);
+
+    ber = ber_alloc_t(LBER_USE_DER);
+    assert_non_null(ber);
+    if (refresh_deletes) {
+        assert_int_not_equal(ber_printf(ber, "t{Ob[W]}",
+                                        LDAP_TAG_SYNC_ID_SET, &cookie_bv,
+                                        (ber_int_t)1, uuids), -1);
+    } else {
+        assert_int_not_equal(ber_printf(ber, "t{O[W]}",
+                                        LDAP_TAG_SYNC_ID_SET, &cookie_bv,
+                                        uuids), -1);
+    }
+
+    feed_info(sctx, LDAP_SYNC_INFO, ber);
+}
+
+static void feed_result(struct sdap_sync_ctx *sctx, int result,
+                        const char *cookie)
+{
+    struct test_ldap_msg msg = { 0 };
+    LDAPControl *ctrls[2] = { NULL, NULL };
+    struct berval cookie_bv;
+    BerElement *ber;
+
+    if (cookie != NULL) {
+        ber = ber_alloc_t(LBER_USE_DER);
+        assert_non_null(ber);
+        ber_str2bv(cookie, 0, 0, &cookie_bv);
+        assert_int_not_equal(ber_printf(ber, "{O}", &cookie_bv), -1);
+        ctrls[0] = sync_control(LDAP_CONTROL_SYNC_DONE, ber);
+    }
+
+    msg.ctrls = ctrls;
+    msg.result = result;
+
+    sdap_syncrepl_result(sctx, NULL, (LDAPMessage *)(void *)&msg);
+
+    ldap_control_free(ctrls[0]);
+}
+
+static void assert_cookie(const char *cookie, const char *expected)
+{
+    char *encoded;
+
+    if (expected == NULL) {
+        assert_null(cookie);
+        return;
+    }
+
+    encoded = sss_base64_encode(NULL, (const uint8_t *)expected,
+                                strlen(expected));
+    assert_non_null(encoded);
+    assert_non_null(cookie);
+    assert_string_equal(cookie, encoded);
+    talloc_free(encoded);
+}
+
+static void assert_stored_cookie(struct sss_domain_info *dom,
+                                 const char *expected)
+{
+    const char *cookie = NULL;
+    errno_t ret;
+
+    ret = sysdb_get_change_stream_cookie(sync_test_ctx, dom, &cookie);
+    assert_int_equal(ret, EOK);
+    assert_cookie(cookie, expected);
+    talloc_free(discard_const(cookie));
+}
+
+static void set_stored_cookie(struct sdap_sync_ctx *sctx, const char *cookie)
+{
+    struct berval bv;
+    errno_t ret;
+
+    ber_str2bv(cookie, 0, 0, &bv);
+    ret = sdap_sync_set_cookie(sctx, &bv);
+    assert_int_equal(ret, EOK);
+
+    sdap_sync_store_cookie(sctx);
+    assert_false(sctx->cookie_dirty);
+}
+
+/* expected is a space separated list of type:value */
+static void assert_queue(struct sdap_sync_ctx *sctx, const char *expected)
+{
+    struct sdap_sync_change *change;
+    char *queue;
+    size_t count = 0;
+
+    queue = talloc_strdup(sctx, "");
+    assert_non_null(queue);
+
+    DLIST_FOR_EACH(change, sctx->changes) {
+        queue = talloc_asprintf_append(queue, "%s:%s ",
+                                       sdap_sync_type_str(change->type),
+                                       change->value);
+        assert_non_null(queue);
+        count++;
+    }
+
+    assert_string_equal(queue, expected);
+    assert_int_equal(sctx->num_queued, count);
+    talloc_free(queue);
+}
+
+static void store_user(struct sss_domain_info *dom, const char *name,
+                       uid_t uid, const char *uuid)
+{
+    struct sysdb_attrs *attrs = NULL;
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(sync_test_ctx, name, dom->name);
+    assert_non_null(fqname);
+
+    if (uuid != NULL) {
+        attrs = sysdb_new_attrs(fqname);
+        assert_non_null(attrs);
+        ret = sysdb_attrs_add_string(attrs, SYSDB_UUID, uuid);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_store_user(dom, fqname, "*", uid, uid, name, "/home/user",
+                           "/bin/sh", NULL, attrs, NULL, 300, 0);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(fqname);
+}
+
+static bool user_is_cached(struct sss_domain_info *dom, const char *name)
+{
+    struct ldb_message *msg;
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(sync_test_ctx, name, dom->name);
+    assert_non_null(fqname);
+
+    ret = sysdb_search_user_by_name(fqname, dom, fqname, NULL, &msg);
+    talloc_free(fqname);
+
+    return ret == EOK;
+}
+
+static void wait_for_apply(struct sdap_sync_ctx *sctx)
+{
+    while (sctx->apply_req != NULL || sctx->rewind_te != NULL) {
+        assert_int_equal(tevent_loop_once(sctx->ev), 0);
+    }
+}
+
+static int test_sync_setup(void **state)
+{
+    struct test_sync_ctx *test_ctx;
+    struct sdap_options *opts;
+    struct be_ctx *be_ctx;
+    errno_t ret;
+    struct sss_test_conf_param params[] = {
+        { "ldap_search_base", TEST_BASE },
+        { "ldap_change_stream", "syncrepl" },
+        { NULL, NULL },
+    };
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_sync_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         params);
+    assert_non_null(test_ctx->tctx);
+
+    opts = mock_sdap_options_ldap(test_ctx, test_ctx->tctx->dom,
+                                  test_ctx->tctx->confdb,
+                                  test_ctx->tctx->conf_dom_path);
+    assert_non_null(opts);
+
+    be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    test_ctx->id_ctx = mock_sdap_id_ctx(test_ctx, be_ctx, opts);
+    test_ctx->sdom = opts->sdom;
+
+    test_ctx->lookups = talloc_strdup(test_ctx, "");
+    assert_non_null(test_ctx->lookups);
+
+    sync_test_ctx = test_ctx;
+
+    ret = sdap_sync_ctx_init(test_ctx, test_ctx->id_ctx, test_ctx->sdom,
+                             SDAP_CHANGE_STREAM_SYNCREPL,
+                             test_enum_send, test_enum_recv, test_ctx,
+                             &test_ctx->sctx);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_sync_teardown(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+
+    sync_test_ctx = NULL;
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Tests =================================== */
+
+void test_sync_entry_queue(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x01, "posixAccount", "alice", "c1");
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x02, "posixGroup", "admins", "c2");
+    /* neither a user nor a group, only the cookie is taken */
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x03, "device", "printer", "c3");
+    feed_entry(sctx, LDAP_SYNC_DELETE, 0x11, NULL, NULL, NULL);
+    /* already queued */
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x01, "posixAccount", "alice", NULL);
+    /* unchanged */
+    feed_entry(sctx, LDAP_SYNC_PRESENT, 0x04, "posixAccount", "bob", NULL);
+
+    assert_queue(sctx, "user:alice group:admins delete:"TEST_UUID_11" ");
+    assert_int_equal(sctx->stats.received, 4);
+
+    /* the cookie is kept until the changes are applied */
+    assert_cookie(sctx->cookie, "c3");
+    assert_true(sctx->cookie_dirty);
+    assert_stored_cookie(sctx->dom, NULL);
+}
+
+void test_sync_info(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+    struct berval cookie_bv;
+    BerElement *ber;
+
+    /* newcookie */
+    ber = ber_alloc_t(LBER_USE_DER);
+    assert_non_null(ber);
+    ber_str2bv("n1", 0, 0, &cookie_bv);
+    assert_int_not_equal(ber_printf(ber, "tO", LDAP_TAG_SYNC_NEW_COOKIE,
+                                    &cookie_bv), -1);
+    feed_info(sctx, LDAP_SYNC_INFO, ber);
+    assert_cookie(sctx->cookie, "n1");
+    assert_queue(sctx, "");
+
+    /* syncIdSet of deleted entries */
+    feed_id_set(sctx, true, 0x22, 0x33, "n2");
+    assert_cookie(sctx->cookie, "n2");
+    assert_queue(sctx, "delete:"TEST_UUID_22" delete:"TEST_UUID_33" ");
+
+    /* syncIdSet of present entries is left to the cleanup task */
+    feed_id_set(sctx, false, 0x44, 0x55, "n3");
+    assert_cookie(sctx->cookie, "n3");
+    assert_queue(sctx, "delete:"TEST_UUID_22" delete:"TEST_UUID_33" ");
+
+    /* end of the refresh phase */
+    ber = ber_alloc_t(LBER_USE_DER);
+    assert_non_null(ber);
+    ber_str2bv("n4", 0, 0, &cookie_bv);
+    assert_int_not_equal(ber_printf(ber, "t{O}",
+                                    LDAP_TAG_SYNC_REFRESH_DELETE,
+                                    &cookie_bv), -1);
+    feed_info(sctx, LDAP_SYNC_INFO, ber);
+    assert_cookie(sctx->cookie, "n4");
+
+    /* other intermediate responses are ignored */
+    ber = ber_alloc_t(LBER_USE_DER);
+    assert_non_null(ber);
+    ber_str2bv("n5", 0, 0, &cookie_bv);
+    assert_int_not_equal(ber_printf(ber, "tO", LDAP_TAG_SYNC_NEW_COOKIE,
+                                    &cookie_bv), -1);
+    feed_info(sctx, "1.2.3.4", ber);
+    assert_cookie(sctx->cookie, "n4");
+
+    assert_queue(sctx, "delete:"TEST_UUID_22" delete:"TEST_UUID_33" ");
+    assert_stored_cookie(sctx->dom, NULL);
+}
+
+void test_sync_apply(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+
+    store_user(sctx->dom, "alice", 10001, NULL);
+    store_user(sctx->dom, "carol", 10003, TEST_UUID_11);
+
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x01, "posixAccount", "alice", "c1");
+    /* not cached, read on its first lookup */
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x02, "posixAccount", "bob", "c2");
+    feed_entry(sctx, LDAP_SYNC_DELETE, 0x11, NULL, NULL, "c3");
+
+    will_return(users_get_send, EOK);
+    sdap_sync_apply_next(sctx);
+
+    /* the lookup of alice is running */
+    assert_non_null(sctx->apply_req);
+    assert_stored_cookie(sctx->dom, NULL);
+
+    wait_for_apply(sctx);
+
+    assert_string_equal(test_ctx->lookups, "user:alice ");
+    assert_queue(sctx, "");
+    assert_false(user_is_cached(sctx->dom, "carol"));
+    assert_true(user_is_cached(sctx->dom, "alice"));
+    assert_int_equal(sctx->stats.applied, 1);
+    assert_int_equal(sctx->stats.deleted, 1);
+
+    assert_false(sctx->cookie_dirty);
+    assert_stored_cookie(sctx->dom, "c3");
+}
+
+void test_sync_apply_order(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+
+    sctx->dom->enumerate = true;
+
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x01, "posixGroup", "admins", "c1");
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x02, "posixAccount", "alice", "c2");
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x01, "posixGroup", "admins", "c3");
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x03, "posixAccount", "bob", "c4");
+
+    assert_queue(sctx, "group:admins user:alice user:bob ");
+
+    will_return(groups_get_send, EOK);
+    sdap_sync_apply_next(sctx);
+    assert_queue(sctx, "user:alice user:bob ");
+
+    /* changes reported while a lookup is running are queued behind,
+     * unless they are still waiting */
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x02, "posixAccount", "alice", "c5");
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x01, "posixGroup", "admins", "c6");
+    assert_queue(sctx, "user:alice user:bob group:admins ");
+    assert_stored_cookie(sctx->dom, NULL);
+
+    will_return(users_get_send, EOK);
+    will_return(users_get_send, EOK);
+    will_return(groups_get_send, EOK);
+    wait_for_apply(sctx);
+
+    assert_string_equal(test_ctx->lookups,
+                        "group:admins user:alice user:bob group:admins ");
+    assert_int_equal(sctx->stats.applied, 4);
+    assert_stored_cookie(sctx->dom, "c6");
+}
+
+void test_sync_apply_failure(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+
+    set_stored_cookie(sctx, "c0");
+    store_user(sctx->dom, "alice", 10001, NULL);
+    store_user(sctx->dom, "bob", 10002, NULL);
+
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x01, "posixAccount", "alice", "c1");
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x02, "posixAccount", "bob", "c2");
+
+    will_return(users_get_send, EIO);
+    will_return(users_get_send, EOK);
+    sdap_sync_apply_next(sctx);
+    wait_for_apply(sctx);
+
+    /* the changes are requested again from the last stored cookie */
+    assert_string_equal(test_ctx->lookups, "user:alice user:bob ");
+    assert_queue(sctx, "");
+    assert_cookie(sctx->cookie, "c0");
+    assert_false(sctx->cookie_dirty);
+    assert_stored_cookie(sctx->dom, "c0");
+    assert_false(sctx->apply_failed);
+    assert_non_null(sctx->start_te);
+}
+
+void test_sync_full_refresh(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+    char name[32];
+    errno_t ret;
+    int i;
+
+    sctx->dom->enumerate = true;
+
+    feed_entry(sctx, LDAP_SYNC_DELETE, 0x11, NULL, NULL, NULL);
+    for (i = 0; i < SDAP_SYNC_MAX_LOOKUPS - 1; i++) {
+        snprintf(name, sizeof(name), "user%d", i);
+        ret = sdap_sync_queue(sctx, SDAP_SYNC_USER, name);
+        assert_int_equal(ret, EOK);
+    }
+    assert_false(sctx->full_refresh);
+    assert_int_equal(sctx->num_queued, SDAP_SYNC_MAX_LOOKUPS);
+
+    /* one too many, the lookups are replaced by an enumeration */
+    feed_entry(sctx, LDAP_SYNC_ADD, 0x02, "posixGroup", "admins", "c1");
+    assert_true(sctx->full_refresh);
+    assert_queue(sctx, "delete:"TEST_UUID_11" ");
+
+    /* only deletions are queued until the enumeration finished */
+    feed_entry(sctx, LDAP_SYNC_MODIFY, 0x03, "posixAccount", "alice", NULL);
+    feed_entry(sctx, LDAP_SYNC_DELETE, 0x22, NULL, NULL, "c2");
+    assert_queue(sctx, "delete:"TEST_UUID_11" delete:"TEST_UUID_22" ");
+
+    will_return(test_enum_send, EOK);
+    sdap_sync_apply_next(sctx);
+    assert_stored_cookie(sctx->dom, NULL);
+    wait_for_apply(sctx);
+
+    assert_string_equal(test_ctx->lookups, "enum:"TEST_DOM_NAME" ");
+    assert_false(sctx->full_refresh);
+    assert_int_equal(sctx->stats.full_refreshes, 1);
+    assert_queue(sctx, "");
+    assert_stored_cookie(sctx->dom, "c2");
+}
+
+void test_sync_full_refresh_not_enumerating(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+    char name[32];
+    errno_t ret;
+    int i;
+
+    for (i = 0; i < SDAP_SYNC_MAX_LOOKUPS + 10; i++) {
+        snprintf(name, sizeof(name), "user%d", i);
+        ret = sdap_sync_queue(sctx, SDAP_SYNC_USER, name);
+        assert_int_equal(ret, EOK);
+    }
+
+    /* objects which are not cached are skipped instead */
+    assert_false(sctx->full_refresh);
+    assert_int_equal(sctx->num_queued, SDAP_SYNC_MAX_LOOKUPS + 10);
+
+    sdap_sync_apply_next(sctx);
+    wait_for_apply(sctx);
+
+    assert_string_equal(test_ctx->lookups, "");
+    assert_int_equal(sctx->num_queued, 0);
+}
+
+void test_sync_result(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_sync_ctx *sctx = test_ctx->sctx;
+
+    feed_entry(sctx, LDAP_SYNC_DELETE, 0x11, NULL, NULL, "c1");
+
+    /* the server ended the persist phase */
+    feed_result(sctx, LDAP_SUCCESS, "d1");
+    assert_queue(sctx, "");
+    assert_stored_cookie(sctx->dom, "d1");
+    assert_false(sctx->running);
+    assert_non_null(sctx->start_te);
+
+    /* the cookie is too old, start over */
+    feed_result(sctx, LDAP_SYNC_REFRESH_REQUIRED, NULL);
+    assert_null(sctx->cookie);
+    assert_stored_cookie(sctx->dom, NULL);
+    assert_non_null(sctx->start_te);
+}
+
+void test_sync_search_base(void **state)
+{
+    struct test_sync_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                       struct test_sync_ctx);
+    struct sdap_options *opts = test_ctx->id_ctx->opts;
+    struct sdap_domain *sdom = test_ctx->sdom;
+    enum sdap_change_stream mode;
+    const char *base;
+    int scope;
+    errno_t ret;
+
+    ret = sdap_sync_search_base(sdom, &base, &scope);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(base, TEST_BASE);
+    assert_int_equal(scope, LDAP_SCOPE_SUBTREE);
+
+    ret = sdap_change_stream_get(opts, sdom, &mode);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(mode, SDAP_CHANGE_STREAM_SYNCREPL);
+
+    /* the same base in both lists */
+    ret = dp_opt_set_string(opts->basic, SDAP_USER_SEARCH_BASE,
+                            "ou=People,"TEST_BASE"?onelevel?");
+    assert_int_equal(ret, EOK);
+    ret = dp_opt_set_string(opts->basic, SDAP_GROUP_SEARCH_BASE,
+                            "OU=people,"TEST_BASE"?onelevel?");
+    assert_int_equal(ret, EOK);
+    talloc_zfree(sdom->user_search_bases);
+    talloc_zfree(sdom->group_search_bases);
+    ret = sdap_parse_search_base(opts, opts->basic, SDAP_USER_SEARCH_BASE,
+                                 &sdom->user_search_bases);
+    assert_int_equal(ret, EOK);
+    ret = sdap_parse_search_base(opts, opts->basic, SDAP_GROUP_SEARCH_BASE,
+                                 &sdom->group_search_bases);
+    assert_int_equal(ret, EOK);
+
+    ret = sdap_sync_search_base(sdom, &base, &scope);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(base, "ou=People,"TEST_BASE);
+    assert_int_equal(scope, LDAP_SCOPE_ONELEVEL);
+
+    /* different bases of users and groups */
+    ret = dp_opt_set_string(opts->basic, SDAP_GROUP_SEARCH_BASE,
+                            "ou=Groups,"TEST_BASE"?onelevel?");
+    assert_int_equal(ret, EOK);
+    talloc_zfree(sdom->group_search_bases);
+    ret = sdap_parse_search_base(opts, opts->basic, SDAP_GROUP_SEARCH_BASE,
+                                 &sdom->group_search_bases);
+    assert_int_equal(ret, EOK);
+
+    ret = sdap_sync_search_base(sdom, &base, &scope);
+    assert_int_equal(ret, ENOTSUP);
+
+    ret = sdap_change_stream_get(opts, sdom, &mode);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(mode, SDAP_CHANGE_STREAM_NONE);
+
+    /* DirSync always follows the whole naming context */
+    ret = dp_opt_set_string(opts->basic, SDAP_CHANGE_STREAM, "dirsync");
+    assert_int_equal(ret, EOK);
+    ret = sdap_change_stream_get(opts, sdom, &mode);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(mode, SDAP_CHANGE_STREAM_DIRSYNC);
+
+    /* several user bases with the same scope */
+    ret = dp_opt_set_string(opts->basic, SDAP_CHANGE_STREAM, "syncrepl");
+    assert_int_equal(ret, EOK);
+    ret = dp_opt_set_string(opts->basic, SDAP_USER_SEARCH_BASE,
+                            "ou=People,"TEST_BASE"?onelevel??"
+                            "ou=Admins,"TEST_BASE"?onelevel?");
+    assert_int_equal(ret, EOK);
+    talloc_zfree(sdom->user_search_bases);
+    talloc_zfree(sdom->group_search_bases);
+    ret = sdap_parse_search_base(opts, opts->basic, SDAP_USER_SEARCH_BASE,
+                                 &sdom->user_search_bases);
+    assert_int_equal(ret, EOK);
+
+    ret = sdap_change_stream_get(opts, sdom, &mode);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(mode, SDAP_CHANGE_STREAM_NONE);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    int no_cleanup = 0;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sync_entry_queue,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_info,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_apply,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_apply_order,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_apply_failure,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_full_refresh,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_full_refresh_not_enumerating,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_result,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+        cmocka_unit_test_setup_teardown(test_sync_search_base,
+                                        test_sync_setup,
+                                        test_sync_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    test_dom_suite_setup(TESTS_PATH);
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    if (rv == 0 && no_cleanup == 0) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+    return rv;
+}
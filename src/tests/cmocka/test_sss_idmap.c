@@ -478,6 +478,87 @@ void test_map_id_external(void **state)
     assert_int_equal(err, IDMAP_EXTERNAL);
 }
 
+#define TEST_MANY_DOMS 100
+#define TEST_MANY_MIN 100000
+#define TEST_MANY_SIZE 1000
+
+static uint32_t test_many_min_id(unsigned int dom, unsigned int range)
+{
+    /* ranges of different domains alternate */
+    return TEST_MANY_MIN + (range * TEST_MANY_DOMS + dom) * TEST_MANY_SIZE;
+}
+
+void test_map_id_many_domains(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct sss_idmap_range range;
+    enum idmap_error_code err;
+    char *name;
+    char *dom_sid;
+    char *sid;
+    char *mapped_sid;
+    uint32_t id;
+    unsigned int i;
+    unsigned int r;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    assert_non_null(test_ctx);
+
+    for (i = 0; i < TEST_MANY_DOMS; i++) {
+        name = talloc_asprintf(test_ctx, "dom%u.test", i);
+        assert_non_null(name);
+        dom_sid = talloc_asprintf(test_ctx, "S-1-5-21-%u-2-3", i);
+        assert_non_null(dom_sid);
+
+        for (r = 0; r < 2; r++) {
+            range.min = test_many_min_id(i, r);
+            range.max = range.min + TEST_MANY_SIZE - 1;
+            err = sss_idmap_add_domain_ex(test_ctx->idmap_ctx, name, dom_sid,
+                                          &range, NULL, r * TEST_MANY_SIZE,
+                                          false);
+            assert_int_equal(err, IDMAP_SUCCESS);
+        }
+
+        talloc_free(name);
+        talloc_free(dom_sid);
+    }
+
+    for (i = 0; i < TEST_MANY_DOMS; i++) {
+        for (r = 0; r < 2; r++) {
+            sid = talloc_asprintf(test_ctx, "S-1-5-21-%u-2-3-%u", i,
+                                  r * TEST_MANY_SIZE + 5);
+            assert_non_null(sid);
+
+            err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sid, &id);
+            assert_int_equal(err, IDMAP_SUCCESS);
+            assert_int_equal(id, test_many_min_id(i, r) + 5);
+
+            err = sss_idmap_unix_to_sid(test_ctx->idmap_ctx, id, &mapped_sid);
+            assert_int_equal(err, IDMAP_SUCCESS);
+            assert_string_equal(mapped_sid, sid);
+            sss_idmap_free_sid(test_ctx->idmap_ctx, mapped_sid);
+            talloc_free(sid);
+        }
+    }
+
+    err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, "S-1-5-21-0-2-3-5000",
+                                &id);
+    assert_int_equal(err, IDMAP_NO_RANGE);
+
+    err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, "S-1-5-21-0-2-4-5", &id);
+    assert_int_equal(err, IDMAP_NO_DOMAIN);
+
+    err = sss_idmap_unix_to_sid(test_ctx->idmap_ctx,
+                                test_many_min_id(0, 2), &sid);
+    assert_int_equal(err, IDMAP_NO_DOMAIN);
+
+    /* SIDs with more components than the domain SID are invalid. */
+    err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, "S-1-5-21-0-2-3-4-5",
+                                &id);
+    assert_int_equal(err, IDMAP_SID_INVALID);
+}
+
 void test_check_sid_id(void **state)
 {
     struct test_ctx *test_ctx;
@@ -739,6 +820,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_map_id_external,
                                         test_sss_idmap_setup_with_external_mappings,
                                         test_sss_idmap_teardown),
+        cmocka_unit_test_setup_teardown(test_map_id_many_domains,
+                                        test_sss_idmap_setup,
+                                        test_sss_idmap_teardown),
         cmocka_unit_test_setup_teardown(test_check_sid_id,
                                         test_sss_idmap_setup_with_domains,
                                         test_sss_idmap_teardown),
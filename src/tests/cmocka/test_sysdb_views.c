@@ -801,6 +801,44 @@ static void test_sysdb_enumpwent_filter_views(void **state)
     check_enumpwent(ret, test_ctx->domain, res, true);
 }
 
+static void test_sysdb_enumpwent_page_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *res;
+    const char *after;
+
+    ret = sysdb_enumpwent_page_with_views(test_ctx, test_ctx->domain,
+                                          NULL, NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "alice", true);
+    assert_user_attrs(res->msgs[1], test_ctx->domain, "barney", true);
+
+    /* The next page starts after the original name */
+    after = ldb_msg_find_attr_as_string(res->msgs[1], SYSDB_NAME, NULL);
+    assert_non_null(after);
+
+    ret = sysdb_enumpwent_page_with_views(test_ctx, test_ctx->domain,
+                                          NULL, after, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "bob", true);
+
+    ret = sysdb_enumpwent_page_with_views(test_ctx, test_ctx->domain,
+                                          "b*", NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "barney", true);
+    assert_user_attrs(res->msgs[1], test_ctx->domain, "bob", true);
+
+    ret = sysdb_enumpwent_page_with_views(test_ctx, test_ctx->domain,
+                                          NULL, NULL,
+                                          SYSDB_ENUM_PAGE_MAX_SIZE + 1, &res);
+    assert_int_equal(ret, EINVAL);
+}
+
 static const char *groups[] = { "one", "two", "three", NULL };
 
 static void enum_test_group_override(struct sysdb_test_ctx *test_ctx,
@@ -1046,6 +1084,39 @@ static void test_sysdb_enumgrent_filter_views(void **state)
     check_enumgrent(ret, test_ctx->domain, res, true);
 }
 
+static void test_sysdb_enumgrent_page_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *res;
+    const char *after;
+
+    ret = sysdb_enumgrent_page_with_views(test_ctx, test_ctx->domain,
+                                          NULL, NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_group_attrs(res->msgs[0], test_ctx->domain,
+                       "one", TEST_GID_OVERRIDE_BASE);
+    assert_group_attrs(res->msgs[1], test_ctx->domain,
+                       "three", TEST_GID_OVERRIDE_BASE + 2);
+
+    after = ldb_msg_find_attr_as_string(res->msgs[1], SYSDB_NAME, NULL);
+    assert_non_null(after);
+
+    ret = sysdb_enumgrent_page_with_views(test_ctx, test_ctx->domain,
+                                          NULL, after, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_group_attrs(res->msgs[0], test_ctx->domain,
+                       "two", TEST_GID_OVERRIDE_BASE + 1);
+
+    ret = sysdb_enumgrent_page_with_views(test_ctx, test_ctx->domain,
+                                          "x*", NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 0);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -1084,6 +1155,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_filter,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_page_views,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_filter_views,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
@@ -1096,6 +1170,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_filter,
                                         test_enum_groups_setup,
                                         test_enum_groups_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_page_views,
+                                        test_enum_groups_setup,
+                                        test_enum_groups_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_filter_views,
                                         test_enum_groups_setup,
                                         test_enum_groups_teardown),
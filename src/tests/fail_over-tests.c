@@ -23,6 +23,9 @@
 */
 
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <check.h>
 #include <popt.h>
@@ -35,8 +38,8 @@
 #include "tests/common_check.h"
 #include "util/util.h"
 
-/* Interface under test */
-#include "providers/fail_over.h"
+/* Interface under test, included to reach the server list */
+#include "providers/fail_over.c"
 
 int use_net_test;
 
@@ -58,7 +61,7 @@ struct task {
 };
 
 static struct test_ctx *
-setup_test(void)
+setup_test_opts(int probe_timeout)
 {
     struct test_ctx *ctx;
     struct fo_options fopts;
@@ -82,6 +85,7 @@ setup_test(void)
     memset(&fopts, 0, sizeof(fopts));
     fopts.retry_timeout = 30;
     fopts.family_order  = IPV4_FIRST;
+    fopts.probe_timeout = probe_timeout;
 
     ctx->fo_ctx = fo_context_init(ctx, &fopts);
     if (ctx->fo_ctx == NULL) {
@@ -92,6 +96,12 @@ setup_test(void)
     return ctx;
 }
 
+static struct test_ctx *
+setup_test(void)
+{
+    return setup_test_opts(0);
+}
+
 static void
 test_loop(struct test_ctx *data)
 {
@@ -268,6 +278,110 @@ START_TEST(test_fo_resolve_service)
 }
 END_TEST
 
+/* Returns a socket bound to a free port on the loopback */
+static int
+bind_loopback(int *_port)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int sd;
+
+    sd = socket(AF_INET, SOCK_STREAM, 0);
+    fail_if(sd < 0, "socket() failed");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fail_if(bind(sd, (struct sockaddr *) &addr, sizeof(addr)) != 0,
+            "bind() failed");
+    fail_if(getsockname(sd, (struct sockaddr *) &addr, &len) != 0,
+            "getsockname() failed");
+
+    *_port = ntohs(addr.sin_port);
+    return sd;
+}
+
+START_TEST(test_fo_probe_servers)
+{
+    struct test_ctx *ctx;
+    struct fo_service *service;
+    int closed_port;
+    int open_port;
+    int sd;
+
+    ctx = setup_test_opts(1);
+    fail_if(ctx == NULL);
+
+    /* nobody listens on the first port any more */
+    sd = bind_loopback(&closed_port);
+    close(sd);
+
+    sd = bind_loopback(&open_port);
+    fail_if(listen(sd, 5) != 0, "listen() failed");
+
+    fail_if(fo_new_service(ctx->fo_ctx, "ldap", NULL, &service) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", closed_port,
+                          NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", open_port,
+                          NULL, true) != EOK);
+
+    /* the first server in the list is skipped, it did not answer */
+    get_request(ctx, service, EOK, open_port, PORT_WORKING, SERVER_WORKING);
+    fail_if(fo_get_active_server(service)->rtt < 0,
+            "Round trip time was not recorded");
+
+    /* the active server is used without probing */
+    get_request(ctx, service, EOK, open_port, -1, -1);
+
+    close(sd);
+    talloc_free(ctx);
+}
+END_TEST
+
+static struct fo_server *
+find_server(struct fo_service *service, int port)
+{
+    struct fo_server *server;
+
+    DLIST_FOR_EACH(server, service->server_list) {
+        if (server->port == port) {
+            return server;
+        }
+    }
+
+    fail("No server with port %d", port);
+    return NULL;
+}
+
+START_TEST(test_fo_prefer_fastest_server)
+{
+    struct test_ctx *ctx;
+    struct fo_service *service;
+
+    ctx = setup_test();
+    fail_if(ctx == NULL);
+
+    fail_if(fo_new_service(ctx->fo_ctx, "ldap", NULL, &service) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 389, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 390, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 391, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 392, NULL, false) != EOK);
+
+    /* a backup server is never preferred over a primary one */
+    find_server(service, 390)->rtt = 20;
+    find_server(service, 391)->rtt = 5;
+    find_server(service, 392)->rtt = 0;
+
+    get_request(ctx, service, EOK, 391, PORT_NOT_WORKING, -1);
+    get_request(ctx, service, EOK, 390, PORT_NOT_WORKING, -1);
+
+    /* nothing measured is left, fall back to the list order */
+    get_request(ctx, service, EOK, 389, PORT_WORKING, SERVER_WORKING);
+
+    talloc_free(ctx);
+}
+END_TEST
+
 Suite *
 create_suite(void)
 {
@@ -279,6 +393,8 @@ create_suite(void)
     /* Do some testing */
     tcase_add_test(tc, test_fo_new_service);
     tcase_add_test(tc, test_fo_resolve_service);
+    tcase_add_test(tc, test_fo_probe_servers);
+    tcase_add_test(tc, test_fo_prefer_fastest_server);
     if (use_net_test) {
     }
     /* Add all test cases to the test suite */
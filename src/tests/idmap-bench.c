@@ -0,0 +1,236 @@
+/*
+   SSSD
+
+   ID-mapping library benchmark
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures SID to ID and ID to SID conversions with many trusted domains.
+ * Every domain gets a number of slices, like the secondary slices which are
+ * added while mapping objects with large RIDs, and the objects are looked up
+ * in random domains and slices. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <popt.h>
+
+#include "lib/idmap/sss_idmap.h"
+
+#define DEFAULT_DOMAINS 500
+#define DEFAULT_SLICES  10
+#define DEFAULT_LOOKUPS 1000000
+#define BENCH_RANGESIZE 200000
+#define BENCH_LOWER     200000
+
+static double bench_elapsed(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec)
+            + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_report(const char *op, unsigned int ops, double secs)
+{
+    printf("%-10s %10u ops %10.3f s %12.0f ops/s\n",
+           op, ops, secs, secs > 0 ? ops / secs : 0);
+}
+
+static void bench_dom_sid(char *buf, size_t size, unsigned int dom)
+{
+    snprintf(buf, size, "S-1-5-21-%u-%u-%u", 1000 + dom, 2000 + dom * 7,
+             3000 + dom * 13);
+}
+
+/* Slices of all domains are interleaved so that the IDs of one domain are
+ * not adjacent. */
+static uint32_t bench_min_id(unsigned int domains, unsigned int dom,
+                             unsigned int slice)
+{
+    return BENCH_LOWER + (slice * domains + dom) * BENCH_RANGESIZE;
+}
+
+static enum idmap_error_code bench_add(struct sss_idmap_ctx *ctx,
+                                       unsigned int domains,
+                                       unsigned int slices)
+{
+    struct sss_idmap_range range;
+    enum idmap_error_code err;
+    char name[64];
+    char sid[64];
+    unsigned int dom;
+    unsigned int slice;
+
+    for (slice = 0; slice < slices; slice++) {
+        for (dom = 0; dom < domains; dom++) {
+            snprintf(name, sizeof(name), "dom%u.bench", dom);
+            bench_dom_sid(sid, sizeof(sid), dom);
+
+            range.min = bench_min_id(domains, dom, slice);
+            range.max = range.min + BENCH_RANGESIZE - 1;
+
+            err = sss_idmap_add_domain_ex(ctx, name, sid, &range, NULL,
+                                          slice * BENCH_RANGESIZE, false);
+            if (err != IDMAP_SUCCESS) {
+                fprintf(stderr, "Cannot add slice %u of %s: %s\n",
+                        slice, name, idmap_error_string(err));
+                return err;
+            }
+        }
+    }
+
+    return IDMAP_SUCCESS;
+}
+
+static int bench_run(unsigned int domains, unsigned int slices,
+                     unsigned int lookups)
+{
+    struct sss_idmap_ctx *ctx = NULL;
+    struct timespec start;
+    enum idmap_error_code err;
+    unsigned int dom;
+    unsigned int slice;
+    unsigned int i;
+    uint32_t offset;
+    uint32_t expected;
+    uint32_t id;
+    char dom_sid[64];
+    char sid[80];
+    char *out;
+
+    err = sss_idmap_init(NULL, NULL, NULL, &ctx);
+    if (err != IDMAP_SUCCESS) {
+        goto done;
+    }
+
+    err = sss_idmap_ctx_set_rangesize(ctx, BENCH_RANGESIZE);
+    if (err != IDMAP_SUCCESS) {
+        goto done;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    err = bench_add(ctx, domains, slices);
+    if (err != IDMAP_SUCCESS) {
+        goto done;
+    }
+    bench_report("add", domains * slices, bench_elapsed(&start));
+
+    srand(domains * slices);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < lookups; i++) {
+        dom = rand() % domains;
+        slice = rand() % slices;
+        offset = rand() % BENCH_RANGESIZE;
+
+        bench_dom_sid(dom_sid, sizeof(dom_sid), dom);
+        snprintf(sid, sizeof(sid), "%s-%u", dom_sid,
+                 slice * BENCH_RANGESIZE + offset);
+
+        err = sss_idmap_sid_to_unix(ctx, sid, &id);
+        expected = bench_min_id(domains, dom, slice) + offset;
+        if (err != IDMAP_SUCCESS || id != expected) {
+            fprintf(stderr, "Wrong mapping of %s\n", sid);
+            err = IDMAP_ERROR;
+            goto done;
+        }
+    }
+    bench_report("sid2unix", lookups, bench_elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < lookups; i++) {
+        dom = rand() % domains;
+        slice = rand() % slices;
+        offset = rand() % BENCH_RANGESIZE;
+
+        err = sss_idmap_unix_to_sid(ctx,
+                                    bench_min_id(domains, dom, slice) + offset,
+                                    &out);
+        if (err != IDMAP_SUCCESS) {
+            fprintf(stderr, "Cannot map ID of slice %u of domain %u\n",
+                    slice, dom);
+            goto done;
+        }
+        sss_idmap_free_sid(ctx, out);
+    }
+    bench_report("unix2sid", lookups, bench_elapsed(&start));
+
+    err = IDMAP_SUCCESS;
+
+done:
+    if (err != IDMAP_SUCCESS) {
+        fprintf(stderr, "Benchmark failed: %s\n", idmap_error_string(err));
+    }
+    if (ctx != NULL) {
+        sss_idmap_free(ctx);
+    }
+    return err;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int pc_domains = DEFAULT_DOMAINS;
+    int pc_slices = DEFAULT_SLICES;
+    int pc_lookups = DEFAULT_LOOKUPS;
+    int ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "domains", 'D', POPT_ARG_INT, &pc_domains, 0,
+          "Number of domains", NULL },
+        { "slices", 's', POPT_ARG_INT, &pc_slices, 0,
+          "Number of slices of each domain", NULL },
+        { "lookups", 'n', POPT_ARG_INT, &pc_lookups, 0,
+          "Number of lookups in each direction", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (pc_domains <= 0 || pc_slices <= 0 || pc_lookups <= 0) {
+        fprintf(stderr, "All numbers must be positive\n");
+        return 1;
+    }
+
+    /* all IDs have to fit into 32 bits */
+    if ((uint64_t)pc_domains * pc_slices
+            > (UINT32_MAX - BENCH_LOWER) / BENCH_RANGESIZE) {
+        fprintf(stderr, "Too many slices\n");
+        return 1;
+    }
+
+    ret = bench_run(pc_domains, pc_slices, pc_lookups);
+    if (ret != IDMAP_SUCCESS) {
+        return 2;
+    }
+
+    return 0;
+}
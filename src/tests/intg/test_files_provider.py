@@ -155,6 +155,22 @@ def files_domain_only(request):
     return None
 
 
+@pytest.fixture
+def files_domain_incremental_reload(request):
+    conf = unindent("""\
+        [sssd]
+        domains             = files
+        services            = nss
+
+        [domain/files]
+        id_provider = files
+        incremental_reload = true
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
 @pytest.fixture
 def files_multiple_sources(request):
     _, alt_passwd_path = tempfile.mkstemp(prefix='altpasswd')
@@ -630,6 +646,40 @@ def test_mod_user_shell(add_user_with_canary, files_domain_only):
     check_user(moduser)
 
 
+def test_mod_user_remove_shell(add_user_with_canary,
+                               files_domain_incremental_reload):
+    """
+    Test that removing a user shell is detected and the shell is removed
+    from the cached user instead of keeping the old value
+    """
+    res, user = sssd_getpwnam_sync(USER1["name"])
+    assert res == NssReturnCode.SUCCESS
+    assert user == USER1
+
+    moduser = dict(USER1)
+    moduser['shell'] = ''
+    add_user_with_canary.usermod(**moduser)
+
+    check_user(moduser)
+
+
+def test_mod_user_shell_incremental_reload(add_user_with_canary,
+                                           files_domain_incremental_reload):
+    """
+    Test that modifying a user shell is detected when only the changed
+    entries are written to the cache
+    """
+    res, user = sssd_getpwnam_sync(USER1["name"])
+    assert res == NssReturnCode.SUCCESS
+    assert user == USER1
+
+    moduser = dict(USER1)
+    moduser['shell'] = '/bin/zsh'
+    add_user_with_canary.usermod(**moduser)
+
+    check_user(moduser)
+
+
 def incomplete_user_setup(pwd_ops, del_field, exp_field):
     adduser = dict(USER1)
     del adduser[del_field]
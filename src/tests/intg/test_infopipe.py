@@ -573,3 +573,56 @@ def test_sssctl_domain_list_app_domain(dbus_system_bus,
     assert "Error" not in output
     assert output.find("LDAP") != -1
     assert output.find("app") != -1
+
+
+def list_paged(method, args, page_size):
+    paths = []
+    cursor = ''
+    while True:
+        res, cursor = method(*(args + [cursor, page_size]))
+        assert len(res) <= page_size
+        paths.extend(res)
+        if cursor == '':
+            return paths
+
+
+def test_list_by_name_paged(dbus_system_bus, ldap_conn, sanity_rfc2307):
+    users_obj = dbus_system_bus.get_object(
+                                        'org.freedesktop.sssd.infopipe',
+                                        '/org/freedesktop/sssd/infopipe/Users')
+    users_iface = dbus.Interface(users_obj,
+                                 "org.freedesktop.sssd.infopipe.Users")
+
+    expected = users_iface.ListByName('user*', 0)
+    assert len(expected) > 0
+
+    for page_size in (1, 2, 100):
+        paths = list_paged(users_iface.ListByNamePaged, ['user*'], page_size)
+        assert len(paths) == len(set(paths))
+        assert sorted(paths) == sorted(expected)
+
+    expected = users_iface.ListByDomainAndName('LDAP', 'user*', 0)
+    assert len(expected) == 3
+
+    paths = list_paged(users_iface.ListByDomainAndNamePaged,
+                       ['LDAP', 'user*'], 2)
+    assert sorted(paths) == sorted(expected)
+
+    groups_obj = dbus_system_bus.get_object(
+                                        'org.freedesktop.sssd.infopipe',
+                                        '/org/freedesktop/sssd/infopipe/Groups')
+    groups_iface = dbus.Interface(groups_obj,
+                                  "org.freedesktop.sssd.infopipe.Groups")
+
+    expected = groups_iface.ListByDomainAndName('LDAP', 'group*', 0)
+    assert len(expected) == 3
+
+    paths = list_paged(groups_iface.ListByDomainAndNamePaged,
+                       ['LDAP', 'group*'], 2)
+    assert sorted(paths) == sorted(expected)
+
+    # a cursor of another domain is rejected
+    res, cursor = users_iface.ListByDomainAndNamePaged('LDAP', 'user*', '', 1)
+    assert cursor != ''
+    with pytest.raises(dbus.exceptions.DBusException):
+        users_iface.ListByDomainAndNamePaged('app', 'user*', cursor, 1)
@@ -24,7 +24,6 @@ import pytest
 import socket
 import time
 import signal
-import sys
 from requests import HTTPError
 
 import kdc
@@ -35,12 +34,14 @@ from test_secrets import create_sssd_secrets_fixture
 from secrets import SecretsLocalClient
 
 MAX_SECRETS = 10
+WRITE_BACK_INTERVAL = 5
 
 
 class KcmTestEnv(object):
-    def __init__(self, k5kdc, k5util):
+    def __init__(self, k5kdc, k5util, kcm_pid):
         self.k5kdc = k5kdc
         self.k5util = k5util
+        self.kcm_pid = kcm_pid
         self.counter = 0
 
     def my_uid(self):
@@ -76,10 +77,7 @@ def create_conf_fixture(request, contents):
     request.addfinalizer(lambda: os.unlink(config.CONF_PATH))
 
 
-def create_sssd_kcm_fixture(sock_path, request):
-    if subprocess.call(['sssd', "--genconf"]) != 0:
-        raise Exception("failed to regenerate confdb")
-
+def start_sssd_kcm(sock_path):
     resp_path = os.path.join(config.LIBEXEC_PATH, "sssd", "sssd_kcm")
     if not os.access(resp_path, os.X_OK):
         # It would be cleaner to use pytest.mark.skipif on the package level
@@ -90,26 +88,42 @@ def create_sssd_kcm_fixture(sock_path, request):
     assert kcm_pid >= 0
 
     if kcm_pid == 0:
-        if subprocess.call([resp_path, "--uid=0", "--gid=0"]) != 0:
+        try:
+            os.execv(resp_path, [resp_path, "--uid=0", "--gid=0"])
+        finally:
             print("sssd_kcm failed to start")
-            sys.exit(99)
-    else:
-        abs_sock_path = os.path.join(config.RUNSTATEDIR, sock_path)
-        sck = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-        for _ in range(1, 100):
-            try:
-                sck.connect(abs_sock_path)
-            except:
-                time.sleep(0.1)
-            else:
-                break
-        sck.close()
-        assert os.path.exists(abs_sock_path)
+            os._exit(99)
 
-    def kcm_teardown():
-        if kcm_pid == 0:
-            return
+    abs_sock_path = os.path.join(config.RUNSTATEDIR, sock_path)
+    sck = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    for _ in range(1, 100):
+        try:
+            sck.connect(abs_sock_path)
+        except:
+            time.sleep(0.1)
+        else:
+            break
+    sck.close()
+    assert os.path.exists(abs_sock_path)
+    return kcm_pid
+
+
+def stop_sssd_kcm(kcm_pid):
+    try:
         os.kill(kcm_pid, signal.SIGTERM)
+        os.waitpid(kcm_pid, 0)
+    except OSError:
+        pass
+
+
+def create_sssd_kcm_fixture(sock_path, request):
+    if subprocess.call(['sssd', "--genconf"]) != 0:
+        raise Exception("failed to regenerate confdb")
+
+    kcm_pid = start_sssd_kcm(sock_path)
+
+    def kcm_teardown():
+        stop_sssd_kcm(kcm_pid)
         try:
             os.unlink(os.path.join(config.SECDB_PATH, "secrets.ldb"))
         except OSError as osex:
@@ -120,7 +134,8 @@ def create_sssd_kcm_fixture(sock_path, request):
     return kcm_pid
 
 
-def create_sssd_conf(kcm_path, ccache_storage, max_secrets=MAX_SECRETS):
+def create_sssd_conf(kcm_path, ccache_storage, max_secrets=MAX_SECRETS,
+                     write_back_interval=0):
     return unindent("""\
         [sssd]
         domains = local
@@ -132,6 +147,7 @@ def create_sssd_conf(kcm_path, ccache_storage, max_secrets=MAX_SECRETS):
         [kcm]
         socket_path = {kcm_path}
         ccache_storage = {ccache_storage}
+        ccache_write_back_interval = {write_back_interval}
 
         [secrets]
         max_secrets = {max_secrets}
@@ -147,11 +163,11 @@ def common_setup_for_kcm_mem(request, kdc_instance, kcm_path, sssd_conf):
     kdc_instance.add_config({'kcm_socket': kcm_socket_include})
 
     create_conf_fixture(request, sssd_conf)
-    create_sssd_kcm_fixture(kcm_path, request)
+    kcm_pid = create_sssd_kcm_fixture(kcm_path, request)
 
     k5util = krb5utils.Krb5Utils(kdc_instance.krb5_conf_path)
 
-    return KcmTestEnv(kdc_instance, k5util)
+    return KcmTestEnv(kdc_instance, k5util, kcm_pid)
 
 
 @pytest.fixture
@@ -200,6 +216,18 @@ def setup_for_kcm_secdb(request, kdc_instance):
     return common_setup_for_kcm_mem(request, kdc_instance, kcm_path, sssd_conf)
 
 
+@pytest.fixture
+def setup_for_kcm_secdb_write_back(request, kdc_instance):
+    """
+    Set up the KCM responder backed by libsss_secrets that keeps the
+    ccaches in memory and writes them back periodically
+    """
+    kcm_path = os.path.join(config.RUNSTATEDIR, "kcm.socket")
+    sssd_conf = create_sssd_conf(kcm_path, "secdb",
+                                 write_back_interval=WRITE_BACK_INTERVAL)
+    return common_setup_for_kcm_mem(request, kdc_instance, kcm_path, sssd_conf)
+
+
 def kcm_init_list_destroy(testenv):
     """
     Test that kinit, kdestroy and klist work with KCM
@@ -245,6 +273,12 @@ def test_kcm_secdb_init_list_destroy(setup_for_kcm_secdb):
     kcm_init_list_destroy(testenv)
 
 
+def test_kcm_secdb_write_back_init_list_destroy(
+        setup_for_kcm_secdb_write_back):
+    testenv = setup_for_kcm_secdb_write_back
+    kcm_init_list_destroy(testenv)
+
+
 def kcm_overwrite(testenv):
     """
     Test that reusing a ccache reinitializes the cache and doesn't
@@ -356,6 +390,52 @@ def test_kcm_secdb_collection_init_list_destroy(setup_for_kcm_secdb):
     collection_init_list_destroy(testenv)
 
 
+def test_kcm_secdb_write_back_collection_init_list_destroy(
+        setup_for_kcm_secdb_write_back):
+    testenv = setup_for_kcm_secdb_write_back
+    collection_init_list_destroy(testenv)
+
+
+def test_kcm_secdb_write_back_restart(request,
+                                      setup_for_kcm_secdb_write_back):
+    """
+    Test that ccaches which were written by the flush timer and ccaches
+    which were only in memory survive a restart of the KCM responder
+    """
+    testenv = setup_for_kcm_secdb_write_back
+    kcm_path = os.path.join(config.RUNSTATEDIR, "kcm.socket")
+
+    testenv.k5kdc.add_principal("alice", "alicepw")
+    testenv.k5kdc.add_principal("bob", "bobpw")
+    testenv.k5kdc.add_principal("host/somehostname")
+
+    out, _, _ = testenv.k5util.kinit("alice", "alicepw")
+    assert out == 0
+
+    # let the timer write alice's ccache
+    time.sleep(WRITE_BACK_INTERVAL + 1)
+
+    # bob's ccache and its service ticket are only in memory, they must
+    # be written when the responder is terminated
+    out, _, _ = testenv.k5util.kinit("bob", "bobpw")
+    assert out == 0
+    out, _, _ = testenv.k5util.kvno('host/somehostname')
+    assert out == 0
+
+    # the fixture stops the original process and removes the database
+    # after the restarted one is stopped
+    stop_sssd_kcm(testenv.kcm_pid)
+    kcm_pid = start_sssd_kcm(kcm_path)
+    request.addfinalizer(lambda: stop_sssd_kcm(kcm_pid))
+
+    assert testenv.k5util.default_principal() == 'bob@KCMTEST'
+    cc_coll = testenv.k5util.list_all_princs()
+    assert len(cc_coll) == 2
+    assert cc_coll['alice@KCMTEST'] == ['krbtgt/KCMTEST@KCMTEST']
+    assert set(cc_coll['bob@KCMTEST']) == set(['krbtgt/KCMTEST@KCMTEST',
+                                               'host/somehostname@KCMTEST'])
+
+
 def exercise_kswitch(testenv):
     """
     Test switching between principals
@@ -417,6 +497,11 @@ def test_kcm_secdb_kswitch(setup_for_kcm_secdb):
     exercise_kswitch(testenv)
 
 
+def test_kcm_secdb_write_back_kswitch(setup_for_kcm_secdb_write_back):
+    testenv = setup_for_kcm_secdb_write_back
+    exercise_kswitch(testenv)
+
+
 def exercise_subsidiaries(testenv):
     """
     Test that subsidiary caches are usable and KCM: without specifying UID
@@ -239,6 +239,66 @@ def zero_timeout_rfc2307(request, ldap_conn):
     return None
 
 
+def load_many_users_to_ldap(request, ldap_conn, count):
+    ent_list = ldap_ent.List(ldap_conn.ds_inst.base_dn)
+    for i in range(count):
+        ent_list.add_user("bulkuser%d" % i, 3000 + i, 2001)
+    create_ldap_fixture(request, ldap_conn, ent_list)
+
+
+@pytest.fixture
+def small_passwd_mc_rfc2307(request, ldap_conn):
+    load_many_users_to_ldap(request, ldap_conn, 100)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        memcache_size_passwd = 1
+        memcache_max_growth = 8
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+@pytest.fixture
+def disabled_passwd_mc_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        memcache_size_passwd = 0
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
 def test_getpwnam(ldap_conn, sanity_rfc2307):
     ent.assert_passwd_by_name(
         'user1',
@@ -919,3 +979,71 @@ def test_mc_zero_timeout(ldap_conn, zero_timeout_rfc2307):
         grp.getgrnam('group1')
     with pytest.raises(KeyError):
         grp.getgrgid(2001)
+
+
+def test_mc_growth(ldap_conn, small_passwd_mc_rfc2307):
+    """
+    Test that a passwd memory cache which is too small grows and that
+    a long living client keeps reading it after the file was replaced
+    """
+    users = ["bulkuser%d" % i for i in range(100)]
+
+    ent.assert_passwd_by_name(
+        'bulkuser0',
+        dict(name='bulkuser0', uid=3000, gid=2001))
+    initial_size = MemoryCache(config.MCACHE_PATH + '/passwd').data_size
+
+    # 64 elements hold only a fraction of the users; every pass stores
+    # the users evicted in the previous one until the cache is large
+    # enough for all of them
+    for _ in range(8):
+        for i, user in enumerate(users):
+            ent.assert_passwd_by_name(
+                user,
+                dict(name=user, uid=3000 + i, gid=2001))
+
+    grown_size = MemoryCache(config.MCACHE_PATH + '/passwd').data_size
+    assert grown_size > initial_size
+    assert grown_size <= initial_size * 8
+
+    stop_sssd()
+
+    # every user must be served from the grown memory cache, this client
+    # had the original file mapped and must have switched to the new one
+    for i, user in enumerate(users):
+        ent.assert_passwd_by_name(
+            user,
+            dict(name=user, uid=3000 + i, gid=2001))
+        ent.assert_passwd_by_uid(
+            3000 + i,
+            dict(name=user, uid=3000 + i, gid=2001))
+
+
+def test_mc_disabled_passwd(ldap_conn, disabled_passwd_mc_rfc2307):
+    """
+    Test that memcache_size_passwd = 0 disables only the passwd memory cache
+    """
+    assert not os.path.exists(config.MCACHE_PATH + '/passwd')
+    assert os.path.exists(config.MCACHE_PATH + '/group')
+
+    ent.assert_passwd_by_name(
+        'user1',
+        dict(name='user1', passwd='*', uid=1001, gid=2001,
+             gecos='1001', shell='/bin/bash'))
+    ent.assert_passwd_by_uid(
+        1001,
+        dict(name='user1', passwd='*', uid=1001, gid=2001,
+             gecos='1001', shell='/bin/bash'))
+
+    ent.assert_group_by_name("group1", dict(name="group1", gid=2001))
+    ent.assert_group_by_gid(2001, dict(name="group1", gid=2001))
+    stop_sssd()
+
+    # users are not cached in memory, groups still are
+    with pytest.raises(KeyError):
+        pwd.getpwnam('user1')
+    with pytest.raises(KeyError):
+        pwd.getpwuid(1001)
+
+    ent.assert_group_by_name("group1", dict(name="group1", gid=2001))
+    ent.assert_group_by_gid(2001, dict(name="group1", gid=2001))
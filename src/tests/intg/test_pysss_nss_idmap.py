@@ -142,6 +142,19 @@ def cleanup_sssd_process():
         os.unlink(config.MCACHE_PATH + "/" + path)
 
 
+def stop_sssd():
+    """Stop the SSSD process and keep its state"""
+    with open(config.PIDFILE_PATH, "r") as pid_file:
+        pid = int(pid_file.read())
+    os.kill(pid, signal.SIGTERM)
+    while True:
+        try:
+            os.kill(pid, signal.SIGCONT)
+        except:
+            break
+        time.sleep(1)
+
+
 def create_sssd_fixture(request):
     """Start SSSD and add teardown for stopping it and removing its state"""
     create_sssd_process()
@@ -289,3 +302,32 @@ def test_case_insensitive(ldap_conn, simple_ad):
     output = pysss_nss_idmap.getnamebysid(group_sid)[group_sid]
     assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_GROUP
     assert output[pysss_nss_idmap.NAME_KEY] == group.lower()
+
+
+def test_user_operations_with_mc(ldap_conn, simple_ad):
+    """
+    Test that the answers of the SID lookups are stored in the memory cache
+    and used when the responder is not running
+    """
+    user = 'user1_dom1-19661'
+    user_id = pwd.getpwnam(user).pw_uid
+    user_sid = 'S-1-5-21-1305200397-2901131868-73388776-82809'
+
+    def check_user():
+        output = pysss_nss_idmap.getsidbyname(user)[user]
+        assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+        assert output[pysss_nss_idmap.SID_KEY] == user_sid
+
+        output = pysss_nss_idmap.getsidbyuid(user_id)[user_id]
+        assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+        assert output[pysss_nss_idmap.SID_KEY] == user_sid
+
+        output = pysss_nss_idmap.getnamebysid(user_sid)[user_sid]
+        assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+        assert output[pysss_nss_idmap.NAME_KEY] == user
+
+    check_user()
+    assert os.path.exists(config.MCACHE_PATH + "/sid")
+
+    stop_sssd()
+    check_user()
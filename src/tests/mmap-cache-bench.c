@@ -0,0 +1,273 @@
+/*
+   SSSD
+
+   NSS memory cache writer benchmark
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures how fast passwd records are stored into the memory cache when
+ * it is 90% full. The cache is filled first, then random records are
+ * replaced by new ones, so free slots have to be searched among the used
+ * ones. Finally new records are stored without making room for them while
+ * a tenth of the records is stored again, as responder does for entries
+ * that are still requested, and the number of these that were not evicted
+ * is reported. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <talloc.h>
+#include <popt.h>
+
+#include "util/util.h"
+#include "util/mmap_cache.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
+
+#define DEFAULT_ENTRIES SSS_MC_CACHE_ELEMENTS
+#define BENCH_CACHE     "bench_passwd"
+#define BENCH_FILL      90 /* percent */
+#define BENCH_HOT       10 /* percent of stored records */
+#define BENCH_ID_BASE   100000
+
+static double bench_elapsed(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec)
+            + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_report(const char *op, unsigned int ops, double secs)
+{
+    printf("%-10s %10u ops %10.3f s %12.0f ops/s\n",
+           op, ops, secs, secs > 0 ? ops / secs : 0);
+}
+
+static void bench_name(char *buf, size_t size, uint32_t id)
+{
+    snprintf(buf, size, "user%07u", id);
+}
+
+static errno_t bench_store(struct sss_mc_ctx **mcc, uint32_t id)
+{
+    struct sized_string name;
+    struct sized_string pw;
+    struct sized_string gecos;
+    struct sized_string homedir;
+    struct sized_string shell;
+    char namebuf[32];
+    char homebuf[64];
+
+    bench_name(namebuf, sizeof(namebuf), id);
+    snprintf(homebuf, sizeof(homebuf), "/home/%s", namebuf);
+
+    to_sized_string(&name, namebuf);
+    to_sized_string(&pw, "*");
+    to_sized_string(&gecos, "Benchmark user");
+    to_sized_string(&homedir, homebuf);
+    to_sized_string(&shell, "/bin/bash");
+
+    return sss_mmap_cache_pw_store(mcc, &name, &pw, BENCH_ID_BASE + id,
+                                   BENCH_ID_BASE + id, &gecos, &homedir,
+                                   &shell);
+}
+
+static errno_t bench_invalidate(struct sss_mc_ctx *mcc, uint32_t id)
+{
+    struct sized_string name;
+    char namebuf[32];
+
+    bench_name(namebuf, sizeof(namebuf), id);
+    to_sized_string(&name, namebuf);
+
+    return sss_mmap_cache_pw_invalidate(mcc, &name);
+}
+
+/* Number of records that fill the given percentage of the cache. */
+static uint32_t bench_records(unsigned int entries, unsigned int percent)
+{
+    size_t rec_len;
+    char namebuf[32];
+
+    bench_name(namebuf, sizeof(namebuf), 0);
+
+    /* the same strings as in bench_store() */
+    rec_len = sizeof(struct sss_mc_rec) + sizeof(struct sss_mc_pwd_data)
+              + strlen(namebuf) + 1 + sizeof("*")
+              + sizeof("Benchmark user") + strlen("/home/") + strlen(namebuf)
+              + 1 + sizeof("/bin/bash");
+
+    /* the free table has one bit for each of the MC_ALIGN64(entries)
+     * slots */
+    return MC_ALIGN64(entries) * percent / 100 / MC_SIZE_TO_SLOTS(rec_len);
+}
+
+static int bench_run(unsigned int entries)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_mc_ctx *mcc = NULL;
+    struct timespec start;
+    uint32_t *live;
+    uint32_t records;
+    uint32_t hot;
+    uint32_t next_id;
+    uint32_t kept;
+    uint32_t ops;
+    uint32_t pos;
+    uint32_t i;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    records = bench_records(entries, BENCH_FILL);
+    hot = records * BENCH_HOT / 100;
+    if (records == 0 || hot == 0) {
+        fprintf(stderr, "The cache is too small\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    live = talloc_array(tmp_ctx, uint32_t, records);
+    if (live == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* growth is disabled so the cache stays at the same fill */
+    ret = sss_mmap_cache_init(tmp_ctx, BENCH_CACHE, geteuid(), getegid(),
+                              SSS_MC_PASSWD, entries, entries, 3600, &mcc);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot create the memory cache [%d]: %s\n",
+                ret, sss_strerror(ret));
+        goto done;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < records; i++) {
+        ret = bench_store(&mcc, i);
+        if (ret != EOK) {
+            goto done;
+        }
+        live[i] = i;
+    }
+    bench_report("fill", records, bench_elapsed(&start));
+    next_id = records;
+
+    /* replace random records, the cache stays 90% full */
+    srand(records);
+    ops = records;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ops; i++) {
+        pos = hot + rand() % (records - hot);
+
+        ret = bench_invalidate(mcc, live[pos]);
+        if (ret != EOK) {
+            fprintf(stderr, "Record %u is missing\n", live[pos]);
+            goto done;
+        }
+
+        ret = bench_store(&mcc, next_id);
+        if (ret != EOK) {
+            goto done;
+        }
+        live[pos] = next_id++;
+    }
+    bench_report("replace", ops, bench_elapsed(&start));
+
+    /* new records evict old ones, the hot ones are stored again */
+    ops = 2 * records;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ops; i++) {
+        if (i % 4 == 0) {
+            ret = bench_store(&mcc, live[(i / 4) % hot]);
+        } else {
+            ret = bench_store(&mcc, next_id++);
+        }
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+    bench_report("churn", ops, bench_elapsed(&start));
+
+    kept = 0;
+    for (i = 0; i < hot; i++) {
+        if (bench_invalidate(mcc, live[i]) == EOK) {
+            kept++;
+        }
+    }
+    printf("%u of %u hot records were kept\n", kept, hot);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        fprintf(stderr, "Benchmark failed [%d]: %s\n", ret, sss_strerror(ret));
+    }
+    talloc_free(tmp_ctx);
+    unlink(SSS_NSS_MCACHE_DIR"/"BENCH_CACHE);
+    return ret;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int debug = 0;
+    int pc_entries = DEFAULT_ENTRIES;
+    int ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "debug-level", 'd', POPT_ARG_INT, &debug, 0,
+          "Set debug level", NULL },
+        { "entries", 'n', POPT_ARG_INT, &pc_entries, 0,
+          "Number of elements of the cache", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (pc_entries <= 0) {
+        fprintf(stderr, "The number of entries must be positive\n");
+        return 1;
+    }
+
+    DEBUG_CLI_INIT(debug);
+
+    ret = bench_run(pc_entries);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+   SSSD
+
+   Negative cache backend benchmark
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Compares the tdb and hash table backends of the negative cache. Every
+ * entry is added once, looked up once and a lookup of a missing entry is
+ * done for each of them, finally all users are reset. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <talloc.h>
+#include <popt.h>
+
+#include "util/util.h"
+#include "responder/common/negcache.h"
+
+#define DEFAULT_ENTRIES 1000000
+#define BENCH_DOM_NAME  "bench.test"
+
+static double bench_elapsed(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec)
+            + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_report(const char *backend, const char *op,
+                         unsigned int entries, double secs)
+{
+    printf("%-5s %-12s %10u ops %10.3f s %12.0f ops/s\n",
+           backend, op, entries, secs, secs > 0 ? entries / secs : 0);
+}
+
+static int bench_backend(const char *name, enum sss_ncache_backend backend,
+                         unsigned int entries)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_nc_ctx *ncache;
+    struct sss_domain_info *dom;
+    struct timespec start;
+    char **names;
+    unsigned int i;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dom = talloc_zero(tmp_ctx, struct sss_domain_info);
+    names = talloc_array(tmp_ctx, char *, entries);
+    if (dom == NULL || names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    dom->name = discard_const_p(char, BENCH_DOM_NAME);
+    dom->case_sensitive = true;
+
+    for (i = 0; i < entries; i++) {
+        names[i] = talloc_asprintf(names, "user%u@%s", i, BENCH_DOM_NAME);
+        if (names[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    /* the local timeout is disabled so files are never consulted */
+    ret = sss_ncache_init_ex(tmp_ctx, 3600, 0, backend, &ncache);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot initialize the %s backend [%d]: %s\n",
+                name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < entries; i++) {
+        ret = sss_ncache_set_user(ncache, false, dom, names[i]);
+        if (ret != EOK) {
+            fprintf(stderr, "set_user failed [%d]: %s\n",
+                    ret, sss_strerror(ret));
+            goto done;
+        }
+        ret = sss_ncache_set_uid(ncache, false, NULL, i);
+        if (ret != EOK) {
+            fprintf(stderr, "set_uid failed [%d]: %s\n",
+                    ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+    bench_report(name, "set", entries * 2, bench_elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < entries; i++) {
+        if (sss_ncache_check_user(ncache, dom, names[i]) != EEXIST
+                || sss_ncache_check_uid(ncache, NULL, i) != EEXIST) {
+            fprintf(stderr, "Entry %u is missing\n", i);
+            ret = EIO;
+            goto done;
+        }
+    }
+    bench_report(name, "check hit", entries * 2, bench_elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < entries; i++) {
+        if (sss_ncache_check_gid(ncache, NULL, i) != ENOENT) {
+            fprintf(stderr, "Unexpected entry %u\n", i);
+            ret = EIO;
+            goto done;
+        }
+    }
+    bench_report(name, "check miss", entries, bench_elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = sss_ncache_reset_users(ncache);
+    if (ret != EOK) {
+        goto done;
+    }
+    bench_report(name, "reset users", entries * 2, bench_elapsed(&start));
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int debug = 0;
+    int pc_entries = DEFAULT_ENTRIES;
+    int ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "debug-level", 'd', POPT_ARG_INT, &debug, 0,
+          "Set debug level", NULL },
+        { "entries", 'n', POPT_ARG_INT, &pc_entries, 0,
+          "Number of entries of each kind", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (pc_entries <= 0) {
+        fprintf(stderr, "The number of entries must be positive\n");
+        return 1;
+    }
+
+    DEBUG_CLI_INIT(debug);
+
+    ret = bench_backend("tdb", SSS_NCACHE_BACKEND_TDB, pc_entries);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    ret = bench_backend("hash", SSS_NCACHE_BACKEND_HASH, pc_entries);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,584 @@
+/*
+   SSSD
+
+   sbus binary framing benchmark
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures round-trip latency of a DataProvider.getAccountInfo call
+ * between two processes connected with a Unix socket. The same arguments
+ * are encoded with the generated argument readers and writers either as
+ * D-Bus messages over a plain socket pair, or as binary frames over the
+ * sbus frame transport. The server side decodes the call and sends back
+ * a reply. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <talloc.h>
+#include <tevent.h>
+#include <popt.h>
+#include <dbus/dbus.h>
+
+#include "util/util.h"
+#include "util/atomic_io.h"
+#include "sbus/frame/sbus_frame.h"
+#include "sss_iface/sbus_sss_arguments.h"
+
+#define DEFAULT_CALLS  100000
+#define BENCH_BUS      "sssd.domain"
+#define BENCH_PATH     "/sssd"
+#define BENCH_IFACE    "sssd.dataprovider"
+#define BENCH_METHOD   "getAccountInfo"
+
+typedef errno_t (*bench_fn)(TALLOC_CTX *mem_ctx, int fd, uint32_t serial);
+
+static double bench_elapsed(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec)
+            + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_report(const char *method, unsigned int calls, double secs)
+{
+    printf("%-6s %10u calls %10.3f s %10.2f us/call\n",
+           method, calls, secs, calls > 0 ? secs * 1e6 / calls : 0);
+}
+
+static errno_t bench_send(int fd, const void *buf, uint32_t len)
+{
+    ssize_t ret;
+
+    ret = sss_atomic_write_s(fd, &len, sizeof(len));
+    if (ret != sizeof(len)) {
+        return EIO;
+    }
+
+    ret = sss_atomic_write_s(fd, discard_const(buf), len);
+    if (ret != len) {
+        return EIO;
+    }
+
+    return EOK;
+}
+
+static errno_t bench_recv(TALLOC_CTX *mem_ctx, int fd,
+                          uint8_t **_buf, uint32_t *_len)
+{
+    uint8_t *buf;
+    uint32_t len;
+    ssize_t ret;
+
+    ret = sss_atomic_read_s(fd, &len, sizeof(len));
+    if (ret != sizeof(len)) {
+        return EIO;
+    }
+
+    buf = talloc_size(mem_ctx, len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_atomic_read_s(fd, buf, len);
+    if (ret != len) {
+        return EIO;
+    }
+
+    *_buf = buf;
+    *_len = len;
+
+    return EOK;
+}
+
+static errno_t bench_dbus_send(int fd, DBusMessage *msg, uint32_t serial)
+{
+    char *buf;
+    int len;
+    errno_t ret;
+
+    dbus_message_set_serial(msg, serial);
+    if (!dbus_message_marshal(msg, &buf, &len)) {
+        return ENOMEM;
+    }
+
+    ret = bench_send(fd, buf, len);
+    dbus_free(buf);
+
+    return ret;
+}
+
+static errno_t bench_dbus_recv(TALLOC_CTX *mem_ctx, int fd,
+                               DBusMessage **_msg)
+{
+    DBusMessage *msg;
+    DBusError error;
+    uint8_t *buf;
+    uint32_t len;
+    errno_t ret;
+
+    ret = bench_recv(mem_ctx, fd, &buf, &len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    dbus_error_init(&error);
+    msg = dbus_message_demarshal((const char *)buf, len, &error);
+    if (msg == NULL) {
+        dbus_error_free(&error);
+        return EIO;
+    }
+
+    *_msg = msg;
+
+    return EOK;
+}
+
+static errno_t bench_dbus_client(TALLOC_CTX *mem_ctx, int fd, uint32_t serial)
+{
+    struct _sbus_sss_invoker_args_uusss in = {0, 1, "name=user1", "", ""};
+    struct _sbus_sss_invoker_args_qus out;
+    DBusMessageIter iter;
+    DBusMessage *msg;
+    errno_t ret;
+
+    msg = dbus_message_new_method_call(BENCH_BUS, BENCH_PATH, BENCH_IFACE,
+                                       BENCH_METHOD);
+    if (msg == NULL) {
+        return ENOMEM;
+    }
+
+    dbus_message_iter_init_append(msg, &iter);
+    ret = _sbus_sss_invoker_write_uusss(&iter, &in);
+    if (ret == EOK) {
+        ret = bench_dbus_send(fd, msg, serial);
+    }
+    dbus_message_unref(msg);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = bench_dbus_recv(mem_ctx, fd, &msg);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    dbus_message_iter_init(msg, &iter);
+    ret = _sbus_sss_invoker_read_qus(mem_ctx, &iter, &out);
+    dbus_message_unref(msg);
+
+    return ret;
+}
+
+static errno_t bench_dbus_server(TALLOC_CTX *mem_ctx, int fd, uint32_t serial)
+{
+    struct _sbus_sss_invoker_args_qus out = {0, 0, "Success"};
+    struct _sbus_sss_invoker_args_uusss in;
+    DBusMessageIter iter;
+    DBusMessage *reply;
+    DBusMessage *msg;
+    errno_t ret;
+
+    ret = bench_dbus_recv(mem_ctx, fd, &msg);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    dbus_message_iter_init(msg, &iter);
+    ret = _sbus_sss_invoker_read_uusss(mem_ctx, &iter, &in);
+    if (ret != EOK) {
+        dbus_message_unref(msg);
+        return ret;
+    }
+
+    reply = dbus_message_new_method_return(msg);
+    dbus_message_unref(msg);
+    if (reply == NULL) {
+        return ENOMEM;
+    }
+
+    dbus_message_iter_init_append(reply, &iter);
+    ret = _sbus_sss_invoker_write_qus(&iter, &out);
+    if (ret == EOK) {
+        ret = bench_dbus_send(fd, reply, serial);
+    }
+    dbus_message_unref(reply);
+
+    return ret;
+}
+
+static errno_t bench_loop(bench_fn fn, int fd, unsigned int calls)
+{
+    TALLOC_CTX *tmp_ctx;
+    unsigned int i;
+    errno_t ret;
+
+    for (i = 0; i < calls; i++) {
+        tmp_ctx = talloc_new(NULL);
+        if (tmp_ctx == NULL) {
+            return ENOMEM;
+        }
+
+        ret = fn(tmp_ctx, fd, i + 1);
+        talloc_free(tmp_ctx);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static int bench_method(const char *name, bench_fn client, bench_fn server,
+                        unsigned int calls)
+{
+    struct timespec start;
+    int status;
+    int fds[2];
+    pid_t pid;
+    errno_t ret;
+
+    ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    if (ret != 0) {
+        return errno;
+    }
+
+    pid = fork();
+    if (pid == -1) {
+        ret = errno;
+        close(fds[0]);
+        close(fds[1]);
+        return ret;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        ret = bench_loop(server, fds[1], calls);
+        _exit(ret == EOK ? 0 : 1);
+    }
+
+    close(fds[1]);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = bench_loop(client, fds[0], calls);
+    if (ret == EOK) {
+        bench_report(name, calls, bench_elapsed(&start));
+    } else {
+        fprintf(stderr, "%s failed [%d]: %s\n", name, ret, sss_strerror(ret));
+    }
+
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return ret;
+}
+
+struct bench_frame_handler_state {
+    struct _sbus_sss_invoker_args_uusss in;
+};
+
+static struct tevent_req *
+bench_frame_handler_send(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct sbus_frame_reader *in,
+                         void *data)
+{
+    struct bench_frame_handler_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct bench_frame_handler_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    ret = _sbus_sss_invoker_frame_read_uusss(state, in, &state->in);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+    } else {
+        tevent_req_done(req);
+    }
+
+    return tevent_req_post(req, ev);
+}
+
+static errno_t bench_frame_handler_recv(TALLOC_CTX *mem_ctx,
+                                        struct tevent_req *req,
+                                        struct sbus_frame_writer *out)
+{
+    struct _sbus_sss_invoker_args_qus args = {0, 0, "Success"};
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return _sbus_sss_invoker_frame_write_qus(out, &args);
+}
+
+static const struct sbus_frame_method bench_frame_methods[] = {
+    {BENCH_IFACE, BENCH_METHOD,
+     bench_frame_handler_send, bench_frame_handler_recv, NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+/* Serve calls until the parent terminates us. Writes one byte into
+ * @ready_fd once the server is listening. */
+static void bench_frame_server(const char *socket_path, int ready_fd)
+{
+    struct sbus_frame_server *server;
+    struct tevent_context *ev;
+    errno_t ret;
+    char c = 0;
+
+    ev = tevent_context_init(NULL);
+    if (ev == NULL) {
+        _exit(1);
+    }
+
+    ret = sbus_frame_server_create(ev, ev, socket_path, geteuid(), getegid(),
+                                   bench_frame_methods, &server);
+    if (ret != EOK) {
+        _exit(1);
+    }
+
+    sss_atomic_write_s(ready_fd, &c, 1);
+    close(ready_fd);
+
+    while (tevent_loop_once(ev) == 0) {
+        /* serve */
+    }
+
+    _exit(1);
+}
+
+static errno_t bench_frame_call(TALLOC_CTX *mem_ctx,
+                                struct tevent_context *ev,
+                                struct sbus_frame_conn *conn)
+{
+    struct _sbus_sss_invoker_args_uusss in = {0, 1, "name=user1", "", ""};
+    struct _sbus_sss_invoker_args_qus out;
+    struct sbus_frame_writer *writer;
+    struct sbus_frame_reader *reply;
+    struct tevent_req *req;
+    errno_t ret;
+
+    writer = sbus_frame_call_writer(mem_ctx, BENCH_IFACE, BENCH_METHOD);
+    if (writer == NULL) {
+        return ENOMEM;
+    }
+
+    ret = _sbus_sss_invoker_frame_write_uusss(writer, &in);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    req = sbus_frame_call_send(mem_ctx, conn, writer);
+    if (req == NULL) {
+        return ENOMEM;
+    }
+
+    if (!tevent_req_poll(req, ev)) {
+        return EIO;
+    }
+
+    ret = sbus_frame_call_recv(mem_ctx, req, &reply);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return _sbus_sss_invoker_frame_read_qus(mem_ctx, reply, &out);
+}
+
+static errno_t bench_frame_client(struct tevent_context *ev,
+                                  const char *socket_path,
+                                  unsigned int calls)
+{
+    struct sbus_frame_conn *conn;
+    struct timespec start;
+    struct tevent_req *req;
+    TALLOC_CTX *tmp_ctx;
+    unsigned int i;
+    errno_t ret;
+
+    req = sbus_frame_connect_send(ev, ev, socket_path);
+    if (req == NULL) {
+        return ENOMEM;
+    }
+
+    if (!tevent_req_poll(req, ev)) {
+        return EIO;
+    }
+
+    ret = sbus_frame_connect_recv(ev, req, &conn);
+    talloc_free(req);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < calls; i++) {
+        tmp_ctx = talloc_new(NULL);
+        if (tmp_ctx == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = bench_frame_call(tmp_ctx, ev, conn);
+        talloc_free(tmp_ctx);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    bench_report("frame", calls, bench_elapsed(&start));
+
+    ret = EOK;
+
+done:
+    talloc_free(conn);
+    return ret;
+}
+
+/* Unlike the D-Bus half this goes through the frame transport, so the
+ * numbers include the tevent dispatch on both sides. */
+static int bench_frame(unsigned int calls)
+{
+    struct tevent_context *ev;
+    char dir[] = "/tmp/sbus-frame-bench-XXXXXX";
+    char *socket_path = NULL;
+    int status;
+    int fds[2];
+    pid_t pid;
+    errno_t ret;
+    char c;
+
+    if (mkdtemp(dir) == NULL) {
+        return errno;
+    }
+
+    socket_path = talloc_asprintf(NULL, "%s/bench.frame", dir);
+    if (socket_path == NULL) {
+        rmdir(dir);
+        return ENOMEM;
+    }
+
+    ret = pipe(fds);
+    if (ret != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    pid = fork();
+    if (pid == -1) {
+        ret = errno;
+        close(fds[0]);
+        close(fds[1]);
+        goto done;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        bench_frame_server(socket_path, fds[1]);
+    }
+
+    close(fds[1]);
+    if (sss_atomic_read_s(fds[0], &c, 1) != 1) {
+        close(fds[0]);
+        waitpid(pid, &status, 0);
+        ret = EIO;
+        goto done;
+    }
+    close(fds[0]);
+
+    ev = tevent_context_init(NULL);
+    if (ev == NULL) {
+        ret = ENOMEM;
+    } else {
+        ret = bench_frame_client(ev, socket_path, calls);
+        talloc_free(ev);
+    }
+
+    if (ret != EOK) {
+        fprintf(stderr, "frame failed [%d]: %s\n", ret, sss_strerror(ret));
+    }
+
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+
+done:
+    unlink(socket_path);
+    rmdir(dir);
+    talloc_free(socket_path);
+
+    return ret;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int debug = 0;
+    int pc_calls = DEFAULT_CALLS;
+    int ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "debug-level", 'd', POPT_ARG_INT, &debug, 0,
+          "Set debug level", NULL },
+        { "calls", 'n', POPT_ARG_INT, &pc_calls, 0,
+          "Number of calls", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (pc_calls <= 0) {
+        fprintf(stderr, "The number of calls must be positive\n");
+        return 1;
+    }
+
+    DEBUG_CLI_INIT(debug);
+
+    ret = bench_method("dbus", bench_dbus_client, bench_dbus_server,
+                       pc_calls);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    ret = bench_frame(pc_calls);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    return 0;
+}
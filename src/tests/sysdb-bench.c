@@ -0,0 +1,250 @@
+/*
+   SSSD
+
+   sysdb bulk store benchmark
+
+   Copyright (C) 2026 Red Hat
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Compares storing users one by one with sysdb_store_user() inside one
+ * transaction, which is what sdap_save_users() does, with a single call
+ * of sysdb_store_users(). Every user is stored twice, first into an empty
+ * cache and then again as an update of the cached entry. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <talloc.h>
+#include <popt.h>
+
+#include "util/util.h"
+#include "db/sysdb.h"
+#include "tests/common.h"
+
+#define DEFAULT_ENTRIES 100000
+#define TESTS_PATH      "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB    "tests_conf.ldb"
+#define BENCH_DOM_NAME  "sysdb_bench"
+#define BENCH_ID_BASE   100000
+
+static double bench_elapsed(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec)
+            + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_report(const char *method, const char *op,
+                         unsigned int entries, double secs)
+{
+    printf("%-6s %-8s %10u users %10.3f s %12.0f users/s\n",
+           method, op, entries, secs, secs > 0 ? entries / secs : 0);
+}
+
+static struct sysdb_store_user_entry *
+bench_users(TALLOC_CTX *mem_ctx, struct sss_domain_info *dom,
+            unsigned int entries, const char *shell)
+{
+    struct sysdb_store_user_entry *users;
+    unsigned int i;
+
+    users = talloc_zero_array(mem_ctx, struct sysdb_store_user_entry,
+                              entries);
+    if (users == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < entries; i++) {
+        users[i].name = talloc_asprintf(users, "user%u@%s", i, dom->name);
+        users[i].homedir = talloc_asprintf(users, "/home/user%u", i);
+        if (users[i].name == NULL || users[i].homedir == NULL) {
+            talloc_free(users);
+            return NULL;
+        }
+        users[i].uid = BENCH_ID_BASE + i;
+        users[i].gid = BENCH_ID_BASE + i;
+        users[i].gecos = "Benchmark user";
+        users[i].shell = shell;
+        users[i].attrs = sysdb_new_attrs(users);
+        if (users[i].attrs == NULL) {
+            talloc_free(users);
+            return NULL;
+        }
+    }
+
+    return users;
+}
+
+static errno_t bench_store_single(struct sss_domain_info *dom,
+                                  struct sysdb_store_user_entry *users,
+                                  unsigned int entries)
+{
+    unsigned int i;
+    errno_t ret;
+
+    ret = sysdb_transaction_start(dom->sysdb);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < entries; i++) {
+        ret = sysdb_store_user(dom, users[i].name, users[i].pwd,
+                               users[i].uid, users[i].gid, users[i].gecos,
+                               users[i].homedir, users[i].shell,
+                               users[i].orig_dn, users[i].attrs,
+                               users[i].remove_attrs, 0, 0);
+        if (ret != EOK) {
+            fprintf(stderr, "Cannot store %s [%d]: %s\n",
+                    users[i].name, ret, sss_strerror(ret));
+            sysdb_transaction_cancel(dom->sysdb);
+            return ret;
+        }
+    }
+
+    return sysdb_transaction_commit(dom->sysdb);
+}
+
+static errno_t bench_store_bulk(struct sss_domain_info *dom,
+                                struct sysdb_store_user_entry *users,
+                                unsigned int entries)
+{
+    size_t failed;
+    errno_t ret;
+
+    ret = sysdb_store_users(dom, users, entries, 0, 0, &failed);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (failed > 0) {
+        fprintf(stderr, "%zu users were not stored\n", failed);
+        return EIO;
+    }
+
+    return EOK;
+}
+
+static int bench_method(const char *name, bool bulk, unsigned int entries)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_test_ctx *tctx;
+    struct sysdb_store_user_entry *users;
+    struct timespec start;
+    const char *op;
+    int pass;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    tctx = create_dom_test_ctx(tmp_ctx, TESTS_PATH, TEST_CONF_DB,
+                               BENCH_DOM_NAME, "ldap", NULL);
+    if (tctx == NULL) {
+        fprintf(stderr, "Cannot create the test domain\n");
+        ret = EIO;
+        goto done;
+    }
+
+    for (pass = 0; pass < 2; pass++) {
+        /* the attributes are consumed by the store, start afresh */
+        users = bench_users(tmp_ctx, tctx->dom, entries,
+                            pass == 0 ? "/bin/bash" : "/bin/zsh");
+        if (users == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        op = pass == 0 ? "add" : "update";
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (bulk) {
+            ret = bench_store_bulk(tctx->dom, users, entries);
+        } else {
+            ret = bench_store_single(tctx->dom, users, entries);
+        }
+        if (ret != EOK) {
+            fprintf(stderr, "%s %s failed [%d]: %s\n",
+                    name, op, ret, sss_strerror(ret));
+            goto done;
+        }
+        bench_report(name, op, entries, bench_elapsed(&start));
+
+        talloc_free(users);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, BENCH_DOM_NAME);
+    return ret;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int debug = 0;
+    int pc_entries = DEFAULT_ENTRIES;
+    int ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "debug-level", 'd', POPT_ARG_INT, &debug, 0,
+          "Set debug level", NULL },
+        { "entries", 'n', POPT_ARG_INT, &pc_entries, 0,
+          "Number of users to store", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (pc_entries <= 0) {
+        fprintf(stderr, "The number of entries must be positive\n");
+        return 1;
+    }
+
+    DEBUG_CLI_INIT(debug);
+
+    ret = bench_method("single", false, pc_entries);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    ret = bench_method("bulk", true, pc_entries);
+    if (ret != EOK) {
+        return 2;
+    }
+
+    return 0;
+}
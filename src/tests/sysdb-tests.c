@@ -744,6 +744,100 @@ START_TEST (test_sysdb_store_user)
 }
 END_TEST
 
+START_TEST (test_sysdb_store_users_bulk)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct sysdb_store_user_entry users[6];
+    struct sysdb_store_group_entry groups[3];
+    const char *attrs[] = { SYSDB_UIDNUM, SYSDB_GIDNUM, SYSDB_SHELL, NULL };
+    struct ldb_message *msg;
+    size_t failed;
+    int ret;
+    int i;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    memset(users, 0, sizeof(users));
+    for (i = 0; i < 5; i++) {
+        users[i].name = test_asprintf_fqname(test_ctx, test_ctx->domain,
+                                             "bulkuser%d", i);
+        fail_if(users[i].name == NULL);
+        users[i].uid = 27300 + i;
+        users[i].gid = 27300 + i;
+        users[i].homedir = "/home/bulkuser";
+        users[i].shell = "/bin/bash";
+    }
+
+    ret = sysdb_store_users(test_ctx->domain, users, 5, 0, 0, &failed);
+    fail_if(ret != EOK, "Could not store users [%d]: %s",
+            ret, sss_strerror(ret));
+    fail_if(failed != 0, "%zu users were not stored", failed);
+
+    for (i = 0; i < 5; i++) {
+        ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain,
+                                        users[i].name, attrs, &msg);
+        fail_if(ret != EOK, "User %s was not stored", users[i].name);
+        fail_unless(ldb_msg_find_attr_as_uint(msg, SYSDB_UIDNUM, 0)
+                    == 27300 + i, "Wrong UID of %s", users[i].name);
+    }
+
+    /* Existing users are modified, a duplicate in the batch is fine */
+    for (i = 0; i < 5; i++) {
+        users[i].shell = "/bin/ksh";
+    }
+    users[5] = users[0];
+
+    ret = sysdb_store_users(test_ctx->domain, users, 6, 0, 0, &failed);
+    fail_if(ret != EOK, "Could not store users [%d]: %s",
+            ret, sss_strerror(ret));
+    fail_if(failed != 0, "%zu users were not stored", failed);
+
+    for (i = 0; i < 5; i++) {
+        ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain,
+                                        users[i].name, attrs, &msg);
+        fail_if(ret != EOK, "User %s disappeared", users[i].name);
+        fail_if(strcmp(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, ""),
+                       "/bin/ksh") != 0, "Shell of %s was not updated",
+                users[i].name);
+    }
+
+    memset(groups, 0, sizeof(groups));
+    for (i = 0; i < 3; i++) {
+        groups[i].name = test_asprintf_fqname(test_ctx, test_ctx->domain,
+                                              "bulkgroup%d", i);
+        fail_if(groups[i].name == NULL);
+        groups[i].gid = 27310 + i;
+    }
+
+    ret = sysdb_store_groups(test_ctx->domain, groups, 3, 0, 0, &failed);
+    fail_if(ret != EOK, "Could not store groups [%d]: %s",
+            ret, sss_strerror(ret));
+    fail_if(failed != 0, "%zu groups were not stored", failed);
+
+    for (i = 0; i < 3; i++) {
+        ret = sysdb_search_group_by_name(test_ctx, test_ctx->domain,
+                                         groups[i].name, attrs, &msg);
+        fail_if(ret != EOK, "Group %s was not stored", groups[i].name);
+        fail_unless(ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0)
+                    == 27310 + i, "Wrong GID of %s", groups[i].name);
+    }
+
+    for (i = 0; i < 5; i++) {
+        ret = sysdb_delete_user(test_ctx->domain, users[i].name, 0);
+        fail_if(ret != EOK, "Could not delete %s", users[i].name);
+    }
+
+    for (i = 0; i < 3; i++) {
+        ret = sysdb_delete_group(test_ctx->domain, groups[i].name, 0);
+        fail_if(ret != EOK, "Could not delete %s", groups[i].name);
+    }
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_store_user_existing)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -1380,6 +1474,70 @@ START_TEST (test_sysdb_enumpwent)
 END_TEST
 
 
+START_TEST (test_sysdb_enumpwent_page)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct ldb_result *all;
+    struct ldb_result *res;
+    const char *after = NULL;
+    const char *name;
+    size_t count = 0;
+    unsigned int i;
+    int ret;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    ret = sysdb_enumpwent(test_ctx, test_ctx->domain, &all);
+    fail_unless(ret == EOK, "sysdb_enumpwent failed (%d: %s)",
+                ret, strerror(ret));
+
+    /* Every user is returned once, in name order */
+    do {
+        ret = sysdb_enumpwent_page(test_ctx, test_ctx->domain, NULL, after, 3,
+                                   &res);
+        fail_unless(ret == EOK, "sysdb_enumpwent_page failed (%d: %s)",
+                    ret, strerror(ret));
+        fail_if(res->count > 3, "Expected at most 3 users, got %d",
+                res->count);
+
+        for (i = 0; i < res->count; i++) {
+            name = ldb_msg_find_attr_as_string(res->msgs[i], SYSDB_NAME, NULL);
+            fail_if(name == NULL, "No name?\n");
+            fail_if(after != NULL && strcmp(name, after) <= 0,
+                    "User %s is not after %s", name, after);
+            after = name;
+        }
+
+        count += res->count;
+    } while (res->count == 3);
+
+    fail_if(count != all->count, "Expected %d users, got %zu",
+            all->count, count);
+
+    ret = sysdb_enumpwent_page(test_ctx, test_ctx->domain, "nosuchuser*",
+                               NULL, 3, &res);
+    fail_unless(ret == EOK, "sysdb_enumpwent_page failed (%d: %s)",
+                ret, strerror(ret));
+    fail_if(res->count != 0, "Expected no users, got %d", res->count);
+
+    /* Page sizes are bounded */
+    ret = sysdb_enumpwent_page(test_ctx, test_ctx->domain, NULL, NULL, 0,
+                               &res);
+    fail_unless(ret == EINVAL, "Expected EINVAL, got %d", ret);
+
+    ret = sysdb_enumpwent_page(test_ctx, test_ctx->domain, NULL, NULL,
+                               SYSDB_ENUM_PAGE_MAX_SIZE + 1, &res);
+    fail_unless(ret == EINVAL, "Expected EINVAL, got %d", ret);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_set_user_attr)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -3740,6 +3898,112 @@ START_TEST (test_sysdb_memberof_ghost_replace_noop)
 }
 END_TEST
 
+static unsigned int test_count_memberof(struct sysdb_test_ctx *test_ctx,
+                                        const char *username)
+{
+    const char *attrs[] = { SYSDB_MEMBEROF, NULL };
+    struct ldb_message_element *el;
+    struct ldb_message *msg;
+    unsigned int count;
+    int ret;
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, username,
+                                    attrs, &msg);
+    fail_if(ret != EOK, "Cannot find user %s [%d]: %s",
+            username, ret, sss_strerror(ret));
+
+    el = ldb_msg_find_element(msg, SYSDB_MEMBEROF);
+    count = el == NULL ? 0 : el->num_values;
+    talloc_free(msg);
+
+    return count;
+}
+
+START_TEST (test_sysdb_memberof_nested_in_transaction)
+{
+    struct sysdb_test_ctx *test_ctx;
+    const char *groups[3];
+    const char *username;
+    int ret;
+    int i;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    for (i = 0; i < 3; i++) {
+        groups[i] = test_asprintf_fqname(test_ctx, test_ctx->domain,
+                                         "nestgroup%d", i);
+        fail_if(groups[i] == NULL);
+    }
+    username = test_asprintf_fqname(test_ctx, test_ctx->domain, "nestuser");
+    fail_if(username == NULL);
+
+    ret = sysdb_transaction_start(test_ctx->sysdb);
+    fail_if(ret != EOK, "Cannot start transaction");
+
+    /* groups[0] > groups[1] > groups[2] > username */
+    for (i = 0; i < 3; i++) {
+        ret = sysdb_add_group(test_ctx->domain, groups[i], 28700 + i,
+                              NULL, 0, 0);
+        fail_if(ret != EOK, "Cannot add group %s", groups[i]);
+    }
+    ret = sysdb_add_user(test_ctx->domain, username, 28710, 28710,
+                         NULL, "/home/nestuser", "/bin/bash",
+                         NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Cannot add user %s", username);
+
+    ret = sysdb_add_group_member(test_ctx->domain, groups[2], username,
+                                 SYSDB_MEMBER_USER, false);
+    fail_if(ret != EOK);
+    ret = sysdb_add_group_member(test_ctx->domain, groups[1], groups[2],
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    ret = sysdb_add_group_member(test_ctx->domain, groups[0], groups[1],
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    fail_unless(test_count_memberof(test_ctx, username) == 3);
+
+    /* Every change below reuses the ancestors read by the previous ones */
+    ret = sysdb_remove_group_member(test_ctx->domain, groups[0], groups[1],
+                                    SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    fail_unless(test_count_memberof(test_ctx, username) == 2);
+
+    ret = sysdb_remove_group_member(test_ctx->domain, groups[1], groups[2],
+                                    SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    fail_unless(test_count_memberof(test_ctx, username) == 1);
+
+    ret = sysdb_add_group_member(test_ctx->domain, groups[0], groups[1],
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    ret = sysdb_add_group_member(test_ctx->domain, groups[1], groups[2],
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    fail_unless(test_count_memberof(test_ctx, username) == 3);
+
+    ret = sysdb_remove_group_member(test_ctx->domain, groups[0], groups[1],
+                                    SYSDB_MEMBER_GROUP, false);
+    fail_if(ret != EOK);
+    fail_unless(test_count_memberof(test_ctx, username) == 2);
+
+    ret = sysdb_transaction_commit(test_ctx->sysdb);
+    fail_if(ret != EOK, "Cannot commit transaction");
+
+    fail_unless(test_count_memberof(test_ctx, username) == 2);
+
+    ret = sysdb_delete_user(test_ctx->domain, username, 0);
+    fail_if(ret != EOK);
+    for (i = 0; i < 3; i++) {
+        ret = sysdb_delete_group(test_ctx->domain, groups[i], 0);
+        fail_if(ret != EOK);
+    }
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_memberof_user_cleanup)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -5672,6 +5936,45 @@ START_TEST(test_sysdb_has_enumerated)
 }
 END_TEST
 
+START_TEST(test_sysdb_change_stream_cookie)
+{
+    errno_t ret;
+    struct sysdb_test_ctx *test_ctx;
+    const char *cookie;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    ret = sysdb_get_change_stream_cookie(test_ctx, test_ctx->domain, &cookie);
+    fail_if(ret != EOK, "Error [%d][%s] reading the cookie",
+                        ret, strerror(ret));
+    fail_unless(cookie == NULL, "No cookie expected");
+
+    ret = sysdb_set_change_stream_cookie(test_ctx->domain, "Y3NuPTE=");
+    fail_if(ret != EOK, "Error [%d][%s] setting the cookie",
+                        ret, strerror(ret));
+
+    ret = sysdb_get_change_stream_cookie(test_ctx, test_ctx->domain, &cookie);
+    fail_if(ret != EOK, "Error [%d][%s] reading the cookie",
+                        ret, strerror(ret));
+    fail_if(cookie == NULL || strcmp(cookie, "Y3NuPTE=") != 0,
+            "Unexpected cookie [%s]", cookie ? cookie : "none");
+
+    /* Removing the cookie starts the stream over */
+    ret = sysdb_set_change_stream_cookie(test_ctx->domain, NULL);
+    fail_if(ret != EOK, "Error [%d][%s] removing the cookie",
+                        ret, strerror(ret));
+
+    ret = sysdb_get_change_stream_cookie(test_ctx, test_ctx->domain, &cookie);
+    fail_if(ret != EOK, "Error [%d][%s] reading the cookie",
+                        ret, strerror(ret));
+    fail_unless(cookie == NULL, "Cookie should have been removed");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(test_sysdb_original_dn_case_insensitive)
 {
     errno_t ret;
@@ -7372,6 +7675,9 @@ Suite *create_sysdb_suite(void)
     /* Create a new user */
     tcase_add_loop_test(tc_sysdb, test_sysdb_store_user, 27010, 27020);
 
+    /* Store users and groups in bulk */
+    tcase_add_test(tc_sysdb, test_sysdb_store_users_bulk);
+
     /* Verify the users were added */
     tcase_add_loop_test(tc_sysdb, test_sysdb_getpwnam, 27010, 27020);
 
@@ -7380,6 +7686,7 @@ Suite *create_sysdb_suite(void)
 
     /* Enumerate the users */
     tcase_add_test(tc_sysdb, test_sysdb_enumpwent);
+    tcase_add_test(tc_sysdb, test_sysdb_enumpwent_page);
 
     /* Change their attribute */
     tcase_add_loop_test(tc_sysdb, test_sysdb_set_user_attr, 27010, 27020);
@@ -7483,6 +7790,9 @@ Suite *create_sysdb_suite(void)
     /* Test sysdb enumerated flag */
     tcase_add_test(tc_sysdb, test_sysdb_has_enumerated);
 
+    /* Test the change stream cookie */
+    tcase_add_test(tc_sysdb, test_sysdb_change_stream_cookie);
+
     /* Test originalDN searches */
     tcase_add_test(tc_sysdb, test_sysdb_original_dn_case_insensitive);
 
@@ -7698,6 +8008,8 @@ Suite *create_sysdb_suite(void)
                         1 , 11);
     tcase_add_loop_test(tc_memberof, test_sysdb_remove_local_group_by_gid,
                         MBO_GROUP_BASE , MBO_GROUP_BASE + 10);
+
+    tcase_add_test(tc_memberof, test_sysdb_memberof_nested_in_transaction);
     suite_add_tcase(s, tc_memberof);
 
     TCase *tc_subdomain = tcase_create("SYSDB sub-domain Tests");
@@ -161,6 +161,42 @@ static int clear_fastcache(bool *sssd_nss_is_off)
             return ret;
         }
     }
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/sid");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/services");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/netgroup");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/negative");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
 
     *sssd_nss_is_off = true;
     return EOK;
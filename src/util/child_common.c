@@ -28,6 +28,7 @@
 #include <tevent.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <poll.h>
 
 #include "util/util.h"
 #include "util/find_uid.h"
@@ -519,6 +520,211 @@ int read_pipe_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct write_pipe_frame_state {
+    uint8_t *frame;
+};
+
+static void write_pipe_frame_done(struct tevent_req *subreq);
+
+struct tevent_req *write_pipe_frame_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         uint8_t *buf, size_t len, int fd)
+{
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct write_pipe_frame_state *state;
+    size_t rp = 0;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct write_pipe_frame_state);
+    if (req == NULL) return NULL;
+
+    if (len > CHILD_MAX_FRAME_SIZE) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Frame of %zu bytes is too large.\n", len);
+        ret = EMSGSIZE;
+        goto done;
+    }
+
+    state->frame = talloc_size(state, sizeof(uint32_t) + len);
+    if (state->frame == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    SAFEALIGN_SET_UINT32(&state->frame[rp], len, &rp);
+    if (len > 0) {
+        safealign_memcpy(&state->frame[rp], buf, len, &rp);
+    }
+
+    subreq = write_pipe_send(state, ev, state->frame, rp, fd);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_req_set_callback(subreq, write_pipe_frame_done, req);
+
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void write_pipe_frame_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct write_pipe_frame_state *state = tevent_req_data(req,
+                                                struct write_pipe_frame_state);
+    errno_t ret;
+
+    ret = write_pipe_recv(subreq);
+    talloc_zfree(subreq);
+
+    /* the payload may contain credentials */
+    safezero(state->frame, talloc_get_size(state->frame));
+    talloc_zfree(state->frame);
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+int write_pipe_frame_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct read_pipe_frame_state {
+    int fd;
+    uint8_t hdr[sizeof(uint32_t)];
+    size_t hdr_len;
+    uint8_t *buf;
+    size_t len;
+    size_t expected;
+};
+
+static void read_pipe_frame_handler(struct tevent_context *ev,
+                                    struct tevent_fd *fde,
+                                    uint16_t flags, void *pvt);
+
+struct tevent_req *read_pipe_frame_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev, int fd)
+{
+    struct tevent_req *req;
+    struct read_pipe_frame_state *state;
+    struct tevent_fd *fde;
+
+    req = tevent_req_create(mem_ctx, &state, struct read_pipe_frame_state);
+    if (req == NULL) return NULL;
+
+    state->fd = fd;
+
+    fde = tevent_add_fd(ev, state, fd, TEVENT_FD_READ,
+                        read_pipe_frame_handler, req);
+    if (fde == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_fd failed.\n");
+        talloc_zfree(req);
+        return NULL;
+    }
+
+    return req;
+}
+
+static void read_pipe_frame_handler(struct tevent_context *ev,
+                                    struct tevent_fd *fde,
+                                    uint16_t flags, void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct read_pipe_frame_state *state = tevent_req_data(req,
+                                                struct read_pipe_frame_state);
+    uint32_t frame_len;
+    ssize_t size;
+    errno_t err;
+
+    if (flags & TEVENT_FD_WRITE) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "read_pipe_frame_handler called with TEVENT_FD_WRITE,"
+              " this should not happen.\n");
+        tevent_req_error(req, EINVAL);
+        return;
+    }
+
+    /* Only read what belongs to this frame, the next one is left in the
+     * pipe for the next request. */
+    if (state->hdr_len < sizeof(state->hdr)) {
+        size = read(state->fd, state->hdr + state->hdr_len,
+                    sizeof(state->hdr) - state->hdr_len);
+    } else {
+        size = read(state->fd, state->buf + state->len,
+                    state->expected - state->len);
+    }
+
+    if (size == -1) {
+        err = errno;
+        if (err == EINTR || err == EAGAIN || err == EWOULDBLOCK) {
+            return;
+        }
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "read failed [%d][%s].\n", err, strerror(err));
+        tevent_req_error(req, err);
+        return;
+    } else if (size == 0) {
+        DEBUG(SSSDBG_OP_FAILURE, "EOF received in the middle of a frame\n");
+        tevent_req_error(req, EPIPE);
+        return;
+    }
+
+    if (state->hdr_len < sizeof(state->hdr)) {
+        state->hdr_len += size;
+        if (state->hdr_len < sizeof(state->hdr)) {
+            return;
+        }
+
+        SAFEALIGN_COPY_UINT32(&frame_len, state->hdr, NULL);
+        if (frame_len > CHILD_MAX_FRAME_SIZE) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Frame of %"PRIu32" bytes is too large.\n", frame_len);
+            tevent_req_error(req, EMSGSIZE);
+            return;
+        }
+
+        state->expected = frame_len;
+        state->buf = talloc_size(state, state->expected);
+        if (state->buf == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+    } else {
+        state->len += size;
+    }
+
+    if (state->len == state->expected) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Frame of %zu bytes received\n", state->len);
+        tevent_req_done(req);
+    }
+}
+
+int read_pipe_frame_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                         uint8_t **buf, ssize_t *len)
+{
+    struct read_pipe_frame_state *state;
+    state = tevent_req_data(req, struct read_pipe_frame_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *buf = talloc_steal(mem_ctx, state->buf);
+    *len = state->len;
+
+    return EOK;
+}
+
 static void child_invoke_callback(struct tevent_context *ev,
                                   struct tevent_immediate *imm,
                                   void *pvt);
@@ -831,3 +1037,492 @@ errno_t child_debug_init(const char *logfile, int *debug_fd)
 
     return EOK;
 }
+
+/* CHILD WORKER POOL */
+
+struct sss_child_pool_worker {
+    struct sss_child_pool_worker *prev;
+    struct sss_child_pool_worker *next;
+
+    struct sss_child_pool *pool;
+    pid_t pid;
+    struct child_io_fds *io;
+    struct sss_child_ctx_old *child_ctx;
+    size_t requests;
+    bool busy;
+};
+
+struct sss_child_pool {
+    struct tevent_context *ev;
+    const char *binary;
+    int debug_fd;
+    const char **extra_argv;
+
+    struct sss_child_pool_worker *workers;
+    size_t num_workers;
+    size_t size;
+    size_t max_requests;
+    uint32_t timeout;
+};
+
+static void sss_child_pool_worker_exited(int child_status,
+                                         struct tevent_signal *sige,
+                                         void *pvt)
+{
+    struct sss_child_pool_worker *worker;
+
+    worker = talloc_get_type(pvt, struct sss_child_pool_worker);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Worker [%d] of [%s] exited.\n", worker->pid,
+          worker->pool != NULL ? worker->pool->binary : "-");
+
+    /* The handler is freed by the caller */
+    worker->child_ctx = NULL;
+
+    /* A busy worker is released by its request which fails reading the
+     * response */
+    if (!worker->busy) {
+        talloc_free(worker);
+    }
+}
+
+static int sss_child_pool_worker_destructor(struct sss_child_pool_worker *w)
+{
+    if (w->pool != NULL) {
+        DLIST_REMOVE(w->pool->workers, w);
+        w->pool->num_workers--;
+    }
+
+    /* An idle worker exits when its pipe is closed, child_handler_destroy()
+     * also kills a worker which is stuck in a request */
+    talloc_zfree(w->io);
+    if (w->child_ctx != NULL) {
+        child_handler_destroy(w->child_ctx);
+    }
+
+    return 0;
+}
+
+static errno_t sss_child_pool_spawn(struct sss_child_pool *pool)
+{
+    struct sss_child_pool_worker *worker;
+    int pipefd_to_child[2] = PIPE_INIT;
+    int pipefd_from_child[2] = PIPE_INIT;
+    pid_t pid;
+    errno_t ret;
+
+    worker = talloc_zero(pool, struct sss_child_pool_worker);
+    if (worker == NULL) {
+        return ENOMEM;
+    }
+
+    worker->io = talloc(worker, struct child_io_fds);
+    if (worker->io == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+    worker->io->write_to_child_fd = -1;
+    worker->io->read_from_child_fd = -1;
+    talloc_set_destructor((void *) worker->io, child_io_destructor);
+
+    ret = pipe(pipefd_from_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto fail;
+    }
+    ret = pipe(pipefd_to_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto fail;
+    }
+
+    pid = fork();
+    if (pid == 0) { /* child */
+        exec_child_ex(worker, pipefd_to_child, pipefd_from_child,
+                      pool->binary, pool->debug_fd, pool->extra_argv, false,
+                      STDIN_FILENO, STDOUT_FILENO);
+
+        /* We should never get here */
+        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec [%s]\n", pool->binary);
+        _exit(1);
+    } else if (pid == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "fork failed [%d][%s].\n", ret, strerror(ret));
+        goto fail;
+    }
+
+    worker->pid = pid;
+    worker->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    worker->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(worker->io->read_from_child_fd);
+    sss_fd_nonblocking(worker->io->write_to_child_fd);
+
+    worker->pool = pool;
+    DLIST_ADD(pool->workers, worker);
+    pool->num_workers++;
+    talloc_set_destructor(worker, sss_child_pool_worker_destructor);
+
+    ret = child_handler_setup(pool->ev, pid, sss_child_pool_worker_exited,
+                              worker, &worker->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not set up child signal handler\n");
+        kill(pid, SIGKILL);
+        talloc_free(worker);
+        return ret;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Started worker [%d] of [%s].\n",
+          pid, pool->binary);
+
+    return EOK;
+
+fail:
+    PIPE_CLOSE(pipefd_from_child);
+    PIPE_CLOSE(pipefd_to_child);
+    talloc_free(worker);
+    return ret;
+}
+
+/* An idle worker must be alive and must not have written anything that
+ * was not asked for, otherwise the next response would be out of sync */
+static bool sss_child_pool_worker_healthy(struct sss_child_pool_worker *w)
+{
+    struct pollfd pfd;
+    int ret;
+
+    if (w->child_ctx == NULL) {
+        return false;
+    }
+
+    pfd.fd = w->io->read_from_child_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    ret = poll(&pfd, 1, 0);
+    if (ret != 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Worker [%d] is not healthy [%d][%#x], discarding it.\n",
+              w->pid, ret, pfd.revents);
+        return false;
+    }
+
+    return true;
+}
+
+static int sss_child_pool_destructor(struct sss_child_pool *pool)
+{
+    struct sss_child_pool_worker *worker;
+
+    /* Busy workers belong to their requests and are freed when they
+     * finish, the idle ones are freed together with the pool */
+    while ((worker = pool->workers) != NULL) {
+        DLIST_REMOVE(pool->workers, worker);
+        worker->pool = NULL;
+    }
+
+    return 0;
+}
+
+errno_t sss_child_pool_init(TALLOC_CTX *mem_ctx,
+                            struct tevent_context *ev,
+                            const char *binary,
+                            int debug_fd,
+                            const char *extra_argv[],
+                            size_t size,
+                            size_t max_requests,
+                            uint32_t timeout,
+                            struct sss_child_pool **_pool)
+{
+    struct sss_child_pool *pool;
+    size_t argc = 0;
+    size_t c;
+    errno_t ret;
+
+    if (binary == NULL || size == 0) {
+        return EINVAL;
+    }
+
+    pool = talloc_zero(mem_ctx, struct sss_child_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    pool->ev = ev;
+    pool->debug_fd = debug_fd;
+    pool->size = size;
+    pool->max_requests = max_requests;
+    pool->timeout = timeout;
+
+    pool->binary = talloc_strdup(pool, binary);
+    if (pool->binary == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (extra_argv != NULL) {
+        while (extra_argv[argc] != NULL) {
+            argc++;
+        }
+    }
+
+    pool->extra_argv = talloc_zero_array(pool, const char *, argc + 1);
+    if (pool->extra_argv == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < argc; c++) {
+        pool->extra_argv[c] = talloc_strdup(pool->extra_argv, extra_argv[c]);
+        if (pool->extra_argv[c] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    talloc_set_destructor(pool, sss_child_pool_destructor);
+
+    for (c = 0; c < pool->size; c++) {
+        ret = sss_child_pool_spawn(pool);
+        if (ret != EOK) {
+            /* Not fatal, workers are started again on demand */
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot start worker of [%s] [%d]: %s\n",
+                  binary, ret, sss_strerror(ret));
+            break;
+        }
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Pool of %zu workers of [%s], %zu requests per worker.\n",
+          pool->size, pool->binary, pool->max_requests);
+
+    *_pool = pool;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(pool);
+    }
+
+    return ret;
+}
+
+/* Returns an idle worker owned by mem_ctx or NULL if all workers are busy
+ * and no new one can be started. */
+static struct sss_child_pool_worker *
+sss_child_pool_get(TALLOC_CTX *mem_ctx, struct sss_child_pool *pool)
+{
+    struct sss_child_pool_worker *worker;
+    struct sss_child_pool_worker *next;
+    errno_t ret;
+
+    for (worker = pool->workers; worker != NULL; worker = next) {
+        next = worker->next;
+
+        if (worker->busy) {
+            continue;
+        }
+
+        if (sss_child_pool_worker_healthy(worker)) {
+            break;
+        }
+
+        talloc_free(worker);
+    }
+
+    if (worker == NULL && pool->num_workers < pool->size) {
+        ret = sss_child_pool_spawn(pool);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot start worker of [%s] [%d]: %s\n",
+                  pool->binary, ret, sss_strerror(ret));
+            return NULL;
+        }
+        worker = pool->workers;
+    }
+
+    if (worker == NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "All workers of [%s] are busy.\n",
+              pool->binary);
+        return NULL;
+    }
+
+    worker->busy = true;
+    talloc_steal(mem_ctx, worker);
+
+    return worker;
+}
+
+static void sss_child_pool_put(struct sss_child_pool_worker *worker)
+{
+    worker->requests++;
+
+    if (worker->pool == NULL || worker->child_ctx == NULL
+            || (worker->pool->max_requests > 0
+                    && worker->requests >= worker->pool->max_requests)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Retiring worker [%d] after %zu requests.\n",
+              worker->pid, worker->requests);
+        talloc_free(worker);
+        return;
+    }
+
+    worker->busy = false;
+    talloc_steal(worker->pool, worker);
+}
+
+struct sss_child_pool_state {
+    struct tevent_context *ev;
+    struct sss_child_pool_worker *worker;
+    struct tevent_timer *timeout_handler;
+
+    uint8_t *buf;
+    ssize_t len;
+};
+
+static void sss_child_pool_timeout(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv, void *pvt);
+static void sss_child_pool_written(struct tevent_req *subreq);
+static void sss_child_pool_done(struct tevent_req *subreq);
+
+struct tevent_req *sss_child_pool_send(TALLOC_CTX *mem_ctx,
+                                       struct tevent_context *ev,
+                                       struct sss_child_pool *pool,
+                                       uint8_t *buf, size_t len)
+{
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct sss_child_pool_state *state;
+    struct timeval tv;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sss_child_pool_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+
+    /* The worker is owned by the request until it finished successfully,
+     * so a worker with an unfinished request is never reused */
+    state->worker = sss_child_pool_get(state, pool);
+    if (state->worker == NULL) {
+        ret = EBUSY;
+        goto done;
+    }
+
+    if (pool->timeout > 0) {
+        tv = tevent_timeval_current_ofs(pool->timeout, 0);
+        state->timeout_handler = tevent_add_timer(ev, state, tv,
+                                                  sss_child_pool_timeout, req);
+        if (state->timeout_handler == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    subreq = write_pipe_frame_send(state, ev, buf, len,
+                                   state->worker->io->write_to_child_fd);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_req_set_callback(subreq, sss_child_pool_written, req);
+
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void sss_child_pool_timeout(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv, void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct sss_child_pool_state *state = tevent_req_data(req,
+                                                struct sss_child_pool_state);
+    errno_t ret;
+
+    state->timeout_handler = NULL;
+
+    DEBUG(SSSDBG_IMPORTANT_INFO, "Timeout for worker [%d] reached.\n",
+          state->worker->pid);
+
+    ret = kill(state->worker->pid, SIGKILL);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "kill failed [%d][%s].\n", ret, strerror(ret));
+    }
+
+    tevent_req_error(req, ETIMEDOUT);
+}
+
+static void sss_child_pool_written(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct sss_child_pool_state *state = tevent_req_data(req,
+                                                struct sss_child_pool_state);
+    errno_t ret;
+
+    ret = write_pipe_frame_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    subreq = read_pipe_frame_send(state, state->ev,
+                                  state->worker->io->read_from_child_fd);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, sss_child_pool_done, req);
+}
+
+static void sss_child_pool_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct sss_child_pool_state *state = tevent_req_data(req,
+                                                struct sss_child_pool_state);
+    errno_t ret;
+
+    talloc_zfree(state->timeout_handler);
+
+    ret = read_pipe_frame_recv(subreq, state, &state->buf, &state->len);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    sss_child_pool_put(state->worker);
+    state->worker = NULL;
+
+    tevent_req_done(req);
+}
+
+int sss_child_pool_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                        uint8_t **buf, ssize_t *len)
+{
+    struct sss_child_pool_state *state = tevent_req_data(req,
+                                                struct sss_child_pool_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *buf = talloc_steal(mem_ctx, state->buf);
+    *len = state->len;
+
+    return EOK;
+}
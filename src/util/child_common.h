@@ -34,6 +34,7 @@
 
 #define IN_BUF_SIZE         512
 #define CHILD_MSG_CHUNK     256
+#define CHILD_MAX_FRAME_SIZE (1024 * 1024)
 
 #define SIGTERM_TO_SIGKILL_TIME 2
 #define CHILD_TIMEOUT_EXIT_CODE 7
@@ -100,6 +101,21 @@ struct tevent_req *read_pipe_send(TALLOC_CTX *mem_ctx,
 int read_pipe_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
                    uint8_t **buf, ssize_t *len);
 
+/* Length-prefixed messages for children which serve more than one request
+ * over the same pipe. A frame is the length of the payload as uint32_t in
+ * host byte order followed by the payload. Unlike read_pipe_send(),
+ * read_pipe_frame_send() finishes after one frame and does not wait for
+ * EOF. EOF in the middle of a frame is reported as EPIPE. */
+struct tevent_req *write_pipe_frame_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         uint8_t *buf, size_t len, int fd);
+int write_pipe_frame_recv(struct tevent_req *req);
+
+struct tevent_req *read_pipe_frame_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev, int fd);
+int read_pipe_frame_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                         uint8_t **buf, ssize_t *len);
+
 /* The pipes to communicate with the child must be nonblocking */
 void fd_nonblocking(int fd);
 
@@ -121,4 +137,48 @@ int child_io_destructor(void *ptr);
 
 errno_t child_debug_init(const char *logfile, int *debug_fd);
 
+/* CHILD WORKER POOL
+ *
+ * A pool of long-lived children which serve one request after another
+ * over their pipes, so that the fork() and exec() of a helper is paid
+ * once per worker and not once per request. Requests and responses are
+ * exchanged as frames, see write_pipe_frame_send().
+ *
+ * A worker is started as binary with extra_argv and must handle requests
+ * with child_worker_read_request() and child_worker_send_response() until
+ * child_worker_read_request() returns ENOENT. Sending an empty response
+ * tells the caller that the request failed.
+ *
+ * Workers are started on demand up to size of them and replaced after
+ * max_requests requests, 0 means no limit. A worker is health-checked
+ * before it gets a request; a worker which exited or left unexpected data
+ * in its pipe is discarded. If a request takes longer than timeout
+ * seconds, 0 means no timeout, the worker is killed and the request fails
+ * with ETIMEDOUT. If all workers are busy the request fails with EBUSY,
+ * callers are expected to fall back to a per-request child then. */
+struct sss_child_pool;
+
+errno_t sss_child_pool_init(TALLOC_CTX *mem_ctx,
+                            struct tevent_context *ev,
+                            const char *binary,
+                            int debug_fd,
+                            const char *extra_argv[],
+                            size_t size,
+                            size_t max_requests,
+                            uint32_t timeout,
+                            struct sss_child_pool **_pool);
+
+struct tevent_req *sss_child_pool_send(TALLOC_CTX *mem_ctx,
+                                       struct tevent_context *ev,
+                                       struct sss_child_pool *pool,
+                                       uint8_t *buf, size_t len);
+int sss_child_pool_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                        uint8_t **buf, ssize_t *len);
+
+/* Child side of the worker pool. Implemented in child_worker.c which has no
+ * tevent dependency and can be linked into the helpers. */
+errno_t child_worker_read_request(TALLOC_CTX *mem_ctx, int fd,
+                                  uint8_t **_buf, size_t *_len);
+errno_t child_worker_send_response(int fd, uint8_t *buf, size_t len);
+
 #endif /* __CHILD_COMMON_H__ */
@@ -0,0 +1,106 @@
+/*
+    SSSD
+
+    Child side of the child worker pool
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Blocking counterparts of write_pipe_frame_send() and
+ * read_pipe_frame_send() for the children. They only depend on talloc and
+ * atomic_io.c, so the helpers can link them without pulling in tevent. */
+
+#include "util/util.h"
+#include "util/child_common.h"
+
+errno_t child_worker_read_request(TALLOC_CTX *mem_ctx, int fd,
+                                  uint8_t **_buf, size_t *_len)
+{
+    uint8_t hdr[sizeof(uint32_t)];
+    uint32_t len;
+    uint8_t *buf;
+    ssize_t res;
+    errno_t ret;
+
+    errno = 0;
+    res = sss_atomic_read_s(fd, hdr, sizeof(hdr));
+    if (res == 0) {
+        /* The pool closed the pipe, the worker is done */
+        return ENOENT;
+    } else if (res != (ssize_t) sizeof(hdr)) {
+        ret = (errno == 0) ? EPIPE : errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "read failed [%d][%s].\n", ret, strerror(ret));
+        return ret;
+    }
+
+    SAFEALIGN_COPY_UINT32(&len, hdr, NULL);
+    if (len > CHILD_MAX_FRAME_SIZE) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Request of %"PRIu32" bytes is too large\n",
+              len);
+        return EMSGSIZE;
+    }
+
+    buf = talloc_size(mem_ctx, len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    errno = 0;
+    res = sss_atomic_read_s(fd, buf, len);
+    if (res != (ssize_t) len) {
+        ret = (errno == 0) ? EPIPE : errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "read failed [%d][%s].\n", ret, strerror(ret));
+        talloc_free(buf);
+        return ret;
+    }
+
+    *_buf = buf;
+    *_len = len;
+    return EOK;
+}
+
+errno_t child_worker_send_response(int fd, uint8_t *buf, size_t len)
+{
+    uint8_t hdr[sizeof(uint32_t)];
+    ssize_t res;
+    errno_t ret;
+
+    if (len > CHILD_MAX_FRAME_SIZE) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Response of %zu bytes is too large\n", len);
+        return EMSGSIZE;
+    }
+
+    SAFEALIGN_SET_UINT32(hdr, len, NULL);
+
+    errno = 0;
+    res = sss_atomic_write_s(fd, hdr, sizeof(hdr));
+    if (res == (ssize_t) sizeof(hdr)) {
+        if (len == 0) {
+            return EOK;
+        }
+
+        res = sss_atomic_write_s(fd, buf, len);
+        if (res == (ssize_t) len) {
+            return EOK;
+        }
+    }
+
+    ret = (errno == 0) ? EIO : errno;
+    DEBUG(SSSDBG_CRIT_FAILURE, "write failed [%d][%s].\n", ret, strerror(ret));
+    return ret;
+}
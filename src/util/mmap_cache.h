@@ -149,7 +149,61 @@ struct sss_mc_initgr_data {
                              * after gids */
 };
 
+struct sss_mc_sid_data {
+    rel_ptr_t name;         /* ptr to the lookup key of the record (SID or
+                             * object name), rel. to struct base addr */
+    rel_ptr_t sid;          /* ptr to SID string, rel. to struct base addr */
+    uint32_t type;          /* enum sss_id_type of the object */
+    uint32_t id;            /* POSIX ID of the object, 0 if not known */
+    uint32_t populated_by;  /* lookup which created the record, one of
+                             * SSS_MC_SID_BY_* */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* concatenation of all strings, each string is
+                             * zero terminated ordered as follows:
+                             * name records: name, SID
+                             * other records: SID */
+};
+
+/* Used by the services and netgroup caches. Both store the packed reply
+ * body exactly as sent by the responder so the client can parse it with
+ * the same code it uses for socket replies. The negative cache uses the
+ * same record with an empty reply, only the presence of the key matters. */
+struct sss_mc_reply_data {
+    rel_ptr_t name;         /* ptr to the lookup key of the record,
+                             * rel. to struct base addr */
+    rel_ptr_t reply;        /* ptr to the reply body, rel. to struct base addr */
+    uint32_t reply_len;     /* length of the reply body */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* zero terminated key followed by the reply */
+};
+
 #pragma pack()
 
+/* Records in the SID cache are hashed by SID (hash1) and by ID (hash2),
+ * except name records which are hashed by name (hash1) and by SID (hash2).
+ * A record created by a lookup by ID, UID or GID must only be used to answer
+ * the same kind of lookup because the three can return different objects if
+ * a user and a group share the same number. */
+#define SSS_MC_SID_BY_ID    0
+#define SSS_MC_SID_BY_UID   1
+#define SSS_MC_SID_BY_GID   2
+#define SSS_MC_SID_BY_SID   3
+#define SSS_MC_SID_BY_NAME  4
+
+/* Keys of the services cache. '#' can never be part of a service name
+ * because it starts a comment in /etc/services. The protocol is an empty
+ * string if the caller did not request any. */
+#define SSS_MC_SVC_NAME_KEY_FMT "%s/%s"
+#define SSS_MC_SVC_PORT_KEY_FMT "#%u/%s"
+
+/* Keys of the negative cache are "<kind>:<name or decimal ID>" so a user
+ * and a group with the same name do not share a record. */
+#define SSS_MC_NEG_USER     'U'
+#define SSS_MC_NEG_GROUP    'G'
+#define SSS_MC_NEG_UID      'u'
+#define SSS_MC_NEG_GID      'g'
+#define SSS_MC_NEG_NAME_KEY_FMT "%c:%s"
+#define SSS_MC_NEG_ID_KEY_FMT "%c:%u"
+
 
 #endif /* _MMAP_CACHE_H_ */
@@ -22,6 +22,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <limits.h>
 
 #include "config.h"
 
@@ -199,7 +200,8 @@ done:
 }
 
 static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
-                                            struct sss_sec_req *req)
+                                            struct sss_sec_req *req,
+                                            int pending)
 {
     TALLOC_CTX *tmp_ctx;
     static const char *attrs[] = { NULL };
@@ -228,7 +230,7 @@ static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    if (res->count >= req->quota->max_secrets) {
+    if (res->count + pending >= req->quota->max_secrets) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store any more secrets as the maximum allowed limit (%d) "
               "has been reached\n", req->quota->max_secrets);
@@ -278,7 +280,8 @@ static struct ldb_dn *per_uid_container(TALLOC_CTX *mem_ctx,
 }
 
 static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
-                                                   struct sss_sec_req *req)
+                                                   struct sss_sec_req *req,
+                                                   int pending)
 {
     TALLOC_CTX *tmp_ctx;
     static const char *attrs[] = { NULL };
@@ -309,7 +312,7 @@ static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    if (res->count >= req->quota->max_uid_secrets) {
+    if (res->count + pending >= req->quota->max_uid_secrets) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store any more secrets for this client (basedn %s) "
               "as the maximum allowed limit (%d) has been reached\n",
@@ -1014,6 +1017,39 @@ done:
     return ret;
 }
 
+errno_t sss_sec_check_quota(struct sss_sec_req *req,
+                            int pending_secrets,
+                            int pending_uid_secrets)
+{
+    int ret;
+
+    if (req == NULL) {
+        return EINVAL;
+    }
+
+    ret = local_db_check_number_of_secrets(req, req, pending_secrets);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return local_db_check_peruid_number_of_secrets(req, req,
+                                                   pending_uid_secrets);
+}
+
+errno_t sss_sec_check_payload_size(struct sss_sec_req *req,
+                                   size_t secret_len)
+{
+    if (req == NULL) {
+        return EINVAL;
+    }
+
+    if (secret_len > INT_MAX) {
+        return ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE;
+    }
+
+    return local_check_max_payload_size(req, secret_len);
+}
+
 errno_t sss_sec_put(struct sss_sec_req *req,
                     const char *secret)
 {
@@ -1044,7 +1080,7 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_number_of_secrets(msg, req);
+    ret = local_db_check_number_of_secrets(msg, req, 0);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "local_db_check_number_of_secrets failed [%d]: %s\n",
@@ -1052,7 +1088,7 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_peruid_number_of_secrets(msg, req);
+    ret = local_db_check_peruid_number_of_secrets(msg, req, 0);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "local_db_check_number_of_secrets failed [%d]: %s\n",
@@ -1157,7 +1193,7 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_number_of_secrets(msg, req);
+    ret = local_db_check_number_of_secrets(msg, req, 0);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "local_db_check_number_of_secrets failed [%d]: %s\n",
@@ -1165,7 +1201,7 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_peruid_number_of_secrets(msg, req);
+    ret = local_db_check_peruid_number_of_secrets(msg, req, 0);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "local_db_check_number_of_secrets failed [%d]: %s\n",
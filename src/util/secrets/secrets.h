@@ -88,6 +88,18 @@ errno_t sss_sec_get(TALLOC_CTX *mem_ctx,
 errno_t sss_sec_put(struct sss_sec_req *req,
                     const char *secret);
 
+/* Check that the secret of req could be added by sss_sec_put() if there
+ * were pending_secrets more secrets in the hive and pending_uid_secrets
+ * more secrets of the client. For callers that delay their writes. */
+errno_t sss_sec_check_quota(struct sss_sec_req *req,
+                            int pending_secrets,
+                            int pending_uid_secrets);
+
+/* Check that a secret of secret_len characters is within the payload size
+ * limit of the hive of req, like sss_sec_put() and sss_sec_update() do. */
+errno_t sss_sec_check_payload_size(struct sss_sec_req *req,
+                                   size_t secret_len);
+
 errno_t sss_sec_update(struct sss_sec_req *req,
                        const char *secret);
 